@@ -134,6 +134,9 @@ else()
 		endif()
 		message(STATUS "GASNET ROOT: $ENV{GASNet_ROOT_DIR}")
 		set(Legion_MAX_DIM ${FF_MAX_DIM} CACHE STRING "Maximum number of dimensions")
+		if(FF_USE_OPENMP)
+		  set(Legion_USE_OpenMP ON CACHE BOOL "enable Legion_USE_OpenMP")
+		endif()
 		if (FF_GPU_BACKEND STREQUAL "cuda")
 			set(Legion_USE_CUDA ON CACHE BOOL "enable Legion_USE_CUDA" FORCE)
 			set(Legion_CUDA_ARCH ${FF_CUDA_ARCH} CACHE STRING "Legion CUDA ARCH" FORCE)
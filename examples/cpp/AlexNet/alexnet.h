@@ -13,51 +13,18 @@
  * limitations under the License.
  */
 
+#include "flexflow/image_data_loader.h"
 #include "flexflow/model.h"
-#define MAX_NUM_SAMPLES 4196
 
 using namespace Legion;
 using namespace std;
-using FlexFlow::FID_DATA;
-using FlexFlow::TensorAccessorR;
-using FlexFlow::TensorAccessorW;
 
 struct AlexNetConfig {
   AlexNetConfig(void) {
     // Set default configurations here
     std::memset(dataset_path, 0, MAX_FILE_LENGTH);
+    loader_workers = 4;
   }
   char dataset_path[MAX_FILE_LENGTH];
-};
-
-class DataLoader {
-public:
-  DataLoader(FlexFlow::FFModel &ff,
-             AlexNetConfig const *alexnet,
-             FlexFlow::ParallelTensor _input,
-             FlexFlow::ParallelTensor _label);
-  static void load_input(Task const *task,
-                         std::vector<PhysicalRegion> const &regions,
-                         Context ctx,
-                         Runtime *runtime);
-  static void load_label(Task const *task,
-                         std::vector<PhysicalRegion> const &regions,
-                         Context ctx,
-                         Runtime *runtime);
-  static void load_entire_dataset(Task const *task,
-                                  std::vector<PhysicalRegion> const &regions,
-                                  Context ctx,
-                                  Runtime *runtime);
-  void next_batch(FlexFlow::FFModel &);
-  void reset(void);
-
-public:
-  int num_samples, next_index;
-  FlexFlow::ParallelTensor full_input, batch_input;
-  FlexFlow::ParallelTensor full_label, batch_label;
-};
-
-struct SampleIdxs {
-  int num_samples;
-  int idxs[MAX_NUM_SAMPLES];
+  int loader_workers;
 };
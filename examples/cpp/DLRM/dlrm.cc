@@ -26,7 +26,8 @@ void parse_input_args(char **argv, int argc, DLRMConfig &apConfig);
 DLRMConfig::DLRMConfig(void)
     : sparse_feature_size(64), sigmoid_bot(-1), sigmoid_top(-1),
       embedding_bag_size(1), loss_threshold(0.0f), arch_interaction_op("cat"),
-      dataset_path(""), data_size(-1) {
+      dataset_path(""), data_size(-1), embedding_mode("dense"),
+      qr_collisions(4), md_embedding_dim(16) {
   embedding_size.push_back(1000000);
   embedding_size.push_back(1000000);
   embedding_size.push_back(1000000);
@@ -65,12 +66,34 @@ Tensor create_mlp(FFModel *model,
 }
 
 Tensor create_emb(FFModel *model,
+                  DLRMConfig const &config,
                   Tensor const &input,
                   int input_dim,
                   int output_dim,
                   int idx) {
   float range = sqrt(1.0f / input_dim);
   Initializer *embed_init = new UniformInitializer(std::rand(), -range, range);
+  if (config.embedding_mode == "qr") {
+    // qr_collisions rows of the table share each remainder row
+    int num_buckets =
+        (input_dim + config.qr_collisions - 1) / config.qr_collisions;
+    return model->qr_embedding(input,
+                               input_dim,
+                               num_buckets,
+                               output_dim,
+                               AGGR_MODE_SUM,
+                               DT_FLOAT,
+                               embed_init);
+  } else if (config.embedding_mode == "mixed-dim") {
+    return model->mixed_dim_embedding(input,
+                                      input_dim,
+                                      config.md_embedding_dim,
+                                      output_dim,
+                                      AGGR_MODE_SUM,
+                                      DT_FLOAT,
+                                      embed_init);
+  }
+  assert(config.embedding_mode == "dense");
   Tensor t = model->embedding(input,
                               input_dim,
                               output_dim,
@@ -85,8 +108,6 @@ Tensor interact_features(FFModel *model,
                          Tensor const &x,
                          std::vector<Tensor> const &ly,
                          std::string interaction) {
-  // Currently only support cat
-  // TODO: implement dot attention
   if (interaction == "cat") {
     Tensor *inputs = (Tensor *)malloc(sizeof(Tensor) * (1 + ly.size()));
     inputs[0] = x;
@@ -95,6 +116,22 @@ Tensor interact_features(FFModel *model,
     }
     return model->concat(ly.size() + 1, inputs, -1 /*axis*/);
     free(inputs);
+  } else if (interaction == "dot") {
+    return model->dot_interaction(x, ly);
+  } else if (interaction == "dot-composed") {
+    // The same interaction out of generic ops, for comparison with the fused
+    // op: it computes the full matrix of dots instead of the lower triangle
+    int batch_size = x->dims[1], feature_size = x->dims[0];
+    int num_features = ly.size() + 1;
+    std::vector<Tensor> features;
+    features.push_back(x);
+    features.insert(features.end(), ly.begin(), ly.end());
+    Tensor t = model->concat(num_features, features.data(), -1 /*axis*/);
+    t = model->reshape(t, {batch_size, num_features, feature_size});
+    Tensor dots = model->batch_matmul(t, model->transpose(t, {0, 2, 1}));
+    dots = model->reshape(dots, {batch_size, num_features * num_features});
+    Tensor inputs[2] = {x, dots};
+    return model->concat(2, inputs, -1 /*axis*/);
   } else {
     assert(false);
   }
@@ -128,6 +165,7 @@ void FlexFlow::top_level_task(Task const *task,
                   ffConfig.workersPerNode,
                   ffConfig.numNodes);
     log_app.print("EmbeddingBagSize(%d)", dlrmConfig.embedding_bag_size);
+    log_app.print("EmbeddingMode(%s)", dlrmConfig.embedding_mode.c_str());
     print_vector("Embedding Vocab Sizes", dlrmConfig.embedding_size);
     print_vector("MLP Top", dlrmConfig.mlp_top);
     print_vector("MLP Bot", dlrmConfig.mlp_bot);
@@ -158,7 +196,8 @@ void FlexFlow::top_level_task(Task const *task,
   for (size_t i = 0; i < dlrmConfig.embedding_size.size(); i++) {
     int input_dim = dlrmConfig.embedding_size[i];
     int output_dim = dlrmConfig.sparse_feature_size;
-    ly.push_back(create_emb(&ff, sparse_inputs[i], input_dim, output_dim, i));
+    ly.push_back(create_emb(
+        &ff, dlrmConfig, sparse_inputs[i], input_dim, output_dim, i));
   }
   Tensor z = interact_features(&ff, x, ly, dlrmConfig.arch_interaction_op);
   Tensor p =
@@ -259,6 +298,18 @@ void parse_input_args(char **argv, int argc, DLRMConfig &config) {
       config.embedding_bag_size = atoi(argv[++i]);
       continue;
     }
+    if (!strcmp(argv[i], "--arch-embedding-mode")) {
+      config.embedding_mode = std::string(argv[++i]);
+      continue;
+    }
+    if (!strcmp(argv[i], "--qr-collisions")) {
+      config.qr_collisions = atoi(argv[++i]);
+      continue;
+    }
+    if (!strcmp(argv[i], "--md-embedding-dim")) {
+      config.md_embedding_dim = atoi(argv[++i]);
+      continue;
+    }
     if (!strcmp(argv[i], "--arch-mlp-bot")) {
       std::stringstream ss(std::string(argv[++i]));
       std::string word;
@@ -29,6 +29,9 @@ struct DLRMConfig {
   std::vector<int> embedding_size, mlp_bot, mlp_top;
   std::string arch_interaction_op, dataset_path;
   int data_size;
+  // "dense", "qr" or "mixed-dim"
+  std::string embedding_mode;
+  int qr_collisions, md_embedding_dim;
 };
 
 struct ArgsConfig {
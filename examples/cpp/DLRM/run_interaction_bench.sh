@@ -0,0 +1,12 @@
+#!/bin/bash
+
+# Compares the training throughput of the fused dot interaction with the same
+# interaction composed out of concat/reshape/batch_matmul
+numgpu="${1:-1}"
+per_gpu_batch_size=256
+batchsize=$((numgpu * per_gpu_batch_size))
+
+for op in dot dot-composed; do
+  echo "arch-interaction-op = ${op}"
+  ./dlrm -ll:gpu "${numgpu}" -ll:cpu 4 -ll:fsize 12000 -ll:zsize 20000 -ll:util "${numgpu}" --arch-sparse-feature-size 64 --arch-embedding-size 1000000-1000000-1000000-1000000-1000000-1000000-1000000-1000000 --arch-mlp-bot 64-512-512-64 --arch-mlp-top 100-1024-1024-1024-1 --arch-interaction-op "${op}" --epochs 20 --batch-size "${batchsize}" --data-size $((batchsize * 4)) | grep THROUGHPUT
+done
@@ -14,8 +14,6 @@
  */
 
 #include "inception.h"
-#include <fstream>
-#include <sstream>
 #include <string>
 
 using namespace Legion;
@@ -23,6 +21,19 @@ using namespace FlexFlow;
 
 LegionRuntime::Logger::Category log_app("Inceptionv3");
 
+void parse_input_args(char **argv, int argc, InceptionConfig &config) {
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--dataset")) {
+      config.dataset_path = std::string(argv[++i]);
+      continue;
+    }
+    if (!strcmp(argv[i], "--loader-workers")) {
+      config.loader_workers = atoi(argv[++i]);
+      continue;
+    }
+  }
+}
+
 Tensor InceptionA(FFModel &ff, Tensor input, int pool_features) {
   Tensor t1 = input;
   t1 = ff.conv2d(t1, 64, 1, 1, 1, 1, 0, 0, AC_MODE_RELU);
@@ -125,16 +136,17 @@ void FlexFlow::top_level_task(Task const *task,
                               Context ctx,
                               Runtime *runtime) {
   FFConfig ffConfig;
-  /* { */
-  /* const InputArgs &command_args = HighLevelRuntime::get_input_args(); */
-  /* char **argv = command_args.argv; */
-  /* int argc = command_args.argc; */
-  /* parse_input_args(argv, argc, inceptionConfig); */
-  log_app.print("batchSize(%d) workersPerNodes(%d) numNodes(%d)",
-                ffConfig.batchSize,
-                ffConfig.workersPerNode,
-                ffConfig.numNodes);
-  /* } */
+  InceptionConfig inceptionConfig;
+  {
+    InputArgs const &command_args = HighLevelRuntime::get_input_args();
+    char **argv = command_args.argv;
+    int argc = command_args.argc;
+    parse_input_args(argv, argc, inceptionConfig);
+    log_app.print("batchSize(%d) workersPerNodes(%d) numNodes(%d)",
+                  ffConfig.batchSize,
+                  ffConfig.workersPerNode,
+                  ffConfig.numNodes);
+  }
   FFModel ff(ffConfig);
 
   Tensor input;
@@ -180,7 +192,23 @@ void FlexFlow::top_level_task(Task const *task,
   ff.compile(optimizer, LOSS_SPARSE_CATEGORICAL_CROSSENTROPY, metrics);
 
   // Data Loader
-  /* DataLoader data_loader(ff, inceptionConfig, input, ff.label_tensor); */
+  ParallelTensor input_pt, label_pt;
+  ff.get_parallel_tensor_from_tensor(input, input_pt);
+  ff.get_parallel_tensor_from_tensor(ff.label_tensor, label_pt);
+  if (inceptionConfig.dataset_path.length() == 0) {
+    log_app.print("Use random dataset...");
+  } else {
+    log_app.print("Start loading dataset from %s",
+                  inceptionConfig.dataset_path.c_str());
+  }
+  ImageDataLoader data_loader(
+      ff,
+      input_pt,
+      label_pt,
+      open_image_source(
+          inceptionConfig.dataset_path, 128 * ffConfig.batchSize, 342, 342, 10),
+      ImageAugmentation(),
+      inceptionConfig.loader_workers);
   ff.init_operators();
   // Start timer
   {
@@ -191,19 +219,10 @@ void FlexFlow::top_level_task(Task const *task,
   }
   double ts_start = Realm::Clock::current_time_in_microseconds();
   for (int epoch = 0; epoch < ffConfig.epochs; epoch++) {
-    /* data_loader.reset(); */
+    data_loader.reset();
     ff.reset_metrics();
-    /* int iterations = data_loader.num_samples / ffConfig.batchSize; */
-    int iterations = 128;
-
-    for (int iter = 0; iter < iterations; iter++) {
-      /* if (inceptionConfig.dataset_path.length() == 0) { */
-      /*   // Only load data once for random input */
-      /*   if (iter == 0 && epoch == 0) */
-      /*     data_loader.next_batch(ff); */
-      /* } else { */
-      /*   data_loader.next_batch(ff); */
-      /* } */
+    for (int iter = 0; iter < data_loader.num_batches; iter++) {
+      data_loader.next_batch(ff);
       if (epoch > 0) {
         runtime->begin_trace(ctx, 111 /*trace_id*/);
       }
@@ -227,7 +246,8 @@ void FlexFlow::top_level_task(Task const *task,
   double run_time = 1e-6 * (ts_end - ts_start);
   printf("ELAPSED TIME = %.4fs, THROUGHPUT = %.2f samples/s\n",
          run_time,
-         8192 * ffConfig.epochs / run_time);
+         data_loader.num_batches * ffConfig.batchSize * ffConfig.epochs /
+             run_time);
 }
 
 void FlexFlow::register_custom_tasks() {}
@@ -13,8 +13,17 @@
  * limitations under the License.
  */
 
+#include "flexflow/image_data_loader.h"
 #include "flexflow/model.h"
-#define MAX_NUM_SAMPLES 4196
 
 using namespace Legion;
 using namespace std;
+
+struct InceptionConfig {
+  InceptionConfig(void) {
+    // Set default configurations here
+    loader_workers = 4;
+  }
+  std::string dataset_path;
+  int loader_workers;
+};
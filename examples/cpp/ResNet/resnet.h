@@ -13,8 +13,8 @@
  * limitations under the License.
  */
 
+#include "flexflow/image_data_loader.h"
 #include "flexflow/model.h"
-#define MAX_NUM_SAMPLES 4196
 
 using namespace Legion;
 using namespace std;
@@ -22,38 +22,8 @@ using namespace std;
 struct ResNetConfig {
   ResNetConfig(void) {
     // Set default configurations here
+    loader_workers = 4;
   }
   std::string dataset_path;
-};
-
-class DataLoader {
-public:
-  DataLoader(FlexFlow::FFModel &ff,
-             ResNetConfig const &resnet,
-             FlexFlow::Tensor _input,
-             FlexFlow::Tensor _label);
-  static void load_input(Task const *task,
-                         std::vector<PhysicalRegion> const &regions,
-                         Context ctx,
-                         Runtime *runtime);
-  static void load_label(Task const *task,
-                         std::vector<PhysicalRegion> const &regions,
-                         Context ctx,
-                         Runtime *runtime);
-  static void load_entire_dataset(Task const *task,
-                                  std::vector<PhysicalRegion> const &regions,
-                                  Context ctx,
-                                  Runtime *runtime);
-  void next_batch(FlexFlow::FFModel &);
-  void reset(void);
-
-public:
-  int num_samples, next_index;
-  FlexFlow::Tensor full_input, batch_input;
-  FlexFlow::Tensor full_label, batch_label;
-};
-
-struct SampleIdxs {
-  int num_samples;
-  int idxs[MAX_NUM_SAMPLES];
+  int loader_workers;
 };
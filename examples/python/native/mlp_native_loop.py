@@ -0,0 +1,73 @@
+from flexflow.core import *
+import numpy as np
+
+import argparse
+
+
+def run_steps(ffconfig, ffmodel, dataloaders, iterations, native_loop):
+    tracing_id = 100 if native_loop else 101
+    ts_start = ffconfig.get_current_time()
+    if native_loop:
+        ffmodel.run_loop(dataloaders, iterations=iterations,
+                         tracing_id=tracing_id)
+    else:
+        for iter in range(0, iterations):
+            ffconfig.begin_trace(tracing_id)
+            for d in dataloaders:
+                d.next_batch(ffmodel)
+            ffmodel.forward()
+            ffmodel.zero_gradients()
+            ffmodel.backward()
+            ffmodel.update()
+            ffconfig.end_trace(tracing_id)
+    ts_end = ffconfig.get_current_time()
+    return 1e-6 * (ts_end - ts_start)
+
+
+def top_level_task(iterations):
+    ffconfig = FFConfig()
+    print("Python API batchSize(%d) workersPerNodes(%d) numNodes(%d)" % (
+        ffconfig.batch_size, ffconfig.workers_per_node, ffconfig.num_nodes))
+    ffmodel = FFModel(ffconfig)
+
+    # A small MLP, for which issuing the steps from Python dominates
+    dims_input = [ffconfig.batch_size, 64]
+    input_tensor = ffmodel.create_tensor(dims_input, DataType.DT_FLOAT)
+    t = ffmodel.dense(input_tensor, 64, ActiMode.AC_MODE_RELU)
+    t = ffmodel.dense(t, 10)
+    t = ffmodel.softmax(t)
+
+    ffoptimizer = SGDOptimizer(ffmodel, 0.01)
+    ffmodel.optimizer = ffoptimizer
+    ffmodel.compile(loss_type=LossType.LOSS_SPARSE_CATEGORICAL_CROSSENTROPY, metrics=[
+                    MetricsType.METRICS_ACCURACY, MetricsType.METRICS_SPARSE_CATEGORICAL_CROSSENTROPY])
+    label_tensor = ffmodel.label_tensor
+
+    num_samples = ffconfig.batch_size * iterations
+    x_train = np.random.rand(num_samples, 64).astype('float32')
+    y_train = np.random.randint(0, 10, (num_samples, 1)).astype('int32')
+    dataloaders = [ffmodel.create_data_loader(input_tensor, x_train),
+                   ffmodel.create_data_loader(label_tensor, y_train)]
+
+    ffmodel.init_layers()
+
+    for native_loop in [False, True]:
+        for d in dataloaders:
+            d.reset()
+        # Warm up the trace before timing
+        run_steps(ffconfig, ffmodel, dataloaders, 2, native_loop)
+        for d in dataloaders:
+            d.reset()
+        run_time = run_steps(ffconfig, ffmodel, dataloaders, iterations, native_loop)
+        print("%s loop: iterations %d, ELAPSED TIME = %.4fs, THROUGHPUT = %.2f steps/s" %
+              ("native" if native_loop else "python", iterations, run_time,
+               iterations / run_time))
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--iterations", type=int, default=1000,
+                        help="Number of steps of each loop")
+    args, unknown = parser.parse_known_args()
+    print("mlp native loop")
+    top_level_task(args.iterations)
@@ -0,0 +1,83 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _FLEXFLOW_ACTIVATION_OFFLOAD_H_
+#define _FLEXFLOW_ACTIVATION_OFFLOAD_H_
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+namespace FlexFlow {
+
+/**
+ * @brief An operator of a strategy, as seen by the activation offload
+ * planner. Operators are given in topological order.
+ */
+struct OffloadOp {
+  std::vector<int> devices; ///< Devices running the operator
+  float forward_time = 0.0f, backward_time = 0.0f; ///< ms
+  ///< Per-device bytes of the outputs saved for the backward pass; 0 if the
+  ///< outputs cannot be offloaded
+  size_t output_bytes = 0;
+  ///< Index of the last operator reading the outputs (the operator itself if
+  ///< none does): the outputs are needed again by its backward pass
+  int last_consumer = 0;
+};
+
+/**
+ * @brief Result of plan_activation_offload.
+ */
+struct ActivationOffloadPlan {
+  std::vector<int> offloaded; ///< Indices of the offloaded operators
+  ///< For each offloaded operator, the operator before whose backward pass
+  ///< the prefetch is issued; the offload is issued after the forward pass
+  ///< of the offloaded operator itself
+  std::vector<int> prefetch_before;
+  std::unordered_map<int, float> device_mem; ///< MB per device afterwards
+  float max_per_device_mem = 0.0f;           ///< MB
+  float copy_time = 0.0f; ///< ms spent by the copy engines, all hidden
+};
+
+/**
+ * @brief Choose the saved activations to offload to host memory after the
+ * forward pass and to prefetch before the backward pass, so that every
+ * device fits below the memory threshold.
+ *
+ * @details Each device is modeled as running the forward passes of its
+ * operators back to back, then their backward passes in reverse order, with
+ * one copy engine per direction to host memory processing copies in order.
+ * An offload starts once its operator has run forward and must finish
+ * before the end of the forward pass, where the activation memory peaks; a
+ * prefetch starts after the forward pass and must finish before the
+ * backward pass of the last consumer. Activations are considered from the
+ * largest and only offloaded if all of their copies stay hidden behind
+ * compute, so offloading never lengthens the simulated step. The runtime
+ * issues the copies at the points of the returned plan.
+ *
+ * @param ops operators of the strategy in topological order
+ * @param device_mem per-device memory usage (MB) without offloading
+ * @param memory_threshold per-device memory (MB) to stay below
+ * @param host_bandwidth bandwidth between a device and host memory (B/ms)
+ */
+ActivationOffloadPlan
+    plan_activation_offload(std::vector<OffloadOp> const &ops,
+                            std::unordered_map<int, float> const &device_mem,
+                            float memory_threshold,
+                            float host_bandwidth);
+
+} // namespace FlexFlow
+
+#endif // _FLEXFLOW_ACTIVATION_OFFLOAD_H_
@@ -0,0 +1,120 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _FLEXFLOW_CAPACITY_PLANNING_H_
+#define _FLEXFLOW_CAPACITY_PLANNING_H_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace FlexFlow {
+
+/**
+ * @brief A cluster shape considered by capacity planning.
+ */
+struct ClusterCandidate {
+  int num_nodes = 1, gpus_per_node = 1;
+  float cost_per_gpu_hour = 0.0f;
+
+  int num_gpus() const {
+    return num_nodes * gpus_per_node;
+  }
+  float cost_per_hour() const {
+    return num_gpus() * cost_per_gpu_hour;
+  }
+};
+
+/**
+ * @brief Parse a comma-separated list of "<nodes>x<gpus per node>@<cost per
+ * GPU-hour>" candidates, e.g. "1x8@2.5,2x8@2.5,4x4@1.9".
+ * @return false if the list is empty or malformed
+ */
+bool parse_cluster_candidates(std::string const &spec,
+                              std::vector<ClusterCandidate> &candidates);
+
+/**
+ * @brief Roofline model of the kernel times of a GPU, which capacity
+ * planning uses instead of measuring the operators so that it runs without
+ * a GPU.
+ */
+struct AnalyticCostModel {
+  float flops_per_ms = 1e11f;     ///< Peak arithmetic throughput (FLOP/ms)
+  float bytes_per_ms = 1.5e9f;    ///< Device memory bandwidth (B/ms)
+  float kernel_overhead = 0.005f; ///< Fixed time of a kernel (ms)
+
+  /**
+   * @brief Time of a kernel (ms) doing flops operations and moving bytes to
+   * and from device memory, bound by the slower of the two.
+   */
+  float kernel_time(double flops, double bytes) const;
+};
+
+/**
+ * @brief The best strategy found by the search on one cluster candidate.
+ */
+class CapacityPlanPoint {
+public:
+  CapacityPlanPoint(ClusterCandidate const &_cluster,
+                    int batch_size,
+                    float _step_time);
+
+  ClusterCandidate cluster;
+  float step_time;  ///< Simulated time of one step (ms)
+  float throughput; ///< Samples per second
+  float cost_per_hour;
+  float cost_per_million_samples;
+};
+
+/**
+ * @brief The points not dominated by another point with both a lower or
+ * equal cost per hour and a lower or equal step time, by increasing cost.
+ */
+std::vector<CapacityPlanPoint>
+    capacity_pareto_front(std::vector<CapacityPlanPoint> const &points);
+
+/**
+ * @brief Index of the point with the lowest cost per hour whose throughput
+ * meets the target (samples/s), or -1 if none does. Ties go to the higher
+ * throughput.
+ */
+int select_capacity_point(std::vector<CapacityPlanPoint> const &points,
+                          float target_throughput);
+
+/**
+ * @brief Result of plan_capacity.
+ */
+struct CapacityPlan {
+  std::vector<CapacityPlanPoint> points; ///< One per candidate, in order
+  std::vector<CapacityPlanPoint> pareto_front;
+  int best; ///< See select_capacity_point
+};
+
+/**
+ * @brief Plan the capacity of a model trained with batch_size samples per
+ * step: evaluate the step time (ms) of every candidate, then select the
+ * cheapest one reaching the target throughput (samples/s).
+ *
+ * @param step_time simulated step time of the best strategy on a candidate
+ */
+CapacityPlan plan_capacity(
+    std::vector<ClusterCandidate> const &candidates,
+    int batch_size,
+    float target_throughput,
+    std::function<float(ClusterCandidate const &)> const &step_time);
+
+} // namespace FlexFlow
+
+#endif // _FLEXFLOW_CAPACITY_PLANNING_H_
@@ -16,6 +16,7 @@
 #ifndef _FLEXFLOW_CONFIG_H_
 #define _FLEXFLOW_CONFIG_H_
 #include "ffconst.h"
+#include "flexflow/capacity_planning.h"
 #include "legion.h"
 #include <cstring>
 #if defined(FF_USE_CUDA) || defined(FF_USE_HIP_CUDA)
@@ -117,6 +118,7 @@ public:
   int epochs, batchSize, printFreq;
   // int inputHeight, inputWidth;
   int numNodes, cpusPerNode, workersPerNode;
+  int utilityProcsPerNode; // given by -ll:util
   float device_mem; // The device (GPU) memory threshold; given by -ll:fsize
   float learningRate, weightDecay;
   size_t workSpaceSize;
@@ -128,6 +130,7 @@ public:
   size_t search_budget;
   float search_alpha;
   bool search_overlap_backward_update;
+  bool search_fusion_aware; // account for apply_fusion during the search
   CompMode computationMode;
   // Control parallelizable dimensions
   bool only_data_parallel;
@@ -141,6 +144,7 @@ public:
   std::string import_strategy_file;
   std::string export_strategy_file;
   std::string export_strategy_task_graph_file;
+  std::string export_strategy_task_graph_trace_file;
   std::string export_strategy_computation_graph_file;
   bool include_costs_dot_graph;
   tl::optional<std::string> substitution_json_path = tl::nullopt;
@@ -150,6 +154,25 @@ public:
   std::string machine_model_file;
   int simulator_segment_size;
   int simulator_max_num_segments;
+  // Task launch overhead model of the simulator (in ms)
+  float simulator_task_launch_overhead;
+  float simulator_point_launch_overhead;
+  // Step-time variability of the simulator; the search optimizes the given
+  // quantile of the step time (0 for the mean)
+  float search_step_time_quantile;
+  // Serving search (inference only): the search also picks the batch size
+  // that maximizes throughput subject to a per-batch latency SLO in ms
+  float serving_latency_slo; // 0 to disable
+  std::vector<int> serving_batch_sizes; // empty for the default candidates
+  // Capacity planning: the search is run on every candidate cluster shape
+  // before the actual one, and the cheapest shape that reaches the target
+  // throughput (samples/s) is reported
+  std::vector<ClusterCandidate> plan_clusters; // empty to disable
+  float plan_target_throughput;
+  // Kernel times of the candidates, estimated instead of measured
+  AnalyticCostModel plan_cost_model;
+  float simulator_jitter;
+  int simulator_num_samples;
   bool enable_propagation;
   tl::optional<int> search_num_nodes = tl::nullopt;
   tl::optional<int> search_num_workers = tl::nullopt;
@@ -157,6 +180,26 @@ public:
   bool enable_control_replication;
   int python_data_loader_type;
   bool perform_memory_search{false};
+  // Let the memory search offload saved activations to host memory when
+  // the copies overlap compute, before resorting to more partitioning
+  bool offload_activations{false};
+  // Lower Repartition and Combine to partitions of their input region, so
+  // that the runtime only moves the pieces whose placement changes
+  bool alias_parallel_ops{true};
+  // Weight MCMC proposals by the critical-path cost of the operators and
+  // adapt the temperature, instead of the uniform sampler with restarts
+  bool search_cost_guided_mcmc{true};
+  // Proposals of the MCMC search over the operators of the model, run next
+  // to the PCG search (0 to disable)
+  size_t search_mcmc_budget{0};
+  // Run MultiHeadAttention with the tiled kernels, which keep no score
+  // matrix, instead of cuDNN (CUDA only, ignored on HIP)
+  bool tiled_attention{false};
+  // Precision of the moments kept by AdamOptimizer
+  OptimizerStateType optimizer_state_type{OPTIMIZER_STATE_FP32};
+  // Merge chains of element-wise layers into ElementExpression layers
+  // before the operators are created
+  bool perform_expression_fusion{false};
 };
 
 class FFIterationConfig {
@@ -0,0 +1,57 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _FLEXFLOW_CPU_TASK_MODEL_H_
+#define _FLEXFLOW_CPU_TASK_MODEL_H_
+
+#include <cstddef>
+
+namespace FlexFlow {
+
+/**
+ * @brief Run time of a CPU task on a single-core processor (LOC_PROC) or on
+ * an OpenMP processor (OMP_PROC) spanning several cores.
+ *
+ * @details A task processes a number of elements at element_time per
+ * element and core. An OpenMP processor splits them across its threads but
+ * pays the fork and join of a parallel region, so small tasks are faster on
+ * a single core, and they leave the other cores to other tasks.
+ */
+struct CpuTaskModel {
+  float element_time = 1e-6f; ///< ms per element on one core
+  float omp_overhead = 0.01f; ///< ms to fork and join a parallel region
+  int omp_threads = 1;        ///< Threads of an OpenMP processor
+  float omp_efficiency = 0.8f; ///< Parallel efficiency of the threads
+
+  /**
+   * @brief Run time in ms of a task over volume elements on one core, or on
+   * an OpenMP processor if omp is set.
+   */
+  float task_time(size_t volume, bool omp) const;
+  /**
+   * @brief Whether a task over volume elements runs faster on an OpenMP
+   * processor.
+   */
+  bool prefer_omp(size_t volume) const;
+  /**
+   * @brief The smallest volume preferring an OpenMP processor, or 0 if none
+   * does.
+   */
+  size_t min_omp_volume() const;
+};
+
+} // namespace FlexFlow
+
+#endif // _FLEXFLOW_CPU_TASK_MODEL_H_
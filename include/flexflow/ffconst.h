@@ -38,6 +38,15 @@ enum LossType {
   LOSS_IDENTITY = 54,
 };
 
+enum EmbeddingMode {
+  // One num_entries x out_dim table
+  EMBEDDING_MODE_DENSE = 60,
+  // Quotient-remainder tables whose rows are multiplied elementwise
+  EMBEDDING_MODE_QR = 61,
+  // A num_entries x embed_dim table projected to out_dim
+  EMBEDDING_MODE_MIXED_DIM = 62,
+};
+
 enum CompMode {
   COMP_MODE_TRAINING = 70,
   COMP_MODE_INFERENCE = 71,
@@ -49,6 +58,13 @@ enum ParameterSyncType {
   NCCL = 82,
 };
 
+enum OptimizerStateType {
+  OPTIMIZER_STATE_FP32 = 90,
+  OPTIMIZER_STATE_BF16 = 91,
+  // 8-bit codes with a scale per block, see OPTIMIZER_STATE_BLOCK_SIZE
+  OPTIMIZER_STATE_INT8 = 92,
+};
+
 enum MetricsType {
   METRICS_ACCURACY = 1001,
   METRICS_CATEGORICAL_CROSSENTROPY = 1002,
@@ -145,6 +161,8 @@ enum OperatorType {
   OP_MEAN,  // https://pytorch.org/docs/stable/generated/torch.mean.html
   OP_LAYERNORM,
   OP_GATHER, // https://pytorch.org/docs/stable/generated/torch.gather.html
+  OP_DOT_INTERACTION,
+  OP_ELEMENT_EXPRESSION,
   // Parallel Ops
   OP_REPARTITION,
   OP_COMBINE,
@@ -0,0 +1,70 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _FLEXFLOW_GRADIENT_OVERWRITE_H_
+#define _FLEXFLOW_GRADIENT_OVERWRITE_H_
+
+#include <set>
+#include <vector>
+
+namespace FlexFlow {
+
+/**
+ * @brief The gradient accesses of the backward pass of an operator, as seen
+ * by the gradient overwrite planner. Gradients are identified by integers.
+ */
+struct GradientAccess {
+  ///< Gradients of the outputs, read by the backward pass
+  std::vector<int> reads;
+  ///< Gradients written by the backward pass (inputs, then weights), or -1
+  ///< for the inputs and weights without gradients
+  std::vector<int> writes;
+  ///< Whether the backward pass can overwrite each written gradient as a
+  ///< whole instead of accumulating into it
+  std::vector<bool> can_overwrite;
+};
+
+/**
+ * @brief Result of plan_gradient_overwrites.
+ */
+struct GradientOverwritePlan {
+  ///< For each operator and written gradient, whether the backward pass
+  ///< overwrites it
+  std::vector<std::vector<bool>> overwrite;
+  ///< Gradients overwritten by their first writer, which need no zeroing
+  std::set<int> overwritten;
+};
+
+/**
+ * @brief Find the first writer of each gradient in the backward pass, which
+ * can overwrite the gradient so that it needs no zeroing beforehand.
+ *
+ * @details The backward passes run in the reverse order of the operators,
+ * after the loss has overwritten the gradients in loss_grads. The first
+ * write of a gradient is an overwrite if its writer supports it and writes
+ * the gradient only once; any later write accumulates. A gradient read
+ * before it is written, or first written by an operator that accumulates,
+ * keeps being zeroed.
+ *
+ * @param ops operators in topological order
+ * @param loss_grads gradients overwritten by the loss
+ */
+GradientOverwritePlan
+    plan_gradient_overwrites(std::vector<GradientAccess> const &ops,
+                             std::vector<int> const &loss_grads);
+
+} // namespace FlexFlow
+
+#endif // _FLEXFLOW_GRADIENT_OVERWRITE_H_
@@ -0,0 +1,131 @@
+#ifndef _FLEXFLOW_GRAPH_IR_H
+#define _FLEXFLOW_GRAPH_IR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace FlexFlow {
+
+class FFModel;
+struct TensorBase;
+typedef TensorBase *Tensor;
+
+namespace GraphIR {
+
+/**
+ * @brief Binary form of the graph IR emitted by the Python front-ends.
+ *
+ * @details Each node of the string IR (see python/flexflow/torch/model.py)
+ * is encoded as its front-end op type, its name, the indices of its input
+ * and output nodes, and its attributes as typed values. All integers are
+ * little-endian:
+ *
+ *   "FFIR" u32:version u32:num_nodes node*
+ *   node  := u16:op_type u16:len name u16:n u32*n (inputs)
+ *            u16:n u32*n (outputs) u8:n param*n
+ *   param := u8:0 i32 | u8:1 f64 | u8:2 u16:len bytes | u8:3 i64
+ *
+ * A graph round-trips through the string IR, which is kept for debugging.
+ */
+uint32_t const VERSION = 1;
+
+// Must match OpType in python/flexflow/type.py
+enum OpCode {
+  CONV2D = 2011,
+  EMBEDDING = 2012,
+  POOL2D = 2013,
+  LINEAR = 2014,
+  SOFTMAX = 2015,
+  CONCAT = 2016,
+  FLAT = 2017,
+  BATCH_NORM = 2021,
+  RELU = 2022,
+  SIGMOID = 2023,
+  TANH = 2024,
+  ELU = 2025,
+  DROPOUT = 2026,
+  BATCH_MATMUL = 2027,
+  SPLIT = 2028,
+  RESHAPE = 2029,
+  TRANSPOSE = 2030,
+  ADD = 2041,
+  SUBTRACT = 2042,
+  MULTIPLY = 2043,
+  POW = 2045,
+  MEAN = 2046,
+  RSQRT = 2047,
+  INPUT = 2050,
+  OUTPUT = 2051,
+  GETITEM = 2070,
+  IDENTITY = 2084,
+  GELU = 2085,
+  PERMUTE = 2086,
+  SCALAR_MULTIPLY = 2087,
+  SCALAR_ADD = 2089,
+  SCALAR_SUB = 2090,
+  SCALAR_TRUEDIV = 2091,
+  FLOAT = 2100,
+  CONTIGUOUS = 2101,
+  TO = 2102,
+  UNSQUEEZE = 2103,
+  TYPE_AS = 2104,
+  VIEW = 2105,
+  SLICE = 2107,
+  PAD = 2108,
+};
+
+struct Param {
+  enum Kind : uint8_t { INT32 = 0, FLOAT = 1, STRING = 2, INT64 = 3 };
+  Kind kind = INT64;
+  int64_t i = 0;
+  double f = 0.0;
+  std::string s;
+
+  int64_t as_int() const;
+  double as_float() const;
+  bool as_bool() const;
+};
+
+struct Node {
+  int op_type;
+  std::string name;
+  std::vector<int> inputs, outputs;
+  std::vector<Param> params;
+};
+
+struct Graph {
+  std::vector<Node> nodes;
+
+  std::vector<char> serialize() const;
+  // Returns false if buffer is not a well-formed graph IR
+  static bool deserialize(char const *buffer, size_t size, Graph &graph);
+};
+
+struct LayerInfo {
+  int node;    // Index of the node that added the layer
+  int op_type; // Front-end op type of the layer
+};
+
+/**
+ * @brief Add the layers of a graph IR to a model in one pass.
+ *
+ * @details Mirrors the string_to_ff methods of the PyTorch front-end,
+ * including the defaults of the Python API, so both paths build the same
+ * layers.
+ *
+ * @param[in] inputs Tensors for the INPUT nodes, in order
+ * @param[out] outputs Tensors of the OUTPUT node
+ * @param[out] layers Node and front-end op type of each layer added
+ */
+void build(FFModel &model,
+           Graph const &graph,
+           std::vector<Tensor> const &inputs,
+           std::vector<Tensor> &outputs,
+           std::vector<LayerInfo> &layers);
+
+} // namespace GraphIR
+} // namespace FlexFlow
+
+#endif // _FLEXFLOW_GRAPH_IR_H
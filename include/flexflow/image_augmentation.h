@@ -0,0 +1,196 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _FLEXFLOW_IMAGE_AUGMENTATION_H_
+#define _FLEXFLOW_IMAGE_AUGMENTATION_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace FlexFlow {
+
+/**
+ * @brief A decoded 8-bit image with interleaved channels (HWC).
+ */
+struct Image {
+  int height = 0, width = 0, channels = 0;
+  std::vector<uint8_t> pixels;
+};
+
+/**
+ * @brief Decode a binary PPM (P6) or PGM (P5) image with 8-bit samples.
+ * @return false if the data is not such an image
+ */
+bool decode_pnm(uint8_t const *data, size_t size, Image &image);
+
+/**
+ * @brief A labeled image dataset. read() is called concurrently by the
+ * workers of an ImageBatchPipeline and must be thread-safe.
+ */
+class ImageSource {
+public:
+  virtual ~ImageSource() {}
+  virtual size_t num_samples() const = 0;
+  virtual void read(size_t index, Image &image, int &label) const = 0;
+};
+
+/**
+ * @brief The CIFAR-10 binary format: records of one label byte followed by
+ * a planar 32x32 RGB image.
+ */
+class CifarBinarySource : public ImageSource {
+public:
+  CifarBinarySource(std::string const &path);
+  size_t num_samples() const override;
+  void read(size_t index, Image &image, int &label) const override;
+
+  static constexpr int kSide = 32;
+  static constexpr size_t kRecordSize = 1 + 3 * kSide * kSide;
+
+private:
+  std::vector<uint8_t> data;
+};
+
+/**
+ * @brief A list file with one "<path> <label>" line per PNM image; relative
+ * paths are resolved against the directory of the list. Images are read
+ * and decoded on each access.
+ */
+class ImageListSource : public ImageSource {
+public:
+  ImageListSource(std::string const &list_file);
+  size_t num_samples() const override;
+  void read(size_t index, Image &image, int &label) const override;
+
+private:
+  std::vector<std::string> paths;
+  std::vector<int> labels;
+};
+
+/**
+ * @brief Random images and labels, a deterministic function of the index,
+ * for benchmarking without a dataset.
+ */
+class SyntheticImageSource : public ImageSource {
+public:
+  SyntheticImageSource(
+      size_t num_samples, int height, int width, int channels, int num_labels);
+  size_t num_samples() const override;
+  void read(size_t index, Image &image, int &label) const override;
+
+private:
+  size_t size;
+  int height, width, channels, num_labels;
+};
+
+/**
+ * @brief Open a dataset for the image examples: a CIFAR binary file if the
+ * path ends in .bin, an image list otherwise, or synthetic images of the
+ * given shape if the path is empty.
+ */
+std::unique_ptr<ImageSource> open_image_source(std::string const &path,
+                                               size_t num_synthetic_samples,
+                                               int height,
+                                               int width,
+                                               int num_labels);
+
+/**
+ * @brief The transformation from a source image to a network input.
+ */
+struct ImageAugmentation {
+  int channels = 3, height = 224, width = 224; ///< Output shape
+  ///< Crop a random area of [min_crop_area, 1] of the image with an aspect
+  ///< ratio in [3/4, 4/3] before resizing; resize the whole image otherwise
+  bool random_crop = true;
+  float min_crop_area = 0.08f;
+  bool random_flip = true; ///< Mirror horizontally with probability 1/2
+  ///< Per-channel normalization of the [0, 1] pixel values
+  std::vector<float> mean = {0.485f, 0.456f, 0.406f};
+  std::vector<float> stddev = {0.229f, 0.224f, 0.225f};
+};
+
+/**
+ * @brief Augment an image into a planar (CHW) float output of the shape of
+ * the augmentation, using bilinear interpolation. All randomness comes from
+ * the seed. A single-channel image is replicated over the output channels.
+ */
+void augment_image(Image const &image,
+                   ImageAugmentation const &aug,
+                   uint64_t seed,
+                   float *output);
+
+/**
+ * @brief Load and augment batches of images on a pool of CPU threads.
+ *
+ * @details The calling thread takes part in each batch, so the pipeline
+ * runs num_workers - 1 threads of its own. Samples are distributed
+ * dynamically; the augmentation of each sample only depends on the batch
+ * seed and its position, so the output does not depend on num_workers.
+ * Batches are loaded one at a time.
+ */
+class ImageBatchPipeline {
+public:
+  ImageBatchPipeline(std::unique_ptr<ImageSource> source,
+                     ImageAugmentation const &aug,
+                     int num_workers);
+  ~ImageBatchPipeline();
+
+  /**
+   * @brief Load the samples at the given indices of the source into images
+   * (batch x channels x height x width) and labels.
+   */
+  void load_batch(std::vector<size_t> const &indices,
+                  uint64_t seed,
+                  float *images,
+                  int32_t *labels);
+
+  ImageSource const &get_source() const {
+    return *source;
+  }
+  ImageAugmentation const &get_augmentation() const {
+    return aug;
+  }
+  int get_num_workers() const {
+    return (int)workers.size() + 1;
+  }
+
+private:
+  void worker_loop();
+  void process_samples();
+
+  std::unique_ptr<ImageSource> source;
+  ImageAugmentation aug;
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable work_ready, work_done;
+  // The batch being loaded, guarded by mutex
+  std::vector<size_t> const *batch_indices = nullptr;
+  uint64_t batch_seed = 0;
+  float *batch_images = nullptr;
+  int32_t *batch_labels = nullptr;
+  size_t next_sample = 0, samples_done = 0;
+  uint64_t generation = 0;
+  bool stopping = false;
+};
+
+} // namespace FlexFlow
+
+#endif // _FLEXFLOW_IMAGE_AUGMENTATION_H_
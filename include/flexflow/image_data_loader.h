@@ -0,0 +1,89 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _FLEXFLOW_IMAGE_DATA_LOADER_H_
+#define _FLEXFLOW_IMAGE_DATA_LOADER_H_
+
+#include "flexflow/image_augmentation.h"
+#include "flexflow/model.h"
+
+namespace FlexFlow {
+
+/**
+ * @brief Feed augmented image batches to the input and label tensors of a
+ * model, e.g., of shape [W, H, C, N, replica] and [1, N, replica].
+ *
+ * @details Each batch is decoded and augmented by an ImageBatchPipeline in
+ * a CPU task that writes one of two zero-copy staging buffers, then copied
+ * into the partitions of the input and label tensors by GPU tasks.
+ * next_batch() loads the current buffer into the tensors and launches the
+ * fill of the next batch into the other one, so that augmentation overlaps
+ * with the training step that follows. The output shape of the augmentation
+ * is taken from the input tensor.
+ */
+class ImageDataLoader {
+public:
+  ImageDataLoader(FFModel &ff,
+                  ParallelTensor input,
+                  ParallelTensor label,
+                  std::unique_ptr<ImageSource> source,
+                  ImageAugmentation const &aug,
+                  int num_workers,
+                  bool shuffle = true);
+  ~ImageDataLoader();
+
+  /**
+   * @brief Start a new epoch: reshuffle the samples and launch the fill of
+   * the first batch.
+   */
+  void reset(void);
+  /**
+   * @brief Load the next batch of the epoch into the input and label tensors.
+   */
+  void next_batch(FFModel &ff);
+
+  static void
+      fill_batch_task(Legion::Task const *task,
+                      std::vector<Legion::PhysicalRegion> const &regions,
+                      Legion::Context ctx,
+                      Legion::Runtime *runtime);
+  template <typename DT>
+  static void
+      load_batch_task(Legion::Task const *task,
+                      std::vector<Legion::PhysicalRegion> const &regions,
+                      Legion::Context ctx,
+                      Legion::Runtime *runtime);
+
+public:
+  size_t num_samples;
+  int num_batches;
+
+private:
+  void launch_fill(int buffer);
+  void launch_load(ParallelTensor batch, ParallelTensor staging, int task_id);
+
+  FFModel &ff;
+  ParallelTensor batch_input, batch_label;
+  ParallelTensor staging_input[2], staging_label[2];
+  int loader_id;
+  bool shuffle;
+  std::vector<size_t> order;
+  int epoch = 0, next_index = 0;
+  Legion::Future last_fill[2];
+};
+
+} // namespace FlexFlow
+
+#endif // _FLEXFLOW_IMAGE_DATA_LOADER_H_
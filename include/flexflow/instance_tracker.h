@@ -0,0 +1,213 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _FLEXFLOW_INSTANCE_TRACKER_H_
+#define _FLEXFLOW_INSTANCE_TRACKER_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace FlexFlow {
+
+/**
+ * @brief Usage statistics of the physical instances in one memory.
+ */
+struct MemoryUsageStats {
+  size_t capacity = 0;  ///< Bytes of the memory (0 if unknown)
+  size_t allocated = 0; ///< Bytes held by live instances
+  size_t peak = 0;      ///< Maximum of allocated
+  size_t num_live = 0, num_created = 0, num_reused = 0, num_collected = 0;
+};
+
+/**
+ * @brief Track the lifetime of the physical instances created by the
+ * mappers of a process.
+ *
+ * @details Every instance is stamped with the time of the last mapping that
+ * chose it. There is no reference count: the runtime itself never collects
+ * an instance in use, whatever its priority. Instances are kept alive while
+ * their memory is below the garbage collection threshold (a fraction of its
+ * capacity); above it, the least recently used instances are selected as
+ * victims, which the mapper makes collectable by the runtime. Victims are
+ * forgotten once the runtime reports them as collected.
+ *
+ * @tparam Mem memory handle
+ * @tparam Inst instance handle
+ */
+template <typename Mem, typename Inst>
+class InstanceTracker {
+public:
+  InstanceTracker(double _gc_threshold = 0.8) : gc_threshold(_gc_threshold) {
+    assert(gc_threshold > 0.0 && gc_threshold <= 1.0);
+  }
+
+  // Start a new mapping; instances used from now on are protected from
+  // being selected as victims until the next call
+  void begin_mapping(void) {
+    epoch = clock;
+  }
+
+  void set_capacity(Mem const &mem, size_t capacity) {
+    stats[mem].capacity = capacity;
+  }
+
+  void add_instance(Mem const &mem, Inst const &inst, size_t size) {
+    assert(instances.find(inst) == instances.end());
+    InstanceInfo &info = instances[inst];
+    info.memory = mem;
+    info.size = size;
+    MemoryUsageStats &s = stats[mem];
+    s.allocated += size;
+    s.peak = std::max(s.peak, s.allocated);
+    s.num_live++;
+    s.num_created++;
+  }
+
+  // Record a mapping that chose the instance; returns false for instances
+  // not created through this tracker
+  bool use_instance(Inst const &inst) {
+    typename std::map<Inst, InstanceInfo>::iterator it = instances.find(inst);
+    if (it == instances.end()) {
+      return false;
+    }
+    if (it->second.num_uses > 0) {
+      stats[it->second.memory].num_reused++;
+    }
+    it->second.num_uses++;
+    it->second.last_use = ++clock;
+    it->second.victim = false;
+    return true;
+  }
+
+  void remove_instance(Inst const &inst) {
+    typename std::map<Inst, InstanceInfo>::iterator it = instances.find(inst);
+    assert(it != instances.end());
+    MemoryUsageStats &s = stats[it->second.memory];
+    assert(s.allocated >= it->second.size);
+    s.allocated -= it->second.size;
+    s.num_live--;
+    s.num_collected++;
+    instances.erase(it);
+  }
+
+  // Whether allocating extra_bytes more would exceed the GC threshold
+  bool under_pressure(Mem const &mem, size_t extra_bytes = 0) const {
+    typename std::map<Mem, MemoryUsageStats>::const_iterator it =
+        stats.find(mem);
+    if (it == stats.end() || it->second.capacity == 0) {
+      return false;
+    }
+    return it->second.allocated + extra_bytes >
+           gc_threshold * it->second.capacity;
+  }
+
+  // Pick the least recently used instances of mem to make collectable, until
+  // allocating extra_bytes more would stay below the GC threshold. Instances
+  // used by the current mapping are never picked. With all_idle, every
+  // instance not in use is picked regardless of the threshold
+  std::vector<Inst>
+      select_victims(Mem const &mem, size_t extra_bytes, bool all_idle) {
+    std::vector<std::pair<unsigned long long, Inst>> candidates;
+    size_t reclaimable = 0;
+    for (auto const &it : instances) {
+      if (!(it.second.memory == mem)) {
+        continue;
+      }
+      if (it.second.victim) {
+        reclaimable += it.second.size;
+      } else if (it.second.last_use <= epoch) {
+        candidates.push_back(std::make_pair(it.second.last_use, it.first));
+      }
+    }
+    std::sort(candidates.begin(),
+              candidates.end(),
+              [](std::pair<unsigned long long, Inst> const &lhs,
+                 std::pair<unsigned long long, Inst> const &rhs) {
+                return lhs.first < rhs.first;
+              });
+    MemoryUsageStats const &s = stats[mem];
+    std::vector<Inst> victims;
+    for (auto const &c : candidates) {
+      if (!all_idle && (s.capacity == 0 || s.allocated + extra_bytes <=
+                                               reclaimable +
+                                                   gc_threshold * s.capacity)) {
+        break;
+      }
+      InstanceInfo &info = instances[c.second];
+      info.victim = true;
+      reclaimable += info.size;
+      victims.push_back(c.second);
+    }
+    return victims;
+  }
+
+  // Make an instance a victim right away, e.g. once its data is also valid
+  // in another memory; returns false for instances not created through this
+  // tracker
+  bool evict_instance(Inst const &inst) {
+    typename std::map<Inst, InstanceInfo>::iterator it = instances.find(inst);
+    if (it == instances.end()) {
+      return false;
+    }
+    it->second.victim = true;
+    return true;
+  }
+
+  bool is_victim(Inst const &inst) const {
+    typename std::map<Inst, InstanceInfo>::const_iterator it =
+        instances.find(inst);
+    return it != instances.end() && it->second.victim;
+  }
+
+  std::vector<Inst> get_victims(Mem const &mem) const {
+    std::vector<Inst> victims;
+    for (auto const &it : instances) {
+      if (it.second.memory == mem && it.second.victim) {
+        victims.push_back(it.first);
+      }
+    }
+    return victims;
+  }
+
+  MemoryUsageStats const &get_stats(Mem const &mem) {
+    return stats[mem];
+  }
+
+  std::map<Mem, MemoryUsageStats> const &get_all_stats() const {
+    return stats;
+  }
+
+private:
+  struct InstanceInfo {
+    Mem memory;
+    size_t size = 0;
+    size_t num_uses = 0;
+    unsigned long long last_use = 0;
+    bool victim = false;
+  };
+
+  double gc_threshold;
+  unsigned long long clock = 0, epoch = 0;
+  std::map<Inst, InstanceInfo> instances;
+  std::map<Mem, MemoryUsageStats> stats;
+};
+
+}; // namespace FlexFlow
+
+#endif // _FLEXFLOW_INSTANCE_TRACKER_H_
@@ -0,0 +1,105 @@
+#ifndef _FLEXFLOW_LAYERWISE_OPTIMIZER_H_
+#define _FLEXFLOW_LAYERWISE_OPTIMIZER_H_
+
+#include "flexflow/optimizer_state.h"
+
+namespace FlexFlow {
+
+/**
+ * @brief Ratio of the weight norm to the update norm of a tensor, or 1 when
+ * either norm is zero (e.g. freshly zeroed biases).
+ */
+FF_STATE_FUNC float trust_ratio(float w_norm, float u_norm) {
+  return (w_norm > 0.0f && u_norm > 0.0f) ? w_norm / u_norm : 1.0f;
+}
+
+/**
+ * @brief The hyper-parameters of one LAMB step; bias_correction1 and
+ * bias_correction2 are 1 - beta1^t and 1 - beta2^t.
+ */
+struct LAMBStep {
+  float lr, beta1, beta2, bias_correction1, bias_correction2, weight_decay,
+      epsilon;
+};
+
+/**
+ * @brief The direction of a LAMB step given the updated moments: the Adam
+ * direction plus the decoupled weight decay.
+ */
+FF_STATE_FUNC float
+    lamb_direction(LAMBStep const &s, float w, float m, float v) {
+  float m_hat = m / s.bias_correction1;
+  float v_hat = v / s.bias_correction2;
+  return m_hat / (sqrtf(v_hat) + s.epsilon) + s.weight_decay * w;
+}
+
+/**
+ * @brief Update the moments of an element and return its LAMB direction.
+ */
+FF_STATE_FUNC float
+    lamb_moments(LAMBStep const &s, float grad, float w, float &m, float &v) {
+  m = s.beta1 * m + (1 - s.beta1) * grad;
+  v = s.beta2 * v + (1 - s.beta2) * grad * grad;
+  return lamb_direction(s, w, m, v);
+}
+
+/**
+ * @brief The hyper-parameters of one LARS step.
+ */
+struct LARSStep {
+  float lr, momentum, weight_decay, trust_coefficient, epsilon;
+};
+
+/**
+ * @brief The layer-wise learning rate multiplier of LARS.
+ */
+FF_STATE_FUNC float
+    lars_ratio(LARSStep const &s, float w_norm, float g_norm) {
+  if (w_norm > 0.0f && g_norm > 0.0f) {
+    return s.trust_coefficient * w_norm /
+           (g_norm + s.weight_decay * w_norm + s.epsilon);
+  }
+  return 1.0f;
+}
+
+FF_STATE_FUNC void
+    lars_step(LARSStep const &s, float ratio, float grad, float &w, float &v) {
+  v = s.momentum * v + s.lr * ratio * (grad + s.weight_decay * w);
+  w -= v;
+}
+
+namespace Kernels {
+namespace LAMB {
+
+/**
+ * @brief LAMB update of a whole tensor on the CPU. The first pass updates
+ * the moments and accumulates the norms of the weights and of the update,
+ * the second applies the update scaled by their trust ratio.
+ */
+void update_cpu(LAMBStep const &step,
+                size_t size,
+                float const *w_grad,
+                float *w,
+                float *m,
+                float *v);
+
+} // namespace LAMB
+
+namespace LARS {
+
+/**
+ * @brief LARS update of a whole tensor on the CPU. The norms of the weights
+ * and of the gradients are accumulated in one pass before the momentum
+ * update.
+ */
+void update_cpu(LARSStep const &step,
+                size_t size,
+                float const *w_grad,
+                float *w,
+                float *v);
+
+} // namespace LARS
+} // namespace Kernels
+} // namespace FlexFlow
+
+#endif // _FLEXFLOW_LAYERWISE_OPTIMIZER_H_
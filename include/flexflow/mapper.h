@@ -17,9 +17,13 @@
 #define __FLEXFLOW_MAPPER_H__
 
 #include "default_mapper.h"
+#include "flexflow/cpu_task_model.h"
+#include "flexflow/instance_tracker.h"
 #include "legion.h"
 #include "model.h"
 #include "null_mapper.h"
+#include <memory>
+#include <mutex>
 
 namespace FlexFlow {
 
@@ -51,6 +55,17 @@ struct InstanceCreationLog {
   Processor processor;
 };
 
+/**
+ * @brief The instance tracker of a process, shared by the mappers of its
+ * processors since they create instances in the same zero-copy and system
+ * memories. Hold lock while using tracker.
+ */
+struct SharedInstanceTracker {
+  SharedInstanceTracker(double gc_threshold) : tracker(gc_threshold) {}
+  std::mutex lock;
+  InstanceTracker<Memory, PhysicalInstance> tracker;
+};
+
 class FFMapper : public NullMapper {
 public:
   FFMapper(MapperRuntime *rt,
@@ -58,7 +73,10 @@ public:
            Processor local,
            char const *mapper_name, // const std::string& strategyFile,
            bool _enable_control_replication,
-           bool _log_instance_creation);
+           bool _log_instance_creation,
+           std::shared_ptr<SharedInstanceTracker> _instance_tracker,
+           bool _print_memory_stats,
+           CpuTaskModel const &_cpu_task_model);
   ~FFMapper();
   virtual char const *get_mapper_name(void) const;
   virtual MapperSyncModel get_mapper_sync_model(void) const;
@@ -71,6 +89,9 @@ public:
                                         Machine machine,
                                         int argv,
                                         char **argc);
+  // Usage of the memories the mappers of this process created instances in
+  std::map<Memory, MemoryUsageStats> get_memory_usage_stats(void) const;
+  void print_memory_usage_stats(void) const;
   virtual void select_task_options(const MapperContext ctx,
                                    Task const &task,
                                    TaskOptions &output);
@@ -317,6 +338,12 @@ private: // Default helper functions
                              RegionRequirement const &req,
                              bool &created,
                              size_t *footprint);
+  bool relieve_memory_pressure(MapperContext ctx,
+                               Memory target_mem,
+                               size_t extra_bytes,
+                               bool all_idle);
+  void record_instance_use(MapperContext ctx, PhysicalInstance const &inst);
+  void set_memory_capacity(Memory const &mem);
   LayoutConstraintID
       default_select_layout_constraints(MapperContext ctx,
                                         Memory target_memory,
@@ -338,6 +365,12 @@ private:
   bool is_parameter_server_update_task(TaskID tid);
   bool is_initializer_task(TaskID tid);
   std::vector<Processor> const &all_procs_by_kind(Processor::Kind kind);
+  // The processors of the points of a task on a CPU view: OpenMP
+  // processors for tasks with an OMP_PROC variant that are large enough,
+  // single-core processors otherwise
+  std::vector<Processor> const *select_cpu_devices(const MapperContext ctx,
+                                                   Task const &task,
+                                                   Domain const &domain);
 
 protected:
   const Processor local_processor;
@@ -347,7 +380,10 @@ protected:
   bool enable_control_replication;
   bool log_instance_creation;
   std::vector<Processor> all_gpus, all_cpus, all_pys, local_gpus, local_cpus,
-      local_pys;
+      local_pys, all_omps, local_omps;
+  // The OpenMP processor standing in for each CPU of a CPU view
+  std::vector<Processor> cpu_omps;
+  CpuTaskModel cpu_task_model;
   std::map<Processor, Memory> proc_fbmems, proc_zcmems;
   std::map<unsigned long long, Processor> cache_update_tasks;
   // We use MappingTagID has the key since we will pass the tag to the mapper
@@ -355,6 +391,8 @@ protected:
   std::map<std::pair<Memory::Kind, FieldSpace>, LayoutConstraintID>
       layout_constraint_cache;
   std::vector<InstanceCreationLog> created_instances;
+  bool print_memory_stats;
+  std::shared_ptr<SharedInstanceTracker> instance_tracker;
 };
 
 }; // namespace FlexFlow
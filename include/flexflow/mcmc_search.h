@@ -0,0 +1,268 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _FLEXFLOW_MCMC_SEARCH_H_
+#define _FLEXFLOW_MCMC_SEARCH_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace FlexFlow {
+
+/**
+ * @brief Settings of mcmc_search.
+ */
+struct McmcSearchOptions {
+  size_t budget = 0; ///< Number of proposals
+  ///< Uphill moves of diff ms are accepted with probability exp(-alpha * diff)
+  ///< by the uniform sampler; 1 / alpha is the initial temperature otherwise
+  float alpha = 0.05f;
+  ///< Weight operator proposals by their cost and sample configurations from
+  ///< the accepted moves, with an adaptive temperature; the uniform sampler
+  ///< restarts from the best strategy periodically instead
+  bool cost_guided = true;
+  float uniform_mix = 0.1f; ///< Share of operators proposed uniformly
+  float learned_mix = 0.5f; ///< Share of configurations from accepted moves
+  ///< Share of proposals made by McmcProblem::rewrite, when it is set
+  float rewrite_chance = 0.0f;
+  ///< The temperature is adjusted every window proposals so that the rate of
+  ///< accepted uphill moves follows a target annealed linearly from
+  ///< initial_acceptance to final_acceptance over the budget
+  size_t window = 100;
+  float initial_acceptance = 0.05f, final_acceptance = 0.001f;
+  ///< Record the first iteration whose best runtime is at most this
+  float target_runtime = 0.0f;
+};
+
+/**
+ * @brief Result of mcmc_search.
+ */
+struct McmcSearchStats {
+  size_t accepted = 0;       ///< Accepted proposals
+  size_t uphill_accepted = 0; ///< Accepted proposals that were slower
+  size_t best_iteration = 0; ///< Iteration of the last improvement
+  ///< First iteration reaching options.target_runtime, or SIZE_MAX
+  size_t target_iteration = std::numeric_limits<size_t>::max();
+  float best_runtime = 0.0f;
+  float final_temperature = 0.0f;
+};
+
+/**
+ * @brief A strategy search problem: one configuration per operator.
+ */
+template <typename Config>
+struct McmcProblem {
+  ///< Simulated runtime of a strategy; also sets the cost of each operator
+  ///< (e.g., its time on the critical path) used to weight proposals
+  std::function<float(std::vector<Config> const &, std::vector<float> &)>
+      simulate;
+  ///< A random configuration of an operator
+  std::function<Config(int)> random_config;
+  ///< Operators that may be rewritten
+  std::vector<bool> mutable_ops;
+  ///< Optional proposal that may rewrite several operators at once (e.g., by
+  ///< propagating a configuration to the neighbours of an operator)
+  std::function<void(std::vector<Config> const &, std::vector<Config> &)>
+      rewrite;
+};
+
+namespace mcmc_internal {
+
+template <typename Config>
+class AcceptedConfigs {
+public:
+  void record(Config const &config) {
+    for (auto &entry : entries) {
+      if (entry.first == config) {
+        entry.second += 1.0f;
+        total += 1.0f;
+        return;
+      }
+    }
+    entries.push_back(std::make_pair(config, 1.0f));
+    total += 1.0f;
+  }
+
+  bool empty() const {
+    return entries.empty();
+  }
+
+  Config const &sample(std::mt19937 &rng) const {
+    assert(!entries.empty());
+    float r = std::uniform_real_distribution<float>(0.0f, total)(rng);
+    for (auto const &entry : entries) {
+      if (r < entry.second) {
+        return entry.first;
+      }
+      r -= entry.second;
+    }
+    return entries.back().first;
+  }
+
+private:
+  std::vector<std::pair<Config, float>> entries;
+  float total = 0.0f;
+};
+
+} // namespace mcmc_internal
+
+/**
+ * @brief Markov chain Monte Carlo search over the configurations of the
+ * operators, starting from best, which is updated to the best strategy
+ * found.
+ *
+ * @details Each proposal rewrites the configuration of one operator. The
+ * uniform sampler picks the operator and its new configuration uniformly,
+ * accepts uphill moves with a fixed probability and periodically restarts
+ * from the best strategy. The cost-guided sampler picks operators in
+ * proportion to their cost in the current strategy, mixed with a uniform
+ * share so that every operator stays reachable. Configurations are drawn
+ * either at random or from the configurations of the operator accepted so
+ * far. Its temperature is adapted to keep the rate of accepted uphill moves
+ * close to an annealed target. With either sampler, a share of the
+ * proposals can come from problem.rewrite instead.
+ */
+template <typename Config>
+McmcSearchStats mcmc_search(McmcProblem<Config> const &problem,
+                            std::vector<Config> &best,
+                            McmcSearchOptions const &options,
+                            std::mt19937 &rng) {
+  size_t const num_ops = best.size();
+  assert(problem.mutable_ops.size() == num_ops);
+  std::vector<int> candidates;
+  for (size_t i = 0; i < num_ops; i++) {
+    if (problem.mutable_ops[i]) {
+      candidates.push_back(i);
+    }
+  }
+  McmcSearchStats stats;
+  std::vector<float> current_costs(num_ops), next_costs(num_ops);
+  stats.best_runtime = problem.simulate(best, current_costs);
+  if (stats.best_runtime <= options.target_runtime) {
+    stats.target_iteration = 0;
+  }
+  if (candidates.empty()) {
+    return stats;
+  }
+  std::vector<Config> current = best, next;
+  float current_runtime = stats.best_runtime;
+  std::vector<mcmc_internal::AcceptedConfigs<Config>> accepted(num_ops);
+  std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+
+  float temperature = 1.0f / options.alpha;
+  size_t window_uphill = 0, window_uphill_accepted = 0;
+  size_t reset_span = std::min(std::max(options.budget / 100, (size_t)1),
+                               (size_t)1000);
+  size_t last_reset_iter = 0;
+  std::vector<float> weights(candidates.size());
+  for (size_t iter = 1; iter <= options.budget; iter++) {
+    if (!options.cost_guided && iter - last_reset_iter >= reset_span) {
+      // Reset the current strategy to be the best strategy
+      current = best;
+      current_runtime = stats.best_runtime;
+      last_reset_iter = iter;
+    }
+    next = current;
+    int op = -1;
+    if (problem.rewrite && uniform(rng) < options.rewrite_chance) {
+      problem.rewrite(current, next);
+    } else {
+      // Choose the operator
+      if (options.cost_guided) {
+        float total = 0.0f;
+        for (int i : candidates) {
+          total += std::max(current_costs[i], 0.0f);
+        }
+        float mix = total > 0.0f ? options.uniform_mix : 1.0f;
+        for (size_t k = 0; k < candidates.size(); k++) {
+          float share =
+              total > 0.0f
+                  ? std::max(current_costs[candidates[k]], 0.0f) / total
+                  : 0.0f;
+          weights[k] = (1.0f - mix) * share + mix / candidates.size();
+        }
+        op = candidates[std::discrete_distribution<int>(weights.begin(),
+                                                        weights.end())(rng)];
+      } else {
+        op = candidates[std::uniform_int_distribution<size_t>(
+            0, candidates.size() - 1)(rng)];
+      }
+      // Choose its configuration
+      if (options.cost_guided && !accepted[op].empty() &&
+          uniform(rng) < options.learned_mix) {
+        next[op] = accepted[op].sample(rng);
+      } else {
+        next[op] = problem.random_config(op);
+      }
+    }
+    float next_runtime = problem.simulate(next, next_costs);
+    if (next_runtime < stats.best_runtime) {
+      stats.best_runtime = next_runtime;
+      stats.best_iteration = iter;
+      best = next;
+    }
+    if (stats.best_runtime <= options.target_runtime &&
+        stats.target_iteration == std::numeric_limits<size_t>::max()) {
+      stats.target_iteration = iter;
+    }
+    float diff = next_runtime - current_runtime;
+    bool accept = diff <= 0.0f;
+    if (!accept) {
+      window_uphill++;
+      accept = uniform(rng) < std::exp(-diff / temperature);
+      if (accept) {
+        window_uphill_accepted++;
+        stats.uphill_accepted++;
+      }
+    }
+    if (accept) {
+      stats.accepted++;
+      if (op >= 0) {
+        accepted[op].record(next[op]);
+      } else {
+        for (size_t i = 0; i < num_ops; i++) {
+          if (!(next[i] == current[i])) {
+            accepted[i].record(next[i]);
+          }
+        }
+      }
+      current.swap(next);
+      current_costs.swap(next_costs);
+      current_runtime = next_runtime;
+    }
+    if (options.cost_guided && iter % options.window == 0 &&
+        window_uphill > 0) {
+      float progress = (float)iter / options.budget;
+      float target = options.initial_acceptance +
+                     progress * (options.final_acceptance -
+                                 options.initial_acceptance);
+      float rate = (float)window_uphill_accepted / window_uphill;
+      temperature *= rate > target ? 0.8f : 1.25f;
+      window_uphill = window_uphill_accepted = 0;
+    }
+  }
+  stats.final_temperature = temperature;
+  return stats;
+}
+
+} // namespace FlexFlow
+
+#endif // _FLEXFLOW_MCMC_SEARCH_H_
@@ -18,6 +18,7 @@
 
 #include <cassert>
 #include <string>
+#include <vector>
 
 namespace FlexFlow {
 
@@ -72,6 +73,12 @@ public:
   float search_time{};
   ///< The max of per-device memory usage among all devices
   float max_per_device_mem_all_deivces = 0.0;
+  ///< Guids of the nodes whose saved activations are offloaded to host
+  ///< memory to fit the memory threshold (see plan_activation_offload)
+  std::vector<size_t> offloaded_nodes;
+  ///< Guids of the nodes before whose backward passes the activations of
+  ///< offloaded_nodes are prefetched
+  std::vector<size_t> prefetch_nodes;
 };
 
 namespace PCG {
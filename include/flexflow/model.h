@@ -30,11 +30,14 @@
 #include "optimizer.h"
 #include "parallel_tensor.h"
 #include "recompile.h"
+#include "region_cache.h"
 #include "simulator.h"
 #include "tensor.h"
 #include "tl/optional.hpp"
 #include <functional>
+#include <set>
 #include <unistd.h>
+#include <unordered_set>
 #include <utility>
 
 #include "ffconst.h"
@@ -69,6 +72,18 @@ enum TaskIDs {
   GATHER_INIT_TASK_ID,
   GATHER_FWD_TASK_ID,
   GATHER_BWD_TASK_ID,
+  DOT_INTERACTION_INIT_TASK_ID,
+  DOT_INTERACTION_FWD_TASK_ID,
+  DOT_INTERACTION_BWD_TASK_ID,
+  ELEMENT_EXPRESSION_INIT_TASK_ID,
+  ELEMENT_EXPRESSION_FWD_TASK_ID,
+  ELEMENT_EXPRESSION_BWD_TASK_ID,
+  SLICE_INIT_TASK_ID,
+  SLICE_FWD_TASK_ID,
+  SLICE_BWD_TASK_ID,
+  PAD_INIT_TASK_ID,
+  PAD_FWD_TASK_ID,
+  PAD_BWD_TASK_ID,
   GROUP_BY_INIT_TASK_ID,
   GROUP_BY_FWD_TASK_ID,
   GROUP_BY_BWD_TASK_ID,
@@ -143,14 +158,25 @@ enum TaskIDs {
   UPDATE_METRICS_TASK_ID,
   // Parameter server prefetch task
   PS_PREFETCH_TASK_ID,
+  // Activation offloading
+  ACTIVATION_OFFLOAD_TASK_ID,
+  ACTIVATION_PREFETCH_TASK_ID,
+  // Image data loader
+  IMAGE_DL_FILL_TASK_ID,
+  IMAGE_DL_LOAD_INPUT_TASK_ID,
+  IMAGE_DL_LOAD_LABEL_TASK_ID,
   // Loss
   LOSS_BWD_TASK_ID,
   // Optimizer with PS
   SGD_UPD_PS_TASK_ID,
   ADAM_UPD_PS_TASK_ID,
+  LAMB_UPD_PS_TASK_ID,
+  LARS_UPD_PS_TASK_ID,
   // Optimizer with NCCL
   SGD_UPD_NCCL_TASK_ID,
   ADAM_UPD_NCCL_TASK_ID,
+  LAMB_UPD_NCCL_TASK_ID,
+  LARS_UPD_NCCL_TASK_ID,
   // Initializer
   GLOROT_INIT_TASK_ID,
   ZERO_INIT_TASK_ID,
@@ -255,8 +281,10 @@ class BatchMatmul;
 class Cast;
 class Concat;
 class Conv2D;
+class DotInteraction;
 class Dropout;
 class ElementBinary;
+class ElementExpression;
 class ElementUnary;
 class Embedding;
 class Flat;
@@ -265,9 +293,11 @@ class Group_by;
 class LayerNorm;
 class Linear;
 class MultiHeadAttention;
+class Pad;
 class Pool2D;
 class Reduce;
 class Reshape;
+class Slice;
 class Softmax;
 class Split;
 class TopK;
@@ -429,11 +459,42 @@ public:
                    Layer const *shared_op = NULL,
                    Initializer *kernel_initializer = NULL,
                    char const *name = NULL);
+  // Add a quotient-remainder embedding layer: row i is the elementwise
+  // product of row i / num_buckets of a quotient table and row
+  // i % num_buckets of a remainder table
+  Tensor qr_embedding(const Tensor input,
+                      int num_entries,
+                      int num_buckets,
+                      int outDim,
+                      AggrMode aggr,
+                      DataType dtype = DT_FLOAT,
+                      Initializer *kernel_initializer = NULL,
+                      char const *name = NULL);
+  // Add a mixed-dimension embedding layer: a num_entries x embed_dim table
+  // followed by a learned embed_dim x outDim projection
+  Tensor mixed_dim_embedding(const Tensor input,
+                             int num_entries,
+                             int embed_dim,
+                             int outDim,
+                             AggrMode aggr,
+                             DataType dtype = DT_FLOAT,
+                             Initializer *kernel_initializer = NULL,
+                             char const *name = NULL);
   // Add a gather layer
   Tensor gather(const Tensor input,
                 const Tensor index,
                 int dim,
                 char const *name = NULL);
+  // Add a DLRM dot-product feature interaction layer
+  Tensor dot_interaction(const Tensor dense,
+                         std::vector<Tensor> const &embeddings,
+                         bool self_interaction = false,
+                         bool concat_dense = true,
+                         char const *name = NULL);
+  // Add a layer computing a DAG of element-wise operations in one pass
+  Tensor element_expression(std::vector<Tensor> const &inputs,
+                            ExpressionProgram const &program,
+                            char const *name = NULL);
   // Add a group_by layer
   void group_by(const Tensor data,
                 const Tensor assign,
@@ -524,6 +585,19 @@ public:
   Tensor transpose(const Tensor input,
                    std::vector<int> const &perm,
                    char const *name = NULL);
+  // Add a slice layer: the window [starts[i], ends[i]) of the leading dims,
+  // where negative indices count from the end
+  Tensor slice(const Tensor input,
+               std::vector<int> const &starts,
+               std::vector<int> const &ends,
+               char const *name = NULL);
+  // Add a pad layer: pads_before[i] and pads_after[i] elements of value
+  // around each dim
+  Tensor pad(const Tensor input,
+             std::vector<int> const &pads_before,
+             std::vector<int> const &pads_after,
+             float value = 0.0f,
+             char const *name = NULL);
   Tensor reduce_sum(const Tensor input,
                     std::vector<int> const &axes,
                     bool keepdims = false,
@@ -662,10 +736,14 @@ public:
   void deserialize_graph_optimal_view(
       Legion::Deserializer &dez,
       PCG::Graph *graph,
-      std::unordered_map<PCG::Node, MachineView> &optimal_views);
+      std::unordered_map<PCG::Node, MachineView> &optimal_views,
+      std::unordered_map<PCG::Node, PCG::Node> &offloaded_nodes);
+  // offloaded_nodes maps the nodes whose outputs are offloaded to host memory
+  // to the nodes before whose backward passes they are prefetched
   bool convert_graph_to_operators(
       const PCG::Graph *graph,
-      std::unordered_map<PCG::Node, MachineView> const &optimal_views);
+      std::unordered_map<PCG::Node, MachineView> const &optimal_views,
+      std::unordered_map<PCG::Node, PCG::Node> const &offloaded_nodes = {});
   static void register_all_machine_views(int num_nodes,
                                          int gpus_per_node,
                                          int cpus_per_node,
@@ -737,6 +815,21 @@ public:
       Legion::IndexSpaceT<TDIM> const &part_is,
       Legion::LogicalRegion const &region,
       Legion::LogicalPartition &part);
+  // A disjoint partition of the box of size dims at offsets in region, which
+  // does not need to cover the region
+  void create_window_partition(int num_dims,
+                               const ParallelDim dims[],
+                               int const offsets[],
+                               Legion::IndexSpace const &part_is,
+                               Legion::LogicalRegion const &region,
+                               Legion::LogicalPartition &part);
+  template <int NDIM, int TDIM>
+  void create_window_partition_with_dim2(
+      const ParallelDim dims[],
+      int const offsets[],
+      Legion::IndexSpaceT<TDIM> const &part_is,
+      Legion::LogicalRegion const &region,
+      Legion::LogicalPartition &part);
 
   template <int NDIM>
   void create_disjoint_partition(const ParallelTensor tensor,
@@ -769,7 +862,8 @@ public:
   void forward(int seq_length = -1);
   void compute_metrics();
   void get_metrics();
-  void backward(int seq_length = -1);
+  // with_metrics = false skips the metrics of this batch
+  void backward(int seq_length = -1, bool with_metrics = true);
   void update();
   bool apply_fusion(std::vector<Op *> const &operators,
                     std::vector<Op *> &new_operators);
@@ -781,6 +875,37 @@ public:
                LossType loss_type,
                std::vector<MetricsType> const &metrics,
                CompMode comp_mode = COMP_MODE_TRAINING);
+  /**
+   * @brief Resume training from a model compiled for different resources.
+   * @details Both models must be built with the same layers. To resize, build
+   * the model again, set config.search_num_nodes/search_num_workers to the new
+   * resources, compile it (which re-runs the strategy search), and then
+   * reshard the parameters and optimizer state of the old model into it.
+   */
+  void reshard_from(FFModel const &old_model);
+  /**
+   * @brief Save the parameters and the optimizer state to a file, from which
+   * a model compiled for any resources can resume after a restart.
+   * @details The model must be compiled. Parameters are named by the index
+   * and type of their layer, so the model that loads the checkpoint must be
+   * built with the same layers, like for reshard_from.
+   */
+  void save_checkpoint(std::string const &file_name) const;
+  /**
+   * @brief Load a file written by save_checkpoint into this compiled model.
+   * @return false, after printing the problem, if the file cannot be read or
+   * does not match the layers and optimizer of this model
+   */
+  bool load_checkpoint(std::string const &file_name);
+  /**
+   * @brief Keep the regions of a tensor mapped by compile for as long as it
+   * is used outside the model, e.g. by a data loader.
+   * @details A recompile may drop the tensor from the model; until it is
+   * released, its regions are neither destroyed nor given to the tensors of
+   * later compiles. Calls nest; tensors not mapped by compile are ignored.
+   */
+  void retain_tensor(const ParallelTensor tensor);
+  void release_tensor(const ParallelTensor tensor);
   void graph_optimize(size_t budget,
                       bool only_data_parallel,
                       std::unique_ptr<PCG::Graph> &best_graph,
@@ -823,6 +948,9 @@ public:
   Legion::IndexSpace get_task_is(ParallelConfig const &pc) const;
   Legion::IndexSpace get_task_is(MachineView const &view) const;
   void create_operators_from_layers();
+  void fuse_element_expressions();
+  void fold_pads_into_convolutions();
+  void plan_gradient_overwrites();
   Op *create_operator_from_layer(Layer *layer,
                                  std::vector<ParallelTensor> const &inputs);
   // APIs for setting iteration configs
@@ -852,6 +980,9 @@ public:
   std::vector<Layer *> layers;
   std::vector<Op *> operators;
   std::vector<ParallelTensor> parameters;
+  // Gradients overwritten by their first writer in the backward pass, which
+  // zero_gradients skips
+  std::set<Legion::LogicalRegion> overwritten_grads;
   FFHandler handlers[MAX_NUM_WORKERS];
   Legion::Future current_metrics;
   // Cached operators: key: operator hash, value: operator pointer
@@ -871,6 +1002,12 @@ public:
           Concat *>,
       std::unordered_map<std::pair<ParallelTensorShape, Conv2DParams>,
                          Conv2D *>,
+      std::unordered_map<
+          std::pair<std::vector<ParallelTensorShape>, DotInteractionParams>,
+          DotInteraction *>,
+      std::unordered_map<
+          std::pair<std::vector<ParallelTensorShape>, ElementExpressionParams>,
+          ElementExpression *>,
       std::unordered_map<std::pair<ParallelTensorShape, DropoutParams>,
                          Dropout *>,
       std::unordered_map<
@@ -894,6 +1031,7 @@ public:
                          LayerNorm *>,
       std::unordered_map<std::pair<ParallelTensorShape, LinearParams>,
                          Linear *>,
+      std::unordered_map<std::pair<ParallelTensorShape, PadParams>, Pad *>,
       std::unordered_map<std::pair<ParallelTensorShape, Pool2DParams>,
                          Pool2D *>,
       std::unordered_map<std::pair<std::tuple<ParallelTensorShape,
@@ -905,6 +1043,7 @@ public:
                          Reduce *>,
       std::unordered_map<std::pair<ParallelTensorShape, ReshapeParams>,
                          Reshape *>,
+      std::unordered_map<std::pair<ParallelTensorShape, SliceParams>, Slice *>,
       std::unordered_map<std::pair<ParallelTensorShape, SplitParams>, Split *>,
       std::unordered_map<std::pair<ParallelTensorShape, SoftmaxParams>,
                          Softmax *>,
@@ -931,6 +1070,48 @@ public:
 private:
   bool debug;
   std::map<MachineView, Legion::IndexSpace, MachineViewDimCompare> all_task_is;
+  // Runtime resources of the tensors mapped by compile, reused across
+  // recompiles with the same shapes and partitionings
+  RegionCache<Legion::FieldSpace> field_space_cache;
+  RegionCache<Legion::IndexSpace> index_space_cache;
+  RegionCache<Legion::IndexPartition> partition_cache;
+  RegionCache<Legion::LogicalRegion> region_cache{true /*exclusive*/};
+
+  Legion::FieldSpace get_or_create_field_space(DataType data_type);
+  template <int NDIM>
+  Legion::IndexSpaceT<NDIM>
+      get_or_create_index_space(Legion::Rect<NDIM> const &rect);
+  template <int NDIM, int TDIM>
+  Legion::IndexPartition
+      get_or_create_partition(Legion::IndexSpaceT<NDIM> const &parent,
+                              Legion::IndexSpaceT<TDIM> const &color_space,
+                              Legion::Transform<NDIM, TDIM> const &transform,
+                              Legion::Rect<NDIM> const &extent);
+  Legion::LogicalRegion get_or_create_region(Legion::IndexSpace const &is,
+                                             Legion::FieldSpace const &fs);
+  void begin_region_cache_epoch();
+  void touch_cached_regions(const ParallelTensor tensor);
+  void end_region_cache_epoch();
+  // Regions referenced by the tensors of the last compile, released when the
+  // next compile drops them
+  std::vector<Legion::LogicalRegion> compile_region_refs;
+  // Tensors retained by retain_tensor, with their number of references
+  std::map<ParallelTensor, int> retained_tensors;
+  // Names of the parameters in checkpoints
+  std::map<ParallelTensor, std::string> get_checkpoint_names() const;
+
+  // Saved activations kept in host memory between the forward and backward
+  // passes, see --offload-activations
+  struct ActivationOffload {
+    ParallelTensor tensor;
+    int offload_after;   // index of the operator after whose forward pass
+                         // the tensor is offloaded
+    int prefetch_before; // index of the operator before whose backward
+                         // pass the tensor is prefetched
+  };
+  std::vector<ActivationOffload> activation_offloads;
+  void offload_activation(const ParallelTensor tensor);
+  void prefetch_activation(const ParallelTensor tensor);
 
   template <int NDIM>
   void map_tensor_with_dim(ParallelTensor tensor, Op const *parallel_op);
@@ -0,0 +1,86 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _FLEXFLOW_MODEL_CHECKPOINT_H_
+#define _FLEXFLOW_MODEL_CHECKPOINT_H_
+
+#include "flexflow/ffconst.h"
+#include <cstddef>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace FlexFlow {
+
+/**
+ * @brief Parameters and optimizer state of a model, independent of the
+ * resources and the strategy it was compiled for, so that training can
+ * resume on other resources after a restart.
+ *
+ * @details Every tensor is stored once, as its logical data. A parallel
+ * tensor keeps its replicas one after the other in its region (see
+ * ParallelTensorShape::is_reshardable_to), and partitioning the region does
+ * not change this layout, so any replica holds the whole tensor.
+ *
+ * The binary format starts with the "FFCK" magic and a version, followed by
+ * the tensors (name, data type, sizes of the data dimensions, data) and the
+ * scalars (name, value).
+ */
+struct ModelCheckpoint {
+  static int const VERSION = 1;
+  struct Tensor {
+    DataType data_type;
+    std::vector<int> dims; // Sizes of the data dimensions
+    std::vector<char> data;
+  };
+
+  std::map<std::string, Tensor> tensors;
+  std::map<std::string, double> scalars;
+
+  /**
+   * @brief Store the first replica of a region holding num_replicas copies
+   * of a tensor.
+   */
+  void save_tensor(std::string const &name,
+                   DataType data_type,
+                   std::vector<int> const &dims,
+                   void const *region,
+                   size_t region_bytes,
+                   int num_replicas);
+  /**
+   * @brief Copy a stored tensor into every replica of a region.
+   * @return false, with a description of the problem in error, if the tensor
+   * is missing or does not have the given type and sizes
+   */
+  bool load_tensor(std::string const &name,
+                   DataType data_type,
+                   std::vector<int> const &dims,
+                   void *region,
+                   size_t region_bytes,
+                   int num_replicas,
+                   std::string &error) const;
+
+  void write(std::ostream &os) const;
+  /**
+   * @return false, with a description of the problem in error, if the input
+   * is not a checkpoint of a version up to VERSION
+   */
+  static bool read(std::istream &is, ModelCheckpoint &ckpt, std::string &error);
+};
+
+} // namespace FlexFlow
+
+#endif // _FLEXFLOW_MODEL_CHECKPOINT_H_
@@ -16,6 +16,8 @@ public:
   FFHandler handle;
   bool profiling; // Measure the run time of the task
   bool trainableInputs[MAX_NUM_INPUTS];
+  bool resetInputGrads[MAX_NUM_INPUTS];
+  bool resetWeightGrads;
   DataType input_type[MAX_NUM_INPUTS];
   DataType weight_type[MAX_NUM_WEIGHTS];
   DataType output_type[MAX_NUM_OUTPUTS];
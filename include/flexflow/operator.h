@@ -178,6 +178,7 @@ public:
      int numWeights,
      int numOutputs,
      ParallelTensor const *tensors);
+  virtual ~Op() = default;
   // graph substitution related methods
   virtual bool get_int_parameter(PMParameter, int *) const;
   virtual bool get_tensor_parameter(TNParameter, DIMParameter, int *) const;
@@ -219,6 +220,10 @@ public:
   virtual bool has_inplace_output();
   virtual void do_inplace_output();
   virtual bool is_parallel_op() const;
+  // Whether the backward pass can overwrite the whole gradient of an input
+  // or of the weights, instead of accumulating into it
+  virtual bool can_overwrite_input_grad(int input_idx) const;
+  virtual bool can_overwrite_weight_grads() const;
   virtual void serialize(Legion::Serializer &) const;
   virtual Op *
       materialize(FFModel &ff, ParallelTensor inputs[], int num_inputs) const;
@@ -266,9 +271,18 @@ public:
   ParallelTensor inputs[MAX_NUM_INPUTS];
   ParallelParameter weights[MAX_NUM_WEIGHTS];
   bool trainableInputs[MAX_NUM_INPUTS];
+  // The backward pass is the first writer of these gradients and
+  // overwrites them, see FFModel::plan_gradient_overwrites
+  bool resetInputGrads[MAX_NUM_INPUTS];
+  bool resetWeightGrads;
   OpMeta *meta[MAX_NUM_WORKERS];
   int numInputs, numWeights, numOutputs;
   bool profiling;
+  // Offload the outputs to host memory after the forward pass, and prefetch
+  // them before the backward pass of prefetch_outputs_before, as planned by
+  // the memory search (see plan_activation_offload)
+  bool offload_outputs = false;
+  Op const *prefetch_outputs_before = nullptr;
 #ifdef FF_USE_NCCL
   ncclUniqueId ncclId;
 #endif
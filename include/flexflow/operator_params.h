@@ -8,8 +8,10 @@
 #include "flexflow/ops/cast_params.h"
 #include "flexflow/ops/concat_params.h"
 #include "flexflow/ops/conv_2d_params.h"
+#include "flexflow/ops/dot_interaction_params.h"
 #include "flexflow/ops/dropout_params.h"
 #include "flexflow/ops/element_binary_params.h"
+#include "flexflow/ops/element_expression_params.h"
 #include "flexflow/ops/element_unary_params.h"
 #include "flexflow/ops/embedding_params.h"
 #include "flexflow/ops/flat_params.h"
@@ -17,9 +19,11 @@
 #include "flexflow/ops/groupby_params.h"
 #include "flexflow/ops/layer_norm_params.h"
 #include "flexflow/ops/linear_params.h"
+#include "flexflow/ops/pad_params.h"
 #include "flexflow/ops/pool_2d_params.h"
 #include "flexflow/ops/reduce_params.h"
 #include "flexflow/ops/reshape_params.h"
+#include "flexflow/ops/slice_params.h"
 #include "flexflow/ops/softmax_params.h"
 #include "flexflow/ops/split_params.h"
 #include "flexflow/ops/topk_params.h"
@@ -41,7 +45,9 @@ using OperatorParameters = mp::variant<AggregateParams,
                                        Conv2DParams,
                                        ConcatParams,
                                        CastParams,
+                                       DotInteractionParams,
                                        ElementBinaryParams,
+                                       ElementExpressionParams,
                                        ElementUnaryParams,
                                        DropoutParams,
                                        EmbeddingParams,
@@ -51,9 +57,11 @@ using OperatorParameters = mp::variant<AggregateParams,
                                        LayerNormParams,
                                        LinearParams,
                                        MultiHeadAttentionParams,
+                                       PadParams,
                                        Pool2DParams,
                                        ReduceParams,
                                        ReshapeParams,
+                                       SliceParams,
                                        SplitParams,
                                        TopKParams,
                                        SoftmaxParams,
@@ -8,6 +8,7 @@
 #include "flexflow/op_meta.h"
 #include "flexflow/operator.h"
 #include "flexflow/ops/attention_params.h"
+#include "flexflow/ops/kernels/tiled_attention_kernels.h"
 
 namespace FlexFlow {
 
@@ -120,6 +121,24 @@ public:
                                       float const *weight_ptr,
                                       float *weight_grad_ptr,
                                       float const *output_grad_ptr);
+  static void tiled_forward_kernel(MultiHeadAttentionMeta const *m,
+                                   float const *query_ptr,
+                                   float const *key_ptr,
+                                   float const *value_ptr,
+                                   float const *weight_ptr,
+                                   float *output_ptr,
+                                   ffStream_t stream);
+  static void tiled_backward_kernel(MultiHeadAttentionMeta const *m,
+                                    float const *query_ptr,
+                                    float *query_grad_ptr,
+                                    float const *key_ptr,
+                                    float *key_grad_ptr,
+                                    float const *value_ptr,
+                                    float *value_grad_ptr,
+                                    float const *weight_ptr,
+                                    float *weight_grad_ptr,
+                                    float const *output_grad_ptr,
+                                    ffStream_t stream);
 
   Params get_params() const;
 
@@ -130,6 +149,9 @@ public:
   bool add_bias_kv, add_zero_attn;
   int qSize, kSize, vSize, qProjSize, kProjSize, vProjSize, oProjSize;
   int qoSeqLength, kvSeqLength;
+  // Use the tiled kernels instead of cuDNN; both read the weights as
+  // [num_heads][Wq Wk Wv Wo] but lay out the matrices differently
+  bool tiled;
 };
 
 class MultiHeadAttentionMeta : public OpMeta {
@@ -150,6 +172,10 @@ public:
 #endif
   int *devQoSeqArray, *devKvSeqArray, *loWinIdx, *hiWinIdx;
   void *reserveSpace;
+  // The tiled kernels keep their state for the backward pass, then their
+  // backward scratch, in reserveSpace
+  bool tiled;
+  TiledAttentionShape tiledShape;
 };
 
 }; // namespace FlexFlow
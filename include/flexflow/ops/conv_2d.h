@@ -106,6 +106,8 @@ public:
   bool estimate_sync_cost(Simulator *sim,
                           MachineView const &pc,
                           CostMetrics &cost_metrics) const override;
+  bool can_overwrite_input_grad(int input_idx) const override;
+  bool can_overwrite_weight_grads() const override;
 
   void serialize(Legion::Serializer &s) const override;
   static PCG::Node deserialize(FFModel &ff,
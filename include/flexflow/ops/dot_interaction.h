@@ -0,0 +1,98 @@
+#ifndef _FLEXFLOW_OPS_DOT_INTERACTION_H
+#define _FLEXFLOW_OPS_DOT_INTERACTION_H
+
+#include "flexflow/accessor.h"
+#include "flexflow/device.h"
+#include "flexflow/model.h"
+#include "flexflow/op_meta.h"
+#include "flexflow/ops/dot_interaction_params.h"
+#include "flexflow/ops/kernels/dot_interaction_kernels.h"
+
+namespace FlexFlow {
+
+class DotInteractionMeta;
+
+/**
+ * @brief The dot-product feature interaction of DLRM: the pairwise dots of
+ * the bottom-MLP output and the embeddings, optionally after the bottom-MLP
+ * output. Only the lower triangle of the pairwise matrix is computed.
+ */
+class DotInteraction : public Op {
+public:
+  using Params = DotInteractionParams;
+  using Input = std::vector<ParallelTensor>;
+
+  DotInteraction(FFModel &model,
+                 int n,
+                 ParallelTensor const *inputs,
+                 bool self_interaction,
+                 bool concat_dense,
+                 char const *name);
+  DotInteraction(FFModel &model,
+                 Params const &params,
+                 Input const &inputs,
+                 char const *name = nullptr);
+  void init(FFModel const &) override;
+  void forward(FFModel const &) override;
+  void backward(FFModel const &) override;
+  void print_layer(FFModel const &model) override {
+    assert(0);
+  }
+  static Op *
+      create_operator_from_layer(FFModel &model,
+                                 Layer const *layer,
+                                 std::vector<ParallelTensor> const &inputs);
+  static OpMeta *init_task(Legion::Task const *task,
+                           std::vector<Legion::PhysicalRegion> const &regions,
+                           Legion::Context ctx,
+                           Legion::Runtime *runtime);
+  static void forward_task(Legion::Task const *task,
+                           std::vector<Legion::PhysicalRegion> const &regions,
+                           Legion::Context ctx,
+                           Legion::Runtime *runtime);
+  static void backward_task(Legion::Task const *task,
+                            std::vector<Legion::PhysicalRegion> const &regions,
+                            Legion::Context ctx,
+                            Legion::Runtime *runtime);
+  bool measure_operator_cost(Simulator *sim,
+                             MachineView const &pc,
+                             CostMetrics &cost_metrics) const override;
+  void serialize(Legion::Serializer &s) const override;
+  static PCG::Node deserialize(FFModel &ff,
+                               Legion::Deserializer &d,
+                               ParallelTensor inputs[],
+                               int num_inputs);
+  Op *materialize(FFModel &ff,
+                  ParallelTensor inputs[],
+                  int num_inputs) const override;
+  static void forward_kernel_wrapper(DotInteractionMeta const *m,
+                                     GenericTensorAccessorR const *inputs,
+                                     GenericTensorAccessorW const &output);
+  static void
+      backward_kernel_wrapper(DotInteractionMeta const *m,
+                              GenericTensorAccessorR const *inputs,
+                              GenericTensorAccessorR const &output_grad,
+                              GenericTensorAccessorW const *input_grads);
+  Params get_params() const;
+
+public:
+  bool self_interaction, concat_dense;
+};
+
+class DotInteractionMeta : public OpMeta {
+public:
+  DotInteractionMeta(FFHandler handler, DotInteraction const *op);
+  ~DotInteractionMeta(void);
+
+public:
+  int num_features;
+  bool self_interaction, concat_dense;
+  // Device copies of the per-feature pointers, refreshed at each launch
+  float const **dev_input_ptrs;
+  float **dev_input_grad_ptrs;
+  char op_name[MAX_OPNAME];
+};
+
+}; // namespace FlexFlow
+
+#endif // _FLEXFLOW_OPS_DOT_INTERACTION_H
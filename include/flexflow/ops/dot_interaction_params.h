@@ -0,0 +1,25 @@
+#ifndef _FLEXFLOW_DOT_INTERACTION_PARAMS_H
+#define _FLEXFLOW_DOT_INTERACTION_PARAMS_H
+
+#include "flexflow/parallel_tensor.h"
+
+namespace FlexFlow {
+
+struct DotInteractionParams {
+  bool self_interaction, concat_dense;
+
+  bool is_valid(std::vector<ParallelTensorShape> const &) const;
+};
+
+bool operator==(DotInteractionParams const &, DotInteractionParams const &);
+
+} // namespace FlexFlow
+
+namespace std {
+template <>
+struct hash<FlexFlow::DotInteractionParams> {
+  size_t operator()(FlexFlow::DotInteractionParams const &) const;
+};
+} // namespace std
+
+#endif // _FLEXFLOW_DOT_INTERACTION_PARAMS_H
@@ -0,0 +1,115 @@
+#ifndef _FLEXFLOW_OPS_ELEMENT_EXPRESSION_H
+#define _FLEXFLOW_OPS_ELEMENT_EXPRESSION_H
+
+#include "flexflow/accessor.h"
+#include "flexflow/device.h"
+#include "flexflow/model.h"
+#include "flexflow/op_meta.h"
+#include "flexflow/ops/element_expression_params.h"
+#include "flexflow/ops/kernels/element_expression_kernels.h"
+
+namespace FlexFlow {
+
+class ElementExpressionMeta;
+
+/**
+ * @brief A DAG of element-wise unary and binary operations, with
+ * broadcasting, computed in a single pass over the output. The backward pass
+ * recomputes the intermediate results instead of storing them.
+ */
+class ElementExpression : public Op {
+public:
+  using Params = ElementExpressionParams;
+  using Input = std::vector<ParallelTensor>;
+
+  ElementExpression(FFModel &model,
+                    ExpressionProgram const &program,
+                    int n,
+                    ParallelTensor const *inputs,
+                    char const *name);
+  ElementExpression(FFModel &model,
+                    Params const &params,
+                    Input const &inputs,
+                    char const *name = nullptr);
+  void init(FFModel const &) override;
+  void forward(FFModel const &) override;
+  void backward(FFModel const &) override;
+  void print_layer(FFModel const &model) override {
+    assert(0);
+  }
+  static Op *
+      create_operator_from_layer(FFModel &model,
+                                 Layer const *layer,
+                                 std::vector<ParallelTensor> const &inputs);
+  /**
+   * @brief Whether a layer can be part of an expression.
+   */
+  static bool can_fuse(Layer const *layer);
+  /**
+   * @brief The expression computing the output of the last of the layers.
+   * @param layers fusible layers in topological order
+   * @param inputs the tensors read by the layers that none of them computes
+   * @return false when the expression has too many inputs or nodes
+   */
+  static bool build_program(std::vector<Layer *> const &layers,
+                            ExpressionProgram &program,
+                            std::vector<Tensor> &inputs);
+  /**
+   * @brief An expression layer, without its output tensor.
+   */
+  static Layer *create_layer(FFModel &model,
+                             std::vector<Tensor> const &inputs,
+                             ExpressionProgram const &program,
+                             char const *name);
+  static OpMeta *init_task(Legion::Task const *task,
+                           std::vector<Legion::PhysicalRegion> const &regions,
+                           Legion::Context ctx,
+                           Legion::Runtime *runtime);
+  static void forward_task(Legion::Task const *task,
+                           std::vector<Legion::PhysicalRegion> const &regions,
+                           Legion::Context ctx,
+                           Legion::Runtime *runtime);
+  static void backward_task(Legion::Task const *task,
+                            std::vector<Legion::PhysicalRegion> const &regions,
+                            Legion::Context ctx,
+                            Legion::Runtime *runtime);
+  bool measure_operator_cost(Simulator *sim,
+                             MachineView const &pc,
+                             CostMetrics &cost_metrics) const override;
+  void serialize(Legion::Serializer &s) const override;
+  static PCG::Node deserialize(FFModel &ff,
+                               Legion::Deserializer &d,
+                               ParallelTensor inputs[],
+                               int num_inputs);
+  Op *materialize(FFModel &ff,
+                  ParallelTensor inputs[],
+                  int num_inputs) const override;
+  static ExpressionShape get_shape(Legion::Domain const &output,
+                                   GenericTensorAccessorR const *inputs,
+                                   int num_inputs);
+  static void forward_kernel_wrapper(ElementExpressionMeta const *m,
+                                     GenericTensorAccessorR const *inputs,
+                                     GenericTensorAccessorW const &output);
+  static void
+      backward_kernel_wrapper(ElementExpressionMeta const *m,
+                              GenericTensorAccessorR const *inputs,
+                              GenericTensorAccessorR const &output_grad,
+                              GenericTensorAccessorW const *input_grads);
+  Params get_params() const;
+
+public:
+  ExpressionProgram program;
+};
+
+class ElementExpressionMeta : public OpMeta {
+public:
+  ElementExpressionMeta(FFHandler handler, ElementExpression const *op);
+
+public:
+  ExpressionProgram program;
+  char op_name[MAX_OPNAME];
+};
+
+}; // namespace FlexFlow
+
+#endif // _FLEXFLOW_OPS_ELEMENT_EXPRESSION_H
@@ -0,0 +1,27 @@
+#ifndef _FLEXFLOW_ELEMENT_EXPRESSION_PARAMS_H
+#define _FLEXFLOW_ELEMENT_EXPRESSION_PARAMS_H
+
+#include "flexflow/ops/kernels/element_expression_kernels.h"
+#include "flexflow/parallel_tensor.h"
+
+namespace FlexFlow {
+
+struct ElementExpressionParams {
+  ExpressionProgram program;
+
+  bool is_valid(std::vector<ParallelTensorShape> const &) const;
+};
+
+bool operator==(ElementExpressionParams const &,
+                ElementExpressionParams const &);
+
+} // namespace FlexFlow
+
+namespace std {
+template <>
+struct hash<FlexFlow::ElementExpressionParams> {
+  size_t operator()(FlexFlow::ElementExpressionParams const &) const;
+};
+} // namespace std
+
+#endif // _FLEXFLOW_ELEMENT_EXPRESSION_PARAMS_H
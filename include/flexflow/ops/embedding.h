@@ -9,6 +9,7 @@
 #include "flexflow/op_meta.h"
 #include "flexflow/operator.h"
 #include "flexflow/ops/embedding_params.h"
+#include "flexflow/ops/kernels/embedding_mode_kernels.h"
 
 namespace FlexFlow {
 
@@ -38,7 +39,10 @@ public:
             AggrMode _aggr,
             bool allocate_weights,
             DataType _dtype,
-            char const *name);
+            char const *name,
+            EmbeddingMode _mode = EMBEDDING_MODE_DENSE,
+            int _num_buckets = 0,
+            int _embed_dim = 0);
   Embedding(FFModel &model,
             Embedding const &other,
             const ParallelTensor input,
@@ -91,6 +95,7 @@ public:
                              CostMetrics &cost_metrics) const override;
 
   Params get_params() const;
+  EmbeddingTables get_tables() const;
 
 private:
 #ifdef DEADCODE
@@ -112,7 +117,7 @@ private:
   int output_vocab_size_replica_dim() const;
 
   int output_size(ParallelDim output_dims[MAX_TENSOR_DIM]);
-  int weight_size(ParallelDim weights_dims[MAX_TENSOR_DIM]);
+  int weight_size(int index, ParallelDim weights_dims[MAX_TENSOR_DIM]);
 
   void register_mappings();
   void register_output_mappings();
@@ -121,6 +126,10 @@ private:
 public:
   int num_entries, out_channels;
   AggrMode aggr;
+  EmbeddingMode mode;
+  // Rows of the remainder table (EMBEDDING_MODE_QR) and width of the table
+  // (EMBEDDING_MODE_MIXED_DIM)
+  int num_buckets, embed_dim;
 };
 
 }; // namespace FlexFlow
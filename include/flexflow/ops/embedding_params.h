@@ -12,6 +12,8 @@ struct EmbeddingParams {
   LayerID layer_guid;
   AggrMode aggr;
   DataType data_type;
+  EmbeddingMode mode = EMBEDDING_MODE_DENSE;
+  int num_buckets = 0, embed_dim = 0;
 
   bool is_valid(ParallelTensorShape const &) const;
 };
@@ -24,6 +24,22 @@ public:
   };
   FusedOp(FFModel &model, Op *op);
   bool add_operator(FFModel &model, Op *op);
+  /**
+   * @brief Whether op can run inside the task of a fused op. Inputs, weights
+   * and no-ops launch no kernels, parallel ops use different parallel_is in
+   * the forward and backward passes, slices read a window partition of their
+   * input, and fused ops are not nested.
+   */
+  static bool can_fuse(Op const *op);
+  /**
+   * @brief Whether a fused op of num_operators operators, with the given
+   * numbers of inputs, weights and outputs summed over its operators, fits
+   * MAX_NUM_FUSED_OPERATORS and MAX_NUM_FUSED_TENSORS.
+   */
+  static bool within_limits(int num_operators,
+                            int num_inputs,
+                            int num_weights,
+                            int num_outputs);
   ParallelTensor init_inout(FFModel &model, const ParallelTensor input) {
     assert(0);
     return ParallelTensor();
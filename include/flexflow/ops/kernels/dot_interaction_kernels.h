@@ -0,0 +1,61 @@
+#ifndef _FLEXFLOW_OPS_KERNELS_DOT_INTERACTION_KERNELS_H
+#define _FLEXFLOW_OPS_KERNELS_DOT_INTERACTION_KERNELS_H
+
+#include <cstddef>
+
+namespace FlexFlow {
+
+/**
+ * @brief Sizes of a DLRM dot-product feature interaction.
+ *
+ * @details The inputs are num_features tensors of [num_samples][feature_size]
+ * (the bottom-MLP output first, then the embeddings). Each output row holds
+ * the first input if concat_dense is set, followed by the dots of the pairs
+ * (i, j) with j < i (j <= i with self_interaction), in the order of DLRM:
+ * pair (i, j) is at pair_index(i, j).
+ */
+struct DotInteractionShape {
+  int num_samples, num_features, feature_size;
+  bool self_interaction = false, concat_dense = true;
+
+  int num_pairs() const {
+    return self_interaction ? num_features * (num_features + 1) / 2
+                            : num_features * (num_features - 1) / 2;
+  }
+  int output_size() const {
+    return (concat_dense ? feature_size : 0) + num_pairs();
+  }
+  /**
+   * @brief Position of the pair (i, j), j < i (or j <= i), among the pairs.
+   */
+  int pair_index(int i, int j) const {
+    return (self_interaction ? i * (i + 1) / 2 : i * (i - 1) / 2) + j;
+  }
+};
+
+namespace Kernels {
+namespace DotInteraction {
+
+/**
+ * @brief Interaction forward pass on the CPU.
+ * @param inputs num_features pointers to [num_samples][feature_size]
+ * @param output [num_samples][output_size()]
+ */
+void forward_cpu(DotInteractionShape const &shape,
+                 float const *const *inputs,
+                 float *output);
+
+/**
+ * @brief Interaction backward pass on the CPU. The gradients are accumulated
+ * into input_grads.
+ */
+void backward_cpu(DotInteractionShape const &shape,
+                  float const *const *inputs,
+                  float const *output_grad,
+                  float *const *input_grads);
+
+} // namespace DotInteraction
+} // namespace Kernels
+} // namespace FlexFlow
+
+#endif // _FLEXFLOW_OPS_KERNELS_DOT_INTERACTION_KERNELS_H
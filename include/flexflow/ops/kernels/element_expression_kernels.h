@@ -0,0 +1,247 @@
+#ifndef _FLEXFLOW_OPS_KERNELS_ELEMENT_EXPRESSION_KERNELS_H
+#define _FLEXFLOW_OPS_KERNELS_ELEMENT_EXPRESSION_KERNELS_H
+
+#include "flexflow/ffconst.h"
+#include <cmath>
+#include <cstddef>
+
+#if defined(__CUDACC__) || defined(__HIPCC__)
+#define FF_EXPRESSION_FUNC __host__ __device__ inline
+#else
+#define FF_EXPRESSION_FUNC inline
+#endif
+
+#define MAX_EXPRESSION_INPUTS 8
+#define MAX_EXPRESSION_NODES 16
+
+namespace FlexFlow {
+
+/**
+ * @brief One element-wise operation of an expression. The operands are
+ * numbered with the inputs first: operand i < num_inputs is input i, and
+ * operand num_inputs + j is the result of node j.
+ */
+struct ExpressionNode {
+  OperatorType op_type;
+  int lhs, rhs; // rhs is -1 for unary operations
+  float scalar; // for the OP_SCALAR_* operations and OP_POW
+};
+
+/**
+ * @brief A DAG of element-wise operations evaluated in a single pass over
+ * the output. The nodes are in topological order and the last one is the
+ * output of the expression.
+ */
+struct ExpressionProgram {
+  int num_inputs = 0, num_nodes = 0;
+  ExpressionNode nodes[MAX_EXPRESSION_NODES];
+
+  static bool is_unary(OperatorType op_type);
+  static bool is_binary(OperatorType op_type);
+  FF_EXPRESSION_FUNC int num_operands() const {
+    return num_inputs + num_nodes;
+  }
+  FF_EXPRESSION_FUNC int output() const {
+    return num_operands() - 1;
+  }
+  /**
+   * @brief Append a node and return its operand.
+   */
+  int add_unary(OperatorType op_type, int x, float scalar = 0.0f);
+  int add_binary(OperatorType op_type, int lhs, int rhs);
+};
+
+/**
+ * @brief Sizes of the output and the inputs of an expression, innermost
+ * dimension first. An input broadcasts along the dimensions where it has
+ * size 1 and the output does not.
+ */
+struct ExpressionShape {
+  int num_dims = 0;
+  int dims[MAX_TENSOR_DIM];
+  int input_dims[MAX_EXPRESSION_INPUTS][MAX_TENSOR_DIM];
+
+  FF_EXPRESSION_FUNC size_t volume() const {
+    size_t v = 1;
+    for (int d = 0; d < num_dims; d++) {
+      v *= dims[d];
+    }
+    return v;
+  }
+  FF_EXPRESSION_FUNC size_t input_volume(int i) const {
+    size_t v = 1;
+    for (int d = 0; d < num_dims; d++) {
+      v *= input_dims[i][d];
+    }
+    return v;
+  }
+  /**
+   * @brief Offset in input i of the element at output offset idx.
+   */
+  FF_EXPRESSION_FUNC size_t input_offset(int i, size_t idx) const {
+    size_t offset = 0, stride = 1;
+    for (int d = 0; d < num_dims; d++) {
+      size_t coord = idx % dims[d];
+      idx /= dims[d];
+      if (input_dims[i][d] > 1) {
+        offset += coord * stride;
+      }
+      stride *= input_dims[i][d];
+    }
+    return offset;
+  }
+};
+
+namespace Kernels {
+namespace ElementExpression {
+
+FF_EXPRESSION_FUNC float apply_unary(OperatorType op_type, float s, float x) {
+  switch (op_type) {
+    case OP_EXP:
+      return expf(x);
+    case OP_IDENTITY:
+      return x;
+    case OP_SCALAR_MULTIPLY:
+      return x * s;
+    case OP_SCALAR_ADD:
+      return x + s;
+    case OP_SCALAR_SUB:
+      return x - s;
+    case OP_SCALAR_TRUE_DIV:
+      return x / s;
+    case OP_GELU:
+      return 0.5f * x * erfcf(-x * (float)M_SQRT1_2);
+    case OP_RSQRT:
+      return 1.0f / sqrtf(x);
+    case OP_POW:
+      return powf(x, s);
+    case OP_SIN:
+      return sinf(x);
+    case OP_COS:
+      return cosf(x);
+    case OP_RELU:
+      return x > 0.0f ? x : 0.0f;
+    case OP_SIGMOID:
+      return 1.0f / (1.0f + expf(-x));
+    case OP_TANH:
+      return tanhf(x);
+    default:
+      return 0.0f;
+  }
+}
+
+/**
+ * @brief Derivative of a unary operation at x, where y is its result.
+ */
+FF_EXPRESSION_FUNC float
+    unary_derivative(OperatorType op_type, float s, float x, float y) {
+  switch (op_type) {
+    case OP_EXP:
+      return y;
+    case OP_IDENTITY:
+    case OP_SCALAR_ADD:
+    case OP_SCALAR_SUB:
+      return 1.0f;
+    case OP_SCALAR_MULTIPLY:
+      return s;
+    case OP_SCALAR_TRUE_DIV:
+      return 1.0f / s;
+    case OP_GELU:
+      return 0.5f * erfcf(-x * (float)M_SQRT1_2) +
+             x * expf(-0.5f * x * x) * (float)(0.5 * M_2_SQRTPI * M_SQRT1_2);
+    case OP_RSQRT:
+      return -0.5f * y * y * y;
+    case OP_POW:
+      return s * powf(x, s - 1.0f);
+    case OP_SIN:
+      return cosf(x);
+    case OP_COS:
+      return -sinf(x);
+    case OP_RELU:
+      return x > 0.0f ? 1.0f : 0.0f;
+    case OP_SIGMOID:
+      return y * (1.0f - y);
+    case OP_TANH:
+      return 1.0f - y * y;
+    default:
+      return 0.0f;
+  }
+}
+
+FF_EXPRESSION_FUNC float apply_binary(OperatorType op_type, float a, float b) {
+  switch (op_type) {
+    case OP_EW_ADD:
+      return a + b;
+    case OP_EW_SUB:
+      return a - b;
+    case OP_EW_MUL:
+      return a * b;
+    case OP_EW_DIV:
+      return a / b;
+    case OP_EW_MAX:
+      return a >= b ? a : b;
+    case OP_EW_MIN:
+      return a <= b ? a : b;
+    default:
+      return 0.0f;
+  }
+}
+
+/**
+ * @brief Partial derivatives of a binary operation at (a, b).
+ */
+FF_EXPRESSION_FUNC void binary_derivatives(
+    OperatorType op_type, float a, float b, float &da, float &db) {
+  switch (op_type) {
+    case OP_EW_ADD:
+      da = 1.0f, db = 1.0f;
+      break;
+    case OP_EW_SUB:
+      da = 1.0f, db = -1.0f;
+      break;
+    case OP_EW_MUL:
+      da = b, db = a;
+      break;
+    case OP_EW_DIV:
+      da = 1.0f / b, db = -a / (b * b);
+      break;
+    case OP_EW_MAX:
+      da = a >= b ? 1.0f : 0.0f, db = 1.0f - da;
+      break;
+    case OP_EW_MIN:
+      da = a <= b ? 1.0f : 0.0f, db = 1.0f - da;
+      break;
+    default:
+      da = 0.0f, db = 0.0f;
+  }
+}
+
+/**
+ * @brief Expression forward pass on the CPU. The output is computed in
+ * chunks that fit in the cache, one operation at a time over each chunk, so
+ * that the inputs and the output are only read and written once.
+ * @param inputs program.num_inputs pointers to tensors of
+ * shape.input_dims[i]
+ * @param output a tensor of shape.dims
+ */
+void forward_cpu(ExpressionProgram const &program,
+                 ExpressionShape const &shape,
+                 float const *const *inputs,
+                 float *output);
+
+/**
+ * @brief Expression backward pass on the CPU. The intermediate results are
+ * recomputed from the inputs, and the gradients are accumulated into
+ * input_grads, summed over the broadcast dimensions.
+ */
+void backward_cpu(ExpressionProgram const &program,
+                  ExpressionShape const &shape,
+                  float const *const *inputs,
+                  float const *output_grad,
+                  float *const *input_grads);
+
+} // namespace ElementExpression
+} // namespace Kernels
+} // namespace FlexFlow
+
+#endif // _FLEXFLOW_OPS_KERNELS_ELEMENT_EXPRESSION_KERNELS_H
@@ -5,6 +5,7 @@
 #include "flexflow/device.h"
 #include "flexflow/fftype.h"
 #include "flexflow/op_meta.h"
+#include "flexflow/ops/kernels/embedding_mode_kernels.h"
 
 namespace FlexFlow {
 
@@ -13,6 +14,7 @@ public:
   EmbeddingMeta(FFHandler handle, Op const *op);
   DataType input_data_type;
   AggrMode aggr;
+  EmbeddingTables tables;
 };
 
 namespace Kernels {
@@ -31,6 +33,46 @@ void backward_kernel_wrapper(EmbeddingMeta const *m,
                              int in_dim,
                              int out_dim,
                              int batch_size);
+// EMBEDDING_MODE_QR, float tables only
+void qr_forward_kernel_wrapper(EmbeddingMeta const *m,
+                               GenericTensorAccessorR const &input,
+                               GenericTensorAccessorW const &output,
+                               GenericTensorAccessorR const &quotient,
+                               GenericTensorAccessorR const &remainder,
+                               int in_dim,
+                               int out_dim,
+                               int batch_size);
+void qr_backward_kernel_wrapper(EmbeddingMeta const *m,
+                                GenericTensorAccessorR const &input,
+                                GenericTensorAccessorR const &output,
+                                GenericTensorAccessorR const &quotient,
+                                GenericTensorAccessorR const &remainder,
+                                GenericTensorAccessorW const &quotient_grad,
+                                GenericTensorAccessorW const &remainder_grad,
+                                int in_dim,
+                                int out_dim,
+                                int batch_size);
+// EMBEDDING_MODE_MIXED_DIM, float tables only. The aggregated rows are kept
+// in the handle's workspace and recomputed by the backward pass
+void mixed_dim_forward_kernel_wrapper(EmbeddingMeta const *m,
+                                      GenericTensorAccessorR const &input,
+                                      GenericTensorAccessorW const &output,
+                                      GenericTensorAccessorR const &table,
+                                      GenericTensorAccessorR const &projection,
+                                      int in_dim,
+                                      int out_dim,
+                                      int batch_size);
+void mixed_dim_backward_kernel_wrapper(
+    EmbeddingMeta const *m,
+    GenericTensorAccessorR const &input,
+    GenericTensorAccessorR const &output,
+    GenericTensorAccessorR const &table,
+    GenericTensorAccessorR const &projection,
+    GenericTensorAccessorW const &table_grad,
+    GenericTensorAccessorW const &projection_grad,
+    int in_dim,
+    int out_dim,
+    int batch_size);
 
 void rand_generate_int64_wrapper(int64_t *ptr, size_t size, int64_t p);
 void rand_generate_int32_wrapper(int32_t *ptr, size_t size, int32_t p);
@@ -57,6 +99,54 @@ void backward_kernel(TI const *input_ptr,
                      AggrMode aggr,
                      int outputSize,
                      ffStream_t stream);
+template <typename TI>
+void qr_forward_kernel(TI const *input_ptr,
+                       float *output_ptr,
+                       float const *quotient_ptr,
+                       float const *remainder_ptr,
+                       int in_dim,
+                       int out_dim,
+                       int batch_size,
+                       int num_buckets,
+                       AggrMode aggr,
+                       ffStream_t stream);
+template <typename TI>
+void qr_backward_kernel(TI const *input_ptr,
+                        float const *output_ptr,
+                        float const *quotient_ptr,
+                        float const *remainder_ptr,
+                        float *quotient_grad_ptr,
+                        float *remainder_grad_ptr,
+                        int in_dim,
+                        int out_dim,
+                        int batch_size,
+                        int num_buckets,
+                        AggrMode aggr,
+                        ffStream_t stream);
+// output = aggr(table rows) x projection, with the aggregated rows kept in
+// the handle's workspace
+template <typename TI>
+void mixed_dim_forward_kernel(EmbeddingMeta const *m,
+                              TI const *input_ptr,
+                              float *output_ptr,
+                              float const *table_ptr,
+                              float const *projection_ptr,
+                              int in_dim,
+                              int out_dim,
+                              int batch_size,
+                              ffStream_t stream);
+template <typename TI>
+void mixed_dim_backward_kernel(EmbeddingMeta const *m,
+                               TI const *input_ptr,
+                               float const *output_ptr,
+                               float const *table_ptr,
+                               float const *projection_ptr,
+                               float *table_grad_ptr,
+                               float *projection_grad_ptr,
+                               int in_dim,
+                               int out_dim,
+                               int batch_size,
+                               ffStream_t stream);
 template <typename TD>
 __global__ void rand_generate_int(TD *ptr, size_t size, TD p);
 } // namespace Internal
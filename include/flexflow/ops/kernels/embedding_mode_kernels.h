@@ -0,0 +1,90 @@
+#ifndef _FLEXFLOW_OPS_KERNELS_EMBEDDING_MODE_KERNELS_H
+#define _FLEXFLOW_OPS_KERNELS_EMBEDDING_MODE_KERNELS_H
+
+#include "flexflow/ffconst.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace FlexFlow {
+
+/**
+ * @brief The tables behind an embedding of num_entries rows of out_dim.
+ *
+ * @details EMBEDDING_MODE_DENSE stores one [num_entries][out_dim] table.
+ * EMBEDDING_MODE_QR stores a quotient table of [quotient_rows()][out_dim] and
+ * a remainder table of [num_buckets][out_dim]; row i of the embedding is the
+ * elementwise product of quotient row i / num_buckets and remainder row
+ * i % num_buckets. EMBEDDING_MODE_MIXED_DIM stores a [num_entries][embed_dim]
+ * table and a [embed_dim][out_dim] projection applied after aggregation.
+ */
+struct EmbeddingTables {
+  EmbeddingMode mode;
+  int num_entries, out_dim, num_buckets, embed_dim;
+
+  int quotient_rows() const {
+    return (num_entries + num_buckets - 1) / num_buckets;
+  }
+  int num_tables() const {
+    return mode == EMBEDDING_MODE_DENSE ? 1 : 2;
+  }
+  /**
+   * @brief Rows and columns of table i, row-major.
+   */
+  int rows(int i) const {
+    switch (mode) {
+      case EMBEDDING_MODE_QR:
+        return i == 0 ? quotient_rows() : num_buckets;
+      case EMBEDDING_MODE_MIXED_DIM:
+        return i == 0 ? num_entries : embed_dim;
+      default:
+        return num_entries;
+    }
+  }
+  int cols(int i) const {
+    return (mode == EMBEDDING_MODE_MIXED_DIM && i == 0) ? embed_dim : out_dim;
+  }
+  size_t num_parameters() const {
+    size_t total = 0;
+    for (int i = 0; i < num_tables(); i++) {
+      total += (size_t)rows(i) * cols(i);
+    }
+    return total;
+  }
+};
+
+namespace Kernels {
+namespace Embedding {
+
+/**
+ * @brief Embedding forward pass on the CPU for any mode.
+ * @param input [batch_size][in_dim] indices, in_dim is 1 for AGGR_MODE_NONE
+ * @param weights num_tables() pointers to the tables
+ * @param output [batch_size][out_dim]
+ */
+void forward_cpu(EmbeddingTables const &tables,
+                 AggrMode aggr,
+                 int64_t const *input,
+                 float const *const *weights,
+                 float *output,
+                 int in_dim,
+                 int batch_size);
+
+/**
+ * @brief Embedding backward pass on the CPU for any mode. The gradients are
+ * accumulated into weight_grads; the weights are only read by the QR and
+ * mixed-dimension modes.
+ */
+void backward_cpu(EmbeddingTables const &tables,
+                  AggrMode aggr,
+                  int64_t const *input,
+                  float const *const *weights,
+                  float const *output_grad,
+                  float *const *weight_grads,
+                  int in_dim,
+                  int batch_size);
+
+} // namespace Embedding
+} // namespace Kernels
+} // namespace FlexFlow
+
+#endif // _FLEXFLOW_OPS_KERNELS_EMBEDDING_MODE_KERNELS_H
@@ -0,0 +1,35 @@
+#ifndef _FLEXFLOW_OPS_KERNELS_PAD_KERNELS_H
+#define _FLEXFLOW_OPS_KERNELS_PAD_KERNELS_H
+
+#include "flexflow/ops/kernels/slice_kernels.h"
+
+namespace FlexFlow {
+namespace Kernels {
+namespace Pad {
+
+/**
+ * @brief Pad forward pass on the CPU. The dense output of output_volume
+ * elements is filled with value, and the dense input is copied into the
+ * window of the output starting at output + origin.
+ */
+void forward_cpu(TensorWindow const &window,
+                 size_t origin,
+                 float value,
+                 float const *input,
+                 float *output,
+                 size_t output_volume);
+
+/**
+ * @brief Pad backward pass on the CPU: accumulates the window of the output
+ * gradient starting at output_grad + origin into the dense input_grad.
+ */
+void backward_cpu(TensorWindow const &window,
+                  size_t origin,
+                  float const *output_grad,
+                  float *input_grad);
+
+} // namespace Pad
+} // namespace Kernels
+} // namespace FlexFlow
+
+#endif // _FLEXFLOW_OPS_KERNELS_PAD_KERNELS_H
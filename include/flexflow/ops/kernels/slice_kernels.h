@@ -0,0 +1,85 @@
+#ifndef _FLEXFLOW_OPS_KERNELS_SLICE_KERNELS_H
+#define _FLEXFLOW_OPS_KERNELS_SLICE_KERNELS_H
+
+#include <cstddef>
+
+#if defined(__CUDACC__) || defined(__HIPCC__)
+#define FF_WINDOW_FUNC __host__ __device__ inline
+#else
+#define FF_WINDOW_FUNC inline
+#endif
+
+namespace FlexFlow {
+
+/**
+ * @brief A box of elements inside a larger tensor: the output of a slice in
+ * its input, or the input of a pad in its output. Sizes and strides are in
+ * elements, innermost dimension first; the strides are those of the
+ * enclosing tensor, so the elements of the box are not contiguous in
+ * general.
+ */
+struct TensorWindow {
+  int num_dims = 0;
+  int dims[MAX_TENSOR_DIM];
+  size_t strides[MAX_TENSOR_DIM];
+
+  /**
+   * @brief The window of size window_dims at offsets in a dense tensor of
+   * size enclosing_dims. Returns the offset of its first element.
+   */
+  size_t set_dense(int ndims,
+                   int const *enclosing_dims,
+                   int const *offsets,
+                   int const *window_dims);
+  FF_WINDOW_FUNC size_t volume() const {
+    size_t v = 1;
+    for (int d = 0; d < num_dims; d++) {
+      v *= dims[d];
+    }
+    return v;
+  }
+  /**
+   * @brief Offset, from the first element of the window, of the element at
+   * position idx of the window in the innermost-first order.
+   */
+  FF_WINDOW_FUNC size_t offset(size_t idx) const {
+    size_t offset = 0;
+    for (int d = 0; d < num_dims; d++) {
+      offset += (idx % dims[d]) * strides[d];
+      idx /= dims[d];
+    }
+    return offset;
+  }
+  /**
+   * @brief Number of elements of the contiguous runs of the window, which
+   * spans the innermost dimensions the window covers entirely.
+   */
+  size_t run_length() const;
+  bool is_contiguous() const {
+    return run_length() == volume();
+  }
+};
+
+namespace Kernels {
+namespace Slice {
+
+/**
+ * @brief Slice forward pass on the CPU: copies the window starting at input
+ * to the dense output. A contiguous window is a single copy.
+ */
+void forward_cpu(TensorWindow const &window, float const *input, float *output);
+
+/**
+ * @brief Slice backward pass on the CPU: accumulates the dense output_grad
+ * into the window starting at input_grad. The rest of the input gradient is
+ * left unchanged.
+ */
+void backward_cpu(TensorWindow const &window,
+                  float const *output_grad,
+                  float *input_grad);
+
+} // namespace Slice
+} // namespace Kernels
+} // namespace FlexFlow
+
+#endif // _FLEXFLOW_OPS_KERNELS_SLICE_KERNELS_H
@@ -0,0 +1,104 @@
+#ifndef _FLEXFLOW_OPS_KERNELS_TILED_ATTENTION_KERNELS_H
+#define _FLEXFLOW_OPS_KERNELS_TILED_ATTENTION_KERNELS_H
+
+#include <cstddef>
+
+namespace FlexFlow {
+
+/**
+ * @brief Sizes of a multi-head attention computed by the tiled kernels.
+ *
+ * @details The tiled kernels never materialize the qo_seq_length x
+ * kv_seq_length score matrix: the scores of a tile of queries against a
+ * tile of keys are folded into a running (online) softmax, and only the
+ * log-sum-exp of each query row is kept for the backward pass, which
+ * recomputes the scores tile by tile.
+ *
+ * Tensors are row-major with the feature dimension innermost: query is
+ * [num_samples][qo_seq_length][q_size] and output is
+ * [num_samples][qo_seq_length][o_proj_size]. The weights of a head are
+ * contiguous, Wq [q_proj_size][q_size], Wk [k_proj_size][k_size],
+ * Wv [v_proj_size][v_size] then Wo [o_proj_size][v_proj_size], which has
+ * the size of the cuDNN weights of the same attention. Projections have no
+ * bias, like the cuDNN path.
+ */
+struct TiledAttentionShape {
+  int num_samples, num_heads;
+  int qo_seq_length, kv_seq_length;
+  int q_size, k_size, v_size;
+  int q_proj_size, k_proj_size, v_proj_size, o_proj_size;
+  float scale = 1.0f; ///< Factor on the scores before the softmax
+  int tile_size = 64;
+
+  size_t wq_offset() const {
+    return 0;
+  }
+  size_t wk_offset() const {
+    return wq_offset() + (size_t)q_proj_size * q_size;
+  }
+  size_t wv_offset() const {
+    return wk_offset() + (size_t)k_proj_size * k_size;
+  }
+  size_t wo_offset() const {
+    return wv_offset() + (size_t)v_proj_size * v_size;
+  }
+  size_t weights_per_head() const {
+    return wo_offset() + (size_t)o_proj_size * v_proj_size;
+  }
+  /**
+   * @brief Floats of the projected queries, keys and values, the per-head
+   * outputs and the log-sum-exp of each row, kept from the forward to the
+   * backward pass by the GPU kernels.
+   */
+  size_t saved_state_size() const;
+  /**
+   * @brief Floats of the gradients of the projections, the scratch of the
+   * backward pass of the GPU kernels.
+   */
+  size_t backward_scratch_size() const;
+  /**
+   * @brief Floats of the score matrices an untiled attention keeps for the
+   * backward pass.
+   */
+  size_t score_matrix_size() const;
+};
+
+namespace Kernels {
+namespace TiledAttention {
+
+/**
+ * @brief Attention forward pass on the CPU.
+ * @param logsumexp [num_samples][num_heads][qo_seq_length] log-sum-exp of
+ * the scores of each query, for backward_cpu; may be NULL
+ */
+void forward_cpu(TiledAttentionShape const &shape,
+                 float const *query,
+                 float const *key,
+                 float const *value,
+                 float const *weight,
+                 float *output,
+                 float *logsumexp);
+
+/**
+ * @brief Attention backward pass on the CPU. The gradients are accumulated
+ * into query_grad, key_grad, value_grad and weight_grad, which may alias
+ * each other when the inputs do (e.g. in self-attention).
+ * @param logsumexp As computed by forward_cpu
+ */
+void backward_cpu(TiledAttentionShape const &shape,
+                  float const *query,
+                  float const *key,
+                  float const *value,
+                  float const *weight,
+                  float const *output_grad,
+                  float const *logsumexp,
+                  float *query_grad,
+                  float *key_grad,
+                  float *value_grad,
+                  float *weight_grad);
+
+} // namespace TiledAttention
+} // namespace Kernels
+} // namespace FlexFlow
+
+#endif // _FLEXFLOW_OPS_KERNELS_TILED_ATTENTION_KERNELS_H
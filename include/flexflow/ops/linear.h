@@ -64,6 +64,8 @@ public:
   ParallelConfig get_random_parallel_config(FFModel const &ff) const override;
   bool is_valid_parallel_config(FFModel const &ff,
                                 ParallelConfig const &pc) const override;
+  bool can_overwrite_input_grad(int input_idx) const override;
+  bool can_overwrite_weight_grads() const override;
 
   void serialize(Legion::Serializer &) const override;
   static PCG::Node deserialize(FFModel &ff,
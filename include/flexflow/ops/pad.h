@@ -0,0 +1,101 @@
+#ifndef _FLEXFLOW_OPS_PAD_H
+#define _FLEXFLOW_OPS_PAD_H
+
+#include "flexflow/accessor.h"
+#include "flexflow/model.h"
+#include "flexflow/op_meta.h"
+#include "flexflow/ops/kernels/pad_kernels.h"
+#include "flexflow/ops/pad_params.h"
+
+namespace FlexFlow {
+
+class PadMeta;
+
+/**
+ * @brief Pads the input with a constant value. The padded dims cannot be
+ * partitioned. A zero padding of the height and width of the input of a
+ * convolution becomes part of the convolution's own padding instead, see
+ * FFModel::fold_pads_into_convolutions.
+ */
+class Pad : public Op {
+public:
+  using Params = PadParams;
+  using Input = ParallelTensor;
+  Pad(FFModel &model,
+      const ParallelTensor input,
+      std::vector<int> const &pads_before,
+      std::vector<int> const &pads_after,
+      float value,
+      char const *name = nullptr);
+  Pad(FFModel &model,
+      Params const &params,
+      const Input input,
+      char const *name = nullptr);
+  void init(FFModel const &) override;
+  void forward(FFModel const &) override;
+  void backward(FFModel const &) override;
+  void print_layer(FFModel const &model) override {
+    assert(0);
+  }
+  static Op *
+      create_operator_from_layer(FFModel &model,
+                                 Layer const *layer,
+                                 std::vector<ParallelTensor> const &inputs);
+  static OpMeta *init_task(Legion::Task const *task,
+                           std::vector<Legion::PhysicalRegion> const &regions,
+                           Legion::Context ctx,
+                           Legion::Runtime *runtime);
+  static void forward_task(Legion::Task const *task,
+                           std::vector<Legion::PhysicalRegion> const &regions,
+                           Legion::Context ctx,
+                           Legion::Runtime *runtime);
+  static void backward_task(Legion::Task const *task,
+                            std::vector<Legion::PhysicalRegion> const &regions,
+                            Legion::Context ctx,
+                            Legion::Runtime *runtime);
+  bool measure_operator_cost(Simulator *sim,
+                             MachineView const &pc,
+                             CostMetrics &cost_metrics) const override;
+  void serialize(Legion::Serializer &s) const override;
+  static PCG::Node deserialize(FFModel &ff,
+                               Legion::Deserializer &d,
+                               ParallelTensor inputs[],
+                               int num_inputs);
+  Op *materialize(FFModel &ff,
+                  ParallelTensor inputs[],
+                  int num_inputs) const override;
+  /**
+   * @brief The window of the input within the output, and its offset in the
+   * output.
+   */
+  static size_t get_window(PadMeta const *m,
+                           Legion::Domain const &input,
+                           Legion::Domain const &output,
+                           TensorWindow &window);
+  static void forward_kernel_wrapper(PadMeta const *m,
+                                     GenericTensorAccessorR const &input,
+                                     GenericTensorAccessorW const &output);
+  static void backward_kernel_wrapper(PadMeta const *m,
+                                      GenericTensorAccessorR const &output_grad,
+                                      GenericTensorAccessorW const &input_grad);
+  Params get_params() const;
+
+public:
+  std::vector<int> pads_before, pads_after;
+  float value;
+};
+
+class PadMeta : public OpMeta {
+public:
+  PadMeta(FFHandler handle, Pad const *pad);
+
+public:
+  int num_dims;
+  int pads_before[MAX_TENSOR_DIM];
+  float value;
+  char op_name[MAX_OPNAME];
+};
+
+}; // namespace FlexFlow
+
+#endif // _FLEXFLOW_OPS_PAD_H
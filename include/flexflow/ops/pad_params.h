@@ -0,0 +1,27 @@
+#ifndef _FLEXFLOW_PAD_PARAMS_H
+#define _FLEXFLOW_PAD_PARAMS_H
+
+#include "flexflow/parallel_tensor.h"
+
+namespace FlexFlow {
+
+struct PadParams {
+  // Elements added before and after each Legion dim; the dims past the end
+  // of the vectors are not padded
+  std::vector<int> pads_before, pads_after;
+  float value;
+  bool is_valid(ParallelTensorShape const &) const;
+};
+
+bool operator==(PadParams const &, PadParams const &);
+
+} // namespace FlexFlow
+
+namespace std {
+template <>
+struct hash<FlexFlow::PadParams> {
+  size_t operator()(FlexFlow::PadParams const &) const;
+};
+} // namespace std
+
+#endif // _FLEXFLOW_PAD_PARAMS_H
@@ -0,0 +1,100 @@
+#ifndef _FLEXFLOW_OPS_SLICE_H
+#define _FLEXFLOW_OPS_SLICE_H
+
+#include "flexflow/model.h"
+#include "flexflow/op_meta.h"
+#include "flexflow/ops/kernels/slice_kernels.h"
+#include "flexflow/ops/slice_params.h"
+
+namespace FlexFlow {
+
+class SliceMeta;
+
+/**
+ * @brief A box [starts, ends) of the input. Each task reads the window of
+ * the input matching its output piece as a sub-region of the input, so
+ * Legion only moves the window between devices, and the task copies it
+ * with a single memcpy when it is contiguous. Dims may be sliced even when
+ * they are partitioned.
+ */
+class Slice : public Op {
+public:
+  using Params = SliceParams;
+  using Input = ParallelTensor;
+  Slice(FFModel &model,
+        const ParallelTensor input,
+        std::vector<int> const &starts,
+        std::vector<int> const &ends,
+        char const *name = nullptr);
+  Slice(FFModel &model,
+        Params const &params,
+        const Input input,
+        char const *name = nullptr);
+  void init(FFModel const &) override;
+  void forward(FFModel const &) override;
+  void backward(FFModel const &) override;
+  void map_output_tensors(FFModel &ff) override;
+  void print_layer(FFModel const &model) override {
+    assert(0);
+  }
+  static Op *
+      create_operator_from_layer(FFModel &model,
+                                 Layer const *layer,
+                                 std::vector<ParallelTensor> const &inputs);
+  static OpMeta *init_task(Legion::Task const *task,
+                           std::vector<Legion::PhysicalRegion> const &regions,
+                           Legion::Context ctx,
+                           Legion::Runtime *runtime);
+  static void forward_task(Legion::Task const *task,
+                           std::vector<Legion::PhysicalRegion> const &regions,
+                           Legion::Context ctx,
+                           Legion::Runtime *runtime);
+  static void backward_task(Legion::Task const *task,
+                            std::vector<Legion::PhysicalRegion> const &regions,
+                            Legion::Context ctx,
+                            Legion::Runtime *runtime);
+  bool measure_operator_cost(Simulator *sim,
+                             MachineView const &pc,
+                             CostMetrics &cost_metrics) const override;
+  void serialize(Legion::Serializer &s) const override;
+  static PCG::Node deserialize(FFModel &ff,
+                               Legion::Deserializer &d,
+                               ParallelTensor inputs[],
+                               int num_inputs);
+  Op *materialize(FFModel &ff,
+                  ParallelTensor inputs[],
+                  int num_inputs) const override;
+  /**
+   * @brief Copies the window starting at input to the dense output.
+   */
+  static void forward_kernel_wrapper(SliceMeta const *m,
+                                     TensorWindow const &window,
+                                     float const *input,
+                                     float *output);
+  /**
+   * @brief Accumulates the dense output_grad into the window starting at
+   * input_grad.
+   */
+  static void backward_kernel_wrapper(SliceMeta const *m,
+                                      TensorWindow const &window,
+                                      float const *output_grad,
+                                      float *input_grad);
+  Params get_params() const;
+
+public:
+  std::vector<int> starts, ends;
+  // The windows of the input and of its gradient read by each task
+  Legion::LogicalPartition input_lp, input_grad_lp;
+};
+
+class SliceMeta : public OpMeta {
+public:
+  SliceMeta(FFHandler handle, Slice const *slice);
+
+public:
+  char op_name[MAX_OPNAME];
+};
+
+}; // namespace FlexFlow
+
+#endif // _FLEXFLOW_OPS_SLICE_H
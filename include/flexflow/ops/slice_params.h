@@ -0,0 +1,26 @@
+#ifndef _FLEXFLOW_SLICE_PARAMS_H
+#define _FLEXFLOW_SLICE_PARAMS_H
+
+#include "flexflow/parallel_tensor.h"
+
+namespace FlexFlow {
+
+struct SliceParams {
+  // Window [starts[i], ends[i]) of each Legion dim; the dims past the end of
+  // the vectors are kept whole
+  std::vector<int> starts, ends;
+  bool is_valid(ParallelTensorShape const &) const;
+};
+
+bool operator==(SliceParams const &, SliceParams const &);
+
+} // namespace FlexFlow
+
+namespace std {
+template <>
+struct hash<FlexFlow::SliceParams> {
+  size_t operator()(FlexFlow::SliceParams const &) const;
+};
+} // namespace std
+
+#endif // _FLEXFLOW_SLICE_PARAMS_H
@@ -16,6 +16,7 @@
 #ifndef _FLEXFLOW_OPTIMIZER_H_
 #define _FLEXFLOW_OPTIMIZER_H_
 
+#include "flexflow/layerwise_optimizer.h"
 #include "flexflow/parallel_tensor.h"
 #include "legion.h"
 
@@ -30,9 +31,35 @@ public:
   virtual void init(void) = 0;
   virtual void next(void) = 0;
   virtual void update(const ParallelTensor p) = 0;
+  // Copy the state of an optimizer of the same type whose model was compiled
+  // for different resources; old_params maps every parameter of this
+  // optimizer's model to the matching parameter of the old model
+  virtual void reshard_from(
+      Optimizer const *old_optimizer,
+      std::map<ParallelTensor, ParallelTensor> const &old_params) = 0;
+  // Store the state in a checkpoint, or load it back into an optimizer of the
+  // same type whose model may be compiled for different resources; params
+  // names every parameter of the model in the checkpoint
+  virtual void save_checkpoint(
+      ModelCheckpoint &ckpt,
+      std::map<ParallelTensor, std::string> const &params) const = 0;
+  virtual bool
+      load_checkpoint(ModelCheckpoint const &ckpt,
+                      std::map<ParallelTensor, std::string> const &params,
+                      std::string &error) = 0;
+  // Bytes of optimizer state kept per parameter, which the simulator adds to
+  // the memory of the weights
+  virtual float state_bytes_per_parameter(void) const = 0;
   FFModel const *model;
 };
 
+// Per-block scales of OPTIMIZER_STATE_INT8 state: one float per
+// OPTIMIZER_STATE_BLOCK_SIZE elements of each shard of a parameter
+struct OptimizerStateScales {
+  Legion::LogicalRegion region;
+  Legion::LogicalPartition part; // NO_PART for parameter servers
+};
+
 class SGDOptimizer : public Optimizer {
 public:
   SGDOptimizer(FFModel const *_model,
@@ -43,6 +70,15 @@ public:
   void init(void);
   void next(void);
   void update(const ParallelTensor p);
+  void reshard_from(Optimizer const *old_optimizer,
+                    std::map<ParallelTensor, ParallelTensor> const &old_params);
+  void save_checkpoint(
+      ModelCheckpoint &ckpt,
+      std::map<ParallelTensor, std::string> const &params) const;
+  bool load_checkpoint(ModelCheckpoint const &ckpt,
+                       std::map<ParallelTensor, std::string> const &params,
+                       std::string &error);
+  float state_bytes_per_parameter(void) const;
   void set_weight_decay(double _weight_decay);
   static void ps_update_task(Legion::Task const *task,
                              std::vector<Legion::PhysicalRegion> const &regions,
@@ -85,18 +121,33 @@ public:
   void init(void);
   void next(void);
   void update(const ParallelTensor p);
+  void reshard_from(Optimizer const *old_optimizer,
+                    std::map<ParallelTensor, ParallelTensor> const &old_params);
+  void save_checkpoint(
+      ModelCheckpoint &ckpt,
+      std::map<ParallelTensor, std::string> const &params) const;
+  bool load_checkpoint(ModelCheckpoint const &ckpt,
+                       std::map<ParallelTensor, std::string> const &params,
+                       std::string &error);
+  float state_bytes_per_parameter(void) const;
   void set_weight_decay(double _weight_decay);
+  // Must be called before init
+  void set_state_type(OptimizerStateType _state_type);
   static void ps_update_task(Legion::Task const *task,
                              std::vector<Legion::PhysicalRegion> const &regions,
                              Legion::Context ctx,
                              Legion::Runtime *runtime);
+  // v_ptr and m_ptr point to moments of state_type; the scales are only used
+  // by OPTIMIZER_STATE_INT8
   static void ps_update_task_gpu(AdamOptimizer const *op,
                                  float const *w_grad_ptr,
                                  size_t size,
                                  int num_replicas,
                                  float *w_ptr,
-                                 float *v_ptr,
-                                 float *m_ptr);
+                                 void *v_ptr,
+                                 void *m_ptr,
+                                 float *v_scale_ptr,
+                                 float *m_scale_ptr);
 #ifdef FF_USE_NCCL
   static void
       nccl_update_task(Legion::Task const *task,
@@ -108,13 +159,131 @@ public:
                                    float const *w_grad_ptr,
                                    size_t size,
                                    float *w_ptr,
-                                   float *v_ptr,
-                                   float *m_ptr);
+                                   void *v_ptr,
+                                   void *m_ptr,
+                                   float *v_scale_ptr,
+                                   float *m_scale_ptr);
 #endif
   double alpha, beta1, beta2, weight_decay, epsilon;
   double alpha_t, beta1_t, beta2_t;
+  OptimizerStateType state_type;
+  std::map<Legion::LogicalRegion, ParallelTensor> v_values, m_values;
+  std::map<Legion::LogicalRegion, OptimizerStateScales> v_scales, m_scales;
+};
+
+// Argument of each point of the NCCL update tasks of LAMB and LARS, whose
+// trust ratios need the norms of the whole parameter
+struct LayerwiseUpdateArgs {
+  OpMeta *meta;
+  // Points of the launch that hold the same shard of the parameter
+  int num_replicas;
+};
+
+// Layer-wise adaptive moments (LAMB): Adam with decoupled weight decay
+// whose step on each parameter is scaled by ||w|| / ||update||
+class LAMBOptimizer : public Optimizer {
+public:
+  LAMBOptimizer(FFModel const *_model,
+                double _lr = 0.001f,
+                double _beta1 = 0.9f,
+                double _beta2 = 0.999f,
+                double _weight_decay = 0.01f,
+                double _epsilon = 1e-6);
+  void init(void);
+  void next(void);
+  void update(const ParallelTensor p);
+  void reshard_from(Optimizer const *old_optimizer,
+                    std::map<ParallelTensor, ParallelTensor> const &old_params);
+  void save_checkpoint(
+      ModelCheckpoint &ckpt,
+      std::map<ParallelTensor, std::string> const &params) const;
+  bool load_checkpoint(ModelCheckpoint const &ckpt,
+                       std::map<ParallelTensor, std::string> const &params,
+                       std::string &error);
+  float state_bytes_per_parameter(void) const;
+  void set_weight_decay(double _weight_decay);
+  LAMBStep get_step(void) const;
+  static void ps_update_task(Legion::Task const *task,
+                             std::vector<Legion::PhysicalRegion> const &regions,
+                             Legion::Context ctx,
+                             Legion::Runtime *runtime);
+  static void ps_update_task_gpu(LAMBOptimizer const *op,
+                                 float const *w_grad_ptr,
+                                 size_t size,
+                                 int num_replicas,
+                                 float *w_ptr,
+                                 float *v_ptr,
+                                 float *m_ptr);
+#ifdef FF_USE_NCCL
+  static void
+      nccl_update_task(Legion::Task const *task,
+                       std::vector<Legion::PhysicalRegion> const &regions,
+                       Legion::Context ctx,
+                       Legion::Runtime *runtime);
+  static void nccl_update_task_gpu(LAMBOptimizer const *op,
+                                   LayerwiseUpdateArgs const &args,
+                                   float const *w_grad_ptr,
+                                   size_t size,
+                                   float *w_ptr,
+                                   float *v_ptr,
+                                   float *m_ptr);
+#endif
+  double lr, beta1, beta2, weight_decay, epsilon;
+  double beta1_t, beta2_t;
   std::map<Legion::LogicalRegion, ParallelTensor> v_values, m_values;
 };
 
+// Layer-wise adaptive rate scaling (LARS): SGD with momentum whose learning
+// rate on each parameter is scaled by
+// trust_coefficient * ||w|| / (||g|| + weight_decay * ||w||)
+class LARSOptimizer : public Optimizer {
+public:
+  LARSOptimizer(FFModel const *_model,
+                double _lr = 0.1f,
+                double _momentum = 0.9f,
+                double _weight_decay = 5e-4,
+                double _trust_coefficient = 0.001f,
+                double _epsilon = 1e-9);
+  void init(void);
+  void next(void);
+  void update(const ParallelTensor p);
+  void reshard_from(Optimizer const *old_optimizer,
+                    std::map<ParallelTensor, ParallelTensor> const &old_params);
+  void save_checkpoint(
+      ModelCheckpoint &ckpt,
+      std::map<ParallelTensor, std::string> const &params) const;
+  bool load_checkpoint(ModelCheckpoint const &ckpt,
+                       std::map<ParallelTensor, std::string> const &params,
+                       std::string &error);
+  float state_bytes_per_parameter(void) const;
+  void set_weight_decay(double _weight_decay);
+  LARSStep get_step(void) const;
+  static void ps_update_task(Legion::Task const *task,
+                             std::vector<Legion::PhysicalRegion> const &regions,
+                             Legion::Context ctx,
+                             Legion::Runtime *runtime);
+  static void ps_update_task_gpu(LARSOptimizer const *op,
+                                 float const *w_grad_ptr,
+                                 size_t size,
+                                 int num_replicas,
+                                 float *w_ptr,
+                                 float *v_ptr);
+#ifdef FF_USE_NCCL
+  static void
+      nccl_update_task(Legion::Task const *task,
+                       std::vector<Legion::PhysicalRegion> const &regions,
+                       Legion::Context ctx,
+                       Legion::Runtime *runtime);
+  static void nccl_update_task_gpu(LARSOptimizer const *op,
+                                   LayerwiseUpdateArgs const &args,
+                                   float const *w_grad_ptr,
+                                   size_t size,
+                                   float *w_ptr,
+                                   float *v_ptr);
+#endif
+  double lr, momentum, weight_decay, trust_coefficient, epsilon;
+  std::map<Legion::LogicalRegion, ParallelTensor> v_values;
+};
+
 }; // namespace FlexFlow
 #endif
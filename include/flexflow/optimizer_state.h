@@ -0,0 +1,145 @@
+#ifndef _FLEXFLOW_OPTIMIZER_STATE_H_
+#define _FLEXFLOW_OPTIMIZER_STATE_H_
+
+#include "flexflow/ffconst.h"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// The conversions are shared by the CPU reference and the GPU kernels
+#if defined(__CUDACC__) || defined(__HIPCC__)
+#define FF_STATE_FUNC __host__ __device__ inline
+#else
+#define FF_STATE_FUNC inline
+#endif
+
+namespace FlexFlow {
+
+/**
+ * @brief Number of consecutive elements of a shard that share a scale in
+ * OPTIMIZER_STATE_INT8.
+ */
+constexpr int OPTIMIZER_STATE_BLOCK_SIZE = 256;
+
+/**
+ * @brief Bytes of a state tensor per parameter, including the scales of
+ * OPTIMIZER_STATE_INT8.
+ */
+float optimizer_state_bytes(OptimizerStateType type);
+
+/**
+ * @brief Round to the nearest bf16, ties to even.
+ */
+FF_STATE_FUNC uint16_t float_to_bf16(float x) {
+  uint32_t bits;
+  memcpy(&bits, &x, sizeof(bits));
+  if ((bits & 0x7fffffffu) > 0x7f800000u) {
+    // Keep NaNs quiet instead of rounding them to infinity
+    return (uint16_t)((bits >> 16) | 0x40u);
+  }
+  bits += 0x7fffu + ((bits >> 16) & 1u);
+  return (uint16_t)(bits >> 16);
+}
+
+FF_STATE_FUNC float bf16_to_float(uint16_t x) {
+  uint32_t bits = (uint32_t)x << 16;
+  float y;
+  memcpy(&y, &bits, sizeof(y));
+  return y;
+}
+
+/**
+ * @brief First moments are stored as signed linear codes of the absolute
+ * maximum of their block.
+ */
+FF_STATE_FUNC int8_t quantize_first_moment(float x, float absmax) {
+  if (absmax <= 0.0f) {
+    return 0;
+  }
+  float q = rintf(x / absmax * 127.0f);
+  q = q > 127.0f ? 127.0f : (q < -127.0f ? -127.0f : q);
+  return (int8_t)q;
+}
+
+FF_STATE_FUNC float dequantize_first_moment(int8_t q, float absmax) {
+  return (float)q * (absmax / 127.0f);
+}
+
+/**
+ * @brief Second moments are non-negative and span orders of magnitude within
+ * a block, so they are stored as linear codes of their square root.
+ */
+FF_STATE_FUNC uint8_t quantize_second_moment(float x, float max) {
+  if (max <= 0.0f || x <= 0.0f) {
+    return 0;
+  }
+  float q = rintf(sqrtf(x / max) * 255.0f);
+  q = q > 255.0f ? 255.0f : q;
+  return (uint8_t)q;
+}
+
+FF_STATE_FUNC float dequantize_second_moment(uint8_t q, float max) {
+  float r = (float)q / 255.0f;
+  return r * r * max;
+}
+
+/**
+ * @brief The hyper-parameters of one Adam step; alpha_t includes the bias
+ * corrections.
+ */
+struct AdamStep {
+  float alpha_t, beta1, beta2, weight_decay, epsilon;
+};
+
+FF_STATE_FUNC void adam_step(
+    AdamStep const &s, float grad, float &w, float &m, float &v) {
+  float gt = grad + s.weight_decay * w;
+  m = s.beta1 * m + (1 - s.beta1) * gt;
+  v = s.beta2 * v + (1 - s.beta2) * gt * gt;
+  w -= s.alpha_t * m / (sqrtf(v) + s.epsilon);
+}
+
+namespace Kernels {
+namespace Adam {
+
+/**
+ * @brief Adam update on the CPU with fp32 moments.
+ */
+void update_cpu(AdamStep const &step,
+                size_t size,
+                float const *w_grad,
+                float *w,
+                float *m,
+                float *v);
+
+/**
+ * @brief Adam update on the CPU with bf16 moments.
+ */
+void update_bf16_cpu(AdamStep const &step,
+                     size_t size,
+                     float const *w_grad,
+                     float *w,
+                     uint16_t *m,
+                     uint16_t *v);
+
+/**
+ * @brief Adam update on the CPU with blockwise 8-bit moments: the moments of
+ * each block of OPTIMIZER_STATE_BLOCK_SIZE elements are dequantized, updated
+ * in fp32 and requantized with the new maximum of the block.
+ * @param m_scales, v_scales one scale per block
+ */
+void update_int8_cpu(AdamStep const &step,
+                     size_t size,
+                     float const *w_grad,
+                     float *w,
+                     int8_t *m,
+                     uint8_t *v,
+                     float *m_scales,
+                     float *v_scales);
+
+} // namespace Adam
+} // namespace Kernels
+} // namespace FlexFlow
+
+#endif // _FLEXFLOW_OPTIMIZER_STATE_H_
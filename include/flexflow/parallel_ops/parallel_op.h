@@ -32,8 +32,17 @@ public:
       std::vector<ParallelOpInfo> &parallel_ops) const = 0;
   virtual bool is_parallel_op() const;
 
+protected:
+  // Map the output as another partition of the input region (and of its
+  // gradients), for parallel ops that only change how a tensor is
+  // partitioned. Legion then copies the pieces consumers need on other
+  // devices and no task runs. Returns false if the output needs its own
+  // regions.
+  bool alias_output_to_input(FFModel &model);
+
 public:
   Legion::LogicalPartition input_lp, output_grad_lp;
+  bool output_aliased = false;
 };
 
 }; // namespace FlexFlow
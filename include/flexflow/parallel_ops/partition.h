@@ -24,6 +24,7 @@ public:
               Input const input,
               char const *name = nullptr);
   void create_input_partition(FFModel &model) override;
+  void map_output_tensors(FFModel &model) override;
   void init(FFModel const &) override;
   void forward(FFModel const &) override;
   void backward(FFModel const &) override;
@@ -25,6 +25,7 @@
 #include "flexflow/utils/dot/record_formatter.h"
 #include "legion.h"
 #include <ostream>
+#include <string>
 #include <unordered_map>
 
 namespace FlexFlow {
@@ -32,6 +33,7 @@ namespace FlexFlow {
 class Op;
 class FFModel;
 class Initializer;
+struct ModelCheckpoint;
 
 struct ParallelDim {
   static constexpr int UNKNOWN_DEGREE = -1;
@@ -106,6 +108,14 @@ struct ParallelTensorShape {
   int get_num_replica_dims() const;
   int get_num_replicas() const;
 
+  /**
+   * @brief Whether the two shapes hold the same logical tensor and only differ
+   * in how it is partitioned and replicated.
+   * @details The replica dimensions must be the outermost dimensions, so that
+   * every replica is stored contiguously.
+   */
+  bool is_reshardable_to(ParallelTensorShape const &other) const;
+
   std::unordered_map<int, int> get_mv_dim_to_tensor_dim_mapping() const;
   std::unordered_map<int, int> get_tensor_dim_to_mv_dim_mapping() const;
 };
@@ -167,6 +177,17 @@ struct ParallelTensorBase {
                   T const *data);
   template <typename T>
   bool get_tensor(FFModel const *model, T *data, bool get_parameters);
+  // Copy the data of src, which may be partitioned and replicated differently
+  bool reshard_from(FFModel const *model, ParallelTensorBase const *src);
+  // Store the data of this tensor in ckpt under name, or load it back into a
+  // tensor that may be partitioned and replicated differently
+  void save_checkpoint(FFModel const *model,
+                       ModelCheckpoint &ckpt,
+                       std::string const &name) const;
+  bool load_checkpoint(FFModel const *model,
+                       ModelCheckpoint const &ckpt,
+                       std::string const &name,
+                       std::string &error);
   ParallelTensorShape get_shape() const;
 
 private:
@@ -16,8 +16,10 @@
 #ifndef _FLEXFLOW_RECOMPILE_H_
 #define _FLEXFLOW_RECOMPILE_H_
 
+#include "flexflow/parallel_tensor.h"
 #include "legion.h"
 #include <functional>
+#include <vector>
 
 namespace FlexFlow {
 
@@ -25,9 +27,13 @@ class FFModel;
 
 class RecompileState {
 public:
+  // tensors are used by the trigger and alter functions, and are kept from
+  // being reused by the recompiles (see FFModel::retain_tensor)
   RecompileState(std::function<bool(FFModel *)> _trigger_func,
                  std::function<void(FFModel *)> _alter_func,
-                 FFModel *_ff);
+                 FFModel *_ff,
+                 std::vector<ParallelTensor> const &_tensors = {});
+  ~RecompileState();
   bool trigger();
   void alter();
 
@@ -38,6 +44,7 @@ private:
   std::function<bool(FFModel *)> trigger_func;
   std::function<void(FFModel *)> alter_func;
   FFModel *ff;
+  std::vector<ParallelTensor> tensors;
 };
 
 }; // namespace FlexFlow
@@ -0,0 +1,184 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _FLEXFLOW_REGION_CACHE_H_
+#define _FLEXFLOW_REGION_CACHE_H_
+
+#include <cassert>
+#include <cstddef>
+#include <map>
+#include <vector>
+
+namespace FlexFlow {
+
+/**
+ * @brief Usage statistics of the runtime resources held by a RegionCache.
+ */
+struct RegionCacheStats {
+  size_t num_live = 0, num_created = 0, num_reused = 0, num_destroyed = 0;
+};
+
+/**
+ * @brief Reuse runtime resources (index spaces, partitions, field spaces and
+ * regions) across compiles of the same model.
+ *
+ * @details Resources are keyed by their structure, e.g. the rect of an index
+ * space or the parent, color space, transform and extent of a partition.
+ * Every compile is an epoch: a resource found or created during the epoch,
+ * touched because a live tensor still refers to it, or retained, is used by
+ * the epoch. Resources not used by the last max_idle_epochs + 1 epochs are
+ * returned by end_epoch() for the caller to destroy, so that switching back
+ * and forth between strategies does not recreate them every time.
+ *
+ * Shared resources are handed out to every lookup of their key. Exclusive
+ * resources (regions, which hold the data of one tensor) are reference
+ * counted: a lookup only hands out a resource nobody retains and that was
+ * not handed out earlier in the epoch, so that a region is never given to a
+ * tensor while another live tensor still refers to it.
+ *
+ * @tparam Handle runtime handle, ordered by operator<
+ */
+template <typename Handle>
+class RegionCache {
+public:
+  typedef std::vector<long long> Key;
+
+  RegionCache(bool _exclusive = false, unsigned _max_idle_epochs = 1)
+      : exclusive(_exclusive), max_idle_epochs(_max_idle_epochs) {}
+
+  void begin_epoch(void) {
+    assert(!active);
+    epoch++;
+    active = true;
+  }
+
+  bool in_epoch(void) const {
+    return active;
+  }
+
+  // Returns true and sets handle to a cached resource of the key, if any
+  bool find(Key const &key, Handle &handle) {
+    assert(active);
+    auto range = entries.equal_range(key);
+    for (auto it = range.first; it != range.second; it++) {
+      if (exclusive &&
+          (it->second.refs > 0 || it->second.last_use == epoch)) {
+        continue;
+      }
+      it->second.last_use = epoch;
+      handle = it->second.handle;
+      stats.num_reused++;
+      return true;
+    }
+    return false;
+  }
+
+  // Track a resource created by the caller for the key
+  void insert(Key const &key, Handle const &handle) {
+    assert(active);
+    assert(handles.find(handle) == handles.end());
+    Entry entry;
+    entry.handle = handle;
+    entry.last_use = epoch;
+    handles[handle] = entries.insert(std::make_pair(key, entry));
+    stats.num_live++;
+    stats.num_created++;
+  }
+
+  // Keep a resource still referenced from outside the cache; returns false
+  // for resources not created through this cache
+  bool touch(Handle const &handle) {
+    auto it = handles.find(handle);
+    if (it == handles.end()) {
+      return false;
+    }
+    it->second->second.last_use = epoch;
+    return true;
+  }
+
+  // Add a reference to a resource, which keeps it from being handed out or
+  // destroyed until it is released; returns false for resources not created
+  // through this cache
+  bool retain(Handle const &handle) {
+    auto it = handles.find(handle);
+    if (it == handles.end()) {
+      return false;
+    }
+    it->second->second.refs++;
+    return true;
+  }
+
+  // Drop a reference added by retain
+  bool release(Handle const &handle) {
+    auto it = handles.find(handle);
+    if (it == handles.end()) {
+      return false;
+    }
+    assert(it->second->second.refs > 0);
+    it->second->second.refs--;
+    return true;
+  }
+
+  // Finish the epoch; returns the resources idle for too long, which are
+  // forgotten and must be destroyed by the caller
+  std::vector<Handle> end_epoch(void) {
+    assert(active);
+    active = false;
+    std::vector<Handle> unused;
+    for (auto it = entries.begin(); it != entries.end();) {
+      if (it->second.refs > 0) {
+        // Idle epochs are counted from the release
+        it->second.last_use = epoch;
+      }
+      if (epoch - it->second.last_use <= max_idle_epochs) {
+        it++;
+        continue;
+      }
+      unused.push_back(it->second.handle);
+      handles.erase(it->second.handle);
+      it = entries.erase(it);
+      stats.num_live--;
+      stats.num_destroyed++;
+    }
+    return unused;
+  }
+
+  size_t size(void) const {
+    return entries.size();
+  }
+
+  RegionCacheStats const &get_stats(void) const {
+    return stats;
+  }
+
+private:
+  struct Entry {
+    Handle handle;
+    unsigned long long last_use = 0;
+    size_t refs = 0;
+  };
+
+  bool exclusive;
+  unsigned max_idle_epochs;
+  bool active = false;
+  unsigned long long epoch = 0;
+  std::multimap<Key, Entry> entries;
+  std::map<Handle, typename std::multimap<Key, Entry>::iterator> handles;
+  RegionCacheStats stats;
+};
+
+}; // namespace FlexFlow
+
+#endif // _FLEXFLOW_REGION_CACHE_H_
@@ -0,0 +1,85 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _FLEXFLOW_SERVING_SEARCH_H_
+#define _FLEXFLOW_SERVING_SEARCH_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace FlexFlow {
+
+/**
+ * @brief The best strategy found by the search for one batch size, evaluated
+ * for serving: every request of a batch waits for the whole batch.
+ */
+class ServingSearchPoint {
+public:
+  ServingSearchPoint(int _batch_size, float _latency);
+
+  int batch_size;
+  float latency;    ///< Simulated time of one inference step (ms)
+  float throughput; ///< Samples per second
+};
+
+/**
+ * @brief The points not dominated by another point with both a lower or
+ * equal latency and a higher or equal throughput, by increasing latency.
+ */
+std::vector<ServingSearchPoint>
+    serving_pareto_front(std::vector<ServingSearchPoint> const &points);
+
+/**
+ * @brief Index of the point with the highest throughput whose latency meets
+ * the SLO (ms), or of the point with the lowest latency if none does.
+ */
+int select_serving_point(std::vector<ServingSearchPoint> const &points,
+                         float latency_slo);
+
+/**
+ * @brief Default batch sizes of the serving search: the powers of two below
+ * max_batch_size, and max_batch_size itself.
+ */
+std::vector<int> default_serving_batch_sizes(int max_batch_size);
+
+/**
+ * @brief A strategy chosen by the search, written with --export-strategy and
+ * loaded with --import-strategy to skip the search.
+ *
+ * @details The file holds the batch size the strategy was searched for, its
+ * simulated step time and the serialized PCG and machine views returned by
+ * the graph optimize task. Importing it sets FFConfig::batchSize, so the
+ * model must be built the same way as when the strategy was exported.
+ */
+class ExportedStrategy {
+public:
+  static uint32_t const VERSION = 2;
+
+  bool save(std::string const &filename) const;
+  // Returns false if the file is missing or is not an exported strategy
+  static bool load(std::string const &filename, ExportedStrategy &strategy);
+
+public:
+  int batch_size = 0;
+  int comp_mode = 0;
+  float latency_slo = 0.0f; ///< 0 if the strategy was not a serving search
+  float latency = 0.0f;     ///< Simulated step time (ms)
+  std::vector<char> graph_optimal_view;
+};
+
+} // namespace FlexFlow
+
+#endif // _FLEXFLOW_SERVING_SEARCH_H_
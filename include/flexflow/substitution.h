@@ -194,6 +194,8 @@ public:
                      bool use_bias);
   OpX *create_conv2d(TensorX const &input, OpX const *match_opx);
   OpX *create_pool2d(TensorX const &input, OpX const *match_opx);
+  OpX *create_slice(TensorX const &input, OpX const *match_opx);
+  OpX *create_pad(TensorX const &input, OpX const *match_opx);
   OpX *create_attention(TensorX const &query,
                         TensorX const &key,
                         TensorX const &value,
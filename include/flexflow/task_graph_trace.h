@@ -0,0 +1,105 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _FLEXFLOW_TASK_GRAPH_TRACE_H_
+#define _FLEXFLOW_TASK_GRAPH_TRACE_H_
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace FlexFlow {
+
+/**
+ * @brief A simulated task graph without the communication tasks, so that it
+ * can be replayed on another machine model.
+ *
+ * @details Tasks keep the GPU they run on and their run time. Transfers are
+ * kept as edges carrying a number of bytes, which are expanded into the
+ * communication tasks of the path between the two GPUs of the target
+ * machine on replay. Launch tasks run on the utility processors of the node
+ * they were recorded on.
+ *
+ * The text format starts with a "flexflow-taskgraph-trace <version>" line,
+ * followed by the segmentation settings, a "tasks <n>" section with one
+ * "<type> <device> <run time in ms> <name>" line per task and an
+ * "edges <m>" section with one "<src> <dst> <bytes>" line per edge, where
+ * 0 bytes denotes a plain dependency.
+ */
+struct TaskGraphTrace {
+  static int const VERSION = 1;
+  enum TaskType {
+    TASK_FORWARD,
+    TASK_BACKWARD,
+    TASK_UPDATE,
+    TASK_BARRIER,
+    TASK_LAUNCH,
+  };
+  struct Task {
+    TaskType type;
+    int device_id; // GPU of the task, or node of a launch task
+    float run_time;
+    std::string name;
+  };
+  struct Edge {
+    int src, dst;
+    size_t xfer_size;
+  };
+
+  int num_gpus = 0; // GPUs of the recording machine
+  int segment_size = 0, max_num_segments = 1;
+  std::vector<Task> tasks;
+  std::vector<Edge> edges;
+
+  /**
+   * @brief The largest GPU id of the tasks, or -1 if there is none.
+   */
+  int max_gpu_id() const;
+  void write(std::ostream &os) const;
+  /**
+   * @return false, with a description of the problem in error, if the input
+   * is not a trace of a version up to VERSION
+   */
+  static bool read(std::istream &is, TaskGraphTrace &trace, std::string &error);
+};
+
+/**
+ * @brief Settings of a replay; zero takes the value of the trace.
+ */
+struct TaskGraphReplayOptions {
+  int segment_size = 0, max_num_segments = 0;
+  float compute_scale = 1.0f; ///< Factor on the run time of GPU tasks
+};
+
+/**
+ * @brief Makespan and device usage of a replayed task graph.
+ */
+struct TaskGraphReplayReport {
+  struct DeviceUsage {
+    std::string name;
+    float busy_time; // ms
+    size_t bytes;    // Transferred bytes, for communication devices
+  };
+  float makespan = 0.0f;
+  std::vector<DeviceUsage> compute_devices; // GPUs, then utility processors
+  std::vector<DeviceUsage> links;           // By decreasing busy time
+
+  void print(std::ostream &os) const;
+};
+
+} // namespace FlexFlow
+
+#endif // _FLEXFLOW_TASK_GRAPH_TRACE_H_
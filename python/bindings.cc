@@ -360,6 +360,28 @@ PYBIND11_MODULE(flexflow_pybind11_internal, m) {
       .def("set_learning_rate",
            [](AdamOptimizer &optimizer, double lr) { optimizer.alpha = lr; });
 
+  py::class_<LAMBOptimizer, Optimizer>(m, "LAMBOptimizer")
+      .def(py::init<FFModel const *, double, double, double, double, double>(),
+           "model"_a,
+           "lr"_a = 0.001f,
+           "beta1"_a = 0.9f,
+           "beta2"_a = 0.999f,
+           "weight_decay"_a = 0.01f,
+           "epsilon"_a = 1e-6)
+      .def("set_learning_rate",
+           [](LAMBOptimizer &optimizer, double lr) { optimizer.lr = lr; });
+
+  py::class_<LARSOptimizer, Optimizer>(m, "LARSOptimizer")
+      .def(py::init<FFModel const *, double, double, double, double, double>(),
+           "model"_a,
+           "lr"_a = 0.1f,
+           "momentum"_a = 0.9f,
+           "weight_decay"_a = 5e-4,
+           "trust_coefficient"_a = 0.001f,
+           "epsilon"_a = 1e-9)
+      .def("set_learning_rate",
+           [](LARSOptimizer &optimizer, double lr) { optimizer.lr = lr; });
+
   py::class_<NetConfig>(m, "NetConfig")
       .def(py::init())
       .def_readonly("dataset_path", &NetConfig::dataset_path);
@@ -487,7 +509,10 @@ PYBIND11_MODULE(flexflow_pybind11_internal, m) {
       // Training
       .def("forward", &FFModel::forward, "seq_length"_a = -1)
       .def("zero_gradients", &FFModel::zero_gradients)
-      .def("backward", &FFModel::backward, "seq_length"_a = -1)
+      .def("backward",
+           &FFModel::backward,
+           "seq_length"_a = -1,
+           "with_metrics"_a = true)
       .def("update", &FFModel::update)
       // Arithmetic operators
       .def("exp", &FFModel::exp, "x"_a, "name"_a = nullptr)
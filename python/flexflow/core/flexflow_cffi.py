@@ -23,6 +23,7 @@ import warnings
 import numpy as np
 from .flexflow_logger import fflogger
 from flexflow.type import ActiMode, AggrMode, PoolType, DataType, LossType, CompMode, MetricsType, OpType, ParameterSyncType, enum_to_int, int_to_enum
+from flexflow.graph_ir import graph_ir_num_nodes
 _FF_BUILD_DOCS = bool(os.environ.get('READTHEDOCS') or os.environ.get("FF_BUILD_DOCS"))
 if not _FF_BUILD_DOCS:
   from .flexflow_cffi_header import ffc, ffi
@@ -399,6 +400,20 @@ class Gather(Op):
   def __init__(self, handle, idx=None, name=None):
     super(Gather, self).__init__(handle, idx, name)
 
+# -----------------------------------------------------------------------
+# Slice
+# -----------------------------------------------------------------------
+class Slice(Op):
+  def __init__(self, handle, idx=None, name=None):
+    super(Slice, self).__init__(handle, idx, name)
+
+# -----------------------------------------------------------------------
+# Pad
+# -----------------------------------------------------------------------
+class Pad(Op):
+  def __init__(self, handle, idx=None, name=None):
+    super(Pad, self).__init__(handle, idx, name)
+
 # -----------------------------------------------------------------------
 # Identity
 # -----------------------------------------------------------------------
@@ -515,6 +530,10 @@ def convert_op_handle_to_op(op_type, handle, idx=None, name=None):
     return Mean(handle, idx, name)
   elif op_type == OpType.GATHER:
     return Gather(handle, idx, name)
+  elif op_type == OpType.SLICE:
+    return Slice(handle, idx, name)
+  elif op_type == OpType.PAD:
+    return Pad(handle, idx, name)
   else:
     assert 0, "unknown layer type {}".format(op_type)
     return None
@@ -1676,6 +1695,61 @@ class FFModel(object):
     self.add_layer(OpType.TRANSPOSE, name)
     return Tensor(handle, owner_op_type=OpType.TRANSPOSE)
 
+  def slice(self, input, starts, ends, name=None):
+    """Takes the window [starts[i], ends[i]) of the leading dimensions of
+    the :attr:`input` tensor. Negative indices count from the end of a
+    dimension, and the dimensions past the end of starts are kept whole.
+
+    :param input: the input Tensor.
+    :type input: Tensor
+
+    :param starts: the first index of each sliced dimension.
+    :type starts: List of int
+
+    :param ends: the end index (exclusive) of each sliced dimension.
+    :type ends: List of int
+
+    :param name: the name of the layer. Default is None.
+    :type name: string
+
+    :returns:  Tensor -- the output tensor.
+    """
+    assert len(starts) == len(ends), "starts and ends differ in length"
+    c_name = get_c_name(name)
+    c_starts = ffi.new("int[]", starts)
+    c_ends = ffi.new("int[]", ends)
+    handle = ffc.flexflow_model_add_slice(self.handle, input.handle, len(starts), c_starts, c_ends, c_name)
+    self.add_layer(OpType.SLICE, name)
+    return Tensor(handle, owner_op_type=OpType.SLICE)
+
+  def pad(self, input, pads_before, pads_after, value=0.0, name=None):
+    """Pads each dimension of the :attr:`input` tensor with a constant.
+
+    :param input: the input Tensor.
+    :type input: Tensor
+
+    :param pads_before: the number of elements added before each dimension.
+    :type pads_before: List of int
+
+    :param pads_after: the number of elements added after each dimension.
+    :type pads_after: List of int
+
+    :param value: the value of the padding. Default is 0.
+    :type value: float
+
+    :param name: the name of the layer. Default is None.
+    :type name: string
+
+    :returns:  Tensor -- the output tensor.
+    """
+    assert len(pads_before) == len(pads_after), "pads differ in length"
+    c_name = get_c_name(name)
+    c_before = ffi.new("int[]", pads_before)
+    c_after = ffi.new("int[]", pads_after)
+    handle = ffc.flexflow_model_add_pad(self.handle, input.handle, len(pads_before), c_before, c_after, value, c_name)
+    self.add_layer(OpType.PAD, name)
+    return Tensor(handle, owner_op_type=OpType.PAD)
+
   def reverse(self, input, axis, name=None):
     """Layer that reverses specific dimensions of a tensor.
     
@@ -2041,7 +2115,47 @@ class FFModel(object):
       ff_tensor.set_tensor(self, np_tensor)
     print("Compiled ffmodel!")
 
-  def fit(self, x=None, y=None, batch_size=None, epochs=1):
+  def run_loop(self, dataloaders, iterations=0, tracing_id=-1, metrics_interval=1, eval=False, callback=None, callback_interval=1):
+    """Runs training (or inference) steps in C++ without returning to Python
+    between steps.
+
+    :param dataloaders: Dataloaders to load a batch from at every step.
+    :type dataloaders: list of SingleDataLoader
+
+    :param iterations: Number of steps. 0 runs a whole epoch, after resetting
+      the dataloaders and the metrics.
+    :type iterations: int
+
+    :param tracing_id: Legion trace id of the steps, or -1 to not trace them.
+    :type tracing_id: int
+
+    :param metrics_interval: Compute the metrics every this many steps, or never if 0.
+    :type metrics_interval: int
+
+    :param eval: Run forward passes and metrics only.
+    :type eval: bool
+
+    :param callback: Called as callback(iteration) with the number of steps run so
+      far, every :attr:`callback_interval` steps and after the last one. Returning
+      True stops the loop.
+    :type callback: function
+
+    :param callback_interval: Steps between two calls of :attr:`callback`.
+    :type callback_interval: int
+
+    :returns:  int -- the number of steps run.
+    """
+    c_dataloaders = ffi.new("flexflow_single_dataloader_t[]", len(dataloaders))
+    for i, d in enumerate(dataloaders):
+      c_dataloaders[i] = d.handle
+    if callback is None:
+      c_callback = ffi.NULL
+      callback_interval = 0
+    else:
+      c_callback = ffi.callback("bool(void *, int)", lambda user_data, iteration: bool(callback(iteration)))
+    return ffc.flexflow_model_run_loop(self.handle, c_dataloaders, len(dataloaders), iterations, tracing_id, metrics_interval, eval, callback_interval, c_callback, ffi.NULL)
+
+  def fit(self, x=None, y=None, batch_size=None, epochs=1, native_loop=True):
     """Trains the model for a fixed number of epochs (iterations on a dataset).
              
     :param x: Input data. It can be a Dataloader instance or a list of Dataloader instances.
@@ -2058,6 +2172,10 @@ class FFModel(object):
       An epoch is an iteration over the entire :attr:`x` and :attr:`y` data provided.
       The default value is 1.
     :type epochs: int
+
+    :param native_loop: Run the steps of each epoch in C++ (see :meth:`run_loop`)
+      instead of issuing every step from Python.
+    :type native_loop: bool
              
     :returns:  None -- no returns.
     """
@@ -2070,6 +2188,10 @@ class FFModel(object):
     num_samples = y.num_samples
     batch_size = self._ffconfig.batch_size
     self._tracing_id += 1 # get a new tracing id
+    if native_loop:
+      for epoch in range(0,epochs):
+        self.run_loop(dataloaders, tracing_id=self._tracing_id)
+      return
     for epoch in range(0,epochs):
       for d in dataloaders:
         d.reset()
@@ -2085,7 +2207,7 @@ class FFModel(object):
         self.update()
         self._ffconfig.end_trace(self._tracing_id)
           
-  def eval(self, x=None, y=None, batch_size=None):
+  def eval(self, x=None, y=None, batch_size=None, native_loop=True):
     """Returns the loss value & metrics values for the model in test mode. 
              
     :param x: Input data. It can be a Dataloader instance or a list of Dataloader instances.
@@ -2102,6 +2224,10 @@ class FFModel(object):
       An epoch is an iteration over the entire :attr:`x` and :attr:`y` data provided.
       The default value is 1.
     :type epochs: int
+
+    :param native_loop: Run the steps in C++ (see :meth:`run_loop`) instead of
+      issuing every step from Python.
+    :type native_loop: bool
              
     :returns:  None -- no returns.
     """
@@ -2113,6 +2239,10 @@ class FFModel(object):
 
     num_samples = y.num_samples
     batch_size = self._ffconfig.batch_size
+    if native_loop:
+      self._tracing_id += 1 # get a new tracing id
+      self.run_loop(dataloaders, tracing_id=self._tracing_id, eval=True)
+      return
     for d in dataloaders:
       d.reset()
     self.reset_metrics()
@@ -2162,6 +2292,38 @@ class FFModel(object):
     assert 0, f"Cannot find the layer with name {layer_name}"
     return None
 
+  def graph_ir_to_ff(self, buffer, input_tensors):
+    """Add all layers of a binary graph IR with a single C API call.
+
+    :param buffer: graph IR produced by :mod:`flexflow.graph_ir`.
+    :type buffer: bytes
+
+    :param input_tensors: tensors of the INPUT nodes, in order.
+    :type input_tensors: list of Tensor
+
+    :returns:  list of Tensor -- the tensors of the OUTPUT node.
+    """
+    max_outputs = max(graph_ir_num_nodes(buffer), 1)
+    name_size = 128 # MAX_OPNAME
+    c_inputs = ffi.new("flexflow_tensor_t[]", [t.handle for t in input_tensors])
+    c_outputs = ffi.new("flexflow_tensor_t[]", max_outputs)
+    c_num_outputs = ffi.new("int *")
+    c_layers = ffi.new("flexflow_op_t[]", max_outputs)
+    c_layer_op_types = ffi.new("int[]", max_outputs)
+    c_layer_names = ffi.new("char[]", max_outputs * name_size)
+    num_layers = ffc.flexflow_model_add_graph_ir(
+      self.handle, ffi.from_buffer(buffer), len(buffer),
+      len(input_tensors), c_inputs, max_outputs, c_outputs, c_num_outputs,
+      max_outputs, c_layers, c_layer_op_types, c_layer_names, name_size)
+    assert num_layers >= 0, "Invalid graph IR"
+    for i in range(num_layers):
+      op_type = int_to_enum(OpType, c_layer_op_types[i])
+      name = ffi.string(c_layer_names + i * name_size).decode("utf-8")
+      self._layers[self._nb_layers] = convert_op_handle_to_op(
+        op_type, c_layers[i], idx=self._nb_layers, name=name)
+      self._nb_layers += 1
+    return [Tensor(c_outputs[i]) for i in range(c_num_outputs[0])]
+
   def get_tensor_by_id(self, id):
     handle = ffc.flexflow_model_get_parameter_by_id(self.handle, id)
     return Parameter(handle)
@@ -0,0 +1,250 @@
+# Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+"""Binary graph IR shared by the PyTorch and ONNX front-ends.
+
+The binary IR encodes the same nodes as the string IR of the PyTorch
+front-end (one ``name; innodes; outnodes; OP_TYPE; params...`` line per node)
+and is turned into layers by a single C++ call, ``FFModel.graph_ir_to_ff()``,
+instead of one C API call per node. See ``include/flexflow/graph_ir.h`` for
+the format. Both forms convert into each other, so the string IR stays
+available for debugging.
+"""
+
+import struct
+
+from flexflow.type import OpType, enum_to_str, str_to_enum
+
+MAGIC = b"FFIR"
+VERSION = 1
+
+IR_DELIMITER = "; "
+INOUT_NODE_DELIMITER = ','
+
+PARAM_INT32 = 0
+PARAM_FLOAT = 1
+PARAM_STRING = 2
+PARAM_INT64 = 3
+
+# Op types the C++ builder supports; graphs with other nodes (e.g. attributes,
+# layer norms or expands) must go through the per-node path
+SUPPORTED_OP_TYPES = {
+    OpType.CONV2D, OpType.EMBEDDING, OpType.POOL2D, OpType.LINEAR,
+    OpType.SOFTMAX, OpType.CONCAT, OpType.FLAT, OpType.BATCH_NORM,
+    OpType.RELU, OpType.SIGMOID, OpType.TANH, OpType.ELU, OpType.DROPOUT,
+    OpType.BATCH_MATMUL, OpType.SPLIT, OpType.RESHAPE, OpType.TRANSPOSE,
+    OpType.ADD, OpType.SUBTRACT, OpType.MULTIPLY, OpType.POW, OpType.MEAN,
+    OpType.RSQRT, OpType.INPUT, OpType.OUTPUT, OpType.GETITEM,
+    OpType.IDENTITY, OpType.GELU, OpType.PERMUTE, OpType.SCALAR_MULTIPLY,
+    OpType.SCALAR_ADD, OpType.SCALAR_SUB, OpType.SCALAR_TRUEDIV, OpType.FLOAT,
+    OpType.CONTIGUOUS, OpType.TO, OpType.UNSQUEEZE, OpType.TYPE_AS,
+    OpType.VIEW, OpType.SLICE, OpType.PAD,
+}
+
+# Op types whose parameters must all be integers
+INT_PARAM_OP_TYPES = {
+    OpType.GETITEM, OpType.RESHAPE, OpType.PERMUTE, OpType.VIEW, OpType.SLICE,
+}
+
+
+def parse_param(s):
+    """Returns the typed value of a string IR parameter."""
+    try:
+        return int(s)
+    except ValueError:
+        pass
+    try:
+        return float(s)
+    except ValueError:
+        return s
+
+
+class GraphIRNode():
+    def __init__(self, name, op_type, innodes, outnodes, params):
+        self.name = name
+        self.op_type = op_type
+        self.innodes = list(innodes)
+        self.outnodes = list(outnodes)
+        self.params = list(params)
+
+    def ir_string(self):
+        s = [self.name]
+        if self.op_type == OpType.ATTRIBUTE:
+            s.append(enum_to_str(OpType, self.op_type))
+            return IR_DELIMITER.join(s)
+        for nodes in (self.innodes, self.outnodes):
+            s.append(
+                INOUT_NODE_DELIMITER.join(nodes) + INOUT_NODE_DELIMITER
+                if len(nodes) > 0 else ""
+            )
+        s.append(enum_to_str(OpType, self.op_type))
+        s += [str(p) for p in self.params]
+        return IR_DELIMITER.join(s)
+
+    @staticmethod
+    def from_ir_string(string):
+        items = [i.strip() for i in string.strip().split(';')]
+        if len(items) < 4:
+            assert len(items) == 2
+            return GraphIRNode(
+                items[0], str_to_enum(OpType, items[1]), [], [], [],
+            )
+
+        def get_inout_nodes(inout_string):
+            return [n.strip() for n in inout_string.split(INOUT_NODE_DELIMITER)
+                    if n.strip() != ""]
+
+        return GraphIRNode(
+            items[0], str_to_enum(OpType, items[3]),
+            get_inout_nodes(items[1]), get_inout_nodes(items[2]),
+            [parse_param(p) for p in items[4:]],
+        )
+
+
+class GraphIRWriter():
+    """Accumulates nodes in topological order and encodes them."""
+    def __init__(self):
+        self.nodes = []
+
+    def add_node(self, name, op_type, innodes, outnodes=(), params=()):
+        self.nodes.append(
+            GraphIRNode(name, op_type, innodes, outnodes, params)
+        )
+
+    def add_ir_string(self, string):
+        self.nodes.append(GraphIRNode.from_ir_string(string))
+
+    def check_supported(self):
+        """Raises ``NotImplementedError`` if the C++ builder cannot import
+        the graph."""
+        for node in self.nodes:
+            if node.op_type not in SUPPORTED_OP_TYPES:
+                raise NotImplementedError(
+                    f"Graph IR does not support {node.name} "
+                    f"({enum_to_str(OpType, node.op_type)})"
+                )
+            if node.op_type in INT_PARAM_OP_TYPES and \
+                    any(type(p) is not int for p in node.params):
+                raise NotImplementedError(
+                    f"Graph IR does not support {node.name} "
+                    f"({enum_to_str(OpType, node.op_type)}) with parameters "
+                    f"{node.params}"
+                )
+
+    def to_bytes(self):
+        index = {node.name: i for i, node in enumerate(self.nodes)}
+        out = [struct.pack("<4sII", MAGIC, VERSION, len(self.nodes))]
+        for i, node in enumerate(self.nodes):
+            name = node.name.encode("utf-8")
+            out.append(struct.pack(
+                f"<HH{len(name)}s", node.op_type.value, len(name), name,
+            ))
+            for n in node.innodes:
+                if index.get(n, i) >= i:
+                    raise NotImplementedError(
+                        f"Input {n} of {node.name} is not an earlier node"
+                    )
+            ins = [index[n] for n in node.innodes]
+            outs = [index[n] for n in node.outnodes if n in index]
+            for ids in (ins, outs):
+                out.append(struct.pack(f"<H{len(ids)}I", len(ids), *ids))
+            out.append(struct.pack("<B", len(node.params)))
+            for p in node.params:
+                if type(p) is int and -2**31 <= p < 2**31:
+                    out.append(struct.pack("<Bi", PARAM_INT32, p))
+                elif type(p) is int:
+                    out.append(struct.pack("<Bq", PARAM_INT64, p))
+                elif type(p) is float:
+                    out.append(struct.pack("<Bd", PARAM_FLOAT, p))
+                else:
+                    s = str(p).encode("utf-8")
+                    out.append(struct.pack(
+                        f"<BH{len(s)}s", PARAM_STRING, len(s), s,
+                    ))
+        return b"".join(out)
+
+
+def is_graph_ir(buffer):
+    return buffer[:len(MAGIC)] == MAGIC
+
+
+def graph_ir_num_nodes(buffer):
+    """Reads the number of nodes from the header of a binary graph IR."""
+    assert is_graph_ir(buffer), "Not a FlexFlow graph IR"
+    return struct.unpack_from("<4sII", buffer, 0)[2]
+
+
+def strings_to_graph_ir(strings):
+    """Encodes string IR lines as a binary graph IR."""
+    writer = GraphIRWriter()
+    for string in strings:
+        writer.add_ir_string(string)
+    writer.check_supported()
+    return writer.to_bytes()
+
+
+def graph_ir_to_nodes(buffer):
+    """Decodes a binary graph IR into a list of ``GraphIRNode``."""
+    assert is_graph_ir(buffer), "Not a FlexFlow graph IR"
+    _, version, num_nodes = struct.unpack_from("<4sII", buffer, 0)
+    assert version == VERSION, f"Unsupported graph IR version {version}"
+    offset = struct.calcsize("<4sII")
+    raw = []
+    for _ in range(num_nodes):
+        op_type, name_len = struct.unpack_from("<HH", buffer, offset)
+        offset += 4
+        name = buffer[offset:offset + name_len].decode("utf-8")
+        offset += name_len
+        inout = []
+        for _ in range(2):
+            (n,) = struct.unpack_from("<H", buffer, offset)
+            offset += 2
+            inout.append(struct.unpack_from(f"<{n}I", buffer, offset))
+            offset += 4 * n
+        (num_params,) = struct.unpack_from("<B", buffer, offset)
+        offset += 1
+        params = []
+        for _ in range(num_params):
+            (kind,) = struct.unpack_from("<B", buffer, offset)
+            offset += 1
+            if kind == PARAM_INT32:
+                (p,) = struct.unpack_from("<i", buffer, offset)
+                offset += 4
+            elif kind == PARAM_INT64:
+                (p,) = struct.unpack_from("<q", buffer, offset)
+                offset += 8
+            elif kind == PARAM_FLOAT:
+                (p,) = struct.unpack_from("<d", buffer, offset)
+                offset += 8
+            else:
+                assert kind == PARAM_STRING, f"Unknown parameter kind {kind}"
+                (n,) = struct.unpack_from("<H", buffer, offset)
+                offset += 2
+                p = buffer[offset:offset + n].decode("utf-8")
+                offset += n
+            params.append(p)
+        raw.append((name, OpType(op_type), inout[0], inout[1], params))
+    assert offset == len(buffer), "Trailing bytes after the graph IR"
+    names = [r[0] for r in raw]
+    return [
+        GraphIRNode(name, op_type, [names[i] for i in ins],
+                    [names[i] for i in outs], params)
+        for name, op_type, ins, outs, params in raw
+    ]
+
+
+def graph_ir_to_strings(buffer):
+    """Decodes a binary graph IR into string IR lines, for debugging."""
+    return [node.ir_string() for node in graph_ir_to_nodes(buffer)]
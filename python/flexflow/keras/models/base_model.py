@@ -391,36 +391,12 @@ class BaseModel(object):
         for callback in callbacks:
           callback.on_epoch_begin(epoch)
 
-      for dataloader in self._input_dataloaders:
-        dataloader.reset()
-      self._label_dataloader.reset()
-      self._ffmodel.reset_metrics()
       iterations = self._num_samples / self._ffconfig.batch_size
-
-      for iter in range(0, int(iterations)):
-        if callbacks != None:
-          for callback in callbacks:
-            callback.on_batch_begin(iter)
-
-        self._ffconfig.begin_trace(self.__tracing_id)
-        for dataloader in self._input_dataloaders:
-          dataloader.next_batch(self._ffmodel)
-        self._label_dataloader.next_batch(self._ffmodel)
-
-        self._ffmodel.forward()
-        # for layer in self._layers:
-        #   layer.ffhandle.forward(self._ffmodel)
-        if eval == False:
-          self._ffmodel.zero_gradients()
-          self._ffmodel.backward()
-          self._ffmodel.update()
-        else:
-          self._ffmodel.compute_metrics()
-        self._ffconfig.end_trace(self.__tracing_id)
-
-        if callbacks != None:
-          for callback in callbacks:
-            callback.on_batch_end(iter)
+      if hasattr(self._ffmodel, "run_loop"):
+        self.__run_native_loop(int(iterations), eval, callbacks)
+      else:
+        # The pybind11 bindings have no native loop
+        self.__run_python_loop(int(iterations), eval, callbacks)
 
       if callbacks != None:
         for callback in callbacks:
@@ -452,6 +428,59 @@ class BaseModel(object):
     # print(label_array)
     # self._label_tensor.ffhandle.inline_unmap(self._ffconfig)
 
+  def __run_native_loop(self, iterations, eval, callbacks):
+    # The steps of the epoch run in C++; only go back to Python between
+    # steps if a callback needs it
+    batch_callbacks = []
+    if callbacks != None:
+      batch_callbacks = [callback for callback in callbacks
+                         if type(callback).on_batch_begin is not Callback.on_batch_begin
+                         or type(callback).on_batch_end is not Callback.on_batch_end]
+    if len(batch_callbacks) > 0:
+      for callback in batch_callbacks:
+        callback.on_batch_begin(0)
+      def on_step(step):
+        for callback in batch_callbacks:
+          callback.on_batch_end(step - 1)
+        if step < iterations:
+          for callback in batch_callbacks:
+            callback.on_batch_begin(step)
+        return False
+      self._ffmodel.run_loop(self._input_dataloaders + [self._label_dataloader],
+                             tracing_id=self.__tracing_id, eval=eval,
+                             callback=on_step, callback_interval=1)
+    else:
+      self._ffmodel.run_loop(self._input_dataloaders + [self._label_dataloader],
+                             tracing_id=self.__tracing_id, eval=eval)
+
+  def __run_python_loop(self, iterations, eval, callbacks):
+    for dataloader in self._input_dataloaders:
+      dataloader.reset()
+    self._label_dataloader.reset()
+    self._ffmodel.reset_metrics()
+    for iter in range(0, iterations):
+      if callbacks != None:
+        for callback in callbacks:
+          callback.on_batch_begin(iter)
+
+      self._ffconfig.begin_trace(self.__tracing_id)
+      for dataloader in self._input_dataloaders:
+        dataloader.next_batch(self._ffmodel)
+      self._label_dataloader.next_batch(self._ffmodel)
+
+      self._ffmodel.forward()
+      if eval == False:
+        self._ffmodel.zero_gradients()
+        self._ffmodel.backward()
+        self._ffmodel.update()
+      else:
+        self._ffmodel.compute_metrics()
+      self._ffconfig.end_trace(self.__tracing_id)
+
+      if callbacks != None:
+        for callback in callbacks:
+          callback.on_batch_end(iter)
+
   def _create_flexflow_layers(self):
     out_t = 0
 
@@ -16,8 +16,11 @@
 import logging
 import onnx
 import struct
+from onnx import numpy_helper
 from flexflow.core import ActiMode
-from flexflow.core import PoolType, DataType
+from flexflow.core import PoolType, DataType, Tensor
+from flexflow.graph_ir import GraphIRWriter
+from flexflow.type import OpType, enum_to_int
 
 # logging.basicConfig(level=logging.DEBUG)
 
@@ -226,11 +229,71 @@ class ONNXModel(object):
         self.symbol_table[node.output[0]] = output
         logging.debug("ffmodel.relu({})".format(node.input[0]))
 
+    def _initializer_values(self, name):
+        for initializer in self.model.graph.initializer:
+            if initializer.name == name:
+                return numpy_helper.to_array(initializer).flatten().tolist()
+        raise NotImplementedError("{} is not an initializer".format(name))
+
+    def _pad_params(self, node):
+        """Returns the pads before and after each dim and the value."""
+        attribute = {x.name: x for x in node.attribute}
+        if 'mode' in attribute and attribute['mode'].s != b'constant':
+            raise NotImplementedError("Pad {} is not constant".format(node.name))
+        if 'pads' in attribute:
+            pads = list(attribute['pads'].ints)
+            value = attribute['value'].f if 'value' in attribute else 0.0
+        else:
+            pads = self._initializer_values(node.input[1])
+            value = 0.0
+            if len(node.input) > 2 and node.input[2] != '':
+                value = float(self._initializer_values(node.input[2])[0])
+        n = len(pads) // 2
+        return pads[:n], pads[n:], value
+
+    def _slice_params(self, node):
+        """Returns the (axis, start, end) of each sliced dim."""
+        attribute = {x.name: x for x in node.attribute}
+        if 'starts' in attribute:
+            starts = list(attribute['starts'].ints)
+            ends = list(attribute['ends'].ints)
+            axes = list(attribute['axes'].ints) if 'axes' in attribute else list(range(len(starts)))
+        else:
+            starts = self._initializer_values(node.input[1])
+            ends = self._initializer_values(node.input[2])
+            axes = list(range(len(starts)))
+            if len(node.input) > 3 and node.input[3] != '':
+                axes = self._initializer_values(node.input[3])
+            if len(node.input) > 4 and node.input[4] != '':
+                if any(step != 1 for step in self._initializer_values(node.input[4])):
+                    raise NotImplementedError("Strided slice {}".format(node.name))
+        # ONNX uses INT64_MAX for "until the end"
+        ends = [min(end, 2**31 - 1) for end in ends]
+        starts = [max(start, -2**31) for start in starts]
+        return [(axes[i], starts[i], ends[i]) for i in range(len(axes))]
+
     def handlePad(self, ffmodel, node):
         input = self.symbol_table[node.input[0]]
-        output = input
+        pads_before, pads_after, value = self._pad_params(node)
+        output = ffmodel.pad(input, pads_before, pads_after, value, name=node.name)
+        self.symbol_table[node.output[0]] = output
+        logging.debug("ffmodel.pad({}, {}, {}, {})".format(node.input[0], pads_before, pads_after, value))
+
+    def handleSlice(self, ffmodel, node):
+        input = self.symbol_table[node.input[0]]
+        num_dims = input.num_dims
+        starts, ends = [], []
+        for axis, start, end in self._slice_params(node):
+            if axis < 0:
+                axis += num_dims
+            while len(starts) <= axis:
+                starts.append(0)
+                ends.append(2**31 - 1)
+            starts[axis] = start
+            ends[axis] = end
+        output = ffmodel.slice(input, starts, ends, name=node.name)
         self.symbol_table[node.output[0]] = output
-        logging.warn("pass-through pad")
+        logging.debug("ffmodel.slice({}, {}, {})".format(node.input[0], starts, ends))
 
     def handleSoftmax(self, ffmodel, node):
         input = self.symbol_table[node.input[0]]
@@ -284,8 +347,162 @@ class ONNXModel(object):
         self.symbol_table[node.output[0]] = start
         logging.warning("Not implemented handle: {}".format(node.op_type))
 
-    def apply(self, ffmodel, input_dict):
+    def _ir_inputs(self, node):
+        return [self.ir_table[i] for i in node.input if i in self.ir_table]
+
+    def _ir_add_node(self, writer, node, op_type, params=(), num_inputs=1):
+        # Name the IR node like the layer the per-node path would create
+        name = node.name if node.name else node.output[0]
+        if name in self.ir_names:
+            raise NotImplementedError("Duplicate node name {}".format(name))
+        self.ir_names.add(name)
+        writer.add_node(name, op_type, self._ir_inputs(node)[:num_inputs], params=params)
+        self.ir_table[node.output[0]] = name
+
+    def _ir_pool_params(self, node, pool_type):
+        attribute = {x.name: x for x in node.attribute}
+        kernel = attribute["kernel_shape"].ints
+        stride = attribute["strides"].ints
+        if "pads" in attribute:
+            padding = attribute["pads"].ints
+        elif "auto_pad" in attribute and attribute["auto_pad"].s == b'VALID':
+            padding = [0, 0]
+        else:
+            raise NotImplementedError("Unsupported padding of {}".format(node.name))
+        if kernel[0] != kernel[1] or stride[0] != stride[1] or padding[0] != padding[1]:
+            raise NotImplementedError("Non-square pooling {}".format(node.name))
+        return [kernel[0], stride[0], padding[0], enum_to_int(PoolType, pool_type),
+                enum_to_int(ActiMode, ActiMode.AC_MODE_NONE)]
+
+    def encodeAdd(self, writer, node):
+        self._ir_add_node(writer, node, OpType.ADD, num_inputs=2)
+
+    def encodeSub(self, writer, node):
+        self._ir_add_node(writer, node, OpType.SUBTRACT, num_inputs=2)
+
+    def encodeMul(self, writer, node):
+        self._ir_add_node(writer, node, OpType.MULTIPLY, num_inputs=2)
+
+    def encodeConcat(self, writer, node):
+        attribute = {x.name: x for x in node.attribute}
+        self._ir_add_node(writer, node, OpType.CONCAT, [attribute['axis'].i],
+                          num_inputs=len(node.input))
+
+    def encodeSplit(self, writer, node):
+        attribute = {x.name: x for x in node.attribute}
+        if 'split' not in attribute:
+            raise NotImplementedError("Split {} without sizes".format(node.name))
+        axis = attribute['axis'].i if 'axis' in attribute else 0
+        self._ir_add_node(writer, node, OpType.SPLIT, [axis] + list(attribute['split'].ints))
+        split_name = self.ir_table[node.output[0]]
+        for i, output in enumerate(node.output):
+            if output in self.ir_names:
+                raise NotImplementedError("Duplicate node name {}".format(output))
+            self.ir_names.add(output)
+            writer.add_node(output, OpType.GETITEM, [split_name], params=[i])
+            self.ir_table[output] = output
+
+    def encodeAveragePool(self, writer, node):
+        self._ir_add_node(writer, node, OpType.POOL2D,
+                          self._ir_pool_params(node, PoolType.POOL_AVG))
+
+    def encodeMaxPool(self, writer, node):
+        self._ir_add_node(writer, node, OpType.POOL2D,
+                          self._ir_pool_params(node, PoolType.POOL_MAX))
+
+    def encodeBatchNormalization(self, writer, node):
+        self._ir_add_node(writer, node, OpType.BATCH_NORM)
+
+    def encodeConv(self, writer, node):
+        attribute = {x.name: x for x in node.attribute}
+        kernel = attribute["kernel_shape"].ints
+        stride = attribute["strides"].ints
+        if "pads" in attribute:
+            padding = attribute["pads"].ints
+        elif "auto_pad" in attribute and attribute["auto_pad"].s == b'VALID':
+            padding = [0, 0]
+        else:
+            raise NotImplementedError("Unsupported padding of {}".format(node.name))
+        out_channels = self.inputs[node.input[1]].dims[0]
+        params = [out_channels, kernel[0], kernel[1], stride[0], stride[1],
+                  padding[0], padding[1], enum_to_int(ActiMode, ActiMode.AC_MODE_NONE),
+                  attribute["group"].i, 1]
+        self._ir_add_node(writer, node, OpType.CONV2D, params)
+
+    def encodeDropout(self, writer, node):
+        attribute = {x.name: x for x in node.attribute}
+        self._ir_add_node(writer, node, OpType.DROPOUT, [float(attribute["ratio"].f)])
+
+    def encodeFlatten(self, writer, node):
+        self._ir_add_node(writer, node, OpType.FLAT)
+
+    def encodeDense(self, writer, node):
+        attribute = {x.name: x for x in node.attribute}
+        params = [attribute["out_dim"].i, enum_to_int(ActiMode, ActiMode.AC_MODE_NONE), 1]
+        self._ir_add_node(writer, node, OpType.LINEAR, params)
+
+    def encodeRelu(self, writer, node):
+        self._ir_add_node(writer, node, OpType.RELU)
+
+    def encodeSoftmax(self, writer, node):
+        self._ir_add_node(writer, node, OpType.SOFTMAX)
+
+    def encodeReshape(self, writer, node):
+        shape = {x.name: x for x in self.model.graph.initializer}.get(node.input[1])
+        if shape is None:
+            raise NotImplementedError("Reshape {} to a computed shape".format(node.name))
+        shape = list(numpy_helper.to_array(shape))
+        if any(d <= 0 for d in shape):
+            raise NotImplementedError("Reshape {} to {}".format(node.name, shape))
+        self._ir_add_node(writer, node, OpType.RESHAPE, [int(d) for d in shape])
+
+    def encodePassThrough(self, writer, node):
+        self.ir_table[node.output[0]] = self.ir_table[node.input[0]]
+
+    def encodePad(self, writer, node):
+        pads_before, pads_after, value = self._pad_params(node)
+        self._ir_add_node(writer, node, OpType.PAD, pads_before + pads_after + [float(value)])
+
+    def encodeSlice(self, writer, node):
+        params = []
+        for axis, start, end in self._slice_params(node):
+            params += [axis, start, end]
+        self._ir_add_node(writer, node, OpType.SLICE, params)
+
+    encodeCast = encodePassThrough
+    encodeUnsqueeze = encodePassThrough
+
+    def to_graph_ir(self, input_names):
+        """Encodes the graph as a binary graph IR; raises
+        ``NotImplementedError`` if a node is not supported."""
+        writer = GraphIRWriter()
+        self.ir_table = {}
+        self.ir_names = set()
+        for name in input_names:
+            writer.add_node(name, OpType.INPUT, [])
+            self.ir_table[name] = name
+            self.ir_names.add(name)
+        for node in self.model.graph.node:
+            encoder_name = 'encode' + node.op_type
+            if not hasattr(self, encoder_name):
+                raise NotImplementedError("Graph IR does not support {}".format(node.op_type))
+            getattr(self, encoder_name)(writer, node)
+        output = self.model.graph.output[0].name
+        writer.add_node("output", OpType.OUTPUT, [self.ir_table[output]])
+        writer.check_supported()
+        return writer.to_bytes()
+
+    def apply(self, ffmodel, input_dict, use_graph_ir=True):
         self._fusion()
+        if use_graph_ir and all(isinstance(t, Tensor) for t in input_dict.values()):
+            # Add all layers with a single call when every node is supported
+            try:
+                buffer = self.to_graph_ir(list(input_dict.keys()))
+            except NotImplementedError as e:
+                logging.debug("Falling back to per-node import: {}".format(e))
+                buffer = None
+            if buffer is not None:
+                return ffmodel.graph_ir_to_ff(buffer, list(input_dict.values()))[0]
         self.symbol_table.update(input_dict)
         # self.symbol_table = input_dict.copy()
         # for initializer in self.model.graph.initializer:
@@ -363,6 +580,11 @@ class ONNXModelKeras(ONNXModel):
     def handleReshape(self, ffmodel, node):
         print("########################################I am in Keras Reshape")
         self.handleFlatten(ffmodel, node)
+
+    encodeTranspose = ONNXModel.encodePassThrough
+
+    def encodeReshape(self, writer, node):
+        self.encodeFlatten(writer, node)
     
     def _create_initializer_tensor(self, ffconfig, ffmodel, input):
         if len(input.dims) == 1:
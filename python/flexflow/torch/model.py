@@ -20,6 +20,8 @@ import copy
 
 import numpy as np
 from flexflow.core.flexflow_cffi import Tensor, NormInitializer
+from flexflow.graph_ir import (graph_ir_to_strings, is_graph_ir,
+                               strings_to_graph_ir)
 from flexflow.type import (ActiMode, AggrMode, DataType, OpType,
                            ParameterSyncType, PoolType, enum_to_int,
                            enum_to_str, int_to_enum, str_to_enum)
@@ -1442,6 +1444,10 @@ class GetItemNode(FunctionNode):
         new_shape = []  # append then reverse                                                                  
         j = len(shape) - 1
         curr_tensor = copy.copy(tensor)
+        # The window of the input kept by the slices, taken by a single
+        # slice layer
+        starts = [0] * len(shape)
+        ends = list(shape)
 
         for slice_elem in reversed(slices):
             if is_colon(slice_elem):
@@ -1452,34 +1458,25 @@ class GetItemNode(FunctionNode):
                 new_shape.append(1)
             elif is_single_element(slice_elem):
                 assert j >= 0
-                splits = [1, shape[j] - 1]
-                curr_tensor = ffmodel.split(input=curr_tensor, sizes=splits, axis=j, name=name)[0]
+                index = slice_elem + shape[j] if slice_elem < 0 else slice_elem
+                starts[j] = index
+                ends[j] = index + 1
                 new_shape.append(1)
                 j -= 1
             elif is_truncate(slice_elem, shape[j]):
                 assert j >= 0
-                start = 0 if slice_elem.start == None else slice_elem.start
-                stop = shape[j] if slice_elem.stop == None else slice_elem.stop
-                splits = []
-                # create splits    
-                if start > 0 and stop == shape[j]: # truncation from left
-                    splits.append(start)
-                    splits.append(stop - start)
-                    curr_tensor = ffmodel.split(input=curr_tensor, sizes=splits, axis=j, name=name)[1]
-                elif start == 0 and stop < shape[j]: # truncation from right
-                    splits.append(stop)
-                    splits.append(shape[j] - stop)
-                    curr_tensor = ffmodel.split(input=curr_tensor, sizes=splits, axis=j, name=name)[0]
-                elif start > 0 and stop < shape[j]: # truncation from left and right
-                    splits.append(start)
-                    splits.append(stop - start)
-                    splits.append(shape[j] - stop)
-                    curr_tensor = ffmodel.split(input=curr_tensor, sizes=splits, axis=j, name=name)[1]
+                start, stop, step = slice_elem.indices(shape[j])
+                assert step == 1, f"Unsupported slice step: {slice_elem}"
+                starts[j] = start
+                ends[j] = stop
                 new_shape.append(stop - start)
                 j -= 1
             else:
                 assert 0, f"Unsupported slice element: {slice_elem}"
 
+        if starts != [0] * len(shape) or ends != list(shape):
+            curr_tensor = ffmodel.slice(curr_tensor, starts, ends, name=name)
+
         new_shape.reverse()
         return ffmodel.reshape(input=curr_tensor, shape=new_shape, name=name,)
             
@@ -2030,7 +2027,7 @@ class MeanNode(FunctionNode):
             dims[0] = len(input_tensor.dims) - 1
         assert dims[0] >= 0 and dims[0] < len(input_tensor.dims)
         if len(items) >= 6:
-            keepdims = bool(items[5])
+            keepdims = items[5] == "True"
         else:
             keepdims = False
         return ffmodel.mean(
@@ -2493,7 +2490,9 @@ class PyTorchModel():
             i += 1
         return layer_norm_graph
 
-    def torch_to_ff(self, ffmodel, input_tensors, verbose=False):
+    def torch_to_ff(
+        self, ffmodel, input_tensors, verbose=False, use_graph_ir=True,
+    ):
         """
         Traces the PyTorch model wrapped by this ``PyTorchModel`` instance,
         and adds operators to ``ffmodel`` coresponding to the computational
@@ -2506,6 +2505,10 @@ class PyTorchModel():
             verbose (bool, optional): If ``True``, then prints the string
                 representation of each computational graph node. Default:
                 ``False``.
+            use_graph_ir (bool, optional): If ``True``, then adds all
+                operators with a single call through the binary graph IR
+                when every node supports it, and falls back to one call per
+                node otherwise. Default: ``True``.
 
         Returns:
             output_tensors (List[Tensor]): Output tensors of the model.
@@ -2514,6 +2517,19 @@ class PyTorchModel():
             "FlexFlow cannot work with CUDA version of PyTorch; " \
             "please install the CPU version."
         graph = self._trace_model()
+        if use_graph_ir:
+            try:
+                buffer = strings_to_graph_ir(
+                    [node.ir_string for node in graph]
+                )
+            except NotImplementedError:
+                buffer = None
+            if buffer is not None:
+                if verbose:
+                    for string in graph_ir_to_strings(buffer):
+                        print(string)
+                return ffmodel.graph_ir_to_ff(buffer, input_tensors)
+
         output_tensors = []
         node_to_output = OrderedDict()
         input_index = 0
@@ -2541,13 +2557,17 @@ class PyTorchModel():
         """
         Args:
             filename (string): Name of the file from which to load the model
-                information; should be the output of :meth:`torch_to_file`.
+                information; should be the output of :meth:`torch_to_file`,
+                either as string IR or as binary graph IR.
             ffmodel (FFModel): ``FFModel`` to which to add operators
                 corresponding to the computational graph nodes.
             input_tensors (List[Tensor]): Input tensors to the model.
         """
-        with open(filename, "r") as f:
-            lines = f.readlines()
+        with open(filename, "rb") as f:
+            buffer = f.read()
+        if is_graph_ir(buffer):
+            return ffmodel.graph_ir_to_ff(buffer, input_tensors)
+        lines = buffer.decode("utf-8").splitlines()
 
         output_tensors = []
         node_to_output = {}
@@ -2594,9 +2614,23 @@ class PyTorchModel():
         s = [node.ir_string for node in graph]
         return s
 
-    def torch_to_file(self, filename):
+    def torch_to_graph_ir(self):
+        """
+        Returns:
+            buffer (bytes): Binary graph IR of the computational graph; see
+                :mod:`flexflow.graph_ir`. Raises ``NotImplementedError`` if
+                a node is not supported by the binary graph IR.
+        """
+        return strings_to_graph_ir(self.torch_to_string())
+
+    def torch_to_file(self, filename, binary=False):
         """Writes the result of :meth:`torch_to_string` to the file given by
-        ``filename``."""
+        ``filename``, or the result of :meth:`torch_to_graph_ir` if
+        ``binary`` is ``True``."""
+        if binary:
+            with open(filename, "wb") as f:
+                f.write(self.torch_to_graph_ir())
+            return
         s = self.torch_to_string()
         with open(filename, "w") as f:
             for line in s:
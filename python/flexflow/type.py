@@ -108,6 +108,8 @@ class OpType(Enum):
   TYPE_AS = 2104
   VIEW = 2105
   GATHER = 2106
+  SLICE = 2107
+  PAD = 2108
   ATTRIBUTE = 2200
 def enum_to_int(enum, enum_item):
   for item in enum:
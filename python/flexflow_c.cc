@@ -14,8 +14,11 @@
  */
 
 #include "flexflow_c.h"
+#include "flexflow/graph_ir.h"
 #include "flexflow/mapper.h"
 #include "flexflow_dataloader.h"
+#include <algorithm>
+#include <cstring>
 
 using namespace Legion;
 using namespace FlexFlow;
@@ -759,6 +762,52 @@ flexflow_tensor_t flexflow_model_add_transpose(flexflow_model_t handle_,
   return FFCObjectWrapper::wrap(tensor);
 }
 
+flexflow_tensor_t flexflow_model_add_slice(flexflow_model_t handle_,
+                                           const flexflow_tensor_t input_,
+                                           int n,
+                                           int *starts,
+                                           int *ends,
+                                           char const *name) {
+  FFModel *handle = FFCObjectWrapper::unwrap(handle_);
+  Tensor input = FFCObjectWrapper::unwrap(input_);
+  std::vector<int> starts_vec, ends_vec;
+  for (int i = 0; i < n; i++) {
+    starts_vec.push_back(starts[i]);
+    ends_vec.push_back(ends[i]);
+  }
+  Tensor tensor = handle->slice(input, starts_vec, ends_vec, name);
+  DEBUG_PRINT("[Slice] new Tensor %p, input %p, n %d, name %s",
+              tensor,
+              input,
+              n,
+              name);
+  return FFCObjectWrapper::wrap(tensor);
+}
+
+flexflow_tensor_t flexflow_model_add_pad(flexflow_model_t handle_,
+                                         const flexflow_tensor_t input_,
+                                         int n,
+                                         int *pads_before,
+                                         int *pads_after,
+                                         float value,
+                                         char const *name) {
+  FFModel *handle = FFCObjectWrapper::unwrap(handle_);
+  Tensor input = FFCObjectWrapper::unwrap(input_);
+  std::vector<int> before_vec, after_vec;
+  for (int i = 0; i < n; i++) {
+    before_vec.push_back(pads_before[i]);
+    after_vec.push_back(pads_after[i]);
+  }
+  Tensor tensor = handle->pad(input, before_vec, after_vec, value, name);
+  DEBUG_PRINT("[Pad] new Tensor %p, input %p, n %d, value %f, name %s",
+              tensor,
+              input,
+              n,
+              value,
+              name);
+  return FFCObjectWrapper::wrap(tensor);
+}
+
 flexflow_tensor_t flexflow_model_add_reshape(flexflow_model_t handle_,
                                              const flexflow_tensor_t input_,
                                              int n,
@@ -1029,6 +1078,54 @@ flexflow_op_t flexflow_model_get_last_layer(flexflow_model_t handle_) {
   return FFCObjectWrapper::wrap(layer);
 }
 
+int flexflow_model_add_graph_ir(flexflow_model_t handle_,
+                                char const *buffer,
+                                int64_t size,
+                                int num_inputs,
+                                flexflow_tensor_t *inputs_,
+                                int max_outputs,
+                                flexflow_tensor_t *outputs_,
+                                int *num_outputs,
+                                int max_layers,
+                                flexflow_op_t *layers_,
+                                int *layer_op_types,
+                                char *layer_names,
+                                int name_size) {
+  FFModel *handle = FFCObjectWrapper::unwrap(handle_);
+  GraphIR::Graph graph;
+  if (!GraphIR::Graph::deserialize(buffer, size, graph)) {
+    ffc_log.error("Invalid graph IR of %lld bytes", (long long)size);
+    return -1;
+  }
+  std::vector<Tensor> inputs, outputs;
+  for (int i = 0; i < num_inputs; i++) {
+    inputs.push_back(FFCObjectWrapper::unwrap(inputs_[i]));
+  }
+  std::vector<GraphIR::LayerInfo> layers;
+  size_t first_layer = handle->layers.size();
+  GraphIR::build(*handle, graph, inputs, outputs, layers);
+  assert((int)outputs.size() <= max_outputs);
+  assert((int)layers.size() <= max_layers);
+  assert(name_size > 0);
+  for (size_t i = 0; i < outputs.size(); i++) {
+    outputs_[i] = FFCObjectWrapper::wrap(outputs[i]);
+  }
+  *num_outputs = outputs.size();
+  for (size_t i = 0; i < layers.size(); i++) {
+    layers_[i] = FFCObjectWrapper::wrap(handle->layers[first_layer + i]);
+    layer_op_types[i] = layers[i].op_type;
+    // Name of the node that added the layer, as the per-node path names it
+    char *name = layer_names + i * name_size;
+    std::strncpy(name, graph.nodes[layers[i].node].name.c_str(), name_size);
+    name[name_size - 1] = '\0';
+  }
+  DEBUG_PRINT("[GraphIR] %zu nodes, %zu layers, %zu outputs",
+              graph.nodes.size(),
+              layers.size(),
+              outputs.size());
+  return layers.size();
+}
+
 flexflow_tensor_t flexflow_model_get_parameter_by_id(flexflow_model_t handle_,
                                                      int layer_id) {
   assert(false);
@@ -1721,6 +1818,74 @@ void flowflow_single_dataloader_next_batch(flexflow_single_dataloader_t handle_,
   handle->next_batch(*ffmodel);
 }
 
+// -----------------------------------------------------------------------
+// Training loop
+// -----------------------------------------------------------------------
+
+int flexflow_model_run_loop(flexflow_model_t handle_,
+                            flexflow_single_dataloader_t *dataloaders_,
+                            int num_dataloaders,
+                            int num_iterations,
+                            int trace_id,
+                            int metrics_interval,
+                            bool eval,
+                            int callback_interval,
+                            flexflow_loop_callback_t callback,
+                            void *user_data) {
+  FFModel *handle = FFCObjectWrapper::unwrap(handle_);
+  Runtime *runtime = handle->config.lg_hlr;
+  Context ctx = handle->config.lg_ctx;
+  std::vector<SingleDataLoader *> dataloaders;
+  for (int i = 0; i < num_dataloaders; i++) {
+    dataloaders.push_back(FFCObjectWrapper::unwrap(dataloaders_[i]));
+  }
+  if (num_iterations <= 0) {
+    assert(!dataloaders.empty());
+    int num_samples = dataloaders[0]->num_samples;
+    for (SingleDataLoader *dataloader : dataloaders) {
+      num_samples = std::min(num_samples, dataloader->num_samples);
+      dataloader->reset();
+    }
+    handle->reset_metrics();
+    num_iterations = num_samples / handle->config.batchSize;
+  }
+  int iter = 0;
+  while (iter < num_iterations) {
+    bool with_metrics =
+        metrics_interval > 0 && (iter + 1) % metrics_interval == 0;
+    // A trace must replay the same operations: only trace the steps with
+    // the most common shape
+    bool traced = trace_id >= 0 && (!with_metrics || metrics_interval == 1);
+    if (traced) {
+      runtime->begin_trace(ctx, trace_id);
+    }
+    for (SingleDataLoader *dataloader : dataloaders) {
+      dataloader->next_batch(*handle);
+    }
+    handle->forward();
+    if (eval) {
+      if (with_metrics) {
+        handle->compute_metrics();
+      }
+    } else {
+      handle->zero_gradients();
+      handle->backward(-1 /*seq_length*/, with_metrics);
+      handle->update();
+    }
+    if (traced) {
+      runtime->end_trace(ctx, trace_id);
+    }
+    iter++;
+    if (callback != NULL && callback_interval > 0 &&
+        (iter % callback_interval == 0 || iter == num_iterations)) {
+      if (callback(user_data, iter)) {
+        break;
+      }
+    }
+  }
+  return iter;
+}
+
 // -----------------------------------------------------------------------
 // Timer
 // -----------------------------------------------------------------------
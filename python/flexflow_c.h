@@ -284,6 +284,21 @@ flexflow_tensor_t flexflow_model_add_transpose(flexflow_model_t handle,
                                                int *perm,
                                                char const *name);
 
+flexflow_tensor_t flexflow_model_add_slice(flexflow_model_t handle,
+                                           const flexflow_tensor_t input,
+                                           int n,
+                                           int *starts,
+                                           int *ends,
+                                           char const *name);
+
+flexflow_tensor_t flexflow_model_add_pad(flexflow_model_t handle,
+                                         const flexflow_tensor_t input,
+                                         int n,
+                                         int *pads_before,
+                                         int *pads_after,
+                                         float value,
+                                         char const *name);
+
 flexflow_tensor_t flexflow_model_add_reshape(flexflow_model_t handle,
                                              const flexflow_tensor_t input,
                                              int n,
@@ -382,6 +397,24 @@ flexflow_op_t flexflow_model_get_layer_by_id(flexflow_model_t handle,
 
 flexflow_op_t flexflow_model_get_last_layer(flexflow_model_t handle);
 
+// Adds all layers of a binary graph IR (see flexflow/graph_ir.h); returns
+// the number of layers added, or -1 if the buffer is not a valid graph IR.
+// The handle, op type and node name of each added layer are written to
+// layers, layer_op_types and layer_names (name_size bytes per layer)
+int flexflow_model_add_graph_ir(flexflow_model_t handle,
+                                char const *buffer,
+                                int64_t size,
+                                int num_inputs,
+                                flexflow_tensor_t *inputs,
+                                int max_outputs,
+                                flexflow_tensor_t *outputs,
+                                int *num_outputs,
+                                int max_layers,
+                                flexflow_op_t *layers,
+                                int *layer_op_types,
+                                char *layer_names,
+                                int name_size);
+
 flexflow_tensor_t flexflow_model_get_parameter_by_id(flexflow_model_t handle,
                                                      int layer_id);
 
@@ -657,6 +690,33 @@ void flexflow_single_dataloader_reset(flexflow_single_dataloader_t handle);
 void flowflow_single_dataloader_next_batch(flexflow_single_dataloader_t handle,
                                            flexflow_model_t ffmodel);
 
+// -----------------------------------------------------------------------
+// Training loop
+// -----------------------------------------------------------------------
+
+// Called with the number of iterations run so far; returning true stops the
+// loop
+typedef bool (*flexflow_loop_callback_t)(void *user_data, int iteration);
+
+// Run num_iterations training (or, with eval, inference) steps without
+// returning to the caller, loading a batch from each dataloader per step.
+// num_iterations <= 0 runs a whole epoch: the dataloaders and metrics are
+// reset first and the shortest dataloader sets the number of steps. Steps
+// are traced with trace_id unless it is negative; metrics are computed every
+// metrics_interval steps (never if 0), and those steps are not traced. The
+// callback, if any, runs every callback_interval steps and after the last
+// one. Returns the number of steps run.
+int flexflow_model_run_loop(flexflow_model_t handle,
+                            flexflow_single_dataloader_t *dataloaders,
+                            int num_dataloaders,
+                            int num_iterations,
+                            int trace_id,
+                            int metrics_interval,
+                            bool eval,
+                            int callback_interval,
+                            flexflow_loop_callback_t callback,
+                            void *user_data);
+
 // -----------------------------------------------------------------------
 // Timer
 // -----------------------------------------------------------------------
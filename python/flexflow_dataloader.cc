@@ -36,6 +36,8 @@ SingleDataLoader::SingleDataLoader(FFModel &ff,
     assert(full_input_->dims[i].size == input->dims[i].size);
   }
   batch_input = input;
+  model = &ff;
+  model->retain_tensor(batch_input);
   // Currently assume that the leading dim of input is a replica dim of degree 1
   assert(input->dims[input->num_dims - 1].is_replica_dim);
   assert(input->dims[input->num_dims - 1].size == 1);
@@ -100,6 +102,8 @@ SingleDataLoader::SingleDataLoader(FFModel &ff,
   assert(input->dims[input->num_dims - 1].size == 1);
 
   batch_input = input;
+  model = &ff;
+  model->retain_tensor(batch_input);
   ParallelDim dims[MAX_TENSOR_DIM];
   for (int i = 1; i < input->num_dims; i++) {
     dims[i - 1].size = input->dims[input->num_dims - 1 - i].size;
@@ -142,6 +146,10 @@ SingleDataLoader::SingleDataLoader(FFModel &ff,
   next_batch(ff);
 }
 
+SingleDataLoader::~SingleDataLoader() {
+  model->release_tensor(batch_input);
+}
+
 template <int NDIM>
 void SingleDataLoader::index_loader_xd_launcher(FFModel &ff,
                                                 int task_id,
@@ -44,6 +44,7 @@ public:
                    void *full_input_ptr,
                    int num_samples_,
                    DataType datatype_);
+  ~SingleDataLoader();
 
   void next_batch(FlexFlow::FFModel &);
 
@@ -103,6 +104,9 @@ public:
   int num_samples, next_index;
   DataType datatype;
   FlexFlow::ParallelTensor full_input, batch_input;
+
+private:
+  FlexFlow::FFModel *model;
 };
 
 #define MAX_NUM_SAMPLES 4196
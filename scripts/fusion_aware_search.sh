@@ -0,0 +1,25 @@
+#! /usr/bin/env bash
+
+# Compare the strategies picked with and without fusion-aware search on the
+# bundled C++ examples. The launch overheads should first be calibrated with
+# tools/launch_overhead and passed through LAUNCH_OVERHEAD_ARGS, otherwise the
+# simulator does not charge launches and both searches behave the same, e.g.
+#   LAUNCH_OVERHEAD_ARGS="--simulator-task-launch-overhead 0.02 \
+#     --simulator-point-launch-overhead 0.005" ./scripts/fusion_aware_search.sh
+
+BUILD_DIR=${BUILD_DIR:-"$FF_HOME"/build}
+COMMON_ARGS="-ll:gpu 4 -ll:fsize 14000 -ll:zsize 14000 --budget 20 $LAUNCH_OVERHEAD_ARGS"
+
+run() {
+  local name=$1
+  shift
+  for mode in --fusion --fusion-aware-search; do
+    echo "Running $name with $mode"
+    "$@" $COMMON_ARGS "$mode" 2>&1 | grep -E "Fusion-friendly ops|operators (before|after) fusion|ELAPSED TIME"
+  done
+}
+
+run "MLP" "$BUILD_DIR"/examples/cpp/MLP_Unify/mlp_unify
+run "DLRM" "$BUILD_DIR"/examples/cpp/DLRM/dlrm
+run "Inception-v3" "$BUILD_DIR"/examples/cpp/InceptionV3/inception -b 64
+run "BERT" "$BUILD_DIR"/examples/cpp/Transformer/transformer -b 8
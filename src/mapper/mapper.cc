@@ -22,6 +22,33 @@ using namespace Mapping;
 
 LegionRuntime::Logger::Category log_ff_mapper("Mapper");
 
+// Whether an instance of instance_domain can hold a region of region_domain
+// that the tensor accessors see as dense. Instances are laid out with the
+// first dimension fastest, so the region must span the instance along all
+// dimensions before the first one it is cut along, and be a single slice
+// along all dimensions after it. This lets a consumer of a Repartition or
+// Combine output reuse the instance of a co-located input piece.
+static bool instance_covers_densely(Domain const &instance_domain,
+                                    Domain const &region_domain) {
+  if (instance_domain.get_dim() != region_domain.get_dim()) {
+    return false;
+  }
+  bool cut = false;
+  for (int i = 0; i < region_domain.get_dim(); i++) {
+    coord_t lo = region_domain.lo()[i], hi = region_domain.hi()[i];
+    if (lo < instance_domain.lo()[i] || hi > instance_domain.hi()[i]) {
+      return false;
+    }
+    if (cut && lo != hi) {
+      return false;
+    }
+    if (lo != instance_domain.lo()[i] || hi != instance_domain.hi()[i]) {
+      cut = true;
+    }
+  }
+  return true;
+}
+
 FFShardingFunctor::FFShardingFunctor(int _gpus_per_node,
                                      int _cpus_per_node,
                                      int _num_nodes,
@@ -63,11 +90,16 @@ FFMapper::FFMapper(MapperRuntime *rt,
                    char const *_mapper_name,
                    // const std::string& strategyFile,
                    bool _enable_control_replication,
-                   bool _log_instance_creation)
+                   bool _log_instance_creation,
+                   std::shared_ptr<SharedInstanceTracker> _instance_tracker,
+                   bool _print_memory_stats,
+                   CpuTaskModel const &_cpu_task_model)
     : NullMapper(rt, machine), local_processor(_local),
       node_id(_local.address_space()), mapper_name(_mapper_name),
       enable_control_replication(_enable_control_replication),
-      log_instance_creation(_log_instance_creation) {
+      log_instance_creation(_log_instance_creation),
+      print_memory_stats(_print_memory_stats),
+      instance_tracker(_instance_tracker), cpu_task_model(_cpu_task_model) {
   std::vector<Machine::ProcessorMemoryAffinity> proc_mem_affinities;
   machine.get_proc_mem_affinity(proc_mem_affinities);
   Machine::ProcessorQuery proc_query(machine);
@@ -86,11 +118,13 @@ FFMapper::FFMapper(MapperRuntime *rt,
       fb_query.best_affinity_to(*it);
       assert(fb_query.count() == 1);
       proc_fbmems[*it] = *(fb_query.begin());
+      set_memory_capacity(proc_fbmems[*it]);
       Machine::MemoryQuery zc_query(machine);
       zc_query.only_kind(Memory::Z_COPY_MEM);
       zc_query.has_affinity_to(*it);
       assert(zc_query.count() == 1);
       proc_zcmems[*it] = *(zc_query.begin());
+      set_memory_capacity(proc_zcmems[*it]);
     } else if (it->kind() == Processor::LOC_PROC) {
       all_cpus.push_back(*it);
       if (it->address_space() == node_id) {
@@ -101,6 +135,23 @@ FFMapper::FFMapper(MapperRuntime *rt,
       zc_query.has_affinity_to(*it);
       assert(zc_query.count() == 1);
       proc_zcmems[*it] = *(zc_query.begin());
+      set_memory_capacity(proc_zcmems[*it]);
+    } else if (it->kind() == Processor::OMP_PROC) {
+      all_omps.push_back(*it);
+      if (it->address_space() == node_id) {
+        local_omps.push_back(*it);
+      }
+      // Prefer the zero-copy memory shared with the GPUs, like the CPUs
+      Machine::MemoryQuery zc_query(machine);
+      zc_query.only_kind(Memory::Z_COPY_MEM);
+      zc_query.has_affinity_to(*it);
+      Machine::MemoryQuery sys_query(machine);
+      sys_query.only_kind(Memory::SYSTEM_MEM);
+      sys_query.has_affinity_to(*it);
+      assert(zc_query.count() > 0 || sys_query.count() > 0);
+      proc_zcmems[*it] = zc_query.count() > 0 ? *(zc_query.begin())
+                                              : *(sys_query.begin());
+      set_memory_capacity(proc_zcmems[*it]);
     } else if (it->kind() == Processor::PY_PROC) {
       all_pys.push_back(*it);
       if (it->address_space() == node_id) {
@@ -111,9 +162,27 @@ FFMapper::FFMapper(MapperRuntime *rt,
       zc_query.has_affinity_to(*it);
       assert(zc_query.count() == 1);
       proc_zcmems[*it] = *(zc_query.begin());
+      set_memory_capacity(proc_zcmems[*it]);
     }
   }
   total_nodes = address_space_set.size();
+  if (!all_omps.empty()) {
+    // The CPUs of a node share the OpenMP processors of the node
+    assert(all_cpus.size() % total_nodes == 0);
+    assert(all_omps.size() % total_nodes == 0);
+    size_t cpus_per_node = all_cpus.size() / total_nodes;
+    size_t omps_per_node = all_omps.size() / total_nodes;
+    for (size_t i = 0; i < all_cpus.size(); i++) {
+      size_t node = i / cpus_per_node;
+      cpu_omps.push_back(
+          all_omps[node * omps_per_node + (i % cpus_per_node) % omps_per_node]);
+    }
+    log_ff_mapper.print("Map CPU tasks of at least %zu elements per point to "
+                        "%zu OpenMP processors of %d threads",
+                        cpu_task_model.min_omp_volume(),
+                        all_omps.size(),
+                        cpu_task_model.omp_threads);
+  }
   if (enable_control_replication) {
     log_ff_mapper.print("Enabled Control Replication Optimizations.");
   }
@@ -237,6 +306,8 @@ bool FFMapper::is_parameter_server_update_task(TaskID tid) {
   switch (tid) {
     case SGD_UPD_PS_TASK_ID:
     case ADAM_UPD_PS_TASK_ID:
+    case LAMB_UPD_PS_TASK_ID:
+    case LARS_UPD_PS_TASK_ID:
       return true;
     default:
       return false;
@@ -277,7 +348,8 @@ void FFMapper::select_task_options(const MapperContext ctx,
     return;
   }
   if (task.task_id == GRAPH_OPTIMIZE_TASK_ID) {
-    output.initial_proc = all_gpus[0];
+    // Capacity planning needs no GPU
+    output.initial_proc = all_gpus.empty() ? all_cpus[0] : all_gpus[0];
     return;
   }
   if (task.task_id == NCCL_GETUNIQUEID_TASK_ID) {
@@ -355,7 +427,8 @@ void FFMapper::select_task_options(const MapperContext ctx,
       (task.task_id == PY_DL_INT64_LOAD_ENTIRE_CPU_TASK_ID) ||
       (task.task_id == PY_DL_FLOAT_INDEX_LOAD_ENTIRE_CPU_TASK_ID) ||
       (task.task_id == PY_DL_INT32_INDEX_LOAD_ENTIRE_CPU_TASK_ID) ||
-      (task.task_id == PY_DL_INT64_INDEX_LOAD_ENTIRE_CPU_TASK_ID)) {
+      (task.task_id == PY_DL_INT64_INDEX_LOAD_ENTIRE_CPU_TASK_ID) ||
+      (task.task_id == IMAGE_DL_FILL_TASK_ID)) {
     if (!task.is_index_space) {
       output.initial_proc = all_cpus[0];
       return;
@@ -445,7 +518,7 @@ void FFMapper::slice_task(const MapperContext ctx,
     if (view.device_type == MachineView::GPU) {
       devices = &all_gpus;
     } else {
-      devices = &all_cpus;
+      devices = select_cpu_devices(ctx, task, input.domain);
     }
   }
   switch (input.domain.get_dim()) {
@@ -480,6 +553,26 @@ void FFMapper::slice_task(const MapperContext ctx,
   }
 }
 
+std::vector<Processor> const *
+    FFMapper::select_cpu_devices(const MapperContext ctx,
+                                 Task const &task,
+                                 Domain const &domain) {
+  if (cpu_omps.empty() || task.regions.empty()) {
+    return &all_cpus;
+  }
+  std::vector<VariantID> variant_ids;
+  runtime->find_valid_variants(
+      ctx, task.task_id, variant_ids, Processor::OMP_PROC);
+  if (variant_ids.empty()) {
+    return &all_cpus;
+  }
+  // Elements of the first region processed by each point
+  Domain region_domain = runtime->get_index_space_domain(
+      ctx, task.regions[0].region.get_index_space());
+  size_t volume = region_domain.get_volume() / domain.get_volume();
+  return cpu_task_model.prefer_omp(volume) ? &cpu_omps : &all_cpus;
+}
+
 void FFMapper::premap_task(const MapperContext ctx,
                            Task const &task,
                            PremapTaskInput const &input,
@@ -497,6 +590,10 @@ void FFMapper::map_task(const MapperContext ctx,
   // Currently assume there is exactly one variant
   assert(variant_ids.size() == 1);
   output.chosen_variant = variant_ids[0];
+  {
+    std::lock_guard<std::mutex> guard(instance_tracker->lock);
+    instance_tracker->tracker.begin_mapping();
+  }
   // TODO: assign priorities
   output.task_priority = 0;
   output.postmap_task = false;
@@ -505,6 +602,9 @@ void FFMapper::map_task(const MapperContext ctx,
     output.target_procs.push_back(task.target_proc);
   } else if (task.target_proc.kind() == Processor::TOC_PROC) {
     output.target_procs.push_back(task.target_proc);
+  } else if (task.target_proc.kind() == Processor::OMP_PROC) {
+    // The slices of a node are spread over its OpenMP processors
+    output.target_procs.push_back(task.target_proc);
   } else if (task.target_proc.kind() == Processor::LOC_PROC) {
     // Put any of our CPU procs here
     // If we're part of a must epoch launch, our
@@ -582,11 +682,13 @@ void FFMapper::map_task(const MapperContext ctx,
            it != ie;
            ++it) {
         if (it->get_location() == target_mem) {
-          // Only select instances with exact same index domain
+          // Only select instances with the same index domain, or holding
+          // the region densely (e.g., a piece of an aliased parallel op)
           Domain instance_domain = it->get_instance_domain();
           Domain region_domain = runtime->get_index_space_domain(
               ctx, task.regions[idx].region.get_index_space());
-          if (instance_domain.get_volume() == region_domain.get_volume()) {
+          if (instance_domain.get_volume() == region_domain.get_volume() ||
+              instance_covers_densely(instance_domain, region_domain)) {
             valid_instances.push_back(*it);
           }
         }
@@ -600,6 +702,9 @@ void FFMapper::map_task(const MapperContext ctx,
                                 valid_instances,
                                 valid_missing_fields);
       runtime->acquire_and_filter_instances(ctx, valid_instances);
+      for (size_t i = 0; i < valid_instances.size(); i++) {
+        record_instance_use(ctx, valid_instances[i]);
+      }
       output.chosen_instances[idx] = valid_instances;
       missing_fields[idx] = valid_missing_fields;
       if (missing_fields[idx].empty()) {
@@ -633,6 +738,7 @@ void FFMapper::map_task(const MapperContext ctx,
                               created_instances[idx].task_name.c_str());
         }
       }
+      print_memory_usage_stats();
       // Report failed to creation
       log_ff_mapper.error(
           "FlexFlow failed allocation of size %zd bytes for "
@@ -659,6 +765,28 @@ void FFMapper::map_task(const MapperContext ctx,
       created_instances.push_back(clog);
     }
   } // for idx
+  if (task.task_id == ACTIVATION_OFFLOAD_TASK_ID &&
+      task.target_proc.kind() == Processor::TOC_PROC) {
+    // The activation is now also valid in zero-copy memory: let the runtime
+    // collect its framebuffer instance until the prefetch maps it again
+    Memory fb_mem = proc_fbmems[task.target_proc];
+    std::vector<PhysicalInstance> evicted;
+    {
+      std::lock_guard<std::mutex> guard(instance_tracker->lock);
+      for (unsigned idx = 0; idx < task.regions.size(); idx++) {
+        for (PhysicalInstance const &inst : input.valid_instances[idx]) {
+          if (inst.get_location() == fb_mem &&
+              instance_tracker->tracker.evict_instance(inst)) {
+            evicted.push_back(inst);
+          }
+        }
+      }
+    }
+    for (PhysicalInstance const &inst : evicted) {
+      runtime->set_garbage_collection_priority(
+          ctx, inst, LEGION_GC_FIRST_PRIORITY);
+    }
+  }
 }
 
 void FFMapper::map_replicate_task(const MapperContext ctx,
@@ -825,6 +953,7 @@ void FFMapper::select_sharding_functor(const MapperContext ctx,
                                        SelectShardingFunctorOutput &output) {
   // Current all shardings uses data parallelism across machines
   if ((task.task_id == TOP_LEVEL_TASK_ID) ||
+      (task.task_id == IMAGE_DL_FILL_TASK_ID) ||
       ((task.task_id >= CUSTOM_CPU_TASK_ID_FIRST) &&
        (task.task_id <= CUSTOM_CPU_TASK_ID_LAST))) {
     output.chosen_functor = FFConfig::DataParallelism_CPU;
@@ -852,6 +981,10 @@ void FFMapper::map_inline(const MapperContext ctx,
                           InlineMapping const &inline_op,
                           MapInlineInput const &input,
                           MapInlineOutput &output) {
+  {
+    std::lock_guard<std::mutex> guard(instance_tracker->lock);
+    instance_tracker->tracker.begin_mapping();
+  }
   LayoutConstraintSet creation_constraints;
   Memory target_memory = Memory::NO_MEMORY;
   if (inline_op.layout_constraint_id > 0) {
@@ -898,6 +1031,9 @@ void FFMapper::map_inline(const MapperContext ctx,
       }
       if (!output.chosen_instances.empty()) {
         runtime->acquire_and_filter_instances(ctx, output.chosen_instances);
+        for (size_t i = 0; i < output.chosen_instances.size(); i++) {
+          record_instance_use(ctx, output.chosen_instances[i]);
+        }
       }
     }
     // Now see if we have any fields which we still make space for
@@ -933,6 +1069,7 @@ void FFMapper::map_inline(const MapperContext ctx,
                              inline_op.requirement,
                              created,
                              &footprint)) {
+    print_memory_usage_stats();
     log_ff_mapper.error(
         "FlexFlow Mapper failed allocation of size %zd bytes"
         " for region requirement of inline ammping in task %s (UID %lld)"
@@ -1287,6 +1424,8 @@ std::vector<Processor> const &
       return all_gpus;
     case Processor::PY_PROC:
       return all_pys;
+    case Processor::OMP_PROC:
+      return all_omps;
     default:
       assert(0);
   }
@@ -1308,7 +1447,8 @@ Memory FFMapper::default_select_target_memory(MapperContext ctx,
   } else if (target_proc.kind() == Processor::LOC_PROC) {
     assert(proc_zcmems.find(target_proc) != proc_zcmems.end());
     return proc_zcmems[target_proc];
-  } else if (target_proc.kind() == Processor::PY_PROC) {
+  } else if (target_proc.kind() == Processor::PY_PROC ||
+             target_proc.kind() == Processor::OMP_PROC) {
     assert(proc_zcmems.find(target_proc) != proc_zcmems.end());
     return proc_zcmems[target_proc];
   } else {
@@ -1330,6 +1470,9 @@ bool FFMapper::default_make_instance(MapperContext ctx,
   bool tight_region_bounds = true;
   created = true;
   std::vector<LogicalRegion> target_regions(1, target_region);
+  size_t size = 0;
+  // Make room before allocating if the memory is above the GC threshold
+  relieve_memory_pressure(ctx, target_mem, 0 /*extra_bytes*/, false);
   if (!runtime->find_or_create_physical_instance(ctx,
                                                  target_mem,
                                                  constraints,
@@ -1339,18 +1482,136 @@ bool FFMapper::default_make_instance(MapperContext ctx,
                                                  true /*acquire*/,
                                                  0 /*priority*/,
                                                  tight_region_bounds,
-                                                 footprint)) {
-    return false;
+                                                 &size)) {
+    // Make every idle instance collectable and retry once
+    if (!relieve_memory_pressure(ctx, target_mem, size, true) ||
+        !runtime->find_or_create_physical_instance(ctx,
+                                                   target_mem,
+                                                   constraints,
+                                                   target_regions,
+                                                   result,
+                                                   created,
+                                                   true /*acquire*/,
+                                                   0 /*priority*/,
+                                                   tight_region_bounds,
+                                                   &size)) {
+      if (footprint != NULL) {
+        *footprint = size;
+      }
+      return false;
+    }
+  }
+  if (footprint != NULL) {
+    *footprint = size;
   }
   if (created) {
-    int priority = LEGION_GC_NEVER_PRIORITY;
-    if (priority != 0) {
-      runtime->set_garbage_collection_priority(ctx, result, priority);
-    }
+    // Instances stay alive across iterations until the memory runs
+    // low, see relieve_memory_pressure
+    runtime->set_garbage_collection_priority(
+        ctx, result, LEGION_GC_NEVER_PRIORITY);
+    std::lock_guard<std::mutex> guard(instance_tracker->lock);
+    instance_tracker->tracker.add_instance(target_mem, result, size);
   }
+  record_instance_use(ctx, result);
   return true;
 }
 
+bool FFMapper::relieve_memory_pressure(MapperContext ctx,
+                                       Memory target_mem,
+                                       size_t extra_bytes,
+                                       bool all_idle) {
+  // Forget the instances the runtime has collected; acquiring fails once
+  // an instance is deleted
+  // The lock is not held across runtime calls
+  std::vector<PhysicalInstance> victims;
+  {
+    std::lock_guard<std::mutex> guard(instance_tracker->lock);
+    victims = instance_tracker->tracker.get_victims(target_mem);
+  }
+  std::vector<PhysicalInstance> collected;
+  for (size_t i = 0; i < victims.size(); i++) {
+    if (!runtime->acquire_instance(ctx, victims[i])) {
+      collected.push_back(victims[i]);
+    }
+  }
+  {
+    std::lock_guard<std::mutex> guard(instance_tracker->lock);
+    for (size_t i = 0; i < collected.size(); i++) {
+      // Another mapper may have forgotten it already
+      if (instance_tracker->tracker.is_victim(collected[i])) {
+        instance_tracker->tracker.remove_instance(collected[i]);
+      }
+    }
+    if (!all_idle &&
+        !instance_tracker->tracker.under_pressure(target_mem, extra_bytes)) {
+      return false;
+    }
+    // Let the runtime collect the least recently used instances first
+    victims = instance_tracker->tracker.select_victims(
+        target_mem, extra_bytes, all_idle);
+  }
+  for (size_t i = 0; i < victims.size(); i++) {
+    runtime->set_garbage_collection_priority(
+        ctx, victims[i], LEGION_GC_FIRST_PRIORITY);
+  }
+  if (print_memory_stats && !victims.empty()) {
+    log_ff_mapper.print("Memory " IDFMT " under pressure: %zu instances "
+                        "made collectable",
+                        target_mem.id,
+                        victims.size());
+  }
+  return !victims.empty();
+}
+
+void FFMapper::record_instance_use(MapperContext ctx,
+                                   PhysicalInstance const &inst) {
+  bool was_victim;
+  {
+    std::lock_guard<std::mutex> guard(instance_tracker->lock);
+    was_victim = instance_tracker->tracker.is_victim(inst);
+    instance_tracker->tracker.use_instance(inst);
+  }
+  // A victim chosen again must not be collected while in use
+  if (was_victim) {
+    runtime->set_garbage_collection_priority(
+        ctx, inst, LEGION_GC_NEVER_PRIORITY);
+  }
+}
+
+void FFMapper::set_memory_capacity(Memory const &mem) {
+  std::lock_guard<std::mutex> guard(instance_tracker->lock);
+  instance_tracker->tracker.set_capacity(mem, mem.capacity());
+}
+
+std::map<Memory, MemoryUsageStats>
+    FFMapper::get_memory_usage_stats(void) const {
+  std::lock_guard<std::mutex> guard(instance_tracker->lock);
+  return instance_tracker->tracker.get_all_stats();
+}
+
+void FFMapper::print_memory_usage_stats(void) const {
+  std::map<Memory, MemoryUsageStats> stats = get_memory_usage_stats();
+  for (auto const &it : stats) {
+    MemoryUsageStats const &s = it.second;
+    if (s.num_created == 0) {
+      continue;
+    }
+    log_ff_mapper.print("Memory " IDFMT " (kind %d) node %d
+                        ": capacity %zu allocated %zu peak %zu live %zu "
+                        "created %zu reused %zu collected %zu",
+                        it.first.id,
+                        it.first.kind(),
+                        node_id,
+                        s.capacity,
+                        s.allocated,
+                        s.peak,
+                        s.num_live,
+                        s.num_created,
+                        s.num_reused,
+                        s.num_collected);
+  }
+}
+
 LayoutConstraintID FFMapper::default_select_layout_constraints(
     MapperContext ctx,
     Memory target_memory,
@@ -1473,6 +1734,9 @@ void FFMapper::update_mappers(Machine machine,
 
   bool enable_control_replication = true;
   bool log_instance_creation = false;
+  double gc_threshold = 0.8;
+  bool print_memory_stats = false;
+  CpuTaskModel cpu_task_model;
   for (int i = 1; i < argc; i++) {
     // if ((!strcmp(argv[i], "--import")) || (!strcmp(argv[i],
     // "--import-strategy"))) {
@@ -1487,8 +1751,26 @@ void FFMapper::update_mappers(Machine machine,
       log_instance_creation = true;
       continue;
     }
+    if (!strcmp(argv[i], "--gc-threshold")) {
+      gc_threshold = atof(argv[++i]);
+      continue;
+    }
+    if (!strcmp(argv[i], "--print-memory-stats")) {
+      print_memory_stats = true;
+      continue;
+    }
+    if (!strcmp(argv[i], "-ll:othr")) {
+      cpu_task_model.omp_threads = atoi(argv[++i]);
+      continue;
+    }
+    if (!strcmp(argv[i], "--omp-overhead")) {
+      cpu_task_model.omp_overhead = atof(argv[++i]);
+      continue;
+    }
   }
 
+  std::shared_ptr<SharedInstanceTracker> instance_tracker =
+      std::make_shared<SharedInstanceTracker>(gc_threshold);
   for (std::set<Processor>::const_iterator it = local_procs.begin();
        it != local_procs.end();
        it++) {
@@ -1497,11 +1779,19 @@ void FFMapper::update_mappers(Machine machine,
                                     *it,
                                     "FlexFlow Mapper",
                                     enable_control_replication,
-                                    log_instance_creation);
+                                    log_instance_creation,
+                                    instance_tracker,
+                                    print_memory_stats,
+                                    cpu_task_model);
     runtime->replace_default_mapper(mapper, *it);
   }
 }
 
-FFMapper::~FFMapper(void) {}
+FFMapper::~FFMapper(void) {
+  // Printed once, by the last mapper of the process
+  if (print_memory_stats && instance_tracker.use_count() == 1) {
+    print_memory_usage_stats();
+  }
+}
 
 }; // namespace FlexFlow
@@ -181,7 +181,8 @@ MultiHeadAttention::MultiHeadAttention(FFModel &model,
       qSize(_query->dims[0].size), kSize(_key->dims[0].size),
       vSize(_value->dims[0].size), qProjSize(_kdim), kProjSize(_kdim),
       vProjSize(_vdim), oProjSize(_embed_dim),
-      qoSeqLength(_query->dims[1].size), kvSeqLength(_key->dims[1].size)
+      qoSeqLength(_query->dims[1].size), kvSeqLength(_key->dims[1].size),
+      tiled(model.config.tiled_attention)
 // bias_initializer(_bias_initializer)
 {
   // overwrite layer_guid
@@ -271,7 +272,8 @@ MultiHeadAttention::MultiHeadAttention(FFModel &model,
       qSize(_query->dims[0].size), kSize(_key->dims[0].size),
       vSize(_value->dims[0].size), qProjSize(_kdim), kProjSize(_kdim),
       vProjSize(_vdim), oProjSize(_embed_dim),
-      qoSeqLength(_query->dims[1].size), kvSeqLength(_key->dims[1].size)
+      qoSeqLength(_query->dims[1].size), kvSeqLength(_key->dims[1].size),
+      tiled(model.config.tiled_attention)
 // bias_initializer(_bias_initializer)
 {
   // assert key and value have the same sequence length
@@ -798,6 +800,12 @@ bool MultiHeadAttention::measure_operator_cost(
   float const *weight_ptr = (float const *)sim->allocate(num_weights, DT_FLOAT);
   cost_metrics.weights_memory += cost_metrics.total_mem_diff_from(sim->offset);
 
+  // What the forward pass keeps for the backward pass: the score matrices
+  // for cuDNN, linear in the sequence lengths for the tiled kernels
+  sim->allocate((m->reserveSpaceSize + sizeof(float) - 1) / sizeof(float),
+                DT_FLOAT);
+  cost_metrics.outputs_memory += cost_metrics.total_mem_diff_from(sim->offset);
+
   assert(m->profiling == false);
 
   std::function<void()> forward, backward;
@@ -160,6 +160,9 @@ MultiHeadAttentionMeta::MultiHeadAttentionMeta(FFHandler handler,
   hipStream_t stream;
   checkCUDA(get_legion_stream(&stream));
   checkCUDNN(miopenSetStream(handler.dnn, stream));
+  // The tiled kernels are CUDA only; FFConfig turns --tiled-attention off
+  assert(!attn->tiled);
+  tiled = false;
 
 #if 0
   checkCUDNN(cudnnCreateAttnDescriptor(&attnDesc));
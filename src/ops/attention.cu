@@ -22,6 +22,327 @@ namespace FlexFlow {
 using Legion::coord_t;
 using Legion::Memory;
 
+namespace {
+
+// The tiled kernels run one thread per query (or key) row of a tile and stage
+// the rows of the other side in shared memory. Blocks are indexed by
+// (tile, sample, head), and the per-head buffers are [num_heads][num_samples]
+// [seq_length][proj_size].
+
+__global__ void tiled_attention_forward(float const *q,
+                                        float const *k,
+                                        float const *v,
+                                        float *o,
+                                        float *lse,
+                                        int qo_len,
+                                        int kv_len,
+                                        int d,
+                                        int dv,
+                                        float scale) {
+  extern __shared__ float tile[];
+  int const T = blockDim.x;
+  float *k_tile = tile;
+  float *v_tile = tile + T * d;
+  size_t bh = (size_t)blockIdx.z * gridDim.y + blockIdx.y;
+  q += bh * qo_len * d;
+  k += bh * kv_len * d;
+  v += bh * kv_len * dv;
+  o += bh * qo_len * dv;
+  lse += bh * qo_len;
+  int i = blockIdx.x * T + threadIdx.x;
+  bool active = i < qo_len;
+  float const *q_i = q + (size_t)i * d;
+  float *o_i = o + (size_t)i * dv;
+  float m = -INFINITY, l = 0.0f;
+  if (active) {
+    for (int b = 0; b < dv; b++) {
+      o_i[b] = 0.0f;
+    }
+  }
+  for (int k_begin = 0; k_begin < kv_len; k_begin += T) {
+    int width = min(T, kv_len - k_begin);
+    __syncthreads();
+    for (int x = threadIdx.x; x < width * d; x += T) {
+      k_tile[x] = k[(size_t)k_begin * d + x];
+    }
+    for (int x = threadIdx.x; x < width * dv; x += T) {
+      v_tile[x] = v[(size_t)k_begin * dv + x];
+    }
+    __syncthreads();
+    if (!active) {
+      continue;
+    }
+    for (int j = 0; j < width; j++) {
+      float s = 0.0f;
+      for (int a = 0; a < d; a++) {
+        s += q_i[a] * k_tile[j * d + a];
+      }
+      s *= scale;
+      if (s > m) {
+        // Rescale what has been accumulated to the new running maximum
+        float correction = expf(m - s);
+        l *= correction;
+        for (int b = 0; b < dv; b++) {
+          o_i[b] *= correction;
+        }
+        m = s;
+      }
+      float p = expf(s - m);
+      l += p;
+      for (int b = 0; b < dv; b++) {
+        o_i[b] += p * v_tile[j * dv + b];
+      }
+    }
+  }
+  if (active) {
+    for (int b = 0; b < dv; b++) {
+      o_i[b] /= l;
+    }
+    lse[i] = m + logf(l);
+  }
+}
+
+__global__ void tiled_attention_delta(float const *o,
+                                      float const *o_grad,
+                                      float *delta,
+                                      size_t rows,
+                                      int dv) {
+  CUDA_KERNEL_LOOP(i, rows) {
+    float sum = 0.0f;
+    for (int b = 0; b < dv; b++) {
+      sum += o[i * dv + b] * o_grad[i * dv + b];
+    }
+    delta[i] = sum;
+  }
+}
+
+__global__ void tiled_attention_query_grad(float const *q,
+                                           float const *k,
+                                           float const *v,
+                                           float const *o_grad,
+                                           float const *lse,
+                                           float const *delta,
+                                           float *q_grad,
+                                           int qo_len,
+                                           int kv_len,
+                                           int d,
+                                           int dv,
+                                           float scale) {
+  extern __shared__ float tile[];
+  int const T = blockDim.x;
+  float *k_tile = tile;
+  float *v_tile = tile + T * d;
+  size_t bh = (size_t)blockIdx.z * gridDim.y + blockIdx.y;
+  q += bh * qo_len * d;
+  q_grad += bh * qo_len * d;
+  k += bh * kv_len * d;
+  v += bh * kv_len * dv;
+  o_grad += bh * qo_len * dv;
+  lse += bh * qo_len;
+  delta += bh * qo_len;
+  int i = blockIdx.x * T + threadIdx.x;
+  bool active = i < qo_len;
+  float const *q_i = q + (size_t)i * d;
+  float const *o_grad_i = o_grad + (size_t)i * dv;
+  float *q_grad_i = q_grad + (size_t)i * d;
+  if (active) {
+    for (int a = 0; a < d; a++) {
+      q_grad_i[a] = 0.0f;
+    }
+  }
+  for (int k_begin = 0; k_begin < kv_len; k_begin += T) {
+    int width = min(T, kv_len - k_begin);
+    __syncthreads();
+    for (int x = threadIdx.x; x < width * d; x += T) {
+      k_tile[x] = k[(size_t)k_begin * d + x];
+    }
+    for (int x = threadIdx.x; x < width * dv; x += T) {
+      v_tile[x] = v[(size_t)k_begin * dv + x];
+    }
+    __syncthreads();
+    if (!active) {
+      continue;
+    }
+    for (int j = 0; j < width; j++) {
+      float s = 0.0f, dp = 0.0f;
+      for (int a = 0; a < d; a++) {
+        s += q_i[a] * k_tile[j * d + a];
+      }
+      for (int b = 0; b < dv; b++) {
+        dp += o_grad_i[b] * v_tile[j * dv + b];
+      }
+      float p = expf(s * scale - lse[i]);
+      float ds = p * (dp - delta[i]) * scale;
+      for (int a = 0; a < d; a++) {
+        q_grad_i[a] += ds * k_tile[j * d + a];
+      }
+    }
+  }
+}
+
+__global__ void tiled_attention_key_value_grad(float const *q,
+                                               float const *k,
+                                               float const *v,
+                                               float const *o_grad,
+                                               float const *lse,
+                                               float const *delta,
+                                               float *k_grad,
+                                               float *v_grad,
+                                               int qo_len,
+                                               int kv_len,
+                                               int d,
+                                               int dv,
+                                               float scale) {
+  extern __shared__ float tile[];
+  int const T = blockDim.x;
+  float *q_tile = tile;
+  float *o_grad_tile = q_tile + T * d;
+  float *lse_tile = o_grad_tile + T * dv;
+  float *delta_tile = lse_tile + T;
+  size_t bh = (size_t)blockIdx.z * gridDim.y + blockIdx.y;
+  q += bh * qo_len * d;
+  k += bh * kv_len * d;
+  k_grad += bh * kv_len * d;
+  v += bh * kv_len * dv;
+  v_grad += bh * kv_len * dv;
+  o_grad += bh * qo_len * dv;
+  lse += bh * qo_len;
+  delta += bh * qo_len;
+  int j = blockIdx.x * T + threadIdx.x;
+  bool active = j < kv_len;
+  float const *k_j = k + (size_t)j * d;
+  float const *v_j = v + (size_t)j * dv;
+  float *k_grad_j = k_grad + (size_t)j * d;
+  float *v_grad_j = v_grad + (size_t)j * dv;
+  if (active) {
+    for (int a = 0; a < d; a++) {
+      k_grad_j[a] = 0.0f;
+    }
+    for (int b = 0; b < dv; b++) {
+      v_grad_j[b] = 0.0f;
+    }
+  }
+  for (int q_begin = 0; q_begin < qo_len; q_begin += T) {
+    int width = min(T, qo_len - q_begin);
+    __syncthreads();
+    for (int x = threadIdx.x; x < width * d; x += T) {
+      q_tile[x] = q[(size_t)q_begin * d + x];
+    }
+    for (int x = threadIdx.x; x < width * dv; x += T) {
+      o_grad_tile[x] = o_grad[(size_t)q_begin * dv + x];
+    }
+    if (threadIdx.x < width) {
+      lse_tile[threadIdx.x] = lse[q_begin + threadIdx.x];
+      delta_tile[threadIdx.x] = delta[q_begin + threadIdx.x];
+    }
+    __syncthreads();
+    if (!active) {
+      continue;
+    }
+    for (int i = 0; i < width; i++) {
+      float s = 0.0f, dp = 0.0f;
+      for (int a = 0; a < d; a++) {
+        s += q_tile[i * d + a] * k_j[a];
+      }
+      for (int b = 0; b < dv; b++) {
+        dp += o_grad_tile[i * dv + b] * v_j[b];
+      }
+      float p = expf(s * scale - lse_tile[i]);
+      float ds = p * (dp - delta_tile[i]) * scale;
+      for (int b = 0; b < dv; b++) {
+        v_grad_j[b] += p * o_grad_tile[i * dv + b];
+      }
+      for (int a = 0; a < d; a++) {
+        k_grad_j[a] += ds * q_tile[i * d + a];
+      }
+    }
+  }
+}
+
+// Per-head projections out_h[rows][out_size] = in[rows][in_size] * W_h^T of
+// the weights [num_heads][...] at offset
+void project_heads(cublasHandle_t blas,
+                   TiledAttentionShape const &s,
+                   float const *in,
+                   float const *weight,
+                   size_t offset,
+                   float *out,
+                   int rows,
+                   int in_size,
+                   int out_size) {
+  float alpha = 1.0f, beta = 0.0f;
+  checkCUDA(cublasSgemmStridedBatched(blas,
+                                      CUBLAS_OP_T,
+                                      CUBLAS_OP_N,
+                                      out_size,
+                                      rows,
+                                      in_size,
+                                      &alpha,
+                                      weight + offset,
+                                      in_size,
+                                      s.weights_per_head(),
+                                      in,
+                                      in_size,
+                                      0,
+                                      &beta,
+                                      out,
+                                      out_size,
+                                      (long long)rows * out_size,
+                                      s.num_heads));
+}
+
+// Gradients of project_heads, accumulated into in_grad and weight_grad
+void project_heads_backward(cublasHandle_t blas,
+                            TiledAttentionShape const &s,
+                            float const *in,
+                            float const *weight,
+                            size_t offset,
+                            float const *out_grad,
+                            float *in_grad,
+                            float *weight_grad,
+                            int rows,
+                            int in_size,
+                            int out_size) {
+  float alpha = 1.0f, beta = 1.0f;
+  checkCUDA(cublasSgemmStridedBatched(blas,
+                                      CUBLAS_OP_N,
+                                      CUBLAS_OP_T,
+                                      in_size,
+                                      out_size,
+                                      rows,
+                                      &alpha,
+                                      in,
+                                      in_size,
+                                      0,
+                                      out_grad,
+                                      out_size,
+                                      (long long)rows * out_size,
+                                      &beta,
+                                      weight_grad + offset,
+                                      in_size,
+                                      s.weights_per_head(),
+                                      s.num_heads));
+  // The heads add up in in_grad, which may alias another input gradient
+  for (int h = 0; h < s.num_heads; h++) {
+    checkCUDA(cublasSgemm(blas,
+                          CUBLAS_OP_N,
+                          CUBLAS_OP_N,
+                          in_size,
+                          rows,
+                          out_size,
+                          &alpha,
+                          weight + h * s.weights_per_head() + offset,
+                          in_size,
+                          out_grad + (size_t)h * rows * out_size,
+                          out_size,
+                          &beta,
+                          in_grad,
+                          in_size));
+  }
+}
+
+} // namespace
+
 /*static*/
 void MultiHeadAttention::forward_kernel(MultiHeadAttentionMeta const *m,
                                         float const *query_ptr,
@@ -30,6 +351,11 @@ void MultiHeadAttention::forward_kernel(MultiHeadAttentionMeta const *m,
                                         float const *weight_ptr,
                                         float *output_ptr,
                                         cudaStream_t stream) {
+  if (m->tiled) {
+    MultiHeadAttention::tiled_forward_kernel(
+        m, query_ptr, key_ptr, value_ptr, weight_ptr, output_ptr, stream);
+    return;
+  }
   checkCUDNN(cudnnSetStream(m->handle.dnn, stream));
 
   checkCUDNN(cudnnMultiHeadAttnForward(m->handle.dnn,
@@ -100,6 +426,20 @@ void MultiHeadAttention::backward_kernel(MultiHeadAttentionMeta const *m,
                                          float *weight_grad_ptr,
                                          float const *output_grad_ptr,
                                          cudaStream_t stream) {
+  if (m->tiled) {
+    MultiHeadAttention::tiled_backward_kernel(m,
+                                              query_ptr,
+                                              query_grad_ptr,
+                                              key_ptr,
+                                              key_grad_ptr,
+                                              value_ptr,
+                                              value_grad_ptr,
+                                              weight_ptr,
+                                              weight_grad_ptr,
+                                              output_grad_ptr,
+                                              stream);
+    return;
+  }
   checkCUDNN(cudnnSetStream(m->handle.dnn, stream));
 
   checkCUDNN(cudnnMultiHeadAttnBackwardData(m->handle.dnn,
@@ -189,6 +529,177 @@ void MultiHeadAttention::backward_kernel_wrapper(
   }
 }
 
+/*static*/
+void MultiHeadAttention::tiled_forward_kernel(MultiHeadAttentionMeta const *m,
+                                              float const *query_ptr,
+                                              float const *key_ptr,
+                                              float const *value_ptr,
+                                              float const *weight_ptr,
+                                              float *output_ptr,
+                                              cudaStream_t stream) {
+  checkCUDA(cublasSetStream(m->handle.blas, stream));
+  TiledAttentionShape const &s = m->tiledShape;
+  int const H = s.num_heads, N = s.num_samples;
+  int const qo_rows = N * s.qo_seq_length, kv_rows = N * s.kv_seq_length;
+  int const d = s.q_proj_size, dv = s.v_proj_size;
+  float *q = (float *)m->reserveSpace;
+  float *k = q + (size_t)H * qo_rows * d;
+  float *v = k + (size_t)H * kv_rows * d;
+  float *o = v + (size_t)H * kv_rows * dv;
+  float *lse = o + (size_t)H * qo_rows * dv;
+
+  project_heads(m->handle.blas, s, query_ptr, weight_ptr, s.wq_offset(), q,
+                qo_rows, s.q_size, d);
+  project_heads(m->handle.blas, s, key_ptr, weight_ptr, s.wk_offset(), k,
+                kv_rows, s.k_size, d);
+  project_heads(m->handle.blas, s, value_ptr, weight_ptr, s.wv_offset(), v,
+                kv_rows, s.v_size, dv);
+  int const T = s.tile_size;
+  dim3 grid((s.qo_seq_length + T - 1) / T, N, H);
+  tiled_attention_forward<<<grid, T, T * (d + dv) * sizeof(float), stream>>>(
+      q, k, v, o, lse, s.qo_seq_length, s.kv_seq_length, d, dv, s.scale);
+  // The heads add up through the output projection
+  for (int h = 0; h < H; h++) {
+    float alpha = 1.0f, beta = h == 0 ? 0.0f : 1.0f;
+    checkCUDA(cublasSgemm(m->handle.blas,
+                          CUBLAS_OP_T,
+                          CUBLAS_OP_N,
+                          s.o_proj_size,
+                          qo_rows,
+                          dv,
+                          &alpha,
+                          weight_ptr + h * s.weights_per_head() + s.wo_offset(),
+                          dv,
+                          o + (size_t)h * qo_rows * dv,
+                          dv,
+                          &beta,
+                          output_ptr,
+                          s.o_proj_size));
+  }
+}
+
+/*static*/
+void MultiHeadAttention::tiled_backward_kernel(MultiHeadAttentionMeta const *m,
+                                               float const *query_ptr,
+                                               float *query_grad_ptr,
+                                               float const *key_ptr,
+                                               float *key_grad_ptr,
+                                               float const *value_ptr,
+                                               float *value_grad_ptr,
+                                               float const *weight_ptr,
+                                               float *weight_grad_ptr,
+                                               float const *output_grad_ptr,
+                                               cudaStream_t stream) {
+  checkCUDA(cublasSetStream(m->handle.blas, stream));
+  TiledAttentionShape const &s = m->tiledShape;
+  int const H = s.num_heads, N = s.num_samples;
+  int const qo_rows = N * s.qo_seq_length, kv_rows = N * s.kv_seq_length;
+  int const d = s.q_proj_size, dv = s.v_proj_size;
+  // The state saved by the forward pass
+  float const *q = (float const *)m->reserveSpace;
+  float const *k = q + (size_t)H * qo_rows * d;
+  float const *v = k + (size_t)H * kv_rows * d;
+  float const *o = v + (size_t)H * kv_rows * dv;
+  float const *lse = o + (size_t)H * qo_rows * dv;
+  // The backward scratch
+  float *q_grad = (float *)(lse + (size_t)H * qo_rows);
+  float *k_grad = q_grad + (size_t)H * qo_rows * d;
+  float *v_grad = k_grad + (size_t)H * kv_rows * d;
+  float *o_grad = v_grad + (size_t)H * kv_rows * dv;
+  float *delta = o_grad + (size_t)H * qo_rows * dv;
+
+  // Through the output projection
+  {
+    float alpha = 1.0f, beta = 0.0f;
+    checkCUDA(cublasSgemmStridedBatched(m->handle.blas,
+                                        CUBLAS_OP_N,
+                                        CUBLAS_OP_N,
+                                        dv,
+                                        qo_rows,
+                                        s.o_proj_size,
+                                        &alpha,
+                                        weight_ptr + s.wo_offset(),
+                                        dv,
+                                        s.weights_per_head(),
+                                        output_grad_ptr,
+                                        s.o_proj_size,
+                                        0,
+                                        &beta,
+                                        o_grad,
+                                        dv,
+                                        (long long)qo_rows * dv,
+                                        H));
+    beta = 1.0f;
+    checkCUDA(cublasSgemmStridedBatched(m->handle.blas,
+                                        CUBLAS_OP_N,
+                                        CUBLAS_OP_T,
+                                        dv,
+                                        s.o_proj_size,
+                                        qo_rows,
+                                        &alpha,
+                                        o,
+                                        dv,
+                                        (long long)qo_rows * dv,
+                                        output_grad_ptr,
+                                        s.o_proj_size,
+                                        0,
+                                        &beta,
+                                        weight_grad_ptr + s.wo_offset(),
+                                        dv,
+                                        s.weights_per_head(),
+                                        H));
+  }
+  // Through the softmax, recomputing the probabilities tile by tile from the
+  // log-sum-exp of each query
+  size_t rows = (size_t)H * qo_rows;
+  tiled_attention_delta<<<GET_BLOCKS(rows), CUDA_NUM_THREADS, 0, stream>>>(
+      o, o_grad, delta, rows, dv);
+  int const T = s.tile_size;
+  dim3 q_grid((s.qo_seq_length + T - 1) / T, N, H);
+  tiled_attention_query_grad<<<q_grid,
+                               T,
+                               T * (d + dv) * sizeof(float),
+                               stream>>>(q,
+                                         k,
+                                         v,
+                                         o_grad,
+                                         lse,
+                                         delta,
+                                         q_grad,
+                                         s.qo_seq_length,
+                                         s.kv_seq_length,
+                                         d,
+                                         dv,
+                                         s.scale);
+  dim3 kv_grid((s.kv_seq_length + T - 1) / T, N, H);
+  tiled_attention_key_value_grad<<<kv_grid,
+                                   T,
+                                   T * (d + dv + 2) * sizeof(float),
+                                   stream>>>(q,
+                                             k,
+                                             v,
+                                             o_grad,
+                                             lse,
+                                             delta,
+                                             k_grad,
+                                             v_grad,
+                                             s.qo_seq_length,
+                                             s.kv_seq_length,
+                                             d,
+                                             dv,
+                                             s.scale);
+  // Through the input projections
+  project_heads_backward(m->handle.blas, s, query_ptr, weight_ptr,
+                         s.wq_offset(), q_grad, query_grad_ptr,
+                         weight_grad_ptr, qo_rows, s.q_size, d);
+  project_heads_backward(m->handle.blas, s, key_ptr, weight_ptr,
+                         s.wk_offset(), k_grad, key_grad_ptr, weight_grad_ptr,
+                         kv_rows, s.k_size, d);
+  project_heads_backward(m->handle.blas, s, value_ptr, weight_ptr,
+                         s.wv_offset(), v_grad, value_grad_ptr,
+                         weight_grad_ptr, kv_rows, s.v_size, dv);
+}
+
 MultiHeadAttentionMeta::MultiHeadAttentionMeta(FFHandler handler,
                                                MultiHeadAttention const *attn,
                                                Memory gpu_mem,
@@ -206,6 +717,50 @@ MultiHeadAttentionMeta::MultiHeadAttentionMeta(FFHandler handler,
   checkCUDNN(cudnnCreateSeqDataDescriptor(&oDesc));
   // Currently do not support adding bias to key/value projection
   assert(!attn->add_bias_kv);
+  tiled = attn->tiled;
+  if (tiled) {
+    tiledShape.num_samples = num_samples;
+    tiledShape.num_heads = num_heads;
+    tiledShape.qo_seq_length = attn->qoSeqLength;
+    tiledShape.kv_seq_length = attn->kvSeqLength;
+    tiledShape.q_size = attn->qSize;
+    tiledShape.k_size = attn->kSize;
+    tiledShape.v_size = attn->vSize;
+    tiledShape.q_proj_size = attn->qProjSize;
+    tiledShape.k_proj_size = attn->kProjSize;
+    tiledShape.v_proj_size = attn->vProjSize;
+    tiledShape.o_proj_size = attn->oProjSize;
+    // Same softmax scaling as the cuDNN path (smScaler)
+    tiledShape.scale = 1.0f;
+    // Fit the tiles of the backward pass in 48KB of shared memory
+    while (tiledShape.tile_size > 1 &&
+           tiledShape.tile_size *
+                   (tiledShape.q_proj_size + tiledShape.v_proj_size + 2) *
+                   sizeof(float) >
+               48 * 1024) {
+      tiledShape.tile_size /= 2;
+    }
+    weightSize = tiledShape.weights_per_head() * num_heads * sizeof(float);
+    reserveSpaceSize = (tiledShape.saved_state_size() +
+                        tiledShape.backward_scratch_size()) *
+                       sizeof(float);
+    Realm::Rect<1, coord_t> bounds(
+        Realm::Point<1, coord_t>(0),
+        Realm::Point<1, coord_t>(reserveSpaceSize - 1));
+    std::vector<size_t> field_sizes;
+    field_sizes.push_back(sizeof(char));
+    Realm::RegionInstance::create_instance(reserveInst,
+                                           gpu_mem,
+                                           bounds,
+                                           field_sizes,
+                                           0,
+                                           Realm::ProfilingRequestSet())
+        .wait();
+    reserveSpace = reserveInst.pointer_untyped(0, sizeof(char));
+    devQoSeqArray = devKvSeqArray = NULL;
+    loWinIdx = hiWinIdx = NULL;
+    return;
+  }
   cudnnAttnQueryMap_t attnMode = CUDNN_ATTN_QUERYMAP_ALL_TO_ONE;
   // Assume no beam search for now
   int maxBeamSize = 1;
@@ -593,6 +593,8 @@ OpMeta *Conv2D::init_task(Task const *task,
   m->use_bias = conv->use_bias;
   m->profiling = conv->profiling;
   m->trainableInputs[0] = conv->trainableInputs[0];
+  m->resetInputGrads[0] = conv->resetInputGrads[0];
+  m->resetWeightGrads = conv->resetWeightGrads;
   std::strcpy(m->op_name, conv->name);
 
   int input_w = acc_input.rect.hi[0] - acc_input.rect.lo[0] + 1;
@@ -1010,6 +1012,16 @@ bool Conv2D::estimate_sync_cost(Simulator *sim,
   return true;
 }
 
+// The backward pass writes the whole input and weight gradients with cuDNN
+// calls, whose beta selects between overwriting and accumulating
+bool Conv2D::can_overwrite_input_grad(int input_idx) const {
+  return true;
+}
+
+bool Conv2D::can_overwrite_weight_grads() const {
+  return true;
+}
+
 void Conv2D::serialize(Legion::Serializer &sez) const {
   sez.serialize(this->layer_guid.id);
   sez.serialize(this->out_channels);
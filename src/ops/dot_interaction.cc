@@ -0,0 +1,488 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flexflow/ops/dot_interaction.h"
+#include "flexflow/utils/hash_utils.h"
+#include "legion/legion_utilities.h"
+
+namespace FlexFlow {
+
+// declare Legion names
+using Legion::ArgumentMap;
+using Legion::Context;
+using Legion::coord_t;
+using Legion::Domain;
+using Legion::FutureMap;
+using Legion::IndexLauncher;
+using Legion::PhysicalRegion;
+using Legion::Predicate;
+using Legion::Rect;
+using Legion::RegionRequirement;
+using Legion::Runtime;
+using Legion::Task;
+using Legion::TaskArgument;
+using Legion::TaskLauncher;
+using PCG::Node;
+
+bool operator==(DotInteractionParams const &lhs,
+                DotInteractionParams const &rhs) {
+  return lhs.self_interaction == rhs.self_interaction &&
+         lhs.concat_dense == rhs.concat_dense;
+}
+
+bool DotInteractionParams::is_valid(
+    std::vector<ParallelTensorShape> const &inputs) const {
+  if (inputs.size() < 1 || inputs.size() > MAX_NUM_INPUTS) {
+    return false;
+  }
+  for (auto const &input : inputs) {
+    if (!input.is_valid()) {
+      return false;
+    }
+    if (input.num_dims != inputs[0].num_dims) {
+      return false;
+    }
+    // The features of a sample cannot be split
+    if (input.dims[0].degree != 1) {
+      return false;
+    }
+    for (int i = 0; i < input.num_dims; i++) {
+      if (input.dims[i] != inputs[0].dims[i]) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+DotInteractionParams DotInteraction::get_params() const {
+  DotInteractionParams params;
+  params.self_interaction = this->self_interaction;
+  params.concat_dense = this->concat_dense;
+  return params;
+}
+
+Tensor FFModel::dot_interaction(const Tensor dense,
+                                std::vector<Tensor> const &embeddings,
+                                bool self_interaction,
+                                bool concat_dense,
+                                char const *name) {
+  std::vector<Tensor> features;
+  features.push_back(dense);
+  features.insert(features.end(), embeddings.begin(), embeddings.end());
+  assert(features.size() <= MAX_NUM_INPUTS);
+  Layer *interaction = new Layer(this,
+                                 OP_DOT_INTERACTION,
+                                 DT_FLOAT,
+                                 name,
+                                 features.size() /*inputs*/,
+                                 0 /*weights*/,
+                                 1 /*outputs*/,
+                                 features.data());
+  int numdim = dense->num_dims;
+  for (auto const &t : features) {
+    assert(t->data_type == DT_FLOAT);
+    assert(t->num_dims == numdim);
+    for (int i = 0; i < numdim; i++) {
+      assert(t->dims[i] == dense->dims[i]);
+    }
+  }
+  DotInteractionShape shape;
+  shape.num_features = features.size();
+  shape.feature_size = dense->dims[0];
+  shape.self_interaction = self_interaction;
+  shape.concat_dense = concat_dense;
+  int dims[MAX_TENSOR_DIM];
+  for (int i = 0; i < numdim; i++) {
+    dims[i] = dense->dims[i];
+  }
+  dims[0] = shape.output_size();
+  interaction->outputs[0] = create_tensor_legion_ordering(
+      numdim, dims, DT_FLOAT, interaction, 0, true /*create_grad*/);
+  interaction->add_int_property("self_interaction", self_interaction);
+  interaction->add_int_property("concat_dense", concat_dense);
+  layers.push_back(interaction);
+  return interaction->outputs[0];
+}
+
+Op *DotInteraction::create_operator_from_layer(
+    FFModel &model,
+    Layer const *layer,
+    std::vector<ParallelTensor> const &inputs) {
+  long long value;
+  layer->get_int_property("self_interaction", value);
+  bool self_interaction = (bool)value;
+  layer->get_int_property("concat_dense", value);
+  bool concat_dense = (bool)value;
+  return new DotInteraction(model,
+                            inputs.size(),
+                            inputs.data(),
+                            self_interaction,
+                            concat_dense,
+                            layer->name);
+}
+
+DotInteraction::DotInteraction(FFModel &model,
+                               int _n,
+                               ParallelTensor const *_inputs,
+                               bool _self_interaction,
+                               bool _concat_dense,
+                               char const *name)
+    : Op(model,
+         OP_DOT_INTERACTION,
+         DT_FLOAT,
+         name,
+         _n /*inputs*/,
+         0 /*weights*/,
+         1 /*outputs*/,
+         _inputs),
+      self_interaction(_self_interaction), concat_dense(_concat_dense) {
+  int num_dim = inputs[0]->num_dims;
+  for (int i = 0; i < numInputs; i++) {
+    assert(inputs[i]->data_type == DT_FLOAT);
+    assert(inputs[i]->num_dims == num_dim);
+    for (int j = 0; j < num_dim; j++) {
+      // All inputs are partitioned the same way, along the samples only
+      assert(inputs[i]->dims[j] == inputs[0]->dims[j]);
+    }
+  }
+  assert(inputs[0]->dims[0].degree == 1);
+  DotInteractionShape shape;
+  shape.num_features = numInputs;
+  shape.feature_size = inputs[0]->dims[0].size;
+  shape.self_interaction = self_interaction;
+  shape.concat_dense = concat_dense;
+  ParallelDim dims[MAX_TENSOR_DIM];
+  for (int i = 0; i < num_dim; i++) {
+    dims[i] = inputs[0]->dims[i];
+  }
+  dims[0].size = shape.output_size();
+  numOutputs = 1;
+  outputs[0] = model.create_parallel_tensor_legion_ordering(
+      num_dim, dims, DT_FLOAT, this);
+}
+
+DotInteraction::DotInteraction(FFModel &model,
+                               DotInteractionParams const &params,
+                               std::vector<ParallelTensor> const &inputs,
+                               char const *name)
+    : DotInteraction(model,
+                     inputs.size(),
+                     inputs.data(),
+                     params.self_interaction,
+                     params.concat_dense,
+                     name) {}
+
+void DotInteraction::serialize(Legion::Serializer &sez) const {
+  sez.serialize(this->self_interaction);
+  sez.serialize(this->concat_dense);
+}
+
+/*static*/
+Node DotInteraction::deserialize(FFModel &ff,
+                                 Legion::Deserializer &dez,
+                                 ParallelTensor inputs[],
+                                 int num_inputs) {
+  DotInteractionParams params;
+  dez.deserialize(params.self_interaction);
+  dez.deserialize(params.concat_dense);
+  return ff.get_or_create_node<DotInteraction>({inputs, inputs + num_inputs},
+                                               params);
+}
+
+Op *DotInteraction::materialize(FFModel &ff,
+                                ParallelTensor inputs[],
+                                int num_inputs) const {
+  return new DotInteraction(ff,
+                            num_inputs,
+                            inputs,
+                            this->self_interaction,
+                            this->concat_dense,
+                            this->name);
+}
+
+void DotInteraction::init(FFModel const &ff) {
+  assert(check_output_input_weight_same_parallel_is());
+  parallel_is = outputs[0]->parallel_is;
+  ArgumentMap argmap;
+  Context ctx = ff.config.lg_ctx;
+  Runtime *runtime = ff.config.lg_hlr;
+  set_argumentmap_for_init(ff, argmap);
+  IndexLauncher launcher(DOT_INTERACTION_INIT_TASK_ID,
+                         parallel_is,
+                         TaskArgument(this, sizeof(DotInteraction)),
+                         argmap,
+                         Predicate::TRUE_PRED,
+                         false /*must*/,
+                         0 /*mapper_id*/,
+                         outputs[0]->machine_view.hash());
+  for (int i = 0; i < numInputs; i++) {
+    launcher.add_region_requirement(RegionRequirement(inputs[i]->part,
+                                                      0 /*projection id*/,
+                                                      READ_ONLY,
+                                                      EXCLUSIVE,
+                                                      inputs[i]->region));
+    launcher.add_field(i, FID_DATA);
+  }
+  launcher.add_region_requirement(RegionRequirement(outputs[0]->part,
+                                                    0 /*projection id*/,
+                                                    WRITE_ONLY,
+                                                    EXCLUSIVE,
+                                                    outputs[0]->region));
+  launcher.add_field(numInputs, FID_DATA);
+  FutureMap fm = runtime->execute_index_space(ctx, launcher);
+  fm.wait_all_results();
+  set_opmeta_from_futuremap(ff, fm);
+}
+
+/*
+  regions[0..numInputs-1](I): inputs
+  regions[numInputs](O): output
+*/
+OpMeta *DotInteraction::init_task(Task const *task,
+                                  std::vector<PhysicalRegion> const &regions,
+                                  Context ctx,
+                                  Runtime *runtime) {
+  DotInteraction const *op = (DotInteraction const *)task->args;
+  FFHandler handle = *((FFHandler const *)task->local_args);
+  assert(regions.size() == op->numInputs + 1);
+  assert(task->regions.size() == regions.size());
+  DotInteractionMeta *m = new DotInteractionMeta(handle, op);
+  m->profiling = op->profiling;
+  std::strcpy(m->op_name, op->name);
+  return m;
+}
+
+void DotInteraction::forward(FFModel const &ff) {
+  ArgumentMap argmap;
+  Context ctx = ff.config.lg_ctx;
+  Runtime *runtime = ff.config.lg_hlr;
+  set_argumentmap_for_forward(ff, argmap);
+  IndexLauncher launcher(DOT_INTERACTION_FWD_TASK_ID,
+                         parallel_is,
+                         TaskArgument(NULL, 0),
+                         argmap,
+                         Predicate::TRUE_PRED,
+                         false /*must*/,
+                         0 /*mapper_id*/,
+                         outputs[0]->machine_view.hash());
+  for (int i = 0; i < numInputs; i++) {
+    launcher.add_region_requirement(RegionRequirement(inputs[i]->part,
+                                                      0 /*projection id*/,
+                                                      READ_ONLY,
+                                                      EXCLUSIVE,
+                                                      inputs[i]->region));
+    launcher.add_field(i, FID_DATA);
+  }
+  launcher.add_region_requirement(RegionRequirement(outputs[0]->part,
+                                                    0 /*projection id*/,
+                                                    WRITE_ONLY,
+                                                    EXCLUSIVE,
+                                                    outputs[0]->region));
+  launcher.add_field(numInputs, FID_DATA);
+  runtime->execute_index_space(ctx, launcher);
+}
+
+/*
+  regions[0..num_features-1](I): inputs
+  regions[num_features](O): output
+*/
+void DotInteraction::forward_task(Task const *task,
+                                  std::vector<PhysicalRegion> const &regions,
+                                  Context ctx,
+                                  Runtime *runtime) {
+  DotInteractionMeta const *m = *((DotInteractionMeta **)task->local_args);
+  int const n = m->num_features;
+  assert(regions.size() == n + 1);
+  assert(task->regions.size() == regions.size());
+  GenericTensorAccessorR inputs[MAX_NUM_INPUTS];
+  for (int i = 0; i < n; i++) {
+    inputs[i] = helperGetGenericTensorAccessorRO(
+        DT_FLOAT, regions[i], task->regions[i], FID_DATA, ctx, runtime);
+  }
+  GenericTensorAccessorW output = helperGetGenericTensorAccessorWO(
+      DT_FLOAT, regions[n], task->regions[n], FID_DATA, ctx, runtime);
+  forward_kernel_wrapper(m, inputs, output);
+}
+
+void DotInteraction::backward(FFModel const &ff) {
+  ArgumentMap argmap;
+  Context ctx = ff.config.lg_ctx;
+  Runtime *runtime = ff.config.lg_hlr;
+  set_argumentmap_for_backward(ff, argmap);
+  IndexLauncher launcher(DOT_INTERACTION_BWD_TASK_ID,
+                         parallel_is,
+                         TaskArgument(NULL, 0),
+                         argmap,
+                         Predicate::TRUE_PRED,
+                         false /*must*/,
+                         0 /*mapper_id*/,
+                         outputs[0]->machine_view.hash());
+  for (int i = 0; i < numInputs; i++) {
+    launcher.add_region_requirement(RegionRequirement(inputs[i]->part,
+                                                      0 /*projection id*/,
+                                                      READ_ONLY,
+                                                      EXCLUSIVE,
+                                                      inputs[i]->region));
+    launcher.add_field(i, FID_DATA);
+  }
+  launcher.add_region_requirement(RegionRequirement(outputs[0]->part_grad,
+                                                    0 /*projection id*/,
+                                                    READ_ONLY,
+                                                    EXCLUSIVE,
+                                                    outputs[0]->region_grad));
+  launcher.add_field(numInputs, FID_DATA);
+  for (int i = 0; i < numInputs; i++) {
+    launcher.add_region_requirement(RegionRequirement(inputs[i]->part_grad,
+                                                      0 /*projection id*/,
+                                                      READ_WRITE,
+                                                      EXCLUSIVE,
+                                                      inputs[i]->region_grad));
+    launcher.add_field(numInputs + 1 + i, FID_DATA);
+  }
+  runtime->execute_index_space(ctx, launcher);
+}
+
+/*
+  regions[0..num_features-1](I): inputs
+  regions[num_features](I): output_grad
+  regions[num_features+1..2*num_features](I/O): input_grads
+*/
+void DotInteraction::backward_task(Task const *task,
+                                   std::vector<PhysicalRegion> const &regions,
+                                   Context ctx,
+                                   Runtime *runtime) {
+  DotInteractionMeta const *m = *((DotInteractionMeta **)task->local_args);
+  int const n = m->num_features;
+  assert(regions.size() == 2 * n + 1);
+  assert(task->regions.size() == regions.size());
+  GenericTensorAccessorR inputs[MAX_NUM_INPUTS];
+  GenericTensorAccessorW input_grads[MAX_NUM_INPUTS];
+  for (int i = 0; i < n; i++) {
+    inputs[i] = helperGetGenericTensorAccessorRO(
+        DT_FLOAT, regions[i], task->regions[i], FID_DATA, ctx, runtime);
+    input_grads[i] = helperGetGenericTensorAccessorRW(DT_FLOAT,
+                                                      regions[n + 1 + i],
+                                                      task->regions[n + 1 + i],
+                                                      FID_DATA,
+                                                      ctx,
+                                                      runtime);
+  }
+  GenericTensorAccessorR output_grad = helperGetGenericTensorAccessorRO(
+      DT_FLOAT, regions[n], task->regions[n], FID_DATA, ctx, runtime);
+  backward_kernel_wrapper(m, inputs, output_grad, input_grads);
+}
+
+bool DotInteraction::measure_operator_cost(Simulator *sim,
+                                           MachineView const &mv,
+                                           CostMetrics &cost_metrics) const {
+  assert(numInputs <= MAX_NUM_INPUTS);
+  ParallelTensorBase sub_inputs[MAX_NUM_INPUTS], sub_output;
+  if (!outputs[0]->get_sub_tensor(mv, sub_output)) {
+    return false;
+  }
+  for (int i = 0; i < numInputs; i++) {
+    if (!inputs[i]->get_sub_tensor(mv, sub_inputs[i])) {
+      return false;
+    }
+  }
+
+  DotInteractionMeta *m = new DotInteractionMeta(sim->handler, this);
+  sim->free_all();
+  bool out_of_memory = false;
+  GenericTensorAccessorR input_accs[MAX_NUM_INPUTS];
+  for (int i = 0; i < numInputs; i++) {
+    float *input_ptr =
+        (float *)sim->allocate(sub_inputs[i].get_volume(), DT_FLOAT);
+    out_of_memory = out_of_memory || (input_ptr == NULL);
+    input_accs[i] =
+        GenericTensorAccessorR(DT_FLOAT, sub_inputs[i].get_domain(), input_ptr);
+  }
+  cost_metrics.inputs_memory += cost_metrics.total_mem_diff_from(sim->offset);
+
+  Domain out_domain = sub_output.get_domain();
+  float *output_ptr = (float *)sim->allocate(sub_output.get_volume(), DT_FLOAT);
+  out_of_memory = out_of_memory || (output_ptr == NULL);
+  GenericTensorAccessorW output_acc(DT_FLOAT, out_domain, output_ptr);
+  cost_metrics.outputs_memory += cost_metrics.total_mem_diff_from(sim->offset);
+
+  if (out_of_memory) {
+    cost_metrics.forward_time = Simulator::MAXIMUM_TASK_RUN_TIME;
+    cost_metrics.backward_time = Simulator::MAXIMUM_TASK_RUN_TIME;
+    delete m;
+    return true;
+  }
+
+  std::function<void()> forward, backward;
+  forward = [&] { forward_kernel_wrapper(m, input_accs, output_acc); };
+  GenericTensorAccessorW input_grad_accs[MAX_NUM_INPUTS];
+  if (sim->computationMode == COMP_MODE_TRAINING) {
+    for (int i = 0; i < numInputs; i++) {
+      float *input_grad_ptr =
+          (float *)sim->allocate(sub_inputs[i].get_volume(), DT_FLOAT);
+      out_of_memory = out_of_memory || (input_grad_ptr == NULL);
+      input_grad_accs[i] = GenericTensorAccessorW(
+          DT_FLOAT, sub_inputs[i].get_domain(), input_grad_ptr);
+    }
+    cost_metrics.inputs_memory += cost_metrics.total_mem_diff_from(sim->offset);
+    float *output_grad_ptr =
+        (float *)sim->allocate(sub_output.get_volume(), DT_FLOAT);
+    out_of_memory = out_of_memory || (output_grad_ptr == NULL);
+    GenericTensorAccessorR output_grad_acc(
+        DT_FLOAT, out_domain, output_grad_ptr);
+    cost_metrics.outputs_memory +=
+        cost_metrics.total_mem_diff_from(sim->offset);
+    if (out_of_memory) {
+      cost_metrics.forward_time = Simulator::MAXIMUM_TASK_RUN_TIME;
+      cost_metrics.backward_time = Simulator::MAXIMUM_TASK_RUN_TIME;
+      delete m;
+      return true;
+    }
+    backward = [&] {
+      backward_kernel_wrapper(m, input_accs, output_grad_acc, input_grad_accs);
+    };
+  }
+
+  inner_measure_operator_cost(sim, forward, backward, cost_metrics);
+
+  if (sim->computationMode == COMP_MODE_TRAINING) {
+    printf("[Measure DotInteraction] name(%s) num_features(%d) "
+           "forward_time(%.4lf) backward_time(%.4lf)\n",
+           name,
+           numInputs,
+           cost_metrics.forward_time,
+           cost_metrics.backward_time);
+  } else {
+    printf("[Measure DotInteraction] name(%s) num_features(%d) "
+           "forward_time(%.4lf)\n",
+           name,
+           numInputs,
+           cost_metrics.forward_time);
+  }
+  delete m;
+  return true;
+}
+
+}; // namespace FlexFlow
+
+namespace std {
+size_t hash<FlexFlow::DotInteractionParams>::operator()(
+    FlexFlow::DotInteractionParams const &params) const {
+  size_t key = 0;
+  hash_combine(key, params.self_interaction);
+  hash_combine(key, params.concat_dense);
+  return key;
+}
+}; // namespace std
@@ -0,0 +1,296 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flexflow/ops/dot_interaction.h"
+#include "flexflow/utils/cuda_helper.h"
+
+namespace FlexFlow {
+// declare Legion names
+using Legion::Domain;
+
+namespace {
+
+int const DOT_INTERACTION_THREADS = 256;
+// Stage the features of a sample in shared memory when they fit
+size_t const DOT_INTERACTION_MAX_STAGED = 48 * 1024;
+
+__device__ inline int pair_base(int i, bool self_interaction) {
+  return self_interaction ? i * (i + 1) / 2 : i * (i - 1) / 2;
+}
+
+// Inverse of DotInteractionShape::pair_index
+__device__ inline void
+    pair_from_index(int k, bool self_interaction, int &i, int &j) {
+  float root = sqrtf(8.0f * k + 1.0f);
+  i = self_interaction ? (int)((root - 1.0f) / 2.0f)
+                       : (int)((root + 1.0f) / 2.0f);
+  // Fix the rounding of the estimate
+  while (pair_base(i + 1, self_interaction) <= k) {
+    i++;
+  }
+  while (pair_base(i, self_interaction) > k) {
+    i--;
+  }
+  j = k - pair_base(i, self_interaction);
+}
+
+// One block per sample: the block loads the features of the sample once
+// and each thread computes a pair
+template <bool STAGED>
+__global__ void dot_interaction_forward_kernel(float const *const *inputs,
+                                               float *output,
+                                               int num_samples,
+                                               int num_features,
+                                               int feature_size,
+                                               bool self_interaction,
+                                               bool concat_dense) {
+  extern __shared__ float staged[];
+  int const d = feature_size;
+  int const num_pairs = pair_base(num_features, self_interaction);
+  int const out_size = (concat_dense ? d : 0) + num_pairs;
+  for (int n = blockIdx.x; n < num_samples; n += gridDim.x) {
+    if (STAGED) {
+      for (int t = threadIdx.x; t < num_features * d; t += blockDim.x) {
+        staged[t] = inputs[t / d][(size_t)n * d + t % d];
+      }
+      __syncthreads();
+    }
+    float *out = output + (size_t)n * out_size;
+    if (concat_dense) {
+      for (int e = threadIdx.x; e < d; e += blockDim.x) {
+        out[e] = inputs[0][(size_t)n * d + e];
+      }
+      out += d;
+    }
+    for (int k = threadIdx.x; k < num_pairs; k += blockDim.x) {
+      int i, j;
+      pair_from_index(k, self_interaction, i, j);
+      float sum = 0.0f;
+      if (STAGED) {
+        for (int e = 0; e < d; e++) {
+          sum += staged[i * d + e] * staged[j * d + e];
+        }
+      } else {
+        float const *x_i = inputs[i] + (size_t)n * d;
+        float const *x_j = inputs[j] + (size_t)n * d;
+        for (int e = 0; e < d; e++) {
+          sum += x_i[e] * x_j[e];
+        }
+      }
+      out[k] = sum;
+    }
+    if (STAGED) {
+      __syncthreads();
+    }
+  }
+}
+
+// One block per sample, each thread owns an element of an input gradient,
+// so the accumulation needs no atomics
+template <bool STAGED>
+__global__ void dot_interaction_backward_kernel(float const *const *inputs,
+                                                float const *output_grad,
+                                                float *const *input_grads,
+                                                int num_samples,
+                                                int num_features,
+                                                int feature_size,
+                                                bool self_interaction,
+                                                bool concat_dense) {
+  extern __shared__ float staged[];
+  int const d = feature_size;
+  int const num_pairs = pair_base(num_features, self_interaction);
+  int const out_size = (concat_dense ? d : 0) + num_pairs;
+  for (int n = blockIdx.x; n < num_samples; n += gridDim.x) {
+    if (STAGED) {
+      for (int t = threadIdx.x; t < num_features * d; t += blockDim.x) {
+        staged[t] = inputs[t / d][(size_t)n * d + t % d];
+      }
+      __syncthreads();
+    }
+    float const *grad = output_grad + (size_t)n * out_size;
+    float const *pair_grad = concat_dense ? grad + d : grad;
+    for (int t = threadIdx.x; t < num_features * d; t += blockDim.x) {
+      int f = t / d, e = t % d;
+      float sum = (concat_dense && f == 0) ? grad[e] : 0.0f;
+      for (int o = 0; o < num_features; o++) {
+        float x_o = STAGED ? staged[o * d + e] : inputs[o][(size_t)n * d + e];
+        if (o == f) {
+          if (self_interaction) {
+            sum += 2.0f * pair_grad[pair_base(f, true) + f] * x_o;
+          }
+        } else {
+          int hi = max(o, f), lo = min(o, f);
+          sum += pair_grad[pair_base(hi, self_interaction) + lo] * x_o;
+        }
+      }
+      input_grads[f][(size_t)n * d + e] += sum;
+    }
+    if (STAGED) {
+      __syncthreads();
+    }
+  }
+}
+
+} // namespace
+
+/*static*/
+void DotInteraction::forward_kernel_wrapper(
+    DotInteractionMeta const *m,
+    GenericTensorAccessorR const *inputs,
+    GenericTensorAccessorW const &output) {
+  cudaStream_t stream;
+  checkCUDA(get_legion_stream(&stream));
+  cudaEvent_t t_start, t_end;
+  if (m->profiling) {
+    cudaEventCreate(&t_start);
+    cudaEventCreate(&t_end);
+    cudaEventRecord(t_start, stream);
+  }
+  int const n = m->num_features;
+  Domain in_domain = inputs[0].domain;
+  int feature_size = in_domain.hi()[0] - in_domain.lo()[0] + 1;
+  int num_samples = in_domain.get_volume() / feature_size;
+  float const *input_ptrs[MAX_NUM_INPUTS];
+  for (int i = 0; i < n; i++) {
+    assert(inputs[i].domain.get_volume() == in_domain.get_volume());
+    input_ptrs[i] = inputs[i].get_float_ptr();
+  }
+  cudaMemcpyAsync(m->dev_input_ptrs,
+                  input_ptrs,
+                  n * sizeof(float *),
+                  cudaMemcpyHostToDevice,
+                  stream);
+  int num_blocks = std::min(num_samples, BLOCK_SIZE_LIMIT);
+  size_t staged_size = (size_t)n * feature_size * sizeof(float);
+  if (staged_size <= DOT_INTERACTION_MAX_STAGED) {
+    dot_interaction_forward_kernel<true>
+        <<<num_blocks, DOT_INTERACTION_THREADS, staged_size, stream>>>(
+            m->dev_input_ptrs,
+            output.get_float_ptr(),
+            num_samples,
+            n,
+            feature_size,
+            m->self_interaction,
+            m->concat_dense);
+  } else {
+    dot_interaction_forward_kernel<false>
+        <<<num_blocks, DOT_INTERACTION_THREADS, 0, stream>>>(
+            m->dev_input_ptrs,
+            output.get_float_ptr(),
+            num_samples,
+            n,
+            feature_size,
+            m->self_interaction,
+            m->concat_dense);
+  }
+  if (m->profiling) {
+    cudaEventRecord(t_end, stream);
+    checkCUDA(cudaEventSynchronize(t_end));
+    float elapsed = 0;
+    checkCUDA(cudaEventElapsedTime(&elapsed, t_start, t_end));
+    cudaEventDestroy(t_start);
+    cudaEventDestroy(t_end);
+    printf("[%s] forward time = %.2lfms\n", m->op_name, elapsed);
+  }
+}
+
+/*static*/
+void DotInteraction::backward_kernel_wrapper(
+    DotInteractionMeta const *m,
+    GenericTensorAccessorR const *inputs,
+    GenericTensorAccessorR const &output_grad,
+    GenericTensorAccessorW const *input_grads) {
+  cudaStream_t stream;
+  checkCUDA(get_legion_stream(&stream));
+  cudaEvent_t t_start, t_end;
+  if (m->profiling) {
+    cudaEventCreate(&t_start);
+    cudaEventCreate(&t_end);
+    cudaEventRecord(t_start, stream);
+  }
+  int const n = m->num_features;
+  Domain in_domain = inputs[0].domain;
+  int feature_size = in_domain.hi()[0] - in_domain.lo()[0] + 1;
+  int num_samples = in_domain.get_volume() / feature_size;
+  float const *input_ptrs[MAX_NUM_INPUTS];
+  float *input_grad_ptrs[MAX_NUM_INPUTS];
+  for (int i = 0; i < n; i++) {
+    assert(input_grads[i].domain.get_volume() == in_domain.get_volume());
+    input_ptrs[i] = inputs[i].get_float_ptr();
+    input_grad_ptrs[i] = input_grads[i].get_float_ptr();
+  }
+  cudaMemcpyAsync(m->dev_input_ptrs,
+                  input_ptrs,
+                  n * sizeof(float *),
+                  cudaMemcpyHostToDevice,
+                  stream);
+  cudaMemcpyAsync(m->dev_input_grad_ptrs,
+                  input_grad_ptrs,
+                  n * sizeof(float *),
+                  cudaMemcpyHostToDevice,
+                  stream);
+  int num_blocks = std::min(num_samples, BLOCK_SIZE_LIMIT);
+  size_t staged_size = (size_t)n * feature_size * sizeof(float);
+  if (staged_size <= DOT_INTERACTION_MAX_STAGED) {
+    dot_interaction_backward_kernel<true>
+        <<<num_blocks, DOT_INTERACTION_THREADS, staged_size, stream>>>(
+            m->dev_input_ptrs,
+            output_grad.get_float_ptr(),
+            m->dev_input_grad_ptrs,
+            num_samples,
+            n,
+            feature_size,
+            m->self_interaction,
+            m->concat_dense);
+  } else {
+    dot_interaction_backward_kernel<false>
+        <<<num_blocks, DOT_INTERACTION_THREADS, 0, stream>>>(
+            m->dev_input_ptrs,
+            output_grad.get_float_ptr(),
+            m->dev_input_grad_ptrs,
+            num_samples,
+            n,
+            feature_size,
+            m->self_interaction,
+            m->concat_dense);
+  }
+  if (m->profiling) {
+    cudaEventRecord(t_end, stream);
+    checkCUDA(cudaEventSynchronize(t_end));
+    float elapsed = 0;
+    checkCUDA(cudaEventElapsedTime(&elapsed, t_start, t_end));
+    cudaEventDestroy(t_start);
+    cudaEventDestroy(t_end);
+    printf("[%s] backward time = %.2lfms\n", m->op_name, elapsed);
+  }
+}
+
+DotInteractionMeta::DotInteractionMeta(FFHandler handler,
+                                       DotInteraction const *op)
+    : OpMeta(handler, op) {
+  num_features = op->numInputs;
+  self_interaction = op->self_interaction;
+  concat_dense = op->concat_dense;
+  std::strcpy(op_name, op->name);
+  checkCUDA(cudaMalloc(&dev_input_ptrs, num_features * sizeof(float *)));
+  checkCUDA(cudaMalloc(&dev_input_grad_ptrs, num_features * sizeof(float *)));
+}
+
+DotInteractionMeta::~DotInteractionMeta(void) {
+  checkCUDA(cudaFree(dev_input_ptrs));
+  checkCUDA(cudaFree(dev_input_grad_ptrs));
+}
+
+}; // namespace FlexFlow
@@ -0,0 +1,610 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flexflow/ops/element_expression.h"
+#include "flexflow/utils/hash_utils.h"
+#include "legion/legion_utilities.h"
+
+namespace FlexFlow {
+
+// declare Legion names
+using Legion::ArgumentMap;
+using Legion::Context;
+using Legion::coord_t;
+using Legion::Domain;
+using Legion::FutureMap;
+using Legion::IndexLauncher;
+using Legion::PhysicalRegion;
+using Legion::Predicate;
+using Legion::Rect;
+using Legion::RegionRequirement;
+using Legion::Runtime;
+using Legion::Task;
+using Legion::TaskArgument;
+using Legion::TaskLauncher;
+using PCG::Node;
+
+bool operator==(ElementExpressionParams const &lhs,
+                ElementExpressionParams const &rhs) {
+  if (lhs.program.num_inputs != rhs.program.num_inputs ||
+      lhs.program.num_nodes != rhs.program.num_nodes) {
+    return false;
+  }
+  for (int j = 0; j < lhs.program.num_nodes; j++) {
+    ExpressionNode const &a = lhs.program.nodes[j];
+    ExpressionNode const &b = rhs.program.nodes[j];
+    if (a.op_type != b.op_type || a.lhs != b.lhs || a.rhs != b.rhs ||
+        a.scalar != b.scalar) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ElementExpressionParams::is_valid(
+    std::vector<ParallelTensorShape> const &inputs) const {
+  if ((int)inputs.size() != program.num_inputs || program.num_nodes < 1) {
+    return false;
+  }
+  for (auto const &input : inputs) {
+    if (!input.is_valid()) {
+      return false;
+    }
+    if (input.num_dims != inputs[0].num_dims) {
+      return false;
+    }
+  }
+  // An input broadcasts along the dimensions where it has size 1
+  for (int i = 0; i < inputs[0].num_dims; i++) {
+    for (auto const &a : inputs) {
+      for (auto const &b : inputs) {
+        if (a.dims[i].size > 1 && b.dims[i].size > 1 &&
+            a.dims[i] != b.dims[i]) {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+ElementExpressionParams ElementExpression::get_params() const {
+  ElementExpressionParams params;
+  params.program = this->program;
+  return params;
+}
+
+/*static*/
+bool ElementExpression::can_fuse(Layer const *layer) {
+  bool unary = ExpressionProgram::is_unary(layer->op_type);
+  bool binary = ExpressionProgram::is_binary(layer->op_type);
+  if (!(unary && layer->numInputs == 1) && !(binary && layer->numInputs == 2)) {
+    return false;
+  }
+  if (layer->data_type != DT_FLOAT || layer->numOutputs != 1) {
+    return false;
+  }
+  int numdim = layer->outputs[0]->num_dims;
+  for (int i = 0; i < layer->numInputs; i++) {
+    Tensor t = layer->inputs[i];
+    if (t->data_type != DT_FLOAT || t->num_dims != numdim) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*static*/
+bool ElementExpression::build_program(std::vector<Layer *> const &layers,
+                                      ExpressionProgram &program,
+                                      std::vector<Tensor> &inputs) {
+  if (layers.size() > MAX_EXPRESSION_NODES) {
+    return false;
+  }
+  std::map<Tensor, int> operands;
+  for (Layer const *l : layers) {
+    operands[l->outputs[0]] = -1;
+  }
+  // The tensors not computed by the layers are the inputs
+  inputs.clear();
+  for (Layer const *l : layers) {
+    for (int i = 0; i < l->numInputs; i++) {
+      Tensor t = l->inputs[i];
+      if (operands.find(t) == operands.end()) {
+        operands[t] = inputs.size();
+        inputs.push_back(t);
+      }
+    }
+  }
+  if (inputs.size() > MAX_EXPRESSION_INPUTS) {
+    return false;
+  }
+  program = ExpressionProgram();
+  program.num_inputs = inputs.size();
+  for (Layer const *l : layers) {
+    int x = operands[l->inputs[0]];
+    assert(x >= 0 && "The layers are not in topological order");
+    if (l->numInputs == 1) {
+      float scalar = 0.0f;
+      l->get_float_property("scalar", scalar);
+      operands[l->outputs[0]] = program.add_unary(l->op_type, x, scalar);
+    } else {
+      int y = operands[l->inputs[1]];
+      assert(y >= 0 && "The layers are not in topological order");
+      operands[l->outputs[0]] = program.add_binary(l->op_type, x, y);
+    }
+  }
+  return true;
+}
+
+/*static*/
+Layer *ElementExpression::create_layer(FFModel &model,
+                                       std::vector<Tensor> const &inputs,
+                                       ExpressionProgram const &program,
+                                       char const *name) {
+  assert((int)inputs.size() == program.num_inputs);
+  assert(inputs.size() <= MAX_EXPRESSION_INPUTS);
+  Layer *expr = new Layer(&model,
+                          OP_ELEMENT_EXPRESSION,
+                          DT_FLOAT,
+                          name,
+                          inputs.size() /*inputs*/,
+                          0 /*weights*/,
+                          1 /*outputs*/,
+                          inputs.data());
+  // Each node is stored as its (op_type, lhs, rhs) and a scalar property
+  std::vector<int> nodes;
+  for (int j = 0; j < program.num_nodes; j++) {
+    ExpressionNode const &node = program.nodes[j];
+    nodes.push_back(node.op_type);
+    nodes.push_back(node.lhs);
+    nodes.push_back(node.rhs);
+    expr->add_float_property("scalar" + std::to_string(j), node.scalar);
+  }
+  expr->add_int_vector_property("nodes", nodes);
+  return expr;
+}
+
+Tensor FFModel::element_expression(std::vector<Tensor> const &inputs,
+                                   ExpressionProgram const &program,
+                                   char const *name) {
+  Layer *expr = ElementExpression::create_layer(*this, inputs, program, name);
+  int numdim = inputs[0]->num_dims;
+  int dims[MAX_TENSOR_DIM];
+  for (int i = 0; i < numdim; i++) {
+    dims[i] = 1;
+  }
+  for (auto const &t : inputs) {
+    assert(t->data_type == DT_FLOAT);
+    assert(t->num_dims == numdim);
+    for (int i = 0; i < numdim; i++) {
+      assert(t->dims[i] == 1 || dims[i] == 1 || t->dims[i] == dims[i]);
+      dims[i] = std::max(dims[i], t->dims[i]);
+    }
+  }
+  expr->outputs[0] = create_tensor_legion_ordering(
+      numdim, dims, DT_FLOAT, expr, 0, true /*create_grad*/);
+  layers.push_back(expr);
+  return expr->outputs[0];
+}
+
+Op *ElementExpression::create_operator_from_layer(
+    FFModel &model,
+    Layer const *layer,
+    std::vector<ParallelTensor> const &inputs) {
+  std::vector<int> nodes;
+  layer->get_int_vector_property("nodes", nodes);
+  assert(nodes.size() % 3 == 0);
+  ExpressionProgram program;
+  program.num_inputs = inputs.size();
+  for (size_t j = 0; j < nodes.size() / 3; j++) {
+    OperatorType op_type = (OperatorType)nodes[3 * j];
+    float scalar;
+    layer->get_float_property("scalar" + std::to_string(j), scalar);
+    if (nodes[3 * j + 2] < 0) {
+      program.add_unary(op_type, nodes[3 * j + 1], scalar);
+    } else {
+      program.add_binary(op_type, nodes[3 * j + 1], nodes[3 * j + 2]);
+    }
+  }
+  return new ElementExpression(
+      model, program, inputs.size(), inputs.data(), layer->name);
+}
+
+ElementExpression::ElementExpression(FFModel &model,
+                                     ExpressionProgram const &_program,
+                                     int _n,
+                                     ParallelTensor const *_inputs,
+                                     char const *name)
+    : Op(model,
+         OP_ELEMENT_EXPRESSION,
+         DT_FLOAT,
+         name,
+         _n /*inputs*/,
+         0 /*weights*/,
+         1 /*outputs*/,
+         _inputs),
+      program(_program) {
+  assert(program.num_inputs == numInputs);
+  assert(numInputs <= MAX_EXPRESSION_INPUTS);
+  int num_dim = inputs[0]->num_dims;
+  ParallelDim dims[MAX_TENSOR_DIM];
+  for (int i = 0; i < num_dim; i++) {
+    dims[i] = inputs[0]->dims[i];
+  }
+  for (int j = 0; j < numInputs; j++) {
+    assert(inputs[j]->data_type == DT_FLOAT);
+    assert(inputs[j]->num_dims == num_dim);
+    for (int i = 0; i < num_dim; i++) {
+      if (inputs[j]->dims[i].size == 1) {
+        continue;
+      }
+      if (dims[i].size == 1) {
+        dims[i] = inputs[j]->dims[i];
+      } else {
+        assert(inputs[j]->dims[i] == dims[i] &&
+               "Operands could not be broadcast together");
+      }
+    }
+  }
+  numOutputs = 1;
+  outputs[0] = model.create_parallel_tensor_legion_ordering(
+      num_dim, dims, DT_FLOAT, this);
+}
+
+ElementExpression::ElementExpression(FFModel &model,
+                                     ElementExpressionParams const &params,
+                                     std::vector<ParallelTensor> const &inputs,
+                                     char const *name)
+    : ElementExpression(
+          model, params.program, inputs.size(), inputs.data(), name) {}
+
+void ElementExpression::serialize(Legion::Serializer &sez) const {
+  sez.serialize(program.num_nodes);
+  for (int j = 0; j < program.num_nodes; j++) {
+    sez.serialize(program.nodes[j].op_type);
+    sez.serialize(program.nodes[j].lhs);
+    sez.serialize(program.nodes[j].rhs);
+    sez.serialize(program.nodes[j].scalar);
+  }
+}
+
+/*static*/
+Node ElementExpression::deserialize(FFModel &ff,
+                                    Legion::Deserializer &dez,
+                                    ParallelTensor inputs[],
+                                    int num_inputs) {
+  ElementExpressionParams params;
+  params.program.num_inputs = num_inputs;
+  dez.deserialize(params.program.num_nodes);
+  assert(params.program.num_nodes <= MAX_EXPRESSION_NODES);
+  for (int j = 0; j < params.program.num_nodes; j++) {
+    dez.deserialize(params.program.nodes[j].op_type);
+    dez.deserialize(params.program.nodes[j].lhs);
+    dez.deserialize(params.program.nodes[j].rhs);
+    dez.deserialize(params.program.nodes[j].scalar);
+  }
+  return ff.get_or_create_node<ElementExpression>({inputs, inputs + num_inputs},
+                                                  params);
+}
+
+Op *ElementExpression::materialize(FFModel &ff,
+                                   ParallelTensor inputs[],
+                                   int num_inputs) const {
+  return new ElementExpression(
+      ff, this->program, num_inputs, inputs, this->name);
+}
+
+/*static*/
+ExpressionShape
+    ElementExpression::get_shape(Domain const &output,
+                                 GenericTensorAccessorR const *inputs,
+                                 int num_inputs) {
+  ExpressionShape shape;
+  shape.num_dims = output.get_dim();
+  for (int d = 0; d < shape.num_dims; d++) {
+    shape.dims[d] = output.hi()[d] - output.lo()[d] + 1;
+    for (int i = 0; i < num_inputs; i++) {
+      assert(inputs[i].domain.get_dim() == shape.num_dims);
+      shape.input_dims[i][d] =
+          inputs[i].domain.hi()[d] - inputs[i].domain.lo()[d] + 1;
+      assert(shape.input_dims[i][d] == 1 ||
+             shape.input_dims[i][d] == shape.dims[d]);
+    }
+  }
+  return shape;
+}
+
+void ElementExpression::init(FFModel const &ff) {
+  assert(check_output_input_weight_same_parallel_is());
+  parallel_is = outputs[0]->parallel_is;
+  ArgumentMap argmap;
+  Context ctx = ff.config.lg_ctx;
+  Runtime *runtime = ff.config.lg_hlr;
+  set_argumentmap_for_init(ff, argmap);
+  IndexLauncher launcher(ELEMENT_EXPRESSION_INIT_TASK_ID,
+                         parallel_is,
+                         TaskArgument(this, sizeof(ElementExpression)),
+                         argmap,
+                         Predicate::TRUE_PRED,
+                         false /*must*/,
+                         0 /*mapper_id*/,
+                         outputs[0]->machine_view.hash());
+  for (int i = 0; i < numInputs; i++) {
+    launcher.add_region_requirement(RegionRequirement(inputs[i]->part,
+                                                      0 /*projection id*/,
+                                                      READ_ONLY,
+                                                      EXCLUSIVE,
+                                                      inputs[i]->region));
+    launcher.add_field(i, FID_DATA);
+  }
+  launcher.add_region_requirement(RegionRequirement(outputs[0]->part,
+                                                    0 /*projection id*/,
+                                                    WRITE_ONLY,
+                                                    EXCLUSIVE,
+                                                    outputs[0]->region));
+  launcher.add_field(numInputs, FID_DATA);
+  FutureMap fm = runtime->execute_index_space(ctx, launcher);
+  fm.wait_all_results();
+  set_opmeta_from_futuremap(ff, fm);
+}
+
+/*
+  regions[0..numInputs-1](I): inputs
+  regions[numInputs](O): output
+*/
+OpMeta *ElementExpression::init_task(Task const *task,
+                                     std::vector<PhysicalRegion> const &regions,
+                                     Context ctx,
+                                     Runtime *runtime) {
+  ElementExpression const *op = (ElementExpression const *)task->args;
+  FFHandler handle = *((FFHandler const *)task->local_args);
+  assert(regions.size() == op->numInputs + 1);
+  assert(task->regions.size() == regions.size());
+  ElementExpressionMeta *m = new ElementExpressionMeta(handle, op);
+  m->profiling = op->profiling;
+  std::strcpy(m->op_name, op->name);
+  return m;
+}
+
+void ElementExpression::forward(FFModel const &ff) {
+  ArgumentMap argmap;
+  Context ctx = ff.config.lg_ctx;
+  Runtime *runtime = ff.config.lg_hlr;
+  set_argumentmap_for_forward(ff, argmap);
+  IndexLauncher launcher(ELEMENT_EXPRESSION_FWD_TASK_ID,
+                         parallel_is,
+                         TaskArgument(NULL, 0),
+                         argmap,
+                         Predicate::TRUE_PRED,
+                         false /*must*/,
+                         0 /*mapper_id*/,
+                         outputs[0]->machine_view.hash());
+  for (int i = 0; i < numInputs; i++) {
+    launcher.add_region_requirement(RegionRequirement(inputs[i]->part,
+                                                      0 /*projection id*/,
+                                                      READ_ONLY,
+                                                      EXCLUSIVE,
+                                                      inputs[i]->region));
+    launcher.add_field(i, FID_DATA);
+  }
+  launcher.add_region_requirement(RegionRequirement(outputs[0]->part,
+                                                    0 /*projection id*/,
+                                                    WRITE_ONLY,
+                                                    EXCLUSIVE,
+                                                    outputs[0]->region));
+  launcher.add_field(numInputs, FID_DATA);
+  runtime->execute_index_space(ctx, launcher);
+}
+
+/*
+  regions[0..num_inputs-1](I): inputs
+  regions[num_inputs](O): output
+*/
+void ElementExpression::forward_task(Task const *task,
+                                     std::vector<PhysicalRegion> const &regions,
+                                     Context ctx,
+                                     Runtime *runtime) {
+  ElementExpressionMeta const *m =
+      *((ElementExpressionMeta **)task->local_args);
+  int const n = m->program.num_inputs;
+  assert(regions.size() == n + 1);
+  assert(task->regions.size() == regions.size());
+  GenericTensorAccessorR inputs[MAX_EXPRESSION_INPUTS];
+  for (int i = 0; i < n; i++) {
+    inputs[i] = helperGetGenericTensorAccessorRO(
+        DT_FLOAT, regions[i], task->regions[i], FID_DATA, ctx, runtime);
+  }
+  GenericTensorAccessorW output = helperGetGenericTensorAccessorWO(
+      DT_FLOAT, regions[n], task->regions[n], FID_DATA, ctx, runtime);
+  forward_kernel_wrapper(m, inputs, output);
+}
+
+void ElementExpression::backward(FFModel const &ff) {
+  ArgumentMap argmap;
+  Context ctx = ff.config.lg_ctx;
+  Runtime *runtime = ff.config.lg_hlr;
+  set_argumentmap_for_backward(ff, argmap);
+  IndexLauncher launcher(ELEMENT_EXPRESSION_BWD_TASK_ID,
+                         parallel_is,
+                         TaskArgument(NULL, 0),
+                         argmap,
+                         Predicate::TRUE_PRED,
+                         false /*must*/,
+                         0 /*mapper_id*/,
+                         outputs[0]->machine_view.hash());
+  for (int i = 0; i < numInputs; i++) {
+    launcher.add_region_requirement(RegionRequirement(inputs[i]->part,
+                                                      0 /*projection id*/,
+                                                      READ_ONLY,
+                                                      EXCLUSIVE,
+                                                      inputs[i]->region));
+    launcher.add_field(i, FID_DATA);
+  }
+  launcher.add_region_requirement(RegionRequirement(outputs[0]->part_grad,
+                                                    0 /*projection id*/,
+                                                    READ_ONLY,
+                                                    EXCLUSIVE,
+                                                    outputs[0]->region_grad));
+  launcher.add_field(numInputs, FID_DATA);
+  for (int i = 0; i < numInputs; i++) {
+    launcher.add_region_requirement(RegionRequirement(inputs[i]->part_grad,
+                                                      0 /*projection id*/,
+                                                      READ_WRITE,
+                                                      EXCLUSIVE,
+                                                      inputs[i]->region_grad));
+    launcher.add_field(numInputs + 1 + i, FID_DATA);
+  }
+  runtime->execute_index_space(ctx, launcher);
+}
+
+/*
+  regions[0..num_inputs-1](I): inputs
+  regions[num_inputs](I): output_grad
+  regions[num_inputs+1..2*num_inputs](I/O): input_grads
+*/
+void ElementExpression::backward_task(
+    Task const *task,
+    std::vector<PhysicalRegion> const &regions,
+    Context ctx,
+    Runtime *runtime) {
+  ElementExpressionMeta const *m =
+      *((ElementExpressionMeta **)task->local_args);
+  int const n = m->program.num_inputs;
+  assert(regions.size() == 2 * n + 1);
+  assert(task->regions.size() == regions.size());
+  GenericTensorAccessorR inputs[MAX_EXPRESSION_INPUTS];
+  GenericTensorAccessorW input_grads[MAX_EXPRESSION_INPUTS];
+  for (int i = 0; i < n; i++) {
+    inputs[i] = helperGetGenericTensorAccessorRO(
+        DT_FLOAT, regions[i], task->regions[i], FID_DATA, ctx, runtime);
+    input_grads[i] = helperGetGenericTensorAccessorRW(DT_FLOAT,
+                                                      regions[n + 1 + i],
+                                                      task->regions[n + 1 + i],
+                                                      FID_DATA,
+                                                      ctx,
+                                                      runtime);
+  }
+  GenericTensorAccessorR output_grad = helperGetGenericTensorAccessorRO(
+      DT_FLOAT, regions[n], task->regions[n], FID_DATA, ctx, runtime);
+  backward_kernel_wrapper(m, inputs, output_grad, input_grads);
+}
+
+bool ElementExpression::measure_operator_cost(
+    Simulator *sim, MachineView const &mv, CostMetrics &cost_metrics) const {
+  assert(numInputs <= MAX_EXPRESSION_INPUTS);
+  ParallelTensorBase sub_inputs[MAX_EXPRESSION_INPUTS], sub_output;
+  if (!outputs[0]->get_sub_tensor(mv, sub_output)) {
+    return false;
+  }
+  for (int i = 0; i < numInputs; i++) {
+    if (!inputs[i]->get_sub_tensor(mv, sub_inputs[i])) {
+      return false;
+    }
+  }
+
+  ElementExpressionMeta *m = new ElementExpressionMeta(sim->handler, this);
+  sim->free_all();
+  bool out_of_memory = false;
+  GenericTensorAccessorR input_accs[MAX_EXPRESSION_INPUTS];
+  for (int i = 0; i < numInputs; i++) {
+    float *input_ptr =
+        (float *)sim->allocate(sub_inputs[i].get_volume(), DT_FLOAT);
+    out_of_memory = out_of_memory || (input_ptr == NULL);
+    input_accs[i] =
+        GenericTensorAccessorR(DT_FLOAT, sub_inputs[i].get_domain(), input_ptr);
+  }
+  cost_metrics.inputs_memory += cost_metrics.total_mem_diff_from(sim->offset);
+
+  Domain out_domain = sub_output.get_domain();
+  float *output_ptr = (float *)sim->allocate(sub_output.get_volume(), DT_FLOAT);
+  out_of_memory = out_of_memory || (output_ptr == NULL);
+  GenericTensorAccessorW output_acc(DT_FLOAT, out_domain, output_ptr);
+  cost_metrics.outputs_memory += cost_metrics.total_mem_diff_from(sim->offset);
+
+  if (out_of_memory) {
+    cost_metrics.forward_time = Simulator::MAXIMUM_TASK_RUN_TIME;
+    cost_metrics.backward_time = Simulator::MAXIMUM_TASK_RUN_TIME;
+    delete m;
+    return true;
+  }
+
+  std::function<void()> forward, backward;
+  forward = [&] { forward_kernel_wrapper(m, input_accs, output_acc); };
+  GenericTensorAccessorW input_grad_accs[MAX_EXPRESSION_INPUTS];
+  if (sim->computationMode == COMP_MODE_TRAINING) {
+    for (int i = 0; i < numInputs; i++) {
+      float *input_grad_ptr =
+          (float *)sim->allocate(sub_inputs[i].get_volume(), DT_FLOAT);
+      out_of_memory = out_of_memory || (input_grad_ptr == NULL);
+      input_grad_accs[i] = GenericTensorAccessorW(
+          DT_FLOAT, sub_inputs[i].get_domain(), input_grad_ptr);
+    }
+    cost_metrics.inputs_memory += cost_metrics.total_mem_diff_from(sim->offset);
+    float *output_grad_ptr =
+        (float *)sim->allocate(sub_output.get_volume(), DT_FLOAT);
+    out_of_memory = out_of_memory || (output_grad_ptr == NULL);
+    GenericTensorAccessorR output_grad_acc(
+        DT_FLOAT, out_domain, output_grad_ptr);
+    cost_metrics.outputs_memory +=
+        cost_metrics.total_mem_diff_from(sim->offset);
+    if (out_of_memory) {
+      cost_metrics.forward_time = Simulator::MAXIMUM_TASK_RUN_TIME;
+      cost_metrics.backward_time = Simulator::MAXIMUM_TASK_RUN_TIME;
+      delete m;
+      return true;
+    }
+    backward = [&] {
+      backward_kernel_wrapper(m, input_accs, output_grad_acc, input_grad_accs);
+    };
+  }
+
+  inner_measure_operator_cost(sim, forward, backward, cost_metrics);
+
+  if (sim->computationMode == COMP_MODE_TRAINING) {
+    printf("[Measure ElementExpression] name(%s) num_nodes(%d) "
+           "forward_time(%.4lf) backward_time(%.4lf)\n",
+           name,
+           program.num_nodes,
+           cost_metrics.forward_time,
+           cost_metrics.backward_time);
+  } else {
+    printf("[Measure ElementExpression] name(%s) num_nodes(%d) "
+           "forward_time(%.4lf)\n",
+           name,
+           program.num_nodes,
+           cost_metrics.forward_time);
+  }
+  delete m;
+  return true;
+}
+
+}; // namespace FlexFlow
+
+namespace std {
+size_t hash<FlexFlow::ElementExpressionParams>::operator()(
+    FlexFlow::ElementExpressionParams const &params) const {
+  size_t key = 0;
+  hash_combine(key, params.program.num_inputs);
+  hash_combine(key, params.program.num_nodes);
+  for (int j = 0; j < params.program.num_nodes; j++) {
+    hash_combine(key, params.program.nodes[j].op_type);
+    hash_combine(key, params.program.nodes[j].lhs);
+    hash_combine(key, params.program.nodes[j].rhs);
+    hash_combine(key, params.program.nodes[j].scalar);
+  }
+  return key;
+}
+}; // namespace std
@@ -0,0 +1,190 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flexflow/ops/element_expression.h"
+#include "flexflow/utils/cuda_helper.h"
+
+namespace FlexFlow {
+
+// declare Legion names
+using Legion::coord_t;
+using Legion::Domain;
+
+using namespace FlexFlow::Kernels::ElementExpression;
+
+namespace {
+
+// Passed by value so that a launch needs no copy of the pointers
+struct ExpressionPointers {
+  float const *inputs[MAX_EXPRESSION_INPUTS];
+  float *input_grads[MAX_EXPRESSION_INPUTS];
+};
+
+__device__ inline void evaluate(ExpressionProgram const &program,
+                                ExpressionShape const &shape,
+                                ExpressionPointers const &ptrs,
+                                coord_t idx,
+                                float *values) {
+  for (int i = 0; i < program.num_inputs; i++) {
+    values[i] = ptrs.inputs[i][shape.input_offset(i, idx)];
+  }
+  for (int j = 0; j < program.num_nodes; j++) {
+    ExpressionNode const &node = program.nodes[j];
+    values[program.num_inputs + j] =
+        node.rhs < 0
+            ? apply_unary(node.op_type, node.scalar, values[node.lhs])
+            : apply_binary(node.op_type, values[node.lhs], values[node.rhs]);
+  }
+}
+
+// Each thread evaluates the whole expression for an element
+__global__ void element_expression_forward_kernel(ExpressionProgram program,
+                                                  ExpressionShape shape,
+                                                  ExpressionPointers ptrs,
+                                                  float *output,
+                                                  coord_t volume) {
+  CUDA_KERNEL_LOOP(idx, volume) {
+    float values[MAX_EXPRESSION_INPUTS + MAX_EXPRESSION_NODES];
+    evaluate(program, shape, ptrs, idx, values);
+    output[idx] = values[program.output()];
+  }
+}
+
+// Each thread recomputes the expression for an element and propagates its
+// gradient back to the inputs; the broadcast inputs are accumulated with
+// atomics
+__global__ void element_expression_backward_kernel(ExpressionProgram program,
+                                                   ExpressionShape shape,
+                                                   ExpressionPointers ptrs,
+                                                   float const *output_grad,
+                                                   coord_t volume) {
+  CUDA_KERNEL_LOOP(idx, volume) {
+    float values[MAX_EXPRESSION_INPUTS + MAX_EXPRESSION_NODES];
+    float grads[MAX_EXPRESSION_INPUTS + MAX_EXPRESSION_NODES];
+    evaluate(program, shape, ptrs, idx, values);
+    for (int k = 0; k < program.output(); k++) {
+      grads[k] = 0.0f;
+    }
+    grads[program.output()] = output_grad[idx];
+    for (int j = program.num_nodes - 1; j >= 0; j--) {
+      ExpressionNode const &node = program.nodes[j];
+      int const id = program.num_inputs + j;
+      if (node.rhs < 0) {
+        grads[node.lhs] += grads[id] * unary_derivative(node.op_type,
+                                                        node.scalar,
+                                                        values[node.lhs],
+                                                        values[id]);
+      } else {
+        float da, db;
+        binary_derivatives(
+            node.op_type, values[node.lhs], values[node.rhs], da, db);
+        grads[node.lhs] += grads[id] * da;
+        grads[node.rhs] += grads[id] * db;
+      }
+    }
+    for (int i = 0; i < program.num_inputs; i++) {
+      if (shape.input_volume(i) == volume) {
+        ptrs.input_grads[i][idx] += grads[i];
+      } else {
+        atomicAdd(ptrs.input_grads[i] + shape.input_offset(i, idx), grads[i]);
+      }
+    }
+  }
+}
+
+} // namespace
+
+/*static*/
+void ElementExpression::forward_kernel_wrapper(
+    ElementExpressionMeta const *m,
+    GenericTensorAccessorR const *inputs,
+    GenericTensorAccessorW const &output) {
+  cudaStream_t stream;
+  checkCUDA(get_legion_stream(&stream));
+  cudaEvent_t t_start, t_end;
+  if (m->profiling) {
+    cudaEventCreate(&t_start);
+    cudaEventCreate(&t_end);
+    cudaEventRecord(t_start, stream);
+  }
+  int const n = m->program.num_inputs;
+  ExpressionShape shape = get_shape(output.domain, inputs, n);
+  ExpressionPointers ptrs;
+  for (int i = 0; i < n; i++) {
+    ptrs.inputs[i] = inputs[i].get_float_ptr();
+  }
+  coord_t volume = output.domain.get_volume();
+  element_expression_forward_kernel<<<GET_BLOCKS(volume),
+                                      CUDA_NUM_THREADS,
+                                      0,
+                                      stream>>>(
+      m->program, shape, ptrs, output.get_float_ptr(), volume);
+  if (m->profiling) {
+    cudaEventRecord(t_end, stream);
+    checkCUDA(cudaEventSynchronize(t_end));
+    float elapsed = 0;
+    checkCUDA(cudaEventElapsedTime(&elapsed, t_start, t_end));
+    cudaEventDestroy(t_start);
+    cudaEventDestroy(t_end);
+    printf("[%s] forward time = %.2lfms\n", m->op_name, elapsed);
+  }
+}
+
+/*static*/
+void ElementExpression::backward_kernel_wrapper(
+    ElementExpressionMeta const *m,
+    GenericTensorAccessorR const *inputs,
+    GenericTensorAccessorR const &output_grad,
+    GenericTensorAccessorW const *input_grads) {
+  cudaStream_t stream;
+  checkCUDA(get_legion_stream(&stream));
+  cudaEvent_t t_start, t_end;
+  if (m->profiling) {
+    cudaEventCreate(&t_start);
+    cudaEventCreate(&t_end);
+    cudaEventRecord(t_start, stream);
+  }
+  int const n = m->program.num_inputs;
+  ExpressionShape shape = get_shape(output_grad.domain, inputs, n);
+  ExpressionPointers ptrs;
+  for (int i = 0; i < n; i++) {
+    ptrs.inputs[i] = inputs[i].get_float_ptr();
+    ptrs.input_grads[i] = input_grads[i].get_float_ptr();
+  }
+  coord_t volume = output_grad.domain.get_volume();
+  element_expression_backward_kernel<<<GET_BLOCKS(volume),
+                                       CUDA_NUM_THREADS,
+                                       0,
+                                       stream>>>(
+      m->program, shape, ptrs, output_grad.get_float_ptr(), volume);
+  if (m->profiling) {
+    cudaEventRecord(t_end, stream);
+    checkCUDA(cudaEventSynchronize(t_end));
+    float elapsed = 0;
+    checkCUDA(cudaEventElapsedTime(&elapsed, t_start, t_end));
+    cudaEventDestroy(t_start);
+    cudaEventDestroy(t_end);
+    printf("[%s] backward time = %.2lfms\n", m->op_name, elapsed);
+  }
+}
+
+ElementExpressionMeta::ElementExpressionMeta(FFHandler handler,
+                                             ElementExpression const *op)
+    : OpMeta(handler, op) {
+  program = op->program;
+  std::strcpy(op_name, op->name);
+}
+
+}; // namespace FlexFlow
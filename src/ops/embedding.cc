@@ -39,22 +39,22 @@ using Legion::TaskLauncher;
 
 using namespace FlexFlow::Kernels::Embedding;
 
-Tensor FFModel::embedding(const Tensor input,
-                          int num_entries,
-                          int out_dim,
-                          AggrMode aggr,
-                          DataType dtype,
-                          Layer const *shared_op,
-                          Initializer *kernel_initializer,
-                          char const *name) {
-  Layer *embed = new Layer(this,
+static Tensor add_embedding(FFModel &model,
+                            const Tensor input,
+                            EmbeddingTables const &tables,
+                            AggrMode aggr,
+                            DataType dtype,
+                            Initializer *kernel_initializer,
+                            char const *name) {
+  Layer *embed = new Layer(&model,
                            OP_EMBEDDING,
                            dtype,
                            name,
                            1 /*inputs*/,
-                           1 /*weights*/,
+                           tables.num_tables() /*weights*/,
                            1 /*outputs*/,
                            input);
+  int const out_dim = tables.out_dim;
   if (aggr == AGGR_MODE_NONE) {
     int numdims = input->num_dims + 1;
     int dims[MAX_TENSOR_DIM];
@@ -62,7 +62,7 @@ Tensor FFModel::embedding(const Tensor input,
       dims[i] = input->dims[i - 1];
     }
     dims[0] = out_dim;
-    embed->outputs[0] = create_tensor_legion_ordering(
+    embed->outputs[0] = model.create_tensor_legion_ordering(
         numdims, dims, embed->data_type, embed, 0, true /*create_grad*/);
   } else {
     int numdims = input->num_dims;
@@ -71,40 +71,99 @@ Tensor FFModel::embedding(const Tensor input,
       dims[i] = input->dims[i];
     }
     dims[0] = out_dim;
-    embed->outputs[0] = create_tensor_legion_ordering(
+    embed->outputs[0] = model.create_tensor_legion_ordering(
         numdims, dims, embed->data_type, embed, 0, true /*create_grad*/);
   }
-  {
-    int dims[2] = {out_dim, num_entries};
-    embed->weights[0] = create_weight_legion_ordering(2,
-                                                      dims,
-                                                      dtype,
-                                                      embed,
-                                                      true /*create_grad*/,
-                                                      kernel_initializer,
-                                                      CHOSEN_SYNC_TYPE);
+  for (int i = 0; i < tables.num_tables(); i++) {
+    int dims[2] = {tables.cols(i), tables.rows(i)};
+    embed->weights[i] =
+        model.create_weight_legion_ordering(2,
+                                            dims,
+                                            dtype,
+                                            embed,
+                                            true /*create_grad*/,
+                                            kernel_initializer,
+                                            CHOSEN_SYNC_TYPE);
   }
   embed->data_type = dtype;
-  embed->add_int_property("num_entries", num_entries);
+  embed->add_int_property("num_entries", tables.num_entries);
   embed->add_int_property("out_dim", out_dim);
   embed->add_int_property("aggr_mode", aggr);
+  embed->add_int_property("embedding_mode", tables.mode);
+  embed->add_int_property("num_buckets", tables.num_buckets);
+  embed->add_int_property("embed_dim", tables.embed_dim);
   embed->add_initializer("kernel", kernel_initializer);
-  layers.push_back(embed);
+  model.layers.push_back(embed);
   return embed->outputs[0];
 }
 
+Tensor FFModel::embedding(const Tensor input,
+                          int num_entries,
+                          int out_dim,
+                          AggrMode aggr,
+                          DataType dtype,
+                          Layer const *shared_op,
+                          Initializer *kernel_initializer,
+                          char const *name) {
+  EmbeddingTables tables{EMBEDDING_MODE_DENSE, num_entries, out_dim, 0, 0};
+  return add_embedding(
+      *this, input, tables, aggr, dtype, kernel_initializer, name);
+}
+
+Tensor FFModel::qr_embedding(const Tensor input,
+                             int num_entries,
+                             int num_buckets,
+                             int out_dim,
+                             AggrMode aggr,
+                             DataType dtype,
+                             Initializer *kernel_initializer,
+                             char const *name) {
+  assert(num_buckets > 0 && num_buckets <= num_entries);
+  // The kernels only handle float tables
+  assert(dtype == DT_FLOAT);
+  EmbeddingTables tables{
+      EMBEDDING_MODE_QR, num_entries, out_dim, num_buckets, 0};
+  return add_embedding(
+      *this, input, tables, aggr, dtype, kernel_initializer, name);
+}
+
+Tensor FFModel::mixed_dim_embedding(const Tensor input,
+                                    int num_entries,
+                                    int embed_dim,
+                                    int out_dim,
+                                    AggrMode aggr,
+                                    DataType dtype,
+                                    Initializer *kernel_initializer,
+                                    char const *name) {
+  assert(embed_dim > 0);
+  // The kernels only handle float tables
+  assert(dtype == DT_FLOAT);
+  EmbeddingTables tables{
+      EMBEDDING_MODE_MIXED_DIM, num_entries, out_dim, 0, embed_dim};
+  return add_embedding(
+      *this, input, tables, aggr, dtype, kernel_initializer, name);
+}
+
 EmbeddingParams Embedding::get_params() const {
   EmbeddingParams params;
   params.num_entries = this->num_entries;
   params.out_channels = this->out_channels;
   params.aggr = this->aggr;
   params.data_type = this->data_type;
+  params.mode = this->mode;
+  params.num_buckets = this->num_buckets;
+  params.embed_dim = this->embed_dim;
   // TODO: get rid of layer_guid
   // https://github.com/flexflow/FlexFlow/issues/304
   params.layer_guid = this->layer_guid;
   return params;
 }
 
+EmbeddingTables Embedding::get_tables() const {
+  return EmbeddingTables{
+      mode, num_entries, out_channels, num_buckets, embed_dim};
+}
+
 Op *Embedding::create_operator_from_layer(
     FFModel &model,
     Layer const *layer,
@@ -116,6 +175,12 @@ Op *Embedding::create_operator_from_layer(
   int out_dim = value;
   layer->get_int_property("aggr_mode", value);
   AggrMode aggr = (AggrMode)value;
+  layer->get_int_property("embedding_mode", value);
+  EmbeddingMode mode = (EmbeddingMode)value;
+  layer->get_int_property("num_buckets", value);
+  int num_buckets = value;
+  layer->get_int_property("embed_dim", value);
+  int embed_dim = value;
   Initializer *kernel_initializer;
   layer->get_initializer("kernel", kernel_initializer);
   return new Embedding(model,
@@ -126,7 +191,10 @@ Op *Embedding::create_operator_from_layer(
                        aggr,
                        false /*allocate_weights*/,
                        layer->data_type,
-                       layer->name);
+                       layer->name,
+                       mode,
+                       num_buckets,
+                       embed_dim);
 }
 
 int Embedding::input_vocab_size_replica_dim() const {
@@ -180,13 +248,15 @@ int Embedding::output_size(ParallelDim output_dims[MAX_TENSOR_DIM]) {
   // const int REPLICA = this->output_vocab_size_replica_dim();
 }
 
-int Embedding::weight_size(ParallelDim weight_dims[MAX_TENSOR_DIM]) {
+int Embedding::weight_size(int index,
+                           ParallelDim weight_dims[MAX_TENSOR_DIM]) {
   ParallelTensor const &input = this->inputs[0];
+  EmbeddingTables tables = this->get_tables();
 
-  weight_dims[Weight::OUT_CHANNELS].size = this->out_channels;
+  weight_dims[Weight::OUT_CHANNELS].size = tables.cols(index);
   weight_dims[Weight::OUT_CHANNELS].degree = 1;
   weight_dims[Weight::OUT_CHANNELS].parallel_idx = -1;
-  weight_dims[Weight::VOCAB_SIZE].size = this->num_entries;
+  weight_dims[Weight::VOCAB_SIZE].size = tables.rows(index);
   weight_dims[Weight::VOCAB_SIZE].degree = 1;
   weight_dims[Weight::VOCAB_SIZE].parallel_idx = -1;
   for (int i = 2; i < input->num_dims; i++) {
@@ -213,8 +283,10 @@ void Embedding::register_output_mappings() {
 }
 
 void Embedding::register_weight_mappings() {
-  for (int i = 2; i < this->inputs[0]->num_dims; i++) {
-    this->register_weight_parallel_dims(i - 1, i);
+  for (int w = 0; w < this->numWeights; w++) {
+    for (int i = 2; i < this->inputs[0]->num_dims; i++) {
+      this->register_weight_parallel_dims(i - 1, i, 0 /*input_idx*/, w);
+    }
   }
 }
 
@@ -233,7 +305,8 @@ bool operator==(EmbeddingParams const &lhs, EmbeddingParams const &rhs) {
   return lhs.layer_guid == rhs.layer_guid &&
          lhs.out_channels == rhs.out_channels &&
          lhs.num_entries == rhs.num_entries && lhs.aggr == rhs.aggr &&
-         lhs.data_type == rhs.data_type;
+         lhs.data_type == rhs.data_type && lhs.mode == rhs.mode &&
+         lhs.num_buckets == rhs.num_buckets && lhs.embed_dim == rhs.embed_dim;
 }
 
 Embedding::Embedding(FFModel &model,
@@ -249,7 +322,10 @@ Embedding::Embedding(FFModel &model,
                 params.aggr,
                 allocate_weights,
                 params.data_type,
-                name) {}
+                name,
+                params.mode,
+                params.num_buckets,
+                params.embed_dim) {}
 
 Embedding::Embedding(FFModel &model,
                      Embedding const &other,
@@ -263,7 +339,10 @@ Embedding::Embedding(FFModel &model,
                 other.aggr,
                 allocate_weights,
                 other.data_type,
-                other.name) {}
+                other.name,
+                other.mode,
+                other.num_buckets,
+                other.embed_dim) {}
 
 Embedding::Embedding(FFModel &model,
                      LayerID const &_layer_guid,
@@ -273,25 +352,32 @@ Embedding::Embedding(FFModel &model,
                      AggrMode _aggr,
                      bool allocate_weights,
                      DataType dtype,
-                     char const *name)
+                     char const *name,
+                     EmbeddingMode _mode,
+                     int _num_buckets,
+                     int _embed_dim)
     : Op(model,
          OP_EMBEDDING,
          dtype,
          name,
          1 /*inputs*/,
-         1 /*weights*/,
+         _mode == EMBEDDING_MODE_DENSE ? 1 : 2 /*weights*/,
          allocate_weights,
          1 /*outputs*/,
          _input),
-      num_entries(_num_entries), out_channels(_out_channels), aggr(_aggr) {
+      num_entries(_num_entries), out_channels(_out_channels), aggr(_aggr),
+      mode(_mode), num_buckets(_num_buckets), embed_dim(_embed_dim) {
   layer_guid = _layer_guid;
+  assert(numWeights == this->get_tables().num_tables());
   std::vector<ParallelDim *> weight_dim_sets;
 
-  int weight_ndim;
-  ParallelDim weight_dims[MAX_TENSOR_DIM];
+  int weight_ndim[MAX_NUM_WEIGHTS];
+  ParallelDim weight_dims[MAX_NUM_WEIGHTS][MAX_TENSOR_DIM];
   if (allocate_weights) {
-    weight_ndim = this->weight_size(weight_dims);
-    weight_dim_sets.push_back(weight_dims);
+    for (int i = 0; i < numWeights; i++) {
+      weight_ndim[i] = this->weight_size(i, weight_dims[i]);
+      weight_dim_sets.push_back(weight_dims[i]);
+    }
   }
 
   ParallelDim output_dims[MAX_TENSOR_DIM];
@@ -307,14 +393,16 @@ Embedding::Embedding(FFModel &model,
     Initializer *weight_initializer = new GlorotUniform(std::rand() /*seed*/);
     // Initializer *weight_initializer = new ZeroInitializer(/*seed*/);
 
-    weights[0] =
-        model.create_parallel_weight_legion_ordering(weight_ndim,
-                                                     weight_dims,
-                                                     dtype,
-                                                     nullptr /*owner_op*/,
-                                                     true /*create_grad*/,
-                                                     weight_initializer,
-                                                     CHOSEN_SYNC_TYPE);
+    for (int i = 0; i < numWeights; i++) {
+      weights[i] =
+          model.create_parallel_weight_legion_ordering(weight_ndim[i],
+                                                       weight_dims[i],
+                                                       dtype,
+                                                       nullptr /*owner_op*/,
+                                                       true /*create_grad*/,
+                                                       weight_initializer,
+                                                       CHOSEN_SYNC_TYPE);
+    }
   }
 
   outputs[0] = model.create_parallel_tensor_legion_ordering(
@@ -378,6 +466,7 @@ OpMeta *Embedding::init_task(Task const *task,
   EmbeddingMeta *m = new EmbeddingMeta(handle, embed);
   m->profiling = embed->profiling;
   m->aggr = embed->aggr;
+  m->tables = embed->get_tables();
   return m;
 }
 
@@ -416,6 +505,15 @@ void Embedding::forward(FFModel const &ff) {
                                                     EXCLUSIVE,
                                                     weights[0]->region));
   launcher.add_field(2, FID_DATA);
+  if (mode != EMBEDDING_MODE_DENSE) {
+    // regions[3]: remainder table or projection
+    launcher.add_region_requirement(RegionRequirement(weights[1]->part,
+                                                      0 /*projection*/,
+                                                      READ_ONLY,
+                                                      EXCLUSIVE,
+                                                      weights[1]->region));
+    launcher.add_field(3, FID_DATA);
+  }
   runtime->execute_index_space(ctx, launcher);
 }
 
@@ -423,14 +521,16 @@ void Embedding::forward(FFModel const &ff) {
   regions[0](I): input
   regions[1](O): output
   regions[2](I): kernel
+  regions[3](I): remainder table or projection (QR and mixed-dim modes)
 */
 void Embedding::forward_task(Task const *task,
                              std::vector<PhysicalRegion> const &regions,
                              Context ctx,
                              Runtime *runtime) {
   EmbeddingMeta const *m = *((EmbeddingMeta **)task->local_args);
-  assert(regions.size() == 3);
-  assert(task->regions.size() == 3);
+  int num_tables = m->tables.num_tables();
+  assert(regions.size() == 2 + num_tables);
+  assert(task->regions.size() == 2 + num_tables);
   // Assert that weight and output must have the same data type
   // otherwise, a cast operator should be inserted
   assert(m->weight_type[0] == m->output_type[0]);
@@ -448,8 +548,6 @@ void Embedding::forward_task(Task const *task,
       assert(input.domain.hi()[i] == output.domain.hi()[i + 1]);
       assert(input.domain.lo()[i] == output.domain.lo()[i + 1]);
     }
-    assert(kernel.domain.hi()[0] - kernel.domain.lo()[0] ==
-           output.domain.hi()[0] - output.domain.lo()[0]);
   } else {
     // assert(kernel_domain.get_dim() == 2);
     assert(input.domain.get_dim() == output.domain.get_dim());
@@ -457,9 +555,11 @@ void Embedding::forward_task(Task const *task,
       assert(input.domain.hi()[i] == output.domain.hi()[i]);
       assert(input.domain.lo()[i] == output.domain.lo()[i]);
     }
-    assert(kernel.domain.hi()[0] - kernel.domain.lo()[0] ==
-           output.domain.hi()[0] - output.domain.lo()[0]);
   }
+  assert(kernel.domain.hi()[0] - kernel.domain.lo()[0] + 1 ==
+         m->tables.cols(0));
+  assert(output.domain.hi()[0] - output.domain.lo()[0] + 1 ==
+         m->tables.out_dim);
 
   int in_dim, out_dim, effective_batch_size;
   if (m->aggr == AGGR_MODE_NONE) {
@@ -473,8 +573,33 @@ void Embedding::forward_task(Task const *task,
     effective_batch_size = output.domain.get_volume() / out_dim;
     assert(effective_batch_size * in_dim == input.domain.get_volume());
   }
-  forward_kernel_wrapper(
-      m, input, output, kernel, in_dim, out_dim, effective_batch_size);
+  if (m->tables.mode == EMBEDDING_MODE_DENSE) {
+    forward_kernel_wrapper(
+        m, input, output, kernel, in_dim, out_dim, effective_batch_size);
+    return;
+  }
+  GenericTensorAccessorR kernel2 = helperGetGenericTensorAccessorRO(
+      m->weight_type[1], regions[3], task->regions[3], FID_DATA, ctx, runtime);
+  if (m->tables.mode == EMBEDDING_MODE_QR) {
+    qr_forward_kernel_wrapper(m,
+                              input,
+                              output,
+                              kernel,
+                              kernel2,
+                              in_dim,
+                              out_dim,
+                              effective_batch_size);
+  } else {
+    assert(m->tables.mode == EMBEDDING_MODE_MIXED_DIM);
+    mixed_dim_forward_kernel_wrapper(m,
+                                     input,
+                                     output,
+                                     kernel,
+                                     kernel2,
+                                     in_dim,
+                                     out_dim,
+                                     effective_batch_size);
+  }
 }
 
 #ifdef DEADCODE
@@ -579,16 +704,43 @@ void Embedding::backward(FFModel const &ff) {
                                                     EXCLUSIVE,
                                                     weights[0]->region_grad));
   launcher.add_field(2, FID_DATA);
+  if (mode != EMBEDDING_MODE_DENSE) {
+    // The gradient of each table depends on the values of both
+    // regions[3]: weight_grad of the remainder table or projection
+    launcher.add_region_requirement(RegionRequirement(weights[1]->part_grad,
+                                                      0 /*projection*/,
+                                                      READ_WRITE,
+                                                      EXCLUSIVE,
+                                                      weights[1]->region_grad));
+    launcher.add_field(3, FID_DATA);
+    // regions[4-5]: weights
+    for (int i = 0; i < numWeights; i++) {
+      launcher.add_region_requirement(RegionRequirement(weights[i]->part,
+                                                        0 /*projection*/,
+                                                        READ_ONLY,
+                                                        EXCLUSIVE,
+                                                        weights[i]->region));
+      launcher.add_field(4 + i, FID_DATA);
+    }
+  }
   runtime->execute_index_space(ctx, launcher);
 }
 
+/*
+  regions[0](I): input
+  regions[1](I): output_grad
+  regions[2](I/O): kernel_grad
+  regions[3](I/O): remainder table or projection grad (QR and mixed-dim)
+  regions[4-5](I): kernel, remainder table or projection (QR and mixed-dim)
+*/
 void Embedding::backward_task(Task const *task,
                               std::vector<PhysicalRegion> const &regions,
                               Context ctx,
                               Runtime *runtime) {
   EmbeddingMeta const *m = *((EmbeddingMeta **)task->local_args);
-  assert(regions.size() == 3);
-  assert(task->regions.size() == 3);
+  int num_regions = m->tables.mode == EMBEDDING_MODE_DENSE ? 3 : 6;
+  assert(regions.size() == num_regions);
+  assert(task->regions.size() == num_regions);
   // Assert that weight and output must have the same data type
   // otherwise, a cast operator should be inserted
   assert(m->weight_type[0] == m->output_type[0]);
@@ -606,8 +758,6 @@ void Embedding::backward_task(Task const *task,
       assert(input.domain.hi()[i] == output_grad.domain.hi()[i + 1]);
       assert(input.domain.lo()[i] == output_grad.domain.lo()[i + 1]);
     }
-    assert(kernel_grad.domain.hi()[0] - kernel_grad.domain.lo()[0] ==
-           output_grad.domain.hi()[0] - output_grad.domain.lo()[0]);
   } else {
     // assert(kernel_grad_domain.get_dim() == 2);
     assert(input.domain.get_dim() == output_grad.domain.get_dim());
@@ -615,9 +765,11 @@ void Embedding::backward_task(Task const *task,
       assert(input.domain.hi()[i] == output_grad.domain.hi()[i]);
       assert(input.domain.lo()[i] == output_grad.domain.lo()[i]);
     }
-    assert(kernel_grad.domain.hi()[0] - kernel_grad.domain.lo()[0] ==
-           output_grad.domain.hi()[0] - output_grad.domain.lo()[0]);
   }
+  assert(kernel_grad.domain.hi()[0] - kernel_grad.domain.lo()[0] + 1 ==
+         m->tables.cols(0));
+  assert(output_grad.domain.hi()[0] - output_grad.domain.lo()[0] + 1 ==
+         m->tables.out_dim);
   int in_dim, out_dim, effective_batch_size;
   if (m->aggr == AGGR_MODE_NONE) {
     in_dim = 1;
@@ -630,13 +782,46 @@ void Embedding::backward_task(Task const *task,
     effective_batch_size = output_grad.domain.get_volume() / out_dim;
     assert(effective_batch_size * in_dim == input.domain.get_volume());
   }
-  backward_kernel_wrapper(m,
-                          input,
-                          output_grad,
-                          kernel_grad,
-                          in_dim,
-                          out_dim,
-                          effective_batch_size);
+  if (m->tables.mode == EMBEDDING_MODE_DENSE) {
+    backward_kernel_wrapper(m,
+                            input,
+                            output_grad,
+                            kernel_grad,
+                            in_dim,
+                            out_dim,
+                            effective_batch_size);
+    return;
+  }
+  GenericTensorAccessorW kernel2_grad = helperGetGenericTensorAccessorRW(
+      m->weight_type[1], regions[3], task->regions[3], FID_DATA, ctx, runtime);
+  GenericTensorAccessorR kernel = helperGetGenericTensorAccessorRO(
+      m->weight_type[0], regions[4], task->regions[4], FID_DATA, ctx, runtime);
+  GenericTensorAccessorR kernel2 = helperGetGenericTensorAccessorRO(
+      m->weight_type[1], regions[5], task->regions[5], FID_DATA, ctx, runtime);
+  if (m->tables.mode == EMBEDDING_MODE_QR) {
+    qr_backward_kernel_wrapper(m,
+                               input,
+                               output_grad,
+                               kernel,
+                               kernel2,
+                               kernel_grad,
+                               kernel2_grad,
+                               in_dim,
+                               out_dim,
+                               effective_batch_size);
+  } else {
+    assert(m->tables.mode == EMBEDDING_MODE_MIXED_DIM);
+    mixed_dim_backward_kernel_wrapper(m,
+                                      input,
+                                      output_grad,
+                                      kernel,
+                                      kernel2,
+                                      kernel_grad,
+                                      kernel2_grad,
+                                      in_dim,
+                                      out_dim,
+                                      effective_batch_size);
+  }
 }
 
 #ifdef DEADCODE
@@ -720,6 +905,7 @@ bool Embedding::measure_operator_cost(Simulator *sim,
   EmbeddingMeta *m = new EmbeddingMeta(sim->handler, this);
   assert(m->profiling == false);
   m->aggr = this->aggr;
+  m->tables = this->get_tables();
 
   sim->free_all();
   bool out_of_memory = false;
@@ -737,17 +923,26 @@ bool Embedding::measure_operator_cost(Simulator *sim,
   GenericTensorAccessorW output_acc(
       outputs[0]->data_type, out_domain, output_ptr);
 
-  Domain weight_domain;
-  weight_domain.dim = 2;
-  weight_domain.rect_data[0] = 0;
-  weight_domain.rect_data[1] = 0;
-  weight_domain.rect_data[2] = num_entries - 1;
-  weight_domain.rect_data[3] = out_channels - 1;
-
-  void *weight_ptr = sim->allocate(num_entries * out_channels, this->data_type);
-  cost_metrics.weights_memory += cost_metrics.total_mem_diff_from(sim->offset);
-  out_of_memory = out_of_memory || (weight_ptr == NULL);
-  GenericTensorAccessorR weight_acc(this->data_type, weight_domain, weight_ptr);
+  // QR and mixed-dimension tables are measured at their own, smaller, size
+  EmbeddingTables tables = this->get_tables();
+  int num_tables = tables.num_tables();
+  Domain weight_domains[2];
+  std::vector<GenericTensorAccessorR> weight_accs;
+  for (int i = 0; i < num_tables; i++) {
+    Domain &weight_domain = weight_domains[i];
+    weight_domain.dim = 2;
+    weight_domain.rect_data[0] = 0;
+    weight_domain.rect_data[1] = 0;
+    weight_domain.rect_data[2] = tables.cols(i) - 1;
+    weight_domain.rect_data[3] = tables.rows(i) - 1;
+    void *weight_ptr =
+        sim->allocate(weight_domain.get_volume(), this->data_type);
+    cost_metrics.weights_memory +=
+        cost_metrics.total_mem_diff_from(sim->offset);
+    out_of_memory = out_of_memory || (weight_ptr == NULL);
+    weight_accs.push_back(
+        GenericTensorAccessorR(this->data_type, weight_domain, weight_ptr));
+  }
   if (out_of_memory) {
     cost_metrics.forward_time = Simulator::MAXIMUM_TASK_RUN_TIME;
     cost_metrics.backward_time = Simulator::MAXIMUM_TASK_RUN_TIME;
@@ -768,24 +963,53 @@ bool Embedding::measure_operator_cost(Simulator *sim,
         input_acc.get_int64_ptr(), sub_input.get_volume(), num_entries);
   }
 
+  std::vector<GenericTensorAccessorW> weight_grad_accs;
   std::function<void()> forward, backward;
   forward = [&] {
-    forward_kernel_wrapper(m,
-                           input_acc,
-                           output_acc,
-                           weight_acc,
-                           in_dim,
-                           out_dim,
-                           effective_batch_size);
+    switch (mode) {
+      case EMBEDDING_MODE_DENSE:
+        forward_kernel_wrapper(m,
+                               input_acc,
+                               output_acc,
+                               weight_accs[0],
+                               in_dim,
+                               out_dim,
+                               effective_batch_size);
+        break;
+      case EMBEDDING_MODE_QR:
+        qr_forward_kernel_wrapper(m,
+                                  input_acc,
+                                  output_acc,
+                                  weight_accs[0],
+                                  weight_accs[1],
+                                  in_dim,
+                                  out_dim,
+                                  effective_batch_size);
+        break;
+      case EMBEDDING_MODE_MIXED_DIM:
+        mixed_dim_forward_kernel_wrapper(m,
+                                         input_acc,
+                                         output_acc,
+                                         weight_accs[0],
+                                         weight_accs[1],
+                                         in_dim,
+                                         out_dim,
+                                         effective_batch_size);
+        break;
+      default:
+        assert(false);
+    }
   };
   if (sim->computationMode == COMP_MODE_TRAINING) {
-    void *weight_grad_ptr =
-        sim->allocate(num_entries * out_channels, this->data_type);
-    cost_metrics.weights_memory +=
-        cost_metrics.total_mem_diff_from(sim->offset);
-    out_of_memory = out_of_memory || (weight_grad_ptr == NULL);
-    GenericTensorAccessorW weight_grad_acc(
-        this->data_type, weight_domain, weight_grad_ptr);
+    for (int i = 0; i < num_tables; i++) {
+      void *weight_grad_ptr =
+          sim->allocate(weight_domains[i].get_volume(), this->data_type);
+      cost_metrics.weights_memory +=
+          cost_metrics.total_mem_diff_from(sim->offset);
+      out_of_memory = out_of_memory || (weight_grad_ptr == NULL);
+      weight_grad_accs.push_back(GenericTensorAccessorW(
+          this->data_type, weight_domains[i], weight_grad_ptr));
+    }
 
     void *output_grad_ptr =
         sim->allocate(sub_output.get_volume(), outputs[0]->data_type);
@@ -808,13 +1032,43 @@ bool Embedding::measure_operator_cost(Simulator *sim,
       return true;
     }
     backward = [&] {
-      backward_kernel_wrapper(m,
-                              input_grad_acc,
-                              output_grad_acc,
-                              weight_grad_acc,
-                              in_dim,
-                              out_dim,
-                              effective_batch_size);
+      switch (mode) {
+        case EMBEDDING_MODE_DENSE:
+          backward_kernel_wrapper(m,
+                                  input_grad_acc,
+                                  output_grad_acc,
+                                  weight_grad_accs[0],
+                                  in_dim,
+                                  out_dim,
+                                  effective_batch_size);
+          break;
+        case EMBEDDING_MODE_QR:
+          qr_backward_kernel_wrapper(m,
+                                     input_grad_acc,
+                                     output_grad_acc,
+                                     weight_accs[0],
+                                     weight_accs[1],
+                                     weight_grad_accs[0],
+                                     weight_grad_accs[1],
+                                     in_dim,
+                                     out_dim,
+                                     effective_batch_size);
+          break;
+        case EMBEDDING_MODE_MIXED_DIM:
+          mixed_dim_backward_kernel_wrapper(m,
+                                            input_grad_acc,
+                                            output_grad_acc,
+                                            weight_accs[0],
+                                            weight_accs[1],
+                                            weight_grad_accs[0],
+                                            weight_grad_accs[1],
+                                            in_dim,
+                                            out_dim,
+                                            effective_batch_size);
+          break;
+        default:
+          assert(false);
+      }
     };
   }
 
@@ -1200,6 +1454,9 @@ size_t hash<FlexFlow::EmbeddingParams>::operator()(
   hash_combine(key, params.aggr);
   hash_combine(key, params.num_entries);
   hash_combine(key, params.data_type);
+  hash_combine(key, params.mode);
+  hash_combine(key, params.num_buckets);
+  hash_combine(key, params.embed_dim);
   return key;
 }
 }; // namespace std
@@ -58,7 +58,10 @@ FusedOp::FusedOp(FFModel &model, Op *op)
     // we also need to check region duplicate for the first op in a fused op
     // (e.g., MHA)
     for (int j = 0; j < numInputs; j++) {
-      if (inputs[j]->region == op->inputs[i]->region) {
+      // Tensors may share a region under different partitions (see
+      // ParallelOp::alias_output_to_input)
+      if (inputs[j]->region == op->inputs[i]->region &&
+          inputs[j]->part == op->inputs[i]->part) {
         // This input is one of my inputs
         assert(!found);
         assert(inputs[j]->region != LogicalRegion::NO_REGION);
@@ -114,6 +117,29 @@ FusedOp::FusedOp(FFModel &model, Op *op)
   }
 }
 
+bool FusedOp::can_fuse(Op const *op) {
+  switch (op->op_type) {
+    case OP_INPUT:
+    case OP_WEIGHT:
+    case OP_NOOP:
+    case OP_SLICE:
+    case OP_FUSED:
+      return false;
+    default:
+      return !op->is_parallel_op();
+  }
+}
+
+bool FusedOp::within_limits(int num_operators,
+                            int num_inputs,
+                            int num_weights,
+                            int num_outputs) {
+  return num_operators <= MAX_NUM_FUSED_OPERATORS &&
+         num_inputs <= MAX_NUM_FUSED_TENSORS &&
+         num_weights <= MAX_NUM_FUSED_TENSORS &&
+         num_outputs <= MAX_NUM_FUSED_TENSORS;
+}
+
 bool FusedOp::add_operator(FFModel &model, Op *op) {
   // Context ctx = model.config.lg_ctx;
   // Runtime* runtime = model.config.lg_hlr;
@@ -127,11 +153,7 @@ bool FusedOp::add_operator(FFModel &model, Op *op) {
   // assert(model.config.find_parallel_config(my_domain.get_dim(), name,
   // my_config)); assert(model.config.find_parallel_config(op_domain.get_dim(),
   // op->name, op_config));
-  // Cannot fuse parallel operators since they have different paralel_is
-  // in forward and backward
-  assert(!op->is_parallel_op());
-  // Currently don't consider nested fusion
-  assert(op->op_type != OP_FUSED);
+  assert(can_fuse(op));
   MachineView my_view = outputs[0]->machine_view;
   MachineView op_view = op->outputs[0]->machine_view;
   if (my_view == op_view) {
@@ -145,23 +167,21 @@ bool FusedOp::add_operator(FFModel &model, Op *op) {
     weight_offset += op_num_weights[i];
     output_offset += op_num_outputs[i];
   }
-  if ((input_offset + op->numInputs > MAX_NUM_FUSED_TENSORS) ||
-      (weight_offset + op->numWeights > MAX_NUM_FUSED_TENSORS) ||
-      (output_offset + op->numOutputs > MAX_NUM_FUSED_TENSORS)) {
-    fprintf(stderr, "Cannot fuse. Consider increase MAX_NUM_FUSED_TENSORS\n");
-    return false;
-  }
-  if (numOperators + 1 > MAX_NUM_FUSED_OPERATORS) {
-    fprintf(
-        stderr,
-        "Reach to the fusion limit. Consider increase MAX_NUM_FUSED_OPERATORS");
+  if (!within_limits(numOperators + 1,
+                     input_offset + op->numInputs,
+                     weight_offset + op->numWeights,
+                     output_offset + op->numOutputs)) {
+    fprintf(stderr,
+            "Reach to the fusion limit. Consider increase "
+            "MAX_NUM_FUSED_OPERATORS or MAX_NUM_FUSED_TENSORS\n");
     return false;
   }
   // Set inputs
   for (int i = 0; i < op->numInputs; i++) {
     bool found = false;
     for (int j = 0; j < numInputs; j++) {
-      if (inputs[j]->region == op->inputs[i]->region) {
+      if (inputs[j]->region == op->inputs[i]->region &&
+          inputs[j]->part == op->inputs[i]->part) {
         // This input is one of my inputs
         assert(!found);
         assert(inputs[j]->region != LogicalRegion::NO_REGION);
@@ -172,7 +192,8 @@ bool FusedOp::add_operator(FFModel &model, Op *op) {
       }
     }
     for (int j = 0; j < numOutputs; j++) {
-      if ((outputs[j]->region == op->inputs[i]->region) && (!found)) {
+      if ((outputs[j]->region == op->inputs[i]->region) &&
+          (outputs[j]->part == op->inputs[i]->part) && (!found)) {
         // This input is one of my outputs
         assert(!found);
         assert(outputs[j]->region != LogicalRegion::NO_REGION);
@@ -16,6 +16,7 @@
 #include "flexflow/ops/fused.h"
 #include "flexflow/model.h"
 #include "flexflow/ops/batch_norm.h"
+#include "flexflow/ops/element_expression.h"
 #include "flexflow/ops/element_unary.h"
 #include "flexflow/ops/kernels/batch_matmul_kernels.h"
 #include "flexflow/ops/kernels/concat_kernels.h"
@@ -28,6 +29,7 @@
 #include "flexflow/ops/kernels/reshape_kernels.h"
 #include "flexflow/ops/kernels/transpose_kernels.h"
 #include "flexflow/ops/linear.h"
+#include "flexflow/ops/pad.h"
 #include "flexflow/utils/hip_helper.h"
 #include <hip/hip_runtime.h>
 
@@ -292,6 +294,23 @@ __host__ void FusedOp::forward_task(Task const *task,
         break;
         break;
       }
+      case OP_ELEMENT_EXPRESSION: {
+        assert(fused->op_num_weights[op] == 0);
+        assert(fused->op_num_outputs[op] == 1);
+        ElementExpressionMeta *m = (ElementExpressionMeta *)metas->meta[op];
+        ElementExpression::forward_kernel_wrapper(
+            m, my_input_accessor, my_output_accessor[0]);
+        break;
+      }
+      case OP_PAD: {
+        assert(fused->op_num_inputs[op] == 1);
+        assert(fused->op_num_weights[op] == 0);
+        assert(fused->op_num_outputs[op] == 1);
+        PadMeta *m = (PadMeta *)metas->meta[op];
+        Pad::forward_kernel_wrapper(
+            m, my_input_accessor[0], my_output_accessor[0]);
+        break;
+      }
       case OP_RELU:
       case OP_SIGMOID:
       case OP_TANH:
@@ -687,6 +706,30 @@ __host__ void FusedOp::backward_task(Task const *task,
             my_input_grad_accessor[1].get_float_ptr());
         break;
       }
+      case OP_ELEMENT_EXPRESSION: {
+        assert(fused->op_num_weights[op] == 0);
+        assert(fused->op_num_outputs[op] == 1);
+        ElementExpressionMeta *m = (ElementExpressionMeta *)metas->meta[op];
+        GenericTensorAccessorR output_grad(
+            DT_FLOAT,
+            my_output_grad_accessor[0].domain,
+            my_output_grad_accessor[0].get_float_ptr());
+        ElementExpression::backward_kernel_wrapper(
+            m, my_input_accessor, output_grad, my_input_grad_accessor);
+        break;
+      }
+      case OP_PAD: {
+        assert(fused->op_num_inputs[op] == 1);
+        assert(fused->op_num_weights[op] == 0);
+        assert(fused->op_num_outputs[op] == 1);
+        PadMeta *m = (PadMeta *)metas->meta[op];
+        GenericTensorAccessorR output_grad(
+            DT_FLOAT,
+            my_output_grad_accessor[0].domain,
+            my_output_grad_accessor[0].get_float_ptr());
+        Pad::backward_kernel_wrapper(m, output_grad, my_input_grad_accessor[0]);
+        break;
+      }
       case OP_RELU:
       case OP_SIGMOID:
       case OP_TANH:
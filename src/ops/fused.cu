@@ -16,6 +16,7 @@
 #include "flexflow/accessor.h"
 #include "flexflow/model.h"
 #include "flexflow/ops/batch_norm.h"
+#include "flexflow/ops/element_expression.h"
 #include "flexflow/ops/element_unary.h"
 #include "flexflow/ops/embedding.h"
 #include "flexflow/ops/flat.h"
@@ -31,6 +32,7 @@
 #include "flexflow/ops/kernels/pool_2d_kernels.h"
 #include "flexflow/ops/kernels/reshape_kernels.h"
 #include "flexflow/ops/kernels/transpose_kernels.h"
+#include "flexflow/ops/pad.h"
 #include "flexflow/utils/cuda_helper.h"
 
 namespace FlexFlow {
@@ -306,9 +308,9 @@ __host__ void FusedOp::forward_task(Task const *task,
       }
       case OP_EMBEDDING: {
         assert(fused->op_num_inputs[op] == 1);
-        assert(fused->op_num_weights[op] == 1);
         assert(fused->op_num_outputs[op] == 1);
         EmbeddingMeta *m = (EmbeddingMeta *)metas->meta[op];
+        assert(fused->op_num_weights[op] == m->tables.num_tables());
         if (m->aggr == AGGR_MODE_NONE) {
           // assert(kernel_domain.get_dim() == 2);
           assert(my_input_accessor[0].domain.get_dim() + 1 ==
@@ -320,9 +322,8 @@ __host__ void FusedOp::forward_task(Task const *task,
                    my_output_accessor[0].domain.lo()[i + 1]);
           }
           assert(my_weight_accessor[0].domain.hi()[0] -
-                     my_weight_accessor[0].domain.lo()[0] ==
-                 my_output_accessor[0].domain.hi()[0] -
-                     my_output_accessor[0].domain.lo()[0]);
+                     my_weight_accessor[0].domain.lo()[0] + 1 ==
+                 m->tables.cols(0));
         } else {
           assert(my_input_accessor[0].domain.get_dim() ==
                  my_output_accessor[0].domain.get_dim());
@@ -333,9 +334,8 @@ __host__ void FusedOp::forward_task(Task const *task,
                    my_output_accessor[0].domain.lo()[i]);
           }
           assert(my_weight_accessor[0].domain.hi()[0] -
-                     my_weight_accessor[0].domain.lo()[0] ==
-                 my_output_accessor[0].domain.hi()[0] -
-                     my_output_accessor[0].domain.lo()[0]);
+                     my_weight_accessor[0].domain.lo()[0] + 1 ==
+                 m->tables.cols(0));
         }
         int in_dim, out_dim, effective_batch_size;
         if (m->aggr == AGGR_MODE_NONE) {
@@ -359,13 +359,51 @@ __host__ void FusedOp::forward_task(Task const *task,
         }
 
         assert(my_input_accessor[0].data_type == DT_INT64);
-        Kernels::Embedding::forward_kernel_wrapper(m,
-                                                   my_input_accessor[0],
-                                                   my_output_accessor[0],
-                                                   my_weight_accessor[0],
-                                                   in_dim,
-                                                   out_dim,
-                                                   effective_batch_size);
+        if (m->tables.mode == EMBEDDING_MODE_QR) {
+          Kernels::Embedding::qr_forward_kernel_wrapper(m,
+                                                        my_input_accessor[0],
+                                                        my_output_accessor[0],
+                                                        my_weight_accessor[0],
+                                                        my_weight_accessor[1],
+                                                        in_dim,
+                                                        out_dim,
+                                                        effective_batch_size);
+        } else if (m->tables.mode == EMBEDDING_MODE_MIXED_DIM) {
+          Kernels::Embedding::mixed_dim_forward_kernel_wrapper(
+              m,
+              my_input_accessor[0],
+              my_output_accessor[0],
+              my_weight_accessor[0],
+              my_weight_accessor[1],
+              in_dim,
+              out_dim,
+              effective_batch_size);
+        } else {
+          Kernels::Embedding::forward_kernel_wrapper(m,
+                                                     my_input_accessor[0],
+                                                     my_output_accessor[0],
+                                                     my_weight_accessor[0],
+                                                     in_dim,
+                                                     out_dim,
+                                                     effective_batch_size);
+        }
+        break;
+      }
+      case OP_ELEMENT_EXPRESSION: {
+        assert(fused->op_num_weights[op] == 0);
+        assert(fused->op_num_outputs[op] == 1);
+        ElementExpressionMeta *m = (ElementExpressionMeta *)metas->meta[op];
+        ElementExpression::forward_kernel_wrapper(
+            m, my_input_accessor, my_output_accessor[0]);
+        break;
+      }
+      case OP_PAD: {
+        assert(fused->op_num_inputs[op] == 1);
+        assert(fused->op_num_weights[op] == 0);
+        assert(fused->op_num_outputs[op] == 1);
+        PadMeta *m = (PadMeta *)metas->meta[op];
+        Pad::forward_kernel_wrapper(
+            m, my_input_accessor[0], my_output_accessor[0]);
         break;
       }
       case OP_RELU:
@@ -766,9 +804,9 @@ __host__ void FusedOp::backward_task(Task const *task,
       }
       case OP_EMBEDDING: {
         assert(fused->op_num_inputs[op] == 1);
-        assert(fused->op_num_weights[op] == 1);
         assert(fused->op_num_outputs[op] == 1);
         EmbeddingMeta *m = (EmbeddingMeta *)metas->meta[op];
+        assert(fused->op_num_weights[op] == m->tables.num_tables());
         assert(my_input_accessor[0].data_type == DT_INT64);
         int in_dim, out_dim, effective_batch_size;
         if (m->aggr == AGGR_MODE_NONE) {
@@ -789,13 +827,40 @@ __host__ void FusedOp::backward_task(Task const *task,
           assert(effective_batch_size * in_dim ==
                  my_input_accessor[0].domain.get_volume());
         }
-        Kernels::Embedding::backward_kernel_wrapper(m,
-                                                    my_input_accessor[0],
-                                                    my_output_grad_accessor[0],
-                                                    my_weight_grad_accessor[0],
-                                                    in_dim,
-                                                    out_dim,
-                                                    effective_batch_size);
+        if (m->tables.mode == EMBEDDING_MODE_QR) {
+          Kernels::Embedding::qr_backward_kernel_wrapper(
+              m,
+              my_input_accessor[0],
+              my_output_grad_accessor[0],
+              my_weight_accessor[0],
+              my_weight_accessor[1],
+              my_weight_grad_accessor[0],
+              my_weight_grad_accessor[1],
+              in_dim,
+              out_dim,
+              effective_batch_size);
+        } else if (m->tables.mode == EMBEDDING_MODE_MIXED_DIM) {
+          Kernels::Embedding::mixed_dim_backward_kernel_wrapper(
+              m,
+              my_input_accessor[0],
+              my_output_grad_accessor[0],
+              my_weight_accessor[0],
+              my_weight_accessor[1],
+              my_weight_grad_accessor[0],
+              my_weight_grad_accessor[1],
+              in_dim,
+              out_dim,
+              effective_batch_size);
+        } else {
+          Kernels::Embedding::backward_kernel_wrapper(
+              m,
+              my_input_accessor[0],
+              my_output_grad_accessor[0],
+              my_weight_grad_accessor[0],
+              in_dim,
+              out_dim,
+              effective_batch_size);
+        }
         break;
       }
       case OP_LINEAR: {
@@ -830,6 +895,30 @@ __host__ void FusedOp::backward_task(Task const *task,
             batch_size);
         break;
       }
+      case OP_ELEMENT_EXPRESSION: {
+        assert(fused->op_num_weights[op] == 0);
+        assert(fused->op_num_outputs[op] == 1);
+        ElementExpressionMeta *m = (ElementExpressionMeta *)metas->meta[op];
+        GenericTensorAccessorR output_grad(
+            DT_FLOAT,
+            my_output_grad_accessor[0].domain,
+            my_output_grad_accessor[0].get_float_ptr());
+        ElementExpression::backward_kernel_wrapper(
+            m, my_input_accessor, output_grad, my_input_grad_accessor);
+        break;
+      }
+      case OP_PAD: {
+        assert(fused->op_num_inputs[op] == 1);
+        assert(fused->op_num_weights[op] == 0);
+        assert(fused->op_num_outputs[op] == 1);
+        PadMeta *m = (PadMeta *)metas->meta[op];
+        GenericTensorAccessorR output_grad(
+            DT_FLOAT,
+            my_output_grad_accessor[0].domain,
+            my_output_grad_accessor[0].get_float_ptr());
+        Pad::backward_kernel_wrapper(m, output_grad, my_input_grad_accessor[0]);
+        break;
+      }
       case OP_RELU:
       case OP_SIGMOID:
       case OP_TANH:
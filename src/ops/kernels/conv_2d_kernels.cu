@@ -292,7 +292,10 @@ void backward_kernel(Conv2DMeta const *m,
   checkCUDNN(cudnnSetStream(m->handle.dnn, stream));
 
   float alpha = 1.0f;
-  // float beta = 0.0f;
+  // The first writer of a gradient overwrites it, see
+  // FFModel::plan_gradient_overwrites
+  float input_beta = m->resetInputGrads[0] ? 0.0f : 1.0f;
+  float weight_beta = m->resetWeightGrads ? 0.0f : 1.0f;
   if (m->relu) {
     cudnnDataType_t dataType;
     int n, c, h, w, nStride, cStride, hStride, wStride;
@@ -310,7 +313,6 @@ void backward_kernel(Conv2DMeta const *m,
         output_grad_ptr, output_ptr, n * c * h * w);
   }
   // Compute filter gradiant
-  // NOTE: we use alpha for kernel_grad to accumulate gradients
   checkCUDNN(cudnnConvolutionBackwardFilter(m->handle.dnn,
                                             &alpha,
                                             m->inputTensor,
@@ -321,22 +323,20 @@ void backward_kernel(Conv2DMeta const *m,
                                             m->bwdFilterAlgo,
                                             m->handle.workSpace,
                                             m->handle.workSpaceSize,
-                                            &alpha,
+                                            &weight_beta,
                                             m->filterDesc,
                                             kernel_grad_ptr));
   // Compute bias gradiant
-  // NOTE: we use alpha for bias_grad to accumulate gradients
   if (bias_grad_ptr != NULL) {
     checkCUDNN(cudnnConvolutionBackwardBias(m->handle.dnn,
                                             &alpha,
                                             m->outputTensor,
                                             output_grad_ptr,
-                                            &alpha,
+                                            &weight_beta,
                                             m->biasTensor,
                                             bias_grad_ptr));
   }
   // Compute data gradiant
-  // NOTE: we use alpha for input_grad to accumulate gradients
   if (input_grad_ptr != NULL) {
     checkCUDNN(cudnnConvolutionBackwardData(m->handle.dnn,
                                             &alpha,
@@ -348,7 +348,7 @@ void backward_kernel(Conv2DMeta const *m,
                                             m->bwdDataAlgo,
                                             m->handle.workSpace,
                                             m->handle.workSpaceSize,
-                                            &alpha,
+                                            &input_beta,
                                             m->inputTensor,
                                             input_grad_ptr));
   }
@@ -0,0 +1,82 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flexflow/ops/kernels/dot_interaction_kernels.h"
+
+namespace FlexFlow {
+namespace Kernels {
+namespace DotInteraction {
+
+void forward_cpu(DotInteractionShape const &shape,
+                 float const *const *inputs,
+                 float *output) {
+  int const d = shape.feature_size;
+  for (int n = 0; n < shape.num_samples; n++) {
+    float *out = output + (size_t)n * shape.output_size();
+    if (shape.concat_dense) {
+      for (int e = 0; e < d; e++) {
+        out[e] = inputs[0][(size_t)n * d + e];
+      }
+      out += d;
+    }
+    for (int i = 0; i < shape.num_features; i++) {
+      float const *x_i = inputs[i] + (size_t)n * d;
+      int last = shape.self_interaction ? i : i - 1;
+      for (int j = 0; j <= last; j++) {
+        float const *x_j = inputs[j] + (size_t)n * d;
+        float sum = 0.0f;
+        for (int e = 0; e < d; e++) {
+          sum += x_i[e] * x_j[e];
+        }
+        out[shape.pair_index(i, j)] = sum;
+      }
+    }
+  }
+}
+
+void backward_cpu(DotInteractionShape const &shape,
+                  float const *const *inputs,
+                  float const *output_grad,
+                  float *const *input_grads) {
+  int const d = shape.feature_size;
+  for (int n = 0; n < shape.num_samples; n++) {
+    float const *grad = output_grad + (size_t)n * shape.output_size();
+    if (shape.concat_dense) {
+      for (int e = 0; e < d; e++) {
+        input_grads[0][(size_t)n * d + e] += grad[e];
+      }
+      grad += d;
+    }
+    for (int i = 0; i < shape.num_features; i++) {
+      float const *x_i = inputs[i] + (size_t)n * d;
+      float *x_i_grad = input_grads[i] + (size_t)n * d;
+      int last = shape.self_interaction ? i : i - 1;
+      for (int j = 0; j <= last; j++) {
+        float const *x_j = inputs[j] + (size_t)n * d;
+        float *x_j_grad = input_grads[j] + (size_t)n * d;
+        float g = grad[shape.pair_index(i, j)];
+        // For i == j both updates apply, which gives d(x.x)/dx = 2x
+        for (int e = 0; e < d; e++) {
+          x_i_grad[e] += g * x_j[e];
+          x_j_grad[e] += g * x_i[e];
+        }
+      }
+    }
+  }
+}
+
+} // namespace DotInteraction
+} // namespace Kernels
+} // namespace FlexFlow
@@ -0,0 +1,402 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flexflow/ops/kernels/element_expression_kernels.h"
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace FlexFlow {
+
+bool ExpressionProgram::is_unary(OperatorType op_type) {
+  switch (op_type) {
+    case OP_EXP:
+    case OP_IDENTITY:
+    case OP_SCALAR_MULTIPLY:
+    case OP_SCALAR_ADD:
+    case OP_SCALAR_SUB:
+    case OP_SCALAR_TRUE_DIV:
+    case OP_GELU:
+    case OP_RSQRT:
+    case OP_POW:
+    case OP_SIN:
+    case OP_COS:
+    case OP_RELU:
+    case OP_SIGMOID:
+    case OP_TANH:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool ExpressionProgram::is_binary(OperatorType op_type) {
+  switch (op_type) {
+    case OP_EW_ADD:
+    case OP_EW_SUB:
+    case OP_EW_MUL:
+    case OP_EW_DIV:
+    case OP_EW_MAX:
+    case OP_EW_MIN:
+      return true;
+    default:
+      return false;
+  }
+}
+
+int ExpressionProgram::add_unary(OperatorType op_type, int x, float scalar) {
+  assert(is_unary(op_type));
+  assert(num_nodes < MAX_EXPRESSION_NODES);
+  assert(x >= 0 && x < num_operands());
+  ExpressionNode &node = nodes[num_nodes++];
+  node.op_type = op_type;
+  node.lhs = x;
+  node.rhs = -1;
+  node.scalar = scalar;
+  return output();
+}
+
+int ExpressionProgram::add_binary(OperatorType op_type, int lhs, int rhs) {
+  assert(is_binary(op_type));
+  assert(num_nodes < MAX_EXPRESSION_NODES);
+  assert(lhs >= 0 && lhs < num_operands());
+  assert(rhs >= 0 && rhs < num_operands());
+  ExpressionNode &node = nodes[num_nodes++];
+  node.op_type = op_type;
+  node.lhs = lhs;
+  node.rhs = rhs;
+  node.scalar = 0.0f;
+  return output();
+}
+
+namespace Kernels {
+namespace ElementExpression {
+
+namespace {
+
+// Elements evaluated at a time; the buffers of all the operands of a chunk
+// stay in the cache
+int const CHUNK_SIZE = 512;
+
+// The loops below are instantiated for each operation so that the switch is
+// hoisted out of them and they can be vectorized
+template <typename F>
+void dispatch_unary(OperatorType op_type, F const &f) {
+  switch (op_type) {
+    case OP_EXP:
+      f.template run<OP_EXP>();
+      break;
+    case OP_IDENTITY:
+      f.template run<OP_IDENTITY>();
+      break;
+    case OP_SCALAR_MULTIPLY:
+      f.template run<OP_SCALAR_MULTIPLY>();
+      break;
+    case OP_SCALAR_ADD:
+      f.template run<OP_SCALAR_ADD>();
+      break;
+    case OP_SCALAR_SUB:
+      f.template run<OP_SCALAR_SUB>();
+      break;
+    case OP_SCALAR_TRUE_DIV:
+      f.template run<OP_SCALAR_TRUE_DIV>();
+      break;
+    case OP_GELU:
+      f.template run<OP_GELU>();
+      break;
+    case OP_RSQRT:
+      f.template run<OP_RSQRT>();
+      break;
+    case OP_POW:
+      f.template run<OP_POW>();
+      break;
+    case OP_SIN:
+      f.template run<OP_SIN>();
+      break;
+    case OP_COS:
+      f.template run<OP_COS>();
+      break;
+    case OP_RELU:
+      f.template run<OP_RELU>();
+      break;
+    case OP_SIGMOID:
+      f.template run<OP_SIGMOID>();
+      break;
+    case OP_TANH:
+      f.template run<OP_TANH>();
+      break;
+    default:
+      assert(false && "Unsupported unary operation");
+  }
+}
+
+template <typename F>
+void dispatch_binary(OperatorType op_type, F const &f) {
+  switch (op_type) {
+    case OP_EW_ADD:
+      f.template run<OP_EW_ADD>();
+      break;
+    case OP_EW_SUB:
+      f.template run<OP_EW_SUB>();
+      break;
+    case OP_EW_MUL:
+      f.template run<OP_EW_MUL>();
+      break;
+    case OP_EW_DIV:
+      f.template run<OP_EW_DIV>();
+      break;
+    case OP_EW_MAX:
+      f.template run<OP_EW_MAX>();
+      break;
+    case OP_EW_MIN:
+      f.template run<OP_EW_MIN>();
+      break;
+    default:
+      assert(false && "Unsupported binary operation");
+  }
+}
+
+struct UnaryForward {
+  float s;
+  float const *x;
+  float *y;
+  int n;
+  template <OperatorType OP>
+  void run() const {
+    for (int k = 0; k < n; k++) {
+      y[k] = apply_unary(OP, s, x[k]);
+    }
+  }
+};
+
+struct BinaryForward {
+  float const *a, *b;
+  float *y;
+  int n;
+  template <OperatorType OP>
+  void run() const {
+    for (int k = 0; k < n; k++) {
+      y[k] = apply_binary(OP, a[k], b[k]);
+    }
+  }
+};
+
+struct UnaryBackward {
+  float s;
+  float const *x, *y, *y_grad;
+  float *x_grad;
+  int n;
+  template <OperatorType OP>
+  void run() const {
+    for (int k = 0; k < n; k++) {
+      x_grad[k] += y_grad[k] * unary_derivative(OP, s, x[k], y[k]);
+    }
+  }
+};
+
+struct BinaryBackward {
+  float const *a, *b, *y_grad;
+  float *a_grad, *b_grad;
+  int n;
+  template <OperatorType OP>
+  void run() const {
+    for (int k = 0; k < n; k++) {
+      float da, db;
+      binary_derivatives(OP, a[k], b[k], da, db);
+      a_grad[k] += y_grad[k] * da;
+      b_grad[k] += y_grad[k] * db;
+    }
+  }
+};
+
+bool is_full(ExpressionShape const &shape, int i) {
+  return shape.input_volume(i) == shape.volume();
+}
+
+// Elements [start, start + n) of input i broadcast to the output, walking
+// the innermost dimension in runs
+float const *load_input(ExpressionShape const &shape,
+                        int i,
+                        float const *input,
+                        size_t start,
+                        int n,
+                        float *buffer) {
+  if (is_full(shape, i)) {
+    return input + start;
+  }
+  bool const inner = shape.input_dims[i][0] > 1;
+  size_t idx = start;
+  for (int k = 0; k < n;) {
+    int run = std::min(n - k, shape.dims[0] - (int)(idx % shape.dims[0]));
+    float const *src = input + shape.input_offset(i, idx);
+    for (int r = 0; r < run; r++) {
+      buffer[k + r] = inner ? src[r] : src[0];
+    }
+    k += run;
+    idx += run;
+  }
+  return buffer;
+}
+
+// The reverse of load_input: sums the gradients of the broadcast elements
+void store_input_grad(ExpressionShape const &shape,
+                      int i,
+                      float const *grad,
+                      size_t start,
+                      int n,
+                      float *input_grad) {
+  if (is_full(shape, i)) {
+    float *dst = input_grad + start;
+    for (int k = 0; k < n; k++) {
+      dst[k] += grad[k];
+    }
+    return;
+  }
+  bool const inner = shape.input_dims[i][0] > 1;
+  size_t idx = start;
+  for (int k = 0; k < n;) {
+    int run = std::min(n - k, shape.dims[0] - (int)(idx % shape.dims[0]));
+    float *dst = input_grad + shape.input_offset(i, idx);
+    if (inner) {
+      for (int r = 0; r < run; r++) {
+        dst[r] += grad[k + r];
+      }
+    } else {
+      float sum = 0.0f;
+      for (int r = 0; r < run; r++) {
+        sum += grad[k + r];
+      }
+      dst[0] += sum;
+    }
+    k += run;
+    idx += run;
+  }
+}
+
+// Evaluates every operand over a chunk. The value of the last node is
+// written to output when it is not NULL.
+void evaluate_chunk(ExpressionProgram const &program,
+                    ExpressionShape const &shape,
+                    float const *const *inputs,
+                    size_t start,
+                    int n,
+                    float *buffers,
+                    float const **values,
+                    float *output) {
+  for (int i = 0; i < program.num_inputs; i++) {
+    values[i] =
+        load_input(shape, i, inputs[i], start, n, buffers + i * CHUNK_SIZE);
+  }
+  for (int j = 0; j < program.num_nodes; j++) {
+    ExpressionNode const &node = program.nodes[j];
+    int const id = program.num_inputs + j;
+    float *y = (output != NULL && id == program.output())
+                   ? output
+                   : buffers + id * CHUNK_SIZE;
+    if (node.rhs < 0) {
+      UnaryForward f = {node.scalar, values[node.lhs], y, n};
+      dispatch_unary(node.op_type, f);
+    } else {
+      BinaryForward f = {values[node.lhs], values[node.rhs], y, n};
+      dispatch_binary(node.op_type, f);
+    }
+    values[id] = y;
+  }
+}
+
+} // namespace
+
+void forward_cpu(ExpressionProgram const &program,
+                 ExpressionShape const &shape,
+                 float const *const *inputs,
+                 float *output) {
+  assert(program.num_inputs <= MAX_EXPRESSION_INPUTS);
+  assert(program.num_nodes > 0);
+  int const num_operands = program.num_operands();
+  std::vector<float> buffers((size_t)num_operands * CHUNK_SIZE);
+  std::vector<float const *> values(num_operands);
+  size_t const volume = shape.volume();
+  for (size_t start = 0; start < volume; start += CHUNK_SIZE) {
+    int n = (int)std::min((size_t)CHUNK_SIZE, volume - start);
+    evaluate_chunk(program,
+                   shape,
+                   inputs,
+                   start,
+                   n,
+                   buffers.data(),
+                   values.data(),
+                   output + start);
+  }
+}
+
+void backward_cpu(ExpressionProgram const &program,
+                  ExpressionShape const &shape,
+                  float const *const *inputs,
+                  float const *output_grad,
+                  float *const *input_grads) {
+  assert(program.num_inputs <= MAX_EXPRESSION_INPUTS);
+  assert(program.num_nodes > 0);
+  int const num_operands = program.num_operands();
+  std::vector<float> buffers((size_t)num_operands * CHUNK_SIZE);
+  std::vector<float> grads((size_t)num_operands * CHUNK_SIZE);
+  std::vector<float const *> values(num_operands);
+  size_t const volume = shape.volume();
+  for (size_t start = 0; start < volume; start += CHUNK_SIZE) {
+    int n = (int)std::min((size_t)CHUNK_SIZE, volume - start);
+    evaluate_chunk(program,
+                   shape,
+                   inputs,
+                   start,
+                   n,
+                   buffers.data(),
+                   values.data(),
+                   NULL);
+    std::fill(
+        grads.begin(), grads.begin() + (num_operands - 1) * CHUNK_SIZE, 0.0f);
+    std::copy(output_grad + start,
+              output_grad + start + n,
+              grads.begin() + (num_operands - 1) * CHUNK_SIZE);
+    for (int j = program.num_nodes - 1; j >= 0; j--) {
+      ExpressionNode const &node = program.nodes[j];
+      int const id = program.num_inputs + j;
+      float const *y_grad = grads.data() + id * CHUNK_SIZE;
+      float *lhs_grad = grads.data() + node.lhs * CHUNK_SIZE;
+      if (node.rhs < 0) {
+        UnaryBackward f = {
+            node.scalar, values[node.lhs], values[id], y_grad, lhs_grad, n};
+        dispatch_unary(node.op_type, f);
+      } else {
+        float *rhs_grad = grads.data() + node.rhs * CHUNK_SIZE;
+        BinaryBackward f = {
+            values[node.lhs], values[node.rhs], y_grad, lhs_grad, rhs_grad, n};
+        dispatch_binary(node.op_type, f);
+      }
+    }
+    for (int i = 0; i < program.num_inputs; i++) {
+      if (input_grads[i] != NULL) {
+        store_input_grad(shape,
+                         i,
+                         grads.data() + i * CHUNK_SIZE,
+                         start,
+                         n,
+                         input_grads[i]);
+      }
+    }
+  }
+}
+
+} // namespace ElementExpression
+} // namespace Kernels
+} // namespace FlexFlow
@@ -210,6 +210,179 @@ void backward_kernel_wrapper(EmbeddingMeta const *m,
   }
 }
 
+void qr_forward_kernel_wrapper(EmbeddingMeta const *m,
+                               GenericTensorAccessorR const &input,
+                               GenericTensorAccessorW const &output,
+                               GenericTensorAccessorR const &quotient,
+                               GenericTensorAccessorR const &remainder,
+                               int in_dim,
+                               int out_dim,
+                               int batch_size) {
+  cudaStream_t stream;
+  checkCUDA(get_legion_stream(&stream));
+  assert(quotient.data_type == DT_FLOAT && remainder.data_type == DT_FLOAT);
+  if (input.data_type == DT_INT32) {
+    Internal::qr_forward_kernel(input.get_int32_ptr(),
+                                output.get_float_ptr(),
+                                quotient.get_float_ptr(),
+                                remainder.get_float_ptr(),
+                                in_dim,
+                                out_dim,
+                                batch_size,
+                                m->tables.num_buckets,
+                                m->aggr,
+                                stream);
+  } else if (input.data_type == DT_INT64) {
+    Internal::qr_forward_kernel(input.get_int64_ptr(),
+                                output.get_float_ptr(),
+                                quotient.get_float_ptr(),
+                                remainder.get_float_ptr(),
+                                in_dim,
+                                out_dim,
+                                batch_size,
+                                m->tables.num_buckets,
+                                m->aggr,
+                                stream);
+  } else {
+    assert(false && "Unsupported DataType in Embedding");
+  }
+  if (m->profiling) {
+    checkCUDA(cudaDeviceSynchronize());
+  }
+}
+
+void qr_backward_kernel_wrapper(EmbeddingMeta const *m,
+                                GenericTensorAccessorR const &input,
+                                GenericTensorAccessorR const &output,
+                                GenericTensorAccessorR const &quotient,
+                                GenericTensorAccessorR const &remainder,
+                                GenericTensorAccessorW const &quotient_grad,
+                                GenericTensorAccessorW const &remainder_grad,
+                                int in_dim,
+                                int out_dim,
+                                int batch_size) {
+  cudaStream_t stream;
+  checkCUDA(get_legion_stream(&stream));
+  assert(quotient.data_type == DT_FLOAT && remainder.data_type == DT_FLOAT);
+  if (input.data_type == DT_INT32) {
+    Internal::qr_backward_kernel(input.get_int32_ptr(),
+                                 output.get_float_ptr(),
+                                 quotient.get_float_ptr(),
+                                 remainder.get_float_ptr(),
+                                 quotient_grad.get_float_ptr(),
+                                 remainder_grad.get_float_ptr(),
+                                 in_dim,
+                                 out_dim,
+                                 batch_size,
+                                 m->tables.num_buckets,
+                                 m->aggr,
+                                 stream);
+  } else if (input.data_type == DT_INT64) {
+    Internal::qr_backward_kernel(input.get_int64_ptr(),
+                                 output.get_float_ptr(),
+                                 quotient.get_float_ptr(),
+                                 remainder.get_float_ptr(),
+                                 quotient_grad.get_float_ptr(),
+                                 remainder_grad.get_float_ptr(),
+                                 in_dim,
+                                 out_dim,
+                                 batch_size,
+                                 m->tables.num_buckets,
+                                 m->aggr,
+                                 stream);
+  } else {
+    assert(false && "Unsupported DataType in Embedding");
+  }
+  if (m->profiling) {
+    checkCUDA(cudaDeviceSynchronize());
+  }
+}
+
+void mixed_dim_forward_kernel_wrapper(EmbeddingMeta const *m,
+                                      GenericTensorAccessorR const &input,
+                                      GenericTensorAccessorW const &output,
+                                      GenericTensorAccessorR const &table,
+                                      GenericTensorAccessorR const &projection,
+                                      int in_dim,
+                                      int out_dim,
+                                      int batch_size) {
+  cudaStream_t stream;
+  checkCUDA(get_legion_stream(&stream));
+  assert(table.data_type == DT_FLOAT && projection.data_type == DT_FLOAT);
+  if (input.data_type == DT_INT32) {
+    Internal::mixed_dim_forward_kernel(m,
+                                       input.get_int32_ptr(),
+                                       output.get_float_ptr(),
+                                       table.get_float_ptr(),
+                                       projection.get_float_ptr(),
+                                       in_dim,
+                                       out_dim,
+                                       batch_size,
+                                       stream);
+  } else if (input.data_type == DT_INT64) {
+    Internal::mixed_dim_forward_kernel(m,
+                                       input.get_int64_ptr(),
+                                       output.get_float_ptr(),
+                                       table.get_float_ptr(),
+                                       projection.get_float_ptr(),
+                                       in_dim,
+                                       out_dim,
+                                       batch_size,
+                                       stream);
+  } else {
+    assert(false && "Unsupported DataType in Embedding");
+  }
+  if (m->profiling) {
+    checkCUDA(cudaDeviceSynchronize());
+  }
+}
+
+void mixed_dim_backward_kernel_wrapper(
+    EmbeddingMeta const *m,
+    GenericTensorAccessorR const &input,
+    GenericTensorAccessorR const &output,
+    GenericTensorAccessorR const &table,
+    GenericTensorAccessorR const &projection,
+    GenericTensorAccessorW const &table_grad,
+    GenericTensorAccessorW const &projection_grad,
+    int in_dim,
+    int out_dim,
+    int batch_size) {
+  cudaStream_t stream;
+  checkCUDA(get_legion_stream(&stream));
+  assert(table.data_type == DT_FLOAT && projection.data_type == DT_FLOAT);
+  if (input.data_type == DT_INT32) {
+    Internal::mixed_dim_backward_kernel(m,
+                                        input.get_int32_ptr(),
+                                        output.get_float_ptr(),
+                                        table.get_float_ptr(),
+                                        projection.get_float_ptr(),
+                                        table_grad.get_float_ptr(),
+                                        projection_grad.get_float_ptr(),
+                                        in_dim,
+                                        out_dim,
+                                        batch_size,
+                                        stream);
+  } else if (input.data_type == DT_INT64) {
+    Internal::mixed_dim_backward_kernel(m,
+                                        input.get_int64_ptr(),
+                                        output.get_float_ptr(),
+                                        table.get_float_ptr(),
+                                        projection.get_float_ptr(),
+                                        table_grad.get_float_ptr(),
+                                        projection_grad.get_float_ptr(),
+                                        in_dim,
+                                        out_dim,
+                                        batch_size,
+                                        stream);
+  } else {
+    assert(false && "Unsupported DataType in Embedding");
+  }
+  if (m->profiling) {
+    checkCUDA(cudaDeviceSynchronize());
+  }
+}
+
 void rand_generate_int64_wrapper(int64_t *ptr, size_t size, int64_t p) {
   cudaStream_t stream;
   checkCUDA(get_legion_stream(&stream));
@@ -258,11 +431,11 @@ __global__ void embed_forward_with_aggr(TI const *input,
     for (int j = 0; j < in_dim; j++) {
       TI wordIdx = input[idx * in_dim + j];
       output[i] = output[i] + embed[wordIdx * out_dim + off];
-      if (aggr == AGGR_MODE_SUM) {
-      } else {
-        assert(aggr == AGGR_MODE_AVG);
-        output[i] = output[i] * scale;
-      }
+    }
+    if (aggr == AGGR_MODE_SUM) {
+    } else {
+      assert(aggr == AGGR_MODE_AVG);
+      output[i] = output[i] * scale;
     }
   }
 }
@@ -479,6 +652,225 @@ void backward_kernel(TI const *input_ptr,
   }
 }
 
+// Row i of a QR embedding is quotient[i / num_buckets] * remainder[i %
+// num_buckets], aggregated over the bag like the dense rows
+template <typename TI>
+__global__ void qr_embed_forward(TI const *input,
+                                 float *output,
+                                 float const *quotient,
+                                 float const *remainder,
+                                 int out_dim,
+                                 int in_dim,
+                                 int batch_size,
+                                 int num_buckets,
+                                 float scale) {
+  CUDA_KERNEL_LOOP(i, batch_size * out_dim) {
+    int idx = i / out_dim;
+    int off = i % out_dim;
+    float sum = 0.0f;
+    for (int j = 0; j < in_dim; j++) {
+      TI wordIdx = input[idx * in_dim + j];
+      sum += quotient[(wordIdx / num_buckets) * out_dim + off] *
+             remainder[(wordIdx % num_buckets) * out_dim + off];
+    }
+    output[i] = sum * scale;
+  }
+}
+
+template <typename TI>
+__global__ void qr_embed_backward(TI const *input,
+                                  float const *output,
+                                  float const *quotient,
+                                  float const *remainder,
+                                  float *quotient_grad,
+                                  float *remainder_grad,
+                                  int out_dim,
+                                  int in_dim,
+                                  int batch_size,
+                                  int num_buckets,
+                                  float scale) {
+  CUDA_KERNEL_LOOP(i, batch_size * out_dim) {
+    int idx = i / out_dim;
+    int off = i % out_dim;
+    float gradient = output[i] * scale;
+    for (int j = 0; j < in_dim; j++) {
+      TI wordIdx = input[idx * in_dim + j];
+      TI q = (wordIdx / num_buckets) * out_dim + off;
+      TI r = (wordIdx % num_buckets) * out_dim + off;
+      atomicAdd(quotient_grad + q, gradient * remainder[r]);
+      atomicAdd(remainder_grad + r, gradient * quotient[q]);
+    }
+  }
+}
+
+template <typename TI>
+void qr_forward_kernel(TI const *input_ptr,
+                       float *output_ptr,
+                       float const *quotient_ptr,
+                       float const *remainder_ptr,
+                       int in_dim,
+                       int out_dim,
+                       int batch_size,
+                       int num_buckets,
+                       AggrMode aggr,
+                       cudaStream_t stream) {
+  float scale = aggr == AGGR_MODE_AVG ? 1.0f / in_dim : 1.0f;
+  int outputSize = batch_size * out_dim;
+  qr_embed_forward<TI>
+      <<<GET_BLOCKS(outputSize), CUDA_NUM_THREADS, 0, stream>>>(input_ptr,
+                                                                output_ptr,
+                                                                quotient_ptr,
+                                                                remainder_ptr,
+                                                                out_dim,
+                                                                in_dim,
+                                                                batch_size,
+                                                                num_buckets,
+                                                                scale);
+}
+
+template <typename TI>
+void qr_backward_kernel(TI const *input_ptr,
+                        float const *output_ptr,
+                        float const *quotient_ptr,
+                        float const *remainder_ptr,
+                        float *quotient_grad_ptr,
+                        float *remainder_grad_ptr,
+                        int in_dim,
+                        int out_dim,
+                        int batch_size,
+                        int num_buckets,
+                        AggrMode aggr,
+                        cudaStream_t stream) {
+  float scale = aggr == AGGR_MODE_AVG ? 1.0f / in_dim : 1.0f;
+  int outputSize = batch_size * out_dim;
+  qr_embed_backward<TI>
+      <<<GET_BLOCKS(outputSize), CUDA_NUM_THREADS, 0, stream>>>(
+          input_ptr,
+          output_ptr,
+          quotient_ptr,
+          remainder_ptr,
+          quotient_grad_ptr,
+          remainder_grad_ptr,
+          out_dim,
+          in_dim,
+          batch_size,
+          num_buckets,
+          scale);
+}
+
+template <typename TI>
+void mixed_dim_forward_kernel(EmbeddingMeta const *m,
+                              TI const *input_ptr,
+                              float *output_ptr,
+                              float const *table_ptr,
+                              float const *projection_ptr,
+                              int in_dim,
+                              int out_dim,
+                              int batch_size,
+                              cudaStream_t stream) {
+  int embed_dim = m->tables.embed_dim;
+  assert(sizeof(float) * batch_size * embed_dim <= m->handle.workSpaceSize);
+  float *h_ptr = (float *)m->handle.workSpace;
+  forward_kernel<TI, float>(input_ptr,
+                            h_ptr,
+                            table_ptr,
+                            in_dim,
+                            embed_dim,
+                            batch_size,
+                            m->aggr,
+                            batch_size * embed_dim,
+                            stream);
+  checkCUDA(cublasSetStream(m->handle.blas, stream));
+  float alpha = 1.0f, beta = 0.0f;
+  // output[batch_size][out_dim] = h[batch_size][embed_dim] x
+  // projection[embed_dim][out_dim]
+  checkCUDA(cublasSgemm(m->handle.blas,
+                        CUBLAS_OP_N,
+                        CUBLAS_OP_N,
+                        out_dim,
+                        batch_size,
+                        embed_dim,
+                        &alpha,
+                        projection_ptr,
+                        out_dim,
+                        h_ptr,
+                        embed_dim,
+                        &beta,
+                        output_ptr,
+                        out_dim));
+}
+
+template <typename TI>
+void mixed_dim_backward_kernel(EmbeddingMeta const *m,
+                               TI const *input_ptr,
+                               float const *output_ptr,
+                               float const *table_ptr,
+                               float const *projection_ptr,
+                               float *table_grad_ptr,
+                               float *projection_grad_ptr,
+                               int in_dim,
+                               int out_dim,
+                               int batch_size,
+                               cudaStream_t stream) {
+  int embed_dim = m->tables.embed_dim;
+  assert(2 * sizeof(float) * batch_size * embed_dim <=
+         m->handle.workSpaceSize);
+  float *h_ptr = (float *)m->handle.workSpace;
+  float *h_grad_ptr = h_ptr + (size_t)batch_size * embed_dim;
+  // Recompute the aggregated rows rather than keeping them from the forward
+  // pass
+  forward_kernel<TI, float>(input_ptr,
+                            h_ptr,
+                            table_ptr,
+                            in_dim,
+                            embed_dim,
+                            batch_size,
+                            m->aggr,
+                            batch_size * embed_dim,
+                            stream);
+  checkCUDA(cublasSetStream(m->handle.blas, stream));
+  float alpha = 1.0f, beta = 0.0f;
+  // projection_grad += h^T x output_grad
+  checkCUDA(cublasSgemm(m->handle.blas,
+                        CUBLAS_OP_N,
+                        CUBLAS_OP_T,
+                        out_dim,
+                        embed_dim,
+                        batch_size,
+                        &alpha,
+                        output_ptr,
+                        out_dim,
+                        h_ptr,
+                        embed_dim,
+                        &alpha,
+                        projection_grad_ptr,
+                        out_dim));
+  // h_grad = output_grad x projection^T
+  checkCUDA(cublasSgemm(m->handle.blas,
+                        CUBLAS_OP_T,
+                        CUBLAS_OP_N,
+                        embed_dim,
+                        batch_size,
+                        out_dim,
+                        &alpha,
+                        projection_ptr,
+                        out_dim,
+                        output_ptr,
+                        out_dim,
+                        &beta,
+                        h_grad_ptr,
+                        embed_dim));
+  backward_kernel<TI, float>(input_ptr,
+                             h_grad_ptr,
+                             table_grad_ptr,
+                             in_dim,
+                             embed_dim,
+                             batch_size,
+                             m->aggr,
+                             batch_size * embed_dim,
+                             stream);
+}
+
 template <typename TD>
 __global__ void rand_generate_int(TD *ptr, size_t size, TD p) {
   CUDA_KERNEL_LOOP(i, size) {
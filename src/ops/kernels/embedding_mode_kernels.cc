@@ -0,0 +1,199 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flexflow/ops/kernels/embedding_mode_kernels.h"
+#include <cassert>
+#include <vector>
+
+namespace FlexFlow {
+namespace Kernels {
+namespace Embedding {
+
+namespace {
+
+float bag_scale(AggrMode aggr, int in_dim) {
+  return aggr == AGGR_MODE_AVG ? 1.0f / in_dim : 1.0f;
+}
+
+// h[n] = aggr_j table[input[n][j]], with rows of dim elements
+void gather(AggrMode aggr,
+            int64_t const *input,
+            float const *table,
+            float *h,
+            int dim,
+            int in_dim,
+            int batch_size) {
+  float scale = bag_scale(aggr, in_dim);
+  for (int n = 0; n < batch_size; n++) {
+    float *out = h + (size_t)n * dim;
+    for (int e = 0; e < dim; e++) {
+      out[e] = 0.0f;
+    }
+    for (int j = 0; j < in_dim; j++) {
+      float const *row = table + input[(size_t)n * in_dim + j] * dim;
+      for (int e = 0; e < dim; e++) {
+        out[e] += row[e];
+      }
+    }
+    for (int e = 0; e < dim; e++) {
+      out[e] *= scale;
+    }
+  }
+}
+
+void scatter(AggrMode aggr,
+             int64_t const *input,
+             float const *h_grad,
+             float *table_grad,
+             int dim,
+             int in_dim,
+             int batch_size) {
+  float scale = bag_scale(aggr, in_dim);
+  for (int n = 0; n < batch_size; n++) {
+    float const *grad = h_grad + (size_t)n * dim;
+    for (int j = 0; j < in_dim; j++) {
+      float *row = table_grad + input[(size_t)n * in_dim + j] * dim;
+      for (int e = 0; e < dim; e++) {
+        row[e] += scale * grad[e];
+      }
+    }
+  }
+}
+
+} // namespace
+
+void forward_cpu(EmbeddingTables const &tables,
+                 AggrMode aggr,
+                 int64_t const *input,
+                 float const *const *weights,
+                 float *output,
+                 int in_dim,
+                 int batch_size) {
+  assert(aggr != AGGR_MODE_NONE || in_dim == 1);
+  int const d = tables.out_dim;
+  switch (tables.mode) {
+    case EMBEDDING_MODE_DENSE:
+      gather(aggr, input, weights[0], output, d, in_dim, batch_size);
+      break;
+    case EMBEDDING_MODE_QR: {
+      float scale = bag_scale(aggr, in_dim);
+      for (int n = 0; n < batch_size; n++) {
+        float *out = output + (size_t)n * d;
+        for (int e = 0; e < d; e++) {
+          out[e] = 0.0f;
+        }
+        for (int j = 0; j < in_dim; j++) {
+          int64_t idx = input[(size_t)n * in_dim + j];
+          float const *q = weights[0] + (idx / tables.num_buckets) * d;
+          float const *r = weights[1] + (idx % tables.num_buckets) * d;
+          for (int e = 0; e < d; e++) {
+            out[e] += q[e] * r[e];
+          }
+        }
+        for (int e = 0; e < d; e++) {
+          out[e] *= scale;
+        }
+      }
+      break;
+    }
+    case EMBEDDING_MODE_MIXED_DIM: {
+      int const k = tables.embed_dim;
+      std::vector<float> h((size_t)batch_size * k);
+      gather(aggr, input, weights[0], h.data(), k, in_dim, batch_size);
+      for (int n = 0; n < batch_size; n++) {
+        float *out = output + (size_t)n * d;
+        for (int e = 0; e < d; e++) {
+          out[e] = 0.0f;
+        }
+        for (int c = 0; c < k; c++) {
+          float hc = h[(size_t)n * k + c];
+          float const *p = weights[1] + (size_t)c * d;
+          for (int e = 0; e < d; e++) {
+            out[e] += hc * p[e];
+          }
+        }
+      }
+      break;
+    }
+    default:
+      assert(false && "Unsupported embedding mode");
+  }
+}
+
+void backward_cpu(EmbeddingTables const &tables,
+                  AggrMode aggr,
+                  int64_t const *input,
+                  float const *const *weights,
+                  float const *output_grad,
+                  float *const *weight_grads,
+                  int in_dim,
+                  int batch_size) {
+  assert(aggr != AGGR_MODE_NONE || in_dim == 1);
+  int const d = tables.out_dim;
+  switch (tables.mode) {
+    case EMBEDDING_MODE_DENSE:
+      scatter(
+          aggr, input, output_grad, weight_grads[0], d, in_dim, batch_size);
+      break;
+    case EMBEDDING_MODE_QR: {
+      float scale = bag_scale(aggr, in_dim);
+      for (int n = 0; n < batch_size; n++) {
+        float const *grad = output_grad + (size_t)n * d;
+        for (int j = 0; j < in_dim; j++) {
+          int64_t idx = input[(size_t)n * in_dim + j];
+          size_t q = (idx / tables.num_buckets) * d;
+          size_t r = (idx % tables.num_buckets) * d;
+          for (int e = 0; e < d; e++) {
+            float g = scale * grad[e];
+            weight_grads[0][q + e] += g * weights[1][r + e];
+            weight_grads[1][r + e] += g * weights[0][q + e];
+          }
+        }
+      }
+      break;
+    }
+    case EMBEDDING_MODE_MIXED_DIM: {
+      // The forward pass is recomputed rather than keeping the aggregated
+      // rows around
+      int const k = tables.embed_dim;
+      std::vector<float> h((size_t)batch_size * k);
+      std::vector<float> h_grad((size_t)batch_size * k, 0.0f);
+      gather(aggr, input, weights[0], h.data(), k, in_dim, batch_size);
+      for (int n = 0; n < batch_size; n++) {
+        float const *grad = output_grad + (size_t)n * d;
+        for (int c = 0; c < k; c++) {
+          float hc = h[(size_t)n * k + c];
+          float const *p = weights[1] + (size_t)c * d;
+          float *p_grad = weight_grads[1] + (size_t)c * d;
+          float sum = 0.0f;
+          for (int e = 0; e < d; e++) {
+            p_grad[e] += hc * grad[e];
+            sum += p[e] * grad[e];
+          }
+          h_grad[(size_t)n * k + c] = sum;
+        }
+      }
+      scatter(
+          aggr, input, h_grad.data(), weight_grads[0], k, in_dim, batch_size);
+      break;
+    }
+    default:
+      assert(false && "Unsupported embedding mode");
+  }
+}
+
+} // namespace Embedding
+} // namespace Kernels
+} // namespace FlexFlow
@@ -297,6 +297,10 @@ void backward_kernel(LinearMeta const *m,
   checkCUDNN(miopenSetStream(m->handle.dnn, stream));
 
   float alpha = 1.0f;
+  // The first writer of a gradient overwrites it, see
+  // FFModel::plan_gradient_overwrites
+  float input_beta = m->resetInputGrads[0] ? 0.0f : 1.0f;
+  float weight_beta = m->resetWeightGrads ? 0.0f : 1.0f;
   hipblasDatatype_t input_type = ff_to_cuda_datatype(m->input_type);
   hipblasDatatype_t weight_type = ff_to_cuda_datatype(m->weight_type);
   hipblasDatatype_t output_type = ff_to_cuda_datatype(m->output_type);
@@ -318,7 +322,6 @@ void backward_kernel(LinearMeta const *m,
     assert(m->activation == AC_MODE_NONE);
   }
   // Compute weight gradiant
-  // NOTE: we use alpha=1 for kernel_grad to accumulate gradients
   checkCUDA(hipblasGemmEx(m->handle.blas,
                           HIPBLAS_OP_N,
                           HIPBLAS_OP_T,
@@ -332,14 +335,13 @@ void backward_kernel(LinearMeta const *m,
                           output_grad_ptr,
                           output_type,
                           out_dim,
-                          &alpha,
+                          &weight_beta,
                           kernel_grad_ptr,
                           weight_type,
                           in_dim,
                           compute_type,
                           HIPBLAS_GEMM_DEFAULT));
   // Compute bias gradiant
-  // NOTE: we use alpha=1 for bias_grad to accumulate gradients
   // use_bias = True
   if (bias_grad_ptr != NULL) {
     checkCUDA(hipblasGemmEx(m->handle.blas,
@@ -355,7 +357,7 @@ void backward_kernel(LinearMeta const *m,
                             output_grad_ptr,
                             output_type,
                             out_dim,
-                            &alpha,
+                            &weight_beta,
                             bias_grad_ptr,
                             weight_type,
                             1,
@@ -363,7 +365,6 @@ void backward_kernel(LinearMeta const *m,
                             HIPBLAS_GEMM_DEFAULT));
   }
   // Compute data gradiant
-  // NOTE: we use alpha=1 for input_grad to accumulate gradients
   if (input_grad_ptr != NULL) {
     checkCUDA(hipblasGemmEx(m->handle.blas,
                             HIPBLAS_OP_N,
@@ -378,7 +379,7 @@ void backward_kernel(LinearMeta const *m,
                             output_grad_ptr,
                             output_type,
                             out_dim,
-                            &alpha,
+                            &input_beta,
                             input_grad_ptr,
                             input_type,
                             in_dim,
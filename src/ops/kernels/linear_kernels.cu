@@ -289,6 +289,10 @@ void backward_kernel(LinearMeta const *m,
   checkCUDNN(cudnnSetStream(m->handle.dnn, stream));
 
   float alpha = 1.0f;
+  // The first writer of a gradient overwrites it, see
+  // FFModel::plan_gradient_overwrites
+  float input_beta = m->resetInputGrads[0] ? 0.0f : 1.0f;
+  float weight_beta = m->resetWeightGrads ? 0.0f : 1.0f;
   cudaDataType_t input_type = ff_to_cuda_datatype(m->input_type);
   cudaDataType_t weight_type = ff_to_cuda_datatype(m->weight_type);
   cudaDataType_t output_type = ff_to_cuda_datatype(m->output_type);
@@ -310,7 +314,6 @@ void backward_kernel(LinearMeta const *m,
     assert(m->activation == AC_MODE_NONE);
   }
   // Compute weight gradiant
-  // NOTE: we use alpha=1 for kernel_grad to accumulate gradients
   checkCUDA(cublasGemmEx(m->handle.blas,
                          CUBLAS_OP_N,
                          CUBLAS_OP_T,
@@ -324,14 +327,13 @@ void backward_kernel(LinearMeta const *m,
                          output_grad_ptr,
                          output_type,
                          out_dim,
-                         &alpha,
+                         &weight_beta,
                          kernel_grad_ptr,
                          weight_type,
                          in_dim,
                          compute_type,
                          CUBLAS_GEMM_DEFAULT_TENSOR_OP));
   // Compute bias gradiant
-  // NOTE: we use alpha=1 for bias_grad to accumulate gradients
   // use_bias = True
   if (bias_grad_ptr != NULL) {
     checkCUDA(cublasGemmEx(m->handle.blas,
@@ -347,7 +349,7 @@ void backward_kernel(LinearMeta const *m,
                            output_grad_ptr,
                            output_type,
                            out_dim,
-                           &alpha,
+                           &weight_beta,
                            bias_grad_ptr,
                            weight_type,
                            1,
@@ -355,7 +357,6 @@ void backward_kernel(LinearMeta const *m,
                            CUBLAS_GEMM_DEFAULT_TENSOR_OP));
   }
   // Compute data gradiant
-  // NOTE: we use alpha=1 for input_grad to accumulate gradients
   if (input_grad_ptr != NULL) {
     checkCUDA(cublasGemmEx(m->handle.blas,
                            CUBLAS_OP_N,
@@ -370,7 +371,7 @@ void backward_kernel(LinearMeta const *m,
                            output_grad_ptr,
                            output_type,
                            out_dim,
-                           &alpha,
+                           &input_beta,
                            input_grad_ptr,
                            input_type,
                            in_dim,
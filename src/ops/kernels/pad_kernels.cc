@@ -0,0 +1,56 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flexflow/ops/kernels/pad_kernels.h"
+#include <algorithm>
+#include <cstring>
+
+namespace FlexFlow {
+namespace Kernels {
+namespace Pad {
+
+void forward_cpu(TensorWindow const &window,
+                 size_t origin,
+                 float value,
+                 float const *input,
+                 float *output,
+                 size_t output_volume) {
+  std::fill(output, output + output_volume, value);
+  size_t const run = window.run_length();
+  size_t const volume = window.volume();
+  for (size_t idx = 0; idx < volume; idx += run) {
+    std::memcpy(output + origin + window.offset(idx),
+                input + idx,
+                run * sizeof(float));
+  }
+}
+
+void backward_cpu(TensorWindow const &window,
+                  size_t origin,
+                  float const *output_grad,
+                  float *input_grad) {
+  size_t const run = window.run_length();
+  size_t const volume = window.volume();
+  for (size_t idx = 0; idx < volume; idx += run) {
+    float const *src = output_grad + origin + window.offset(idx);
+    for (size_t k = 0; k < run; k++) {
+      input_grad[idx + k] += src[k];
+    }
+  }
+}
+
+} // namespace Pad
+} // namespace Kernels
+} // namespace FlexFlow
@@ -0,0 +1,83 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flexflow/ops/kernels/slice_kernels.h"
+#include <cassert>
+#include <cstring>
+
+namespace FlexFlow {
+
+size_t TensorWindow::set_dense(int ndims,
+                               int const *enclosing_dims,
+                               int const *offsets,
+                               int const *window_dims) {
+  assert(ndims <= MAX_TENSOR_DIM);
+  num_dims = ndims;
+  size_t origin = 0, stride = 1;
+  for (int d = 0; d < num_dims; d++) {
+    assert(offsets[d] >= 0);
+    assert(offsets[d] + window_dims[d] <= enclosing_dims[d]);
+    dims[d] = window_dims[d];
+    strides[d] = stride;
+    origin += offsets[d] * stride;
+    stride *= enclosing_dims[d];
+  }
+  return origin;
+}
+
+size_t TensorWindow::run_length() const {
+  size_t run = 1;
+  for (int d = 0; d < num_dims; d++) {
+    // The stride of a dimension of size 1 does not matter
+    if (dims[d] == 1) {
+      continue;
+    }
+    if (strides[d] != run) {
+      break;
+    }
+    run *= dims[d];
+  }
+  return run;
+}
+
+namespace Kernels {
+namespace Slice {
+
+void forward_cpu(TensorWindow const &window,
+                 float const *input,
+                 float *output) {
+  size_t const run = window.run_length();
+  size_t const volume = window.volume();
+  for (size_t idx = 0; idx < volume; idx += run) {
+    std::memcpy(output + idx, input + window.offset(idx), run * sizeof(float));
+  }
+}
+
+void backward_cpu(TensorWindow const &window,
+                  float const *output_grad,
+                  float *input_grad) {
+  size_t const run = window.run_length();
+  size_t const volume = window.volume();
+  for (size_t idx = 0; idx < volume; idx += run) {
+    float *dst = input_grad + window.offset(idx);
+    for (size_t k = 0; k < run; k++) {
+      dst[k] += output_grad[idx + k];
+    }
+  }
+}
+
+} // namespace Slice
+} // namespace Kernels
+} // namespace FlexFlow
@@ -0,0 +1,365 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flexflow/ops/kernels/tiled_attention_kernels.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace FlexFlow {
+
+size_t TiledAttentionShape::saved_state_size() const {
+  size_t rows = (size_t)num_samples * num_heads;
+  return rows * ((size_t)qo_seq_length * (q_proj_size + v_proj_size + 1) +
+                 (size_t)kv_seq_length * (k_proj_size + v_proj_size));
+}
+
+size_t TiledAttentionShape::backward_scratch_size() const {
+  size_t rows = (size_t)num_samples * num_heads;
+  return rows * ((size_t)qo_seq_length * (q_proj_size + v_proj_size + 1) +
+                 (size_t)kv_seq_length * (k_proj_size + v_proj_size));
+}
+
+size_t TiledAttentionShape::score_matrix_size() const {
+  return (size_t)num_samples * num_heads * qo_seq_length * kv_seq_length;
+}
+
+namespace Kernels {
+namespace TiledAttention {
+
+namespace {
+
+// out[i][a] (+)= sum_c w[a][c] * in[i][c]
+void project(float const *in,
+             float const *w,
+             float *out,
+             int rows,
+             int in_size,
+             int out_size,
+             bool accumulate) {
+  for (int i = 0; i < rows; i++) {
+    for (int a = 0; a < out_size; a++) {
+      float sum = accumulate ? out[(size_t)i * out_size + a] : 0.0f;
+      for (int c = 0; c < in_size; c++) {
+        sum += w[(size_t)a * in_size + c] * in[(size_t)i * in_size + c];
+      }
+      out[(size_t)i * out_size + a] = sum;
+    }
+  }
+}
+
+// Gradients of out = project(in, w): in_grad[i][c] += sum_a out_grad[i][a] *
+// w[a][c] and w_grad[a][c] += sum_i out_grad[i][a] * in[i][c]
+void project_backward(float const *in,
+                      float const *w,
+                      float const *out_grad,
+                      float *in_grad,
+                      float *w_grad,
+                      int rows,
+                      int in_size,
+                      int out_size) {
+  for (int i = 0; i < rows; i++) {
+    for (int a = 0; a < out_size; a++) {
+      float g = out_grad[(size_t)i * out_size + a];
+      if (g == 0.0f) {
+        continue;
+      }
+      for (int c = 0; c < in_size; c++) {
+        in_grad[(size_t)i * in_size + c] += g * w[(size_t)a * in_size + c];
+        w_grad[(size_t)a * in_size + c] += g * in[(size_t)i * in_size + c];
+      }
+    }
+  }
+}
+
+float dot(float const *a, float const *b, int n) {
+  float sum = 0.0f;
+  for (int i = 0; i < n; i++) {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+// Scores of the queries [q_begin, q_end) against the keys [k_begin, k_end)
+void score_tile(TiledAttentionShape const &shape,
+                float const *q,
+                float const *k,
+                int q_begin,
+                int q_end,
+                int k_begin,
+                int k_end,
+                float *scores) {
+  int const d = shape.q_proj_size;
+  int const width = k_end - k_begin;
+  for (int i = q_begin; i < q_end; i++) {
+    for (int j = k_begin; j < k_end; j++) {
+      scores[(size_t)(i - q_begin) * width + (j - k_begin)] =
+          shape.scale * dot(q + (size_t)i * d, k + (size_t)j * d, d);
+    }
+  }
+}
+
+// Per-head output o = softmax(q k^T) v without the score matrix. Computes
+// logsumexp, or uses it to normalize the probabilities if given
+void attend(TiledAttentionShape const &shape,
+            float const *q,
+            float const *k,
+            float const *v,
+            float *o,
+            float *lse,
+            bool lse_given) {
+  int const T = shape.tile_size;
+  int const dv = shape.v_proj_size;
+  std::vector<float> scores((size_t)T * T);
+  std::vector<float> row_max(T), row_sum(T);
+  for (int q_begin = 0; q_begin < shape.qo_seq_length; q_begin += T) {
+    int q_end = std::min(q_begin + T, shape.qo_seq_length);
+    std::fill(o + (size_t)q_begin * dv, o + (size_t)q_end * dv, 0.0f);
+    std::fill(row_max.begin(),
+              row_max.end(),
+              -std::numeric_limits<float>::infinity());
+    std::fill(row_sum.begin(), row_sum.end(), 0.0f);
+    for (int k_begin = 0; k_begin < shape.kv_seq_length; k_begin += T) {
+      int k_end = std::min(k_begin + T, shape.kv_seq_length);
+      int width = k_end - k_begin;
+      score_tile(shape, q, k, q_begin, q_end, k_begin, k_end, scores.data());
+      for (int i = q_begin; i < q_end; i++) {
+        float const *s = scores.data() + (size_t)(i - q_begin) * width;
+        float *o_i = o + (size_t)i * dv;
+        float m = lse_given ? lse[i] : row_max[i - q_begin];
+        if (!lse_given) {
+          // Rescale what has been accumulated to the new running maximum
+          float tile_max = *std::max_element(s, s + width);
+          if (tile_max > m) {
+            float correction = std::exp(m - tile_max);
+            row_sum[i - q_begin] *= correction;
+            for (int b = 0; b < dv; b++) {
+              o_i[b] *= correction;
+            }
+            m = tile_max;
+            row_max[i - q_begin] = m;
+          }
+        }
+        for (int j = 0; j < width; j++) {
+          float p = std::exp(s[j] - m);
+          row_sum[i - q_begin] += p;
+          float const *v_j = v + (size_t)(k_begin + j) * dv;
+          for (int b = 0; b < dv; b++) {
+            o_i[b] += p * v_j[b];
+          }
+        }
+      }
+    }
+    if (!lse_given) {
+      for (int i = q_begin; i < q_end; i++) {
+        float l = row_sum[i - q_begin];
+        for (int b = 0; b < dv; b++) {
+          o[(size_t)i * dv + b] /= l;
+        }
+        lse[i] = row_max[i - q_begin] + std::log(l);
+      }
+    }
+  }
+}
+
+} // namespace
+
+void forward_cpu(TiledAttentionShape const &shape,
+                 float const *query,
+                 float const *key,
+                 float const *value,
+                 float const *weight,
+                 float *output,
+                 float *logsumexp) {
+  assert(shape.q_proj_size == shape.k_proj_size);
+  assert(shape.tile_size > 0);
+  int const qo = shape.qo_seq_length, kv = shape.kv_seq_length;
+  std::vector<float> q((size_t)qo * shape.q_proj_size),
+      k((size_t)kv * shape.k_proj_size), v((size_t)kv * shape.v_proj_size),
+      o((size_t)qo * shape.v_proj_size), lse(qo);
+  std::fill(output,
+            output + (size_t)shape.num_samples * qo * shape.o_proj_size,
+            0.0f);
+  for (int n = 0; n < shape.num_samples; n++) {
+    float const *query_n = query + (size_t)n * qo * shape.q_size;
+    float const *key_n = key + (size_t)n * kv * shape.k_size;
+    float const *value_n = value + (size_t)n * kv * shape.v_size;
+    float *output_n = output + (size_t)n * qo * shape.o_proj_size;
+    for (int h = 0; h < shape.num_heads; h++) {
+      float const *w = weight + h * shape.weights_per_head();
+      project(query_n,
+              w + shape.wq_offset(),
+              q.data(),
+              qo,
+              shape.q_size,
+              shape.q_proj_size,
+              false);
+      project(key_n,
+              w + shape.wk_offset(),
+              k.data(),
+              kv,
+              shape.k_size,
+              shape.k_proj_size,
+              false);
+      project(value_n,
+              w + shape.wv_offset(),
+              v.data(),
+              kv,
+              shape.v_size,
+              shape.v_proj_size,
+              false);
+      attend(shape, q.data(), k.data(), v.data(), o.data(), lse.data(), false);
+      // The heads add up through the output projection
+      project(o.data(),
+              w + shape.wo_offset(),
+              output_n,
+              qo,
+              shape.v_proj_size,
+              shape.o_proj_size,
+              true);
+      if (logsumexp != NULL) {
+        std::copy(lse.begin(),
+                  lse.end(),
+                  logsumexp + ((size_t)n * shape.num_heads + h) * qo);
+      }
+    }
+  }
+}
+
+void backward_cpu(TiledAttentionShape const &shape,
+                  float const *query,
+                  float const *key,
+                  float const *value,
+                  float const *weight,
+                  float const *output_grad,
+                  float const *logsumexp,
+                  float *query_grad,
+                  float *key_grad,
+                  float *value_grad,
+                  float *weight_grad) {
+  assert(shape.q_proj_size == shape.k_proj_size);
+  int const T = shape.tile_size;
+  int const qo = shape.qo_seq_length, kv = shape.kv_seq_length;
+  int const d = shape.q_proj_size, dv = shape.v_proj_size;
+  std::vector<float> q((size_t)qo * d), k((size_t)kv * d),
+      v((size_t)kv * dv), o((size_t)qo * dv), o_grad((size_t)qo * dv),
+      q_grad((size_t)qo * d), k_grad((size_t)kv * d), v_grad((size_t)kv * dv),
+      delta(qo), scores((size_t)T * T);
+  for (int n = 0; n < shape.num_samples; n++) {
+    float const *query_n = query + (size_t)n * qo * shape.q_size;
+    float const *key_n = key + (size_t)n * kv * shape.k_size;
+    float const *value_n = value + (size_t)n * kv * shape.v_size;
+    float const *output_grad_n =
+        output_grad + (size_t)n * qo * shape.o_proj_size;
+    for (int h = 0; h < shape.num_heads; h++) {
+      float const *w = weight + h * shape.weights_per_head();
+      float *w_grad = weight_grad + h * shape.weights_per_head();
+      float *lse = const_cast<float *>(logsumexp) +
+                   ((size_t)n * shape.num_heads + h) * qo;
+      project(query_n, w + shape.wq_offset(), q.data(), qo, shape.q_size, d,
+              false);
+      project(key_n, w + shape.wk_offset(), k.data(), kv, shape.k_size, d,
+              false);
+      project(value_n, w + shape.wv_offset(), v.data(), kv, shape.v_size, dv,
+              false);
+      attend(shape, q.data(), k.data(), v.data(), o.data(), lse, true);
+
+      // Through the output projection
+      std::fill(o_grad.begin(), o_grad.end(), 0.0f);
+      project_backward(o.data(),
+                       w + shape.wo_offset(),
+                       output_grad_n,
+                       o_grad.data(),
+                       w_grad + shape.wo_offset(),
+                       qo,
+                       dv,
+                       shape.o_proj_size);
+      for (int i = 0; i < qo; i++) {
+        delta[i] = dot(o_grad.data() + (size_t)i * dv,
+                       o.data() + (size_t)i * dv,
+                       dv);
+      }
+
+      // Through the softmax, recomputing the probabilities tile by tile
+      std::fill(q_grad.begin(), q_grad.end(), 0.0f);
+      std::fill(k_grad.begin(), k_grad.end(), 0.0f);
+      std::fill(v_grad.begin(), v_grad.end(), 0.0f);
+      for (int q_begin = 0; q_begin < qo; q_begin += T) {
+        int q_end = std::min(q_begin + T, qo);
+        for (int k_begin = 0; k_begin < kv; k_begin += T) {
+          int k_end = std::min(k_begin + T, kv);
+          int width = k_end - k_begin;
+          score_tile(shape,
+                     q.data(),
+                     k.data(),
+                     q_begin,
+                     q_end,
+                     k_begin,
+                     k_end,
+                     scores.data());
+          for (int i = q_begin; i < q_end; i++) {
+            float const *s = scores.data() + (size_t)(i - q_begin) * width;
+            float const *o_grad_i = o_grad.data() + (size_t)i * dv;
+            for (int j = k_begin; j < k_end; j++) {
+              float p = std::exp(s[j - k_begin] - lse[i]);
+              float *v_grad_j = v_grad.data() + (size_t)j * dv;
+              for (int b = 0; b < dv; b++) {
+                v_grad_j[b] += p * o_grad_i[b];
+              }
+              float dp = dot(o_grad_i, v.data() + (size_t)j * dv, dv);
+              float ds = p * (dp - delta[i]) * shape.scale;
+              for (int a = 0; a < d; a++) {
+                q_grad[(size_t)i * d + a] += ds * k[(size_t)j * d + a];
+                k_grad[(size_t)j * d + a] += ds * q[(size_t)i * d + a];
+              }
+            }
+          }
+        }
+      }
+
+      // Through the input projections
+      project_backward(query_n,
+                       w + shape.wq_offset(),
+                       q_grad.data(),
+                       query_grad + (size_t)n * qo * shape.q_size,
+                       w_grad + shape.wq_offset(),
+                       qo,
+                       shape.q_size,
+                       d);
+      project_backward(key_n,
+                       w + shape.wk_offset(),
+                       k_grad.data(),
+                       key_grad + (size_t)n * kv * shape.k_size,
+                       w_grad + shape.wk_offset(),
+                       kv,
+                       shape.k_size,
+                       d);
+      project_backward(value_n,
+                       w + shape.wv_offset(),
+                       v_grad.data(),
+                       value_grad + (size_t)n * kv * shape.v_size,
+                       w_grad + shape.wv_offset(),
+                       kv,
+                       shape.v_size,
+                       dv);
+    }
+  }
+}
+
+} // namespace TiledAttention
+} // namespace Kernels
+} // namespace FlexFlow
@@ -315,6 +315,8 @@ OpMeta *Linear::init_task_with_dim(Task const *task,
   m->use_bias = linear->use_bias;
   m->profiling = linear->profiling;
   m->trainableInputs[0] = linear->trainableInputs[0];
+  m->resetInputGrads[0] = linear->resetInputGrads[0];
+  m->resetWeightGrads = linear->resetWeightGrads;
   m->input_type = linear->inputs[0]->data_type;
   m->weight_type = linear->weights[0]->data_type;
   m->output_type = linear->outputs[0]->data_type;
@@ -770,6 +772,16 @@ bool Linear::is_valid_parallel_config(FFModel const &ff,
   return true;
 }
 
+// The backward pass writes the whole input and weight gradients with GEMMs,
+// whose beta selects between overwriting and accumulating
+bool Linear::can_overwrite_input_grad(int input_idx) const {
+  return true;
+}
+
+bool Linear::can_overwrite_weight_grads() const {
+  return true;
+}
+
 bool Linear::measure_operator_cost(Simulator *sim,
                                    MachineView const &mv,
                                    CostMetrics &cost_metrics) const {
@@ -0,0 +1,451 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flexflow/ops/pad.h"
+#include "flexflow/utils/hash_utils.h"
+#include "legion/legion_utilities.h"
+
+namespace FlexFlow {
+
+// declare Legion names
+using Legion::ArgumentMap;
+using Legion::Context;
+using Legion::coord_t;
+using Legion::Domain;
+using Legion::FutureMap;
+using Legion::IndexLauncher;
+using Legion::PhysicalRegion;
+using Legion::Predicate;
+using Legion::Rect;
+using Legion::RegionRequirement;
+using Legion::Runtime;
+using Legion::Task;
+using Legion::TaskArgument;
+using Legion::TaskLauncher;
+using PCG::Node;
+
+bool operator==(PadParams const &lhs, PadParams const &rhs) {
+  return lhs.pads_before == rhs.pads_before &&
+         lhs.pads_after == rhs.pads_after && lhs.value == rhs.value;
+}
+
+bool PadParams::is_valid(ParallelTensorShape const &input) const {
+  if (!input.is_valid()) {
+    return false;
+  }
+  if (pads_before.size() != pads_after.size() ||
+      (int)pads_before.size() > input.num_dims) {
+    return false;
+  }
+  for (size_t i = 0; i < pads_before.size(); i++) {
+    if (pads_before[i] < 0 || pads_after[i] < 0) {
+      return false;
+    }
+    // A padded dim cannot be partitioned
+    if (pads_before[i] + pads_after[i] > 0 && input.dims[i].degree != 1) {
+      return false;
+    }
+  }
+  return true;
+}
+
+PadParams Pad::get_params() const {
+  PadParams params;
+  params.pads_before = this->pads_before;
+  params.pads_after = this->pads_after;
+  params.value = this->value;
+  return params;
+}
+
+Tensor FFModel::pad(const Tensor input,
+                    std::vector<int> const &_pads_before,
+                    std::vector<int> const &_pads_after,
+                    float value,
+                    char const *name) {
+  assert((int)_pads_before.size() == input->num_dims);
+  assert((int)_pads_after.size() == input->num_dims);
+  int numdim = input->num_dims;
+  // Use Legion indexing to store the pads
+  std::vector<int> pads_before(numdim), pads_after(numdim);
+  int dims[MAX_TENSOR_DIM];
+  bool identity = true;
+  for (int i = 0; i < numdim; i++) {
+    pads_before[i] = _pads_before[numdim - 1 - i];
+    pads_after[i] = _pads_after[numdim - 1 - i];
+    assert(pads_before[i] >= 0 && pads_after[i] >= 0);
+    dims[i] = input->dims[i] + pads_before[i] + pads_after[i];
+    identity = identity && dims[i] == input->dims[i];
+  }
+  if (identity) {
+    return input;
+  }
+  Layer *pad = new Layer(this,
+                         OP_PAD,
+                         DT_FLOAT,
+                         name,
+                         1 /*inputs*/,
+                         0 /*weights*/,
+                         1 /*outputs*/,
+                         input);
+  pad->outputs[0] = create_tensor_legion_ordering(
+      numdim, dims, input->data_type, pad, 0, true /*create_grad*/);
+  pad->add_int_vector_property("pads_before", pads_before);
+  pad->add_int_vector_property("pads_after", pads_after);
+  pad->add_float_property("value", value);
+  layers.push_back(pad);
+  return pad->outputs[0];
+}
+
+Op *Pad::create_operator_from_layer(FFModel &model,
+                                    Layer const *layer,
+                                    std::vector<ParallelTensor> const &inputs) {
+  std::vector<int> pads_before, pads_after;
+  layer->get_int_vector_property("pads_before", pads_before);
+  layer->get_int_vector_property("pads_after", pads_after);
+  float value;
+  layer->get_float_property("value", value);
+  return new Pad(model, inputs[0], pads_before, pads_after, value, layer->name);
+}
+
+Pad::Pad(FFModel &model,
+         PadParams const &params,
+         const ParallelTensor input,
+         char const *name)
+    : Pad(model,
+          input,
+          params.pads_before,
+          params.pads_after,
+          params.value,
+          name) {}
+
+Pad::Pad(FFModel &model,
+         const ParallelTensor input,
+         std::vector<int> const &_pads_before,
+         std::vector<int> const &_pads_after,
+         float _value,
+         char const *name)
+    : Op(model,
+         OP_PAD,
+         input->data_type,
+         name,
+         1 /*inputs*/,
+         0 /*weights*/,
+         1 /*outputs*/,
+         input),
+      pads_before(_pads_before), pads_after(_pads_after), value(_value) {
+  assert(get_params().is_valid(input->get_shape()));
+  assert(input->data_type == DT_FLOAT);
+  int num_dim = input->num_dims;
+  ParallelDim dims[MAX_TENSOR_DIM];
+  for (int i = 0; i < num_dim; i++) {
+    dims[i] = input->dims[i];
+  }
+  for (size_t i = 0; i < pads_before.size(); i++) {
+    dims[i].size += pads_before[i] + pads_after[i];
+  }
+  numOutputs = 1;
+  outputs[0] = model.create_parallel_tensor_legion_ordering(
+      num_dim, dims, input->data_type, this);
+}
+
+void Pad::serialize(Legion::Serializer &sez) const {
+  sez.serialize(pads_before.size());
+  for (size_t i = 0; i < pads_before.size(); i++) {
+    sez.serialize(pads_before[i]);
+    sez.serialize(pads_after[i]);
+  }
+  sez.serialize(value);
+}
+
+/*static*/
+Node Pad::deserialize(FFModel &ff,
+                      Legion::Deserializer &dez,
+                      ParallelTensor inputs[],
+                      int num_inputs) {
+  assert(num_inputs == 1);
+  size_t num_dims;
+  dez.deserialize(num_dims);
+  PadParams params;
+  params.pads_before.resize(num_dims);
+  params.pads_after.resize(num_dims);
+  for (size_t i = 0; i < num_dims; i++) {
+    dez.deserialize(params.pads_before[i]);
+    dez.deserialize(params.pads_after[i]);
+  }
+  dez.deserialize(params.value);
+  return ff.get_or_create_node<Pad>(inputs[0], params);
+}
+
+Op *Pad::materialize(FFModel &ff,
+                     ParallelTensor inputs[],
+                     int num_inputs) const {
+  assert(num_inputs == 1);
+  return new Pad(ff,
+                 inputs[0],
+                 this->pads_before,
+                 this->pads_after,
+                 this->value,
+                 this->name);
+}
+
+/*static*/
+size_t Pad::get_window(PadMeta const *m,
+                       Domain const &input,
+                       Domain const &output,
+                       TensorWindow &window) {
+  int num_dims = input.get_dim();
+  assert(output.get_dim() == num_dims);
+  int input_dims[MAX_TENSOR_DIM], output_dims[MAX_TENSOR_DIM],
+      offsets[MAX_TENSOR_DIM];
+  for (int d = 0; d < num_dims; d++) {
+    input_dims[d] = input.hi()[d] - input.lo()[d] + 1;
+    output_dims[d] = output.hi()[d] - output.lo()[d] + 1;
+    offsets[d] = d < m->num_dims ? m->pads_before[d] : 0;
+  }
+  return window.set_dense(num_dims, output_dims, offsets, input_dims);
+}
+
+void Pad::init(FFModel const &ff) {
+  assert(check_output_input_weight_same_parallel_is());
+  parallel_is = outputs[0]->parallel_is;
+  ArgumentMap argmap;
+  Context ctx = ff.config.lg_ctx;
+  Runtime *runtime = ff.config.lg_hlr;
+  set_argumentmap_for_init(ff, argmap);
+  IndexLauncher launcher(PAD_INIT_TASK_ID,
+                         parallel_is,
+                         TaskArgument(this, sizeof(Pad)),
+                         argmap,
+                         Predicate::TRUE_PRED,
+                         false /*must*/,
+                         0 /*mapper_id*/,
+                         outputs[0]->machine_view.hash());
+  launcher.add_region_requirement(RegionRequirement(inputs[0]->part,
+                                                    0 /*projection id*/,
+                                                    READ_ONLY,
+                                                    EXCLUSIVE,
+                                                    inputs[0]->region));
+  launcher.add_field(0, FID_DATA);
+  launcher.add_region_requirement(RegionRequirement(outputs[0]->part,
+                                                    0 /*projection id*/,
+                                                    WRITE_ONLY,
+                                                    EXCLUSIVE,
+                                                    outputs[0]->region));
+  launcher.add_field(1, FID_DATA);
+  FutureMap fm = runtime->execute_index_space(ctx, launcher);
+  fm.wait_all_results();
+  set_opmeta_from_futuremap(ff, fm);
+}
+
+/*
+  regions[0](I): input
+  regions[1](O): output
+*/
+OpMeta *Pad::init_task(Task const *task,
+                       std::vector<PhysicalRegion> const &regions,
+                       Context ctx,
+                       Runtime *runtime) {
+  Pad const *pad = (Pad const *)task->args;
+  FFHandler handle = *((FFHandler const *)task->local_args);
+  assert(regions.size() == 2);
+  assert(task->regions.size() == 2);
+  PadMeta *m = new PadMeta(handle, pad);
+  m->profiling = pad->profiling;
+  return m;
+}
+
+void Pad::forward(FFModel const &ff) {
+  ArgumentMap argmap;
+  Context ctx = ff.config.lg_ctx;
+  Runtime *runtime = ff.config.lg_hlr;
+  set_argumentmap_for_forward(ff, argmap);
+  IndexLauncher launcher(PAD_FWD_TASK_ID,
+                         parallel_is,
+                         TaskArgument(NULL, 0),
+                         argmap,
+                         Predicate::TRUE_PRED,
+                         false /*must*/,
+                         0 /*mapper_id*/,
+                         outputs[0]->machine_view.hash());
+  launcher.add_region_requirement(RegionRequirement(inputs[0]->part,
+                                                    0 /*projection id*/,
+                                                    READ_ONLY,
+                                                    EXCLUSIVE,
+                                                    inputs[0]->region));
+  launcher.add_field(0, FID_DATA);
+  launcher.add_region_requirement(RegionRequirement(outputs[0]->part,
+                                                    0 /*projection id*/,
+                                                    WRITE_ONLY,
+                                                    EXCLUSIVE,
+                                                    outputs[0]->region));
+  launcher.add_field(1, FID_DATA);
+  runtime->execute_index_space(ctx, launcher);
+}
+
+/*
+  regions[0](I): input
+  regions[1](O): output
+*/
+void Pad::forward_task(Task const *task,
+                       std::vector<PhysicalRegion> const &regions,
+                       Context ctx,
+                       Runtime *runtime) {
+  assert(regions.size() == 2);
+  assert(task->regions.size() == 2);
+  PadMeta const *m = *((PadMeta **)task->local_args);
+  GenericTensorAccessorR input = helperGetGenericTensorAccessorRO(
+      DT_FLOAT, regions[0], task->regions[0], FID_DATA, ctx, runtime);
+  GenericTensorAccessorW output = helperGetGenericTensorAccessorWO(
+      DT_FLOAT, regions[1], task->regions[1], FID_DATA, ctx, runtime);
+  forward_kernel_wrapper(m, input, output);
+}
+
+void Pad::backward(FFModel const &ff) {
+  ArgumentMap argmap;
+  Context ctx = ff.config.lg_ctx;
+  Runtime *runtime = ff.config.lg_hlr;
+  set_argumentmap_for_backward(ff, argmap);
+  IndexLauncher launcher(PAD_BWD_TASK_ID,
+                         parallel_is,
+                         TaskArgument(NULL, 0),
+                         argmap,
+                         Predicate::TRUE_PRED,
+                         false /*must*/,
+                         0 /*mapper_id*/,
+                         outputs[0]->machine_view.hash());
+  launcher.add_region_requirement(RegionRequirement(outputs[0]->part_grad,
+                                                    0 /*projection id*/,
+                                                    READ_ONLY,
+                                                    EXCLUSIVE,
+                                                    outputs[0]->region_grad));
+  launcher.add_field(0, FID_DATA);
+  launcher.add_region_requirement(RegionRequirement(inputs[0]->part_grad,
+                                                    0 /*projection id*/,
+                                                    READ_WRITE,
+                                                    EXCLUSIVE,
+                                                    inputs[0]->region_grad));
+  launcher.add_field(1, FID_DATA);
+  runtime->execute_index_space(ctx, launcher);
+}
+
+/*
+  regions[0](I): output_grad
+  regions[1](I/O): input_grad
+*/
+void Pad::backward_task(Task const *task,
+                        std::vector<PhysicalRegion> const &regions,
+                        Context ctx,
+                        Runtime *runtime) {
+  assert(regions.size() == 2);
+  assert(task->regions.size() == 2);
+  PadMeta const *m = *((PadMeta **)task->local_args);
+  GenericTensorAccessorR output_grad = helperGetGenericTensorAccessorRO(
+      DT_FLOAT, regions[0], task->regions[0], FID_DATA, ctx, runtime);
+  GenericTensorAccessorW input_grad = helperGetGenericTensorAccessorRW(
+      DT_FLOAT, regions[1], task->regions[1], FID_DATA, ctx, runtime);
+  backward_kernel_wrapper(m, output_grad, input_grad);
+}
+
+bool Pad::measure_operator_cost(Simulator *sim,
+                                MachineView const &mv,
+                                CostMetrics &cost_metrics) const {
+  ParallelTensorBase sub_input, sub_output;
+  if (!outputs[0]->get_sub_tensor(mv, sub_output)) {
+    return false;
+  }
+  if (!inputs[0]->get_sub_tensor(mv, sub_input)) {
+    return false;
+  }
+
+  PadMeta *m = new PadMeta(sim->handler, this);
+  sim->free_all();
+  Domain in_domain = sub_input.get_domain();
+  Domain out_domain = sub_output.get_domain();
+  float *input_ptr = (float *)sim->allocate(sub_input.get_volume(), DT_FLOAT);
+  GenericTensorAccessorR input_acc(DT_FLOAT, in_domain, input_ptr);
+  cost_metrics.inputs_memory += cost_metrics.total_mem_diff_from(sim->offset);
+  float *output_ptr = (float *)sim->allocate(sub_output.get_volume(), DT_FLOAT);
+  GenericTensorAccessorW output_acc(DT_FLOAT, out_domain, output_ptr);
+  cost_metrics.outputs_memory += cost_metrics.total_mem_diff_from(sim->offset);
+  bool out_of_memory = (input_ptr == NULL) || (output_ptr == NULL);
+  if (out_of_memory) {
+    cost_metrics.forward_time = Simulator::MAXIMUM_TASK_RUN_TIME;
+    cost_metrics.backward_time = Simulator::MAXIMUM_TASK_RUN_TIME;
+    delete m;
+    return true;
+  }
+
+  std::function<void()> forward, backward;
+  forward = [&] { forward_kernel_wrapper(m, input_acc, output_acc); };
+  if (sim->computationMode == COMP_MODE_TRAINING) {
+    float *input_grad_ptr =
+        (float *)sim->allocate(sub_input.get_volume(), DT_FLOAT);
+    GenericTensorAccessorW input_grad_acc(DT_FLOAT, in_domain, input_grad_ptr);
+    cost_metrics.inputs_memory += cost_metrics.total_mem_diff_from(sim->offset);
+    float *output_grad_ptr =
+        (float *)sim->allocate(sub_output.get_volume(), DT_FLOAT);
+    GenericTensorAccessorR output_grad_acc(
+        DT_FLOAT, out_domain, output_grad_ptr);
+    cost_metrics.outputs_memory +=
+        cost_metrics.total_mem_diff_from(sim->offset);
+    out_of_memory = (input_grad_ptr == NULL) || (output_grad_ptr == NULL);
+    if (out_of_memory) {
+      cost_metrics.forward_time = Simulator::MAXIMUM_TASK_RUN_TIME;
+      cost_metrics.backward_time = Simulator::MAXIMUM_TASK_RUN_TIME;
+      delete m;
+      return true;
+    }
+    backward = [&] {
+      backward_kernel_wrapper(m, output_grad_acc, input_grad_acc);
+    };
+  }
+
+  inner_measure_operator_cost(sim, forward, backward, cost_metrics);
+
+  if (sim->computationMode == COMP_MODE_TRAINING) {
+    printf("[Measure Pad] name(%s) input_volume(%zu) output_volume(%zu) "
+           "forward_time(%.4lf) backward_time(%.4lf)\n",
+           name,
+           in_domain.get_volume(),
+           out_domain.get_volume(),
+           cost_metrics.forward_time,
+           cost_metrics.backward_time);
+  } else {
+    printf("[Measure Pad] name(%s) input_volume(%zu) output_volume(%zu) "
+           "forward_time(%.4lf)\n",
+           name,
+           in_domain.get_volume(),
+           out_domain.get_volume(),
+           cost_metrics.forward_time);
+  }
+  delete m;
+  return true;
+}
+
+}; // namespace FlexFlow
+
+namespace std {
+size_t hash<FlexFlow::PadParams>::operator()(
+    FlexFlow::PadParams const &params) const {
+  size_t key = 0;
+  hash_combine(key, params.pads_before.size());
+  for (size_t i = 0; i < params.pads_before.size(); i++) {
+    hash_combine(key, params.pads_before[i]);
+    hash_combine(key, params.pads_after[i]);
+  }
+  hash_combine(key, params.value);
+  return key;
+}
+}; // namespace std
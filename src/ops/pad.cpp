@@ -0,0 +1,142 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flexflow/ops/pad.h"
+#include "flexflow/utils/hip_helper.h"
+#include <hip/hip_runtime.h>
+
+namespace FlexFlow {
+
+// declare Legion names
+using Legion::coord_t;
+
+namespace {
+
+__global__ void pad_forward_kernel(TensorWindow window,
+                                   float const *input,
+                                   float *output,
+                                   coord_t volume) {
+  CUDA_KERNEL_LOOP(idx, volume) {
+    output[window.offset(idx)] = input[idx];
+  }
+}
+
+__global__ void pad_backward_kernel(TensorWindow window,
+                                    float const *output_grad,
+                                    float *input_grad,
+                                    coord_t volume) {
+  CUDA_KERNEL_LOOP(idx, volume) {
+    input_grad[idx] += output_grad[window.offset(idx)];
+  }
+}
+
+} // namespace
+
+/*static*/
+void Pad::forward_kernel_wrapper(PadMeta const *m,
+                                 GenericTensorAccessorR const &input,
+                                 GenericTensorAccessorW const &output) {
+  hipStream_t stream;
+  checkCUDA(get_legion_stream(&stream));
+  hipEvent_t t_start, t_end;
+  if (m->profiling) {
+    hipEventCreate(&t_start);
+    hipEventCreate(&t_end);
+    hipEventRecord(t_start, stream);
+  }
+  TensorWindow window;
+  size_t origin = get_window(m, input.domain, output.domain, window);
+  coord_t output_volume = output.domain.get_volume();
+  if (m->value == 0.0f) {
+    checkCUDA(hipMemsetAsync(
+        output.get_float_ptr(), 0, output_volume * sizeof(float), stream));
+  } else {
+    hipLaunchKernelGGL(assign_kernel<float>,
+                       GET_BLOCKS(output_volume),
+                       CUDA_NUM_THREADS,
+                       0,
+                       stream,
+                       output.get_float_ptr(),
+                       output_volume,
+                       m->value);
+  }
+  coord_t volume = window.volume();
+  hipLaunchKernelGGL(pad_forward_kernel,
+                     GET_BLOCKS(volume),
+                     CUDA_NUM_THREADS,
+                     0,
+                     stream,
+                     window,
+                     input.get_float_ptr(),
+                     output.get_float_ptr() + origin,
+                     volume);
+  if (m->profiling) {
+    hipEventRecord(t_end, stream);
+    checkCUDA(hipEventSynchronize(t_end));
+    float elapsed = 0;
+    checkCUDA(hipEventElapsedTime(&elapsed, t_start, t_end));
+    hipEventDestroy(t_start);
+    hipEventDestroy(t_end);
+    printf("[%s] forward time = %.2lfms\n", m->op_name, elapsed);
+  }
+}
+
+/*static*/
+void Pad::backward_kernel_wrapper(PadMeta const *m,
+                                  GenericTensorAccessorR const &output_grad,
+                                  GenericTensorAccessorW const &input_grad) {
+  hipStream_t stream;
+  checkCUDA(get_legion_stream(&stream));
+  hipEvent_t t_start, t_end;
+  if (m->profiling) {
+    hipEventCreate(&t_start);
+    hipEventCreate(&t_end);
+    hipEventRecord(t_start, stream);
+  }
+  TensorWindow window;
+  size_t origin =
+      get_window(m, input_grad.domain, output_grad.domain, window);
+  coord_t volume = window.volume();
+  hipLaunchKernelGGL(pad_backward_kernel,
+                     GET_BLOCKS(volume),
+                     CUDA_NUM_THREADS,
+                     0,
+                     stream,
+                     window,
+                     output_grad.get_float_ptr() + origin,
+                     input_grad.get_float_ptr(),
+                     volume);
+  if (m->profiling) {
+    hipEventRecord(t_end, stream);
+    checkCUDA(hipEventSynchronize(t_end));
+    float elapsed = 0;
+    checkCUDA(hipEventElapsedTime(&elapsed, t_start, t_end));
+    hipEventDestroy(t_start);
+    hipEventDestroy(t_end);
+    printf("[%s] backward time = %.2lfms\n", m->op_name, elapsed);
+  }
+}
+
+PadMeta::PadMeta(FFHandler handler, Pad const *pad) : OpMeta(handler, pad) {
+  num_dims = pad->pads_before.size();
+  assert(num_dims <= MAX_TENSOR_DIM);
+  for (int i = 0; i < num_dims; i++) {
+    pads_before[i] = pad->pads_before[i];
+  }
+  value = pad->value;
+  std::strcpy(op_name, pad->name);
+}
+
+}; // namespace FlexFlow
@@ -0,0 +1,524 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flexflow/ops/slice.h"
+#include "flexflow/utils/hash_utils.h"
+#include "legion/legion_utilities.h"
+
+namespace FlexFlow {
+
+// declare Legion names
+using Legion::ArgumentMap;
+using Legion::Context;
+using Legion::coord_t;
+using Legion::Domain;
+using Legion::FutureMap;
+using Legion::IndexLauncher;
+using Legion::LogicalPartition;
+using Legion::LogicalRegion;
+using Legion::PhysicalRegion;
+using Legion::Predicate;
+using Legion::Rect;
+using Legion::RegionRequirement;
+using Legion::Runtime;
+using Legion::Task;
+using Legion::TaskArgument;
+using Legion::TaskLauncher;
+using PCG::Node;
+
+bool operator==(SliceParams const &lhs, SliceParams const &rhs) {
+  return lhs.starts == rhs.starts && lhs.ends == rhs.ends;
+}
+
+bool SliceParams::is_valid(ParallelTensorShape const &input) const {
+  if (!input.is_valid()) {
+    return false;
+  }
+  if (starts.size() != ends.size() || (int)starts.size() > input.num_dims) {
+    return false;
+  }
+  for (size_t i = 0; i < starts.size(); i++) {
+    if (starts[i] < 0 || starts[i] >= ends[i] ||
+        ends[i] > input.dims[i].size) {
+      return false;
+    }
+    // Each task reads an equal share of the window
+    if ((ends[i] - starts[i]) % input.dims[i].degree != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+SliceParams Slice::get_params() const {
+  SliceParams params;
+  params.starts = this->starts;
+  params.ends = this->ends;
+  return params;
+}
+
+Tensor FFModel::slice(const Tensor input,
+                      std::vector<int> const &_starts,
+                      std::vector<int> const &_ends,
+                      char const *name) {
+  assert(_starts.size() == _ends.size());
+  assert((int)_starts.size() <= input->num_dims);
+  int numdim = input->num_dims;
+  // Use Legion indexing to store the window; negative indices count from
+  // the end of the dimension
+  std::vector<int> starts(numdim), ends(numdim);
+  int dims[MAX_TENSOR_DIM];
+  bool identity = true;
+  for (int i = 0; i < numdim; i++) {
+    int size = input->dims[i];
+    int c_dim = numdim - 1 - i;
+    int start = 0, end = size;
+    if (c_dim < (int)_starts.size()) {
+      start = _starts[c_dim] < 0 ? _starts[c_dim] + size : _starts[c_dim];
+      end = _ends[c_dim] < 0 ? _ends[c_dim] + size : _ends[c_dim];
+      start = std::min(std::max(start, 0), size);
+      end = std::min(std::max(end, 0), size);
+    }
+    assert(start < end && "Empty slices are not supported");
+    starts[i] = start;
+    ends[i] = end;
+    dims[i] = end - start;
+    identity = identity && dims[i] == size;
+  }
+  if (identity) {
+    return input;
+  }
+  Layer *slice = new Layer(this,
+                           OP_SLICE,
+                           DT_FLOAT,
+                           name,
+                           1 /*inputs*/,
+                           0 /*weights*/,
+                           1 /*outputs*/,
+                           input);
+  slice->outputs[0] = create_tensor_legion_ordering(
+      numdim, dims, input->data_type, slice, 0, true /*create_grad*/);
+  slice->add_int_vector_property("starts", starts);
+  slice->add_int_vector_property("ends", ends);
+  layers.push_back(slice);
+  return slice->outputs[0];
+}
+
+Op *Slice::create_operator_from_layer(
+    FFModel &model,
+    Layer const *layer,
+    std::vector<ParallelTensor> const &inputs) {
+  std::vector<int> starts, ends;
+  layer->get_int_vector_property("starts", starts);
+  layer->get_int_vector_property("ends", ends);
+  return new Slice(model, inputs[0], starts, ends, layer->name);
+}
+
+Slice::Slice(FFModel &model,
+             SliceParams const &params,
+             const ParallelTensor input,
+             char const *name)
+    : Slice(model, input, params.starts, params.ends, name) {}
+
+Slice::Slice(FFModel &model,
+             const ParallelTensor input,
+             std::vector<int> const &_starts,
+             std::vector<int> const &_ends,
+             char const *name)
+    : Op(model,
+         OP_SLICE,
+         input->data_type,
+         name,
+         1 /*inputs*/,
+         0 /*weights*/,
+         1 /*outputs*/,
+         input),
+      starts(_starts), ends(_ends) {
+  assert(get_params().is_valid(input->get_shape()));
+  assert(input->data_type == DT_FLOAT);
+  int num_dim = input->num_dims;
+  ParallelDim dims[MAX_TENSOR_DIM];
+  for (int i = 0; i < num_dim; i++) {
+    dims[i] = input->dims[i];
+  }
+  for (size_t i = 0; i < starts.size(); i++) {
+    dims[i].size = ends[i] - starts[i];
+  }
+  numOutputs = 1;
+  outputs[0] = model.create_parallel_tensor_legion_ordering(
+      num_dim, dims, input->data_type, this);
+}
+
+void Slice::map_output_tensors(FFModel &ff) {
+  Op::map_output_tensors(ff);
+  // The windows of the input matching the pieces of the output; the other
+  // dims start at zero
+  int offsets[MAX_TENSOR_DIM];
+  for (int i = 0; i < outputs[0]->num_dims; i++) {
+    offsets[i] = i < (int)starts.size() ? starts[i] : 0;
+  }
+  ff.create_window_partition(outputs[0]->num_dims,
+                             outputs[0]->dims,
+                             offsets,
+                             outputs[0]->parallel_is,
+                             inputs[0]->region,
+                             input_lp);
+  if (inputs[0]->region_grad != LogicalRegion::NO_REGION) {
+    ff.create_window_partition(outputs[0]->num_dims,
+                               outputs[0]->dims,
+                               offsets,
+                               outputs[0]->parallel_is,
+                               inputs[0]->region_grad,
+                               input_grad_lp);
+  }
+}
+
+void Slice::serialize(Legion::Serializer &sez) const {
+  sez.serialize(starts.size());
+  for (size_t i = 0; i < starts.size(); i++) {
+    sez.serialize(starts[i]);
+    sez.serialize(ends[i]);
+  }
+}
+
+/*static*/
+Node Slice::deserialize(FFModel &ff,
+                        Legion::Deserializer &dez,
+                        ParallelTensor inputs[],
+                        int num_inputs) {
+  assert(num_inputs == 1);
+  size_t num_dims;
+  dez.deserialize(num_dims);
+  SliceParams params;
+  params.starts.resize(num_dims);
+  params.ends.resize(num_dims);
+  for (size_t i = 0; i < num_dims; i++) {
+    dez.deserialize(params.starts[i]);
+    dez.deserialize(params.ends[i]);
+  }
+  return ff.get_or_create_node<Slice>(inputs[0], params);
+}
+
+Op *Slice::materialize(FFModel &ff,
+                       ParallelTensor inputs[],
+                       int num_inputs) const {
+  assert(num_inputs == 1);
+  return new Slice(ff, inputs[0], this->starts, this->ends, this->name);
+}
+
+namespace {
+
+template <int NDIM>
+void set_window(Realm::AffineAccessor<float, NDIM, coord_t> const &acc,
+                Rect<NDIM> const &rect,
+                TensorWindow &window) {
+  window.num_dims = NDIM;
+  for (int d = 0; d < NDIM; d++) {
+    window.dims[d] = rect.hi[d] - rect.lo[d] + 1;
+    window.strides[d] = acc.strides[d] / sizeof(float);
+  }
+}
+
+// The window is a sub-region of the input, so it keeps the strides of the
+// instance of the whole input
+float const *get_window_ro(PhysicalRegion const &region,
+                           RegionRequirement const &req,
+                           Context ctx,
+                           Runtime *runtime,
+                           TensorWindow &window) {
+  Domain domain =
+      runtime->get_index_space_domain(ctx, req.region.get_index_space());
+  switch (domain.get_dim()) {
+#define DIMFUNC(DIM)                                                           \
+  case DIM: {                                                                  \
+    AccessorRO<float, DIM> const acc(region, FID_DATA);                        \
+    Rect<DIM> rect = domain;                                                   \
+    set_window<DIM>(acc.accessor, rect, window);                               \
+    return acc.ptr(rect.lo);                                                   \
+  }
+    LEGION_FOREACH_N(DIMFUNC)
+#undef DIMFUNC
+    default:
+      assert(false && "Unsupported number of dims");
+  }
+  return nullptr;
+}
+
+float *get_window_rw(PhysicalRegion const &region,
+                     RegionRequirement const &req,
+                     Context ctx,
+                     Runtime *runtime,
+                     TensorWindow &window) {
+  Domain domain =
+      runtime->get_index_space_domain(ctx, req.region.get_index_space());
+  switch (domain.get_dim()) {
+#define DIMFUNC(DIM)                                                           \
+  case DIM: {                                                                  \
+    AccessorRW<float, DIM> const acc(region, FID_DATA);                        \
+    Rect<DIM> rect = domain;                                                   \
+    set_window<DIM>(acc.accessor, rect, window);                               \
+    return acc.ptr(rect.lo);                                                   \
+  }
+    LEGION_FOREACH_N(DIMFUNC)
+#undef DIMFUNC
+    default:
+      assert(false && "Unsupported number of dims");
+  }
+  return nullptr;
+}
+
+} // namespace
+
+void Slice::init(FFModel const &ff) {
+  assert(check_output_input_weight_same_parallel_is());
+  parallel_is = outputs[0]->parallel_is;
+  ArgumentMap argmap;
+  Context ctx = ff.config.lg_ctx;
+  Runtime *runtime = ff.config.lg_hlr;
+  set_argumentmap_for_init(ff, argmap);
+  IndexLauncher launcher(SLICE_INIT_TASK_ID,
+                         parallel_is,
+                         TaskArgument(this, sizeof(Slice)),
+                         argmap,
+                         Predicate::TRUE_PRED,
+                         false /*must*/,
+                         0 /*mapper_id*/,
+                         outputs[0]->machine_view.hash());
+  launcher.add_region_requirement(RegionRequirement(input_lp,
+                                                    0 /*projection id*/,
+                                                    READ_ONLY,
+                                                    EXCLUSIVE,
+                                                    inputs[0]->region));
+  launcher.add_field(0, FID_DATA);
+  launcher.add_region_requirement(RegionRequirement(outputs[0]->part,
+                                                    0 /*projection id*/,
+                                                    WRITE_ONLY,
+                                                    EXCLUSIVE,
+                                                    outputs[0]->region));
+  launcher.add_field(1, FID_DATA);
+  FutureMap fm = runtime->execute_index_space(ctx, launcher);
+  fm.wait_all_results();
+  set_opmeta_from_futuremap(ff, fm);
+}
+
+/*
+  regions[0](I): input window
+  regions[1](O): output
+*/
+OpMeta *Slice::init_task(Task const *task,
+                         std::vector<PhysicalRegion> const &regions,
+                         Context ctx,
+                         Runtime *runtime) {
+  Slice const *slice = (Slice const *)task->args;
+  FFHandler handle = *((FFHandler const *)task->local_args);
+  assert(regions.size() == 2);
+  assert(task->regions.size() == 2);
+  SliceMeta *m = new SliceMeta(handle, slice);
+  m->profiling = slice->profiling;
+  return m;
+}
+
+void Slice::forward(FFModel const &ff) {
+  ArgumentMap argmap;
+  Context ctx = ff.config.lg_ctx;
+  Runtime *runtime = ff.config.lg_hlr;
+  set_argumentmap_for_forward(ff, argmap);
+  IndexLauncher launcher(SLICE_FWD_TASK_ID,
+                         parallel_is,
+                         TaskArgument(NULL, 0),
+                         argmap,
+                         Predicate::TRUE_PRED,
+                         false /*must*/,
+                         0 /*mapper_id*/,
+                         outputs[0]->machine_view.hash());
+  launcher.add_region_requirement(RegionRequirement(input_lp,
+                                                    0 /*projection id*/,
+                                                    READ_ONLY,
+                                                    EXCLUSIVE,
+                                                    inputs[0]->region));
+  launcher.add_field(0, FID_DATA);
+  launcher.add_region_requirement(RegionRequirement(outputs[0]->part,
+                                                    0 /*projection id*/,
+                                                    WRITE_ONLY,
+                                                    EXCLUSIVE,
+                                                    outputs[0]->region));
+  launcher.add_field(1, FID_DATA);
+  runtime->execute_index_space(ctx, launcher);
+}
+
+/*
+  regions[0](I): input window
+  regions[1](O): output
+*/
+void Slice::forward_task(Task const *task,
+                         std::vector<PhysicalRegion> const &regions,
+                         Context ctx,
+                         Runtime *runtime) {
+  assert(regions.size() == 2);
+  assert(task->regions.size() == 2);
+  SliceMeta const *m = *((SliceMeta **)task->local_args);
+  TensorWindow window;
+  float const *input =
+      get_window_ro(regions[0], task->regions[0], ctx, runtime, window);
+  GenericTensorAccessorW output = helperGetGenericTensorAccessorWO(
+      DT_FLOAT, regions[1], task->regions[1], FID_DATA, ctx, runtime);
+  assert(output.domain.get_volume() == window.volume());
+  forward_kernel_wrapper(m, window, input, output.get_float_ptr());
+}
+
+void Slice::backward(FFModel const &ff) {
+  ArgumentMap argmap;
+  Context ctx = ff.config.lg_ctx;
+  Runtime *runtime = ff.config.lg_hlr;
+  set_argumentmap_for_backward(ff, argmap);
+  IndexLauncher launcher(SLICE_BWD_TASK_ID,
+                         parallel_is,
+                         TaskArgument(NULL, 0),
+                         argmap,
+                         Predicate::TRUE_PRED,
+                         false /*must*/,
+                         0 /*mapper_id*/,
+                         outputs[0]->machine_view.hash());
+  launcher.add_region_requirement(RegionRequirement(outputs[0]->part_grad,
+                                                    0 /*projection id*/,
+                                                    READ_ONLY,
+                                                    EXCLUSIVE,
+                                                    outputs[0]->region_grad));
+  launcher.add_field(0, FID_DATA);
+  launcher.add_region_requirement(RegionRequirement(input_grad_lp,
+                                                    0 /*projection id*/,
+                                                    READ_WRITE,
+                                                    EXCLUSIVE,
+                                                    inputs[0]->region_grad));
+  launcher.add_field(1, FID_DATA);
+  runtime->execute_index_space(ctx, launcher);
+}
+
+/*
+  regions[0](I): output_grad
+  regions[1](I/O): input_grad window
+*/
+void Slice::backward_task(Task const *task,
+                          std::vector<PhysicalRegion> const &regions,
+                          Context ctx,
+                          Runtime *runtime) {
+  assert(regions.size() == 2);
+  assert(task->regions.size() == 2);
+  SliceMeta const *m = *((SliceMeta **)task->local_args);
+  GenericTensorAccessorR output_grad = helperGetGenericTensorAccessorRO(
+      DT_FLOAT, regions[0], task->regions[0], FID_DATA, ctx, runtime);
+  TensorWindow window;
+  float *input_grad =
+      get_window_rw(regions[1], task->regions[1], ctx, runtime, window);
+  assert(output_grad.domain.get_volume() == window.volume());
+  backward_kernel_wrapper(m, window, output_grad.get_float_ptr(), input_grad);
+}
+
+bool Slice::measure_operator_cost(Simulator *sim,
+                                  MachineView const &mv,
+                                  CostMetrics &cost_metrics) const {
+  ParallelTensorBase sub_input, sub_output;
+  if (!outputs[0]->get_sub_tensor(mv, sub_output)) {
+    return false;
+  }
+  if (!inputs[0]->get_sub_tensor(mv, sub_input)) {
+    return false;
+  }
+  // A window of the size of the output piece in an input piece
+  Domain in_domain = sub_input.get_domain();
+  Domain out_domain = sub_output.get_domain();
+  int num_dims = in_domain.get_dim();
+  int in_dims[MAX_TENSOR_DIM], out_dims[MAX_TENSOR_DIM],
+      offsets[MAX_TENSOR_DIM];
+  for (int d = 0; d < num_dims; d++) {
+    in_dims[d] = in_domain.hi()[d] - in_domain.lo()[d] + 1;
+    out_dims[d] = out_domain.hi()[d] - out_domain.lo()[d] + 1;
+    offsets[d] = 0;
+  }
+  TensorWindow window;
+  window.set_dense(num_dims, in_dims, offsets, out_dims);
+
+  SliceMeta *m = new SliceMeta(sim->handler, this);
+  sim->free_all();
+  float *input_ptr = (float *)sim->allocate(sub_input.get_volume(), DT_FLOAT);
+  cost_metrics.inputs_memory += cost_metrics.total_mem_diff_from(sim->offset);
+  float *output_ptr = (float *)sim->allocate(sub_output.get_volume(), DT_FLOAT);
+  cost_metrics.outputs_memory += cost_metrics.total_mem_diff_from(sim->offset);
+  bool out_of_memory = (input_ptr == NULL) || (output_ptr == NULL);
+  if (out_of_memory) {
+    cost_metrics.forward_time = Simulator::MAXIMUM_TASK_RUN_TIME;
+    cost_metrics.backward_time = Simulator::MAXIMUM_TASK_RUN_TIME;
+    delete m;
+    return true;
+  }
+
+  std::function<void()> forward, backward;
+  forward = [&] { forward_kernel_wrapper(m, window, input_ptr, output_ptr); };
+  if (sim->computationMode == COMP_MODE_TRAINING) {
+    float *input_grad_ptr =
+        (float *)sim->allocate(sub_input.get_volume(), DT_FLOAT);
+    cost_metrics.inputs_memory += cost_metrics.total_mem_diff_from(sim->offset);
+    float *output_grad_ptr =
+        (float *)sim->allocate(sub_output.get_volume(), DT_FLOAT);
+    cost_metrics.outputs_memory +=
+        cost_metrics.total_mem_diff_from(sim->offset);
+    out_of_memory = (input_grad_ptr == NULL) || (output_grad_ptr == NULL);
+    if (out_of_memory) {
+      cost_metrics.forward_time = Simulator::MAXIMUM_TASK_RUN_TIME;
+      cost_metrics.backward_time = Simulator::MAXIMUM_TASK_RUN_TIME;
+      delete m;
+      return true;
+    }
+    backward = [&] {
+      backward_kernel_wrapper(m, window, output_grad_ptr, input_grad_ptr);
+    };
+  }
+
+  inner_measure_operator_cost(sim, forward, backward, cost_metrics);
+
+  if (sim->computationMode == COMP_MODE_TRAINING) {
+    printf("[Measure Slice] name(%s) volume(%zu) contiguous(%d) "
+           "forward_time(%.4lf) backward_time(%.4lf)\n",
+           name,
+           window.volume(),
+           window.is_contiguous(),
+           cost_metrics.forward_time,
+           cost_metrics.backward_time);
+  } else {
+    printf("[Measure Slice] name(%s) volume(%zu) contiguous(%d) "
+           "forward_time(%.4lf)\n",
+           name,
+           window.volume(),
+           window.is_contiguous(),
+           cost_metrics.forward_time);
+  }
+  delete m;
+  return true;
+}
+
+}; // namespace FlexFlow
+
+namespace std {
+size_t hash<FlexFlow::SliceParams>::operator()(
+    FlexFlow::SliceParams const &params) const {
+  size_t key = 0;
+  hash_combine(key, params.starts.size());
+  for (size_t i = 0; i < params.starts.size(); i++) {
+    hash_combine(key, params.starts[i]);
+    hash_combine(key, params.ends[i]);
+  }
+  return key;
+}
+}; // namespace std
@@ -0,0 +1,129 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flexflow/ops/slice.h"
+#include "flexflow/utils/hip_helper.h"
+#include <hip/hip_runtime.h>
+
+namespace FlexFlow {
+
+// declare Legion names
+using Legion::coord_t;
+
+namespace {
+
+__global__ void slice_forward_kernel(TensorWindow window,
+                                     float const *input,
+                                     float *output,
+                                     coord_t volume) {
+  CUDA_KERNEL_LOOP(idx, volume) {
+    output[idx] = input[window.offset(idx)];
+  }
+}
+
+__global__ void slice_backward_kernel(TensorWindow window,
+                                      float const *output_grad,
+                                      float *input_grad,
+                                      coord_t volume) {
+  CUDA_KERNEL_LOOP(idx, volume) {
+    input_grad[window.offset(idx)] += output_grad[idx];
+  }
+}
+
+} // namespace
+
+/*static*/
+void Slice::forward_kernel_wrapper(SliceMeta const *m,
+                                   TensorWindow const &window,
+                                   float const *input,
+                                   float *output) {
+  hipStream_t stream;
+  checkCUDA(get_legion_stream(&stream));
+  hipEvent_t t_start, t_end;
+  if (m->profiling) {
+    hipEventCreate(&t_start);
+    hipEventCreate(&t_end);
+    hipEventRecord(t_start, stream);
+  }
+  coord_t volume = window.volume();
+  if (window.is_contiguous()) {
+    checkCUDA(hipMemcpyAsync(output,
+                             input,
+                             volume * sizeof(float),
+                             hipMemcpyDeviceToDevice,
+                             stream));
+  } else {
+    hipLaunchKernelGGL(slice_forward_kernel,
+                       GET_BLOCKS(volume),
+                       CUDA_NUM_THREADS,
+                       0,
+                       stream,
+                       window,
+                       input,
+                       output,
+                       volume);
+  }
+  if (m->profiling) {
+    hipEventRecord(t_end, stream);
+    checkCUDA(hipEventSynchronize(t_end));
+    float elapsed = 0;
+    checkCUDA(hipEventElapsedTime(&elapsed, t_start, t_end));
+    hipEventDestroy(t_start);
+    hipEventDestroy(t_end);
+    printf("[%s] forward time = %.2lfms\n", m->op_name, elapsed);
+  }
+}
+
+/*static*/
+void Slice::backward_kernel_wrapper(SliceMeta const *m,
+                                    TensorWindow const &window,
+                                    float const *output_grad,
+                                    float *input_grad) {
+  hipStream_t stream;
+  checkCUDA(get_legion_stream(&stream));
+  hipEvent_t t_start, t_end;
+  if (m->profiling) {
+    hipEventCreate(&t_start);
+    hipEventCreate(&t_end);
+    hipEventRecord(t_start, stream);
+  }
+  coord_t volume = window.volume();
+  // The elements of the window are distinct, so no atomics are needed
+  hipLaunchKernelGGL(slice_backward_kernel,
+                     GET_BLOCKS(volume),
+                     CUDA_NUM_THREADS,
+                     0,
+                     stream,
+                     window,
+                     output_grad,
+                     input_grad,
+                     volume);
+  if (m->profiling) {
+    hipEventRecord(t_end, stream);
+    checkCUDA(hipEventSynchronize(t_end));
+    float elapsed = 0;
+    checkCUDA(hipEventElapsedTime(&elapsed, t_start, t_end));
+    hipEventDestroy(t_start);
+    hipEventDestroy(t_end);
+    printf("[%s] backward time = %.2lfms\n", m->op_name, elapsed);
+  }
+}
+
+SliceMeta::SliceMeta(FFHandler handler, Slice const *slice)
+    : OpMeta(handler, slice) {
+  std::strcpy(op_name, slice->name);
+}
+
+}; // namespace FlexFlow
@@ -104,6 +104,9 @@ OpMeta *Repartition::init_task(Task const *task,
 void Repartition::init(FFModel const &ff) {
   ArgumentMap argmap;
   parallel_is = outputs[0]->parallel_is;
+  if (output_aliased) {
+    return;
+  }
   Context ctx = ff.config.lg_ctx;
   Runtime *runtime = ff.config.lg_hlr;
   assert(numOutputs == 1);
@@ -129,6 +132,12 @@ void Repartition::init(FFModel const &ff) {
   fm.wait_all_results();
 }
 
+void Repartition::map_output_tensors(FFModel &ff) {
+  if (!alias_output_to_input(ff)) {
+    Op::map_output_tensors(ff);
+  }
+}
+
 void Repartition::create_input_partition(FFModel &ff) {
   assert(outputs[0]->part != LogicalPartition::NO_PART);
   assert(inputs[0]->part != LogicalPartition::NO_PART);
@@ -145,6 +154,11 @@ void Repartition::create_input_partition(FFModel &ff) {
 }
 
 void Repartition::forward(FFModel const &ff) {
+  // The output is a partition of the input region: Legion copies the pieces
+  // that consumers map on another device
+  if (output_aliased) {
+    return;
+  }
   ArgumentMap argmap;
   Context ctx = ff.config.lg_ctx;
   Runtime *runtime = ff.config.lg_hlr;
@@ -173,6 +187,10 @@ void Repartition::forward(FFModel const &ff) {
 }
 
 void Repartition::backward(FFModel const &ff) {
+  // Consumers accumulate directly into the input gradients
+  if (output_aliased) {
+    return;
+  }
   // skip backpropagation for input
   if (inputs[0]->owner_op != nullptr &&
       inputs[0]->owner_op->op_type == OP_INPUT) {
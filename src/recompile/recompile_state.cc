@@ -21,9 +21,20 @@ namespace FlexFlow {
 
 RecompileState::RecompileState(std::function<bool(FFModel *)> _trigger_func,
                                std::function<void(FFModel *)> _alter_func,
-                               FFModel *_ff)
-    : trigger_func(_trigger_func), alter_func(_alter_func), ff(_ff) {
+                               FFModel *_ff,
+                               std::vector<ParallelTensor> const &_tensors)
+    : trigger_func(_trigger_func), alter_func(_alter_func), ff(_ff),
+      tensors(_tensors) {
   recompilations = 0;
+  for (ParallelTensor const &tensor : tensors) {
+    ff->retain_tensor(tensor);
+  }
+}
+
+RecompileState::~RecompileState() {
+  for (ParallelTensor const &tensor : tensors) {
+    ff->release_tensor(tensor);
+  }
 }
 
 bool RecompileState::trigger() {
@@ -435,4 +435,21 @@ template int64_t *helperGetTensorPointerWO(PhysicalRegion region,
                                            Context ctx,
                                            Runtime *runtime);
 
+// Low-precision optimizer state, see OptimizerStateType
+template int8_t *helperGetTensorPointerRW(PhysicalRegion region,
+                                          RegionRequirement req,
+                                          FieldID fid,
+                                          Context ctx,
+                                          Runtime *runtime);
+template uint8_t *helperGetTensorPointerRW(PhysicalRegion region,
+                                           RegionRequirement req,
+                                           FieldID fid,
+                                           Context ctx,
+                                           Runtime *runtime);
+template uint16_t *helperGetTensorPointerRW(PhysicalRegion region,
+                                            RegionRequirement req,
+                                            FieldID fid,
+                                            Context ctx,
+                                            Runtime *runtime);
+
 }; // namespace FlexFlow
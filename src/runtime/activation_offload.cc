@@ -0,0 +1,203 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flexflow/activation_offload.h"
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+namespace FlexFlow {
+
+namespace {
+
+/**
+ * @brief Forward and backward schedule of the operators of one device.
+ */
+struct DeviceTimeline {
+  std::vector<float> forward_end;    ///< End of the forward pass of op i
+  std::vector<float> backward_start; ///< Start of the backward pass of op i
+  float forward_total = 0.0f;
+};
+
+DeviceTimeline build_timeline(std::vector<OffloadOp> const &ops, int device) {
+  DeviceTimeline t;
+  t.forward_end.resize(ops.size());
+  t.backward_start.resize(ops.size());
+  for (size_t i = 0; i < ops.size(); i++) {
+    std::vector<int> const &devices = ops[i].devices;
+    if (std::find(devices.begin(), devices.end(), device) != devices.end()) {
+      t.forward_total += ops[i].forward_time;
+    }
+    t.forward_end[i] = t.forward_total;
+  }
+  float backward = t.forward_total;
+  for (size_t i = ops.size(); i-- > 0;) {
+    t.backward_start[i] = backward;
+    std::vector<int> const &devices = ops[i].devices;
+    if (std::find(devices.begin(), devices.end(), device) != devices.end()) {
+      backward += ops[i].backward_time;
+    }
+  }
+  return t;
+}
+
+// Whether the copies of the activations offloaded from a device, sorted by
+// operator index, are all hidden behind its compute; prefetch_start, if
+// given, receives the start of the prefetch of each activation
+bool copies_hidden(DeviceTimeline const &t,
+                   std::vector<OffloadOp> const &ops,
+                   std::vector<int> const &offloaded,
+                   float host_bandwidth,
+                   std::unordered_map<int, float> *prefetch_start = nullptr) {
+  // Offloads are issued in program order
+  float engine = 0.0f;
+  for (int i : offloaded) {
+    engine = std::max(engine, t.forward_end[i]) +
+             ops[i].output_bytes / host_bandwidth;
+    if (engine > t.forward_total) {
+      return false;
+    }
+  }
+  // Prefetches are issued in the order they are needed; schedule them as
+  // late as possible, starting from the last one
+  std::vector<std::pair<float, int>> needed;
+  for (int i : offloaded) {
+    needed.push_back(
+        std::make_pair(t.backward_start[ops[i].last_consumer], i));
+  }
+  std::sort(needed.begin(), needed.end());
+  float next_start = std::numeric_limits<float>::max();
+  for (size_t k = needed.size(); k-- > 0;) {
+    int i = needed[k].second;
+    next_start = std::min(needed[k].first, next_start) -
+                 ops[i].output_bytes / host_bandwidth;
+    if (next_start < t.forward_total) {
+      return false;
+    }
+    if (prefetch_start != nullptr) {
+      (*prefetch_start)[i] = next_start;
+    }
+  }
+  return true;
+}
+
+// The operator before whose backward pass a prefetch starting at the given
+// time is issued: the last one whose backward pass starts by then
+int prefetch_point(DeviceTimeline const &t, float start) {
+  // Backward passes run from the last operator to the first
+  int j = (int)t.backward_start.size() - 1;
+  while (j > 0 && t.backward_start[j - 1] <= start) {
+    j--;
+  }
+  return j;
+}
+
+} // namespace
+
+ActivationOffloadPlan
+    plan_activation_offload(std::vector<OffloadOp> const &ops,
+                            std::unordered_map<int, float> const &device_mem,
+                            float memory_threshold,
+                            float host_bandwidth) {
+  assert(host_bandwidth > 0.0f);
+  ActivationOffloadPlan plan;
+  plan.device_mem = device_mem;
+  auto over_threshold = [&](int device) {
+    return plan.device_mem[device] >= memory_threshold;
+  };
+
+  std::vector<int> candidates;
+  for (size_t i = 0; i < ops.size(); i++) {
+    assert(ops[i].last_consumer >= (int)i &&
+           ops[i].last_consumer < (int)ops.size());
+    if (ops[i].output_bytes > 0) {
+      candidates.push_back(i);
+    }
+  }
+  std::stable_sort(candidates.begin(), candidates.end(), [&](int a, int b) {
+    return ops[a].output_bytes > ops[b].output_bytes;
+  });
+
+  std::unordered_map<int, DeviceTimeline> timelines;
+  std::unordered_map<int, std::vector<int>> offloaded_from;
+  for (int i : candidates) {
+    bool any_over = false;
+    for (auto const &d : plan.device_mem) {
+      any_over = any_over || d.second >= memory_threshold;
+    }
+    if (!any_over) {
+      break;
+    }
+    std::vector<int> const &devices = ops[i].devices;
+    if (std::none_of(devices.begin(), devices.end(), over_threshold)) {
+      continue;
+    }
+    // Offloading saves memory on every device of the operator, so its
+    // copies must be hidden on all of them
+    std::unordered_map<int, std::vector<int>> tentative;
+    bool hidden = true;
+    for (int d : devices) {
+      if (timelines.find(d) == timelines.end()) {
+        timelines[d] = build_timeline(ops, d);
+      }
+      std::vector<int> &offloaded = tentative[d];
+      offloaded = offloaded_from[d];
+      offloaded.insert(std::upper_bound(offloaded.begin(), offloaded.end(), i),
+                       i);
+      if (!copies_hidden(timelines[d], ops, offloaded, host_bandwidth)) {
+        hidden = false;
+        break;
+      }
+    }
+    if (!hidden) {
+      continue;
+    }
+    for (int d : devices) {
+      offloaded_from[d] = tentative[d];
+      plan.device_mem[d] -= ops[i].output_bytes / 1e6f;
+    }
+    plan.offloaded.push_back(i);
+    plan.copy_time += 2 * devices.size() * ops[i].output_bytes / host_bandwidth;
+  }
+  std::sort(plan.offloaded.begin(), plan.offloaded.end());
+  // Issue each prefetch early enough for all devices of its operator
+  std::unordered_map<int, int> prefetch_before;
+  for (auto const &d : offloaded_from) {
+    std::unordered_map<int, float> prefetch_start;
+    bool hidden = copies_hidden(timelines[d.first],
+                                ops,
+                                d.second,
+                                host_bandwidth,
+                                &prefetch_start);
+    assert(hidden);
+    for (auto const &p : prefetch_start) {
+      int j = prefetch_point(timelines[d.first], p.second);
+      assert(j >= ops[p.first].last_consumer);
+      if (prefetch_before.find(p.first) == prefetch_before.end() ||
+          j > prefetch_before[p.first]) {
+        prefetch_before[p.first] = j;
+      }
+    }
+  }
+  for (int i : plan.offloaded) {
+    plan.prefetch_before.push_back(prefetch_before.at(i));
+  }
+  for (auto const &d : plan.device_mem) {
+    plan.max_per_device_mem = std::max(plan.max_per_device_mem, d.second);
+  }
+  return plan;
+}
+
+} // namespace FlexFlow
@@ -0,0 +1,118 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flexflow/capacity_planning.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+
+namespace FlexFlow {
+
+bool parse_cluster_candidates(std::string const &spec,
+                              std::vector<ClusterCandidate> &candidates) {
+  candidates.clear();
+  size_t begin = 0;
+  while (begin <= spec.size()) {
+    size_t end = spec.find(',', begin);
+    if (end == std::string::npos) {
+      end = spec.size();
+    }
+    std::string item = spec.substr(begin, end - begin);
+    ClusterCandidate c;
+    char trailing;
+    if (sscanf(item.c_str(),
+               "%dx%d@%f%c",
+               &c.num_nodes,
+               &c.gpus_per_node,
+               &c.cost_per_gpu_hour,
+               &trailing) != 3 ||
+        c.num_nodes <= 0 || c.gpus_per_node <= 0 ||
+        c.cost_per_gpu_hour < 0.0f) {
+      candidates.clear();
+      return false;
+    }
+    candidates.push_back(c);
+    begin = end + 1;
+  }
+  return !candidates.empty();
+}
+
+float AnalyticCostModel::kernel_time(double flops, double bytes) const {
+  return kernel_overhead +
+         (float)std::max(flops / flops_per_ms, bytes / bytes_per_ms);
+}
+
+CapacityPlanPoint::CapacityPlanPoint(ClusterCandidate const &_cluster,
+                                     int batch_size,
+                                     float _step_time)
+    : cluster(_cluster), step_time(_step_time) {
+  assert(step_time > 0.0f);
+  throughput = batch_size * 1000.0f / step_time;
+  cost_per_hour = cluster.cost_per_hour();
+  cost_per_million_samples = cost_per_hour / (throughput * 3600.0f) * 1e6f;
+}
+
+std::vector<CapacityPlanPoint>
+    capacity_pareto_front(std::vector<CapacityPlanPoint> const &points) {
+  std::vector<CapacityPlanPoint> sorted = points;
+  std::sort(sorted.begin(),
+            sorted.end(),
+            [](CapacityPlanPoint const &a, CapacityPlanPoint const &b) {
+              if (a.cost_per_hour != b.cost_per_hour) {
+                return a.cost_per_hour < b.cost_per_hour;
+              }
+              return a.step_time < b.step_time;
+            });
+  std::vector<CapacityPlanPoint> front;
+  for (CapacityPlanPoint const &p : sorted) {
+    // Every point kept so far costs less or the same
+    if (front.empty() || p.step_time < front.back().step_time) {
+      front.push_back(p);
+    }
+  }
+  return front;
+}
+
+int select_capacity_point(std::vector<CapacityPlanPoint> const &points,
+                          float target_throughput) {
+  int best = -1;
+  for (size_t i = 0; i < points.size(); i++) {
+    if (points[i].throughput < target_throughput) {
+      continue;
+    }
+    if (best < 0 || points[i].cost_per_hour < points[best].cost_per_hour ||
+        (points[i].cost_per_hour == points[best].cost_per_hour &&
+         points[i].throughput > points[best].throughput)) {
+      best = i;
+    }
+  }
+  return best;
+}
+
+CapacityPlan plan_capacity(
+    std::vector<ClusterCandidate> const &candidates,
+    int batch_size,
+    float target_throughput,
+    std::function<float(ClusterCandidate const &)> const &step_time) {
+  CapacityPlan plan;
+  for (ClusterCandidate const &c : candidates) {
+    plan.points.push_back(CapacityPlanPoint(c, batch_size, step_time(c)));
+  }
+  plan.pareto_front = capacity_pareto_front(plan.points);
+  plan.best = select_capacity_point(plan.points, target_throughput);
+  return plan;
+}
+
+} // namespace FlexFlow
@@ -0,0 +1,47 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flexflow/cpu_task_model.h"
+#include <cassert>
+#include <cmath>
+
+namespace FlexFlow {
+
+float CpuTaskModel::task_time(size_t volume, bool omp) const {
+  float serial_time = volume * element_time;
+  if (!omp) {
+    return serial_time;
+  }
+  assert(omp_threads > 0);
+  return omp_overhead + serial_time / (omp_threads * omp_efficiency);
+}
+
+bool CpuTaskModel::prefer_omp(size_t volume) const {
+  return omp_threads > 1 && task_time(volume, true) < task_time(volume, false);
+}
+
+size_t CpuTaskModel::min_omp_volume() const {
+  // Solve volume * t = overhead + volume * t / (threads * efficiency)
+  float speedup = omp_threads * omp_efficiency;
+  if (omp_threads <= 1 || speedup <= 1.0f || element_time <= 0.0f) {
+    return 0;
+  }
+  float volume = omp_overhead / (element_time * (1.0f - 1.0f / speedup));
+  size_t v = (size_t)std::floor(volume) + 1;
+  assert(prefer_omp(v));
+  return v;
+}
+
+} // namespace FlexFlow
@@ -47,6 +47,10 @@ std::string get_operator_type_name(OperatorType type) {
       return "Embedding";
     case OP_GATHER:
       return "Gather";
+    case OP_DOT_INTERACTION:
+      return "DotInteraction";
+    case OP_ELEMENT_EXPRESSION:
+      return "ElementExpression";
     case OP_GROUP_BY:
       return "Group_by";
     case OP_CACHE:
@@ -0,0 +1,60 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flexflow/gradient_overwrite.h"
+#include <algorithm>
+#include <cassert>
+
+namespace FlexFlow {
+
+GradientOverwritePlan
+    plan_gradient_overwrites(std::vector<GradientAccess> const &ops,
+                             std::vector<int> const &loss_grads) {
+  GradientOverwritePlan plan;
+  plan.overwrite.resize(ops.size());
+  // Gradients whose content is defined by the writes so far
+  std::set<int> defined;
+  for (int g : loss_grads) {
+    defined.insert(g);
+    plan.overwritten.insert(g);
+  }
+  for (int l = (int)ops.size() - 1; l >= 0; l--) {
+    GradientAccess const &op = ops[l];
+    assert(op.can_overwrite.size() == op.writes.size());
+    // An output gradient nobody has written must be zero when read
+    for (int g : op.reads) {
+      defined.insert(g);
+    }
+    plan.overwrite[l].resize(op.writes.size(), false);
+    for (size_t i = 0; i < op.writes.size(); i++) {
+      int g = op.writes[i];
+      if (g < 0 || defined.find(g) != defined.end()) {
+        continue;
+      }
+      // A gradient written twice by one operator is accumulated into
+      bool single = std::count(op.writes.begin(), op.writes.end(), g) == 1;
+      if (op.can_overwrite[i] && single) {
+        plan.overwrite[l][i] = true;
+        plan.overwritten.insert(g);
+      }
+    }
+    for (int g : op.writes) {
+      defined.insert(g);
+    }
+  }
+  return plan;
+}
+
+} // namespace FlexFlow
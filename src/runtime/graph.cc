@@ -13,6 +13,7 @@
  * limitations under the License.
  */
 #include "flexflow/graph.h"
+#include "flexflow/activation_offload.h"
 #include "flexflow/dominators.h"
 #include "flexflow/ffconst_utils.h"
 #include "flexflow/ops/aggregate.h"
@@ -21,8 +22,10 @@
 #include "flexflow/ops/cast.h"
 #include "flexflow/ops/concat.h"
 #include "flexflow/ops/conv_2d.h"
+#include "flexflow/ops/dot_interaction.h"
 #include "flexflow/ops/dropout.h"
 #include "flexflow/ops/element_binary.h"
+#include "flexflow/ops/element_expression.h"
 #include "flexflow/ops/element_unary.h"
 #include "flexflow/ops/embedding.h"
 #include "flexflow/ops/flat.h"
@@ -31,9 +34,11 @@
 #include "flexflow/ops/layer_norm.h"
 #include "flexflow/ops/linear.h"
 #include "flexflow/ops/noop.h"
+#include "flexflow/ops/pad.h"
 #include "flexflow/ops/pool_2d.h"
 #include "flexflow/ops/reduce.h"
 #include "flexflow/ops/reshape.h"
+#include "flexflow/ops/slice.h"
 #include "flexflow/ops/softmax.h"
 #include "flexflow/ops/split.h"
 #include "flexflow/ops/topk.h"
@@ -43,6 +48,7 @@
 #include "flexflow/parallel_ops/partition.h"
 #include "flexflow/parallel_ops/reduction.h"
 #include "flexflow/parallel_ops/replicate.h"
+#include "flexflow/serving_search.h"
 #include "flexflow/utils/disjoint_set.h"
 #include "legion.h"
 #include "legion/legion_utilities.h"
@@ -1454,6 +1460,9 @@ T SearchHelper::estimate_xfer_cost(Graph const *graph,
       // source.node.ptr->name, sink.node.ptr->name, estimated_xfer_cost);
       op_cost += estimated_xfer_cost;
     }
+    // Credit the sink's launch if apply_fusion will fold it into the source
+    op_cost -= this->model->simulator->estimate_fusion_savings(
+        source.node.ptr, source.view, sink.node.ptr, sink.view);
     this->add_operator_cost<T>(source, op_cost, &result);
   } else {
     Node real_source = graph->find_source_node();
@@ -1491,6 +1500,8 @@ GraphCostResultWithMemory
           sink.node.ptr, it2.dstIdx, source.view, sink.view);
       op_cost += estimated_xfer_cost;
     }
+    op_cost -= this->model->simulator->estimate_fusion_savings(
+        source.node.ptr, source.view, sink.node.ptr, sink.view);
     this->add_operator_cost_with_memory(
         source, op_cost, MemoryUsage{}, &result);
   } else {
@@ -1555,7 +1566,8 @@ void SearchHelper::add_sink_node_costs(NodeAssignment const &sink,
                                        T *result) const {
   this->add_operator_cost<T>(sink,
                              metrics.forward_time + metrics.backward_time +
-                                 metrics.sync_time,
+                                 metrics.sync_time + metrics.launch_time +
+                                 metrics.straggler_time,
                              result);
 }
 
@@ -1571,7 +1583,8 @@ void SearchHelper::add_sink_node_costs<GraphCostResultWithMemory>(
   float op_total_mem_mb = ((float)(metrics.op_total_mem / 1e4)) / 1e2;
   this->add_operator_cost_with_memory(
       sink,
-      metrics.forward_time + metrics.backward_time + metrics.sync_time,
+      metrics.forward_time + metrics.backward_time + metrics.sync_time +
+          metrics.launch_time + metrics.straggler_time,
       MemoryUsage{MemoryUsageType::GLOBAL, op_total_mem_mb},
       result);
 }
@@ -1727,6 +1740,8 @@ T SearchHelper::graph_cost(Graph const *graph,
                           << "forward(" << metrics.forward_time << ") "
                           << "backward(" << metrics.backward_time << ") "
                           << "sync(" << metrics.sync_time << ") "
+                          << "launch(" << metrics.launch_time << ") "
+                          << "straggler(" << metrics.straggler_time << ") "
                           << "memory(" << op_total_mem_mb << " MB)";
     this->add_sink_node_costs<T>(sink, metrics, &result);
   }
@@ -1884,7 +1899,8 @@ std::pair<std::unique_ptr<Graph>, std::unordered_map<Node, MachineView>>
     try_one_lambda(std::pair<float, MemorySearchResult> &lambda,
                    Task const *task,
                    std::shared_ptr<Simulator> &cached_simulator,
-                   bool perform_memory_search) {
+                   bool perform_memory_search,
+                   AnalyticCostModel const *analytic_cost_model = NULL) {
   // Create a new fresh model
   FFModel *model = *((FFModel **)task->args);
   model->clear_graph_search_cache();
@@ -1904,32 +1920,44 @@ std::pair<std::unique_ptr<Graph>, std::unordered_map<Node, MachineView>>
                        .only_kind(Memory::GPU_FB_MEM)
                        .best_affinity_to(task->target_proc)
                        .first();
+  // Without a GPU, e.g. when planning on a CPU, assume -ll:fsize per device
+  size_t gpu_mem_capacity =
+      gpu_mem.exists() ? gpu_mem.capacity()
+                       : (size_t)model->config.device_mem * 1024 * 1024;
   MachineModel *machine;
   if (model->config.machine_model_version == 0) {
     machine =
         (MachineModel *)new SimpleMachineModel(model->config.numNodes,
                                                model->config.workersPerNode,
-                                               gpu_mem.capacity());
+                                               gpu_mem_capacity);
   } else if (model->config.machine_model_version == 1 and
              !model->config.machine_model_file.empty()) {
     machine = (MachineModel *)new EnhancedMachineModel(
-        model->config.machine_model_file, gpu_mem.capacity());
+        model->config.machine_model_file, gpu_mem_capacity);
   } else {
     assert(false &&
            "machine model creation error: currently only support "
            "machine-model-version = 0 or 1. When machine-model-version = 1, "
            "machine-model-file should not be empty.");
   }
-  // Assume this task is running on GPU0
   if (!cached_simulator) {
-    cached_simulator = std::make_shared<Simulator>(
-        model, model->handlers[0], gpu_mem, machine);
+    if (analytic_cost_model != NULL) {
+      cached_simulator =
+          std::make_shared<Simulator>(model, machine, analytic_cost_model);
+    } else {
+      // Assume this task is running on GPU0
+      cached_simulator = std::make_shared<Simulator>(
+          model, model->handlers[0], gpu_mem, machine);
+    }
   } else {
     // Update simulator with the new stuff
-    cached_simulator->handler = model->handlers[0];
-    cached_simulator->memory = gpu_mem;
-    cached_simulator->machine = machine;
+    if (gpu_mem.exists()) {
+      cached_simulator->handler = model->handlers[0];
+      cached_simulator->memory = gpu_mem;
+    }
+    cached_simulator->set_machine_model(machine);
   }
+  cached_simulator->analytic_cost_model = analytic_cost_model;
   model->simulator = cached_simulator.get();
 
   // Perform the search
@@ -1985,7 +2013,8 @@ bool is_valid_strategy(
     Graph *curr_graph,
     std::unordered_map<Node, MachineView> &curr_views,
     std::shared_ptr<Simulator> const cached_simulator,
-    float memory_threshold) {
+    float memory_threshold,
+    bool offload_activations) {
   std::cout << "try to check valid for lambda " << lambdas_results.back().first
             << std::endl;
   assert(cached_simulator.get() != nullptr &&
@@ -2018,6 +2047,56 @@ bool is_valid_strategy(
     }
   }
 
+  if (offload_activations && max_per_device_mem >= memory_threshold) {
+    // Try to fit by offloading saved activations to host memory, which
+    // keeps the partitioning of this strategy
+    using FlexFlow::PCG::Utils::topo_sort;
+    std::vector<Node> order;
+    topo_sort(*curr_graph, &order);
+    std::unordered_map<Node, int> node_to_index;
+    for (size_t i = 0; i < order.size(); i++) {
+      node_to_index[order[i]] = i;
+    }
+    std::vector<OffloadOp> ops(order.size());
+    for (size_t i = 0; i < order.size(); i++) {
+      Op const *op = order[i].ptr;
+      MachineView const &view = curr_views.at(order[i]);
+      CostMetrics op_cost = cached_simulator->measure_operator_cost(op, view);
+      ops[i].devices = view.device_ids();
+      ops[i].forward_time = op_cost.forward_time;
+      ops[i].backward_time = op_cost.backward_time;
+      ops[i].last_consumer = i;
+      for (auto const &e : curr_graph->outEdges[order[i]]) {
+        ops[i].last_consumer =
+            std::max(ops[i].last_consumer, node_to_index.at(e.dstOp));
+      }
+      if (!op->is_parallel_op() && op->op_type != OP_INPUT &&
+          op->op_type != OP_WEIGHT) {
+        ops[i].output_bytes = op_cost.outputs_memory;
+      }
+    }
+    ActivationOffloadPlan plan = plan_activation_offload(
+        ops,
+        device_to_mem,
+        memory_threshold,
+        cached_simulator->machine->get_host_gpu_bandwidth());
+    std::vector<size_t> &offloaded =
+        lambdas_results.back().second.offloaded_nodes;
+    std::vector<size_t> &prefetch =
+        lambdas_results.back().second.prefetch_nodes;
+    offloaded.clear();
+    prefetch.clear();
+    for (size_t k = 0; k < plan.offloaded.size(); k++) {
+      offloaded.push_back(order[plan.offloaded[k]].guid);
+      prefetch.push_back(order[plan.prefetch_before[k]].guid);
+    }
+    std::cout << "offloaded " << offloaded.size()
+              << " activations: max_per_device_mem: " << max_per_device_mem
+              << " -> " << plan.max_per_device_mem
+              << ", hidden copy time: " << plan.copy_time << std::endl;
+    max_per_device_mem = plan.max_per_device_mem;
+  }
+
   lambdas_results.back().second.max_per_device_mem_all_deivces =
       max_per_device_mem;
 
@@ -2031,137 +2110,16 @@ bool is_valid_strategy(
   return true;
 };
 
-}; // namespace
-
 /**
- * @brief Starting point of Unity search procedure. Registered on Legion
- * runtime. Legion task to launch as one step of model.compile().
- *
- * @param task Legion task to get FFModel and other configs
- * @param regions Not used
- * @param ctx Not used
- * @param runtime Not used
- * @return GraphOptimalViewSerialized Serialized optimal PCG
+ * @brief Serialize a PCG and its machine views, to be reconstructed by
+ * FFModel::deserialize_graph_optimal_view.
  */
-GraphOptimalViewSerialized
-    Graph::graph_optimize_task(Task const *task,
-                               std::vector<PhysicalRegion> const &regions,
-                               Context ctx,
-                               Runtime *runtime) {
-  auto model_config = (*((FFModel **)task->args))->config;
-  bool perform_memory_search = model_config.perform_memory_search;
-  float memory_threshold = model_config.device_mem;
-  bool only_data_parallel = model_config.only_data_parallel;
-
-  std::vector<std::pair<float, MemorySearchResult>> lambdas{};
-
-  std::shared_ptr<Simulator> cached_simulator{};
-
-  // Optimized graph from the search
-  std::unique_ptr<Graph> best_graph;
-  std::unordered_map<Node, MachineView> optimal_views;
-
-  // Be optimistic
-  lambdas.emplace_back(std::make_pair(1.0, MemorySearchResult{}));
-  auto try_result = try_one_lambda(
-      lambdas.back(), task, cached_simulator, perform_memory_search);
-  best_graph = std::move(try_result.first);
-  optimal_views = try_result.second;
-
-  bool has_valid_strategy = false;
-  int best_lambda_index = -1;
-  int binary_search_budget = 10;
-
-  if (perform_memory_search && !is_valid_strategy(lambdas,
-                                                  best_graph.get(),
-                                                  optimal_views,
-                                                  cached_simulator,
-                                                  memory_threshold)) {
-    // Not found the strategy; need to do binary search
-    lambdas.emplace_back(std::make_pair(0.0, MemorySearchResult{}));
-    try_result = try_one_lambda(
-        lambdas.back(), task, cached_simulator, perform_memory_search);
-    best_graph = std::move(try_result.first);
-    optimal_views = try_result.second;
-
-    if (!is_valid_strategy(lambdas,
-                           best_graph.get(),
-                           optimal_views,
-                           cached_simulator,
-                           memory_threshold)) {
-      // Cannot find a valid strategy
-      has_valid_strategy = false;
-    } else {
-      has_valid_strategy = true;
-      best_lambda_index = 1;
-
-      // Do a binary search between 0 and 1 for the best lambda
-      int bianry_search_num = 0;
-      float lower = 0.0;
-      float upper = 1.0;
-
-      while (bianry_search_num < binary_search_budget) {
-        bianry_search_num++;
-
-        float mid = (lower + upper) * 0.5;
-
-        lambdas.emplace_back(std::make_pair(mid, MemorySearchResult{}));
-        try_result = try_one_lambda(
-            lambdas.back(), task, cached_simulator, perform_memory_search);
-
-        if (!is_valid_strategy(lambdas,
-                               try_result.first.get(),
-                               try_result.second,
-                               cached_simulator,
-                               memory_threshold)) {
-          upper = mid;
-        } else {
-          // Found a better and valid strategy
-          best_graph = std::move(try_result.first);
-          optimal_views = try_result.second;
-
-          lower = mid;
-          best_lambda_index = 1 + bianry_search_num;
-        }
-      }
-    }
-  } else {
-    has_valid_strategy = true;
-    best_lambda_index = 0;
-  }
-
-  // Print out the results
-  if (perform_memory_search) {
-    if (has_valid_strategy) {
-      auto &best_l = lambdas[best_lambda_index];
-      std::cout << "Found valid strategy with memory_threshold: "
-                << memory_threshold << " | lambda index: " << best_lambda_index
-                << ", lambda value: " << best_l.first
-                << ", result: run time cost: " << best_l.second.run_time_cost
-                << ", memory cost: " << best_l.second.memory_cost
-                << ", search time: " << best_l.second.search_time
-                << ", per-device max memory: "
-                << best_l.second.max_per_device_mem_all_deivces << std::endl;
-    } else {
-      std::cout << "Failed to find a valid strategy" << std::endl;
-    }
-
-    std::cout << "All lambda results:" << std::endl;
-    for (auto l : lambdas) {
-      std::cout << "lambda: " << l.first
-                << ", run time cost: " << l.second.run_time_cost
-                << ", memory cost: " << l.second.memory_cost
-                << ", search time: " << l.second.search_time
-                << ", per-device max memory: "
-                << l.second.max_per_device_mem_all_deivces << std::endl;
-    }
-  } else if (!only_data_parallel) {
-    std::cout << "\nNot doing memory search" << std::endl;
-  }
-
-  // Following lines are to serialize the optimized PCG.
-  // Only need best_graph and optimal_views below.
-  Serializer sez;
+void serialize_graph_optimal_view(
+    Graph *best_graph,
+    std::unordered_map<Node, MachineView> const &optimal_views,
+    std::vector<size_t> const &offloaded_nodes,
+    std::vector<size_t> const &prefetch_nodes,
+    Serializer &sez) {
   // First serialize graph
   sez.serialize(best_graph->inEdges.size());
   std::unordered_map<Node, int> todos;
@@ -2233,6 +2191,9 @@ GraphOptimalViewSerialized
         sez.serialize(embed->out_channels);
         sez.serialize(embed->aggr);
         sez.serialize(embed->data_type);
+        sez.serialize(embed->mode);
+        sez.serialize(embed->num_buckets);
+        sez.serialize(embed->embed_dim);
         break;
       }
       case OP_EW_ADD:
@@ -2308,6 +2269,597 @@ GraphOptimalViewSerialized
     sez.serialize(it.first.guid);
     sez.serialize(it.second);
   }
+  // Third, serialize the nodes whose outputs are offloaded to host memory,
+  // and the nodes before which they are prefetched
+  assert(prefetch_nodes.size() == offloaded_nodes.size());
+  sez.serialize(offloaded_nodes.size());
+  for (size_t i = 0; i < offloaded_nodes.size(); i++) {
+    sez.serialize(offloaded_nodes[i]);
+    sez.serialize(prefetch_nodes[i]);
+  }
+}
+
+/**
+ * @brief Find how many samples each layer tensor folds into its outermost
+ * dimension, e.g. batch * seq_length after a view(-1, hidden), or 0 if the
+ * tensor does not depend on the samples.
+ *
+ * @details The sample dimension is followed through the layers from the
+ * model inputs, so a shape that merely equals the batch size is not taken
+ * for it. Aborts with an error if a layer moves the samples out of the
+ * outermost dimension, since the other batch sizes could not be derived.
+ */
+std::unordered_map<Tensor, int> find_sample_factors(FFModel const *model) {
+  int const batch_size = model->config.batchSize;
+  std::unordered_map<Tensor, int> factors;
+  for (Layer const *layer : model->layers) {
+    if (layer->op_type == OP_INPUT) {
+      Tensor tensor = layer->outputs[0];
+      factors[tensor] =
+          tensor->dims[tensor->num_dims - 1] == batch_size ? 1 : 0;
+      continue;
+    }
+    int factor = 0;
+    for (int i = 0; i < layer->numInputs && factor == 0; i++) {
+      auto it = factors.find(layer->inputs[i]);
+      factor = it == factors.end() ? 0 : it->second;
+    }
+    if (factor > 0 && layer->op_type == OP_RESHAPE) {
+      std::vector<int> shape;
+      layer->get_int_vector_property("shape", shape);
+      // -1 if the samples are split over several dimensions, which the
+      // check below rejects
+      factor = shape[0] % batch_size == 0 ? shape[0] / batch_size : -1;
+    }
+    for (int i = 0; i < layer->numOutputs; i++) {
+      Tensor tensor = layer->outputs[i];
+      if (factor != 0 &&
+          tensor->dims[tensor->num_dims - 1] != factor * batch_size) {
+        fprintf(stderr,
+                "Serving search: layer %s moves the samples out of the "
+                "outermost dimension, so the model cannot be searched for "
+                "other batch sizes; pass --serving-batch-sizes %d\n",
+                layer->name,
+                batch_size);
+        assert(false);
+      }
+      factors[tensor] = factor;
+    }
+  }
+  return factors;
+}
+
+/**
+ * @brief Recreate the operators of the model for another batch size.
+ *
+ * @param factors Samples folded into the outermost dimension of each layer
+ * tensor, see find_sample_factors. The layer tensors and the target shapes
+ * of reshapes are scaled by them; the operator shapes are inferred again.
+ */
+void set_search_batch_size(FFModel *model,
+                           std::unordered_map<Tensor, int> const &factors,
+                           int batch_size) {
+  if (batch_size == model->config.batchSize) {
+    return;
+  }
+  for (Layer *layer : model->layers) {
+    for (int i = 0; i < layer->numOutputs; i++) {
+      Tensor tensor = layer->outputs[i];
+      int factor = factors.at(tensor);
+      if (factor > 0) {
+        tensor->dims[tensor->num_dims - 1] = factor * batch_size;
+      }
+    }
+    if (layer->op_type == OP_INPUT) {
+      // Mapped again by create_operators_from_layers
+      layer->outputs[0]->parallel_tensor = nullptr;
+    } else if (layer->op_type == OP_RESHAPE) {
+      int factor = factors.at(layer->outputs[0]);
+      if (factor > 0) {
+        std::vector<int> shape;
+        layer->get_int_vector_property("shape", shape);
+        shape[0] = factor * batch_size;
+        layer->add_int_vector_property("shape", shape);
+      }
+    }
+  }
+  model->config.batchSize = batch_size;
+  // The graphs searched for the old batch size, which point to its
+  // operators, are gone by now
+  for (Op *op : model->operators) {
+    delete op;
+  }
+  model->operators.clear();
+  model->create_operators_from_layers();
+}
+
+/**
+ * @brief Serving search: search a strategy for each candidate batch size,
+ * report the Pareto front of throughput versus latency and pick the point
+ * with the highest throughput under the latency SLO.
+ *
+ * @return The search result for the configured batch size, which the model
+ * is compiled with. The selected point is returned in selected.
+ */
+std::pair<std::unique_ptr<Graph>, std::unordered_map<Node, MachineView>>
+    serving_search(std::pair<float, MemorySearchResult> &lambda,
+                   Task const *task,
+                   std::shared_ptr<Simulator> &cached_simulator,
+                   bool perform_memory_search,
+                   ExportedStrategy &selected) {
+  FFModel *model = *((FFModel **)task->args);
+  int const batch_size = model->config.batchSize;
+  float const latency_slo = model->config.serving_latency_slo;
+  std::vector<int> candidates =
+      model->config.serving_batch_sizes.empty()
+          ? default_serving_batch_sizes(batch_size)
+          : model->config.serving_batch_sizes;
+  // Search the configured batch size last to leave the model as configured
+  std::sort(candidates.begin(), candidates.end());
+  candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                   candidates.end());
+  candidates.erase(
+      std::remove(candidates.begin(), candidates.end(), batch_size),
+      candidates.end());
+  candidates.push_back(batch_size);
+
+  std::pair<std::unique_ptr<Graph>, std::unordered_map<Node, MachineView>>
+      result;
+  std::vector<ServingSearchPoint> points;
+  std::vector<std::vector<char>> strategies;
+  std::unordered_map<Tensor, int> factors;
+  if (candidates.size() > 1) {
+    factors = find_sample_factors(model);
+  }
+  for (int b : candidates) {
+    set_search_batch_size(model, factors, b);
+    auto try_result =
+        try_one_lambda(lambda, task, cached_simulator, perform_memory_search);
+    points.emplace_back(b, try_result.first->optimal_cost());
+    printf("Serving search: batch size %d, latency %.3f ms, throughput %.1f "
+           "samples/s\n",
+           b,
+           points.back().latency,
+           points.back().throughput);
+    Serializer sez;
+    serialize_graph_optimal_view(
+        try_result.first.get(), try_result.second, {}, {}, sez);
+    char const *buffer = (char const *)sez.get_buffer();
+    strategies.emplace_back(buffer, buffer + sez.get_used_bytes());
+    if (b == batch_size) {
+      result = std::move(try_result);
+    }
+  }
+
+  int best = select_serving_point(points, latency_slo);
+  printf("Serving search Pareto front (latency SLO %.3f ms):\n", latency_slo);
+  for (ServingSearchPoint const &p : serving_pareto_front(points)) {
+    printf("  batch size %d: latency %.3f ms, throughput %.1f samples/s%s\n",
+           p.batch_size,
+           p.latency,
+           p.throughput,
+           p.batch_size == points[best].batch_size ? " (selected)" : "");
+  }
+  if (points[best].latency > latency_slo) {
+    printf("No batch size meets the latency SLO, selected the lowest "
+           "latency\n");
+  }
+  if (points[best].batch_size != batch_size) {
+    printf("Note: the model is compiled with batch size %d; import the "
+           "exported strategy to serve with batch size %d\n",
+           batch_size,
+           points[best].batch_size);
+  }
+  selected.batch_size = points[best].batch_size;
+  selected.comp_mode = model->config.computationMode;
+  selected.latency_slo = latency_slo;
+  selected.latency = points[best].latency;
+  selected.graph_optimal_view = std::move(strategies[best]);
+  return result;
+}
+
+/**
+ * @brief Capacity planning: search a strategy on every candidate cluster
+ * shape, report the Pareto front of cost versus step time and the cheapest
+ * shape that reaches the target throughput.
+ *
+ * @details Only the simulator is used, with the kernel times estimated by
+ * FFConfig::plan_cost_model instead of measured, and shared by the shapes.
+ * The model configuration is restored afterwards so that the actual search
+ * runs on the actual machine. The simulator creates no device state, so the
+ * planning also runs on a machine without GPUs (-ll:gpu 0).
+ */
+void capacity_planning(Task const *task) {
+  FFModel *model = *((FFModel **)task->args);
+  FFConfig &config = model->config;
+  if (config.machine_model_version != 0) {
+    printf("Capacity planning requires machine-model-version 0, skipped\n");
+    return;
+  }
+  int const num_nodes = config.numNodes;
+  int const workers_per_node = config.workersPerNode;
+  tl::optional<int> const search_num_nodes = config.search_num_nodes;
+  tl::optional<int> const search_num_workers = config.search_num_workers;
+
+  // Estimated kernel times must not end up in the cache of the actual search
+  std::shared_ptr<Simulator> planning_simulator;
+  CapacityPlan plan = plan_capacity(
+      config.plan_clusters,
+      config.batchSize,
+      config.plan_target_throughput,
+      [&](ClusterCandidate const &c) {
+        config.search_num_nodes = c.num_nodes;
+        config.search_num_workers = c.gpus_per_node;
+        std::pair<float, MemorySearchResult> lambda{1.0,
+                                                    MemorySearchResult{}};
+        auto try_result = try_one_lambda(lambda,
+                                         task,
+                                         planning_simulator,
+                                         false,
+                                         &config.plan_cost_model);
+        float step_time = try_result.first->optimal_cost();
+        printf("Capacity planning: %d x %d GPUs, step time %.3f ms\n",
+               c.num_nodes,
+               c.gpus_per_node,
+               step_time);
+        return step_time;
+      });
+
+  config.numNodes = num_nodes;
+  config.workersPerNode = workers_per_node;
+  config.search_num_nodes = search_num_nodes;
+  config.search_num_workers = search_num_workers;
+
+  printf("Capacity planning Pareto front (target %.1f samples/s):\n",
+         config.plan_target_throughput);
+  for (CapacityPlanPoint const &p : plan.pareto_front) {
+    printf("  %d x %d GPUs: %.2f per hour, step time %.3f ms, %.1f "
+           "samples/s, %.2f per million samples\n",
+           p.cluster.num_nodes,
+           p.cluster.gpus_per_node,
+           p.cost_per_hour,
+           p.step_time,
+           p.throughput,
+           p.cost_per_million_samples);
+  }
+  if (plan.best < 0) {
+    printf("No candidate reaches the target throughput\n");
+  } else {
+    CapacityPlanPoint const &best = plan.points[plan.best];
+    printf("Cheapest candidate reaching the target: %d x %d GPUs at %.2f per "
+           "hour (%.1f samples/s)\n",
+           best.cluster.num_nodes,
+           best.cluster.gpus_per_node,
+           best.cost_per_hour,
+           best.throughput);
+  }
+}
+
+/**
+ * @brief Write the task graph of the strategy the model is compiled with,
+ * for the replay tool: the graph is lowered to operators as in
+ * FFModel::compile and simulated on the views chosen for them.
+ */
+void export_compiled_task_graph(
+    FFModel *model,
+    Graph const *graph,
+    std::unordered_map<Node, MachineView> const &optimal_views) {
+  FFConfig const &config = model->config;
+  // The search keeps using the operators of the layers
+  std::vector<Op *> layer_operators = model->operators;
+  model->convert_graph_to_operators(graph, optimal_views, {});
+  std::map<Op const *, MachineView> views;
+  for (Op const *op : model->operators) {
+    views[op] = op->outputs[0]->machine_view;
+  }
+  float runtime = model->simulator->simulate_runtime(
+      model,
+      views,
+      config.computationMode,
+      config.export_strategy_task_graph_file);
+  if (!config.export_strategy_task_graph_trace_file.empty()) {
+    model->simulator->export_task_graph_trace(
+        config.export_strategy_task_graph_trace_file);
+  }
+  printf("Compiled strategy: simulated step time %.3f ms (PCG search: %.3f "
+         "ms)\n",
+         runtime,
+         graph->optimal_cost());
+  for (Op *op : model->operators) {
+    delete op;
+  }
+  model->operators = layer_operators;
+}
+
+}; // namespace
+
+/**
+ * @brief Starting point of Unity search procedure. Registered on Legion
+ * runtime. Legion task to launch as one step of model.compile().
+ *
+ * @param task Legion task to get FFModel and other configs
+ * @param regions Not used
+ * @param ctx Not used
+ * @param runtime Not used
+ * @return GraphOptimalViewSerialized Serialized optimal PCG
+ */
+GraphOptimalViewSerialized
+    Graph::graph_optimize_task(Task const *task,
+                               std::vector<PhysicalRegion> const &regions,
+                               Context ctx,
+                               Runtime *runtime) {
+  auto model_config = (*((FFModel **)task->args))->config;
+  bool perform_memory_search = model_config.perform_memory_search;
+  float memory_threshold = model_config.device_mem;
+  // Offloading trades host copies hidden behind the backward pass for
+  // device memory, so it only applies to training
+  bool offload_activations =
+      model_config.offload_activations &&
+      model_config.computationMode == COMP_MODE_TRAINING;
+  bool only_data_parallel = model_config.only_data_parallel;
+  bool perform_serving_search =
+      model_config.computationMode == COMP_MODE_INFERENCE &&
+      model_config.serving_latency_slo > 0.0f;
+
+  // Without GPUs only the capacity planning, which estimates all kernel
+  // times, can run; an empty strategy tells FFModel::compile to stop
+  if (task->target_proc.kind() == Processor::LOC_PROC) {
+    if (model_config.plan_clusters.empty()) {
+      fprintf(stderr,
+              "Error: searching a strategy requires GPUs; without GPUs only "
+              "--plan-clusters is supported\n");
+      assert(false);
+    }
+    capacity_planning(task);
+    GraphOptimalViewSerialized ret;
+    ret.total_bytes = 0;
+    return ret;
+  }
+
+  // Reuse an exported strategy instead of searching
+  if (!model_config.import_strategy_file.empty()) {
+    ExportedStrategy strategy;
+    bool loaded = ExportedStrategy::load(model_config.import_strategy_file,
+                                         strategy);
+    assert(loaded);
+    assert(strategy.batch_size == model_config.batchSize);
+    assert(strategy.graph_optimal_view.size() <
+           GraphOptimalViewSerialized::buffer_size);
+    printf("Imported the strategy of %s (batch size %d, simulated step time "
+           "%.3f ms)\n",
+           model_config.import_strategy_file.c_str(),
+           strategy.batch_size,
+           strategy.latency);
+    GraphOptimalViewSerialized ret;
+    ret.total_bytes = strategy.graph_optimal_view.size();
+    memcpy(ret.data, strategy.graph_optimal_view.data(), ret.total_bytes);
+    return ret;
+  }
+  ExportedStrategy exported;
+
+  std::vector<std::pair<float, MemorySearchResult>> lambdas{};
+
+  std::shared_ptr<Simulator> cached_simulator{};
+
+  // Optimized graph from the search
+  std::unique_ptr<Graph> best_graph;
+  std::unordered_map<Node, MachineView> optimal_views;
+
+  if (!model_config.plan_clusters.empty()) {
+    capacity_planning(task);
+  }
+
+  // Be optimistic
+  lambdas.emplace_back(std::make_pair(1.0, MemorySearchResult{}));
+  auto try_result = perform_serving_search
+                        ? serving_search(lambdas.back(),
+                                         task,
+                                         cached_simulator,
+                                         perform_memory_search,
+                                         exported)
+                        : try_one_lambda(lambdas.back(),
+                                         task,
+                                         cached_simulator,
+                                         perform_memory_search);
+  best_graph = std::move(try_result.first);
+  optimal_views = try_result.second;
+
+  bool has_valid_strategy = false;
+  int best_lambda_index = -1;
+  int binary_search_budget = 10;
+
+  if (perform_memory_search && !is_valid_strategy(lambdas,
+                                                  best_graph.get(),
+                                                  optimal_views,
+                                                  cached_simulator,
+                                                  memory_threshold,
+                                                  offload_activations)) {
+    // Not found the strategy; need to do binary search
+    lambdas.emplace_back(std::make_pair(0.0, MemorySearchResult{}));
+    try_result = try_one_lambda(
+        lambdas.back(), task, cached_simulator, perform_memory_search);
+    best_graph = std::move(try_result.first);
+    optimal_views = try_result.second;
+
+    if (!is_valid_strategy(lambdas,
+                           best_graph.get(),
+                           optimal_views,
+                           cached_simulator,
+                           memory_threshold,
+                           offload_activations)) {
+      // Cannot find a valid strategy
+      has_valid_strategy = false;
+    } else {
+      has_valid_strategy = true;
+      best_lambda_index = 1;
+
+      // Do a binary search between 0 and 1 for the best lambda
+      int bianry_search_num = 0;
+      float lower = 0.0;
+      float upper = 1.0;
+
+      while (bianry_search_num < binary_search_budget) {
+        bianry_search_num++;
+
+        float mid = (lower + upper) * 0.5;
+
+        lambdas.emplace_back(std::make_pair(mid, MemorySearchResult{}));
+        try_result = try_one_lambda(
+            lambdas.back(), task, cached_simulator, perform_memory_search);
+
+        if (!is_valid_strategy(lambdas,
+                               try_result.first.get(),
+                               try_result.second,
+                               cached_simulator,
+                               memory_threshold,
+                               offload_activations)) {
+          upper = mid;
+        } else {
+          // Found a better and valid strategy
+          best_graph = std::move(try_result.first);
+          optimal_views = try_result.second;
+
+          lower = mid;
+          best_lambda_index = 1 + bianry_search_num;
+        }
+      }
+    }
+  } else {
+    has_valid_strategy = true;
+    best_lambda_index = 0;
+  }
+
+  // Print out the results
+  if (perform_memory_search) {
+    if (has_valid_strategy) {
+      auto &best_l = lambdas[best_lambda_index];
+      std::cout << "Found valid strategy with memory_threshold: "
+                << memory_threshold << " | lambda index: " << best_lambda_index
+                << ", lambda value: " << best_l.first
+                << ", result: run time cost: " << best_l.second.run_time_cost
+                << ", memory cost: " << best_l.second.memory_cost
+                << ", search time: " << best_l.second.search_time
+                << ", per-device max memory: "
+                << best_l.second.max_per_device_mem_all_deivces
+                << ", offloaded activations: "
+                << best_l.second.offloaded_nodes.size() << std::endl;
+    } else {
+      std::cout << "Failed to find a valid strategy" << std::endl;
+    }
+
+    std::cout << "All lambda results:" << std::endl;
+    for (auto l : lambdas) {
+      std::cout << "lambda: " << l.first
+                << ", run time cost: " << l.second.run_time_cost
+                << ", memory cost: " << l.second.memory_cost
+                << ", search time: " << l.second.search_time
+                << ", per-device max memory: "
+                << l.second.max_per_device_mem_all_deivces
+                << ", offloaded activations: "
+                << l.second.offloaded_nodes.size() << std::endl;
+    }
+  } else if (!only_data_parallel) {
+    std::cout << "\nNot doing memory search" << std::endl;
+  }
+
+  // The MCMC search places the operators of the model with the task graph
+  // simulator. Its strategy cannot be lowered to a PCG, so it is reported
+  // next to the one of the PCG search and only its task graph is exported,
+  // with a .mcmc suffix
+  if (model_config.search_mcmc_budget > 0) {
+    FFModel *model = *((FFModel **)task->args);
+    // Start from data parallelism
+    std::map<FlexFlow::Op const *, ParallelConfig> strategy;
+    for (FlexFlow::Op const *op : model->operators) {
+      strategy[op] = op->get_data_parallel_config(*model);
+    }
+    model->mcmc_optimize(strategy,
+                         model_config.search_mcmc_budget,
+                         model_config.search_alpha,
+                         model_config.computationMode,
+                         model_config.enable_propagation);
+    float mcmc_runtime = model->simulator->simulate_runtime(
+        model,
+        strategy,
+        model_config.computationMode,
+        model_config.export_strategy_task_graph_file.empty()
+            ? ""
+            : model_config.export_strategy_task_graph_file + ".mcmc");
+    if (!model_config.export_strategy_task_graph_trace_file.empty()) {
+      model->simulator->export_task_graph_trace(
+          model_config.export_strategy_task_graph_trace_file + ".mcmc");
+    }
+    printf("MCMC strategy: simulated step time %.3f ms (PCG search: %.3f "
+           "ms)\n",
+           mcmc_runtime,
+           best_graph->optimal_cost());
+  }
+  if (!model_config.export_strategy_task_graph_file.empty() ||
+      !model_config.export_strategy_task_graph_trace_file.empty()) {
+    export_compiled_task_graph(
+        *((FFModel **)task->args), best_graph.get(), optimal_views);
+  }
+
+  if (model_config.perform_fusion) {
+    // Report how many ops of the chosen strategy apply_fusion can fold into
+    // their producer, e.g. to compare searches with and without
+    // --fusion-aware-search
+    int num_fused_ops = 0;
+    for (auto const &it : best_graph->inEdges) {
+      if (it.second.empty()) {
+        continue;
+      }
+      Node const &src = it.second.begin()->srcOp;
+      auto src_view = optimal_views.find(src);
+      auto dst_view = optimal_views.find(it.first);
+      if (src_view != optimal_views.end() && dst_view != optimal_views.end() &&
+          Simulator::can_fuse(
+              src.ptr, src_view->second, it.first.ptr, dst_view->second)) {
+        num_fused_ops++;
+      }
+    }
+    printf("Fusion-friendly ops in the optimal strategy (fusion-aware search "
+           "%s): %d of %zu\n",
+           model_config.search_fusion_aware ? "on" : "off",
+           num_fused_ops,
+           best_graph->inEdges.size());
+  }
+
+  // Serialize the optimized PCG.
+  // Only need best_graph and optimal_views below.
+  Serializer sez;
+  std::vector<size_t> offloaded_nodes, prefetch_nodes;
+  if (perform_memory_search) {
+    // Without a valid strategy, best_graph is the one found for lambda 0
+    MemorySearchResult const &result =
+        lambdas[has_valid_strategy ? best_lambda_index : 1].second;
+    offloaded_nodes = result.offloaded_nodes;
+    prefetch_nodes = result.prefetch_nodes;
+  }
+  serialize_graph_optimal_view(best_graph.get(),
+                               optimal_views,
+                               offloaded_nodes,
+                               prefetch_nodes,
+                               sez);
+  if (!model_config.export_strategy_file.empty()) {
+    if (!perform_serving_search) {
+      exported.batch_size = model_config.batchSize;
+      exported.comp_mode = model_config.computationMode;
+      exported.latency = best_graph->optimal_cost();
+      char const *buffer = (char const *)sez.get_buffer();
+      exported.graph_optimal_view.assign(buffer,
+                                         buffer + sez.get_used_bytes());
+    }
+    if (!exported.save(model_config.export_strategy_file)) {
+      fprintf(stderr,
+              "Cannot write the strategy file %s\n",
+              model_config.export_strategy_file.c_str());
+      assert(false);
+    }
+    printf("Exported the strategy for batch size %d to %s\n",
+           exported.batch_size,
+           model_config.export_strategy_file.c_str());
+  }
   assert(sez.get_used_bytes() < GraphOptimalViewSerialized::buffer_size);
   GraphOptimalViewSerialized ret;
   ret.total_bytes = sez.get_used_bytes();
@@ -2399,7 +2951,8 @@ void FFModel::construct_optimal_view(
 void FFModel::deserialize_graph_optimal_view(
     Legion::Deserializer &dez,
     Graph *graph,
-    std::unordered_map<Node, MachineView> &optimal_views) {
+    std::unordered_map<Node, MachineView> &optimal_views,
+    std::unordered_map<Node, Node> &offloaded_nodes) {
   // Deserializer dez(serialized.data, serialized.total_bytes);
   std::unordered_map<size_t, Node> guid_to_nodes;
   size_t num_nodes;
@@ -2498,7 +3051,8 @@ void FFModel::deserialize_graph_optimal_view(
       case OP_EMBEDDING: {
         assert(num_inputs == 1);
         AggrMode aggr;
-        int num_entries, out_channels;
+        EmbeddingMode mode;
+        int num_entries, out_channels, num_buckets, embed_dim;
         size_t id;
         DataType data_type;
         dez.deserialize(id);
@@ -2507,6 +3061,9 @@ void FFModel::deserialize_graph_optimal_view(
         dez.deserialize(out_channels);
         dez.deserialize(aggr);
         dez.deserialize(data_type);
+        dez.deserialize(mode);
+        dez.deserialize(num_buckets);
+        dez.deserialize(embed_dim);
 
         EmbeddingParams params;
         params.aggr = aggr;
@@ -2514,6 +3071,9 @@ void FFModel::deserialize_graph_optimal_view(
         params.out_channels = out_channels;
         params.layer_guid = layer_guid;
         params.data_type = data_type;
+        params.mode = mode;
+        params.num_buckets = num_buckets;
+        params.embed_dim = embed_dim;
         node = get_or_create_node<Embedding>(inputs[0], params);
         break;
       }
@@ -2564,6 +3124,14 @@ void FFModel::deserialize_graph_optimal_view(
         node = Gather::deserialize(*this, dez, inputs, num_inputs);
         break;
       }
+      case OP_DOT_INTERACTION: {
+        node = DotInteraction::deserialize(*this, dez, inputs, num_inputs);
+        break;
+      }
+      case OP_ELEMENT_EXPRESSION: {
+        node = ElementExpression::deserialize(*this, dez, inputs, num_inputs);
+        break;
+      }
       case OP_LAYERNORM: {
         node = LayerNorm::deserialize(*this, dez, inputs, num_inputs);
         break;
@@ -2648,6 +3216,14 @@ void FFModel::deserialize_graph_optimal_view(
         node = Transpose::deserialize(*this, dez, inputs, num_inputs);
         break;
       }
+      case OP_SLICE: {
+        node = Slice::deserialize(*this, dez, inputs, num_inputs);
+        break;
+      }
+      case OP_PAD: {
+        node = Pad::deserialize(*this, dez, inputs, num_inputs);
+        break;
+      }
       case OP_COMBINE: {
         assert(num_inputs == 1);
         int combine_dim, combine_degree;
@@ -2732,6 +3308,18 @@ void FFModel::deserialize_graph_optimal_view(
     dez.deserialize(view);
     optimal_views[guid_to_nodes[guid]] = view;
   }
+  // Third, deserialize the nodes whose outputs are offloaded, with the
+  // nodes before which they are prefetched
+  size_t num_offloaded;
+  dez.deserialize(num_offloaded);
+  for (size_t i = 0; i < num_offloaded; i++) {
+    size_t guid, prefetch_guid;
+    dez.deserialize(guid);
+    dez.deserialize(prefetch_guid);
+    assert(guid_to_nodes.find(guid) != guid_to_nodes.end());
+    assert(guid_to_nodes.find(prefetch_guid) != guid_to_nodes.end());
+    offloaded_nodes[guid_to_nodes[guid]] = guid_to_nodes[prefetch_guid];
+  }
   assert(dez.get_remaining_bytes() == 0);
   printf("Deserialized Views...\n");
   for (auto const &it : optimal_views) {
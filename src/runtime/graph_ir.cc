@@ -0,0 +1,661 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flexflow/graph_ir.h"
+#include "flexflow/model.h"
+#include <cassert>
+#include <climits>
+#include <cstring>
+#include <numeric>
+
+namespace FlexFlow {
+namespace GraphIR {
+
+int64_t Param::as_int() const {
+  switch (kind) {
+    case INT32:
+    case INT64:
+      return i;
+    case FLOAT:
+      return (int64_t)f;
+    default:
+      return std::stoll(s);
+  }
+}
+
+double Param::as_float() const {
+  switch (kind) {
+    case INT32:
+    case INT64:
+      return (double)i;
+    case FLOAT:
+      return f;
+    default:
+      return std::stod(s);
+  }
+}
+
+bool Param::as_bool() const {
+  if (kind == STRING) {
+    return s == "True" || s == "true" || s == "1";
+  }
+  return as_int() != 0;
+}
+
+namespace {
+
+// The IR is little-endian, as are all hosts FlexFlow runs on
+template <typename T>
+void write(std::vector<char> &buffer, T const &value) {
+  char const *bytes = reinterpret_cast<char const *>(&value);
+  buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+void write_ints(std::vector<char> &buffer, std::vector<int> const &values) {
+  assert(values.size() <= UINT16_MAX);
+  write<uint16_t>(buffer, values.size());
+  for (int v : values) {
+    write<uint32_t>(buffer, v);
+  }
+}
+
+class Reader {
+public:
+  Reader(char const *_buffer, size_t _size)
+      : buffer(_buffer), size(_size), offset(0) {}
+
+  template <typename T>
+  bool read(T &value) {
+    if (offset + sizeof(T) > size) {
+      return false;
+    }
+    memcpy(&value, buffer + offset, sizeof(T));
+    offset += sizeof(T);
+    return true;
+  }
+
+  bool read_string(std::string &value, size_t len) {
+    if (offset + len > size) {
+      return false;
+    }
+    value.assign(buffer + offset, len);
+    offset += len;
+    return true;
+  }
+
+  bool read_ints(std::vector<int> &values, size_t num_nodes) {
+    uint16_t n;
+    if (!read(n) || offset + (size_t)n * sizeof(uint32_t) > size) {
+      return false;
+    }
+    values.resize(n);
+    for (uint16_t i = 0; i < n; i++) {
+      uint32_t v = 0;
+      read(v);
+      if (v >= num_nodes) {
+        return false;
+      }
+      values[i] = v;
+    }
+    return true;
+  }
+
+  bool done() const {
+    return offset == size;
+  }
+
+private:
+  char const *buffer;
+  size_t size, offset;
+};
+
+// Fewest inputs and attributes build() reads for an op type; false if the
+// op type is not one build() supports
+bool get_arity(int op_type, size_t &min_inputs, size_t &min_params) {
+  min_inputs = 1;
+  min_params = 0;
+  switch (op_type) {
+    case INPUT:
+    case OUTPUT:
+      min_inputs = 0;
+      break;
+    case CONV2D:
+      min_params = 10;
+      break;
+    case POOL2D:
+      min_params = 5;
+      break;
+    case LINEAR:
+      min_params = 3;
+      break;
+    case EMBEDDING:
+    case TRANSPOSE:
+      min_params = 2;
+      break;
+    case DROPOUT:
+    case SCALAR_ADD:
+    case SCALAR_SUB:
+    case SCALAR_MULTIPLY:
+    case SCALAR_TRUEDIV:
+    case CONCAT:
+    case SPLIT:
+    case GETITEM:
+    case UNSQUEEZE:
+    case PAD:
+    case POW:
+    case MEAN:
+      min_params = 1;
+      break;
+    case ADD:
+    case SUBTRACT:
+    case MULTIPLY:
+    case BATCH_MATMUL:
+      min_inputs = 2;
+      break;
+    case BATCH_NORM:
+    case SOFTMAX:
+    case FLAT:
+    case RELU:
+    case IDENTITY:
+    case GELU:
+    case SIGMOID:
+    case TANH:
+    case ELU:
+    case PERMUTE:
+    case RESHAPE:
+    case VIEW:
+    case SLICE:
+    case RSQRT:
+    case FLOAT:
+    case CONTIGUOUS:
+    case TO:
+    case TYPE_AS:
+      break;
+    default:
+      return false;
+  }
+  return true;
+}
+
+} // namespace
+
+std::vector<char> Graph::serialize() const {
+  std::vector<char> buffer;
+  buffer.insert(buffer.end(), {'F', 'F', 'I', 'R'});
+  write<uint32_t>(buffer, VERSION);
+  write<uint32_t>(buffer, nodes.size());
+  for (Node const &node : nodes) {
+    write<uint16_t>(buffer, node.op_type);
+    assert(node.name.size() <= UINT16_MAX);
+    write<uint16_t>(buffer, node.name.size());
+    buffer.insert(buffer.end(), node.name.begin(), node.name.end());
+    write_ints(buffer, node.inputs);
+    write_ints(buffer, node.outputs);
+    assert(node.params.size() <= UINT8_MAX);
+    write<uint8_t>(buffer, node.params.size());
+    for (Param const &p : node.params) {
+      // Integers that fit take the short encoding
+      bool short_int = (p.kind == Param::INT32 || p.kind == Param::INT64) &&
+                       p.i >= INT32_MIN && p.i <= INT32_MAX;
+      write<uint8_t>(buffer, short_int ? Param::INT32 : p.kind);
+      switch (p.kind) {
+        case Param::INT32:
+        case Param::INT64:
+          if (short_int) {
+            write<int32_t>(buffer, p.i);
+          } else {
+            write<int64_t>(buffer, p.i);
+          }
+          break;
+        case Param::FLOAT:
+          write<double>(buffer, p.f);
+          break;
+        case Param::STRING:
+          assert(p.s.size() <= UINT16_MAX);
+          write<uint16_t>(buffer, p.s.size());
+          buffer.insert(buffer.end(), p.s.begin(), p.s.end());
+          break;
+      }
+    }
+  }
+  return buffer;
+}
+
+bool Graph::deserialize(char const *buffer, size_t size, Graph &graph) {
+  Reader reader(buffer, size);
+  std::string magic;
+  uint32_t version, num_nodes;
+  if (!reader.read_string(magic, 4) || magic != "FFIR" ||
+      !reader.read(version) || version != VERSION || !reader.read(num_nodes)) {
+    return false;
+  }
+  graph.nodes.clear();
+  graph.nodes.resize(num_nodes);
+  for (Node &node : graph.nodes) {
+    uint16_t op_type, name_len;
+    uint8_t num_params;
+    if (!reader.read(op_type) || !reader.read(name_len) ||
+        !reader.read_string(node.name, name_len) ||
+        !reader.read_ints(node.inputs, num_nodes) ||
+        !reader.read_ints(node.outputs, num_nodes) ||
+        !reader.read(num_params)) {
+      return false;
+    }
+    node.op_type = op_type;
+    node.params.resize(num_params);
+    for (Param &p : node.params) {
+      uint8_t kind;
+      uint16_t len;
+      int32_t i32 = 0;
+      if (!reader.read(kind)) {
+        return false;
+      }
+      bool ok = false;
+      switch (kind) {
+        case Param::INT32:
+          ok = reader.read(i32);
+          p.i = i32;
+          break;
+        case Param::INT64:
+          ok = reader.read(p.i);
+          break;
+        case Param::FLOAT:
+          ok = reader.read(p.f);
+          break;
+        case Param::STRING:
+          ok = reader.read(len) && reader.read_string(p.s, len);
+          break;
+      }
+      if (!ok) {
+        return false;
+      }
+      p.kind = (Param::Kind)kind;
+    }
+    // Unsupported op types are left to build(), which names the node
+    size_t min_inputs, min_params;
+    if (get_arity(node.op_type, min_inputs, min_params) &&
+        (node.inputs.size() < min_inputs ||
+         node.params.size() < min_params)) {
+      return false;
+    }
+  }
+  return reader.done();
+}
+
+namespace {
+
+// Dimensions in the order of the Python API (outermost first)
+std::vector<int> get_dims(Tensor const t) {
+  std::vector<int> dims(t->num_dims);
+  for (int i = 0; i < t->num_dims; i++) {
+    dims[i] = t->dims[t->num_dims - 1 - i];
+  }
+  return dims;
+}
+
+std::vector<int> get_int_params(Node const &node, size_t first = 0) {
+  std::vector<int> values;
+  for (size_t i = first; i < node.params.size(); i++) {
+    values.push_back(node.params[i].as_int());
+  }
+  return values;
+}
+
+// Infer the -1 dimension of a view, see FunctionNode.get_view_shape
+std::vector<int> get_view_shape(Tensor const input,
+                                 std::vector<int> shape) {
+  std::vector<int> dims = get_dims(input);
+  size_t numel = std::accumulate(
+      dims.begin(), dims.end(), (size_t)1, std::multiplies<size_t>());
+  size_t new_numel = 1;
+  int infer_dim = -1;
+  for (size_t i = 0; i < shape.size(); i++) {
+    if (shape[i] == -1) {
+      assert(infer_dim < 0 && "Cannot infer more than one dimension");
+      infer_dim = i;
+    } else {
+      assert(shape[i] >= 0);
+      new_numel *= shape[i];
+    }
+  }
+  if (infer_dim >= 0) {
+    assert(new_numel > 0 && numel % new_numel == 0);
+    shape[infer_dim] = numel / new_numel;
+  } else {
+    assert(numel == new_numel && "Invalid view shape");
+  }
+  return shape;
+}
+
+} // namespace
+
+void build(FFModel &model,
+           Graph const &graph,
+           std::vector<Tensor> const &inputs,
+           std::vector<Tensor> &outputs,
+           std::vector<LayerInfo> &layers) {
+  std::vector<std::vector<Tensor>> results(graph.nodes.size());
+  size_t input_index = 0;
+  for (size_t idx = 0; idx < graph.nodes.size(); idx++) {
+    Node const &node = graph.nodes[idx];
+    char const *name = node.name.empty() ? NULL : node.name.c_str();
+    std::vector<Param> const &p = node.params;
+    std::vector<Tensor> in;
+    for (int i : node.inputs) {
+      assert(i < (int)idx && "Graph IR nodes must be in topological order");
+      in.insert(in.end(), results[i].begin(), results[i].end());
+    }
+    // An input node can yield no tensors, e.g. an OUTPUT node
+    size_t min_inputs, min_params;
+    if (get_arity(node.op_type, min_inputs, min_params)) {
+      assert(in.size() >= min_inputs && p.size() >= min_params &&
+             "Graph IR node has too few inputs or attributes");
+    }
+    std::vector<Tensor> &out = results[idx];
+    // The layer added is not always the one of the node, e.g. views are
+    // imported as reshapes
+    int layer_op_type = node.op_type;
+    size_t num_layers = model.layers.size();
+    switch (node.op_type) {
+      case INPUT: {
+        assert(input_index < inputs.size());
+        out.push_back(inputs[input_index++]);
+        break;
+      }
+      case OUTPUT: {
+        outputs.insert(outputs.end(), in.begin(), in.end());
+        break;
+      }
+      case LINEAR: {
+        out.push_back(model.dense(in[0],
+                                  p[0].as_int(),
+                                  (ActiMode)p[1].as_int(),
+                                  p[2].as_bool(),
+                                  DT_FLOAT,
+                                  NULL,
+                                  NULL,
+                                  NULL,
+                                  name));
+        break;
+      }
+      case CONV2D: {
+        out.push_back(model.conv2d(in[0],
+                                   p[0].as_int(),
+                                   p[1].as_int(),
+                                   p[2].as_int(),
+                                   p[3].as_int(),
+                                   p[4].as_int(),
+                                   p[5].as_int(),
+                                   p[6].as_int(),
+                                   (ActiMode)p[7].as_int(),
+                                   p[8].as_int(),
+                                   p[9].as_bool(),
+                                   NULL,
+                                   NULL,
+                                   NULL,
+                                   name));
+        break;
+      }
+      case POOL2D: {
+        int kernel = p[0].as_int(), stride = p[1].as_int(),
+            padding = p[2].as_int();
+        out.push_back(model.pool2d(in[0],
+                                   kernel,
+                                   kernel,
+                                   stride,
+                                   stride,
+                                   padding,
+                                   padding,
+                                   (PoolType)p[3].as_int(),
+                                   (ActiMode)p[4].as_int(),
+                                   name));
+        break;
+      }
+      case BATCH_NORM: {
+        out.push_back(model.batch_norm(in[0], true, name));
+        break;
+      }
+      case SOFTMAX: {
+        out.push_back(model.softmax(in[0], -1, name));
+        break;
+      }
+      case DROPOUT: {
+        out.push_back(model.dropout(in[0], p[0].as_float(), 0, name));
+        break;
+      }
+      case FLAT: {
+        out.push_back(model.flat(in[0], name));
+        break;
+      }
+      case RELU: {
+        out.push_back(model.relu(in[0], true, name));
+        break;
+      }
+      case IDENTITY: {
+        out.push_back(model.identity(in[0], name));
+        break;
+      }
+      case GELU: {
+        out.push_back(model.gelu(in[0], name));
+        break;
+      }
+      case SIGMOID: {
+        out.push_back(model.sigmoid(in[0], name));
+        break;
+      }
+      case TANH: {
+        out.push_back(model.tanh(in[0], name));
+        break;
+      }
+      case ELU: {
+        out.push_back(model.elu(in[0], true, name));
+        break;
+      }
+      case EMBEDDING: {
+        // Same initializer as the PyTorch front-end; owned by the model
+        // like the ones created through the C API
+        Initializer *kernel_initializer = new NormInitializer(42, 0, 1);
+        out.push_back(model.embedding(in[0],
+                                      p[0].as_int(),
+                                      p[1].as_int(),
+                                      AGGR_MODE_NONE,
+                                      DT_FLOAT,
+                                      NULL,
+                                      kernel_initializer,
+                                      name));
+        break;
+      }
+      case SCALAR_ADD: {
+        out.push_back(model.scalar_add(in[0], p[0].as_float(), true, name));
+        break;
+      }
+      case SCALAR_SUB: {
+        out.push_back(model.scalar_sub(in[0], p[0].as_float(), true, name));
+        break;
+      }
+      case SCALAR_MULTIPLY: {
+        out.push_back(
+            model.scalar_multiply(in[0], p[0].as_float(), true, name));
+        break;
+      }
+      case SCALAR_TRUEDIV: {
+        out.push_back(
+            model.scalar_truediv(in[0], p[0].as_float(), true, name));
+        break;
+      }
+      case ADD: {
+        out.push_back(model.add(in[0], in[1], false, name));
+        break;
+      }
+      case SUBTRACT: {
+        out.push_back(model.subtract(in[0], in[1], false, name));
+        break;
+      }
+      case MULTIPLY: {
+        out.push_back(model.multiply(in[0], in[1], false, name));
+        break;
+      }
+      case CONCAT: {
+        out.push_back(model.concat(in.size(), in.data(), p[0].as_int(), name));
+        break;
+      }
+      case SPLIT: {
+        // Either explicit sizes or an even split into one part per user
+        int axis = p[0].as_int();
+        std::vector<int> sizes = get_int_params(node, 1);
+        if (sizes.empty()) {
+          int n = node.outputs.size();
+          int dim = get_dims(in[0])[axis];
+          assert(n > 0 && dim % n == 0 && "Split dimension is not divisible");
+          sizes.assign(n, dim / n);
+        }
+        out.resize(sizes.size());
+        model.split(in[0], out.data(), sizes, axis, name);
+        break;
+      }
+      case GETITEM: {
+        // Only indexing the outputs of a multi-output node is supported;
+        // slicing goes through the string IR
+        assert(node.inputs.size() == 1);
+        std::vector<Tensor> const &tuple = results[node.inputs[0]];
+        int64_t index = p[0].as_int();
+        assert(index >= 0 && index < (int64_t)tuple.size());
+        out.push_back(tuple[index]);
+        break;
+      }
+      case BATCH_MATMUL: {
+        out.push_back(model.batch_matmul(in[0], in[1], -1, -1, name));
+        break;
+      }
+      case TRANSPOSE: {
+        std::vector<int> perm(in[0]->num_dims);
+        std::iota(perm.begin(), perm.end(), 0);
+        // Negative dims count from the end, as in Python
+        int dim0 = p[0].as_int(), dim1 = p[1].as_int();
+        dim0 += dim0 < 0 ? in[0]->num_dims : 0;
+        dim1 += dim1 < 0 ? in[0]->num_dims : 0;
+        assert(dim0 >= 0 && dim0 < in[0]->num_dims);
+        assert(dim1 >= 0 && dim1 < in[0]->num_dims);
+        std::swap(perm[dim0], perm[dim1]);
+        out.push_back(model.transpose(in[0], perm, name));
+        break;
+      }
+      case PERMUTE: {
+        layer_op_type = TRANSPOSE;
+        out.push_back(model.transpose(in[0], get_int_params(node), name));
+        break;
+      }
+      case RESHAPE: {
+        out.push_back(model.reshape(in[0], get_int_params(node), name));
+        break;
+      }
+      case VIEW: {
+        layer_op_type = RESHAPE;
+        std::vector<int> shape = get_view_shape(in[0], get_int_params(node));
+        out.push_back(model.reshape(in[0], shape, name));
+        break;
+      }
+      case UNSQUEEZE: {
+        layer_op_type = RESHAPE;
+        std::vector<int> shape = get_dims(in[0]);
+        // Same position as Python's list.insert
+        int dim = p[0].as_int();
+        if (dim < 0) {
+          dim = std::max(0, dim + (int)shape.size());
+        }
+        dim = std::min(dim, (int)shape.size());
+        shape.insert(shape.begin() + dim, 1);
+        out.push_back(model.reshape(in[0], shape, name));
+        break;
+      }
+      case SLICE: {
+        // (axis, start, end) of each sliced dim; the others are kept whole
+        int num_dims = in[0]->num_dims;
+        std::vector<int> starts, ends;
+        for (size_t i = 0; i + 2 < p.size(); i += 3) {
+          int axis = p[i].as_int();
+          if (axis < 0) {
+            axis += num_dims;
+          }
+          assert(axis >= 0 && axis < num_dims);
+          if ((int)starts.size() <= axis) {
+            starts.resize(axis + 1, 0);
+            ends.resize(axis + 1, INT_MAX);
+          }
+          starts[axis] = p[i + 1].as_int();
+          ends[axis] = p[i + 2].as_int();
+        }
+        out.push_back(model.slice(in[0], starts, ends, name));
+        break;
+      }
+      case PAD: {
+        // The pads before each dim, then after each dim, then the value
+        int num_dims = in[0]->num_dims;
+        assert((int)p.size() == 2 * num_dims + 1);
+        std::vector<int> before, after;
+        for (int i = 0; i < num_dims; i++) {
+          before.push_back(p[i].as_int());
+          after.push_back(p[num_dims + i].as_int());
+        }
+        out.push_back(
+            model.pad(in[0], before, after, p.back().as_float(), name));
+        break;
+      }
+      case POW: {
+        out.push_back(model.pow(in[0], p[0].as_float(), true, name));
+        break;
+      }
+      case MEAN: {
+        int dim = p[0].as_int();
+        if (dim == -1) {
+          dim = in[0]->num_dims - 1;
+        }
+        assert(dim >= 0 && dim < in[0]->num_dims);
+        bool keepdims = p.size() >= 2 && p[1].as_bool();
+        out.push_back(
+            model.mean(in[0], std::vector<int>(1, dim), keepdims, name));
+        break;
+      }
+      case RSQRT: {
+        out.push_back(model.rsqrt(in[0], true, name));
+        break;
+      }
+      case FLOAT:
+      case CONTIGUOUS:
+      case TO:
+      case TYPE_AS: {
+        out.push_back(in[0]);
+        break;
+      }
+      default: {
+        fprintf(stderr,
+                "Graph IR node %s has unsupported op type %d\n",
+                node.name.c_str(),
+                node.op_type);
+        assert(false);
+      }
+    }
+    for (size_t i = num_layers; i < model.layers.size(); i++) {
+      LayerInfo info;
+      info.node = idx;
+      info.op_type = layer_op_type;
+      layers.push_back(info);
+    }
+  }
+  assert(input_index == inputs.size());
+}
+
+} // namespace GraphIR
+} // namespace FlexFlow
@@ -0,0 +1,368 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flexflow/image_augmentation.h"
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+namespace FlexFlow {
+
+namespace {
+
+uint64_t splitmix64(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+bool read_file(std::string const &path, std::vector<uint8_t> &data) {
+  std::ifstream file(path.c_str(), std::ios::binary);
+  if (!file) {
+    return false;
+  }
+  data.assign(std::istreambuf_iterator<char>(file),
+              std::istreambuf_iterator<char>());
+  return true;
+}
+
+// Skip whitespace and comments, then parse a decimal header field
+bool read_pnm_field(uint8_t const *data, size_t size, size_t &pos, int &value) {
+  while (pos < size) {
+    if (data[pos] == '#') {
+      while (pos < size && data[pos] != '\n') {
+        pos++;
+      }
+    } else if (std::isspace(data[pos])) {
+      pos++;
+    } else {
+      break;
+    }
+  }
+  if (pos >= size || !std::isdigit(data[pos])) {
+    return false;
+  }
+  value = 0;
+  while (pos < size && std::isdigit(data[pos])) {
+    value = value * 10 + (data[pos++] - '0');
+    if (value > (1 << 24)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+bool decode_pnm(uint8_t const *data, size_t size, Image &image) {
+  if (size < 2 || data[0] != 'P' || (data[1] != '5' && data[1] != '6')) {
+    return false;
+  }
+  int channels = data[1] == '6' ? 3 : 1;
+  size_t pos = 2;
+  int width, height, maxval;
+  if (!read_pnm_field(data, size, pos, width) ||
+      !read_pnm_field(data, size, pos, height) ||
+      !read_pnm_field(data, size, pos, maxval) || width <= 0 || height <= 0 ||
+      maxval <= 0 || maxval > 255) {
+    return false;
+  }
+  // A single whitespace character separates the header from the samples
+  if (pos >= size || !std::isspace(data[pos])) {
+    return false;
+  }
+  pos++;
+  size_t num_bytes = (size_t)width * height * channels;
+  if (size - pos < num_bytes) {
+    return false;
+  }
+  image.height = height;
+  image.width = width;
+  image.channels = channels;
+  image.pixels.assign(data + pos, data + pos + num_bytes);
+  if (maxval != 255) {
+    for (uint8_t &p : image.pixels) {
+      p = (uint8_t)std::min(255, p * 255 / maxval);
+    }
+  }
+  return true;
+}
+
+CifarBinarySource::CifarBinarySource(std::string const &path) {
+  if (!read_file(path, data)) {
+    fprintf(stderr, "Cannot open CIFAR file %s\n", path.c_str());
+    assert(false);
+  }
+  assert(data.size() % kRecordSize == 0);
+}
+
+size_t CifarBinarySource::num_samples() const {
+  return data.size() / kRecordSize;
+}
+
+void CifarBinarySource::read(size_t index, Image &image, int &label) const {
+  assert(index < num_samples());
+  uint8_t const *record = data.data() + index * kRecordSize;
+  label = record[0];
+  image.height = image.width = kSide;
+  image.channels = 3;
+  image.pixels.resize(3 * kSide * kSide);
+  // Records are planar
+  for (int c = 0; c < 3; c++) {
+    for (int i = 0; i < kSide * kSide; i++) {
+      image.pixels[i * 3 + c] = record[1 + c * kSide * kSide + i];
+    }
+  }
+}
+
+ImageListSource::ImageListSource(std::string const &list_file) {
+  std::ifstream file(list_file.c_str());
+  if (!file) {
+    fprintf(stderr, "Cannot open image list %s\n", list_file.c_str());
+    assert(false);
+  }
+  std::string dir;
+  size_t slash = list_file.find_last_of('/');
+  if (slash != std::string::npos) {
+    dir = list_file.substr(0, slash + 1);
+  }
+  std::string line;
+  while (std::getline(file, line)) {
+    std::istringstream iss(line);
+    std::string path;
+    int label;
+    if (!(iss >> path >> label)) {
+      continue;
+    }
+    paths.push_back(path[0] == '/' ? path : dir + path);
+    labels.push_back(label);
+  }
+}
+
+size_t ImageListSource::num_samples() const {
+  return paths.size();
+}
+
+void ImageListSource::read(size_t index, Image &image, int &label) const {
+  assert(index < num_samples());
+  std::vector<uint8_t> data;
+  if (!read_file(paths[index], data) ||
+      !decode_pnm(data.data(), data.size(), image)) {
+    fprintf(stderr, "Cannot decode image %s\n", paths[index].c_str());
+    assert(false);
+  }
+  label = labels[index];
+}
+
+SyntheticImageSource::SyntheticImageSource(
+    size_t _num_samples, int _height, int _width, int _channels, int _labels)
+    : size(_num_samples), height(_height), width(_width), channels(_channels),
+      num_labels(_labels) {
+  assert(num_labels > 0);
+}
+
+size_t SyntheticImageSource::num_samples() const {
+  return size;
+}
+
+void SyntheticImageSource::read(size_t index, Image &image, int &label) const {
+  assert(index < size);
+  image.height = height;
+  image.width = width;
+  image.channels = channels;
+  image.pixels.resize((size_t)height * width * channels);
+  uint64_t state = splitmix64(index);
+  label = (int)(state % num_labels);
+  for (size_t i = 0; i < image.pixels.size(); i++) {
+    if (i % 8 == 0) {
+      state = splitmix64(state);
+    }
+    image.pixels[i] = (uint8_t)(state >> (8 * (i % 8)));
+  }
+}
+
+std::unique_ptr<ImageSource> open_image_source(std::string const &path,
+                                               size_t num_synthetic_samples,
+                                               int height,
+                                               int width,
+                                               int num_labels) {
+  if (path.empty()) {
+    return std::unique_ptr<ImageSource>(new SyntheticImageSource(
+        num_synthetic_samples, height, width, 3, num_labels));
+  }
+  if (path.size() > 4 && path.compare(path.size() - 4, 4, ".bin") == 0) {
+    return std::unique_ptr<ImageSource>(new CifarBinarySource(path));
+  }
+  return std::unique_ptr<ImageSource>(new ImageListSource(path));
+}
+
+void augment_image(Image const &image,
+                   ImageAugmentation const &aug,
+                   uint64_t seed,
+                   float *output) {
+  assert(image.height > 0 && image.width > 0);
+  assert(image.channels == 1 || image.channels == aug.channels);
+  std::mt19937_64 rng(seed);
+  std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+  // Crop window
+  float x0 = 0.0f, y0 = 0.0f;
+  float crop_w = image.width, crop_h = image.height;
+  if (aug.random_crop) {
+    float const area = (float)image.width * image.height;
+    float const log_min = std::log(3.0f / 4.0f),
+                log_max = std::log(4.0f / 3.0f);
+    for (int attempt = 0; attempt < 10; attempt++) {
+      float target =
+          area * (aug.min_crop_area + (1.0f - aug.min_crop_area) * uniform(rng));
+      float ratio = std::exp(log_min + (log_max - log_min) * uniform(rng));
+      int w = (int)std::round(std::sqrt(target * ratio));
+      int h = (int)std::round(std::sqrt(target / ratio));
+      if (w > 0 && h > 0 && w <= image.width && h <= image.height) {
+        x0 = std::min(std::floor(uniform(rng) * (image.width - w + 1)),
+                      (float)(image.width - w));
+        y0 = std::min(std::floor(uniform(rng) * (image.height - h + 1)),
+                      (float)(image.height - h));
+        crop_w = w;
+        crop_h = h;
+        break;
+      }
+    }
+  }
+  bool flip = aug.random_flip && uniform(rng) < 0.5f;
+  // Bilinear resize of the window, sampling at pixel centers
+  float const scale_x = crop_w / aug.width, scale_y = crop_h / aug.height;
+  std::vector<int> xs0(aug.width), xs1(aug.width);
+  std::vector<float> wx(aug.width);
+  for (int x = 0; x < aug.width; x++) {
+    int src_x = flip ? aug.width - 1 - x : x;
+    float fx = x0 + (src_x + 0.5f) * scale_x - 0.5f;
+    fx = std::min(std::max(fx, x0), x0 + crop_w - 1);
+    xs0[x] = (int)fx;
+    xs1[x] = std::min(xs0[x] + 1, image.width - 1);
+    wx[x] = fx - xs0[x];
+  }
+  size_t const plane = (size_t)aug.height * aug.width;
+  for (int c = 0; c < aug.channels; c++) {
+    int src_c = image.channels == 1 ? 0 : c;
+    float mean = c < (int)aug.mean.size() ? aug.mean[c] : 0.0f;
+    float stddev = c < (int)aug.stddev.size() ? aug.stddev[c] : 1.0f;
+    float const a = 1.0f / (255.0f * stddev), b = -mean / stddev;
+    for (int y = 0; y < aug.height; y++) {
+      float fy = y0 + (y + 0.5f) * scale_y - 0.5f;
+      fy = std::min(std::max(fy, y0), y0 + crop_h - 1);
+      int y_lo = (int)fy, y_hi = std::min(y_lo + 1, image.height - 1);
+      float wy = fy - y_lo;
+      uint8_t const *row_lo =
+          image.pixels.data() + (size_t)y_lo * image.width * image.channels;
+      uint8_t const *row_hi =
+          image.pixels.data() + (size_t)y_hi * image.width * image.channels;
+      float *out = output + c * plane + (size_t)y * aug.width;
+      for (int x = 0; x < aug.width; x++) {
+        int i0 = xs0[x] * image.channels + src_c;
+        int i1 = xs1[x] * image.channels + src_c;
+        float top = row_lo[i0] + wx[x] * (row_lo[i1] - row_lo[i0]);
+        float bottom = row_hi[i0] + wx[x] * (row_hi[i1] - row_hi[i0]);
+        out[x] = (top + wy * (bottom - top)) * a + b;
+      }
+    }
+  }
+}
+
+ImageBatchPipeline::ImageBatchPipeline(std::unique_ptr<ImageSource> _source,
+                                       ImageAugmentation const &_aug,
+                                       int num_workers)
+    : source(std::move(_source)), aug(_aug) {
+  assert(num_workers >= 1);
+  for (int i = 1; i < num_workers; i++) {
+    workers.emplace_back(&ImageBatchPipeline::worker_loop, this);
+  }
+}
+
+ImageBatchPipeline::~ImageBatchPipeline() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  work_ready.notify_all();
+  for (std::thread &t : workers) {
+    t.join();
+  }
+}
+
+void ImageBatchPipeline::load_batch(std::vector<size_t> const &indices,
+                                    uint64_t seed,
+                                    float *images,
+                                    int32_t *labels) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    assert(batch_indices == nullptr && "one batch at a time");
+    batch_indices = &indices;
+    batch_seed = seed;
+    batch_images = images;
+    batch_labels = labels;
+    next_sample = samples_done = 0;
+    generation++;
+  }
+  work_ready.notify_all();
+  process_samples();
+  std::unique_lock<std::mutex> lock(mutex);
+  work_done.wait(lock, [&] { return samples_done == indices.size(); });
+  batch_indices = nullptr;
+}
+
+void ImageBatchPipeline::worker_loop() {
+  uint64_t seen = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      work_ready.wait(lock, [&] { return stopping || generation != seen; });
+      if (stopping) {
+        return;
+      }
+      seen = generation;
+    }
+    process_samples();
+  }
+}
+
+void ImageBatchPipeline::process_samples() {
+  Image image;
+  size_t const sample_size = (size_t)aug.channels * aug.height * aug.width;
+  std::unique_lock<std::mutex> lock(mutex);
+  while (batch_indices != nullptr && next_sample < batch_indices->size()) {
+    size_t i = next_sample++;
+    size_t index = (*batch_indices)[i];
+    uint64_t seed = splitmix64(batch_seed ^ splitmix64(i));
+    float *output = batch_images + i * sample_size;
+    int32_t *label = batch_labels + i;
+    lock.unlock();
+    int l;
+    source->read(index, image, l);
+    augment_image(image, aug, seed, output);
+    *label = l;
+    lock.lock();
+    if (++samples_done == batch_indices->size()) {
+      work_done.notify_all();
+    }
+  }
+}
+
+} // namespace FlexFlow
@@ -0,0 +1,234 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flexflow/accessor.h"
+#include "flexflow/image_data_loader.h"
+#include "legion/legion_utilities.h"
+#include <algorithm>
+#include <random>
+
+namespace FlexFlow {
+
+using namespace Legion;
+
+LegionRuntime::Logger::Category log_image_dl("ImageDataLoader");
+
+namespace {
+
+// Pipelines of the loaders of this process, indexed by loader id. Every
+// shard of a control-replicated top-level task creates its loaders in the
+// same order, so the ids agree across nodes.
+std::mutex pipelines_mutex;
+std::vector<std::unique_ptr<ImageBatchPipeline>> pipelines;
+
+ParallelTensor create_staging_tensor(FFModel &ff, ParallelTensor batch) {
+  // The staging buffer holds a single replica of the whole batch
+  ParallelDim dims[MAX_TENSOR_DIM];
+  for (int i = 0; i < batch->num_dims; i++) {
+    dims[i].size = batch->dims[i].is_replica_dim ? 1 : batch->dims[i].size;
+    dims[i].degree = 1;
+    dims[i].parallel_idx = -1;
+    dims[i].is_replica_dim = batch->dims[i].is_replica_dim;
+  }
+  ParallelTensor staging = ff.create_parallel_tensor_legion_ordering(
+      batch->num_dims, dims, batch->data_type, NULL, 0, false /*create_grad*/);
+  ff.map_tensor(staging, NULL /*parallel_op*/);
+  return staging;
+}
+
+} // namespace
+
+ImageDataLoader::ImageDataLoader(FFModel &_ff,
+                                 ParallelTensor input,
+                                 ParallelTensor label,
+                                 std::unique_ptr<ImageSource> source,
+                                 ImageAugmentation const &_aug,
+                                 int num_workers,
+                                 bool _shuffle)
+    : ff(_ff), batch_input(input), batch_label(label), shuffle(_shuffle) {
+  // input: [W, H, C, N, replica], label: [1, N, replica]
+  assert(input->num_dims == 5 && input->data_type == DT_FLOAT);
+  assert(label->num_dims == 3 && label->data_type == DT_INT32);
+  assert(input->dims[4].is_replica_dim && label->dims[2].is_replica_dim);
+  int batch_size = input->dims[3].size;
+  assert(label->dims[1].size == batch_size && label->dims[0].size == 1);
+  ImageAugmentation aug = _aug;
+  aug.width = input->dims[0].size;
+  aug.height = input->dims[1].size;
+  aug.channels = input->dims[2].size;
+  num_samples = source->num_samples();
+  num_batches = num_samples / batch_size;
+  assert(num_batches > 0);
+  ff.retain_tensor(batch_input);
+  ff.retain_tensor(batch_label);
+  for (int i = 0; i < 2; i++) {
+    staging_input[i] = create_staging_tensor(ff, input);
+    staging_label[i] = create_staging_tensor(ff, label);
+  }
+  {
+    std::lock_guard<std::mutex> lock(pipelines_mutex);
+    loader_id = pipelines.size();
+    pipelines.emplace_back(
+        new ImageBatchPipeline(std::move(source), aug, num_workers));
+  }
+  order.resize(num_samples);
+  for (size_t i = 0; i < num_samples; i++) {
+    order[i] = i;
+  }
+  log_image_dl.print("%zu samples, %d batches of %d %dx%dx%d images, "
+                     "%d workers",
+                     num_samples,
+                     num_batches,
+                     batch_size,
+                     aug.channels,
+                     aug.height,
+                     aug.width,
+                     num_workers);
+}
+
+ImageDataLoader::~ImageDataLoader() {
+  // Outstanding fills may still use the pipeline
+  for (int i = 0; i < 2; i++) {
+    if (last_fill[i].exists()) {
+      last_fill[i].get_void_result();
+    }
+  }
+  ff.release_tensor(batch_input);
+  ff.release_tensor(batch_label);
+  std::lock_guard<std::mutex> lock(pipelines_mutex);
+  pipelines[loader_id].reset();
+}
+
+void ImageDataLoader::reset(void) {
+  if (shuffle) {
+    std::mt19937_64 rng(epoch);
+    std::shuffle(order.begin(), order.end(), rng);
+  }
+  epoch++;
+  next_index = 0;
+  launch_fill(0);
+}
+
+void ImageDataLoader::next_batch(FFModel &) {
+  assert(next_index < num_batches && "reset() starts a new epoch");
+  int buffer = next_index % 2;
+  launch_load(batch_input, staging_input[buffer], IMAGE_DL_LOAD_INPUT_TASK_ID);
+  launch_load(batch_label, staging_label[buffer], IMAGE_DL_LOAD_LABEL_TASK_ID);
+  next_index++;
+  if (next_index < num_batches) {
+    launch_fill(next_index % 2);
+  }
+}
+
+void ImageDataLoader::launch_fill(int buffer) {
+  Context ctx = ff.config.lg_ctx;
+  Runtime *runtime = ff.config.lg_hlr;
+  int batch_size = batch_input->dims[3].size;
+  Serializer sez;
+  sez.serialize(loader_id);
+  sez.serialize((uint64_t)epoch << 32 | next_index);
+  sez.serialize(batch_size);
+  for (int i = 0; i < batch_size; i++) {
+    sez.serialize((uint64_t)order[next_index * batch_size + i]);
+  }
+  TaskLauncher launcher(IMAGE_DL_FILL_TASK_ID,
+                        TaskArgument(sez.get_buffer(), sez.get_used_bytes()));
+  // regions[0]: staging input
+  launcher.add_region_requirement(
+      RegionRequirement(staging_input[buffer]->region,
+                        WRITE_DISCARD,
+                        EXCLUSIVE,
+                        staging_input[buffer]->region,
+                        MAP_TO_ZC_MEMORY));
+  launcher.add_field(0, FID_DATA);
+  // regions[1]: staging label
+  launcher.add_region_requirement(
+      RegionRequirement(staging_label[buffer]->region,
+                        WRITE_DISCARD,
+                        EXCLUSIVE,
+                        staging_label[buffer]->region,
+                        MAP_TO_ZC_MEMORY));
+  launcher.add_field(1, FID_DATA);
+  last_fill[buffer] = runtime->execute_task(ctx, launcher);
+}
+
+void ImageDataLoader::launch_load(ParallelTensor batch,
+                                  ParallelTensor staging,
+                                  int task_id) {
+  Context ctx = ff.config.lg_ctx;
+  Runtime *runtime = ff.config.lg_hlr;
+  IndexLauncher launcher(task_id,
+                         batch->parallel_is,
+                         TaskArgument(NULL, 0),
+                         ArgumentMap(),
+                         Predicate::TRUE_PRED,
+                         false /*must*/,
+                         0 /*mapper_id*/,
+                         batch->machine_view.hash());
+  launcher.add_region_requirement(RegionRequirement(staging->region,
+                                                    0 /*projection id*/,
+                                                    READ_ONLY,
+                                                    EXCLUSIVE,
+                                                    staging->region,
+                                                    MAP_TO_ZC_MEMORY));
+  launcher.add_field(0, FID_DATA);
+  launcher.add_region_requirement(RegionRequirement(batch->part,
+                                                    0 /*projection id*/,
+                                                    WRITE_ONLY,
+                                                    EXCLUSIVE,
+                                                    batch->region));
+  launcher.add_field(1, FID_DATA);
+  runtime->execute_index_space(ctx, launcher);
+}
+
+/*
+  regions[0](O): staging input
+  regions[1](O): staging label
+*/
+void ImageDataLoader::fill_batch_task(Task const *task,
+                                      std::vector<PhysicalRegion> const &regions,
+                                      Context ctx,
+                                      Runtime *runtime) {
+  assert(regions.size() == 2);
+  assert(task->regions.size() == regions.size());
+  Deserializer dez(task->args, task->arglen);
+  int loader_id, batch_size;
+  uint64_t seed;
+  dez.deserialize(loader_id);
+  dez.deserialize(seed);
+  dez.deserialize(batch_size);
+  std::vector<size_t> indices(batch_size);
+  for (int i = 0; i < batch_size; i++) {
+    uint64_t index;
+    dez.deserialize(index);
+    indices[i] = index;
+  }
+  ImageBatchPipeline *pipeline;
+  {
+    std::lock_guard<std::mutex> lock(pipelines_mutex);
+    assert(loader_id < (int)pipelines.size() && pipelines[loader_id]);
+    pipeline = pipelines[loader_id].get();
+  }
+  float *images = helperGetTensorPointerWO<float>(
+      regions[0], task->regions[0], FID_DATA, ctx, runtime);
+  int32_t *labels = helperGetTensorPointerWO<int32_t>(
+      regions[1], task->regions[1], FID_DATA, ctx, runtime);
+  Domain label_domain = runtime->get_index_space_domain(
+      ctx, task->regions[1].region.get_index_space());
+  assert(label_domain.get_volume() == (size_t)batch_size);
+  pipeline->load_batch(indices, seed, images, labels);
+}
+
+} // namespace FlexFlow
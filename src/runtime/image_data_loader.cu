@@ -0,0 +1,76 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flexflow/accessor.h"
+#include "flexflow/image_data_loader.h"
+#include "flexflow/utils/cuda_helper.h"
+
+namespace FlexFlow {
+
+using namespace Legion;
+
+/*
+  regions[0](I): staging buffer
+  regions[1](O): piece of the batch tensor
+*/
+template <typename DT>
+void ImageDataLoader::load_batch_task(Task const *task,
+                                      std::vector<PhysicalRegion> const &regions,
+                                      Context ctx,
+                                      Runtime *runtime) {
+  assert(regions.size() == 2);
+  assert(task->regions.size() == 2);
+  Domain staging_domain = runtime->get_index_space_domain(
+      ctx, task->regions[0].region.get_index_space());
+  Domain batch_domain = runtime->get_index_space_domain(
+      ctx, task->regions[1].region.get_index_space());
+  const DT *staging_ptr = helperGetTensorPointerRO<DT>(
+      regions[0], task->regions[0], FID_DATA, ctx, runtime);
+  DT *batch_ptr = helperGetTensorPointerWO<DT>(
+      regions[1], task->regions[1], FID_DATA, ctx, runtime);
+  // The staging buffer holds one replica; only the sample dim is partitioned
+  int num_dims = batch_domain.get_dim();
+  assert(staging_domain.get_dim() == num_dims);
+  for (int i = 0; i < num_dims - 2; i++) {
+    assert(batch_domain.lo()[i] == staging_domain.lo()[i]);
+    assert(batch_domain.hi()[i] == staging_domain.hi()[i]);
+  }
+  assert(batch_domain.hi()[num_dims - 1] == batch_domain.lo()[num_dims - 1]);
+  coord_t num_elements_per_sample =
+      staging_domain.get_volume() / (staging_domain.hi()[num_dims - 2] -
+                                     staging_domain.lo()[num_dims - 2] + 1);
+  const DT *input_zc =
+      staging_ptr + (batch_domain.lo()[num_dims - 2] -
+                     staging_domain.lo()[num_dims - 2]) *
+                        num_elements_per_sample;
+  cudaStream_t stream;
+  checkCUDA(get_legion_stream(&stream));
+  copy_kernel<DT>
+      <<<GET_BLOCKS(batch_domain.get_volume()), CUDA_NUM_THREADS, 0, stream>>>(
+          batch_ptr, input_zc, batch_domain.get_volume());
+}
+
+template void ImageDataLoader::load_batch_task<float>(
+    Task const *task,
+    std::vector<PhysicalRegion> const &regions,
+    Context ctx,
+    Runtime *runtime);
+template void ImageDataLoader::load_batch_task<int32_t>(
+    Task const *task,
+    std::vector<PhysicalRegion> const &regions,
+    Context ctx,
+    Runtime *runtime);
+
+} // namespace FlexFlow
@@ -165,6 +165,10 @@ void ZeroInitializer::init_task_cpu(Task const *task,
         break;
       }
     }
+    // Split across the threads of an OpenMP processor
+#ifdef FF_USE_OPENMP
+#pragma omp parallel for
+#endif
     for (size_t i = 0; i < domain.get_volume(); i++) {
       w[i] = 0.0f;
     }
@@ -340,6 +344,9 @@ void ConstantInitializer::init_task_cpu(
         break;
       }
     }
+#ifdef FF_USE_OPENMP
+#pragma omp parallel for
+#endif
     for (size_t i = 0; i < domain.get_volume(); i++) {
       w[i] = initializer->float_value;
     }
@@ -0,0 +1,62 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flexflow/layerwise_optimizer.h"
+
+namespace FlexFlow {
+namespace Kernels {
+namespace LAMB {
+
+void update_cpu(LAMBStep const &step,
+                size_t size,
+                float const *w_grad,
+                float *w,
+                float *m,
+                float *v) {
+  double w_norm = 0.0, u_norm = 0.0;
+  for (size_t i = 0; i < size; i++) {
+    float u = lamb_moments(step, w_grad[i], w[i], m[i], v[i]);
+    w_norm += (double)w[i] * w[i];
+    u_norm += (double)u * u;
+  }
+  float ratio = trust_ratio(std::sqrt(w_norm), std::sqrt(u_norm));
+  for (size_t i = 0; i < size; i++) {
+    w[i] -= step.lr * ratio * lamb_direction(step, w[i], m[i], v[i]);
+  }
+}
+
+} // namespace LAMB
+
+namespace LARS {
+
+void update_cpu(LARSStep const &step,
+                size_t size,
+                float const *w_grad,
+                float *w,
+                float *v) {
+  double w_norm = 0.0, g_norm = 0.0;
+  for (size_t i = 0; i < size; i++) {
+    w_norm += (double)w[i] * w[i];
+    g_norm += (double)w_grad[i] * w_grad[i];
+  }
+  float ratio = lars_ratio(step, std::sqrt(w_norm), std::sqrt(g_norm));
+  for (size_t i = 0; i < size; i++) {
+    lars_step(step, ratio, w_grad[i], w[i], v[i]);
+  }
+}
+
+} // namespace LARS
+} // namespace Kernels
+} // namespace FlexFlow
@@ -1,11 +1,111 @@
-#include "flexflow/simulator.h"
+#include "flexflow/machine_model.h"
 
 #include <algorithm>
+#include <cassert>
+#include <fstream>
 #include <functional>
+#include <iterator>
+#include <random>
+#include <sstream>
 #include <thread>
 #include <vector>
 namespace FlexFlow {
 
+Device::Device(std::string const &name,
+               DeviceType type,
+               int node_id,
+               int socket_id,
+               int device_id)
+    : name(name), type(type), node_id(node_id), socket_id(socket_id),
+      device_id(device_id) {}
+
+CompDevice::CompDevice(std::string const &name,
+                       CompDevType comp_type,
+                       int node_id,
+                       int socket_id,
+                       int device_id)
+    : Device(name, Device::DEVICE_COMP, node_id, socket_id, device_id),
+      comp_type(comp_type) {}
+
+MemDevice::MemDevice(std::string const &name,
+                     MemDevType mem_type,
+                     int node_id,
+                     int socket_id,
+                     int device_id,
+                     size_t capacity)
+    : Device(name, Device::DEVICE_MEM, node_id, socket_id, device_id),
+      mem_type(mem_type), capacity(capacity) {}
+
+CommDevice::CommDevice(std::string const &name,
+                       CommDevType comm_type,
+                       int node_id,
+                       int socket_id,
+                       int device_id,
+                       float latency,
+                       float bandwidth)
+    : Device(name, Device::DEVICE_COMM, node_id, socket_id, device_id),
+      comm_type(comm_type), latency(latency), bandwidth(bandwidth) {}
+
+static std::random_device rd;
+static std::mt19937 gen = std::mt19937(rd());
+static std::uniform_real_distribution<> std_uniform =
+    std::uniform_real_distribution<>(0.0, 1.0);
+
+NominalCommDevice::NominalCommDevice(std::string const &name,
+                                     int device_id,
+                                     int nnodes,
+                                     NetworkRoutingStrategy *routing)
+    : CommDevice(name, CommDevice::NW_NOMINAL, -1, -1, device_id, 0, 0),
+      routing_strategy(routing), dirty(true), nnode(nnodes) {}
+
+void NominalCommDevice::reset() {
+  dirty = true;
+  routes = {};
+}
+
+Route NominalCommDevice::expand_to_physical() const {
+  if (dirty) {
+    if (routing_strategy == nullptr) {
+      assert("don't know how to route!" && false);
+    }
+    // std::cerr << name << " dirty... " << std::endl;
+    *const_cast<EcmpRoutes *>(&routes) =
+        routing_strategy->get_routes(device_id / nnode, device_id % nnode);
+    *const_cast<bool *>(&dirty) = false;
+  }
+
+  assert(routes.first.size() > 0 || device_id / nnode == device_id % nnode);
+  size_t pick = 0;
+  double choice = std_uniform(gen);
+  for (size_t i = 0; i < routes.first.size(); i++) {
+    if (choice > routes.first[i]) {
+      break;
+    }
+    pick = i;
+  }
+  Route ret = Route(routes.second[pick].begin(), routes.second[pick].end());
+  return ret;
+}
+
+void NominalCommDevice::set_physical_paths(EcmpRoutes const &rs) {
+  routes = rs;
+  dirty = false;
+}
+
+EcmpRoutes const &NominalCommDevice::get_all_routes() {
+  if (dirty) {
+    if (routing_strategy == nullptr) {
+      assert("don't know how to route!" && false);
+    }
+    // std::cerr << name << " dirty... " << std::endl;
+    *const_cast<EcmpRoutes *>(&routes) =
+        routing_strategy->get_routes(device_id / nnode, device_id % nnode);
+    *const_cast<bool *>(&dirty) = false;
+  }
+  return routes;
+}
+
+
 /// @param[in] nb_elements : size of your for loop
 /// @param[in] functor(start, end) :
 /// your function processing a sub chunk of the for loop.
@@ -170,6 +270,10 @@ float SimpleMachineModel::get_inter_node_gpu_bandwidth() const {
   return inter_node_bandwidth;
 }
 
+float SimpleMachineModel::get_host_gpu_bandwidth() const {
+  return gpu_dram_bandwidth;
+}
+
 std::vector<CommDevice *>
     SimpleMachineModel::get_comm_path(MemDevice *src_mem, MemDevice *tar_mem) {
   std::vector<CommDevice *> ret;
@@ -918,6 +1022,10 @@ float EnhancedMachineModel::get_inter_node_gpu_bandwidth() const {
   return nic_bandwidth;
 }
 
+float EnhancedMachineModel::get_host_gpu_bandwidth() const {
+  return pci_bandwidth * 1024 * 1024;
+}
+
 std::string EnhancedMachineModel::to_string() const {
   std::string s;
   for (int i = 0; i < num_nodes; i++) {
@@ -1134,6 +1242,10 @@ float NetworkedMachineModel::get_inter_node_gpu_bandwidth() const {
   return link_bandwidth;
 }
 
+float NetworkedMachineModel::get_host_gpu_bandwidth() const {
+  return gpu_dram_bandwidth;
+}
+
 void NetworkedMachineModel::set_routing_strategy(NetworkRoutingStrategy *rs) {
   delete routing_strategy;
   routing_strategy = rs;
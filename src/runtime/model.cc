@@ -20,8 +20,12 @@
 #include "flexflow/utils/hip_helper.h"
 #endif
 #include "flexflow/ffconst_utils.h"
+#include "flexflow/gradient_overwrite.h"
 #include "flexflow/graph.h"
+#include "flexflow/image_data_loader.h"
 #include "flexflow/mapper.h"
+#include "flexflow/mcmc_search.h"
+#include "flexflow/model_checkpoint.h"
 #include "flexflow/ops/aggregate.h"
 #include "flexflow/ops/aggregate_spec.h"
 #include "flexflow/ops/attention.h"
@@ -31,8 +35,10 @@
 #include "flexflow/ops/cast.h"
 #include "flexflow/ops/concat.h"
 #include "flexflow/ops/conv_2d.h"
+#include "flexflow/ops/dot_interaction.h"
 #include "flexflow/ops/dropout.h"
 #include "flexflow/ops/element_binary.h"
+#include "flexflow/ops/element_expression.h"
 #include "flexflow/ops/element_unary.h"
 #include "flexflow/ops/embedding.h"
 #include "flexflow/ops/flat.h"
@@ -42,10 +48,12 @@
 #include "flexflow/ops/layer_norm.h"
 #include "flexflow/ops/linear.h"
 #include "flexflow/ops/noop.h"
+#include "flexflow/ops/pad.h"
 #include "flexflow/ops/pool_2d.h"
 #include "flexflow/ops/reduce.h"
 #include "flexflow/ops/reshape.h"
 #include "flexflow/ops/reverse.h"
+#include "flexflow/ops/slice.h"
 #include "flexflow/ops/softmax.h"
 #include "flexflow/ops/split.h"
 #include "flexflow/ops/topk.h"
@@ -55,11 +63,13 @@
 #include "flexflow/parallel_ops/partition.h"
 #include "flexflow/parallel_ops/reduction.h"
 #include "flexflow/parallel_ops/replicate.h"
+#include "flexflow/serving_search.h"
 #include "flexflow/substitution.h"
 #include "flexflow/utils/random_utils.h"
 #include "flexflow/utils/test_utils.h"
 #include "legion/legion_utilities.h"
 #include <dirent.h>
+#include <fstream>
 #include <queue>
 #include <unordered_set>
 
@@ -131,8 +141,9 @@ Op::Op(FFModel &model,
   }
   for (int i = 0; i < numInputs; i++) {
     trainableInputs[i] = true;
-    // resetInputGrads[i] = true;
+    resetInputGrads[i] = false;
   }
+  resetWeightGrads = false;
   for (int i = 0; i < MAX_NUM_OUTPUTS; i++) {
     outputs[i] = nullptr;
   }
@@ -175,8 +186,9 @@ Op::Op(FFModel &model,
   }
   for (int i = 0; i < numInputs; i++) {
     trainableInputs[i] = true;
-    // resetInputGrads[i] = true;
+    resetInputGrads[i] = false;
   }
+  resetWeightGrads = false;
   for (int i = 0; i < MAX_NUM_OUTPUTS; i++) {
     outputs[i] = NULL;
   }
@@ -190,6 +202,14 @@ bool Op::is_parallel_op() const {
   return false;
 }
 
+bool Op::can_overwrite_input_grad(int input_idx) const {
+  return false;
+}
+
+bool Op::can_overwrite_weight_grads() const {
+  return false;
+}
+
 bool Op::can_inplace_output() {
   return false;
 }
@@ -247,28 +267,37 @@ void Op::zero_grad(FFModel const &ff) {
   if (op_type == OP_INPUT || op_type == OP_WEIGHT) {
     return;
   }
+  // Skip the gradients overwritten by their first writer
+  std::vector<ParallelTensor> grads;
+  for (int i = 0; i < numWeights; i++) {
+    if (ff.overwritten_grads.find(weights[i]->region_grad) ==
+        ff.overwritten_grads.end()) {
+      grads.push_back(weights[i]);
+    }
+  }
+  for (int i = 0; i < numOutputs; i++) {
+    if (ff.overwritten_grads.find(outputs[i]->region_grad) ==
+        ff.overwritten_grads.end()) {
+      grads.push_back(outputs[i]);
+    }
+  }
+  if (grads.empty()) {
+    return;
+  }
   Runtime *runtime = ff.config.lg_hlr;
   Context ctx = ff.config.lg_ctx;
   ArgumentMap argmap;
   ZeroInitMeta meta;
   meta.op_ptr = this;
-  meta.num_regions = numWeights + numOutputs;
+  meta.num_regions = grads.size();
   assert(meta.num_regions <= ZeroInitMeta::MAX_NUM_REGIONS);
   IndexSpace parallel_is = IndexSpace::NO_SPACE;
-  for (int i = 0; i < numWeights; i++) {
-    meta.data_types[i] = weights[i]->data_type;
-    if (parallel_is == IndexSpace::NO_SPACE) {
-      parallel_is = weights[i]->parallel_is;
-    } else {
-      assert(parallel_is == weights[i]->parallel_is);
-    }
-  }
-  for (int i = 0; i < numOutputs; i++) {
-    meta.data_types[i + numWeights] = outputs[i]->data_type;
+  for (size_t i = 0; i < grads.size(); i++) {
+    meta.data_types[i] = grads[i]->data_type;
     if (parallel_is == IndexSpace::NO_SPACE) {
-      parallel_is = outputs[i]->parallel_is;
+      parallel_is = grads[i]->parallel_is;
     } else {
-      assert(parallel_is == outputs[i]->parallel_is);
+      assert(parallel_is == grads[i]->parallel_is);
     }
   }
   IndexLauncher launcher(ZERO_INIT_TASK_ID,
@@ -279,26 +308,14 @@ void Op::zero_grad(FFModel const &ff) {
                          false /*must*/,
                          0 /*mapper_id*/,
                          outputs[0]->machine_view.hash());
-  for (int i = 0; i < numWeights; i++) {
-    launcher.add_region_requirement(RegionRequirement(weights[i]->part_grad,
+  for (size_t i = 0; i < grads.size(); i++) {
+    launcher.add_region_requirement(RegionRequirement(grads[i]->part_grad,
                                                       0 /*projection id*/,
                                                       WRITE_ONLY,
                                                       EXCLUSIVE,
-                                                      weights[i]->region_grad));
+                                                      grads[i]->region_grad));
     launcher.add_field(i, FID_DATA);
   }
-  for (int i = 0; i < numOutputs; i++) {
-    launcher.add_region_requirement(RegionRequirement(outputs[i]->part_grad,
-                                                      0 /*projection id*/,
-                                                      WRITE_ONLY,
-                                                      EXCLUSIVE,
-                                                      outputs[i]->region_grad));
-    // LogicalRegion lr = outputs[i]->region_grad;
-    // printf("zero_grad:output[%d]: region(%d,%d,%d)\n", i,
-    // lr.get_index_space().get_id(), lr.get_field_space().get_id(),
-    // lr.get_tree_id());
-    launcher.add_field(i + numWeights, FID_DATA);
-  }
   runtime->execute_index_space(ctx, launcher);
 }
 
@@ -1130,9 +1147,11 @@ bool Op::get_weight_parameter(TNParameter tnp,
   return true;
 }
 
-OpMeta::OpMeta(FFHandler _handle) : handle(_handle), profiling(false) {
+OpMeta::OpMeta(FFHandler _handle)
+    : handle(_handle), profiling(false), resetWeightGrads(false) {
   for (int i = 0; i < MAX_NUM_INPUTS; i++) {
     trainableInputs[i] = true;
+    resetInputGrads[i] = false;
   }
   for (int i = 0; i < MAX_NUM_INPUTS; i++) {
     input_type[i] = DT_NONE;
@@ -1148,7 +1167,9 @@ OpMeta::OpMeta(FFHandler _handle) : handle(_handle), profiling(false) {
 OpMeta::OpMeta(FFHandler _handle, Op const *op) : OpMeta(_handle) {
   for (int i = 0; i < op->numInputs; i++) {
     input_type[i] = op->inputs[i]->data_type;
+    resetInputGrads[i] = op->resetInputGrads[i];
   }
+  resetWeightGrads = op->resetWeightGrads;
   for (int i = 0; i < op->numWeights; i++) {
     weight_type[i] = op->weights[i]->data_type;
   }
@@ -1189,6 +1210,11 @@ FFModel::FFModel(FFConfig &_config)
   //  dataLoader = new DataLoader(config.datasetPath);
   //}
 
+  // Without GPUs (-ll:gpu 0) there are no workers to initialize, and the
+  // model can only be compiled for the capacity planning
+  if (config.workersPerNode * config.numNodes == 0) {
+    return;
+  }
   ArgumentMap argmap;
   Rect<1> task_rect(Point<1>(0),
                     Point<1>(config.workersPerNode * config.numNodes - 1));
@@ -1566,26 +1592,17 @@ void FFModel::map_tensor_with_dim(ParallelTensor tensor,
   }
 }
 
-template <int NDIM, int TDIM>
-void FFModel::map_tensor_with_dim2(ParallelTensor tensor,
-                                   Op const *parallel_op) {
-  // Step 0: check we are the owner or the owner is NULL
-  // in which case set the owner to us
-  if (tensor->owner_op == NULL) {
-    tensor->owner_op = parallel_op;
-    tensor->owner_idx = -1; // meaning tensor is not an output of op
-  } else {
-    // assert tensor->owner_op == parallel_op or parallel_op == nullptr,
-    // which indicates the tensor is not parallelized
-    assert(tensor->owner_op == parallel_op || parallel_op == nullptr);
-  }
-  // Step 1: create regions
+FieldSpace FFModel::get_or_create_field_space(DataType data_type) {
   Context ctx = config.lg_ctx;
   Runtime *runtime = config.lg_hlr;
-
-  FieldSpace fs = runtime->create_field_space(ctx);
+  FieldSpace fs;
+  RegionCache<FieldSpace>::Key key = {data_type};
+  if (field_space_cache.in_epoch() && field_space_cache.find(key, fs)) {
+    return fs;
+  }
+  fs = runtime->create_field_space(ctx);
   FieldAllocator allocator = runtime->create_field_allocator(ctx, fs);
-  switch (tensor->data_type) {
+  switch (data_type) {
     case DT_HALF:
       allocator.allocate_field(sizeof(half), FID_DATA);
       break;
@@ -1604,17 +1621,285 @@ void FFModel::map_tensor_with_dim2(ParallelTensor tensor,
     default:
       assert(false);
   }
+  if (field_space_cache.in_epoch()) {
+    field_space_cache.insert(key, fs);
+  }
+  return fs;
+}
+
+template <int NDIM>
+IndexSpaceT<NDIM> FFModel::get_or_create_index_space(Rect<NDIM> const &rect) {
+  Context ctx = config.lg_ctx;
+  Runtime *runtime = config.lg_hlr;
+  IndexSpace is;
+  RegionCache<IndexSpace>::Key key = {NDIM};
+  for (int i = 0; i < NDIM; i++) {
+    key.push_back(rect.lo[i]);
+    key.push_back(rect.hi[i]);
+  }
+  if (index_space_cache.in_epoch() && index_space_cache.find(key, is)) {
+    return IndexSpaceT<NDIM>(is);
+  }
+  is = runtime->create_index_space(ctx, rect);
+  if (index_space_cache.in_epoch()) {
+    index_space_cache.insert(key, is);
+  }
+  return IndexSpaceT<NDIM>(is);
+}
+
+template <int NDIM, int TDIM>
+IndexPartition
+    FFModel::get_or_create_partition(IndexSpaceT<NDIM> const &parent,
+                                     IndexSpaceT<TDIM> const &color_space,
+                                     Transform<NDIM, TDIM> const &transform,
+                                     Rect<NDIM> const &extent) {
+  Context ctx = config.lg_ctx;
+  Runtime *runtime = config.lg_hlr;
+  IndexPartition ip;
+  // A restriction partition is fully determined by these
+  RegionCache<IndexPartition>::Key key = {
+      parent.get_id(), color_space.get_id(), NDIM, TDIM};
+  for (int i = 0; i < NDIM; i++) {
+    for (int j = 0; j < TDIM; j++) {
+      key.push_back(transform[i][j]);
+    }
+    key.push_back(extent.lo[i]);
+    key.push_back(extent.hi[i]);
+  }
+  if (partition_cache.in_epoch() && partition_cache.find(key, ip)) {
+    return ip;
+  }
+  ip = runtime->create_partition_by_restriction(
+      ctx, parent, color_space, transform, extent);
+  if (partition_cache.in_epoch()) {
+    partition_cache.insert(key, ip);
+  }
+  return ip;
+}
+
+LogicalRegion FFModel::get_or_create_region(IndexSpace const &is,
+                                            FieldSpace const &fs) {
+  Context ctx = config.lg_ctx;
+  Runtime *runtime = config.lg_hlr;
+  LogicalRegion region;
+  // Regions are exclusive: each tensor of a compile gets its own
+  RegionCache<LogicalRegion>::Key key = {is.get_id(), fs.get_id()};
+  if (region_cache.in_epoch() && region_cache.find(key, region)) {
+    return region;
+  }
+  region = runtime->create_logical_region(ctx, is, fs);
+  if (region_cache.in_epoch()) {
+    region_cache.insert(key, region);
+  }
+  return region;
+}
+
+void FFModel::begin_region_cache_epoch() {
+  field_space_cache.begin_epoch();
+  index_space_cache.begin_epoch();
+  partition_cache.begin_epoch();
+  region_cache.begin_epoch();
+  // Weights already mapped by an earlier compile keep their regions
+  for (Op const *op : operators) {
+    for (int i = 0; i < op->numWeights; i++) {
+      touch_cached_regions(op->weights[i]);
+    }
+  }
+  // The tensors of the last compile are dropped; their regions can be reused
+  // unless retained outside the model
+  for (LogicalRegion const &region : compile_region_refs) {
+    region_cache.release(region);
+  }
+  compile_region_refs.clear();
+}
+
+void FFModel::touch_cached_regions(const ParallelTensor tensor) {
+  if (tensor == nullptr) {
+    return;
+  }
+  LogicalRegion regions[2] = {tensor->region, tensor->region_grad};
+  LogicalPartition parts[2] = {tensor->part, tensor->part_grad};
+  for (int i = 0; i < 2; i++) {
+    if (regions[i] != LogicalRegion::NO_REGION) {
+      region_cache.touch(regions[i]);
+      index_space_cache.touch(regions[i].get_index_space());
+      field_space_cache.touch(regions[i].get_field_space());
+    }
+    if (parts[i] != LogicalPartition::NO_PART) {
+      partition_cache.touch(parts[i].get_index_partition());
+    }
+  }
+}
+
+void FFModel::end_region_cache_epoch() {
+  Context ctx = config.lg_ctx;
+  Runtime *runtime = config.lg_hlr;
+  // Operators reused from an earlier compile may still refer to resources
+  // that were not looked up during this one
+  for (Op const *op : operators) {
+    for (int i = 0; i < op->numInputs; i++) {
+      touch_cached_regions(op->inputs[i]);
+    }
+    for (int i = 0; i < op->numWeights; i++) {
+      touch_cached_regions(op->weights[i]);
+    }
+    for (int i = 0; i < op->numOutputs; i++) {
+      touch_cached_regions(op->outputs[i]);
+    }
+  }
+  touch_cached_regions(parallel_label_tensor);
+  for (auto const &t : retained_tensors) {
+    touch_cached_regions(t.first);
+  }
+  // Keep the regions of this compile until the next one drops them
+  std::set<LogicalRegion> regions;
+  for (Op const *op : operators) {
+    for (int i = 0; i < op->numInputs; i++) {
+      regions.insert(op->inputs[i]->region);
+      regions.insert(op->inputs[i]->region_grad);
+    }
+    for (int i = 0; i < op->numWeights; i++) {
+      regions.insert(op->weights[i]->region);
+      regions.insert(op->weights[i]->region_grad);
+    }
+    for (int i = 0; i < op->numOutputs; i++) {
+      regions.insert(op->outputs[i]->region);
+      regions.insert(op->outputs[i]->region_grad);
+    }
+  }
+  if (parallel_label_tensor != nullptr) {
+    regions.insert(parallel_label_tensor->region);
+  }
+  for (LogicalRegion const &region : regions) {
+    if (region_cache.retain(region)) {
+      compile_region_refs.push_back(region);
+    }
+  }
+  // Destroy from the leaves of the region tree up
+  for (LogicalRegion const &region : region_cache.end_epoch()) {
+    runtime->destroy_logical_region(ctx, region);
+  }
+  for (IndexPartition const &ip : partition_cache.end_epoch()) {
+    runtime->destroy_index_partition(ctx, ip);
+  }
+  for (IndexSpace const &is : index_space_cache.end_epoch()) {
+    runtime->destroy_index_space(ctx, is);
+  }
+  for (FieldSpace const &fs : field_space_cache.end_epoch()) {
+    runtime->destroy_field_space(ctx, fs);
+  }
+  RegionCacheStats const &rs = region_cache.get_stats();
+  RegionCacheStats const &ps = partition_cache.get_stats();
+  RegionCacheStats const &is = index_space_cache.get_stats();
+  log_model.info("region cache: regions live(%zu) created(%zu) reused(%zu) "
+                 "destroyed(%zu), partitions live(%zu) created(%zu) "
+                 "reused(%zu) destroyed(%zu), index spaces live(%zu) "
+                 "created(%zu) reused(%zu) destroyed(%zu)",
+                 rs.num_live,
+                 rs.num_created,
+                 rs.num_reused,
+                 rs.num_destroyed,
+                 ps.num_live,
+                 ps.num_created,
+                 ps.num_reused,
+                 ps.num_destroyed,
+                 is.num_live,
+                 is.num_created,
+                 is.num_reused,
+                 is.num_destroyed);
+}
+
+void FFModel::offload_activation(const ParallelTensor tensor) {
+  Context ctx = config.lg_ctx;
+  Runtime *runtime = config.lg_hlr;
+  // An empty task reading the tensor in zero-copy memory; the mapper then
+  // lets the runtime collect its framebuffer instance
+  ArgumentMap argmap;
+  IndexLauncher launcher(ACTIVATION_OFFLOAD_TASK_ID,
+                         tensor->parallel_is,
+                         TaskArgument(NULL, 0),
+                         argmap,
+                         Predicate::TRUE_PRED,
+                         false /*must*/,
+                         0 /*mapper_id*/,
+                         tensor->machine_view.hash());
+  launcher.add_region_requirement(RegionRequirement(tensor->part,
+                                                    0 /*projection*/,
+                                                    READ_ONLY,
+                                                    EXCLUSIVE,
+                                                    tensor->region,
+                                                    MAP_TO_ZC_MEMORY));
+  launcher.add_field(0, FID_DATA);
+  runtime->execute_index_space(ctx, launcher);
+}
+
+void FFModel::prefetch_activation(const ParallelTensor tensor) {
+  Context ctx = config.lg_ctx;
+  Runtime *runtime = config.lg_hlr;
+  // An empty task reading the tensor in framebuffer memory, which copies it
+  // back ahead of the backward passes using it
+  ArgumentMap argmap;
+  IndexLauncher launcher(ACTIVATION_PREFETCH_TASK_ID,
+                         tensor->parallel_is,
+                         TaskArgument(NULL, 0),
+                         argmap,
+                         Predicate::TRUE_PRED,
+                         false /*must*/,
+                         0 /*mapper_id*/,
+                         tensor->machine_view.hash());
+  launcher.add_region_requirement(RegionRequirement(
+      tensor->part, 0 /*projection*/, READ_ONLY, EXCLUSIVE, tensor->region));
+  launcher.add_field(0, FID_DATA);
+  runtime->execute_index_space(ctx, launcher);
+}
+
+void FFModel::retain_tensor(const ParallelTensor tensor) {
+  if (retained_tensors[tensor]++ > 0) {
+    return;
+  }
+  region_cache.retain(tensor->region);
+  region_cache.retain(tensor->region_grad);
+}
+
+void FFModel::release_tensor(const ParallelTensor tensor) {
+  auto it = retained_tensors.find(tensor);
+  assert(it != retained_tensors.end());
+  if (--it->second > 0) {
+    return;
+  }
+  retained_tensors.erase(it);
+  region_cache.release(tensor->region);
+  region_cache.release(tensor->region_grad);
+}
+
+template <int NDIM, int TDIM>
+void FFModel::map_tensor_with_dim2(ParallelTensor tensor,
+                                   Op const *parallel_op) {
+  // Step 0: check we are the owner or the owner is NULL
+  // in which case set the owner to us
+  if (tensor->owner_op == NULL) {
+    tensor->owner_op = parallel_op;
+    tensor->owner_idx = -1; // meaning tensor is not an output of op
+  } else {
+    // assert tensor->owner_op == parallel_op or parallel_op == nullptr,
+    // which indicates the tensor is not parallelized
+    assert(tensor->owner_op == parallel_op || parallel_op == nullptr);
+  }
+  // Step 1: create regions
+  Context ctx = config.lg_ctx;
+  Runtime *runtime = config.lg_hlr;
 
+  FieldSpace fs = get_or_create_field_space(tensor->data_type);
   Point<NDIM> hi;
   for (int i = 0; i < NDIM; i++) {
     hi[i] = tensor->dims[i].size - 1;
   }
   Rect<NDIM> rect(Point<NDIM>::ZEROES(), hi);
-  IndexSpaceT<NDIM> is = runtime->create_index_space(ctx, rect);
-  tensor->region = runtime->create_logical_region(ctx, is, fs);
+  IndexSpaceT<NDIM> is = get_or_create_index_space<NDIM>(rect);
+  tensor->region = get_or_create_region(is, fs);
   if (tensor->create_gradients &&
       config.computationMode == COMP_MODE_TRAINING) {
-    tensor->region_grad = runtime->create_logical_region(ctx, is, fs);
+    tensor->region_grad = get_or_create_region(is, fs);
   }
 
   // Step 2: create partitions if parallel_op != NULL
@@ -1638,8 +1923,8 @@ void FFModel::map_tensor_with_dim2(ParallelTensor tensor,
         }
       }
     }
-    IndexPartition ip = runtime->create_partition_by_restriction(
-        ctx, is, part_is, transform, extent);
+    IndexPartition ip =
+        get_or_create_partition<NDIM, TDIM>(is, part_is, transform, extent);
     assert(runtime->is_index_partition_disjoint(ctx, ip));
     assert(runtime->is_index_partition_complete(ctx, ip));
     tensor->part = runtime->get_logical_partition(ctx, tensor->region, ip);
@@ -1803,8 +2088,8 @@ void FFModel::create_disjoint_partition_with_dim2(
       }
     }
   }
-  IndexPartition ip = runtime->create_partition_by_restriction(
-      ctx, region.get_index_space(), part_is, transform, extent);
+  IndexPartition ip = get_or_create_partition<NDIM, TDIM>(
+      IndexSpaceT<NDIM>(region.get_index_space()), part_is, transform, extent);
   assert(runtime->is_index_partition_disjoint(ctx, ip));
   assert(runtime->is_index_partition_complete(ctx, ip));
   part = runtime->get_logical_partition(ctx, region, ip);
@@ -1864,13 +2149,71 @@ void FFModel::create_aliased_partition_with_dim2(
       }
     }
   }
-  IndexPartition ip = runtime->create_partition_by_restriction(
-      ctx, region.get_index_space(), part_is, transform, extent);
+  IndexPartition ip = get_or_create_partition<NDIM, TDIM>(
+      IndexSpaceT<NDIM>(region.get_index_space()), part_is, transform, extent);
   // assert(runtime->is_index_partition_disjoint(ctx, ip));
   assert(runtime->is_index_partition_complete(ctx, ip));
   part = runtime->get_logical_partition(ctx, region, ip);
 }
 
+void FFModel::create_window_partition(int num_dims,
+                                      const ParallelDim dims[],
+                                      int const offsets[],
+                                      IndexSpace const &part_is,
+                                      LogicalRegion const &region,
+                                      LogicalPartition &part) {
+  Context ctx = config.lg_ctx;
+  Runtime *runtime = config.lg_hlr;
+  Domain task_domain = runtime->get_index_space_domain(ctx, part_is);
+  switch ((num_dims - 1) * MAX_TENSOR_DIM + task_domain.get_dim() - 1) {
+#define DIMFUNC(NDIM, TDIM)                                                    \
+  case (NDIM - 1) * MAX_TENSOR_DIM + (TDIM - 1): {                             \
+    IndexSpaceT<TDIM> part_is_t(part_is);                                      \
+    return create_window_partition_with_dim2<NDIM, TDIM>(                      \
+        dims, offsets, part_is_t, region, part);                               \
+  }
+    LEGION_FOREACH_NN(DIMFUNC)
+#undef DIMFUNC
+    default:
+      assert(false && "Unsupported NDIM/TDIM");
+  }
+}
+
+template <int NDIM, int TDIM>
+void FFModel::create_window_partition_with_dim2(
+    const ParallelDim dims[],
+    int const offsets[],
+    IndexSpaceT<TDIM> const &part_is,
+    LogicalRegion const &region,
+    LogicalPartition &part) {
+  Context ctx = config.lg_ctx;
+  Runtime *runtime = config.lg_hlr;
+  Transform<NDIM, TDIM> transform;
+  Point<NDIM> ext_lo, ext_hi;
+  Rect<NDIM> rect =
+      runtime->get_index_space_domain(ctx, region.get_index_space());
+  for (int i = 0; i < NDIM; i++) {
+    assert(dims[i].size % dims[i].degree == 0);
+    ext_lo[i] = rect.lo[i] + offsets[i];
+    ext_hi[i] = ext_lo[i] + dims[i].size / dims[i].degree - 1;
+    assert(rect.lo[i] + offsets[i] + dims[i].size - 1 <= rect.hi[i]);
+  }
+  Rect<NDIM> extent(ext_lo, ext_hi);
+  for (int i = 0; i < NDIM; i++) {
+    for (int j = 0; j < TDIM; j++) {
+      if (dims[i].parallel_idx == j) {
+        transform[i][j] = extent.hi[i] - extent.lo[i] + 1;
+      } else {
+        transform[i][j] = 0;
+      }
+    }
+  }
+  IndexPartition ip = get_or_create_partition<NDIM, TDIM>(
+      IndexSpaceT<NDIM>(region.get_index_space()), part_is, transform, extent);
+  assert(runtime->is_index_partition_disjoint(ctx, ip));
+  part = runtime->get_logical_partition(ctx, region, ip);
+}
+
 template <int NDIM>
 void FFModel::create_disjoint_partition(const ParallelTensor tensor,
                                         IndexSpaceT<NDIM> const &part_is,
@@ -1903,8 +2246,11 @@ void FFModel::create_disjoint_partition(const ParallelTensor tensor,
       }
     }
   }
-  IndexPartition ip = runtime->create_partition_by_restriction(
-      ctx, tensor->region.get_index_space(), part_is, transform, extent);
+  IndexPartition ip = get_or_create_partition<NDIM, NDIM>(
+      IndexSpaceT<NDIM>(tensor->region.get_index_space()),
+      part_is,
+      transform,
+      extent);
   assert(runtime->is_index_partition_disjoint(ctx, ip));
   assert(runtime->is_index_partition_complete(ctx, ip));
   part_fwd = runtime->get_logical_partition(ctx, tensor->region, ip);
@@ -1957,8 +2303,11 @@ void FFModel::create_data_parallel_partition_with_diff_dims(
     }
   }
   transform[NDIM - 1][TDIM - 1] = extent.hi[NDIM - 1] - extent.lo[NDIM - 1] + 1;
-  IndexPartition ip = runtime->create_partition_by_restriction(
-      ctx, tensor->region.get_index_space(), part_is, transform, extent);
+  IndexPartition ip = get_or_create_partition<NDIM, TDIM>(
+      IndexSpaceT<NDIM>(tensor->region.get_index_space()),
+      part_is,
+      transform,
+      extent);
   assert(runtime->is_index_partition_disjoint(ctx, ip));
   assert(runtime->is_index_partition_complete(ctx, ip));
   part_fwd = runtime->get_logical_partition(ctx, tensor->region, ip);
@@ -2350,12 +2699,12 @@ IndexSpace FFModel::get_or_create_task_is(MachineView const &view) {
     default:
       assert(false);
   }
-  printf("ndim(%d) dims[%d %d %d %d]\n",
-         view.ndims,
-         view.dim[0],
-         view.dim[1],
-         view.dim[2],
-         view.dim[3]);
+  log_model.debug("ndim(%d) dims[%d %d %d %d]",
+                  view.ndims,
+                  view.dim[0],
+                  view.dim[1],
+                  view.dim[2],
+                  view.dim[3]);
   all_task_is[view] = task_is;
   return task_is;
 }
@@ -2416,6 +2765,11 @@ void FFModel::forward(int seq_length) {
   iter_config.seq_length = seq_length;
   for (size_t i = 0; i < operators.size(); i++) {
     operators[i]->forward(*this);
+    for (auto const &offload : activation_offloads) {
+      if (offload.offload_after == (int)i) {
+        offload_activation(offload.tensor);
+      }
+    }
   }
 }
 
@@ -2435,33 +2789,28 @@ void FFModel::get_metrics() {
   metrics_input = operators.size() - 1;
 }
 
-void FFModel::backward(int seq_length) {
+void FFModel::backward(int seq_length, bool with_metrics) {
   iter_config.seq_length = seq_length;
   assert(config.computationMode == COMP_MODE_TRAINING);
   // Compute metrics
-  compute_metrics();
+  if (with_metrics) {
+    compute_metrics();
+  }
   // Compute the gradients of the final operator wrt loss
   Op *final_operator = get_final_operator();
   assert(final_operator->numOutputs == 1);
   loss_op->backward(this, final_operator->outputs[0], parallel_label_tensor);
-  // Perform backpropagation
-  // std::set<LogicalRegion> resetedInputGrads;
+  // Perform backpropagation; the first writer of each gradient overwrites
+  // it, see plan_gradient_overwrites
   for (int l = operators.size() - 1; l >= 0; l--) {
-#ifdef ENABLE_RESNET_INPUT_GRADIENT_OPTIMIZATION
-    for (int i = 0; i < operators[l]->numInputs; i++) {
-      if (resetedInputGrads.find(operators[l]->inputs[i]->region) ==
-          resetedInputGrads.end()) {
-        resetedInputGrads.insert(operators[l]->inputs[i]->region);
-      } else {
-        // This input's gradients has been reseted by other operators
-        // So we should not do it again
-        operators[l]->resetInputGrads[i] = false;
-      }
-    }
-#endif
     // TODO: If operator serves for metrics and for further prop
     // if(l == metrics_input && metrics_input < (int)operators.size()-1)
     //  continue;
+    for (auto const &offload : activation_offloads) {
+      if (offload.prefetch_before == l) {
+        prefetch_activation(offload.tensor);
+      }
+    }
     operators[l]->backward(*this);
   }
 }
@@ -2492,20 +2841,97 @@ void FFModel::compile(Optimizer *_optimizer,
   compile(loss_type, metrics, comp_mode);
 }
 
+void FFModel::reshard_from(FFModel const &old_model) {
+  assert(layers.size() == old_model.layers.size());
+  assert(optimizer != NULL && old_model.optimizer != NULL);
+  std::map<ParallelTensor, ParallelTensor> old_params;
+  for (size_t l = 0; l < layers.size(); l++) {
+    Layer const *layer = layers[l];
+    Layer const *old_layer = old_model.layers[l];
+    assert(layer->op_type == old_layer->op_type);
+    assert(layer->numWeights == old_layer->numWeights);
+    for (int i = 0; i < layer->numWeights; i++) {
+      ParallelTensor p = layer->weights[i]->parallel_tensor;
+      ParallelTensor old_p = old_layer->weights[i]->parallel_tensor;
+      assert(p != nullptr && old_p != nullptr);
+      p->reshard_from(this, old_p);
+      old_params[p] = old_p;
+    }
+  }
+  optimizer->reshard_from(old_model.optimizer, old_params);
+}
+
+std::map<ParallelTensor, std::string> FFModel::get_checkpoint_names() const {
+  // Layers are numbered in the order they were added, which does not depend
+  // on the resources or the strategy
+  std::map<ParallelTensor, std::string> names;
+  for (size_t l = 0; l < layers.size(); l++) {
+    Layer const *layer = layers[l];
+    for (int i = 0; i < layer->numWeights; i++) {
+      ParallelTensor p = layer->weights[i]->parallel_tensor;
+      assert(p != nullptr);
+      names[p] = "layer" + std::to_string(l) + "." +
+                 get_operator_type_name(layer->op_type) + ".weight" +
+                 std::to_string(i);
+    }
+  }
+  return names;
+}
+
+void FFModel::save_checkpoint(std::string const &file_name) const {
+  assert(optimizer != NULL);
+  ModelCheckpoint ckpt;
+  std::map<ParallelTensor, std::string> names = get_checkpoint_names();
+  for (auto const &p : names) {
+    p.first->save_checkpoint(this, ckpt, p.second);
+  }
+  optimizer->save_checkpoint(ckpt, names);
+  std::ofstream file(file_name, std::ios::binary);
+  ckpt.write(file);
+  if (!file) {
+    fprintf(stderr, "Cannot write checkpoint %s\n", file_name.c_str());
+    assert(false);
+  }
+}
+
+bool FFModel::load_checkpoint(std::string const &file_name) {
+  assert(optimizer != NULL);
+  ModelCheckpoint ckpt;
+  std::string error;
+  std::ifstream file(file_name, std::ios::binary);
+  if (!file || !ModelCheckpoint::read(file, ckpt, error)) {
+    fprintf(stderr,
+            "Cannot read checkpoint %s: %s\n",
+            file_name.c_str(),
+            file ? error.c_str() : "cannot open the file");
+    return false;
+  }
+  std::map<ParallelTensor, std::string> names = get_checkpoint_names();
+  for (auto const &p : names) {
+    if (!p.first->load_checkpoint(this, ckpt, p.second, error)) {
+      fprintf(stderr,
+              "Cannot load checkpoint %s: %s\n",
+              file_name.c_str(),
+              error.c_str());
+      return false;
+    }
+  }
+  if (!optimizer->load_checkpoint(ckpt, names, error)) {
+    fprintf(stderr,
+            "Cannot load checkpoint %s: %s\n",
+            file_name.c_str(),
+            error.c_str());
+    return false;
+  }
+  return true;
+}
+
 bool FFModel::apply_fusion(std::vector<Op *> const &operators,
                            std::vector<Op *> &new_operators) {
   // Context ctx = config.lg_ctx;
   // Runtime* runtime = config.lg_hlr;
   for (size_t l = 1; l < operators.size() - 1; l++) {
-    // don't fuse input and weight operator since they don't involve any
-    // forward/backward task launches
-    if (operators[l]->op_type == OP_INPUT ||
-        operators[l]->op_type == OP_WEIGHT) {
-      continue;
-    }
-    // don't fuse parallel op since they have different parallel_is in
-    // forward/backward
-    if (operators[l]->is_parallel_op()) {
+    if (!FusedOp::can_fuse(operators[l])) {
       continue;
     }
     size_t start = 0;
@@ -2539,18 +2965,8 @@ bool FFModel::apply_fusion(std::vector<Op *> const &operators,
           fused_op = (FusedOp *)operators[i];
         } else {
           //  cannot be an in-place operator
-          if (operators[i]->has_inplace_output()) {
-            continue;
-          }
-          // don't fuse input and weight operator since they don't involve any
-          // forward/backward kernels
-          if (operators[i]->op_type == OP_INPUT ||
-              operators[i]->op_type == OP_WEIGHT) {
-            continue;
-          }
-          // don't fuse parallel op since they have different parallel_is in
-          // forward/backward
-          if (operators[i]->is_parallel_op()) {
+          if (operators[i]->has_inplace_output() ||
+              !FusedOp::can_fuse(operators[i])) {
             continue;
           }
           fused_op = new FusedOp(*this, operators[i]);
@@ -2717,13 +3133,25 @@ Op *FFModel::create_operator_from_layer(
       operators.push_back(op);
       return op;
     }
-    case OP_LAYERNORM: {
-      Op *op = LayerNorm::create_operator_from_layer(*this, layer, inputs);
+    case OP_DOT_INTERACTION: {
+      Op *op =
+          DotInteraction::create_operator_from_layer(*this, layer, inputs);
       operators.push_back(op);
       return op;
     }
-    case OP_LINEAR: {
-      Op *op = Linear::create_operator_from_layer(*this, layer, inputs);
+    case OP_ELEMENT_EXPRESSION: {
+      Op *op =
+          ElementExpression::create_operator_from_layer(*this, layer, inputs);
+      operators.push_back(op);
+      return op;
+    }
+    case OP_LAYERNORM: {
+      Op *op = LayerNorm::create_operator_from_layer(*this, layer, inputs);
+      operators.push_back(op);
+      return op;
+    }
+    case OP_LINEAR: {
+      Op *op = Linear::create_operator_from_layer(*this, layer, inputs);
       operators.push_back(op);
       return op;
     }
@@ -2757,6 +3185,16 @@ Op *FFModel::create_operator_from_layer(
       operators.push_back(op);
       return op;
     }
+    case OP_SLICE: {
+      Op *op = Slice::create_operator_from_layer(*this, layer, inputs);
+      operators.push_back(op);
+      return op;
+    }
+    case OP_PAD: {
+      Op *op = Pad::create_operator_from_layer(*this, layer, inputs);
+      operators.push_back(op);
+      return op;
+    }
     case OP_TOPK: {
       Op *op = TopK::create_operator_from_layer(*this, layer, inputs);
       operators.push_back(op);
@@ -2782,6 +3220,229 @@ Op *FFModel::create_operator_from_layer(
   }
 }
 
+void FFModel::fuse_element_expressions() {
+  // Number of layers reading each tensor
+  std::map<Tensor, int> num_consumers;
+  for (Layer const *l : layers) {
+    std::set<Tensor> read(l->inputs, l->inputs + l->numInputs);
+    for (Tensor t : read) {
+      num_consumers[t]++;
+    }
+  }
+  // Grow groups of layers whose results are only read within the group,
+  // except for the result of the last one. A layer joins the groups whose
+  // last result it is the only reader of.
+  std::vector<std::vector<Layer *>> groups;
+  std::map<Tensor, size_t> group_of_output;
+  for (Layer *l : layers) {
+    if (!ElementExpression::can_fuse(l)) {
+      continue;
+    }
+    std::vector<Layer *> members;
+    std::set<size_t> joined;
+    for (int i = 0; i < l->numInputs; i++) {
+      auto it = group_of_output.find(l->inputs[i]);
+      if (it != group_of_output.end() && num_consumers[it->first] == 1 &&
+          joined.insert(it->second).second) {
+        members.insert(members.end(),
+                       groups[it->second].begin(),
+                       groups[it->second].end());
+      }
+    }
+    // Keep the layers in their original, topological order
+    std::sort(members.begin(), members.end(), [](Layer *a, Layer *b) {
+      return a->layer_guid.id < b->layer_guid.id;
+    });
+    members.push_back(l);
+    ExpressionProgram program;
+    std::vector<Tensor> inputs;
+    if (!ElementExpression::build_program(members, program, inputs)) {
+      members = {l};
+      joined.clear();
+    }
+    for (size_t g : joined) {
+      group_of_output.erase(groups[g].back()->outputs[0]);
+      groups[g].clear();
+    }
+    group_of_output[l->outputs[0]] = groups.size();
+    groups.push_back(members);
+  }
+  // Each group of two layers or more becomes an expression at the position
+  // of its last layer, which computes the same tensor
+  std::map<Layer *, Layer *> replaced;
+  std::set<Layer *> removed;
+  for (auto const &group : groups) {
+    if (group.size() < 2) {
+      continue;
+    }
+    ExpressionProgram program;
+    std::vector<Tensor> inputs;
+    bool built = ElementExpression::build_program(group, program, inputs);
+    assert(built);
+    Layer *last = group.back();
+    Layer *expr =
+        ElementExpression::create_layer(*this, inputs, program, nullptr);
+    expr->outputs[0] = last->outputs[0];
+    expr->outputs[0]->owner_layer = expr;
+    expr->outputs[0]->owner_idx = 0;
+    replaced[last] = expr;
+    removed.insert(group.begin(), group.end() - 1);
+  }
+  std::vector<Layer *> fused_layers;
+  for (Layer *l : layers) {
+    if (removed.find(l) != removed.end()) {
+      continue;
+    }
+    auto it = replaced.find(l);
+    fused_layers.push_back(it == replaced.end() ? l : it->second);
+  }
+  log_model.info("fused %zu element-wise layers into %zu expressions",
+                 removed.size() + replaced.size(),
+                 replaced.size());
+  layers = fused_layers;
+}
+
+void FFModel::fold_pads_into_convolutions() {
+  // Layers reading each tensor
+  std::map<Tensor, std::vector<Layer *>> consumers;
+  for (Layer *l : layers) {
+    for (int i = 0; i < l->numInputs; i++) {
+      consumers[l->inputs[i]].push_back(l);
+    }
+  }
+  // A zero padding of the width and height only, equal on both sides, is
+  // the same as a larger padding of each convolution reading the result
+  std::set<Layer *> removed;
+  for (Layer *l : layers) {
+    if (l->op_type != OP_PAD) {
+      continue;
+    }
+    std::vector<int> pads_before, pads_after;
+    float value;
+    l->get_int_vector_property("pads_before", pads_before);
+    l->get_int_vector_property("pads_after", pads_after);
+    l->get_float_property("value", value);
+    bool foldable = value == 0.0f && l->outputs[0]->num_dims == 4;
+    for (size_t i = 0; i < pads_before.size() && foldable; i++) {
+      if (pads_before[i] != pads_after[i] || (i >= 2 && pads_before[i] > 0)) {
+        foldable = false;
+      }
+    }
+    std::vector<Layer *> const &readers = consumers[l->outputs[0]];
+    for (Layer const *r : readers) {
+      if (r->op_type != OP_CONV2D || r->inputs[0] != l->outputs[0]) {
+        foldable = false;
+      }
+    }
+    if (!foldable || readers.empty()) {
+      continue;
+    }
+    for (Layer *conv : readers) {
+      long long padding_w, padding_h;
+      conv->get_int_property("padding_w", padding_w);
+      conv->get_int_property("padding_h", padding_h);
+      conv->add_int_property("padding_w", padding_w + pads_before[0]);
+      conv->add_int_property("padding_h", padding_h + pads_before[1]);
+      conv->inputs[0] = l->inputs[0];
+    }
+    removed.insert(l);
+  }
+  if (removed.empty()) {
+    return;
+  }
+  std::vector<Layer *> folded_layers;
+  for (Layer *l : layers) {
+    if (removed.find(l) == removed.end()) {
+      folded_layers.push_back(l);
+    }
+  }
+  log_model.info("folded %zu pad layers into convolutions", removed.size());
+  layers = folded_layers;
+}
+
+void FFModel::plan_gradient_overwrites() {
+  overwritten_grads.clear();
+  for (Op *op : operators) {
+    for (int i = 0; i < op->numInputs; i++) {
+      op->resetInputGrads[i] = false;
+    }
+    op->resetWeightGrads = false;
+  }
+  if (config.computationMode != COMP_MODE_TRAINING) {
+    return;
+  }
+  std::map<LogicalRegion, int> grad_ids;
+  std::vector<LogicalRegion> grads;
+  auto grad_id = [&](LogicalRegion const &region) -> int {
+    auto it = grad_ids.find(region);
+    if (it != grad_ids.end()) {
+      return it->second;
+    }
+    grad_ids[region] = grads.size();
+    grads.push_back(region);
+    return (int)grads.size() - 1;
+  };
+  std::vector<GradientAccess> accesses(operators.size());
+  for (size_t l = 0; l < operators.size(); l++) {
+    Op const *op = operators[l];
+    GradientAccess &access = accesses[l];
+    if (op->op_type == OP_INPUT || op->op_type == OP_WEIGHT) {
+      continue;
+    }
+    for (int i = 0; i < op->numOutputs; i++) {
+      if (op->outputs[i]->region_grad != LogicalRegion::NO_REGION) {
+        access.reads.push_back(grad_id(op->outputs[i]->region_grad));
+      }
+    }
+    for (int i = 0; i < op->numInputs; i++) {
+      LogicalRegion const &grad = op->inputs[i]->region_grad;
+      access.writes.push_back(
+          grad == LogicalRegion::NO_REGION ? -1 : grad_id(grad));
+      access.can_overwrite.push_back(op->trainableInputs[i] &&
+                                     op->can_overwrite_input_grad(i));
+    }
+    for (int i = 0; i < op->numWeights; i++) {
+      LogicalRegion const &grad = op->weights[i]->region_grad;
+      access.writes.push_back(
+          grad == LogicalRegion::NO_REGION ? -1 : grad_id(grad));
+      access.can_overwrite.push_back(op->can_overwrite_weight_grads());
+    }
+  }
+  Op *final_operator = get_final_operator();
+  std::vector<int> loss_grads;
+  loss_grads.push_back(grad_id(final_operator->outputs[0]->region_grad));
+  GradientOverwritePlan plan =
+      FlexFlow::plan_gradient_overwrites(accesses, loss_grads);
+  for (size_t l = 0; l < operators.size(); l++) {
+    Op *op = operators[l];
+    std::vector<bool> const &overwrite = plan.overwrite[l];
+    for (int i = 0; i < op->numInputs && i < (int)overwrite.size(); i++) {
+      op->resetInputGrads[i] = overwrite[i];
+    }
+    if (op->numWeights == 0 || overwrite.empty()) {
+      continue;
+    }
+    // A single flag covers all weights, so they are overwritten together
+    op->resetWeightGrads = std::all_of(overwrite.begin() + op->numInputs,
+                                       overwrite.end(),
+                                       [](bool b) { return b; });
+    if (!op->resetWeightGrads) {
+      for (int i = 0; i < op->numWeights; i++) {
+        if (overwrite[op->numInputs + i]) {
+          plan.overwritten.erase(accesses[l].writes[op->numInputs + i]);
+        }
+      }
+    }
+  }
+  for (int g : plan.overwritten) {
+    overwritten_grads.insert(grads[g]);
+  }
+  log_model.info("%zu of %zu gradients are overwritten by their first "
+                 "writer and not zeroed",
+                 overwritten_grads.size(),
+                 grads.size());
+}
+
 void FFModel::create_operators_from_layers() {
   std::map<const Tensor, ParallelTensor> tensors_to_parallel_tensors;
   for (auto const &l : layers) {
@@ -2819,7 +3480,14 @@ void FFModel::compile(LossType loss_type,
             "Note: only_data_parallel is specified, FlexFlow compiles a "
             "data-parallel PCG.\n");
   }
+  fold_pads_into_convolutions();
+  if (config.perform_expression_fusion) {
+    fuse_element_expressions();
+  }
   create_operators_from_layers();
+  // Saved activations the memory search chose to offload to host memory,
+  // with the operators before whose backward passes they are prefetched
+  std::vector<std::pair<ParallelTensor, Op const *>> offloaded_tensors;
   // Launch the graph optimize task
   {
     FFModel *model = this;
@@ -2829,13 +3497,28 @@ void FFModel::compile(LossType loss_type,
 
     PCG::GraphOptimalViewSerialized ret =
         future.get_result<PCG::GraphOptimalViewSerialized>();
+    if (ret.total_bytes == 0) {
+      printf("No GPUs to compile the model for, exiting after the capacity "
+             "planning\n");
+      exit(0);
+    }
     Deserializer dez(ret.data, ret.total_bytes);
     // Reconstruct operators
     PCG::Graph *best_graph = new PCG::Graph(this);
     std::unordered_map<PCG::Node, MachineView> optimal_views;
-    deserialize_graph_optimal_view(dez, best_graph, optimal_views);
+    std::unordered_map<PCG::Node, PCG::Node> offloaded_nodes;
+    deserialize_graph_optimal_view(
+        dez, best_graph, optimal_views, offloaded_nodes);
     operators.clear();
-    convert_graph_to_operators(best_graph, optimal_views);
+    convert_graph_to_operators(best_graph, optimal_views, offloaded_nodes);
+    for (Op const *op : operators) {
+      if (op->offload_outputs) {
+        for (int i = 0; i < op->numOutputs; i++) {
+          offloaded_tensors.push_back(
+              std::make_pair(op->outputs[i], op->prefetch_outputs_before));
+        }
+      }
+    }
     best_graph->print_dot();
     delete best_graph;
     for (auto const &layer : layers) {
@@ -2918,6 +3601,11 @@ void FFModel::compile(LossType loss_type,
     }
   }
 
+  // Regions, partitions and index spaces of earlier compiles are reused by
+  // the tensors mapped until end_region_cache_epoch
+  double map_start = Realm::Clock::current_time_in_microseconds();
+  begin_region_cache_epoch();
+  int num_reshards = 0, num_aliased_reshards = 0;
   for (size_t l = 0; l < operators.size(); l++) {
     Op *op = operators[l];
     for (int i = 0; i < op->numInputs; i++) {
@@ -2937,7 +3625,17 @@ void FFModel::compile(LossType loss_type,
       ((ParallelOp *)op)->create_input_partition(*this);
     }
     // op->map_output_tensors(*this);
+    if (op->op_type == OP_REPARTITION || op->op_type == OP_COMBINE) {
+      num_reshards++;
+      if (((ParallelOp *)op)->output_aliased) {
+        num_aliased_reshards++;
+      }
+    }
   }
+  log_model.info("%d of %d repartition/combine operators alias their input "
+                 "and launch no task",
+                 num_aliased_reshards,
+                 num_reshards);
 
   // Check correctness
   for (size_t l = 0; l < operators.size(); l++) {
@@ -3122,6 +3820,63 @@ void FFModel::compile(LossType loss_type,
       assert(false && "Unsupported dim");
     }
   }
+  end_region_cache_epoch();
+  log_model.info("mapped tensors in %.2lf ms",
+                 (Realm::Clock::current_time_in_microseconds() - map_start) /
+                     1000.0);
+  // Offload each activation after the forward pass of its producer, and
+  // prefetch it before the backward pass the memory search planned for, so
+  // that the copies run where plan_activation_offload hid them
+  activation_offloads.clear();
+  if (config.computationMode == COMP_MODE_TRAINING) {
+    for (auto const &offloaded : offloaded_tensors) {
+      ParallelTensor const tensor = offloaded.first;
+      int producer = -1, last_consumer = -1;
+      int prefetch_before = (int)operators.size() - 1;
+      for (size_t l = 0; l < operators.size(); l++) {
+        Op const *op = operators[l];
+        for (int i = 0; i < op->numOutputs; i++) {
+          if (op->outputs[i] == tensor) {
+            producer = l;
+          }
+        }
+        for (int i = 0; i < op->numInputs; i++) {
+          if (op->inputs[i] == tensor) {
+            last_consumer = l;
+          }
+        }
+        // The planned operator may have been fused, or removed with the
+        // final parallel operators, in which case the prefetch is issued
+        // first thing in the backward pass
+        bool planned = op == offloaded.second;
+        if (op->op_type == OP_FUSED) {
+          FusedOp const *fused = (FusedOp const *)op;
+          for (int i = 0; i < fused->numOperators; i++) {
+            planned = planned || fused->operators[i] == offloaded.second;
+          }
+        }
+        if (planned) {
+          prefetch_before = l;
+        }
+      }
+      if (producer < 0) {
+        // Internal to a fused operator
+        continue;
+      }
+      ActivationOffload offload;
+      offload.tensor = tensor;
+      offload.offload_after = producer;
+      offload.prefetch_before = std::max(prefetch_before, last_consumer);
+      activation_offloads.push_back(offload);
+    }
+    if (!activation_offloads.empty()) {
+      log_model.info("offloading %zu activations to host memory",
+                     activation_offloads.size());
+    }
+  }
+  // Let the first writer of each gradient overwrite it, instead of zeroing
+  // it before every step
+  plan_gradient_overwrites();
   // init optimizer
   assert(optimizer != NULL);
   optimizer->init();
@@ -3287,51 +4042,70 @@ void FFModel::mcmc_optimize(std::map<Op const *, ParallelConfig> &best,
                             float alpha,
                             CompMode comp_mode,
                             bool use_propagation) const {
-  // Start from data parallel
-  std::map<Op const *, ParallelConfig> current, next;
-  float best_runtime = simulator->simulate_runtime(this, best, comp_mode);
-  current = best;
-  float current_runtime = best_runtime;
-  size_t reset_span = budget / 100, last_reset_iter = 0;
-  if (reset_span == 0) {
-    reset_span = 1;
-  }
-  if (reset_span > 1000) {
-    reset_span = 1000;
-  }
-  for (size_t iter = 0; iter <= budget; iter++) {
-    // Reset the current strategy to be the best strategy
-    if (iter - last_reset_iter >= reset_span) {
-      current = best;
-      current_runtime = best_runtime;
-      last_reset_iter = iter;
-    }
-    rewrite(current, next, use_propagation);
-    float next_runtime = simulator->simulate_runtime(this, next, comp_mode);
-    if (iter % 1000 == 0) {
-      printf("iteration(%zu) current_strategy(%.4lf) best_strategy(%.4lf)\n",
-             iter,
-             current_runtime,
-             best_runtime);
-    }
-    float rn = static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX);
-    // float ratio = (next_runtime - current_runtime) / current_runtime;
-    float diff = (next_runtime - current_runtime);
-    if (next_runtime < best_runtime) {
-      best_runtime = next_runtime;
-      best = next;
-    }
-    if (next_runtime < current_runtime) {
-      current = next;
-      current_runtime = next_runtime;
-    } else if (rn < std::exp(-alpha * diff)) {
-      current = next;
-      current_runtime = next_runtime;
+  // Search over the operators in program order, keeping the output operator
+  McmcProblem<ParallelConfig> problem;
+  problem.simulate = [&](std::vector<ParallelConfig> const &configs,
+                         std::vector<float> &costs) {
+    std::map<Op const *, ParallelConfig> strategy;
+    for (size_t i = 0; i < operators.size(); i++) {
+      strategy[operators[i]] = configs[i];
     }
+    float runtime = simulator->simulate_runtime(this, strategy, comp_mode);
+    for (size_t i = 0; i < operators.size(); i++) {
+      auto it = simulator->critical_path_costs.find(operators[i]);
+      costs[i] =
+          it == simulator->critical_path_costs.end() ? 0.0f : it->second;
+    }
+    return runtime;
+  };
+  problem.random_config = [&](int i) {
+    return operators[i]->get_random_parallel_config(*this);
+  };
+  problem.mutable_ops = std::vector<bool>(operators.size(), true);
+  problem.mutable_ops.back() = false;
+  if (use_propagation) {
+    problem.rewrite = [&](std::vector<ParallelConfig> const &current,
+                          std::vector<ParallelConfig> &next) {
+      std::map<Op const *, ParallelConfig> current_map, next_map;
+      for (size_t i = 0; i < operators.size(); i++) {
+        current_map[operators[i]] = current[i];
+      }
+      rewrite(current_map, next_map, true);
+      for (size_t i = 0; i < operators.size(); i++) {
+        next[i] = next_map[operators[i]];
+      }
+    };
+  }
+  std::vector<ParallelConfig> configs;
+  for (Op const *op : operators) {
+    configs.push_back(best.find(op)->second);
+  }
+  McmcSearchOptions options;
+  options.budget = budget;
+  options.alpha = alpha;
+  options.cost_guided = config.search_cost_guided_mcmc;
+  // rewrite() makes every proposal of the uniform sampler, as it did before
+  // the cost-guided sampler, and a share of those of the cost-guided one
+  if (use_propagation) {
+    options.rewrite_chance =
+        options.cost_guided ? FFModel::PROPAGATION_CHANCE : 1.0f;
   }
+  std::mt19937 rng(std::rand());
+  McmcSearchStats stats = mcmc_search(problem, configs, options, rng);
+  for (size_t i = 0; i < operators.size(); i++) {
+    best[operators[i]] = configs[i];
+  }
+  log_model.print("MCMC search (%s): best_strategy(%.4lf) found at "
+                  "iteration(%zu) of %zu, accepted(%zu) uphill(%zu) "
+                  "final_temperature(%.4lf)",
+                  options.cost_guided ? "cost-guided" : "uniform",
+                  stats.best_runtime,
+                  stats.best_iteration,
+                  budget,
+                  stats.accepted,
+                  stats.uphill_accepted,
+                  stats.final_temperature);
   printf("=========== Best Discovered Strategy ==========\n");
-  simulator->simulate_runtime(
-      this, best, comp_mode, this->config.export_strategy_task_graph_file);
   std::map<Op const *, ParallelConfig>::const_iterator it;
   for (it = best.begin(); it != best.end(); it++) {
     printf("[%s] num_dims(%d) dims[", it->first->name, it->second.nDims);
@@ -3477,6 +4251,7 @@ struct DefaultConfig {
   const static int numNodes = 1;
   const static int workersPerNode = 0;
   const static int cpusPerNode = 0;
+  const static int utilityProcsPerNode = 1;
   const static size_t searchBudget = -1;
   const static size_t simulatorWorkSpaceSize =
       (size_t)2 * 1024 * 1024 * 1024; // 2GB
@@ -3491,6 +4266,15 @@ struct DefaultConfig {
   const static int machine_model_version = 0;
   const static int simulator_segment_size = 16777216; // 16 MB
   const static int simulator_max_num_segments = 1;
+  // Launch overheads are not modeled unless calibrated
+  constexpr static float simulator_task_launch_overhead = 0.0f;
+  constexpr static float simulator_point_launch_overhead = 0.0f;
+  // Optimize the mean step time without injected jitter
+  constexpr static float search_step_time_quantile = 0.0f;
+  constexpr static float serving_latency_slo = 0.0f;
+  constexpr static float plan_target_throughput = 0.0f;
+  constexpr static float simulator_jitter = 0.0f;
+  const static int simulator_num_samples = 32;
   const static int base_optimize_threshold = 10;
   const static bool enable_control_replication = true;
   // The default python data loader type is 2 to enable control replication
@@ -3508,6 +4292,7 @@ FFConfig::FFConfig() {
   numNodes = DefaultConfig::numNodes;
   cpusPerNode = DefaultConfig::cpusPerNode;
   workersPerNode = DefaultConfig::workersPerNode;
+  utilityProcsPerNode = DefaultConfig::utilityProcsPerNode;
   simulator_work_space_size = DefaultConfig::simulatorWorkSpaceSize;
   search_budget = DefaultConfig::searchBudget;
   search_alpha = DefaultConfig::searchAlpha;
@@ -3522,20 +4307,38 @@ FFConfig::FFConfig() {
   machine_model_version = DefaultConfig::machine_model_version;
   simulator_segment_size = DefaultConfig::simulator_segment_size;
   simulator_max_num_segments = DefaultConfig::simulator_max_num_segments;
+  simulator_task_launch_overhead =
+      DefaultConfig::simulator_task_launch_overhead;
+  simulator_point_launch_overhead =
+      DefaultConfig::simulator_point_launch_overhead;
+  search_step_time_quantile = DefaultConfig::search_step_time_quantile;
+  serving_latency_slo = DefaultConfig::serving_latency_slo;
+  plan_target_throughput = DefaultConfig::plan_target_throughput;
+  simulator_jitter = DefaultConfig::simulator_jitter;
+  simulator_num_samples = DefaultConfig::simulator_num_samples;
   enable_control_replication = DefaultConfig::enable_control_replication;
   python_data_loader_type = DefaultConfig::python_data_loader_type;
   machine_model_file = "";
   import_strategy_file = "";
   export_strategy_file = "";
   export_strategy_task_graph_file = "";
+  export_strategy_task_graph_trace_file = "";
   include_costs_dot_graph = false;
   export_strategy_computation_graph_file = "";
   dataset_path = "";
   substitution_json_path = tl::nullopt;
   syntheticInput = false;
   perform_fusion = false;
+  search_fusion_aware = false;
   base_optimize_threshold = DefaultConfig::base_optimize_threshold;
   perform_memory_search = false;
+  offload_activations = false;
+  alias_parallel_ops = true;
+  search_cost_guided_mcmc = true;
+  search_mcmc_budget = 0;
+  tiled_attention = false;
+  optimizer_state_type = OPTIMIZER_STATE_FP32;
+  perform_expression_fusion = false;
 
   // Parse input arguments
   {
@@ -3637,6 +4440,10 @@ void FFConfig::parse_args(char **argv, int argc) {
       cpusPerNode = atoi(argv[++i]);
       continue;
     }
+    if (!strcmp(argv[i], "-ll:util")) {
+      utilityProcsPerNode = atoi(argv[++i]);
+      continue;
+    }
     if (!strcmp(argv[i], "--profiling")) {
       profiling = true;
       continue;
@@ -3649,6 +4456,11 @@ void FFConfig::parse_args(char **argv, int argc) {
       perform_fusion = true;
       continue;
     }
+    if (!strcmp(argv[i], "--fusion-aware-search")) {
+      perform_fusion = true;
+      search_fusion_aware = true;
+      continue;
+    }
     if (!strcmp(argv[i], "--overlap")) {
       search_overlap_backward_update = true;
       continue;
@@ -3657,6 +4469,10 @@ void FFConfig::parse_args(char **argv, int argc) {
       export_strategy_task_graph_file = std::string(argv[++i]);
       continue;
     }
+    if (!strcmp(argv[i], "--taskgraph-trace")) {
+      export_strategy_task_graph_trace_file = std::string(argv[++i]);
+      continue;
+    }
     if (!strcmp(argv[i], "--include-costs-dot-graph")) {
       include_costs_dot_graph = true;
       continue;
@@ -3681,6 +4497,71 @@ void FFConfig::parse_args(char **argv, int argc) {
       simulator_max_num_segments = atoi(argv[++i]);
       continue;
     }
+    if (!strcmp(argv[i], "--simulator-task-launch-overhead")) {
+      simulator_task_launch_overhead = atof(argv[++i]);
+      continue;
+    }
+    if (!strcmp(argv[i], "--simulator-point-launch-overhead")) {
+      simulator_point_launch_overhead = atof(argv[++i]);
+      continue;
+    }
+    if (!strcmp(argv[i], "--search-quantile")) {
+      search_step_time_quantile = atof(argv[++i]);
+      assert(search_step_time_quantile >= 0.0f &&
+             search_step_time_quantile < 1.0f);
+      continue;
+    }
+    if (!strcmp(argv[i], "--serving-slo")) {
+      serving_latency_slo = atof(argv[++i]);
+      assert(serving_latency_slo >= 0.0f);
+      continue;
+    }
+    if (!strcmp(argv[i], "--serving-batch-sizes")) {
+      // Comma-separated list, e.g. 1,8,32
+      serving_batch_sizes.clear();
+      char *s = argv[++i];
+      while (*s != '\0') {
+        serving_batch_sizes.push_back(strtol(s, &s, 10));
+        assert(serving_batch_sizes.back() > 0);
+        if (*s == ',') {
+          s++;
+        }
+      }
+      continue;
+    }
+    if (!strcmp(argv[i], "--plan-clusters")) {
+      // Comma-separated list of <nodes>x<gpus per node>@<cost per GPU-hour>
+      if (!parse_cluster_candidates(argv[++i], plan_clusters)) {
+        fprintf(stderr, "Invalid --plan-clusters %s\n", argv[i]);
+        assert(false);
+      }
+      continue;
+    }
+    if (!strcmp(argv[i], "--plan-throughput")) {
+      plan_target_throughput = atof(argv[++i]);
+      assert(plan_target_throughput >= 0.0f);
+      continue;
+    }
+    if (!strcmp(argv[i], "--plan-gpu-tflops")) {
+      plan_cost_model.flops_per_ms = atof(argv[++i]) * 1e9f;
+      assert(plan_cost_model.flops_per_ms > 0.0f);
+      continue;
+    }
+    if (!strcmp(argv[i], "--plan-gpu-bandwidth")) {
+      // GB/s
+      plan_cost_model.bytes_per_ms = atof(argv[++i]) * 1e6f;
+      assert(plan_cost_model.bytes_per_ms > 0.0f);
+      continue;
+    }
+    if (!strcmp(argv[i], "--simulator-jitter")) {
+      simulator_jitter = atof(argv[++i]);
+      continue;
+    }
+    if (!strcmp(argv[i], "--simulator-samples")) {
+      simulator_num_samples = atoi(argv[++i]);
+      assert(simulator_num_samples > 0);
+      continue;
+    }
     if (!strcmp(argv[i], "--enable-propagation")) {
       enable_propagation = true;
       continue;
@@ -3716,6 +4597,77 @@ void FFConfig::parse_args(char **argv, int argc) {
       perform_memory_search = true;
       continue;
     }
+    if (!strcmp(argv[i], "--offload-activations")) {
+      offload_activations = true;
+      continue;
+    }
+    if (!strcmp(argv[i], "--tiled-attention")) {
+#if defined(FF_USE_HIP_ROCM)
+      fprintf(stderr,
+              "Warning: --tiled-attention is not supported on HIP, "
+              "MultiHeadAttention keeps using MIOpen\n");
+#else
+      tiled_attention = true;
+#endif
+      continue;
+    }
+    if (!strcmp(argv[i], "--optimizer-state")) {
+      std::string type = std::string(argv[++i]);
+      if (type == "fp32") {
+        optimizer_state_type = OPTIMIZER_STATE_FP32;
+      } else if (type == "bf16") {
+        optimizer_state_type = OPTIMIZER_STATE_BF16;
+      } else if (type == "int8") {
+        optimizer_state_type = OPTIMIZER_STATE_INT8;
+      } else {
+        fprintf(stderr, "Unknown optimizer state type %s\n", type.c_str());
+        assert(false);
+      }
+      continue;
+    }
+    if (!strcmp(argv[i], "--expression-fusion")) {
+      perform_expression_fusion = true;
+      continue;
+    }
+    if (!strcmp(argv[i], "--disable-parallel-op-aliasing")) {
+      alias_parallel_ops = false;
+      continue;
+    }
+    if (!strcmp(argv[i], "--mcmc-uniform-proposals")) {
+      search_cost_guided_mcmc = false;
+      continue;
+    }
+    if (!strcmp(argv[i], "--mcmc-budget")) {
+      search_mcmc_budget = (size_t)atoll(argv[++i]);
+      continue;
+    }
+  }
+  if (!import_strategy_file.empty()) {
+    // An imported strategy is only valid for the batch size it was searched
+    // for, e.g. the one picked by a serving search
+    ExportedStrategy strategy;
+    if (!ExportedStrategy::load(import_strategy_file, strategy)) {
+      fprintf(stderr,
+              "Cannot load the strategy file %s\n",
+              import_strategy_file.c_str());
+      assert(false);
+    }
+    if (strategy.batch_size != batchSize) {
+      fprintf(stderr,
+              "Note: using batch size %d of the imported strategy %s\n",
+              strategy.batch_size,
+              import_strategy_file.c_str());
+      batchSize = strategy.batch_size;
+    }
+  }
+  // Fusion only saves launch overheads in the simulator
+  if (search_fusion_aware && simulator_task_launch_overhead <= 0.0f &&
+      simulator_point_launch_overhead <= 0.0f) {
+    fprintf(stderr,
+            "[Warning] --fusion-aware-search has no effect without "
+            "--simulator-task-launch-overhead or "
+            "--simulator-point-launch-overhead "
+            "(see scripts/fusion_aware_search.sh to calibrate them)\n");
   }
 }
 
@@ -3910,6 +4862,100 @@ void register_flexflow_internal_tasks() {
     Runtime::preregister_task_variant<Gather::backward_task>(
         registrar, "Gather Backward Task");
   }
+  // DotInteraction task
+  {
+    TaskVariantRegistrar registrar(DOT_INTERACTION_INIT_TASK_ID,
+                                   "DotInteraction Init");
+    registrar.add_constraint(ProcessorConstraint(Processor::TOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<OpMeta *, DotInteraction::init_task>(
+        registrar, "DotInteraction Init Task");
+  }
+  {
+    TaskVariantRegistrar registrar(DOT_INTERACTION_FWD_TASK_ID,
+                                   "DotInteraction Forward");
+    registrar.add_constraint(ProcessorConstraint(Processor::TOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<DotInteraction::forward_task>(
+        registrar, "DotInteraction Forward Task");
+  }
+  {
+    TaskVariantRegistrar registrar(DOT_INTERACTION_BWD_TASK_ID,
+                                   "DotInteraction Backward");
+    registrar.add_constraint(ProcessorConstraint(Processor::TOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<DotInteraction::backward_task>(
+        registrar, "DotInteraction Backward Task");
+  }
+  // ElementExpression task
+  {
+    TaskVariantRegistrar registrar(ELEMENT_EXPRESSION_INIT_TASK_ID,
+                                   "ElementExpression Init");
+    registrar.add_constraint(ProcessorConstraint(Processor::TOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<OpMeta *, ElementExpression::init_task>(
+        registrar, "ElementExpression Init Task");
+  }
+  {
+    TaskVariantRegistrar registrar(ELEMENT_EXPRESSION_FWD_TASK_ID,
+                                   "ElementExpression Forward");
+    registrar.add_constraint(ProcessorConstraint(Processor::TOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<ElementExpression::forward_task>(
+        registrar, "ElementExpression Forward Task");
+  }
+  {
+    TaskVariantRegistrar registrar(ELEMENT_EXPRESSION_BWD_TASK_ID,
+                                   "ElementExpression Backward");
+    registrar.add_constraint(ProcessorConstraint(Processor::TOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<ElementExpression::backward_task>(
+        registrar, "ElementExpression Backward Task");
+  }
+  // Slice task
+  {
+    TaskVariantRegistrar registrar(SLICE_INIT_TASK_ID, "Slice Init");
+    registrar.add_constraint(ProcessorConstraint(Processor::TOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<OpMeta *, Slice::init_task>(
+        registrar, "Slice Init Task");
+  }
+  {
+    TaskVariantRegistrar registrar(SLICE_FWD_TASK_ID, "Slice Forward");
+    registrar.add_constraint(ProcessorConstraint(Processor::TOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<Slice::forward_task>(
+        registrar, "Slice Forward Task");
+  }
+  {
+    TaskVariantRegistrar registrar(SLICE_BWD_TASK_ID, "Slice Backward");
+    registrar.add_constraint(ProcessorConstraint(Processor::TOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<Slice::backward_task>(
+        registrar, "Slice Backward Task");
+  }
+  // Pad task
+  {
+    TaskVariantRegistrar registrar(PAD_INIT_TASK_ID, "Pad Init");
+    registrar.add_constraint(ProcessorConstraint(Processor::TOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<OpMeta *, Pad::init_task>(
+        registrar, "Pad Init Task");
+  }
+  {
+    TaskVariantRegistrar registrar(PAD_FWD_TASK_ID, "Pad Forward");
+    registrar.add_constraint(ProcessorConstraint(Processor::TOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<Pad::forward_task>(registrar,
+                                                         "Pad Forward Task");
+  }
+  {
+    TaskVariantRegistrar registrar(PAD_BWD_TASK_ID, "Pad Backward");
+    registrar.add_constraint(ProcessorConstraint(Processor::TOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<Pad::backward_task>(registrar,
+                                                          "Pad Backward Task");
+  }
 
   // Cache task CPU
   {
@@ -4517,6 +5563,22 @@ void register_flexflow_internal_tasks() {
     Runtime::preregister_task_variant<AdamOptimizer::ps_update_task>(
         registrar, "Adam Parameter Server Update Task");
   }
+  {
+    TaskVariantRegistrar registrar(LAMB_UPD_PS_TASK_ID,
+                                   "LAMB Parameter Server Update");
+    registrar.add_constraint(ProcessorConstraint(Processor::TOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<LAMBOptimizer::ps_update_task>(
+        registrar, "LAMB Parameter Server Update Task");
+  }
+  {
+    TaskVariantRegistrar registrar(LARS_UPD_PS_TASK_ID,
+                                   "LARS Parameter Server Update");
+    registrar.add_constraint(ProcessorConstraint(Processor::TOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<LARSOptimizer::ps_update_task>(
+        registrar, "LARS Parameter Server Update Task");
+  }
 #ifdef FF_USE_NCCL
   {
     TaskVariantRegistrar registrar(SGD_UPD_NCCL_TASK_ID, "SGD NCCL Update");
@@ -4532,6 +5594,20 @@ void register_flexflow_internal_tasks() {
     Runtime::preregister_task_variant<AdamOptimizer::nccl_update_task>(
         registrar, "Adam NCCL Update Task");
   }
+  {
+    TaskVariantRegistrar registrar(LAMB_UPD_NCCL_TASK_ID, "LAMB NCCL Update");
+    registrar.add_constraint(ProcessorConstraint(Processor::TOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<LAMBOptimizer::nccl_update_task>(
+        registrar, "LAMB NCCL Update Task");
+  }
+  {
+    TaskVariantRegistrar registrar(LARS_UPD_NCCL_TASK_ID, "LARS NCCL Update");
+    registrar.add_constraint(ProcessorConstraint(Processor::TOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<LARSOptimizer::nccl_update_task>(
+        registrar, "LARS NCCL Update Task");
+  }
 #endif
   // Initializer
   {
@@ -4541,6 +5617,15 @@ void register_flexflow_internal_tasks() {
     Runtime::preregister_task_variant<ZeroInitializer::init_task_cpu>(
         registrar, "Zero Init Task");
   }
+#ifdef FF_USE_OPENMP
+  {
+    TaskVariantRegistrar registrar(ZERO_INIT_TASK_ID, "Zero Init");
+    registrar.add_constraint(ProcessorConstraint(Processor::OMP_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<ZeroInitializer::init_task_cpu>(
+        registrar, "Zero Init OpenMP Task");
+  }
+#endif
   {
     TaskVariantRegistrar registrar(ZERO_INIT_TASK_ID, "Zero Init");
     registrar.add_constraint(ProcessorConstraint(Processor::TOC_PROC));
@@ -4555,6 +5640,15 @@ void register_flexflow_internal_tasks() {
     Runtime::preregister_task_variant<ConstantInitializer::init_task_cpu>(
         registrar, "Constant Init Task");
   }
+#ifdef FF_USE_OPENMP
+  {
+    TaskVariantRegistrar registrar(CONSTANT_INIT_TASK_ID, "Constant Init");
+    registrar.add_constraint(ProcessorConstraint(Processor::OMP_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<ConstantInitializer::init_task_cpu>(
+        registrar, "Constant Init OpenMP Task");
+  }
+#endif
   {
     TaskVariantRegistrar registrar(CONSTANT_INIT_TASK_ID, "Constant Init");
     registrar.add_constraint(ProcessorConstraint(Processor::TOC_PROC));
@@ -4620,6 +5714,15 @@ void register_flexflow_internal_tasks() {
                                       PCG::Graph::graph_optimize_task>(
         registrar, "Graph Optimize Task");
   }
+  {
+    // Without GPUs the task only runs the capacity planning
+    TaskVariantRegistrar registrar(GRAPH_OPTIMIZE_TASK_ID, "Graph Optimize");
+    registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<PCG::GraphOptimalViewSerialized,
+                                      PCG::Graph::graph_optimize_task>(
+        registrar, "Graph Optimize Task (CPU)");
+  }
   // Parameter Server Prefetch task
   {
     TaskVariantRegistrar registrar(PS_PREFETCH_TASK_ID, "Weights Prefetch");
@@ -4628,6 +5731,48 @@ void register_flexflow_internal_tasks() {
     Runtime::preregister_task_variant<UtilityTasks::dummy_task>(
         registrar, "Weights Prefetch Task");
   }
+  // Activation offloading tasks
+  {
+    TaskVariantRegistrar registrar(ACTIVATION_OFFLOAD_TASK_ID,
+                                   "Activation Offload");
+    registrar.add_constraint(ProcessorConstraint(Processor::TOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<UtilityTasks::dummy_task>(
+        registrar, "Activation Offload Task");
+  }
+  {
+    TaskVariantRegistrar registrar(ACTIVATION_PREFETCH_TASK_ID,
+                                   "Activation Prefetch");
+    registrar.add_constraint(ProcessorConstraint(Processor::TOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<UtilityTasks::dummy_task>(
+        registrar, "Activation Prefetch Task");
+  }
+  // Image data loader tasks
+  {
+    TaskVariantRegistrar registrar(IMAGE_DL_FILL_TASK_ID, "Image DL Fill");
+    registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<ImageDataLoader::fill_batch_task>(
+        registrar, "Image DL Fill Task");
+  }
+  {
+    TaskVariantRegistrar registrar(IMAGE_DL_LOAD_INPUT_TASK_ID,
+                                   "Image DL Load Input");
+    registrar.add_constraint(ProcessorConstraint(Processor::TOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<ImageDataLoader::load_batch_task<float>>(
+        registrar, "Image DL Load Input Task");
+  }
+  {
+    TaskVariantRegistrar registrar(IMAGE_DL_LOAD_LABEL_TASK_ID,
+                                   "Image DL Load Label");
+    registrar.add_constraint(ProcessorConstraint(Processor::TOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<
+        ImageDataLoader::load_batch_task<int32_t>>(registrar,
+                                                   "Image DL Load Label Task");
+  }
 }
 
 // template instantiations
@@ -4679,6 +5824,12 @@ LEGION_FOREACH_N(DIMFUNC)
       IndexSpaceT<D2> const &part_is,                                          \
       LogicalRegion const &region,                                             \
       LogicalPartition &part);                                                 \
+  template void FFModel::create_window_partition_with_dim2<D1, D2>(            \
+      const ParallelDim dims[],                                                \
+      int const offsets[],                                                     \
+      IndexSpaceT<D2> const &part_is,                                          \
+      LogicalRegion const &region,                                             \
+      LogicalPartition &part);                                                 \
   template void                                                                \
       FFModel::create_data_parallel_partition_with_diff_dims<D1, D2>(          \
           const ParallelTensor tensor,                                         \
@@ -35,41 +35,70 @@ using Legion::Task;
 using Legion::TaskArgument;
 using Legion::TaskLauncher;
 
-void Op::inner_measure_operator_cost(Simulator *sim,
-                                     std::function<void()> const &forward,
-                                     std::function<void()> const &backward,
-                                     CostMetrics &cost_metrics) const {
-  cudaStream_t stream;
-  checkCUDA(get_legion_stream(&stream));
-  // measure forward time
+// Time run() over sim->repeat_times iterations after sim->warmup_times
+// warm-up iterations. The iterations are timed one by one to get the run-to-run
+// standard deviation when the simulator models step-time variance
+static void measure_run_time(Simulator *sim,
+                             cudaStream_t stream,
+                             std::function<void()> const &run,
+                             float &mean,
+                             float &stddev) {
   checkCUDA(cudaDeviceSynchronize());
-  for (int i = 0; i < sim->warmup_times + sim->repeat_times; i++) {
-    if (i == sim->warmup_times) {
-      checkCUDA(cudaEventRecord(sim->start_event, stream));
-    }
-    forward();
-  }
-  checkCUDA(cudaEventRecord(sim->end_event, stream));
-  checkCUDA(cudaEventSynchronize(sim->end_event));
   float milliseconds;
-  cudaEventElapsedTime(&milliseconds, sim->start_event, sim->end_event);
-  cost_metrics.forward_time = milliseconds / sim->repeat_times;
-
-  // measure backward time
-  if (sim->computationMode == COMP_MODE_TRAINING) {
-    checkCUDA(cudaDeviceSynchronize());
+  if (!sim->variance_model.enabled()) {
     for (int i = 0; i < sim->warmup_times + sim->repeat_times; i++) {
       if (i == sim->warmup_times) {
         checkCUDA(cudaEventRecord(sim->start_event, stream));
       }
-      backward();
+      run();
     }
     checkCUDA(cudaEventRecord(sim->end_event, stream));
     checkCUDA(cudaEventSynchronize(sim->end_event));
     cudaEventElapsedTime(&milliseconds, sim->start_event, sim->end_event);
-    cost_metrics.backward_time = milliseconds / sim->repeat_times;
+    mean = milliseconds / sim->repeat_times;
+    stddev = 0.0f;
+    return;
+  }
+  for (int i = 0; i < sim->warmup_times; i++) {
+    run();
+  }
+  float sum = 0.0f, sum_sq = 0.0f;
+  for (int i = 0; i < sim->repeat_times; i++) {
+    checkCUDA(cudaEventRecord(sim->start_event, stream));
+    run();
+    checkCUDA(cudaEventRecord(sim->end_event, stream));
+    checkCUDA(cudaEventSynchronize(sim->end_event));
+    cudaEventElapsedTime(&milliseconds, sim->start_event, sim->end_event);
+    sum += milliseconds;
+    sum_sq += milliseconds * milliseconds;
+  }
+  mean = sum / sim->repeat_times;
+  stddev = std::sqrt(std::max(0.0f, sum_sq / sim->repeat_times - mean * mean));
+}
+
+void Op::inner_measure_operator_cost(Simulator *sim,
+                                     std::function<void()> const &forward,
+                                     std::function<void()> const &backward,
+                                     CostMetrics &cost_metrics) const {
+  cudaStream_t stream;
+  checkCUDA(get_legion_stream(&stream));
+  // measure forward time
+  measure_run_time(sim,
+                   stream,
+                   forward,
+                   cost_metrics.forward_time,
+                   cost_metrics.forward_time_stddev);
+
+  // measure backward time
+  if (sim->computationMode == COMP_MODE_TRAINING) {
+    measure_run_time(sim,
+                     stream,
+                     backward,
+                     cost_metrics.backward_time,
+                     cost_metrics.backward_time_stddev);
   } else {
     cost_metrics.backward_time = 0.0f;
+    cost_metrics.backward_time_stddev = 0.0f;
   }
 }
 
@@ -0,0 +1,184 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flexflow/model_checkpoint.h"
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+
+namespace FlexFlow {
+
+namespace {
+
+char const MAGIC[4] = {'F', 'F', 'C', 'K'};
+
+template <typename T>
+void write_value(std::ostream &os, T const &value) {
+  os.write(reinterpret_cast<char const *>(&value), sizeof(T));
+}
+
+template <typename T>
+bool read_value(std::istream &is, T &value) {
+  return (bool)is.read(reinterpret_cast<char *>(&value), sizeof(T));
+}
+
+void write_string(std::ostream &os, std::string const &s) {
+  write_value(os, (uint64_t)s.size());
+  os.write(s.data(), s.size());
+}
+
+bool read_string(std::istream &is, std::string &s) {
+  uint64_t size;
+  if (!read_value(is, size)) {
+    return false;
+  }
+  s.resize(size);
+  return size == 0 || (bool)is.read(&s[0], size);
+}
+
+} // namespace
+
+void ModelCheckpoint::save_tensor(std::string const &name,
+                                  DataType data_type,
+                                  std::vector<int> const &dims,
+                                  void const *region,
+                                  size_t region_bytes,
+                                  int num_replicas) {
+  assert(num_replicas > 0 && region_bytes % num_replicas == 0);
+  // Replicas are kept consistent by the parameter synchronization, so the
+  // first one is stored
+  size_t replica_bytes = region_bytes / num_replicas;
+  Tensor &tensor = tensors[name];
+  tensor.data_type = data_type;
+  tensor.dims = dims;
+  char const *ptr = static_cast<char const *>(region);
+  tensor.data.assign(ptr, ptr + replica_bytes);
+}
+
+bool ModelCheckpoint::load_tensor(std::string const &name,
+                                  DataType data_type,
+                                  std::vector<int> const &dims,
+                                  void *region,
+                                  size_t region_bytes,
+                                  int num_replicas,
+                                  std::string &error) const {
+  assert(num_replicas > 0 && region_bytes % num_replicas == 0);
+  auto it = tensors.find(name);
+  if (it == tensors.end()) {
+    error = "no tensor " + name;
+    return false;
+  }
+  Tensor const &tensor = it->second;
+  size_t replica_bytes = region_bytes / num_replicas;
+  if (tensor.data_type != data_type || tensor.dims != dims ||
+      tensor.data.size() != replica_bytes) {
+    error = "tensor " + name + " has a different type or shape";
+    return false;
+  }
+  char *ptr = static_cast<char *>(region);
+  for (int i = 0; i < num_replicas; i++) {
+    memcpy(ptr + i * replica_bytes, tensor.data.data(), replica_bytes);
+  }
+  return true;
+}
+
+void ModelCheckpoint::write(std::ostream &os) const {
+  os.write(MAGIC, sizeof(MAGIC));
+  write_value(os, (int32_t)VERSION);
+  write_value(os, (uint64_t)tensors.size());
+  for (auto const &t : tensors) {
+    write_string(os, t.first);
+    write_value(os, (int32_t)t.second.data_type);
+    write_value(os, (int32_t)t.second.dims.size());
+    for (int d : t.second.dims) {
+      write_value(os, (int32_t)d);
+    }
+    write_value(os, (uint64_t)t.second.data.size());
+    os.write(t.second.data.data(), t.second.data.size());
+  }
+  write_value(os, (uint64_t)scalars.size());
+  for (auto const &s : scalars) {
+    write_string(os, s.first);
+    write_value(os, s.second);
+  }
+}
+
+bool ModelCheckpoint::read(std::istream &is,
+                           ModelCheckpoint &ckpt,
+                           std::string &error) {
+  ckpt = ModelCheckpoint();
+  char magic[sizeof(MAGIC)];
+  int32_t version;
+  if (!is.read(magic, sizeof(magic)) ||
+      memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 ||
+      !read_value(is, version)) {
+    error = "not a checkpoint";
+    return false;
+  }
+  if (version < 1 || version > VERSION) {
+    std::ostringstream oss;
+    oss << "unsupported checkpoint version " << version;
+    error = oss.str();
+    return false;
+  }
+  error = "truncated checkpoint";
+  uint64_t num_tensors;
+  if (!read_value(is, num_tensors)) {
+    return false;
+  }
+  for (uint64_t i = 0; i < num_tensors; i++) {
+    std::string name;
+    int32_t data_type, num_dims;
+    if (!read_string(is, name) || !read_value(is, data_type) ||
+        !read_value(is, num_dims) || num_dims < 0) {
+      return false;
+    }
+    Tensor &tensor = ckpt.tensors[name];
+    tensor.data_type = (DataType)data_type;
+    tensor.dims.resize(num_dims);
+    for (int32_t d = 0; d < num_dims; d++) {
+      int32_t size;
+      if (!read_value(is, size)) {
+        return false;
+      }
+      tensor.dims[d] = size;
+    }
+    uint64_t bytes;
+    if (!read_value(is, bytes)) {
+      return false;
+    }
+    tensor.data.resize(bytes);
+    if (bytes > 0 && !is.read(tensor.data.data(), bytes)) {
+      return false;
+    }
+  }
+  uint64_t num_scalars;
+  if (!read_value(is, num_scalars)) {
+    return false;
+  }
+  for (uint64_t i = 0; i < num_scalars; i++) {
+    std::string name;
+    double value;
+    if (!read_string(is, name) || !read_value(is, value)) {
+      return false;
+    }
+    ckpt.scalars[name] = value;
+  }
+  error.clear();
+  return true;
+}
+
+} // namespace FlexFlow
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cassert>
 #include <cmath>
 #include <functional>
 #include <limits>
@@ -7,7 +9,7 @@
 #include <utility>
 #include <vector>
 
-#include "flexflow/simulator.h"
+#include "flexflow/machine_model.h"
 namespace FlexFlow {
 #define PRINT_EDGE(e, n)                                                       \
   do {                                                                         \
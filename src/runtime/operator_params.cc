@@ -8,8 +8,10 @@
 #include "flexflow/ops/cast.h"
 #include "flexflow/ops/concat.h"
 #include "flexflow/ops/conv_2d.h"
+#include "flexflow/ops/dot_interaction.h"
 #include "flexflow/ops/dropout.h"
 #include "flexflow/ops/element_binary.h"
+#include "flexflow/ops/element_expression.h"
 #include "flexflow/ops/element_unary.h"
 #include "flexflow/ops/embedding.h"
 #include "flexflow/ops/flat.h"
@@ -19,10 +21,12 @@
 #include "flexflow/ops/linear.h"
 #include "flexflow/ops/mean.h"
 #include "flexflow/ops/noop.h"
+#include "flexflow/ops/pad.h"
 #include "flexflow/ops/pool_2d.h"
 #include "flexflow/ops/reduce.h"
 #include "flexflow/ops/reshape.h"
 #include "flexflow/ops/reverse.h"
+#include "flexflow/ops/slice.h"
 #include "flexflow/ops/softmax.h"
 #include "flexflow/ops/split.h"
 #include "flexflow/ops/topk.h"
@@ -76,6 +80,10 @@ tl::optional<OperatorParameters> get_op_parameters(Op const *op) {
       return ((Flat *)op)->get_params();
     case OP_GATHER:
       return ((Gather *)op)->get_params();
+    case OP_DOT_INTERACTION:
+      return ((DotInteraction *)op)->get_params();
+    case OP_ELEMENT_EXPRESSION:
+      return ((ElementExpression *)op)->get_params();
     case OP_MULTIHEAD_ATTENTION:
       return ((MultiHeadAttention *)op)->get_params();
     case OP_LAYERNORM:
@@ -98,6 +106,10 @@ tl::optional<OperatorParameters> get_op_parameters(Op const *op) {
       return ((FusedParallelOp *)op)->get_params();
     case OP_TRANSPOSE:
       return ((Transpose *)op)->get_params();
+    case OP_SLICE:
+      return ((Slice *)op)->get_params();
+    case OP_PAD:
+      return ((Pad *)op)->get_params();
     case OP_BATCHMATMUL:
       return ((BatchMatmul *)op)->get_params();
     case OP_SPLIT:
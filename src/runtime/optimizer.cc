@@ -15,6 +15,7 @@
 
 #include "flexflow/optimizer.h"
 #include "flexflow/model.h"
+#include "flexflow/model_checkpoint.h"
 
 namespace FlexFlow {
 
@@ -23,14 +24,18 @@ using namespace Legion;
 Optimizer::Optimizer(FFModel const *_model) : model(_model) {}
 
 ParallelTensor create_replica_parameter(FFModel const *model,
-                                        const ParallelTensor p) {
+                                        const ParallelTensor p,
+                                        FieldSpace fs = FieldSpace::NO_SPACE) {
   Context ctx = model->config.lg_ctx;
   Runtime *runtime = model->config.lg_hlr;
   ParallelTensor v = new ParallelTensorBase(*p);
   v->region_grad = LogicalRegion::NO_REGION;
   v->part_grad = LogicalPartition::NO_PART;
-  v->region = runtime->create_logical_region(
-      ctx, p->region.get_index_space(), p->region.get_field_space());
+  if (fs == FieldSpace::NO_SPACE) {
+    fs = p->region.get_field_space();
+  }
+  v->region =
+      runtime->create_logical_region(ctx, p->region.get_index_space(), fs);
   if (v->sync_type == ParameterSyncType::PS) {
     // Do nothing
   } else if (v->sync_type == ParameterSyncType::NCCL) {
@@ -42,6 +47,67 @@ ParallelTensor create_replica_parameter(FFModel const *model,
   return v;
 }
 
+// Like create_replica_parameter, but with the single field of fs, for state
+// kept in another precision than the parameter. The state starts at zero
+ParallelTensor create_replica_state(FFModel const *model,
+                                    const ParallelTensor p,
+                                    FieldSpace fs,
+                                    size_t field_size) {
+  Context ctx = model->config.lg_ctx;
+  Runtime *runtime = model->config.lg_hlr;
+  ParallelTensor v = create_replica_parameter(model, p, fs);
+  // Only the element size matters to copies of the codes
+  v->data_type = field_size == sizeof(uint16_t) ? DT_HALF : DT_NONE;
+  uint64_t zero = 0;
+  runtime->fill_field(ctx, v->region, v->region, FID_DATA, &zero, field_size);
+  return v;
+}
+
+// Zero scales for the OPTIMIZER_STATE_INT8 state of p. With NCCL, each
+// point of p->parallel_is gets an equal slice with enough blocks for the
+// largest shard of p
+OptimizerStateScales create_state_scales(FFModel const *model,
+                                         const ParallelTensor p) {
+  Context ctx = model->config.lg_ctx;
+  Runtime *runtime = model->config.lg_hlr;
+  OptimizerStateScales scales;
+  size_t num_blocks = 0;
+  if (p->sync_type == ParameterSyncType::NCCL) {
+    Domain color_domain = runtime->get_index_space_domain(ctx, p->parallel_is);
+    size_t max_shard_volume = 0;
+    for (Domain::DomainPointIterator it(color_domain); it; it++) {
+      LogicalRegion shard =
+          runtime->get_logical_subregion_by_color(ctx, p->part, *it);
+      max_shard_volume = std::max(
+          max_shard_volume,
+          runtime->get_index_space_domain(ctx, shard.get_index_space())
+              .get_volume());
+    }
+    size_t blocks_per_shard =
+        (max_shard_volume + OPTIMIZER_STATE_BLOCK_SIZE - 1) /
+        OPTIMIZER_STATE_BLOCK_SIZE;
+    num_blocks = blocks_per_shard * color_domain.get_volume();
+  } else {
+    Domain domain =
+        runtime->get_index_space_domain(ctx, p->region.get_index_space());
+    num_blocks = (domain.get_volume() + OPTIMIZER_STATE_BLOCK_SIZE - 1) /
+                 OPTIMIZER_STATE_BLOCK_SIZE;
+  }
+  IndexSpace is = runtime->create_index_space(
+      ctx, Rect<1>(Point<1>(0), Point<1>(num_blocks - 1)));
+  scales.region =
+      runtime->create_logical_region(ctx, is, model->config.field_space);
+  if (p->sync_type == ParameterSyncType::NCCL) {
+    IndexPartition ip =
+        runtime->create_equal_partition(ctx, is, p->parallel_is);
+    scales.part = runtime->get_logical_partition(ctx, scales.region, ip);
+  } else {
+    scales.part = LogicalPartition::NO_PART;
+  }
+  runtime->fill_field<float>(ctx, scales.region, scales.region, FID_DATA, 0.0f);
+  return scales;
+}
+
 SGDOptimizer::SGDOptimizer(FFModel const *_model,
                            double _lr,
                            double _momentum,
@@ -87,6 +153,56 @@ void SGDOptimizer::init(void) {
 
 void SGDOptimizer::next(void) {}
 
+float SGDOptimizer::state_bytes_per_parameter(void) const {
+  return momentum > 0.0f ? sizeof(float) : 0.0f;
+}
+
+void SGDOptimizer::reshard_from(
+    Optimizer const *old_optimizer,
+    std::map<ParallelTensor, ParallelTensor> const &old_params) {
+  SGDOptimizer const *old = dynamic_cast<SGDOptimizer const *>(old_optimizer);
+  assert(old != nullptr);
+  if (momentum == 0.0f) {
+    // Stateless
+    return;
+  }
+  assert(old->momentum > 0.0f);
+  for (auto const &p : old_params) {
+    LogicalRegion region = p.first->region, old_region = p.second->region;
+    assert(v_values.find(region) != v_values.end());
+    assert(old->v_values.find(old_region) != old->v_values.end());
+    v_values[region]->reshard_from(model, old->v_values.at(old_region));
+  }
+}
+
+void SGDOptimizer::save_checkpoint(
+    ModelCheckpoint &ckpt,
+    std::map<ParallelTensor, std::string> const &params) const {
+  if (momentum == 0.0f) {
+    return;
+  }
+  for (auto const &p : params) {
+    v_values.at(p.first->region)
+        ->save_checkpoint(model, ckpt, p.second + "/sgd.v");
+  }
+}
+
+bool SGDOptimizer::load_checkpoint(
+    ModelCheckpoint const &ckpt,
+    std::map<ParallelTensor, std::string> const &params,
+    std::string &error) {
+  if (momentum == 0.0f) {
+    return true;
+  }
+  for (auto const &p : params) {
+    if (!v_values.at(p.first->region)
+             ->load_checkpoint(model, ckpt, p.second + "/sgd.v", error)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 void SGDOptimizer::update(const ParallelTensor p) {
   Context ctx = model->config.lg_ctx;
   Runtime *runtime = model->config.lg_hlr;
@@ -326,12 +442,22 @@ AdamOptimizer::AdamOptimizer(FFModel const *_model,
                              double _epsilon)
     : Optimizer(_model), alpha(_alpha), beta1(_beta1), beta2(_beta2),
       weight_decay(_weight_decay), epsilon(_epsilon), alpha_t(_alpha),
-      beta1_t(1.0f), beta2_t(1.0f) {}
+      beta1_t(1.0f), beta2_t(1.0f),
+      state_type(_model->config.optimizer_state_type) {}
 
 void AdamOptimizer::init(void) {
   Context ctx = model->config.lg_ctx;
   Runtime *runtime = model->config.lg_hlr;
   Initializer *initializer = new ZeroInitializer();
+  FieldSpace state_fs = FieldSpace::NO_SPACE;
+  size_t state_size = sizeof(float);
+  if (state_type != OPTIMIZER_STATE_FP32) {
+    state_size = state_type == OPTIMIZER_STATE_BF16 ? sizeof(uint16_t)
+                                                    : sizeof(int8_t);
+    state_fs = runtime->create_field_space(ctx);
+    FieldAllocator allocator = runtime->create_field_allocator(ctx, state_fs);
+    allocator.allocate_field(state_size, FID_DATA);
+  }
   for (size_t i = 0; i < model->parameters.size(); i++) {
     ParallelTensor p = model->parameters[i];
     Domain domain =
@@ -347,10 +473,21 @@ void AdamOptimizer::init(void) {
       case 3:
       case 4:
       case 5: {
-        v_values[p->region] = create_replica_parameter(model, p);
-        m_values[p->region] = create_replica_parameter(model, p);
-        initializer->init(model, v_values[p->region]);
-        initializer->init(model, m_values[p->region]);
+        if (state_type == OPTIMIZER_STATE_FP32) {
+          v_values[p->region] = create_replica_parameter(model, p);
+          m_values[p->region] = create_replica_parameter(model, p);
+          initializer->init(model, v_values[p->region]);
+          initializer->init(model, m_values[p->region]);
+        } else {
+          v_values[p->region] =
+              create_replica_state(model, p, state_fs, state_size);
+          m_values[p->region] =
+              create_replica_state(model, p, state_fs, state_size);
+        }
+        if (state_type == OPTIMIZER_STATE_INT8) {
+          v_scales[p->region] = create_state_scales(model, p);
+          m_scales[p->region] = create_state_scales(model, p);
+        }
         break;
       }
       default: {
@@ -367,6 +504,96 @@ void AdamOptimizer::set_weight_decay(double _weight_decay) {
   weight_decay = _weight_decay;
 }
 
+void AdamOptimizer::set_state_type(OptimizerStateType _state_type) {
+  assert(v_values.empty() && "set_state_type must be called before init");
+  state_type = _state_type;
+}
+
+float AdamOptimizer::state_bytes_per_parameter(void) const {
+  // The first and the second moments
+  return 2 * optimizer_state_bytes(state_type);
+}
+
+void AdamOptimizer::reshard_from(
+    Optimizer const *old_optimizer,
+    std::map<ParallelTensor, ParallelTensor> const &old_params) {
+  AdamOptimizer const *old =
+      dynamic_cast<AdamOptimizer const *>(old_optimizer);
+  assert(old != nullptr);
+  assert(old->state_type == state_type);
+  // Resume at the same step
+  alpha_t = old->alpha_t;
+  beta1_t = old->beta1_t;
+  beta2_t = old->beta2_t;
+  if (state_type == OPTIMIZER_STATE_INT8) {
+    // The blocks follow the shards, so the codes cannot be copied to another
+    // partitioning; restart the moments from zero like a fresh optimizer
+    fprintf(stderr,
+            "Warning: the int8 Adam state is reset when resharding\n");
+    alpha_t = alpha;
+    beta1_t = 1.0f;
+    beta2_t = 1.0f;
+    return;
+  }
+  for (auto const &p : old_params) {
+    LogicalRegion region = p.first->region, old_region = p.second->region;
+    assert(v_values.find(region) != v_values.end());
+    assert(old->v_values.find(old_region) != old->v_values.end());
+    v_values[region]->reshard_from(model, old->v_values.at(old_region));
+    m_values[region]->reshard_from(model, old->m_values.at(old_region));
+  }
+}
+
+void AdamOptimizer::save_checkpoint(
+    ModelCheckpoint &ckpt,
+    std::map<ParallelTensor, std::string> const &params) const {
+  ckpt.scalars["adam.state_type"] = state_type;
+  if (state_type == OPTIMIZER_STATE_INT8) {
+    // The blocks follow the shards, see reshard_from
+    fprintf(stderr,
+            "Warning: the int8 Adam state is not saved in checkpoints\n");
+    return;
+  }
+  ckpt.scalars["adam.alpha_t"] = alpha_t;
+  ckpt.scalars["adam.beta1_t"] = beta1_t;
+  ckpt.scalars["adam.beta2_t"] = beta2_t;
+  for (auto const &p : params) {
+    LogicalRegion region = p.first->region;
+    v_values.at(region)->save_checkpoint(model, ckpt, p.second + "/adam.v");
+    m_values.at(region)->save_checkpoint(model, ckpt, p.second + "/adam.m");
+  }
+}
+
+bool AdamOptimizer::load_checkpoint(
+    ModelCheckpoint const &ckpt,
+    std::map<ParallelTensor, std::string> const &params,
+    std::string &error) {
+  auto type = ckpt.scalars.find("adam.state_type");
+  if (type == ckpt.scalars.end() || type->second != state_type) {
+    error = "the checkpoint has no Adam state of the same type";
+    return false;
+  }
+  if (state_type == OPTIMIZER_STATE_INT8) {
+    // Keep the fresh state of init, like reshard_from
+    fprintf(stderr,
+            "Warning: the int8 Adam state is reset when loading checkpoints\n");
+    return true;
+  }
+  alpha_t = ckpt.scalars.at("adam.alpha_t");
+  beta1_t = ckpt.scalars.at("adam.beta1_t");
+  beta2_t = ckpt.scalars.at("adam.beta2_t");
+  for (auto const &p : params) {
+    LogicalRegion region = p.first->region;
+    if (!v_values.at(region)->load_checkpoint(
+            model, ckpt, p.second + "/adam.v", error) ||
+        !m_values.at(region)->load_checkpoint(
+            model, ckpt, p.second + "/adam.m", error)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 void AdamOptimizer::next(void) {
   beta1_t *= beta1;
   beta2_t *= beta2;
@@ -408,6 +635,22 @@ void AdamOptimizer::update(const ParallelTensor p) {
                           EXCLUSIVE,
                           m_values[p->region]->region));
     launcher.add_field(3, FID_DATA);
+    if (state_type == OPTIMIZER_STATE_INT8) {
+      // regions[4]: v_scales
+      launcher.add_region_requirement(
+          RegionRequirement(v_scales[p->region].region,
+                            READ_WRITE,
+                            EXCLUSIVE,
+                            v_scales[p->region].region));
+      launcher.add_field(4, FID_DATA);
+      // regions[5]: m_scales
+      launcher.add_region_requirement(
+          RegionRequirement(m_scales[p->region].region,
+                            READ_WRITE,
+                            EXCLUSIVE,
+                            m_scales[p->region].region));
+      launcher.add_field(5, FID_DATA);
+    }
     runtime->execute_task(ctx, launcher);
     // Parameter prefetching optimizations to reduce comm. overhead
     // Directly send the parameters back to all worker devices after SGD
@@ -480,6 +723,24 @@ void AdamOptimizer::update(const ParallelTensor p) {
                           EXCLUSIVE,
                           m_values[p->region]->region));
     launcher.add_field(3, FID_DATA);
+    if (state_type == OPTIMIZER_STATE_INT8) {
+      // regions[4]: v_scales
+      launcher.add_region_requirement(
+          RegionRequirement(v_scales[p->region].part,
+                            0 /*projection id*/,
+                            READ_WRITE,
+                            EXCLUSIVE,
+                            v_scales[p->region].region));
+      launcher.add_field(4, FID_DATA);
+      // regions[5]: m_scales
+      launcher.add_region_requirement(
+          RegionRequirement(m_scales[p->region].part,
+                            0 /*projection id*/,
+                            READ_WRITE,
+                            EXCLUSIVE,
+                            m_scales[p->region].region));
+      launcher.add_field(5, FID_DATA);
+    }
     // MustEpochLauncher must_epoch_launcher;
     // must_epoch_launcher.add_index_task(launcher);
     FutureMap fm = runtime->execute_index_space(ctx, launcher);
@@ -490,17 +751,62 @@ void AdamOptimizer::update(const ParallelTensor p) {
   }
 }
 
+// The moments of op->state_type are in regions[2] and regions[3], and their
+// OPTIMIZER_STATE_INT8 scales in regions[4] and regions[5]
+static void get_adam_state_ptrs(AdamOptimizer const *op,
+                                Task const *task,
+                                std::vector<PhysicalRegion> const &regions,
+                                Context ctx,
+                                Runtime *runtime,
+                                void *&v_ptr,
+                                void *&m_ptr,
+                                float *&v_scale_ptr,
+                                float *&m_scale_ptr) {
+  v_scale_ptr = m_scale_ptr = NULL;
+  switch (op->state_type) {
+    case OPTIMIZER_STATE_FP32: {
+      assert(regions.size() == 4);
+      v_ptr = helperGetTensorPointerRW<float>(
+          regions[2], task->regions[2], FID_DATA, ctx, runtime);
+      m_ptr = helperGetTensorPointerRW<float>(
+          regions[3], task->regions[3], FID_DATA, ctx, runtime);
+      break;
+    }
+    case OPTIMIZER_STATE_BF16: {
+      assert(regions.size() == 4);
+      v_ptr = helperGetTensorPointerRW<uint16_t>(
+          regions[2], task->regions[2], FID_DATA, ctx, runtime);
+      m_ptr = helperGetTensorPointerRW<uint16_t>(
+          regions[3], task->regions[3], FID_DATA, ctx, runtime);
+      break;
+    }
+    case OPTIMIZER_STATE_INT8: {
+      assert(regions.size() == 6);
+      v_ptr = helperGetTensorPointerRW<uint8_t>(
+          regions[2], task->regions[2], FID_DATA, ctx, runtime);
+      m_ptr = helperGetTensorPointerRW<int8_t>(
+          regions[3], task->regions[3], FID_DATA, ctx, runtime);
+      v_scale_ptr = helperGetTensorPointerRW<float>(
+          regions[4], task->regions[4], FID_DATA, ctx, runtime);
+      m_scale_ptr = helperGetTensorPointerRW<float>(
+          regions[5], task->regions[5], FID_DATA, ctx, runtime);
+      break;
+    }
+    default:
+      assert(false);
+  }
+}
+
 void AdamOptimizer::ps_update_task(Task const *task,
                                    std::vector<PhysicalRegion> const &regions,
                                    Context ctx,
                                    Runtime *runtime) {
-  assert(regions.size() == 4);
-  assert(task->regions.size() == 4);
+  assert(task->regions.size() == regions.size());
   AdamOptimizer const *op = (AdamOptimizer *)task->args;
   Domain domain = runtime->get_index_space_domain(
       ctx, task->regions[1].region.get_index_space());
   float const *w_grad_ptr = NULL;
-  float *w_ptr = NULL, *v_ptr = NULL, *m_ptr = NULL;
+  float *w_ptr = NULL;
   size_t size = 0, num_replicas = 0;
   switch (domain.get_dim()) {
 #define DIMFUNC(DIM)                                                           \
@@ -513,25 +819,11 @@ void AdamOptimizer::ps_update_task(Task const *task,
                                      ctx,                                      \
                                      runtime,                                  \
                                      true /*readOutput*/);                     \
-    TensorAccessorW<float, DIM> accV(regions[2],                               \
-                                     task->regions[2],                         \
-                                     FID_DATA,                                 \
-                                     ctx,                                      \
-                                     runtime,                                  \
-                                     true /*readOutput*/);                     \
-    TensorAccessorW<float, DIM> accM(regions[3],                               \
-                                     task->regions[3],                         \
-                                     FID_DATA,                                 \
-                                     ctx,                                      \
-                                     runtime,                                  \
-                                     true /*readOutput*/);                     \
     size = accW.rect.volume();                                                 \
     assert(accWGrad.rect.volume() % accW.rect.volume() == 0);                  \
     num_replicas = accWGrad.rect.volume() / accW.rect.volume();                \
     w_grad_ptr = accWGrad.ptr;                                                 \
     w_ptr = accW.ptr;                                                          \
-    v_ptr = accV.ptr;                                                          \
-    m_ptr = accM.ptr;                                                          \
     break;                                                                     \
   }
     LEGION_FOREACH_N(DIMFUNC)
@@ -542,7 +834,19 @@ void AdamOptimizer::ps_update_task(Task const *task,
     }
   }
 
-  ps_update_task_gpu(op, w_grad_ptr, size, num_replicas, w_ptr, v_ptr, m_ptr);
+  void *v_ptr = NULL, *m_ptr = NULL;
+  float *v_scale_ptr = NULL, *m_scale_ptr = NULL;
+  get_adam_state_ptrs(
+      op, task, regions, ctx, runtime, v_ptr, m_ptr, v_scale_ptr, m_scale_ptr);
+  ps_update_task_gpu(op,
+                     w_grad_ptr,
+                     size,
+                     num_replicas,
+                     w_ptr,
+                     v_ptr,
+                     m_ptr,
+                     v_scale_ptr,
+                     m_scale_ptr);
 }
 
 #ifdef FF_USE_NCCL
@@ -550,15 +854,14 @@ void AdamOptimizer::nccl_update_task(Task const *task,
                                      std::vector<PhysicalRegion> const &regions,
                                      Context ctx,
                                      Runtime *runtime) {
-  assert(regions.size() == 4);
-  assert(task->regions.size() == 4);
+  assert(task->regions.size() == regions.size());
   AdamOptimizer const *op = (AdamOptimizer *)task->args;
   OpMeta const *meta = *((OpMeta **)task->local_args);
   // FFHandler handler = *((FFHandler*) task->local_args);
   Domain domain = runtime->get_index_space_domain(
       ctx, task->regions[1].region.get_index_space());
   float const *w_grad_ptr = NULL;
-  float *w_ptr = NULL, *v_ptr = NULL, *m_ptr = NULL;
+  float *w_ptr = NULL;
   size_t size = 0;
   switch (domain.get_dim()) {
 #define DIMFUNC(DIM)                                                           \
@@ -571,26 +874,10 @@ void AdamOptimizer::nccl_update_task(Task const *task,
                                      ctx,                                      \
                                      runtime,                                  \
                                      true /*readOutput*/);                     \
-    TensorAccessorW<float, DIM> accV(regions[2],                               \
-                                     task->regions[2],                         \
-                                     FID_DATA,                                 \
-                                     ctx,                                      \
-                                     runtime,                                  \
-                                     true /*readOutput*/);                     \
-    TensorAccessorW<float, DIM> accM(regions[3],                               \
-                                     task->regions[3],                         \
-                                     FID_DATA,                                 \
-                                     ctx,                                      \
-                                     runtime,                                  \
-                                     true /*readOutput*/);                     \
     size = accW.rect.volume();                                                 \
     assert(accWGrad.rect == accW.rect);                                        \
-    assert(accWGrad.rect == accV.rect);                                        \
-    assert(accWGrad.rect == accM.rect);                                        \
     w_grad_ptr = accWGrad.ptr;                                                 \
     w_ptr = accW.ptr;                                                          \
-    v_ptr = accV.ptr;                                                          \
-    m_ptr = accM.ptr;                                                          \
     break;                                                                     \
   }
     LEGION_FOREACH_N(DIMFUNC)
@@ -601,7 +888,481 @@ void AdamOptimizer::nccl_update_task(Task const *task,
     }
   }
 
-  nccl_update_task_gpu(op, meta, w_grad_ptr, size, w_ptr, v_ptr, m_ptr);
+  void *v_ptr = NULL, *m_ptr = NULL;
+  float *v_scale_ptr = NULL, *m_scale_ptr = NULL;
+  get_adam_state_ptrs(
+      op, task, regions, ctx, runtime, v_ptr, m_ptr, v_scale_ptr, m_scale_ptr);
+  nccl_update_task_gpu(op,
+                       meta,
+                       w_grad_ptr,
+                       size,
+                       w_ptr,
+                       v_ptr,
+                       m_ptr,
+                       v_scale_ptr,
+                       m_scale_ptr);
+}
+#endif
+
+// ------------------------------------------------------------------
+//                   Layer-wise adaptive optimizers
+// ------------------------------------------------------------------
+
+// Launch the update of p by LAMB or LARS. The regions of the task are the
+// gradients, the weights and then the fp32 states, all shaped like p
+static void launch_layerwise_update(FFModel const *model,
+                                    const ParallelTensor p,
+                                    TaskID ps_task_id,
+                                    TaskID nccl_task_id,
+                                    TaskArgument const &arg,
+                                    std::vector<ParallelTensor> const &states) {
+  Context ctx = model->config.lg_ctx;
+  Runtime *runtime = model->config.lg_hlr;
+  assert(p->owner_op != NULL);
+  if (p->sync_type == ParameterSyncType::PS) {
+    TaskLauncher launcher(ps_task_id,
+                          arg,
+                          Predicate::TRUE_PRED,
+                          0 /*mapper_id*/,
+                          p->machine_view.hash());
+    // regions[0]: region_grad
+    launcher.add_region_requirement(RegionRequirement(
+        p->region_grad, READ_ONLY, EXCLUSIVE, p->region_grad));
+    launcher.add_field(0, FID_DATA);
+    // regions[1]: region
+    launcher.add_region_requirement(
+        RegionRequirement(p->region, READ_WRITE, EXCLUSIVE, p->region));
+    launcher.add_field(1, FID_DATA);
+    // regions[2...]: states
+    for (size_t i = 0; i < states.size(); i++) {
+      launcher.add_region_requirement(RegionRequirement(
+          states[i]->region, READ_WRITE, EXCLUSIVE, states[i]->region));
+      launcher.add_field(2 + i, FID_DATA);
+    }
+    runtime->execute_task(ctx, launcher);
+    // Directly send the parameters back to all worker devices
+    ArgumentMap argmap;
+    IndexLauncher index_launcher(PS_PREFETCH_TASK_ID,
+                                 p->parallel_is,
+                                 TaskArgument(NULL, 0),
+                                 argmap,
+                                 Predicate::TRUE_PRED,
+                                 false /*must*/,
+                                 0 /*mapper_id*/,
+                                 p->machine_view.hash());
+    // regions[0]: region
+    index_launcher.add_region_requirement(RegionRequirement(
+        p->part, 0 /*projection*/, READ_ONLY, EXCLUSIVE, p->region));
+    index_launcher.add_field(0, FID_DATA);
+    runtime->execute_index_space(ctx, index_launcher);
+  } else if (p->sync_type == ParameterSyncType::NCCL) {
+    assert(p->owner_op->op_type != OP_FUSED);
+    assert(p->parallel_is != IndexSpace::NO_SPACE);
+    ArgumentMap argmap;
+    Domain domain = runtime->get_index_space_domain(ctx, p->parallel_is);
+    // Every point contributes its shard to the norms, and the points that
+    // hold the same shard must only be counted once
+    int num_parts = 1;
+    for (int i = 0; i < p->num_dims; i++) {
+      if (!p->dims[i].is_replica_dim) {
+        num_parts *= p->dims[i].degree;
+      }
+    }
+    assert(domain.get_volume() % num_parts == 0);
+    LayerwiseUpdateArgs args;
+    args.num_replicas = domain.get_volume() / num_parts;
+    switch (domain.get_dim()) {
+#define DIMFUNC(DIM)                                                           \
+  case DIM: {                                                                  \
+    Rect<DIM> rect = domain;                                                   \
+    int idx = 0;                                                               \
+    for (PointInRectIterator<DIM> it(rect); it(); it++) {                      \
+      args.meta = p->owner_op->meta[idx++];                                    \
+      argmap.set_point(*it,                                                    \
+                       TaskArgument(&args, sizeof(LayerwiseUpdateArgs)));      \
+    }                                                                          \
+    break;                                                                     \
+  }
+      LEGION_FOREACH_N(DIMFUNC)
+#undef DIMFUNC
+      default:
+        assert(false);
+    }
+    IndexLauncher launcher(nccl_task_id,
+                           p->parallel_is,
+                           arg,
+                           argmap,
+                           Predicate::TRUE_PRED,
+                           false /*must_epoch*/,
+                           0 /*mapper_id*/,
+                           p->machine_view.hash());
+    // regions[0]: region_grad
+    launcher.add_region_requirement(RegionRequirement(p->part_grad,
+                                                      0 /*projection id*/,
+                                                      READ_ONLY,
+                                                      EXCLUSIVE,
+                                                      p->region_grad));
+    launcher.add_field(0, FID_DATA);
+    // regions[1]: region
+    launcher.add_region_requirement(RegionRequirement(
+        p->part, 0 /*projection id*/, READ_WRITE, EXCLUSIVE, p->region));
+    launcher.add_field(1, FID_DATA);
+    // regions[2...]: states
+    for (size_t i = 0; i < states.size(); i++) {
+      launcher.add_region_requirement(RegionRequirement(states[i]->part,
+                                                        0 /*projection id*/,
+                                                        READ_WRITE,
+                                                        EXCLUSIVE,
+                                                        states[i]->region));
+      launcher.add_field(2 + i, FID_DATA);
+    }
+    runtime->execute_index_space(ctx, launcher);
+    runtime->issue_execution_fence(ctx);
+  } else {
+    assert(false);
+  }
+}
+
+// The pointers of a task launched by launch_layerwise_update. num_replicas
+// is the number of copies of the gradients a parameter server gathers
+static void
+    get_layerwise_update_ptrs(Task const *task,
+                              std::vector<PhysicalRegion> const &regions,
+                              Context ctx,
+                              Runtime *runtime,
+                              float const *&w_grad_ptr,
+                              float *&w_ptr,
+                              std::vector<float *> &state_ptrs,
+                              size_t &size,
+                              int &num_replicas) {
+  assert(regions.size() == task->regions.size());
+  assert(regions.size() == 2 + state_ptrs.size());
+  Domain grad_domain = runtime->get_index_space_domain(
+      ctx, task->regions[0].region.get_index_space());
+  Domain domain = runtime->get_index_space_domain(
+      ctx, task->regions[1].region.get_index_space());
+  size = domain.get_volume();
+  assert(grad_domain.get_volume() % size == 0);
+  num_replicas = grad_domain.get_volume() / size;
+  w_grad_ptr = helperGetTensorPointerRO<float>(
+      regions[0], task->regions[0], FID_DATA, ctx, runtime);
+  w_ptr = helperGetTensorPointerRW<float>(
+      regions[1], task->regions[1], FID_DATA, ctx, runtime);
+  for (size_t i = 0; i < state_ptrs.size(); i++) {
+    assert(runtime
+               ->get_index_space_domain(
+                   ctx, task->regions[2 + i].region.get_index_space())
+               .get_volume() == size);
+    state_ptrs[i] = helperGetTensorPointerRW<float>(
+        regions[2 + i], task->regions[2 + i], FID_DATA, ctx, runtime);
+  }
+}
+
+// Zeroed fp32 state for every parameter of the model
+static void init_layerwise_state(
+    FFModel const *model,
+    std::map<LogicalRegion, ParallelTensor> &values) {
+  Context ctx = model->config.lg_ctx;
+  Runtime *runtime = model->config.lg_hlr;
+  Initializer *initializer = new ZeroInitializer();
+  for (size_t i = 0; i < model->parameters.size(); i++) {
+    ParallelTensor p = model->parameters[i];
+    Domain domain =
+        runtime->get_index_space_domain(ctx, p->region.get_index_space());
+    // Do not support 0-dim parameter
+    assert(domain.get_dim() >= 1 && domain.get_dim() <= 5);
+    values[p->region] = create_replica_parameter(model, p);
+    initializer->init(model, values[p->region]);
+  }
+  delete initializer;
+}
+
+LAMBOptimizer::LAMBOptimizer(FFModel const *_model,
+                             double _lr,
+                             double _beta1,
+                             double _beta2,
+                             double _weight_decay,
+                             double _epsilon)
+    : Optimizer(_model), lr(_lr), beta1(_beta1), beta2(_beta2),
+      weight_decay(_weight_decay), epsilon(_epsilon), beta1_t(1.0f),
+      beta2_t(1.0f) {}
+
+void LAMBOptimizer::init(void) {
+  init_layerwise_state(model, v_values);
+  init_layerwise_state(model, m_values);
+}
+
+void LAMBOptimizer::next(void) {
+  beta1_t *= beta1;
+  beta2_t *= beta2;
+}
+
+void LAMBOptimizer::set_weight_decay(double _weight_decay) {
+  weight_decay = _weight_decay;
+}
+
+float LAMBOptimizer::state_bytes_per_parameter(void) const {
+  // The first and the second moments
+  return 2 * sizeof(float);
+}
+
+LAMBStep LAMBOptimizer::get_step(void) const {
+  LAMBStep step;
+  step.lr = lr;
+  step.beta1 = beta1;
+  step.beta2 = beta2;
+  step.bias_correction1 = 1 - beta1_t;
+  step.bias_correction2 = 1 - beta2_t;
+  step.weight_decay = weight_decay;
+  step.epsilon = epsilon;
+  return step;
+}
+
+void LAMBOptimizer::reshard_from(
+    Optimizer const *old_optimizer,
+    std::map<ParallelTensor, ParallelTensor> const &old_params) {
+  LAMBOptimizer const *old =
+      dynamic_cast<LAMBOptimizer const *>(old_optimizer);
+  assert(old != nullptr);
+  // Resume at the same step
+  beta1_t = old->beta1_t;
+  beta2_t = old->beta2_t;
+  for (auto const &p : old_params) {
+    LogicalRegion region = p.first->region, old_region = p.second->region;
+    assert(v_values.find(region) != v_values.end());
+    assert(old->v_values.find(old_region) != old->v_values.end());
+    v_values[region]->reshard_from(model, old->v_values.at(old_region));
+    m_values[region]->reshard_from(model, old->m_values.at(old_region));
+  }
+}
+
+void LAMBOptimizer::save_checkpoint(
+    ModelCheckpoint &ckpt,
+    std::map<ParallelTensor, std::string> const &params) const {
+  ckpt.scalars["lamb.beta1_t"] = beta1_t;
+  ckpt.scalars["lamb.beta2_t"] = beta2_t;
+  for (auto const &p : params) {
+    LogicalRegion region = p.first->region;
+    v_values.at(region)->save_checkpoint(model, ckpt, p.second + "/lamb.v");
+    m_values.at(region)->save_checkpoint(model, ckpt, p.second + "/lamb.m");
+  }
+}
+
+bool LAMBOptimizer::load_checkpoint(
+    ModelCheckpoint const &ckpt,
+    std::map<ParallelTensor, std::string> const &params,
+    std::string &error) {
+  if (ckpt.scalars.find("lamb.beta1_t") == ckpt.scalars.end()) {
+    error = "the checkpoint has no LAMB state";
+    return false;
+  }
+  beta1_t = ckpt.scalars.at("lamb.beta1_t");
+  beta2_t = ckpt.scalars.at("lamb.beta2_t");
+  for (auto const &p : params) {
+    LogicalRegion region = p.first->region;
+    if (!v_values.at(region)->load_checkpoint(
+            model, ckpt, p.second + "/lamb.v", error) ||
+        !m_values.at(region)->load_checkpoint(
+            model, ckpt, p.second + "/lamb.m", error)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void LAMBOptimizer::update(const ParallelTensor p) {
+  assert(v_values.find(p->region) != v_values.end());
+  assert(m_values.find(p->region) != m_values.end());
+  launch_layerwise_update(model,
+                          p,
+                          LAMB_UPD_PS_TASK_ID,
+                          LAMB_UPD_NCCL_TASK_ID,
+                          TaskArgument(this, sizeof(LAMBOptimizer)),
+                          {v_values[p->region], m_values[p->region]});
+}
+
+void LAMBOptimizer::ps_update_task(Task const *task,
+                                   std::vector<PhysicalRegion> const &regions,
+                                   Context ctx,
+                                   Runtime *runtime) {
+  LAMBOptimizer const *op = (LAMBOptimizer *)task->args;
+  float const *w_grad_ptr = NULL;
+  float *w_ptr = NULL;
+  std::vector<float *> state_ptrs(2);
+  size_t size = 0;
+  int num_replicas = 0;
+  get_layerwise_update_ptrs(task,
+                            regions,
+                            ctx,
+                            runtime,
+                            w_grad_ptr,
+                            w_ptr,
+                            state_ptrs,
+                            size,
+                            num_replicas);
+  ps_update_task_gpu(op,
+                     w_grad_ptr,
+                     size,
+                     num_replicas,
+                     w_ptr,
+                     state_ptrs[0],
+                     state_ptrs[1]);
+}
+
+#ifdef FF_USE_NCCL
+void LAMBOptimizer::nccl_update_task(Task const *task,
+                                     std::vector<PhysicalRegion> const &regions,
+                                     Context ctx,
+                                     Runtime *runtime) {
+  LAMBOptimizer const *op = (LAMBOptimizer *)task->args;
+  LayerwiseUpdateArgs const &args = *((LayerwiseUpdateArgs *)task->local_args);
+  float const *w_grad_ptr = NULL;
+  float *w_ptr = NULL;
+  std::vector<float *> state_ptrs(2);
+  size_t size = 0;
+  int num_replicas = 0;
+  get_layerwise_update_ptrs(task,
+                            regions,
+                            ctx,
+                            runtime,
+                            w_grad_ptr,
+                            w_ptr,
+                            state_ptrs,
+                            size,
+                            num_replicas);
+  assert(num_replicas == 1);
+  nccl_update_task_gpu(
+      op, args, w_grad_ptr, size, w_ptr, state_ptrs[0], state_ptrs[1]);
+}
+#endif
+
+LARSOptimizer::LARSOptimizer(FFModel const *_model,
+                             double _lr,
+                             double _momentum,
+                             double _weight_decay,
+                             double _trust_coefficient,
+                             double _epsilon)
+    : Optimizer(_model), lr(_lr), momentum(_momentum),
+      weight_decay(_weight_decay), trust_coefficient(_trust_coefficient),
+      epsilon(_epsilon) {}
+
+void LARSOptimizer::init(void) {
+  init_layerwise_state(model, v_values);
+}
+
+void LARSOptimizer::next(void) {}
+
+void LARSOptimizer::set_weight_decay(double _weight_decay) {
+  weight_decay = _weight_decay;
+}
+
+float LARSOptimizer::state_bytes_per_parameter(void) const {
+  // The momentum
+  return sizeof(float);
+}
+
+LARSStep LARSOptimizer::get_step(void) const {
+  LARSStep step;
+  step.lr = lr;
+  step.momentum = momentum;
+  step.weight_decay = weight_decay;
+  step.trust_coefficient = trust_coefficient;
+  step.epsilon = epsilon;
+  return step;
+}
+
+void LARSOptimizer::reshard_from(
+    Optimizer const *old_optimizer,
+    std::map<ParallelTensor, ParallelTensor> const &old_params) {
+  LARSOptimizer const *old =
+      dynamic_cast<LARSOptimizer const *>(old_optimizer);
+  assert(old != nullptr);
+  for (auto const &p : old_params) {
+    LogicalRegion region = p.first->region, old_region = p.second->region;
+    assert(v_values.find(region) != v_values.end());
+    assert(old->v_values.find(old_region) != old->v_values.end());
+    v_values[region]->reshard_from(model, old->v_values.at(old_region));
+  }
+}
+
+void LARSOptimizer::save_checkpoint(
+    ModelCheckpoint &ckpt,
+    std::map<ParallelTensor, std::string> const &params) const {
+  for (auto const &p : params) {
+    v_values.at(p.first->region)
+        ->save_checkpoint(model, ckpt, p.second + "/lars.v");
+  }
+}
+
+bool LARSOptimizer::load_checkpoint(
+    ModelCheckpoint const &ckpt,
+    std::map<ParallelTensor, std::string> const &params,
+    std::string &error) {
+  for (auto const &p : params) {
+    if (!v_values.at(p.first->region)
+             ->load_checkpoint(model, ckpt, p.second + "/lars.v", error)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void LARSOptimizer::update(const ParallelTensor p) {
+  assert(v_values.find(p->region) != v_values.end());
+  launch_layerwise_update(model,
+                          p,
+                          LARS_UPD_PS_TASK_ID,
+                          LARS_UPD_NCCL_TASK_ID,
+                          TaskArgument(this, sizeof(LARSOptimizer)),
+                          {v_values[p->region]});
+}
+
+void LARSOptimizer::ps_update_task(Task const *task,
+                                   std::vector<PhysicalRegion> const &regions,
+                                   Context ctx,
+                                   Runtime *runtime) {
+  LARSOptimizer const *op = (LARSOptimizer *)task->args;
+  float const *w_grad_ptr = NULL;
+  float *w_ptr = NULL;
+  std::vector<float *> state_ptrs(1);
+  size_t size = 0;
+  int num_replicas = 0;
+  get_layerwise_update_ptrs(task,
+                            regions,
+                            ctx,
+                            runtime,
+                            w_grad_ptr,
+                            w_ptr,
+                            state_ptrs,
+                            size,
+                            num_replicas);
+  ps_update_task_gpu(
+      op, w_grad_ptr, size, num_replicas, w_ptr, state_ptrs[0]);
+}
+
+#ifdef FF_USE_NCCL
+void LARSOptimizer::nccl_update_task(Task const *task,
+                                     std::vector<PhysicalRegion> const &regions,
+                                     Context ctx,
+                                     Runtime *runtime) {
+  LARSOptimizer const *op = (LARSOptimizer *)task->args;
+  LayerwiseUpdateArgs const &args = *((LayerwiseUpdateArgs *)task->local_args);
+  float const *w_grad_ptr = NULL;
+  float *w_ptr = NULL;
+  std::vector<float *> state_ptrs(1);
+  size_t size = 0;
+  int num_replicas = 0;
+  get_layerwise_update_ptrs(task,
+                            regions,
+                            ctx,
+                            runtime,
+                            w_grad_ptr,
+                            w_ptr,
+                            state_ptrs,
+                            size,
+                            num_replicas);
+  assert(num_replicas == 1);
+  nccl_update_task_gpu(op, args, w_grad_ptr, size, w_ptr, state_ptrs[0]);
 }
 #endif
 
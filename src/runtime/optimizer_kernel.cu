@@ -149,13 +149,136 @@ __global__ void adam_update(int count,
   }
 }
 
+__global__ void adam_update_bf16(int count,
+                                 AdamStep step,
+                                 float const *WGrad,
+                                 uint16_t *M,
+                                 uint16_t *V,
+                                 float *W) {
+  CUDA_KERNEL_LOOP(i, count) {
+    float mt = bf16_to_float(M[i]), vt = bf16_to_float(V[i]);
+    adam_step(step, WGrad[i], W[i], mt, vt);
+    M[i] = float_to_bf16(mt);
+    V[i] = float_to_bf16(vt);
+  }
+}
+
+// A thread block updates a block of OPTIMIZER_STATE_BLOCK_SIZE elements and
+// reduces the new maxima of its moments before requantizing them
+__global__ void adam_update_int8(size_t count,
+                                 AdamStep step,
+                                 float const *WGrad,
+                                 int8_t *M,
+                                 uint8_t *V,
+                                 float *MScales,
+                                 float *VScales,
+                                 float *W) {
+  __shared__ float m_max[OPTIMIZER_STATE_BLOCK_SIZE];
+  __shared__ float v_max[OPTIMIZER_STATE_BLOCK_SIZE];
+  size_t num_blocks =
+      (count + OPTIMIZER_STATE_BLOCK_SIZE - 1) / OPTIMIZER_STATE_BLOCK_SIZE;
+  int const t = threadIdx.x;
+  for (size_t b = blockIdx.x; b < num_blocks; b += gridDim.x) {
+    size_t i = b * OPTIMIZER_STATE_BLOCK_SIZE + t;
+    float mt = 0.0f, vt = 0.0f;
+    if (i < count) {
+      mt = dequantize_first_moment(M[i], MScales[b]);
+      vt = dequantize_second_moment(V[i], VScales[b]);
+      adam_step(step, WGrad[i], W[i], mt, vt);
+    }
+    m_max[t] = fabsf(mt);
+    v_max[t] = vt;
+    __syncthreads();
+    for (int s = OPTIMIZER_STATE_BLOCK_SIZE / 2; s > 0; s >>= 1) {
+      if (t < s) {
+        m_max[t] = fmaxf(m_max[t], m_max[t + s]);
+        v_max[t] = fmaxf(v_max[t], v_max[t + s]);
+      }
+      __syncthreads();
+    }
+    float m_absmax = m_max[0], v_maxval = v_max[0];
+    if (i < count) {
+      M[i] = quantize_first_moment(mt, m_absmax);
+      V[i] = quantize_second_moment(vt, v_maxval);
+    }
+    if (t == 0) {
+      MScales[b] = m_absmax;
+      VScales[b] = v_maxval;
+    }
+    __syncthreads();
+  }
+}
+
+// Launches the Adam update that matches the precision of the moments
+static void adam_update_state(AdamOptimizer const *op,
+                              float const *w_grad_ptr,
+                              size_t size,
+                              float *w_ptr,
+                              void *v_ptr,
+                              void *m_ptr,
+                              float *v_scale_ptr,
+                              float *m_scale_ptr,
+                              cudaStream_t stream) {
+  AdamStep step;
+  step.alpha_t = op->alpha_t;
+  step.beta1 = op->beta1;
+  step.beta2 = op->beta2;
+  step.weight_decay = op->weight_decay;
+  step.epsilon = op->epsilon;
+  switch (op->state_type) {
+    case OPTIMIZER_STATE_FP32: {
+      adam_update<<<GET_BLOCKS(size), CUDA_NUM_THREADS, 0, stream>>>(
+          size,
+          op->alpha_t,
+          op->beta1,
+          op->beta2,
+          op->weight_decay,
+          op->epsilon,
+          w_grad_ptr,
+          (float *)m_ptr,
+          (float *)v_ptr,
+          w_ptr);
+      break;
+    }
+    case OPTIMIZER_STATE_BF16: {
+      adam_update_bf16<<<GET_BLOCKS(size), CUDA_NUM_THREADS, 0, stream>>>(
+          size,
+          step,
+          w_grad_ptr,
+          (uint16_t *)m_ptr,
+          (uint16_t *)v_ptr,
+          w_ptr);
+      break;
+    }
+    case OPTIMIZER_STATE_INT8: {
+      size_t num_blocks =
+          (size + OPTIMIZER_STATE_BLOCK_SIZE - 1) / OPTIMIZER_STATE_BLOCK_SIZE;
+      num_blocks = std::min(num_blocks, (size_t)BLOCK_SIZE_LIMIT);
+      adam_update_int8<<<num_blocks, OPTIMIZER_STATE_BLOCK_SIZE, 0, stream>>>(
+          size,
+          step,
+          w_grad_ptr,
+          (int8_t *)m_ptr,
+          (uint8_t *)v_ptr,
+          m_scale_ptr,
+          v_scale_ptr,
+          w_ptr);
+      break;
+    }
+    default:
+      assert(false);
+  }
+}
+
 __host__ void AdamOptimizer::ps_update_task_gpu(AdamOptimizer const *op,
                                                 float const *w_grad_ptr,
                                                 size_t size,
                                                 int num_replicas,
                                                 float *w_ptr,
-                                                float *v_ptr,
-                                                float *m_ptr) {
+                                                void *v_ptr,
+                                                void *m_ptr,
+                                                float *v_scale_ptr,
+                                                float *m_scale_ptr) {
   cudaStream_t stream;
   checkCUDA(get_legion_stream(&stream));
   // Step 1: Gather gradients in the first replica
@@ -168,17 +291,15 @@ __host__ void AdamOptimizer::ps_update_task_gpu(AdamOptimizer const *op,
   // fprintf(stderr, "alpha = %.8lf alpha_t = %.8lf decay = %.8lf\n",
   //         op->alpha, op->alpha_t, op->weight_decay);
   //  Step 2: Adam update
-  adam_update<<<GET_BLOCKS(size), CUDA_NUM_THREADS, 0, stream>>>(
-      size,
-      op->alpha_t,
-      op->beta1,
-      op->beta2,
-      op->weight_decay,
-      op->epsilon,
-      w_grad_ptr,
-      m_ptr,
-      v_ptr,
-      w_ptr);
+  adam_update_state(op,
+                    w_grad_ptr,
+                    size,
+                    w_ptr,
+                    v_ptr,
+                    m_ptr,
+                    v_scale_ptr,
+                    m_scale_ptr,
+                    stream);
   // checkCUDA(cudaDeviceSynchronize());
 }
 
@@ -188,8 +309,10 @@ __host__ void AdamOptimizer::nccl_update_task_gpu(AdamOptimizer const *op,
                                                   float const *w_grad_ptr,
                                                   size_t size,
                                                   float *w_ptr,
-                                                  float *v_ptr,
-                                                  float *m_ptr) {
+                                                  void *v_ptr,
+                                                  void *m_ptr,
+                                                  float *v_scale_ptr,
+                                                  float *m_scale_ptr) {
   // Use NCCL to sync gradients
   cudaStream_t stream;
   checkCUDA(get_legion_stream(&stream));
@@ -203,19 +326,231 @@ __host__ void AdamOptimizer::nccl_update_task_gpu(AdamOptimizer const *op,
   // fprintf(stderr, "alpha = %.8lf alpha_t = %.8lf decay = %.8lf\n",
   //         op->alpha, op->alpha_t, op->weight_decay);
   //  Step 2: Adam update
-  adam_update<<<GET_BLOCKS(size), CUDA_NUM_THREADS, 0, stream>>>(
-      size,
-      op->alpha_t,
-      op->beta1,
-      op->beta2,
-      op->weight_decay,
-      op->epsilon,
-      w_grad_ptr,
-      m_ptr,
-      v_ptr,
-      w_ptr);
+  adam_update_state(op,
+                    w_grad_ptr,
+                    size,
+                    w_ptr,
+                    v_ptr,
+                    m_ptr,
+                    v_scale_ptr,
+                    m_scale_ptr,
+                    stream);
   // checkCUDA(cudaDeviceSynchronize());
 }
 #endif
 
+// ------------------------------------------------------------------
+//                   Layer-wise adaptive optimizers
+// ------------------------------------------------------------------
+
+// Add the sums of a and b over the thread block to out[0] and out[1]. The
+// block must have CUDA_NUM_THREADS threads
+__device__ void block_sum_to(float a, float b, float *out) {
+  __shared__ float a_sum[CUDA_NUM_THREADS];
+  __shared__ float b_sum[CUDA_NUM_THREADS];
+  int const t = threadIdx.x;
+  a_sum[t] = a;
+  b_sum[t] = b;
+  __syncthreads();
+  for (int s = CUDA_NUM_THREADS / 2; s > 0; s >>= 1) {
+    if (t < s) {
+      a_sum[t] += a_sum[t + s];
+      b_sum[t] += b_sum[t + s];
+    }
+    __syncthreads();
+  }
+  if (t == 0) {
+    atomicAdd(out, a_sum[0]);
+    atomicAdd(out + 1, b_sum[0]);
+  }
+}
+
+// Gather the replicas of the gradients, update the moments and accumulate
+// the squared norms of the weights and of the LAMB direction in the same pass
+__global__ void lamb_moments_kernel(size_t count,
+                                    int num_replicas,
+                                    LAMBStep step,
+                                    float const *WGrad,
+                                    float const *W,
+                                    float *M,
+                                    float *V,
+                                    float *norms) {
+  float w_norm = 0.0f, u_norm = 0.0f;
+  CUDA_KERNEL_LOOP(i, count) {
+    float g = WGrad[i];
+    for (int r = 1; r < num_replicas; r++) {
+      g += WGrad[r * count + i];
+    }
+    float u = lamb_moments(step, g, W[i], M[i], V[i]);
+    w_norm += W[i] * W[i];
+    u_norm += u * u;
+  }
+  block_sum_to(w_norm, u_norm, norms);
+}
+
+// norms are summed over norm_replicas copies of the parameter
+__global__ void lamb_apply_kernel(size_t count,
+                                  LAMBStep step,
+                                  float const *norms,
+                                  int norm_replicas,
+                                  float const *M,
+                                  float const *V,
+                                  float *W) {
+  float ratio = trust_ratio(sqrtf(norms[0] / norm_replicas),
+                            sqrtf(norms[1] / norm_replicas));
+  CUDA_KERNEL_LOOP(i, count) {
+    W[i] -= step.lr * ratio * lamb_direction(step, W[i], M[i], V[i]);
+  }
+}
+
+// Gather the replicas of the gradients into the first one and accumulate
+// the squared norms of the weights and of the gradients in the same pass
+__global__ void lars_norms_kernel(size_t count,
+                                  int num_replicas,
+                                  float *WGrad,
+                                  float const *W,
+                                  float *norms) {
+  float w_norm = 0.0f, g_norm = 0.0f;
+  CUDA_KERNEL_LOOP(i, count) {
+    float g = WGrad[i];
+    if (num_replicas > 1) {
+      for (int r = 1; r < num_replicas; r++) {
+        g += WGrad[r * count + i];
+      }
+      WGrad[i] = g;
+    }
+    w_norm += W[i] * W[i];
+    g_norm += g * g;
+  }
+  block_sum_to(w_norm, g_norm, norms);
+}
+
+__global__ void lars_apply_kernel(size_t count,
+                                  LARSStep step,
+                                  float const *norms,
+                                  int norm_replicas,
+                                  float const *WGrad,
+                                  float *W,
+                                  float *V) {
+  float ratio = lars_ratio(step,
+                           sqrtf(norms[0] / norm_replicas),
+                           sqrtf(norms[1] / norm_replicas));
+  CUDA_KERNEL_LOOP(i, count) {
+    lars_step(step, ratio, WGrad[i], W[i], V[i]);
+  }
+}
+
+// Zeroed framebuffer memory for the two norms of a layer-wise update. The
+// deferred buffer comes from the memory Legion reserves and is reclaimed when
+// the task completes, without the device synchronization of cudaFree
+static float *alloc_norms(cudaStream_t stream) {
+  Legion::DeferredBuffer<float, 1> buffer(Legion::Rect<1>(0, 1),
+                                          Legion::Memory::GPU_FB_MEM);
+  float *norms = buffer.ptr(0);
+  checkCUDA(cudaMemsetAsync(norms, 0, 2 * sizeof(float), stream));
+  return norms;
+}
+
+__host__ void LAMBOptimizer::ps_update_task_gpu(LAMBOptimizer const *op,
+                                                float const *w_grad_ptr,
+                                                size_t size,
+                                                int num_replicas,
+                                                float *w_ptr,
+                                                float *v_ptr,
+                                                float *m_ptr) {
+  cudaStream_t stream;
+  checkCUDA(get_legion_stream(&stream));
+  float *norms = alloc_norms(stream);
+  LAMBStep step = op->get_step();
+  lamb_moments_kernel<<<GET_BLOCKS(size), CUDA_NUM_THREADS, 0, stream>>>(
+      size, num_replicas, step, w_grad_ptr, w_ptr, m_ptr, v_ptr, norms);
+  lamb_apply_kernel<<<GET_BLOCKS(size), CUDA_NUM_THREADS, 0, stream>>>(
+      size, step, norms, 1, m_ptr, v_ptr, w_ptr);
+}
+
+#ifdef FF_USE_NCCL
+__host__ void
+    LAMBOptimizer::nccl_update_task_gpu(LAMBOptimizer const *op,
+                                        LayerwiseUpdateArgs const &args,
+                                        float const *w_grad_ptr,
+                                        size_t size,
+                                        float *w_ptr,
+                                        float *v_ptr,
+                                        float *m_ptr) {
+  // Use NCCL to sync gradients
+  cudaStream_t stream;
+  checkCUDA(get_legion_stream(&stream));
+  checkNCCL(ncclAllReduce(w_grad_ptr,
+                          (float *)w_grad_ptr,
+                          size,
+                          ncclFloat,
+                          ncclSum,
+                          args.meta->handle.ncclComm,
+                          stream));
+  float *norms = alloc_norms(stream);
+  LAMBStep step = op->get_step();
+  lamb_moments_kernel<<<GET_BLOCKS(size), CUDA_NUM_THREADS, 0, stream>>>(
+      size, 1, step, w_grad_ptr, w_ptr, m_ptr, v_ptr, norms);
+  // The norms of the whole parameter from the norms of the shards
+  checkNCCL(ncclAllReduce(norms,
+                          norms,
+                          2,
+                          ncclFloat,
+                          ncclSum,
+                          args.meta->handle.ncclComm,
+                          stream));
+  lamb_apply_kernel<<<GET_BLOCKS(size), CUDA_NUM_THREADS, 0, stream>>>(
+      size, step, norms, args.num_replicas, m_ptr, v_ptr, w_ptr);
+}
+#endif
+
+__host__ void LARSOptimizer::ps_update_task_gpu(LARSOptimizer const *op,
+                                                float const *w_grad_ptr,
+                                                size_t size,
+                                                int num_replicas,
+                                                float *w_ptr,
+                                                float *v_ptr) {
+  cudaStream_t stream;
+  checkCUDA(get_legion_stream(&stream));
+  float *norms = alloc_norms(stream);
+  lars_norms_kernel<<<GET_BLOCKS(size), CUDA_NUM_THREADS, 0, stream>>>(
+      size, num_replicas, (float *)w_grad_ptr, w_ptr, norms);
+  lars_apply_kernel<<<GET_BLOCKS(size), CUDA_NUM_THREADS, 0, stream>>>(
+      size, op->get_step(), norms, 1, w_grad_ptr, w_ptr, v_ptr);
+}
+
+#ifdef FF_USE_NCCL
+__host__ void
+    LARSOptimizer::nccl_update_task_gpu(LARSOptimizer const *op,
+                                        LayerwiseUpdateArgs const &args,
+                                        float const *w_grad_ptr,
+                                        size_t size,
+                                        float *w_ptr,
+                                        float *v_ptr) {
+  // Use NCCL to sync gradients
+  cudaStream_t stream;
+  checkCUDA(get_legion_stream(&stream));
+  checkNCCL(ncclAllReduce(w_grad_ptr,
+                          (float *)w_grad_ptr,
+                          size,
+                          ncclFloat,
+                          ncclSum,
+                          args.meta->handle.ncclComm,
+                          stream));
+  float *norms = alloc_norms(stream);
+  lars_norms_kernel<<<GET_BLOCKS(size), CUDA_NUM_THREADS, 0, stream>>>(
+      size, 1, (float *)w_grad_ptr, w_ptr, norms);
+  // The norms of the whole parameter from the norms of the shards
+  checkNCCL(ncclAllReduce(norms,
+                          norms,
+                          2,
+                          ncclFloat,
+                          ncclSum,
+                          args.meta->handle.ncclComm,
+                          stream));
+  lars_apply_kernel<<<GET_BLOCKS(size), CUDA_NUM_THREADS, 0, stream>>>(
+      size, op->get_step(), norms, args.num_replicas, w_grad_ptr, w_ptr, v_ptr);
+}
+#endif
+
 }; // namespace FlexFlow
@@ -0,0 +1,95 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flexflow/optimizer_state.h"
+#include <algorithm>
+#include <cassert>
+
+namespace FlexFlow {
+
+float optimizer_state_bytes(OptimizerStateType type) {
+  switch (type) {
+    case OPTIMIZER_STATE_FP32:
+      return sizeof(float);
+    case OPTIMIZER_STATE_BF16:
+      return sizeof(uint16_t);
+    case OPTIMIZER_STATE_INT8:
+      return sizeof(int8_t) + (float)sizeof(float) / OPTIMIZER_STATE_BLOCK_SIZE;
+    default:
+      assert(false);
+      return 0.0f;
+  }
+}
+
+namespace Kernels {
+namespace Adam {
+
+void update_cpu(AdamStep const &step,
+                size_t size,
+                float const *w_grad,
+                float *w,
+                float *m,
+                float *v) {
+  for (size_t i = 0; i < size; i++) {
+    adam_step(step, w_grad[i], w[i], m[i], v[i]);
+  }
+}
+
+void update_bf16_cpu(AdamStep const &step,
+                     size_t size,
+                     float const *w_grad,
+                     float *w,
+                     uint16_t *m,
+                     uint16_t *v) {
+  for (size_t i = 0; i < size; i++) {
+    float mt = bf16_to_float(m[i]), vt = bf16_to_float(v[i]);
+    adam_step(step, w_grad[i], w[i], mt, vt);
+    m[i] = float_to_bf16(mt);
+    v[i] = float_to_bf16(vt);
+  }
+}
+
+void update_int8_cpu(AdamStep const &step,
+                     size_t size,
+                     float const *w_grad,
+                     float *w,
+                     int8_t *m,
+                     uint8_t *v,
+                     float *m_scales,
+                     float *v_scales) {
+  float mt[OPTIMIZER_STATE_BLOCK_SIZE], vt[OPTIMIZER_STATE_BLOCK_SIZE];
+  for (size_t start = 0; start < size; start += OPTIMIZER_STATE_BLOCK_SIZE) {
+    size_t block = start / OPTIMIZER_STATE_BLOCK_SIZE;
+    size_t n = std::min(size - start, (size_t)OPTIMIZER_STATE_BLOCK_SIZE);
+    float m_absmax = 0.0f, v_max = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+      mt[i] = dequantize_first_moment(m[start + i], m_scales[block]);
+      vt[i] = dequantize_second_moment(v[start + i], v_scales[block]);
+      adam_step(step, w_grad[start + i], w[start + i], mt[i], vt[i]);
+      m_absmax = std::max(m_absmax, std::fabs(mt[i]));
+      v_max = std::max(v_max, vt[i]);
+    }
+    for (size_t i = 0; i < n; i++) {
+      m[start + i] = quantize_first_moment(mt[i], m_absmax);
+      v[start + i] = quantize_second_moment(vt[i], v_max);
+    }
+    m_scales[block] = m_absmax;
+    v_scales[block] = v_max;
+  }
+}
+
+} // namespace Adam
+} // namespace Kernels
+} // namespace FlexFlow
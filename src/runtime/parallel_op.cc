@@ -23,6 +23,40 @@ bool ParallelOp::is_parallel_op() const {
   return true;
 }
 
+bool ParallelOp::alias_output_to_input(FFModel &ff) {
+  assert(numInputs == 1);
+  assert(numOutputs == 1);
+  ParallelTensor input = inputs[0];
+  ParallelTensor output = outputs[0];
+  bool needs_grad = output->create_gradients &&
+                    ff.config.computationMode == COMP_MODE_TRAINING;
+  output_aliased = ff.config.alias_parallel_ops &&
+                   input->data_type == output->data_type &&
+                   input->get_volume() == output->get_volume() &&
+                   (!needs_grad ||
+                    input->region_grad != Legion::LogicalRegion::NO_REGION);
+  if (!output_aliased) {
+    return false;
+  }
+  output->parallel_is = ff.get_or_create_task_is(output);
+  output->region = input->region;
+  ff.create_disjoint_partition(output->num_dims,
+                               output->dims,
+                               output->parallel_is,
+                               output->region,
+                               output->part);
+  if (needs_grad) {
+    // Gradients of the output accumulate directly into those of the input
+    output->region_grad = input->region_grad;
+    ff.create_disjoint_partition(output->num_dims,
+                                 output->dims,
+                                 output->parallel_is,
+                                 output->region_grad,
+                                 output->part_grad);
+  }
+  return true;
+}
+
 ParallelOpJoinResult try_join_parallel_ops(ParallelOpInfo const &_first,
                                            ParallelOpInfo const &_second) {
   ParallelOpJoinResult result;
@@ -1,4 +1,5 @@
 #include "flexflow/model.h"
+#include "flexflow/model_checkpoint.h"
 #include "flexflow/ops/attention.h"
 #include "flexflow/ops/concat.h"
 #include "flexflow/ops/conv_2d.h"
@@ -594,6 +595,34 @@ int ParallelTensorShape::get_num_replicas() const {
   return num_replicas;
 }
 
+bool ParallelTensorShape::is_reshardable_to(
+    ParallelTensorShape const &other) const {
+  if (this->data_type != other.data_type) {
+    return false;
+  }
+  std::vector<int> sizes, other_sizes;
+  for (int i = 0; i < this->num_dims; i++) {
+    if (this->dims[i].is_replica_dim) {
+      continue;
+    }
+    if (i >= this->num_dims - this->get_num_replica_dims()) {
+      // A replica dimension is inside a data dimension
+      return false;
+    }
+    sizes.push_back(this->dims[i].size);
+  }
+  for (int i = 0; i < other.num_dims; i++) {
+    if (other.dims[i].is_replica_dim) {
+      continue;
+    }
+    if (i >= other.num_dims - other.get_num_replica_dims()) {
+      return false;
+    }
+    other_sizes.push_back(other.dims[i].size);
+  }
+  return sizes == other_sizes;
+}
+
 std::ostream &operator<<(std::ostream &s, ParallelTensorShape const &shape) {
   s << "[ ";
   for (int i = 0; i < shape.num_dims; i++) {
@@ -775,6 +804,120 @@ template bool TensorBase::get_tensor<int64_t>(FFModel const *ff,
                                               int64_t *data,
                                               bool get_gradients);
 
+bool ParallelTensorBase::reshard_from(FFModel const *ff,
+                                      ParallelTensorBase const *src) {
+  Context ctx = ff->config.lg_ctx;
+  Runtime *runtime = ff->config.lg_hlr;
+  assert(src->get_shape().is_reshardable_to(this->get_shape()));
+  Domain src_domain =
+      runtime->get_index_space_domain(ctx, src->region.get_index_space());
+  Domain dst_domain =
+      runtime->get_index_space_domain(ctx, region.get_index_space());
+  if (src_domain == dst_domain) {
+    // Only the partitioning differs, so Legion can copy the regions directly
+    CopyLauncher launcher;
+    launcher.add_copy_requirements(
+        RegionRequirement(src->region, READ_ONLY, EXCLUSIVE, src->region),
+        RegionRequirement(region, WRITE_DISCARD, EXCLUSIVE, region));
+    launcher.add_src_field(0, FID_DATA);
+    launcher.add_dst_field(0, FID_DATA);
+    runtime->issue_copy_operation(ctx, launcher);
+    return true;
+  }
+  // The number of replicas differs: broadcast the first replica of src to
+  // every replica of this tensor. Replicas are kept consistent by the
+  // parameter synchronization, so any replica of src can be used
+  RegionRequirement src_req(src->region, READ_ONLY, EXCLUSIVE, src->region);
+  src_req.add_field(FID_DATA);
+  InlineLauncher src_launcher(src_req);
+  PhysicalRegion src_pr = runtime->map_region(ctx, src_launcher);
+  RegionRequirement dst_req(region, WRITE_DISCARD, EXCLUSIVE, region);
+  dst_req.add_field(FID_DATA);
+  InlineLauncher dst_launcher(dst_req);
+  PhysicalRegion dst_pr = runtime->map_region(ctx, dst_launcher);
+  src_pr.wait_until_valid();
+  dst_pr.wait_until_valid();
+  GenericTensorAccessorR src_acc = helperGetGenericTensorAccessorRO(
+      data_type, src_pr, src_req, FID_DATA, ctx, runtime);
+  GenericTensorAccessorW dst_acc = helperGetGenericTensorAccessorWO(
+      data_type, dst_pr, dst_req, FID_DATA, ctx, runtime);
+  int num_replicas = get_num_replicas();
+  assert(dst_domain.get_volume() % num_replicas == 0);
+  size_t replica_bytes =
+      dst_domain.get_volume() / num_replicas * data_type_size(data_type);
+  char const *src_ptr = static_cast<char const *>(src_acc.ptr);
+  char *dst_ptr = static_cast<char *>(dst_acc.ptr);
+  for (int i = 0; i < num_replicas; i++) {
+    memcpy(dst_ptr + i * replica_bytes, src_ptr, replica_bytes);
+  }
+  runtime->unmap_region(ctx, src_pr);
+  runtime->unmap_region(ctx, dst_pr);
+  return true;
+}
+
+static std::vector<int> data_dim_sizes(ParallelTensorBase const *tensor) {
+  std::vector<int> sizes;
+  for (int i = 0; i < tensor->num_dims; i++) {
+    if (!tensor->dims[i].is_replica_dim) {
+      sizes.push_back(tensor->dims[i].size);
+    }
+  }
+  return sizes;
+}
+
+void ParallelTensorBase::save_checkpoint(FFModel const *ff,
+                                         ModelCheckpoint &ckpt,
+                                         std::string const &name) const {
+  Context ctx = ff->config.lg_ctx;
+  Runtime *runtime = ff->config.lg_hlr;
+  // The replica dimensions must be outermost for the replicas to be stored
+  // one after the other
+  assert(get_shape().is_reshardable_to(get_shape()));
+  RegionRequirement req(region, READ_ONLY, EXCLUSIVE, region);
+  req.add_field(FID_DATA);
+  InlineLauncher launcher(req);
+  PhysicalRegion pr = runtime->map_region(ctx, launcher);
+  pr.wait_until_valid();
+  GenericTensorAccessorR acc = helperGetGenericTensorAccessorRO(
+      data_type, pr, req, FID_DATA, ctx, runtime);
+  Domain domain =
+      runtime->get_index_space_domain(ctx, region.get_index_space());
+  ckpt.save_tensor(name,
+                   data_type,
+                   data_dim_sizes(this),
+                   acc.ptr,
+                   domain.get_volume() * data_type_size(data_type),
+                   get_num_replicas());
+  runtime->unmap_region(ctx, pr);
+}
+
+bool ParallelTensorBase::load_checkpoint(FFModel const *ff,
+                                         ModelCheckpoint const &ckpt,
+                                         std::string const &name,
+                                         std::string &error) {
+  Context ctx = ff->config.lg_ctx;
+  Runtime *runtime = ff->config.lg_hlr;
+  assert(get_shape().is_reshardable_to(get_shape()));
+  RegionRequirement req(region, WRITE_DISCARD, EXCLUSIVE, region);
+  req.add_field(FID_DATA);
+  InlineLauncher launcher(req);
+  PhysicalRegion pr = runtime->map_region(ctx, launcher);
+  pr.wait_until_valid();
+  GenericTensorAccessorW acc = helperGetGenericTensorAccessorWO(
+      data_type, pr, req, FID_DATA, ctx, runtime);
+  Domain domain =
+      runtime->get_index_space_domain(ctx, region.get_index_space());
+  bool ok = ckpt.load_tensor(name,
+                             data_type,
+                             data_dim_sizes(this),
+                             acc.ptr,
+                             domain.get_volume() * data_type_size(data_type),
+                             get_num_replicas(),
+                             error);
+  runtime->unmap_region(ctx, pr);
+  return ok;
+}
+
 template bool ParallelTensorBase::set_tensor<float>(
     FFModel const *ff, std::vector<int> const &dims, float const *data);
 template bool ParallelTensorBase::get_tensor<float>(FFModel const *ff,
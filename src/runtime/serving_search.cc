@@ -0,0 +1,133 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flexflow/serving_search.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+namespace FlexFlow {
+
+ServingSearchPoint::ServingSearchPoint(int _batch_size, float _latency)
+    : batch_size(_batch_size), latency(_latency) {
+  assert(latency > 0.0f);
+  throughput = batch_size * 1000.0f / latency;
+}
+
+std::vector<ServingSearchPoint>
+    serving_pareto_front(std::vector<ServingSearchPoint> const &points) {
+  std::vector<ServingSearchPoint> sorted = points;
+  std::sort(sorted.begin(),
+            sorted.end(),
+            [](ServingSearchPoint const &a, ServingSearchPoint const &b) {
+              if (a.latency != b.latency) {
+                return a.latency < b.latency;
+              }
+              return a.throughput > b.throughput;
+            });
+  std::vector<ServingSearchPoint> front;
+  for (ServingSearchPoint const &p : sorted) {
+    // Every point kept so far has a lower or equal latency
+    if (front.empty() || p.throughput > front.back().throughput) {
+      front.push_back(p);
+    }
+  }
+  return front;
+}
+
+int select_serving_point(std::vector<ServingSearchPoint> const &points,
+                         float latency_slo) {
+  assert(!points.empty());
+  int best = -1, fastest = 0;
+  for (size_t i = 0; i < points.size(); i++) {
+    if (points[i].latency < points[fastest].latency) {
+      fastest = i;
+    }
+    if (points[i].latency <= latency_slo &&
+        (best < 0 || points[i].throughput > points[best].throughput)) {
+      best = i;
+    }
+  }
+  return best >= 0 ? best : fastest;
+}
+
+std::vector<int> default_serving_batch_sizes(int max_batch_size) {
+  assert(max_batch_size > 0);
+  std::vector<int> batch_sizes;
+  for (int b = 1; b < max_batch_size; b *= 2) {
+    batch_sizes.push_back(b);
+  }
+  batch_sizes.push_back(max_batch_size);
+  return batch_sizes;
+}
+
+namespace {
+
+char const STRATEGY_MAGIC[8] = {'F', 'F', 'S', 'T', 'R', 'A', 'T', '\0'};
+
+} // namespace
+
+bool ExportedStrategy::save(std::string const &filename) const {
+  FILE *file = fopen(filename.c_str(), "wb");
+  if (file == NULL) {
+    return false;
+  }
+  uint32_t version = VERSION;
+  uint64_t size = graph_optimal_view.size();
+  bool ok = fwrite(STRATEGY_MAGIC, sizeof(STRATEGY_MAGIC), 1, file) == 1 &&
+            fwrite(&version, sizeof(version), 1, file) == 1 &&
+            fwrite(&batch_size, sizeof(batch_size), 1, file) == 1 &&
+            fwrite(&comp_mode, sizeof(comp_mode), 1, file) == 1 &&
+            fwrite(&latency_slo, sizeof(latency_slo), 1, file) == 1 &&
+            fwrite(&latency, sizeof(latency), 1, file) == 1 &&
+            fwrite(&size, sizeof(size), 1, file) == 1 &&
+            fwrite(graph_optimal_view.data(), 1, size, file) == size;
+  return fclose(file) == 0 && ok;
+}
+
+bool ExportedStrategy::load(std::string const &filename,
+                            ExportedStrategy &strategy) {
+  FILE *file = fopen(filename.c_str(), "rb");
+  if (file == NULL) {
+    return false;
+  }
+  char magic[sizeof(STRATEGY_MAGIC)];
+  uint32_t version;
+  uint64_t size;
+  bool ok = fread(magic, sizeof(magic), 1, file) == 1 &&
+            memcmp(magic, STRATEGY_MAGIC, sizeof(magic)) == 0 &&
+            fread(&version, sizeof(version), 1, file) == 1 &&
+            version == VERSION &&
+            fread(&strategy.batch_size, sizeof(strategy.batch_size), 1, file) ==
+                1 &&
+            fread(&strategy.comp_mode, sizeof(strategy.comp_mode), 1, file) ==
+                1 &&
+            fread(&strategy.latency_slo,
+                  sizeof(strategy.latency_slo),
+                  1,
+                  file) == 1 &&
+            fread(&strategy.latency, sizeof(strategy.latency), 1, file) == 1 &&
+            fread(&size, sizeof(size), 1, file) == 1;
+  if (ok) {
+    strategy.graph_optimal_view.resize(size);
+    ok = fread(strategy.graph_optimal_view.data(), 1, size, file) == size &&
+         fgetc(file) == EOF;
+  }
+  fclose(file);
+  return ok;
+}
+
+} // namespace FlexFlow
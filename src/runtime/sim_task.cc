@@ -0,0 +1,432 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flexflow/machine_model.h"
+#include "flexflow/utils/dot/dot_file.h"
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <queue>
+#include <sstream>
+
+namespace FlexFlow {
+
+SimTask::SimTask() {}
+
+void SimTask::add_next_task(SimTask *task) {
+  next_tasks.push_back(task);
+  task->counter++;
+}
+
+std::string SimTask::get_type_str() const {
+  switch (type) {
+    case TASK_FORWARD:
+      return "Forward";
+    case TASK_BACKWARD:
+      return "Backward";
+    case TASK_COMM:
+      return "Comm";
+    case TASK_UPDATE:
+      return "Update";
+    case TASK_BARRIER:
+      return "Barrier";
+    case TASK_LAUNCH:
+      return "Launch";
+    default:
+      assert(false && "Unknown task type");
+  }
+}
+
+TaskManager::TaskManager(size_t _max_num_tasks)
+    : global_task_id(0), max_num_tasks(_max_num_tasks) {
+  tasks = (SimTask **)malloc(sizeof(SimTask *) * max_num_tasks);
+  for (size_t i = 0; i < max_num_tasks; i++) {
+    tasks[i] = new SimTask();
+  }
+}
+
+TaskManager::~TaskManager() {
+  for (size_t i = 0; i < max_num_tasks; i++) {
+    delete tasks[i];
+  }
+  free(tasks);
+}
+
+void TaskManager::reset() {
+  global_task_id = 0;
+  hash_to_forward_task.clear();
+  hash_to_backward_task.clear();
+  xfers.clear();
+}
+
+SimTask *TaskManager::new_task() {
+  assert(global_task_id + 1 < max_num_tasks);
+  SimTask *task = tasks[global_task_id++];
+  task->ready_time = 0.0f;
+  task->run_time = 0.0f;
+  task->run_time_stddev = 0.0f;
+  task->next_tasks.clear();
+  task->counter = 0;
+  task->device = NULL;
+  task->mem = NULL;
+  task->name.clear();
+  task->op = NULL;
+  task->critical_pred = NULL;
+
+  task->xfer_size = 0;
+  task->xfer_left = 0;
+  task->store = true;
+
+  return task;
+}
+
+SimTask *TaskManager::new_update_task() {
+  SimTask *task = new_task();
+  task->type = SimTask::TASK_UPDATE;
+  return task;
+}
+
+SimTask *TaskManager::new_barrier_task() {
+  SimTask *task = new_task();
+  task->type = SimTask::TASK_BARRIER;
+  return task;
+}
+
+SimTask *TaskManager::new_comm_task() {
+  SimTask *task = new_task();
+  task->type = SimTask::TASK_COMM;
+  return task;
+}
+
+SimTask *TaskManager::new_comm_task(std::string const &name,
+                                    CommDevice *comm_device,
+                                    size_t message_size) {
+  SimTask *task = new_task();
+  task->type = SimTask::TASK_COMM;
+  task->name = name;
+  task->device = comm_device;
+  task->run_time = comm_device->latency + message_size / comm_device->bandwidth;
+  task->xfer_size = message_size;
+  return task;
+}
+
+SimTask *TaskManager::get_forward_task(Op const *op, int idx) {
+  size_t hash = 17 * 31 + (size_t)(op);
+  hash = hash * 31 + std::hash<int>()(idx);
+  assert(hash_to_forward_task.find(hash) != hash_to_forward_task.end());
+  return hash_to_forward_task[hash];
+}
+
+SimTask *TaskManager::get_backward_task(Op const *op, int idx) {
+  size_t hash = 17 * 31 + (size_t)(op);
+  hash = hash * 31 + std::hash<int>()(idx);
+  assert(hash_to_backward_task.find(hash) != hash_to_backward_task.end());
+  return hash_to_backward_task[hash];
+}
+
+void add_xfer_tasks(TaskManager *task_manager,
+                    MachineModel *machine,
+                    SimTask *src_task,
+                    SimTask *dst_task,
+                    size_t message_size,
+                    bool zero_cost,
+                    int segment_size,
+                    int max_num_segments) {
+  std::vector<CommDevice *> path =
+      machine->get_comm_path(src_task->mem, dst_task->mem);
+  // print the communication path
+  // printf("Message: %zu B\nPath from %s to %s is: ", message_size,
+  // src_task->mem->name.c_str(), dst_task->mem->name.c_str()); for (size_t i =
+  // 0; i < path.size(); i++) {
+  //   printf("%s ", path[i]->name.c_str());
+  // }
+  // printf("\n");
+
+  if (path.empty() || zero_cost) {
+    src_task->add_next_task(dst_task);
+    return;
+  }
+  assert(message_size > 0);
+  std::vector<std::vector<SimTask *>> all_tasks;
+  // Limit the max number of segments per message
+  int seg_size = segment_size;
+  int num_segment = message_size / seg_size;
+  if (message_size % seg_size != 0) {
+    num_segment += 1;
+  }
+  if (num_segment > max_num_segments) {
+    num_segment = max_num_segments;
+    seg_size = message_size / num_segment;
+  }
+  // optional optimization: can reduce the simulation time, but could also
+  // impact the accuracy of the simulation (a communication can be occupied by a
+  // message for long time without be used by other concurrent communication
+  //   if (path.size() == 1) {
+  //     num_segment = 1;
+  //     seg_size = message_size;
+  //   }
+  // Create all the comm tasks
+  // Divide messages into segments
+  for (size_t i = 0; i < path.size(); i++) {
+    all_tasks.push_back({});
+    for (int j = 0; j < num_segment; j++) {
+      int cur_seg_size = seg_size;
+      if (j == num_segment - 1) {
+        cur_seg_size = message_size - (num_segment - 1) * seg_size;
+      }
+      std::string name = "seg " + std::to_string(j) + " from " +
+                         src_task->name + " to " + dst_task->name;
+      SimTask *cur_task =
+          task_manager->new_comm_task(name, path[i], cur_seg_size);
+      // Transfers are charged to the operator waiting for the data
+      cur_task->op = dst_task->op;
+      all_tasks[i].push_back(cur_task);
+    }
+  }
+
+  // Add dependencies among the comm tasks
+  for (size_t i = 0; i < path.size(); i++) {
+    for (int j = 0; j < num_segment; j++) {
+      if (i == 0) {
+        src_task->add_next_task(all_tasks[i][j]);
+      }
+      if (i == path.size() - 1) {
+        all_tasks[i][j]->add_next_task(dst_task);
+      }
+      if (i > 0) {
+        all_tasks[i - 1][j]->add_next_task(all_tasks[i][j]);
+      }
+    }
+  }
+
+  // Add special dependencies for upi_ins, upi_outs, nic_ins, and nic_outs to
+  // prevent communication overlap between upi_ins and upi_outs, and between
+  // nic_ins and nic_outs.
+  if (num_segment > 1 and path.size() >= 2) {
+    for (size_t i = 0; i < path.size(); i++) {
+      for (int j = 0; j < num_segment - 1; j++) {
+        if (((CommDevice *)all_tasks[i][j]->device)->comm_type ==
+                CommDevice::NIC_OUT_COMM or
+            ((CommDevice *)all_tasks[i][j]->device)->comm_type ==
+                CommDevice::UPI_OUT_COMM) {
+          all_tasks[i][j]->add_next_task(all_tasks[i - 1][j + 1]);
+        }
+      }
+    }
+  }
+}
+
+TaskGraphSchedule schedule_task_graph(TaskManager *task_manager,
+                                      std::string const &export_file_name) {
+  // Step 4: add ready tasks into ready_queue
+  std::priority_queue<SimTask *, std::vector<SimTask *>, SimTaskCompare>
+      ready_queue;
+  for (size_t i = 0; i < task_manager->global_task_id; i++) {
+    task_manager->tasks[i]->critical_pred = NULL;
+    if (task_manager->tasks[i]->counter == 0) {
+      ready_queue.push(task_manager->tasks[i]);
+    }
+  }
+  // Step 5: perform simulation
+  TaskGraphSchedule schedule;
+  std::map<Device *, float> device_times;
+  std::map<Device *, SimTask *> device_last_tasks;
+  size_t idx = 0;
+  DotFile<SimTask *> taskGraph;
+  bool export_taskgraph = (export_file_name != "");
+  if (export_taskgraph) {
+    taskGraph.set_filename(export_file_name);
+  }
+  while (!ready_queue.empty()) {
+    // Find the task with the earliest start time
+    SimTask *cur_task = ready_queue.top();
+    ready_queue.pop();
+    float ready_time = 0;
+    if (device_times.find(cur_task->device) != device_times.end()) {
+      ready_time = device_times[cur_task->device];
+    }
+    float start_time = std::max(ready_time, cur_task->ready_time);
+    float end_time = start_time + cur_task->run_time;
+    if (ready_time > cur_task->ready_time) {
+      cur_task->critical_pred = device_last_tasks[cur_task->device];
+    }
+    device_times[cur_task->device] = end_time;
+    device_last_tasks[cur_task->device] = cur_task;
+    schedule.busy_time[cur_task->device] += cur_task->run_time;
+    if (export_taskgraph) {
+      std::map<std::string, std::string> nodeAttrs;
+      std::ostringstream label;
+      label << "\"{ ";
+      if (!(cur_task->name).empty()) {
+        label << cur_task->name << " | ";
+      }
+      label << cur_task->get_type_str() << " | ";
+      label << "{ " << start_time << " | " << end_time << " }";
+      label << " }\"";
+      nodeAttrs["label"] = label.str();
+      nodeAttrs["shape"] = "record";
+      taskGraph.add_node(cur_task, nodeAttrs);
+    }
+    // printf("task[%lu] type(%d) run_time(%.4lf) ready_time(%.4lf)
+    // start_time(%.4lf) device(%s)\n",
+    //       idx, cur_task->type, cur_task->run_time, ready_time, start_time,
+    //       (cur_task->device->name).c_str());
+    if (end_time >= schedule.makespan) {
+      schedule.makespan = end_time;
+      schedule.last_task = cur_task;
+    }
+    for (size_t i = 0; i < cur_task->next_tasks.size(); i++) {
+      SimTask *next = cur_task->next_tasks[i];
+      if (export_taskgraph) {
+        taskGraph.add_edge(cur_task, next);
+      }
+      if (end_time >= next->ready_time) {
+        next->ready_time = end_time;
+        next->critical_pred = cur_task;
+      }
+      next->counter--;
+      if (next->counter == 0) {
+        ready_queue.push(next);
+      }
+    }
+    idx++;
+  }
+  if (export_taskgraph) {
+    taskGraph.close();
+  }
+  // Assert all tasks were processed
+  assert(idx == task_manager->global_task_id);
+  return schedule;
+}
+
+TaskGraphReplayReport
+    replay_task_graph_trace(TaskGraphTrace const &trace,
+                            MachineModel *machine,
+                            TaskGraphReplayOptions const &options) {
+  assert(trace.max_gpu_id() < machine->get_num_gpus());
+  int segment_size =
+      options.segment_size > 0 ? options.segment_size : trace.segment_size;
+  int max_num_segments = options.max_num_segments > 0
+                             ? options.max_num_segments
+                             : trace.max_num_segments;
+  assert(segment_size > 0 && max_num_segments > 0);
+  // Size the task manager for the communication tasks of every transfer
+  std::map<std::pair<int, int>, size_t> path_lengths;
+  size_t num_tasks = trace.tasks.size() + 1;
+  for (TaskGraphTrace::Edge const &edge : trace.edges) {
+    TaskGraphTrace::Task const &src = trace.tasks[edge.src];
+    TaskGraphTrace::Task const &dst = trace.tasks[edge.dst];
+    if (edge.xfer_size == 0 || src.type == TaskGraphTrace::TASK_LAUNCH ||
+        dst.type == TaskGraphTrace::TASK_LAUNCH) {
+      continue;
+    }
+    auto key = std::make_pair(src.device_id, dst.device_id);
+    if (path_lengths.find(key) == path_lengths.end()) {
+      path_lengths[key] =
+          machine
+              ->get_comm_path(machine->get_gpu_fb_mem(src.device_id),
+                              machine->get_gpu_fb_mem(dst.device_id))
+              .size();
+    }
+    num_tasks += path_lengths[key] * max_num_segments;
+  }
+  TaskManager task_manager(num_tasks);
+  std::vector<std::unique_ptr<CompDevice>> util_procs;
+  std::vector<SimTask *> tasks;
+  for (TaskGraphTrace::Task const &t : trace.tasks) {
+    SimTask *task = task_manager.new_task();
+    task->name = t.name;
+    switch (t.type) {
+      case TaskGraphTrace::TASK_FORWARD:
+        task->type = SimTask::TASK_FORWARD;
+        break;
+      case TaskGraphTrace::TASK_BACKWARD:
+        task->type = SimTask::TASK_BACKWARD;
+        break;
+      case TaskGraphTrace::TASK_UPDATE:
+        task->type = SimTask::TASK_UPDATE;
+        break;
+      case TaskGraphTrace::TASK_BARRIER:
+        task->type = SimTask::TASK_BARRIER;
+        break;
+      case TaskGraphTrace::TASK_LAUNCH:
+        task->type = SimTask::TASK_LAUNCH;
+        break;
+    }
+    if (t.type == TaskGraphTrace::TASK_LAUNCH) {
+      // Launches are serialized on the node they were recorded on
+      while ((int)util_procs.size() <= t.device_id) {
+        int id = util_procs.size();
+        util_procs.emplace_back(new CompDevice(
+            "UTIL " + std::to_string(id), CompDevice::UTIL_PROC, id, id, id));
+      }
+      task->device = util_procs[t.device_id].get();
+      task->run_time = t.run_time;
+    } else {
+      task->device = machine->get_gpu(t.device_id);
+      task->mem = machine->get_gpu_fb_mem(t.device_id);
+      task->run_time = t.run_time * options.compute_scale;
+    }
+    tasks.push_back(task);
+  }
+  for (TaskGraphTrace::Edge const &edge : trace.edges) {
+    SimTask *src = tasks[edge.src], *dst = tasks[edge.dst];
+    if (edge.xfer_size == 0 || src->mem == NULL || dst->mem == NULL) {
+      src->add_next_task(dst);
+    } else {
+      add_xfer_tasks(&task_manager,
+                     machine,
+                     src,
+                     dst,
+                     edge.xfer_size,
+                     false /*zero_cost*/,
+                     segment_size,
+                     max_num_segments);
+    }
+  }
+  TaskGraphSchedule schedule = schedule_task_graph(&task_manager, "");
+
+  TaskGraphReplayReport report;
+  report.makespan = schedule.makespan;
+  for (int i = 0; i < machine->get_num_gpus(); i++) {
+    CompDevice *gpu = machine->get_gpu(i);
+    report.compute_devices.push_back(TaskGraphReplayReport::DeviceUsage{
+        gpu->name, schedule.busy_time[gpu], 0});
+  }
+  for (auto const &util_proc : util_procs) {
+    report.compute_devices.push_back(TaskGraphReplayReport::DeviceUsage{
+        util_proc->name, schedule.busy_time[util_proc.get()], 0});
+  }
+  std::map<Device *, size_t> link_bytes;
+  for (size_t i = 0; i < task_manager.global_task_id; i++) {
+    SimTask *task = task_manager.tasks[i];
+    if (task->type == SimTask::TASK_COMM) {
+      link_bytes[task->device] += task->xfer_size;
+    }
+  }
+  for (auto const &it : link_bytes) {
+    report.links.push_back(TaskGraphReplayReport::DeviceUsage{
+        it.first->name, schedule.busy_time[it.first], it.second});
+  }
+  std::sort(report.links.begin(),
+            report.links.end(),
+            [](TaskGraphReplayReport::DeviceUsage const &a,
+               TaskGraphReplayReport::DeviceUsage const &b) {
+              return a.busy_time > b.busy_time;
+            });
+  return report;
+}
+
+} // namespace FlexFlow
@@ -15,6 +15,8 @@
 
 #include "flexflow/simulator.h"
 #include "flexflow/model.h"
+#include "flexflow/ops/conv_2d.h"
+#include "flexflow/ops/fused.h"
 #include "flexflow/parallel_ops/combine.h"
 #include "flexflow/parallel_ops/partition.h"
 #include "flexflow/parallel_ops/reduction.h"
@@ -22,8 +24,11 @@
 #include "flexflow/utils/dot/dot_file.h"
 #include "flexflow/utils/hash_utils.h"
 #include "queue"
+#include <algorithm>
+#include <cmath>
 #include <memory>
 #include <random>
+#include <set>
 #include <unordered_set>
 
 namespace FlexFlow {
@@ -132,221 +137,259 @@ bool MachineResource::is_valid_machine_view(MachineView const &view) const {
   }
 }
 
-Device::Device(std::string const &name,
-               DeviceType type,
-               int node_id,
-               int socket_id,
-               int device_id)
-    : name(name), type(type), node_id(node_id), socket_id(socket_id),
-      device_id(device_id) {}
-
-CompDevice::CompDevice(std::string const &name,
-                       CompDevType comp_type,
-                       int node_id,
-                       int socket_id,
-                       int device_id)
-    : Device(name, Device::DEVICE_COMP, node_id, socket_id, device_id),
-      comp_type(comp_type) {}
-
-MemDevice::MemDevice(std::string const &name,
-                     MemDevType mem_type,
-                     int node_id,
-                     int socket_id,
-                     int device_id,
-                     size_t capacity)
-    : Device(name, Device::DEVICE_MEM, node_id, socket_id, device_id),
-      mem_type(mem_type), capacity(capacity) {}
-
-CommDevice::CommDevice(std::string const &name,
-                       CommDevType comm_type,
-                       int node_id,
-                       int socket_id,
-                       int device_id,
-                       float latency,
-                       float bandwidth)
-    : Device(name, Device::DEVICE_COMM, node_id, socket_id, device_id),
-      comm_type(comm_type), latency(latency), bandwidth(bandwidth) {}
-
-static std::random_device rd;
-static std::mt19937 gen = std::mt19937(rd());
-static std::uniform_real_distribution<> std_uniform =
-    std::uniform_real_distribution<>(0.0, 1.0);
-
-NominalCommDevice::NominalCommDevice(std::string const &name,
-                                     int device_id,
-                                     int nnodes,
-                                     NetworkRoutingStrategy *routing)
-    : CommDevice(name, CommDevice::NW_NOMINAL, -1, -1, device_id, 0, 0),
-      routing_strategy(routing), dirty(true), nnode(nnodes) {}
-
-void NominalCommDevice::reset() {
-  dirty = true;
-  routes = {};
+SimTask *TaskManager::new_forward_task(Op const *op, int idx) {
+  SimTask *task = new_task();
+  task->type = SimTask::TASK_FORWARD;
+  size_t hash = 17 * 31 + (size_t)(op);
+  hash = hash * 31 + std::hash<int>()(idx);
+  hash_to_forward_task[hash] = task;
+  task->name = op->name;
+  task->op = op;
+  return task;
 }
 
-Route NominalCommDevice::expand_to_physical() const {
-  if (dirty) {
-    if (routing_strategy == nullptr) {
-      assert("don't know how to route!" && false);
-    }
-    // std::cerr << name << " dirty... " << std::endl;
-    *const_cast<EcmpRoutes *>(&routes) =
-        routing_strategy->get_routes(device_id / nnode, device_id % nnode);
-    *const_cast<bool *>(&dirty) = false;
-  }
+SimTask *TaskManager::new_backward_task(Op const *op, int idx) {
+  SimTask *task = new_task();
+  task->type = SimTask::TASK_BACKWARD;
+  size_t hash = 17 * 31 + (size_t)(op);
+  hash = hash * 31 + std::hash<int>()(idx);
+  hash_to_backward_task[hash] = task;
+  task->name = op->name;
+  task->op = op;
+  return task;
+}
 
-  assert(routes.first.size() > 0 || device_id / nnode == device_id % nnode);
-  size_t pick = 0;
-  double choice = std_uniform(gen);
-  for (size_t i = 0; i < routes.first.size(); i++) {
-    if (choice > routes.first[i]) {
-      break;
-    }
-    pick = i;
-  }
-  Route ret = Route(routes.second[pick].begin(), routes.second[pick].end());
-  return ret;
+SimTask *TaskManager::new_launch_task(Op const *op,
+                                      CompDevice *util_proc,
+                                      float launch_time) {
+  SimTask *task = new_task();
+  task->type = SimTask::TASK_LAUNCH;
+  task->device = util_proc;
+  task->run_time = launch_time;
+  task->name = op->name;
+  task->op = op;
+  return task;
 }
 
-void NominalCommDevice::set_physical_paths(EcmpRoutes const &rs) {
-  routes = rs;
-  dirty = false;
+Simulator::Simulator(FFModel const *model,
+                     MachineModel *machine,
+                     AnalyticCostModel const *cost_model)
+    : simulatorInst(Realm::RegionInstance::NO_INST),
+      memory(Memory::NO_MEMORY), base_ptr(NULL), capacity(0), offset(0),
+      warmup_times(0), repeat_times(0),
+      computationMode(model->config.computationMode) {
+  assert(cost_model != NULL);
+  conv2d_meta = NULL;
+  linear_meta = NULL;
+  pool2d_meta = NULL;
+  ele_unary_meta = NULL;
+  ele_binary_meta = NULL;
+  batch_matmul_meta = NULL;
+  concat_meta = NULL;
+  transpose_meta = NULL;
+  init_options(model, machine);
+  analytic_cost_model = cost_model;
 }
 
-EcmpRoutes const &NominalCommDevice::get_all_routes() {
-  if (dirty) {
-    if (routing_strategy == nullptr) {
-      assert("don't know how to route!" && false);
-    }
-    // std::cerr << name << " dirty... " << std::endl;
-    *const_cast<EcmpRoutes *>(&routes) =
-        routing_strategy->get_routes(device_id / nnode, device_id % nnode);
-    *const_cast<bool *>(&dirty) = false;
-  }
-  return routes;
+void Simulator::init_options(FFModel const *model, MachineModel *machine) {
+  size_t max_num_tasks = 1024 * 1024;
+  this->machine = machine;
+  segment_size = model->config.simulator_segment_size;
+  max_num_segments = model->config.simulator_max_num_segments;
+  launch_cost_model.per_task_overhead =
+      model->config.simulator_task_launch_overhead;
+  launch_cost_model.per_point_overhead =
+      model->config.simulator_point_launch_overhead;
+  launch_cost_model.utility_procs_per_node = model->config.utilityProcsPerNode;
+  fusion_aware =
+      model->config.perform_fusion && model->config.search_fusion_aware;
+  alias_parallel_ops = model->config.alias_parallel_ops;
+  variance_model.quantile = model->config.search_step_time_quantile;
+  variance_model.jitter = model->config.simulator_jitter;
+  variance_model.num_samples = model->config.simulator_num_samples;
+  optimizer_state_bytes = model->optimizer != NULL
+                              ? model->optimizer->state_bytes_per_parameter()
+                              : 0.0f;
+  analytic_cost_model = NULL;
+  // Initialize task manager
+  task_manager = new TaskManager(max_num_tasks);
 }
 
-SimTask::SimTask() {}
+void Simulator::free_all() {
+  offset = 0;
+}
 
-void SimTask::add_next_task(SimTask *task) {
-  next_tasks.push_back(task);
-  task->counter++;
+bool TaskLaunchCostModel::enabled() const {
+  return per_task_overhead > 0.0f || per_point_overhead > 0.0f;
 }
 
-std::string SimTask::get_type_str() const {
-  switch (type) {
-    case TASK_FORWARD:
-      return "Forward";
-    case TASK_BACKWARD:
-      return "Backward";
-    case TASK_COMM:
-      return "Comm";
-    case TASK_UPDATE:
-      return "Update";
-    case TASK_BARRIER:
-      return "Barrier";
-    default:
-      assert(false && "Unknown task type");
-  }
+float TaskLaunchCostModel::launch_time(int num_points_on_node) const {
+  assert(utility_procs_per_node > 0);
+  int points_per_util_proc =
+      (num_points_on_node + utility_procs_per_node - 1) /
+      utility_procs_per_node;
+  return per_task_overhead + per_point_overhead * points_per_util_proc;
 }
 
-TaskManager::TaskManager(size_t _max_num_tasks)
-    : max_num_tasks(_max_num_tasks) {
-  tasks = (SimTask **)malloc(sizeof(SimTask *) * max_num_tasks);
-  for (size_t i = 0; i < max_num_tasks; i++) {
-    tasks[i] = new SimTask();
-  }
+bool StepTimeVarianceModel::enabled() const {
+  return quantile > 0.0f;
 }
 
-void TaskManager::reset() {
-  global_task_id = 0;
-  hash_to_forward_task.clear();
-  hash_to_backward_task.clear();
+float StepTimeVarianceModel::stddev(float run_time,
+                                    float measured_stddev) const {
+  float injected = jitter * run_time;
+  return std::sqrt(measured_stddev * measured_stddev + injected * injected);
 }
 
-SimTask *TaskManager::new_task() {
-  assert(global_task_id + 1 < max_num_tasks);
-  SimTask *task = tasks[global_task_id++];
-  task->ready_time = 0.0f;
-  task->run_time = 0.0f;
-  task->next_tasks.clear();
-  task->counter = 0;
-  task->device = NULL;
-  task->mem = NULL;
-  task->name.clear();
-
-  task->xfer_size = 0;
-  task->xfer_left = 0;
-  task->store = true;
+// Inverse of the standard normal CDF
+static double normal_quantile(double p) {
+  assert(p > 0.0 && p < 1.0);
+  double lo = -10.0, hi = 10.0;
+  for (int i = 0; i < 64; i++) {
+    double mid = 0.5 * (lo + hi);
+    if (0.5 * std::erfc(-mid / std::sqrt(2.0)) < p) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  return 0.5 * (lo + hi);
+}
 
-  return task;
+float StepTimeVarianceModel::straggler_time(float stddev,
+                                            int num_devices) const {
+  if (!enabled() || stddev <= 0.0f) {
+    return 0.0f;
+  }
+  assert(quantile < 1.0f);
+  assert(num_devices > 0);
+  // The devices of an operator run in lockstep, so its time is the maximum of
+  // num_devices samples, whose quantile q is the quantile q^(1/n) of a sample
+  double p = std::pow((double)quantile, 1.0 / num_devices);
+  return std::max(0.0f, (float)(stddev * normal_quantile(p)));
 }
 
-SimTask *TaskManager::new_update_task() {
-  SimTask *task = new_task();
-  task->type = SimTask::TASK_UPDATE;
-  return task;
+float StepTimeVarianceModel::sample_run_time(float run_time,
+                                             float stddev,
+                                             std::mt19937 &rng) const {
+  if (stddev <= 0.0f) {
+    return run_time;
+  }
+  std::normal_distribution<float> dist(run_time, stddev);
+  return std::max(0.0f, dist(rng));
 }
 
-SimTask *TaskManager::new_barrier_task() {
-  SimTask *task = new_task();
-  task->type = SimTask::TASK_BARRIER;
-  return task;
+float StepTimeVarianceModel::sample_quantile(
+    std::vector<float> samples) const {
+  assert(samples.size() > 0);
+  std::sort(samples.begin(), samples.end());
+  int idx = (int)std::ceil(quantile * samples.size()) - 1;
+  idx = std::min(std::max(idx, 0), (int)samples.size() - 1);
+  return samples[idx];
 }
 
-SimTask *TaskManager::new_comm_task() {
-  SimTask *task = new_task();
-  task->type = SimTask::TASK_COMM;
-  return task;
+// Input, weight and no-op operators do not launch any tasks per iteration
+static bool op_launches_tasks(Op const *op) {
+  switch (op->op_type) {
+    case OP_INPUT:
+    case OP_WEIGHT:
+    case OP_NOOP:
+      return false;
+    default:
+      return true;
+  }
 }
 
-SimTask *TaskManager::new_comm_task(std::string const &name,
-                                    CommDevice *comm_device,
-                                    size_t message_size) {
-  SimTask *task = new_task();
-  task->type = SimTask::TASK_COMM;
-  task->name = name;
-  task->device = comm_device;
-  task->run_time = comm_device->latency + message_size / comm_device->bandwidth;
-  return task;
+float Simulator::estimate_launch_cost(Op const *op,
+                                      MachineView const &view) const {
+  if (!launch_cost_model.enabled() || !op_launches_tasks(op)) {
+    return 0.0f;
+  }
+  if (alias_parallel_ops &&
+      (op->op_type == OP_REPARTITION || op->op_type == OP_COMBINE)) {
+    return 0.0f;
+  }
+  // Each node maps its own points of an index launch
+  std::map<int, int> node_to_num_points;
+  for (int device_id : view.device_ids()) {
+    node_to_num_points[machine->get_gpu(device_id)->node_id]++;
+  }
+  float launch_time = 0.0f;
+  for (auto const &it : node_to_num_points) {
+    launch_time =
+        std::max(launch_time, launch_cost_model.launch_time(it.second));
+  }
+  if (computationMode == COMP_MODE_TRAINING) {
+    // One launch for the forward pass and one for the backward pass
+    launch_time *= 2;
+  }
+  return launch_time;
 }
 
-SimTask *TaskManager::new_forward_task(Op const *op, int idx) {
-  SimTask *task = new_task();
-  task->type = SimTask::TASK_FORWARD;
-  size_t hash = 17 * 31 + (size_t)(op);
-  hash = hash * 31 + std::hash<int>()(idx);
-  hash_to_forward_task[hash] = task;
-  task->name = op->name;
-  return task;
+// Placement-independent part of the fusion rules in FFModel::apply_fusion.
+// Only consumers fed entirely by producer are considered so that each
+// consumer is credited at most once across the edges of the search
+static bool fusable_ops(Op const *producer, Op const *consumer) {
+  if (!FusedOp::can_fuse(producer) || !FusedOp::can_fuse(consumer)) {
+    return false;
+  }
+  if (const_cast<Op *>(producer)->has_inplace_output()) {
+    return false;
+  }
+  if (!FusedOp::within_limits(2,
+                              producer->numInputs + consumer->numInputs,
+                              producer->numWeights + consumer->numWeights,
+                              producer->numOutputs + consumer->numOutputs)) {
+    return false;
+  }
+  for (int i = 0; i < consumer->numInputs; i++) {
+    if (consumer->inputs[i]->owner_op != producer) {
+      return false;
+    }
+  }
+  return true;
 }
 
-SimTask *TaskManager::new_backward_task(Op const *op, int idx) {
-  SimTask *task = new_task();
-  task->type = SimTask::TASK_BACKWARD;
-  size_t hash = 17 * 31 + (size_t)(op);
-  hash = hash * 31 + std::hash<int>()(idx);
-  hash_to_backward_task[hash] = task;
-  task->name = op->name;
-  return task;
+float Simulator::estimate_straggler_cost(CostMetrics const &metrics,
+                                         MachineView const &view) const {
+  if (!variance_model.enabled()) {
+    return 0.0f;
+  }
+  float measured_stddev =
+      std::sqrt(metrics.forward_time_stddev * metrics.forward_time_stddev +
+                metrics.backward_time_stddev * metrics.backward_time_stddev);
+  float stddev = variance_model.stddev(
+      metrics.forward_time + metrics.backward_time, measured_stddev);
+  return variance_model.straggler_time(stddev, view.num_parts());
 }
 
-SimTask *TaskManager::get_forward_task(Op const *op, int idx) {
-  size_t hash = 17 * 31 + (size_t)(op);
-  hash = hash * 31 + std::hash<int>()(idx);
-  assert(hash_to_forward_task.find(hash) != hash_to_forward_task.end());
-  return hash_to_forward_task[hash];
+bool Simulator::can_fuse(Op const *producer,
+                         MachineView const &producer_view,
+                         Op const *consumer,
+                         MachineView const &consumer_view) {
+  return producer_view == consumer_view && fusable_ops(producer, consumer);
 }
 
-SimTask *TaskManager::get_backward_task(Op const *op, int idx) {
-  size_t hash = 17 * 31 + (size_t)(op);
-  hash = hash * 31 + std::hash<int>()(idx);
-  assert(hash_to_backward_task.find(hash) != hash_to_backward_task.end());
-  return hash_to_backward_task[hash];
+float Simulator::estimate_fusion_savings(Op const *producer,
+                                         MachineView const &producer_view,
+                                         Op const *consumer,
+                                         MachineView const &consumer_view) {
+  if (!fusion_aware ||
+      !can_fuse(producer, producer_view, consumer, consumer_view)) {
+    return 0.0f;
+  }
+  // The fused consumer runs inside the producer's task and launches nothing
+  return this->measure_operator_cost(consumer, consumer_view).launch_time;
 }
 
-void Simulator::free_all() {
-  offset = 0;
+CompDevice *Simulator::get_utility_proc(int node_id) {
+  while ((int)utility_procs.size() <= node_id) {
+    int id = utility_procs.size();
+    std::string name = "UTIL " + std::to_string(id);
+    utility_procs.push_back(
+        new CompDevice(name, CompDevice::UTIL_PROC, id, id, id));
+  }
+  return utility_procs[node_id];
 }
 
 size_t data_type_size(DataType type) {
@@ -386,96 +429,21 @@ void Simulator::add_task_dependencies_with_xfer(SimTask *src_task,
                                                 SimTask *dst_task,
                                                 size_t message_size,
                                                 bool zero_cost) {
-  std::vector<CommDevice *> path =
-      machine->get_comm_path(src_task->mem, dst_task->mem);
-  // print the communication path
-  // printf("Message: %zu B\nPath from %s to %s is: ", message_size,
-  // src_task->mem->name.c_str(), dst_task->mem->name.c_str()); for (size_t i =
-  // 0; i < path.size(); i++) {
-  //   printf("%s ", path[i]->name.c_str());
-  // }
-  // printf("\n");
-
-  if (path.empty() || zero_cost) {
-    log_xfer_sim.spew("Simulated xfer cost from %s to %s: 0ms",
-                      src_task->name.c_str(),
-                      dst_task->name.c_str());
-    src_task->add_next_task(dst_task);
-    return;
-  }
-  assert(message_size > 0);
-  std::vector<std::vector<SimTask *>> all_tasks;
-  // Limit the max number of segments per message
-  int seg_size = segment_size;
-  int num_segment = message_size / seg_size;
-  if (message_size % seg_size != 0) {
-    num_segment += 1;
-  }
-  if (num_segment > max_num_segments) {
-    num_segment = max_num_segments;
-    seg_size = message_size / num_segment;
-  }
-  // optional optimization: can reduce the simulation time, but could also
-  // impact the accuracy of the simulation (a communication can be occupied by a
-  // message for long time without be used by other concurrent communication
-  //   if (path.size() == 1) {
-  //     num_segment = 1;
-  //     seg_size = message_size;
-  //   }
-  // Create all the comm tasks
-  // Divide messages into segments
-  for (size_t i = 0; i < path.size(); i++) {
-    all_tasks.push_back({});
-    for (int j = 0; j < num_segment; j++) {
-      int cur_seg_size = seg_size;
-      if (j == num_segment - 1) {
-        cur_seg_size = message_size - (num_segment - 1) * seg_size;
-      }
-      std::string name = "seg " + std::to_string(j) + " from " +
-                         src_task->name + " to " + dst_task->name;
-      SimTask *cur_task =
-          task_manager->new_comm_task(name, path[i], cur_seg_size);
-      all_tasks[i].push_back(cur_task);
-      if (j == 0) {
-        log_xfer_sim.debug("Simulated xfer cost from %s to %s: %fms (%d)",
-                           src_task->name.c_str(),
-                           dst_task->name.c_str(),
-                           cur_task->run_time,
-                           cur_seg_size);
-      }
-    }
-  }
-
-  // Add dependencies among the comm tasks
-  for (size_t i = 0; i < path.size(); i++) {
-    for (int j = 0; j < num_segment; j++) {
-      if (i == 0) {
-        src_task->add_next_task(all_tasks[i][j]);
-      }
-      if (i == path.size() - 1) {
-        all_tasks[i][j]->add_next_task(dst_task);
-      }
-      if (i > 0) {
-        all_tasks[i - 1][j]->add_next_task(all_tasks[i][j]);
-      }
-    }
-  }
-
-  // Add special dependencies for upi_ins, upi_outs, nic_ins, and nic_outs to
-  // prevent communication overlap between upi_ins and upi_outs, and between
-  // nic_ins and nic_outs.
-  if (num_segment > 1 and path.size() >= 2) {
-    for (size_t i = 0; i < path.size(); i++) {
-      for (int j = 0; j < num_segment - 1; j++) {
-        if (((CommDevice *)all_tasks[i][j]->device)->comm_type ==
-                CommDevice::NIC_OUT_COMM or
-            ((CommDevice *)all_tasks[i][j]->device)->comm_type ==
-                CommDevice::UPI_OUT_COMM) {
-          all_tasks[i][j]->add_next_task(all_tasks[i - 1][j + 1]);
-        }
-      }
-    }
-  }
+  task_manager->xfers.push_back(
+      TaskManager::Xfer{src_task, dst_task, message_size, zero_cost});
+  log_xfer_sim.debug("Simulated xfer of %zu bytes from %s to %s%s",
+                     zero_cost ? (size_t)0 : message_size,
+                     src_task->name.c_str(),
+                     dst_task->name.c_str(),
+                     zero_cost ? " (zero cost)" : "");
+  add_xfer_tasks(task_manager,
+                 machine,
+                 src_task,
+                 dst_task,
+                 message_size,
+                 zero_cost,
+                 segment_size,
+                 max_num_segments);
 }
 
 [[noreturn]] void handle_measure_operator_cost_unimplemented(Op const *op) {
@@ -534,23 +502,26 @@ ParallelConfig Op::view_to_pc(MachineView const &view) const {
   return config;
 }
 
-CostMetrics Simulator::measure_operator_cost(Op const *op,
-                                             MachineView const &mv) {
+CostMetrics Simulator::measure_kernel_cost(Op const *op,
+                                          MachineView const &mv) {
+  // A simulator without a device can only estimate
+  assert(analytic_cost_model != NULL || simulatorInst.exists());
   tl::optional<OperatorParameters> retrieved_params = get_op_parameters(op);
   if (retrieved_params.has_value()) {
-    OperatorParameters params = retrieved_params.value();
-    ProfilingRecordKey key{params, mv};
-    if (this->strict_hash_to_operator_cost.find(key) ==
-        this->strict_hash_to_operator_cost.end()) {
+    ProfilingRecordKey key{retrieved_params.value(), mv};
+    if (this->strict_hash_to_kernel_cost.find(key) ==
+        this->strict_hash_to_kernel_cost.end()) {
       CostMetrics cost_metrics{};
-      bool is_implemented = op->measure_operator_cost(this, mv, cost_metrics);
+      bool is_implemented =
+          analytic_cost_model != NULL
+              ? this->estimate_kernel_cost(op, mv, cost_metrics)
+              : op->measure_operator_cost(this, mv, cost_metrics);
       if (!is_implemented) {
         handle_measure_operator_cost_unimplemented(op);
       }
-      op->estimate_sync_cost(this, mv, cost_metrics);
-      this->strict_hash_to_operator_cost[key] = cost_metrics;
+      this->strict_hash_to_kernel_cost[key] = cost_metrics;
     }
-    return this->strict_hash_to_operator_cost.at(key);
+    return this->strict_hash_to_kernel_cost.at(key);
   }
 
   size_t hash = 17 * 31 + op->get_untyped_params_hash();
@@ -564,11 +535,13 @@ CostMetrics Simulator::measure_operator_cost(Op const *op,
 
   if (iter == hash_to_operator_cost.end()) {
     CostMetrics cost_metrics{};
-    bool is_implemented = op->measure_operator_cost(this, mv, cost_metrics);
+    bool is_implemented =
+        analytic_cost_model != NULL
+            ? this->estimate_kernel_cost(op, mv, cost_metrics)
+            : op->measure_operator_cost(this, mv, cost_metrics);
     if (!is_implemented) {
       handle_measure_operator_cost_unimplemented(op);
     }
-    op->estimate_sync_cost(this, mv, cost_metrics);
     hash_to_operator_cost[hash] = cost_metrics;
     return cost_metrics;
   } else {
@@ -576,13 +549,129 @@ CostMetrics Simulator::measure_operator_cost(Op const *op,
   }
 }
 
+// Add the bytes of the parts of tensors on one device of the view to size
+static bool add_sub_tensor_sizes(ParallelTensor const *tensors,
+                          int num_tensors,
+                          MachineView const &mv,
+                          size_t &size) {
+  for (int i = 0; i < num_tensors; i++) {
+    ParallelTensorBase sub_tensor;
+    if (!tensors[i]->get_sub_tensor(mv, sub_tensor)) {
+      return false;
+    }
+    size += sub_tensor.get_volume() * data_type_size(sub_tensor.data_type);
+  }
+  return true;
+}
+
+bool Simulator::estimate_kernel_cost(Op const *op,
+                                     MachineView const &mv,
+                                     CostMetrics &cost_metrics) const {
+  assert(analytic_cost_model != NULL);
+  if (!add_sub_tensor_sizes(
+          op->inputs, op->numInputs, mv, cost_metrics.inputs_memory) ||
+      !add_sub_tensor_sizes(
+          op->outputs, op->numOutputs, mv, cost_metrics.outputs_memory) ||
+      !add_sub_tensor_sizes(
+          op->weights, op->numWeights, mv, cost_metrics.weights_memory)) {
+    return false;
+  }
+  double bytes = cost_metrics.total_memory();
+  ParallelTensorBase sub_output, sub_tensor;
+  if (op->numOutputs > 0) {
+    op->outputs[0]->get_sub_tensor(mv, sub_output);
+  }
+  size_t weight_volume = 0;
+  if (op->numWeights > 0) {
+    op->weights[0]->get_sub_tensor(mv, sub_tensor);
+    weight_volume = sub_tensor.get_volume();
+  }
+  double output_volume = op->numOutputs > 0 ? sub_output.get_volume() : 0.0;
+  // One operation per output element, unless every output element is a dot
+  // product with a row of the weights (or of the second operand)
+  double flops = output_volume;
+  switch (op->op_type) {
+    case OP_LINEAR:
+    case OP_MULTIHEAD_ATTENTION: // the projections only
+      flops = 2.0 * output_volume * weight_volume / sub_output.dims[0].size;
+      break;
+    case OP_CONV2D:
+      flops = 2.0 * output_volume * weight_volume /
+              sub_output.dims[Conv2DOutput::CHANNEL].size;
+      break;
+    case OP_BATCHMATMUL: {
+      op->inputs[0]->get_sub_tensor(mv, sub_tensor);
+      flops = 2.0 * output_volume * sub_tensor.dims[0].size;
+      break;
+    }
+    default:
+      break;
+  }
+  cost_metrics.forward_time = analytic_cost_model->kernel_time(flops, bytes);
+  if (computationMode == COMP_MODE_TRAINING) {
+    // The gradients of the inputs and of the weights, and the memory they
+    // take next to the tensors
+    cost_metrics.backward_time =
+        analytic_cost_model->kernel_time(2.0 * flops, 2.0 * bytes);
+    cost_metrics.inputs_memory *= 2;
+    cost_metrics.outputs_memory *= 2;
+    cost_metrics.weights_memory *= 2;
+  }
+  return true;
+}
+
+size_t Simulator::estimate_optimizer_state_memory(
+    Op const *op, MachineView const &view) const {
+  if (computationMode != COMP_MODE_TRAINING || optimizer_state_bytes <= 0.0f) {
+    return 0;
+  }
+  size_t volume = 0;
+  for (int i = 0; i < op->numWeights; i++) {
+    ParallelTensorBase sub_tensor;
+    if (op->weights[i]->get_sub_tensor(view, sub_tensor)) {
+      volume += sub_tensor.get_volume();
+    }
+  }
+  return (size_t)(volume * optimizer_state_bytes);
+}
+
+CostMetrics Simulator::measure_operator_cost(Op const *op,
+                                             MachineView const &mv) {
+  tl::optional<OperatorParameters> retrieved_params = get_op_parameters(op);
+  if (retrieved_params.has_value()) {
+    ProfilingRecordKey key{retrieved_params.value(), mv};
+    auto iter = this->strict_hash_to_operator_cost.find(key);
+    if (iter != this->strict_hash_to_operator_cost.end()) {
+      return iter->second;
+    }
+  }
+  // The sync, launch and straggler costs depend on the machine model
+  CostMetrics cost_metrics = this->measure_kernel_cost(op, mv);
+  op->estimate_sync_cost(this, mv, cost_metrics);
+  cost_metrics.launch_time = this->estimate_launch_cost(op, mv);
+  cost_metrics.straggler_time = this->estimate_straggler_cost(cost_metrics, mv);
+  cost_metrics.weights_memory += this->estimate_optimizer_state_memory(op, mv);
+  if (retrieved_params.has_value()) {
+    ProfilingRecordKey key{retrieved_params.value(), mv};
+    this->strict_hash_to_operator_cost[key] = cost_metrics;
+  }
+  return cost_metrics;
+}
+
+void Simulator::set_machine_model(MachineModel *_machine) {
+  machine = _machine;
+  // Measured kernel times carry over to the new machine
+  strict_hash_to_operator_cost.clear();
+}
+
 float Simulator::estimate_repartition_xfer_cost(
     int repartition_dim,
     int repartition_degree,
     ParallelTensorShape const &input_tensor_shape,
     ParallelTensorShape const &output_tensor_shape,
     MachineView const &source_view,
-    MachineView const &sink_view) const {
+    MachineView const &sink_view,
+    bool skip_colocated) const {
   assert(source_view != sink_view);
 
   auto tensor_dim_to_mv_dim_mapping =
@@ -597,6 +686,10 @@ float Simulator::estimate_repartition_xfer_cost(
     source_dp.point_data[tensor_dim_to_mv_dim_mapping.at(repartition_dim)] /=
         repartition_degree;
     int source_device = source_view.get_device_id(source_dp);
+    if (skip_colocated && source_device == sink_device) {
+      // The piece is already in place
+      continue;
+    }
 
     float bandwidth = 0.0f;
     int src_node_id = machine->get_gpu(source_device)->node_id;
@@ -641,7 +734,8 @@ float Simulator::estimate_xfer_cost(Op const *op,
                                                     input_tensor->get_shape(),
                                                     output_tensor->get_shape(),
                                                     source_view,
-                                                    sink_view);
+                                                    sink_view,
+                                                    alias_parallel_ops);
       }
       case OP_COMBINE: {
         Combine *combine = (Combine *)op;
@@ -651,7 +745,8 @@ float Simulator::estimate_xfer_cost(Op const *op,
                                                     output_tensor->get_shape(),
                                                     input_tensor->get_shape(),
                                                     sink_view,
-                                                    source_view);
+                                                    source_view,
+                                                    alias_parallel_ops);
       }
       case OP_REPLICATE: {
         Replicate *replicate = (Replicate *)op;
@@ -735,7 +830,9 @@ float Simulator::estimate_xfer_cost(Op const *op,
       d.rect_data[i] = 0;
       d.rect_data[i + d.dim] = source_view.dim[i] - 1;
     }
-    const ParallelTensor input_tensor = op->inputs[input_idx];
+    // A slice only reads the window of its input matching its output
+    const ParallelTensor input_tensor =
+        op->op_type == OP_SLICE ? op->outputs[0] : op->inputs[input_idx];
     size_t total_size = data_type_size(input_tensor->data_type);
     for (int i = 0; i < input_tensor->num_dims; i++) {
       total_size *= input_tensor->dims[i].size / input_tensor->dims[i].degree;
@@ -812,6 +909,84 @@ float Simulator::default_estimate_sync_cost(
   }
 }
 
+float Simulator::simulate_task_graph(std::string const &export_file_name) {
+  TaskGraphSchedule schedule =
+      schedule_task_graph(task_manager, export_file_name);
+  // Walk back the critical path from the last task to finish
+  critical_path_costs.clear();
+  for (SimTask *task = schedule.last_task; task != NULL;
+       task = task->critical_pred) {
+    if (task->op != NULL) {
+      critical_path_costs[task->op] += task->run_time;
+    }
+  }
+  return schedule.makespan;
+}
+
+void Simulator::export_task_graph_trace(std::string const &file_name) const {
+  TaskGraphTrace trace;
+  trace.num_gpus = machine->get_num_gpus();
+  trace.segment_size = segment_size;
+  trace.max_num_segments = max_num_segments;
+  std::unordered_map<SimTask const *, int> task_ids;
+  for (size_t i = 0; i < task_manager->global_task_id; i++) {
+    SimTask const *task = task_manager->tasks[i];
+    TaskGraphTrace::Task t;
+    switch (task->type) {
+      case SimTask::TASK_FORWARD:
+        t.type = TaskGraphTrace::TASK_FORWARD;
+        break;
+      case SimTask::TASK_BACKWARD:
+        t.type = TaskGraphTrace::TASK_BACKWARD;
+        break;
+      case SimTask::TASK_UPDATE:
+        t.type = TaskGraphTrace::TASK_UPDATE;
+        break;
+      case SimTask::TASK_BARRIER:
+        t.type = TaskGraphTrace::TASK_BARRIER;
+        break;
+      case SimTask::TASK_LAUNCH:
+        t.type = TaskGraphTrace::TASK_LAUNCH;
+        break;
+      case SimTask::TASK_COMM:
+        // Expanded again from the transfers on replay
+        continue;
+      default:
+        assert(false && "Unsupported task type in a task graph trace");
+    }
+    t.device_id = t.type == TaskGraphTrace::TASK_LAUNCH
+                      ? task->device->node_id
+                      : task->device->device_id;
+    t.run_time = task->run_time;
+    t.name = task->name;
+    task_ids[task] = trace.tasks.size();
+    trace.tasks.push_back(t);
+  }
+  std::set<std::pair<SimTask const *, SimTask const *>> xfer_pairs;
+  for (TaskManager::Xfer const &xfer : task_manager->xfers) {
+    trace.edges.push_back(TaskGraphTrace::Edge{
+        task_ids.at(xfer.src),
+        task_ids.at(xfer.dst),
+        xfer.zero_cost ? 0 : xfer.size});
+    xfer_pairs.insert(std::make_pair(xfer.src, xfer.dst));
+  }
+  for (auto const &it : task_ids) {
+    for (SimTask const *next : it.first->next_tasks) {
+      if (task_ids.find(next) != task_ids.end() &&
+          xfer_pairs.find(std::make_pair(it.first, next)) ==
+              xfer_pairs.end()) {
+        trace.edges.push_back(
+            TaskGraphTrace::Edge{it.second, task_ids.at(next), 0});
+      }
+    }
+  }
+  std::ofstream file(file_name);
+  trace.write(file);
+  if (!file) {
+    fprintf(stderr, "Cannot write task graph trace %s\n", file_name.c_str());
+  }
+}
+
 float Simulator::simulate_runtime(
     FFModel const *model,
     std::map<Op const *, ParallelConfig> const &global,
@@ -824,12 +999,60 @@ float Simulator::simulate_runtime(
     std::map<Op const *, ParallelConfig> const &global,
     CompMode comp_mode,
     std::string const &export_file_name) {
+  return this->simulate_strategy(
+      model, global, NULL, comp_mode, export_file_name);
+}
+
+float Simulator::simulate_runtime(
+    FFModel const *model,
+    std::map<Op const *, MachineView> const &views,
+    CompMode comp_mode,
+    std::string const &export_file_name) {
+  std::map<Op const *, ParallelConfig> global;
+  for (Op const *op : model->operators) {
+    global[op] = op->view_to_pc(views.at(op));
+  }
+  return this->simulate_strategy(
+      model, global, &views, comp_mode, export_file_name);
+}
+
+/**
+ * @brief The part part_idx of tensor when it is split like partition, which
+ * has the same dims. A dim split more ways than it has elements, e.g. the
+ * replica dim read by a Replicate, is read whole by every part.
+ */
+static Domain get_part_domain(ParallelTensor const tensor,
+                              ParallelTensor const partition,
+                              int part_idx) {
+  assert(tensor->num_dims == partition->num_dims);
+  Domain d;
+  d.dim = tensor->num_dims;
+  for (int i = 0; i < d.dim; i++) {
+    int degree = partition->dims[i].degree;
+    int num_parts = std::min(degree, tensor->dims[i].size);
+    assert(tensor->dims[i].size % num_parts == 0);
+    int dim_size = tensor->dims[i].size / num_parts;
+    d.rect_data[i] = (part_idx % degree) % num_parts * dim_size;
+    d.rect_data[i + d.dim] = d.rect_data[i] + dim_size - 1;
+    part_idx = part_idx / degree;
+  }
+  return d;
+}
+
+float Simulator::simulate_strategy(
+    FFModel const *model,
+    std::map<Op const *, ParallelConfig> const &global,
+    std::map<Op const *, MachineView> const *views,
+    CompMode comp_mode,
+    std::string const &export_file_name) {
   // printf("%s\n", machine->to_string().c_str());
   task_manager->reset();
   // Step 1: register forward and backward tasks
   for (Op *op : model->operators) {
     ParallelConfig config = global.find(op)->second;
-    CostMetrics cost_metrics = measure_operator_cost(op, config);
+    CostMetrics cost_metrics = views != NULL
+                                   ? measure_operator_cost(op, views->at(op))
+                                   : measure_operator_cost(op, config);
     float forward_time = cost_metrics.forward_time;
     float backward_time = cost_metrics.backward_time;
     for (int j = 0; j < config.num_parts(); j++) {
@@ -837,15 +1060,75 @@ float Simulator::simulate_runtime(
       task1->device = machine->get_gpu(config.device_ids[j]);
       task1->mem = machine->get_gpu_fb_mem(config.device_ids[j]);
       task1->run_time = forward_time;
+      task1->run_time_stddev = cost_metrics.forward_time_stddev;
       if (comp_mode == COMP_MODE_TRAINING) {
         SimTask *task2 = task_manager->new_backward_task(op, j);
         task2->device = machine->get_gpu(config.device_ids[j]);
         task2->mem = machine->get_gpu_fb_mem(config.device_ids[j]);
         task2->run_time = backward_time;
+        task2->run_time_stddev = cost_metrics.backward_time_stddev;
         task1->add_next_task(task2);
       }
     }
   }
+  // Step 1.5: add task launches on the utility processors. Launches are
+  // issued in program order (forward in operator order, then backward in
+  // reverse operator order), so the launches on a node are serialized and
+  // each launch gates the points it maps on that node. With fusion-aware
+  // search, ops that apply_fusion will fold into their producer share the
+  // launch of the first op of the fused chain
+  if (launch_cost_model.enabled()) {
+    std::map<Op const *, Op const *> fused_into;
+    for (Op *op : model->operators) {
+      fused_into[op] = op;
+      if (!fusion_aware || op->numInputs == 0) {
+        continue;
+      }
+      Op const *pre_op = op->inputs[0]->owner_op;
+      if (pre_op != NULL && fusable_ops(pre_op, op) &&
+          global.find(pre_op)->second == global.find(op)->second) {
+        fused_into[op] = fused_into[pre_op];
+      }
+    }
+    std::map<int, SimTask *> node_to_last_launch;
+    int num_passes = (comp_mode == COMP_MODE_TRAINING) ? 2 : 1;
+    int num_ops = model->operators.size();
+    for (int pass = 0; pass < num_passes; pass++) {
+      std::map<Op const *, std::map<int, SimTask *>> launches;
+      for (int i = 0; i < num_ops; i++) {
+        Op *op = model->operators[pass == 0 ? i : num_ops - 1 - i];
+        if (!op_launches_tasks(op)) {
+          continue;
+        }
+        ParallelConfig config = global.find(op)->second;
+        std::map<int, std::vector<SimTask *>> node_to_tasks;
+        for (int j = 0; j < config.num_parts(); j++) {
+          SimTask *task = (pass == 0) ? task_manager->get_forward_task(op, j)
+                                      : task_manager->get_backward_task(op, j);
+          node_to_tasks[task->device->node_id].push_back(task);
+        }
+        Op const *root = fused_into[op];
+        bool launched = launches.find(root) != launches.end();
+        for (auto const &it : node_to_tasks) {
+          if (!launched) {
+            SimTask *launchT = task_manager->new_launch_task(
+                root,
+                get_utility_proc(it.first),
+                launch_cost_model.launch_time(it.second.size()));
+            if (node_to_last_launch.find(it.first) !=
+                node_to_last_launch.end()) {
+              node_to_last_launch[it.first]->add_next_task(launchT);
+            }
+            node_to_last_launch[it.first] = launchT;
+            launches[root][it.first] = launchT;
+          }
+          for (SimTask *task : it.second) {
+            launches[root][it.first]->add_next_task(task);
+          }
+        }
+      }
+    }
+  }
   // Step 2: insert dependencies and comm. tasks before compute tasks
   for (Op *op : model->operators) {
     ParallelConfig config = global.find(op)->second;
@@ -858,10 +1141,17 @@ float Simulator::simulate_runtime(
       ParallelConfig pre_config = global.find(pre_op)->second;
       size_t element_size = data_type_size(t->data_type);
       for (int dstId = 0; dstId < config.num_parts(); dstId++) {
-        Domain dstR = op->get_input_tensor_shape(config, j, dstId);
+        // In a PCG only parallel ops read their inputs split otherwise
+        Domain dstR =
+            views == NULL
+                ? op->get_input_tensor_shape(config, j, dstId)
+                : get_part_domain(
+                      t, op->is_parallel_op() ? op->outputs[0] : t, dstId);
         for (int srcId = 0; srcId < pre_config.num_parts(); srcId++) {
           Domain srcR =
-              pre_op->get_output_tensor_shape(pre_config, t->owner_idx, srcId);
+              views == NULL ? pre_op->get_output_tensor_shape(
+                                  pre_config, t->owner_idx, srcId)
+                            : get_part_domain(t, t, srcId);
           bool force_zero_cost = pre_op->op_type == OP_INPUT;
           if (dstR.intersection(srcR).get_volume() > 0) {
             // Forward dependency
@@ -933,6 +1223,7 @@ float Simulator::simulate_runtime(
             Domain firstR = op->get_weight_tensor_shape(pc, j, firstId);
             // Add a compute task for parameter update
             SimTask *updateT = task_manager->new_update_task();
+            updateT->op = op;
             updateT->device = machine->get_gpu(pc.device_ids[firstId]);
             updateT->mem = machine->get_gpu_fb_mem(pc.device_ids[firstId]);
             // TODO add parameter synchronization time
@@ -991,6 +1282,7 @@ float Simulator::simulate_runtime(
             Domain firstR = op->get_weight_tensor_shape(pc, j, firstId);
             // Add a compute task for parameter update
             SimTask *updateT = task_manager->new_update_task();
+            updateT->op = op;
             updateT->device = machine->get_gpu(pc.device_ids[firstId]);
             updateT->mem = machine->get_gpu_fb_mem(pc.device_ids[firstId]);
             updateT->run_time = 0.0f; // Assume update task takes no time
@@ -1023,73 +1315,37 @@ float Simulator::simulate_runtime(
     assert(comp_mode == COMP_MODE_INFERENCE);
   }
 #endif
-  // Step 4: add ready tasks into ready_queue
-  std::priority_queue<SimTask *, std::vector<SimTask *>, SimTaskCompare>
-      ready_queue;
-  for (size_t i = 0; i < task_manager->global_task_id; i++) {
-    if (task_manager->tasks[i]->counter == 0) {
-      ready_queue.push(task_manager->tasks[i]);
-    }
-  }
-  // Step 5: perform simulation
+  // Step 4 and 5: simulate the task graph, optionally sampling task run times
+  // to get the step-time quantile of the variance model
   float sim_time = 0.0f;
-  std::map<Device *, float> device_times;
-  size_t idx = 0;
-  DotFile<SimTask *> taskGraph;
-  bool export_taskgraph = (export_file_name != "");
-  if (export_taskgraph) {
-    taskGraph.set_filename(export_file_name);
-  }
-  while (!ready_queue.empty()) {
-    // Find the task with the earliest start time
-    SimTask *cur_task = ready_queue.top();
-    ready_queue.pop();
-    float ready_time = 0;
-    if (device_times.find(cur_task->device) != device_times.end()) {
-      ready_time = device_times[cur_task->device];
+  if (variance_model.enabled()) {
+    std::vector<int> counters(task_manager->global_task_id);
+    std::vector<float> run_times(task_manager->global_task_id);
+    for (size_t i = 0; i < task_manager->global_task_id; i++) {
+      counters[i] = task_manager->tasks[i]->counter;
+      run_times[i] = task_manager->tasks[i]->run_time;
     }
-    float start_time = std::max(ready_time, cur_task->ready_time);
-    float end_time = start_time + cur_task->run_time;
-    device_times[cur_task->device] = end_time;
-    if (export_taskgraph) {
-      std::map<std::string, std::string> nodeAttrs;
-      std::ostringstream label;
-      label << "\"{ ";
-      if (!(cur_task->name).empty()) {
-        label << cur_task->name << " | ";
+    std::vector<float> samples;
+    for (int k = 0; k < variance_model.num_samples; k++) {
+      for (size_t i = 0; i < task_manager->global_task_id; i++) {
+        SimTask *task = task_manager->tasks[i];
+        task->counter = counters[i];
+        task->ready_time = 0.0f;
+        task->run_time = variance_model.sample_run_time(
+            run_times[i],
+            variance_model.stddev(run_times[i], task->run_time_stddev),
+            rng);
       }
-      label << cur_task->get_type_str() << " | ";
-      label << "{ " << start_time << " | " << end_time << " }";
-      label << " }\"";
-      nodeAttrs["label"] = label.str();
-      nodeAttrs["shape"] = "record";
-      taskGraph.add_node(cur_task, nodeAttrs);
-    }
-    // printf("task[%lu] type(%d) run_time(%.4lf) ready_time(%.4lf)
-    // start_time(%.4lf) device(%s)\n",
-    //       idx, cur_task->type, cur_task->run_time, ready_time, start_time,
-    //       (cur_task->device->name).c_str());
-    if (end_time > sim_time) {
-      sim_time = end_time;
+      samples.push_back(
+          this->simulate_task_graph(k == 0 ? export_file_name : ""));
     }
-    for (size_t i = 0; i < cur_task->next_tasks.size(); i++) {
-      SimTask *next = cur_task->next_tasks[i];
-      if (export_taskgraph) {
-        taskGraph.add_edge(cur_task, next);
-      }
-      next->ready_time = std::max(next->ready_time, end_time);
-      next->counter--;
-      if (next->counter == 0) {
-        ready_queue.push(next);
-      }
+    for (size_t i = 0; i < task_manager->global_task_id; i++) {
+      task_manager->tasks[i]->run_time = run_times[i];
     }
-    idx++;
-  }
-  if (export_taskgraph) {
-    taskGraph.close();
+    sim_time = variance_model.sample_quantile(samples);
+  } else {
+    sim_time = this->simulate_task_graph(export_file_name);
   }
-  // Assert all tasks were processed
-  assert(idx == task_manager->global_task_id);
 #ifdef FF_USE_NCCL
   if (comp_mode == COMP_MODE_TRAINING) {
     std::unordered_set<Op const *> possible_syncs(model->operators.begin(),
@@ -1225,7 +1481,9 @@ float Simulator::simulate_runtime(
   for (size_t l = 0; l < model->operators.size(); l++) {
     Op *op = model->operators[l];
     ParallelConfig config = global.find(op)->second;
-    CostMetrics cost_metrics = measure_operator_cost(op, config);
+    CostMetrics cost_metrics = views != NULL
+                                   ? measure_operator_cost(op, views->at(op))
+                                   : measure_operator_cost(op, config);
     size_t memory_requirement = cost_metrics.total_memory();
     for (int j = 0; j < config.num_parts(); j++) {
       gpu_mem_usage[config.device_ids[j]] += memory_requirement;
@@ -1687,6 +1945,11 @@ float LogicalTaskgraphBasedSimulator::route_transfer_seg(
   return final_finish_time;
 }
 
+static std::random_device rd;
+static std::mt19937 gen = std::mt19937(rd());
+static std::uniform_real_distribution<> std_uniform =
+    std::uniform_real_distribution<>(0.0, 1.0);
+
 void LogicalTaskgraphBasedSimulator::expand_allreduce(
     SimTask *allreduce_task,
     float start_time,
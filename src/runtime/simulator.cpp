@@ -80,8 +80,6 @@ Simulator::Simulator(FFModel const *model,
   checkCUDNN(miopenSetStream(handler.dnn, stream));
 #endif
 
-  size_t max_num_tasks = 1024 * 1024;
-
   hipEventCreate(&start_event);
   hipEventCreate(&end_event);
   conv2d_meta = new Conv2DMeta(handler);
@@ -95,15 +93,17 @@ Simulator::Simulator(FFModel const *model,
   concat_meta = new ConcatMeta(handler);
   // dropout_meta = new DropoutMeta(handler);
   transpose_meta = new TransposeMeta(handler);
-  this->machine = machine;
-  segment_size = model->config.simulator_segment_size;
-  max_num_segments = model->config.simulator_max_num_segments;
-  // Initialize task manager
-  task_manager = new TaskManager(max_num_tasks);
+  init_options(model, machine);
 }
 
 Simulator::~Simulator(void) {
-  simulatorInst.destroy();
+  // Simulators that only estimate kernel times own no device state
+  if (simulatorInst.exists()) {
+    simulatorInst.destroy();
+  }
+  for (CompDevice *util_proc : utility_procs) {
+    delete util_proc;
+  }
 }
 
 __host__ void
@@ -79,8 +79,6 @@ Simulator::Simulator(FFModel const *model,
   checkCUDNN(cudnnSetStream(handler.dnn, stream));
 #endif
 
-  size_t max_num_tasks = 1024 * 1024;
-
   cudaEventCreate(&start_event);
   cudaEventCreate(&end_event);
   conv2d_meta = new Conv2DMeta(handler);
@@ -94,17 +92,16 @@ Simulator::Simulator(FFModel const *model,
   concat_meta = new ConcatMeta(handler);
   // dropout_meta = new DropoutMeta(handler);
   transpose_meta = new TransposeMeta(handler);
-  this->machine = machine;
-  segment_size = model->config.simulator_segment_size;
-  max_num_segments = model->config.simulator_max_num_segments;
-  // Initialize task manager
-  task_manager = new TaskManager(max_num_tasks);
+  init_options(model, machine);
 }
 
 Simulator::~Simulator(void) {
-  simulatorInst.destroy();
-  cudaEventDestroy(start_event);
-  cudaEventDestroy(end_event);
+  // Simulators that only estimate kernel times own no device state
+  if (simulatorInst.exists()) {
+    simulatorInst.destroy();
+    cudaEventDestroy(start_event);
+    cudaEventDestroy(end_event);
+  }
   delete conv2d_meta;
   delete pool2d_meta;
   delete ele_unary_meta;
@@ -113,6 +110,9 @@ Simulator::~Simulator(void) {
   delete concat_meta;
   delete transpose_meta;
   delete task_manager;
+  for (CompDevice *util_proc : utility_procs) {
+    delete util_proc;
+  }
 }
 
 __host__ void
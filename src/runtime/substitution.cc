@@ -29,7 +29,9 @@
 #include "flexflow/ops/flat.h"
 #include "flexflow/ops/linear.h"
 #include "flexflow/ops/noop.h"
+#include "flexflow/ops/pad.h"
 #include "flexflow/ops/pool_2d.h"
+#include "flexflow/ops/slice.h"
 #include "flexflow/ops/softmax.h"
 #include "flexflow/ops/split.h"
 #include "flexflow/parallel_ops/combine.h"
@@ -917,6 +919,18 @@ bool GraphXfer::create_new_operator(OpX const *opx, Node &op) {
       op = model->get_or_create_node<Pool2D>(inputs[0], params);
       break;
     }
+    case OP_SLICE: {
+      Slice *slice = (Slice *)opx->matchOpX->mapOp.ptr;
+      SliceParams params = slice->get_params();
+      op = model->get_or_create_node<Slice>(inputs[0], params);
+      break;
+    }
+    case OP_PAD: {
+      Pad *pad = (Pad *)opx->matchOpX->mapOp.ptr;
+      PadParams params = pad->get_params();
+      op = model->get_or_create_node<Pad>(inputs[0], params);
+      break;
+    }
     case OP_FLAT: {
       Flat *flat = (Flat *)opx->matchOpX->mapOp.ptr;
       op = model->get_or_create_node<Flat>(inputs[0], {});
@@ -1118,6 +1132,18 @@ OpX *GraphXfer::create_pool2d(TensorX const &input, OpX const *matchOpX) {
   return pool;
 }
 
+OpX *GraphXfer::create_slice(TensorX const &input, OpX const *matchOpX) {
+  OpX *slice = new OpX(OP_SLICE, 1, 1, input);
+  slice->matchOpX = matchOpX;
+  return slice;
+}
+
+OpX *GraphXfer::create_pad(TensorX const &input, OpX const *matchOpX) {
+  OpX *pad = new OpX(OP_PAD, 1, 1, input);
+  pad->matchOpX = matchOpX;
+  return pad;
+}
+
 OpX *GraphXfer::create_attention(TensorX const &query,
                                  TensorX const &key,
                                  TensorX const &value,
@@ -1431,6 +1457,9 @@ int get_num_inputs(sl::Operator const &op) {
       return 1;
     case OP_CONV2D:
       return 1;
+    case OP_SLICE:
+    case OP_PAD:
+      return 1;
     case OP_RELU:
     case OP_IDENTITY:
     case OP_SIGMOID:
@@ -1554,7 +1583,7 @@ std::vector<OpX *>
       }
     }
 
-    // We need the matched OpX for constructing conv2d/pool2d/linear
+    // We need the matched OpX for constructing conv2d/pool2d/slice/pad
     OpX *opx = nullptr;
     switch (ops[i].op_type) {
       case OP_CONV2D: {
@@ -1571,6 +1600,20 @@ std::vector<OpX *>
         opx = xfer.create_pool2d(inputs[0], matchOpX);
         break;
       }
+      case OP_SLICE: {
+        OpX *matchOpX = src_ops == nullptr
+                            ? nullptr
+                            : find_opx_with_type(*src_ops, ops[i].op_type);
+        opx = xfer.create_slice(inputs[0], matchOpX);
+        break;
+      }
+      case OP_PAD: {
+        OpX *matchOpX = src_ops == nullptr
+                            ? nullptr
+                            : find_opx_with_type(*src_ops, ops[i].op_type);
+        opx = xfer.create_pad(inputs[0], matchOpX);
+        break;
+      }
       default:
         opx = create_opx(ops[i],
                          parallel_degree,
@@ -3606,7 +3649,8 @@ void FFModel::graph_optimize(
 
 bool FFModel::convert_graph_to_operators(
     Graph const *graph,
-    std::unordered_map<Node, MachineView> const &optimal_views) {
+    std::unordered_map<Node, MachineView> const &optimal_views,
+    std::unordered_map<Node, Node> const &offloaded_nodes) {
   // Clear operators
   operators.clear();
   std::unordered_map<Node, int> todos;
@@ -3764,6 +3808,7 @@ bool FFModel::convert_graph_to_operators(
     for (int i = 0; i < new_op->numWeights; i++) {
       new_op->weights[i]->machine_view = view;
     }
+    new_op->offload_outputs = offloaded_nodes.count(node) > 0;
     node_to_op[node] = new_op;
     operators.push_back(new_op);
     // Decrease the todos
@@ -3776,6 +3821,10 @@ bool FFModel::convert_graph_to_operators(
     }
   }
   assert(queue.size() == graph->inEdges.size());
+  for (auto const &it : offloaded_nodes) {
+    node_to_op.at(it.first)->prefetch_outputs_before =
+        node_to_op.at(it.second);
+  }
   // Remove the final parallel operators
   while (operators[operators.size() - 1]->is_parallel_op()) {
     Op *op = operators[operators.size() - 1];
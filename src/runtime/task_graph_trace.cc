@@ -0,0 +1,161 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flexflow/task_graph_trace.h"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace FlexFlow {
+
+namespace {
+
+char const *const MAGIC = "flexflow-taskgraph-trace";
+char const *const TASK_TYPE_NAMES[] = {
+    "forward", "backward", "update", "barrier", "launch"};
+int const NUM_TASK_TYPES = 5;
+
+bool read_keyword(std::istream &is,
+                  std::string const &keyword,
+                  std::string &error) {
+  std::string word;
+  if (!(is >> word) || word != keyword) {
+    error = "expected \"" + keyword + "\"";
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+int TaskGraphTrace::max_gpu_id() const {
+  int max_id = -1;
+  for (Task const &task : tasks) {
+    if (task.type != TASK_LAUNCH) {
+      max_id = std::max(max_id, task.device_id);
+    }
+  }
+  return max_id;
+}
+
+void TaskGraphTrace::write(std::ostream &os) const {
+  os << MAGIC << " " << VERSION << "\n";
+  os << "num_gpus " << num_gpus << "\n";
+  os << "segment_size " << segment_size << "\n";
+  os << "max_num_segments " << max_num_segments << "\n";
+  os << "tasks " << tasks.size() << "\n";
+  os << std::setprecision(9);
+  for (Task const &task : tasks) {
+    os << TASK_TYPE_NAMES[task.type] << " " << task.device_id << " "
+       << task.run_time << " " << (task.name.empty() ? "-" : task.name)
+       << "\n";
+  }
+  os << "edges " << edges.size() << "\n";
+  for (Edge const &edge : edges) {
+    os << edge.src << " " << edge.dst << " " << edge.xfer_size << "\n";
+  }
+}
+
+bool TaskGraphTrace::read(std::istream &is,
+                          TaskGraphTrace &trace,
+                          std::string &error) {
+  trace = TaskGraphTrace();
+  int version;
+  if (!read_keyword(is, MAGIC, error)) {
+    error = "not a task graph trace";
+    return false;
+  }
+  if (!(is >> version) || version < 1 || version > VERSION) {
+    error = "unsupported trace version";
+    return false;
+  }
+  size_t num_tasks, num_edges;
+  if (!read_keyword(is, "num_gpus", error) || !(is >> trace.num_gpus) ||
+      !read_keyword(is, "segment_size", error) ||
+      !(is >> trace.segment_size) ||
+      !read_keyword(is, "max_num_segments", error) ||
+      !(is >> trace.max_num_segments) || !read_keyword(is, "tasks", error) ||
+      !(is >> num_tasks)) {
+    if (error.empty()) {
+      error = "malformed header";
+    }
+    return false;
+  }
+  for (size_t i = 0; i < num_tasks; i++) {
+    std::string type_name, name;
+    Task task;
+    if (!(is >> type_name >> task.device_id >> task.run_time) ||
+        !std::getline(is, name)) {
+      error = "malformed task " + std::to_string(i);
+      return false;
+    }
+    int type = std::find(TASK_TYPE_NAMES,
+                         TASK_TYPE_NAMES + NUM_TASK_TYPES,
+                         type_name) -
+               TASK_TYPE_NAMES;
+    if (type == NUM_TASK_TYPES || task.device_id < 0) {
+      error = "malformed task " + std::to_string(i);
+      return false;
+    }
+    task.type = (TaskType)type;
+    size_t begin = name.find_first_not_of(" \t");
+    task.name = begin == std::string::npos ? "" : name.substr(begin);
+    if (task.name == "-") {
+      task.name.clear();
+    }
+    trace.tasks.push_back(task);
+  }
+  if (!read_keyword(is, "edges", error)) {
+    return false;
+  }
+  if (!(is >> num_edges)) {
+    error = "malformed edge count";
+    return false;
+  }
+  for (size_t i = 0; i < num_edges; i++) {
+    Edge edge;
+    if (!(is >> edge.src >> edge.dst >> edge.xfer_size) || edge.src < 0 ||
+        edge.dst < 0 || (size_t)edge.src >= num_tasks ||
+        (size_t)edge.dst >= num_tasks) {
+      error = "malformed edge " + std::to_string(i);
+      return false;
+    }
+    trace.edges.push_back(edge);
+  }
+  return true;
+}
+
+void TaskGraphReplayReport::print(std::ostream &os) const {
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(4);
+  out << "makespan: " << makespan << " ms\n";
+  out << "compute devices (busy ms, utilization):\n";
+  for (DeviceUsage const &device : compute_devices) {
+    out << "  " << std::left << std::setw(12) << device.name << std::right
+        << std::setw(12) << device.busy_time << std::setw(9)
+        << (makespan > 0.0f ? 100.0f * device.busy_time / makespan : 0.0f)
+        << "%\n";
+  }
+  out << "links (busy ms, utilization, MB):\n";
+  for (DeviceUsage const &link : links) {
+    out << "  " << std::left << std::setw(16) << link.name << std::right
+        << std::setw(12) << link.busy_time << std::setw(9)
+        << (makespan > 0.0f ? 100.0f * link.busy_time / makespan : 0.0f)
+        << "%" << std::setw(12) << link.bytes / 1e6 << "\n";
+  }
+  os << out.str();
+}
+
+} // namespace FlexFlow
@@ -0,0 +1,31 @@
+#! /usr/bin/env bash
+set -e
+
+# Capacity planning on a machine without GPUs: the simulator estimates all
+# kernel times, and the model exits after printing the plan
+
+# Cd into directory holding this script
+cd "${BASH_SOURCE[0]%/*}"
+
+if [ -z "$FF_HOME" ]; then echo "FF_HOME variable is not defined, aborting tests"; exit 1; fi
+BATCHSIZE=64
+CLUSTERS="1x1@3,1x4@3,1x8@3,2x8@3"
+THROUGHPUT=1000
+OUTPUT=capacity_planning_cpu_test.log
+
+if [[ -f "$FF_HOME/build/examples/cpp/MLP_Unify/mlp_unify" ]]; then
+	MLP_UNIFY="$FF_HOME/build/examples/cpp/MLP_Unify/mlp_unify"
+else
+	MLP_UNIFY=mlp_unify
+fi
+
+"$MLP_UNIFY" -ll:gpu 0 -ll:cpu 1 -ll:csize 4096 -ll:fsize 16384 -b ${BATCHSIZE} --budget 10 --plan-clusters "$CLUSTERS" --plan-throughput "$THROUGHPUT" 2>&1 | tee "$OUTPUT"
+
+# Every candidate is simulated and the plan is reported
+for shape in "1 x 1" "1 x 4" "1 x 8" "2 x 8"; do
+	grep -q "Capacity planning: ${shape} GPUs, step time" "$OUTPUT"
+done
+grep -q "Capacity planning Pareto front" "$OUTPUT"
+grep -q -e "Cheapest candidate reaching the target" -e "No candidate reaches the target throughput" "$OUTPUT"
+grep -q "No GPUs to compile the model for" "$OUTPUT"
+rm -f "$OUTPUT"
@@ -0,0 +1,96 @@
+#include "flexflow/activation_offload.h"
+#include "gtest/gtest.h"
+
+using namespace FlexFlow;
+
+namespace {
+
+// A chain of operators on the given devices, each read by the next one
+std::vector<OffloadOp> chain(std::vector<size_t> const &output_bytes,
+                             std::vector<int> const &devices) {
+  std::vector<OffloadOp> ops(output_bytes.size());
+  for (size_t i = 0; i < ops.size(); i++) {
+    ops[i].devices = devices;
+    ops[i].forward_time = 10.0f;
+    ops[i].backward_time = 20.0f;
+    ops[i].output_bytes = output_bytes[i];
+    ops[i].last_consumer = std::min(i + 1, ops.size() - 1);
+  }
+  return ops;
+}
+
+} // namespace
+
+TEST(activation_offload, offloads_hidden_copies_until_below_threshold) {
+  // 10 ms copies of 100 MB at 1e7 B/ms; the last two activations are the
+  // largest but are needed right at the start of the backward pass
+  std::vector<OffloadOp> ops =
+      chain({100000000, 100000000, 150000000, 150000000}, {0});
+  ActivationOffloadPlan plan =
+      plan_activation_offload(ops, {{0, 500.0f}}, 400.0f, 1e7f);
+  EXPECT_EQ(plan.offloaded, std::vector<int>({0, 1}));
+  // The prefetch of operator 1 starts at 50 ms, right at the start of the
+  // backward pass; the one of operator 0 at 70 ms, during the backward pass
+  // of operator 2
+  EXPECT_EQ(plan.prefetch_before, std::vector<int>({2, 3}));
+  EXPECT_FLOAT_EQ(plan.device_mem[0], 300.0f);
+  EXPECT_FLOAT_EQ(plan.max_per_device_mem, 300.0f);
+  EXPECT_FLOAT_EQ(plan.copy_time, 40.0f);
+
+  // Nothing to do below the threshold
+  plan = plan_activation_offload(ops, {{0, 300.0f}}, 400.0f, 1e7f);
+  EXPECT_TRUE(plan.offloaded.empty());
+  EXPECT_FLOAT_EQ(plan.max_per_device_mem, 300.0f);
+}
+
+TEST(activation_offload, never_exposes_copies) {
+  // 40 ms copies do not fit in the 40 ms forward pass once another
+  // operator ran
+  std::vector<OffloadOp> ops =
+      chain({400000000, 400000000, 400000000, 400000000}, {0});
+  ActivationOffloadPlan plan =
+      plan_activation_offload(ops, {{0, 2000.0f}}, 1000.0f, 1e7f);
+  EXPECT_TRUE(plan.offloaded.empty());
+  EXPECT_FLOAT_EQ(plan.max_per_device_mem, 2000.0f);
+
+  // The copies of an operator must be hidden on all of its devices: on
+  // device 1 the forward pass ends with operator 0, on device 2 it goes on
+  ops = chain({100000000, 0, 0}, {1, 2});
+  ops[1].devices = ops[2].devices = {2};
+  ops[1].forward_time = ops[2].forward_time = 100.0f;
+  ops[0].last_consumer = 1;
+  plan = plan_activation_offload(
+      ops, {{1, 500.0f}, {2, 500.0f}}, 450.0f, 1e7f);
+  EXPECT_TRUE(plan.offloaded.empty());
+  ops[0].devices = {2};
+  plan = plan_activation_offload(
+      ops, {{1, 500.0f}, {2, 500.0f}}, 450.0f, 1e7f);
+  EXPECT_EQ(plan.offloaded, std::vector<int>({0}));
+  EXPECT_FLOAT_EQ(plan.device_mem[1], 500.0f);
+  EXPECT_FLOAT_EQ(plan.device_mem[2], 400.0f);
+  EXPECT_FLOAT_EQ(plan.max_per_device_mem, 500.0f);
+}
+
+TEST(activation_offload, prefetches_as_late_as_hidden) {
+  // Operator 0 is only read by operator 1, and its 30 ms prefetch must end
+  // when the backward pass of operator 1 starts, at 170 ms: it is issued
+  // before the backward pass of operator 3, at 130 ms, since the one of
+  // operator 2 would be too late
+  std::vector<OffloadOp> ops = chain({300000000, 0, 0, 0, 0, 0, 0}, {0});
+  ActivationOffloadPlan plan =
+      plan_activation_offload(ops, {{0, 500.0f}}, 400.0f, 1e7f);
+  EXPECT_EQ(plan.offloaded, std::vector<int>({0}));
+  EXPECT_EQ(plan.prefetch_before, std::vector<int>({3}));
+
+  // On device 1, operators 1 to 3 do not run and the prefetch must end when
+  // the backward pass of operator 4 does, at 100 ms: it is issued before
+  // the backward pass of operator 5
+  ops = chain({300000000, 0, 0, 0, 0, 0, 0}, {0, 1});
+  for (int i = 1; i < 4; i++) {
+    ops[i].devices = {0};
+  }
+  plan = plan_activation_offload(
+      ops, {{0, 500.0f}, {1, 500.0f}}, 400.0f, 1e7f);
+  EXPECT_EQ(plan.offloaded, std::vector<int>({0}));
+  EXPECT_EQ(plan.prefetch_before, std::vector<int>({5}));
+}
@@ -0,0 +1,117 @@
+#include "flexflow/capacity_planning.h"
+#include "gtest/gtest.h"
+
+using namespace FlexFlow;
+
+TEST(capacity_planning, parse_cluster_candidates) {
+  std::vector<ClusterCandidate> candidates;
+  ASSERT_TRUE(parse_cluster_candidates("1x8@2.5,4x4@1.75", candidates));
+  ASSERT_EQ(candidates.size(), 2u);
+  EXPECT_EQ(candidates[0].num_nodes, 1);
+  EXPECT_EQ(candidates[0].gpus_per_node, 8);
+  EXPECT_FLOAT_EQ(candidates[0].cost_per_hour(), 20.0f);
+  EXPECT_EQ(candidates[1].num_gpus(), 16);
+  EXPECT_FLOAT_EQ(candidates[1].cost_per_gpu_hour, 1.75f);
+
+  EXPECT_FALSE(parse_cluster_candidates("", candidates));
+  EXPECT_FALSE(parse_cluster_candidates("2x4", candidates));
+  EXPECT_FALSE(parse_cluster_candidates("2x4@1.0,", candidates));
+  EXPECT_FALSE(parse_cluster_candidates("0x4@1.0", candidates));
+  EXPECT_FALSE(parse_cluster_candidates("2x4@1.0gpu", candidates));
+  EXPECT_TRUE(candidates.empty());
+}
+
+TEST(capacity_planning, pareto_front_and_selection) {
+  std::vector<ClusterCandidate> candidates;
+  ASSERT_TRUE(
+      parse_cluster_candidates("1x4@2,1x8@2,2x8@2,4x4@1.5", candidates));
+  // 64 samples per step
+  std::vector<CapacityPlanPoint> points;
+  points.push_back(CapacityPlanPoint(candidates[0], 64, 100.0f)); // $8/h
+  points.push_back(CapacityPlanPoint(candidates[1], 64, 50.0f));  // $16/h
+  points.push_back(CapacityPlanPoint(candidates[2], 64, 40.0f));  // $32/h
+  points.push_back(CapacityPlanPoint(candidates[3], 64, 30.0f));  // $24/h
+  EXPECT_FLOAT_EQ(points[0].throughput, 640.0f);
+  EXPECT_NEAR(points[0].cost_per_million_samples, 8.0f / 640 / 3600 * 1e6f,
+              1e-3f);
+
+  std::vector<CapacityPlanPoint> front = capacity_pareto_front(points);
+  // 2x8 is both more expensive and slower than 4x4
+  ASSERT_EQ(front.size(), 3u);
+  EXPECT_FLOAT_EQ(front[0].cost_per_hour, 8.0f);
+  EXPECT_FLOAT_EQ(front[1].cost_per_hour, 16.0f);
+  EXPECT_FLOAT_EQ(front[2].cost_per_hour, 24.0f);
+
+  EXPECT_EQ(select_capacity_point(points, 0.0f), 0);
+  EXPECT_EQ(select_capacity_point(points, 1000.0f), 1);
+  EXPECT_EQ(select_capacity_point(points, 1500.0f), 3);
+  EXPECT_EQ(select_capacity_point(points, 3000.0f), -1);
+}
+
+namespace {
+
+// Step time (ms) of a data parallel MLP on a cluster candidate, simulated
+// with the analytic cost model: the forward and backward passes of every
+// layer on a slice of the batch, then a ring all-reduce of its weights
+float data_parallel_step_time(AnalyticCostModel const &model,
+                              ClusterCandidate const &c,
+                              int batch_size,
+                              std::vector<int> const &widths) {
+  float const intra_node_bandwidth = 1.5e8f; // B/ms
+  float const inter_node_bandwidth = 1.25e7f;
+  int n = c.num_gpus();
+  double samples = (double)batch_size / n;
+  float step_time = 0.0f;
+  for (size_t l = 0; l + 1 < widths.size(); l++) {
+    double in = widths[l], out = widths[l + 1];
+    double flops = 2.0 * samples * in * out;
+    double bytes = 4.0 * (samples * in + samples * out + in * out);
+    step_time += model.kernel_time(flops, bytes);
+    step_time += model.kernel_time(2.0 * flops, 2.0 * bytes);
+    if (n > 1) {
+      float bandwidth =
+          c.num_nodes > 1 ? inter_node_bandwidth : intra_node_bandwidth;
+      step_time += 2.0f * (n - 1) / n * 4.0f * in * out / bandwidth;
+    }
+  }
+  return step_time;
+}
+
+} // namespace
+
+TEST(capacity_planning, plan_without_gpu) {
+  AnalyticCostModel model;
+  EXPECT_FLOAT_EQ(model.kernel_time(1e11, 0.0), 1.0f + model.kernel_overhead);
+  EXPECT_FLOAT_EQ(model.kernel_time(0.0, 3e9), 2.0f + model.kernel_overhead);
+
+  std::vector<ClusterCandidate> candidates;
+  ASSERT_TRUE(parse_cluster_candidates("1x1@3,1x2@3,1x4@3,1x8@3,2x8@2.5",
+                                       candidates));
+  int const batch_size = 4096;
+  std::vector<int> const widths = {1024, 4096, 4096, 4096, 1024};
+  CapacityPlan plan = plan_capacity(
+      candidates, batch_size, 800000.0f, [&](ClusterCandidate const &c) {
+        return data_parallel_step_time(model, c, batch_size, widths);
+      });
+
+  ASSERT_EQ(plan.points.size(), candidates.size());
+  for (size_t i = 0; i < candidates.size(); i++) {
+    EXPECT_EQ(plan.points[i].cluster.num_gpus(), candidates[i].num_gpus());
+  }
+  // More GPUs in a node are faster; the second node is behind a slow network
+  EXPECT_LT(plan.points[3].step_time, plan.points[2].step_time);
+  EXPECT_LT(plan.points[2].step_time, plan.points[0].step_time);
+  EXPECT_GT(plan.points[4].step_time, plan.points[3].step_time);
+  ASSERT_EQ(plan.pareto_front.size(), 4u);
+  for (size_t i = 1; i < plan.pareto_front.size(); i++) {
+    EXPECT_GT(plan.pareto_front[i].cost_per_hour,
+              plan.pareto_front[i - 1].cost_per_hour);
+    EXPECT_LT(plan.pareto_front[i].step_time,
+              plan.pareto_front[i - 1].step_time);
+  }
+
+  // The cheapest candidate reaching the target
+  EXPECT_EQ(plan.best, 2);
+  EXPECT_GE(plan.points[2].throughput, 800000.0f);
+  EXPECT_LT(plan.points[1].throughput, 800000.0f);
+}
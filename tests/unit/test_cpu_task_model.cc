@@ -0,0 +1,26 @@
+#include "flexflow/cpu_task_model.h"
+#include "gtest/gtest.h"
+
+using namespace FlexFlow;
+
+TEST(cpu_task_model, single_thread_never_prefers_omp) {
+  CpuTaskModel model;
+  EXPECT_FALSE(model.prefer_omp(1 << 30));
+  EXPECT_EQ(model.min_omp_volume(), 0u);
+  EXPECT_FLOAT_EQ(model.task_time(1000, false), 1000 * model.element_time);
+}
+
+TEST(cpu_task_model, crossover_volume) {
+  CpuTaskModel model;
+  model.element_time = 1e-6f;
+  model.omp_overhead = 0.01f;
+  model.omp_threads = 16;
+  model.omp_efficiency = 0.75f;
+  // A 12x speedup pays for the 10 us overhead from about 11k elements
+  size_t v = model.min_omp_volume();
+  EXPECT_NEAR((float)v, 0.01f / (1e-6f * (1.0f - 1.0f / 12)), 2.0f);
+  EXPECT_TRUE(model.prefer_omp(v));
+  EXPECT_FALSE(model.prefer_omp(v / 2));
+  EXPECT_TRUE(model.prefer_omp(100 * v));
+  EXPECT_NEAR(model.task_time(1200000, true), 0.11f, 1e-4f);
+}
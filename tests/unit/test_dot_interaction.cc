@@ -0,0 +1,112 @@
+#include "flexflow/ops/kernels/dot_interaction_kernels.h"
+#include "gtest/gtest.h"
+#include <random>
+#include <vector>
+
+using namespace FlexFlow;
+using namespace FlexFlow::Kernels::DotInteraction;
+
+namespace {
+
+struct Features {
+  std::vector<std::vector<float>> data;
+  std::vector<float const *> ptrs;
+
+  Features(DotInteractionShape const &shape, std::mt19937 &gen) {
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    data.resize(shape.num_features);
+    for (auto &x : data) {
+      x.resize((size_t)shape.num_samples * shape.feature_size);
+      for (float &v : x) {
+        v = dist(gen);
+      }
+      ptrs.push_back(x.data());
+    }
+  }
+};
+
+} // namespace
+
+TEST(dot_interaction, pair_layout_matches_dlrm) {
+  DotInteractionShape shape{2, 4, 3};
+  EXPECT_EQ(shape.num_pairs(), 6);
+  EXPECT_EQ(shape.output_size(), 9);
+  // DLRM: [(i, j) for i in range(F) for j in range(i)]
+  int k = 0;
+  for (int i = 0; i < 4; i++) {
+    for (int j = 0; j < i; j++) {
+      EXPECT_EQ(shape.pair_index(i, j), k++);
+    }
+  }
+  shape.self_interaction = true;
+  EXPECT_EQ(shape.num_pairs(), 10);
+  EXPECT_EQ(shape.pair_index(3, 3), 9);
+}
+
+TEST(dot_interaction, forward_computes_lower_triangle) {
+  std::mt19937 gen(0);
+  DotInteractionShape shape{3, 5, 4};
+  Features x(shape, gen);
+  std::vector<float> output((size_t)shape.num_samples * shape.output_size());
+  forward_cpu(shape, x.ptrs.data(), output.data());
+  for (int n = 0; n < shape.num_samples; n++) {
+    float const *out = output.data() + n * shape.output_size();
+    for (int e = 0; e < shape.feature_size; e++) {
+      EXPECT_EQ(out[e], x.data[0][n * shape.feature_size + e]);
+    }
+    for (int i = 0; i < shape.num_features; i++) {
+      for (int j = 0; j < i; j++) {
+        float dot = 0.0f;
+        for (int e = 0; e < shape.feature_size; e++) {
+          dot += x.data[i][n * shape.feature_size + e] *
+                 x.data[j][n * shape.feature_size + e];
+        }
+        EXPECT_NEAR(
+            out[shape.feature_size + shape.pair_index(i, j)], dot, 1e-5);
+      }
+    }
+  }
+}
+
+TEST(dot_interaction, backward_matches_finite_differences) {
+  std::mt19937 gen(1);
+  for (bool self_interaction : {false, true}) {
+    DotInteractionShape shape{2, 4, 3};
+    shape.self_interaction = self_interaction;
+    Features x(shape, gen);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::vector<float> coeff((size_t)shape.num_samples * shape.output_size());
+    for (float &c : coeff) {
+      c = dist(gen);
+    }
+    auto loss = [&]() {
+      std::vector<float> output(coeff.size());
+      forward_cpu(shape, x.ptrs.data(), output.data());
+      double l = 0.0;
+      for (size_t i = 0; i < output.size(); i++) {
+        l += (double)output[i] * coeff[i];
+      }
+      return l;
+    };
+    std::vector<std::vector<float>> grads(shape.num_features);
+    std::vector<float *> grad_ptrs;
+    for (auto &g : grads) {
+      // Gradients accumulate into what is already there
+      g.assign((size_t)shape.num_samples * shape.feature_size, 1.0f);
+      grad_ptrs.push_back(g.data());
+    }
+    backward_cpu(shape, x.ptrs.data(), coeff.data(), grad_ptrs.data());
+    float const eps = 1e-2f;
+    for (int f = 0; f < shape.num_features; f++) {
+      for (size_t i = 0; i < x.data[f].size(); i++) {
+        float saved = x.data[f][i];
+        x.data[f][i] = saved + eps;
+        double plus = loss();
+        x.data[f][i] = saved - eps;
+        double minus = loss();
+        x.data[f][i] = saved;
+        EXPECT_NEAR(grads[f][i] - 1.0f, (plus - minus) / (2 * eps), 1e-3);
+      }
+    }
+  }
+}
@@ -0,0 +1,204 @@
+#include "flexflow/ops/kernels/element_expression_kernels.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace FlexFlow;
+using namespace FlexFlow::Kernels::ElementExpression;
+
+namespace {
+
+struct Problem {
+  ExpressionProgram program;
+  ExpressionShape shape;
+  std::vector<std::vector<float>> inputs;
+
+  Problem(ExpressionProgram const &_program,
+          std::vector<std::vector<int>> const &input_dims,
+          unsigned seed)
+      : program(_program) {
+    shape.num_dims = input_dims[0].size();
+    for (int d = 0; d < shape.num_dims; d++) {
+      shape.dims[d] = 1;
+      for (auto const &dims : input_dims) {
+        shape.dims[d] = std::max(shape.dims[d], dims[d]);
+      }
+    }
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+    for (size_t i = 0; i < input_dims.size(); i++) {
+      std::copy(
+          input_dims[i].begin(), input_dims[i].end(), shape.input_dims[i]);
+      inputs.emplace_back(shape.input_volume(i));
+      for (float &v : inputs.back()) {
+        v = value(gen);
+      }
+    }
+  }
+
+  std::vector<float const *> input_ptrs() const {
+    std::vector<float const *> ptrs;
+    for (auto const &t : inputs) {
+      ptrs.push_back(t.data());
+    }
+    return ptrs;
+  }
+
+  std::vector<float> forward() const {
+    std::vector<float> output(shape.volume());
+    forward_cpu(program, shape, input_ptrs().data(), output.data());
+    return output;
+  }
+
+  // One full pass over the output per operation, as the unfused operators
+  std::vector<float> forward_unfused() const {
+    size_t const volume = shape.volume();
+    std::vector<std::vector<float>> operands;
+    for (int i = 0; i < program.num_inputs; i++) {
+      operands.emplace_back(volume);
+      for (size_t k = 0; k < volume; k++) {
+        operands[i][k] = inputs[i][shape.input_offset(i, k)];
+      }
+    }
+    for (int j = 0; j < program.num_nodes; j++) {
+      ExpressionNode const &node = program.nodes[j];
+      std::vector<float> y(volume);
+      for (size_t k = 0; k < volume; k++) {
+        y[k] = node.rhs < 0 ? apply_unary(node.op_type,
+                                          node.scalar,
+                                          operands[node.lhs][k])
+                            : apply_binary(node.op_type,
+                                           operands[node.lhs][k],
+                                           operands[node.rhs][k]);
+      }
+      operands.push_back(y);
+    }
+    return operands.back();
+  }
+};
+
+// gelu(x * 0.5 + bias) * tanh(z) - scale, the bias broadcast over the
+// samples and the scale over everything
+ExpressionProgram gelu_program() {
+  ExpressionProgram program;
+  program.num_inputs = 4;
+  int h = program.add_unary(OP_SCALAR_MULTIPLY, 0, 0.5f);
+  h = program.add_binary(OP_EW_ADD, h, 1);
+  h = program.add_unary(OP_GELU, h);
+  int t = program.add_unary(OP_TANH, program.add_unary(OP_IDENTITY, 2));
+  h = program.add_binary(OP_EW_MUL, h, t);
+  program.add_binary(OP_EW_SUB, h, 3);
+  return program;
+}
+
+// Every other operation, with operands used more than once
+ExpressionProgram mixed_program() {
+  ExpressionProgram program;
+  program.num_inputs = 2;
+  int e = program.add_unary(OP_EXP, 0);
+  int r = program.add_unary(OP_RSQRT, e);
+  int p = program.add_unary(OP_POW, e, 1.5f);
+  int d = program.add_binary(OP_EW_DIV, r, p);
+  int s = program.add_unary(OP_SIN, 1);
+  int c = program.add_unary(OP_COS, 1);
+  int m = program.add_binary(OP_EW_MAX, s, c);
+  int n = program.add_binary(OP_EW_MIN, m, 0);
+  int g = program.add_unary(OP_SIGMOID, n);
+  int a = program.add_unary(OP_SCALAR_ADD, g, 0.25f);
+  int b = program.add_unary(OP_SCALAR_TRUE_DIV, a, 3.0f);
+  int q = program.add_unary(OP_RELU, 0);
+  int x = program.add_binary(OP_EW_MUL, q, q);
+  int y = program.add_unary(OP_SCALAR_SUB, x, 2.0f);
+  int z = program.add_binary(OP_EW_ADD, b, d);
+  program.add_binary(OP_EW_MUL, z, y);
+  return program;
+}
+
+} // namespace
+
+TEST(element_expression, operands_follow_the_inputs) {
+  ExpressionProgram program = gelu_program();
+  EXPECT_EQ(program.num_nodes, 7);
+  EXPECT_EQ(program.output(), 10);
+  EXPECT_EQ(program.nodes[1].lhs, 4);
+  EXPECT_EQ(program.nodes[1].rhs, 1);
+  EXPECT_TRUE(ExpressionProgram::is_unary(OP_GELU));
+  EXPECT_FALSE(ExpressionProgram::is_unary(OP_EW_ADD));
+  EXPECT_TRUE(ExpressionProgram::is_binary(OP_EW_MAX));
+  EXPECT_FALSE(ExpressionProgram::is_binary(OP_CONCAT));
+}
+
+TEST(element_expression, forward_matches_the_unfused_operators) {
+  // The innermost size is not a multiple of the chunk size
+  Problem p(gelu_program(),
+            {{300, 7, 2}, {300, 1, 1}, {300, 7, 2}, {1, 1, 1}},
+            0);
+  std::vector<float> output = p.forward();
+  std::vector<float> expected = p.forward_unfused();
+  ASSERT_EQ(output.size(), expected.size());
+  for (size_t i = 0; i < output.size(); i++) {
+    EXPECT_NEAR(output[i], expected[i], 1e-6);
+  }
+  // The broadcast input is along the innermost dimension
+  Problem q(mixed_program(), {{1, 33, 5}, {17, 33, 5}}, 1);
+  output = q.forward();
+  expected = q.forward_unfused();
+  for (size_t i = 0; i < output.size(); i++) {
+    EXPECT_NEAR(output[i], expected[i], 1e-5);
+  }
+}
+
+TEST(element_expression, backward_matches_finite_differences) {
+  std::vector<Problem> problems;
+  std::vector<std::vector<int>> gelu_dims = {{9, 4}, {9, 1}, {9, 4}, {1, 1}};
+  std::vector<std::vector<int>> mixed_dims = {{1, 6}, {5, 6}};
+  problems.emplace_back(gelu_program(), gelu_dims, 2);
+  problems.emplace_back(mixed_program(), mixed_dims, 3);
+  for (Problem &p : problems) {
+    // The loss is the dot of the output with a fixed random tensor
+    std::mt19937 gen(4);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+    std::vector<float> output_grad(p.shape.volume());
+    for (float &v : output_grad) {
+      v = value(gen);
+    }
+    auto loss = [&]() {
+      std::vector<float> output = p.forward();
+      double sum = 0.0;
+      for (size_t i = 0; i < output.size(); i++) {
+        sum += (double)output[i] * output_grad[i];
+      }
+      return sum;
+    };
+    std::vector<std::vector<float>> grads;
+    std::vector<float *> grad_ptrs;
+    for (auto const &t : p.inputs) {
+      grads.emplace_back(t.size(), 0.0f);
+    }
+    for (auto &g : grads) {
+      grad_ptrs.push_back(g.data());
+    }
+    backward_cpu(p.program,
+                 p.shape,
+                 p.input_ptrs().data(),
+                 output_grad.data(),
+                 grad_ptrs.data());
+    float const eps = 1e-2f;
+    for (size_t t = 0; t < p.inputs.size(); t++) {
+      for (size_t i = 0; i < p.inputs[t].size(); i++) {
+        float v = p.inputs[t][i];
+        p.inputs[t][i] = v + eps;
+        double plus = loss();
+        p.inputs[t][i] = v - eps;
+        double minus = loss();
+        p.inputs[t][i] = v;
+        double expected = (plus - minus) / (2 * eps);
+        // The broadcast inputs sum many gradients
+        EXPECT_NEAR(
+            grads[t][i], expected, 2e-3 * std::max(1.0, std::fabs(expected)));
+      }
+    }
+  }
+}
@@ -0,0 +1,171 @@
+#include "flexflow/ops/kernels/embedding_mode_kernels.h"
+#include "gtest/gtest.h"
+#include <random>
+#include <vector>
+
+using namespace FlexFlow;
+using namespace FlexFlow::Kernels::Embedding;
+
+namespace {
+
+struct Problem {
+  EmbeddingTables tables;
+  AggrMode aggr;
+  int in_dim, batch_size;
+  std::vector<int64_t> input;
+  std::vector<std::vector<float>> weights;
+
+  Problem(EmbeddingTables const &_tables,
+          AggrMode _aggr,
+          int _in_dim,
+          int _batch_size,
+          unsigned seed)
+      : tables(_tables), aggr(_aggr), in_dim(_in_dim),
+        batch_size(_batch_size) {
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int64_t> index(0, tables.num_entries - 1);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+    input.resize((size_t)batch_size * in_dim);
+    for (int64_t &i : input) {
+      i = index(gen);
+    }
+    weights.resize(tables.num_tables());
+    for (int t = 0; t < tables.num_tables(); t++) {
+      weights[t].resize((size_t)tables.rows(t) * tables.cols(t));
+      for (float &v : weights[t]) {
+        v = value(gen);
+      }
+    }
+  }
+
+  std::vector<float const *> weight_ptrs() const {
+    std::vector<float const *> ptrs;
+    for (auto const &w : weights) {
+      ptrs.push_back(w.data());
+    }
+    return ptrs;
+  }
+
+  std::vector<float> forward() const {
+    std::vector<float> output((size_t)batch_size * tables.out_dim);
+    forward_cpu(tables,
+                aggr,
+                input.data(),
+                weight_ptrs().data(),
+                output.data(),
+                in_dim,
+                batch_size);
+    return output;
+  }
+
+  // The dense table holding every embedding row
+  std::vector<float> materialize() const {
+    int const d = tables.out_dim;
+    std::vector<float> dense((size_t)tables.num_entries * d, 0.0f);
+    for (int i = 0; i < tables.num_entries; i++) {
+      for (int e = 0; e < d; e++) {
+        float &v = dense[(size_t)i * d + e];
+        if (tables.mode == EMBEDDING_MODE_QR) {
+          v = weights[0][(i / tables.num_buckets) * d + e] *
+              weights[1][(i % tables.num_buckets) * d + e];
+        } else {
+          for (int c = 0; c < tables.embed_dim; c++) {
+            v += weights[0][(size_t)i * tables.embed_dim + c] *
+                 weights[1][(size_t)c * d + e];
+          }
+        }
+      }
+    }
+    return dense;
+  }
+};
+
+} // namespace
+
+TEST(embedding_modes, tables_are_smaller_than_dense) {
+  EmbeddingTables dense{EMBEDDING_MODE_DENSE, 1000000, 64, 0, 0};
+  EmbeddingTables qr{EMBEDDING_MODE_QR, 1000000, 64, 1000, 0};
+  EmbeddingTables mixed{EMBEDDING_MODE_MIXED_DIM, 1000000, 64, 0, 8};
+  EXPECT_EQ(dense.num_parameters(), 64000000u);
+  EXPECT_EQ(qr.quotient_rows(), 1000);
+  EXPECT_EQ(qr.num_parameters(), 2000u * 64);
+  EXPECT_EQ(mixed.num_parameters(), 8000000u + 8 * 64);
+  // The quotient table has a partial last row when num_buckets does not
+  // divide num_entries
+  EmbeddingTables uneven{EMBEDDING_MODE_QR, 10, 4, 3, 0};
+  EXPECT_EQ(uneven.rows(0), 4);
+  EXPECT_EQ(uneven.rows(1), 3);
+}
+
+TEST(embedding_modes, forward_matches_the_materialized_table) {
+  for (EmbeddingMode mode : {EMBEDDING_MODE_QR, EMBEDDING_MODE_MIXED_DIM}) {
+    for (AggrMode aggr : {AGGR_MODE_NONE, AGGR_MODE_SUM, AGGR_MODE_AVG}) {
+      int in_dim = aggr == AGGR_MODE_NONE ? 1 : 5;
+      Problem p({mode, 103, 16, 10, 4}, aggr, in_dim, 32, 0);
+      std::vector<float> output = p.forward();
+      std::vector<float> dense = p.materialize();
+      EmbeddingTables dense_tables{EMBEDDING_MODE_DENSE, 103, 16, 0, 0};
+      std::vector<float> expected(output.size());
+      float const *dense_ptr = dense.data();
+      forward_cpu(dense_tables,
+                  aggr,
+                  p.input.data(),
+                  &dense_ptr,
+                  expected.data(),
+                  in_dim,
+                  p.batch_size);
+      for (size_t i = 0; i < output.size(); i++) {
+        EXPECT_NEAR(output[i], expected[i], 1e-5);
+      }
+    }
+  }
+}
+
+TEST(embedding_modes, backward_matches_finite_differences) {
+  for (EmbeddingMode mode : {EMBEDDING_MODE_QR, EMBEDDING_MODE_MIXED_DIM}) {
+    Problem p({mode, 50, 6, 7, 3}, AGGR_MODE_AVG, 3, 8, 1);
+    // The loss is the dot of the output with a fixed random tensor
+    std::mt19937 gen(2);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+    std::vector<float> output_grad((size_t)p.batch_size * p.tables.out_dim);
+    for (float &v : output_grad) {
+      v = value(gen);
+    }
+    auto loss = [&]() {
+      std::vector<float> output = p.forward();
+      double sum = 0.0;
+      for (size_t i = 0; i < output.size(); i++) {
+        sum += (double)output[i] * output_grad[i];
+      }
+      return sum;
+    };
+    std::vector<std::vector<float>> grads;
+    std::vector<float *> grad_ptrs;
+    for (auto const &w : p.weights) {
+      grads.emplace_back(w.size(), 0.0f);
+    }
+    for (auto &g : grads) {
+      grad_ptrs.push_back(g.data());
+    }
+    backward_cpu(p.tables,
+                 p.aggr,
+                 p.input.data(),
+                 p.weight_ptrs().data(),
+                 output_grad.data(),
+                 grad_ptrs.data(),
+                 p.in_dim,
+                 p.batch_size);
+    float const eps = 1e-2f;
+    for (size_t t = 0; t < p.weights.size(); t++) {
+      for (size_t i = 0; i < p.weights[t].size(); i++) {
+        float w = p.weights[t][i];
+        p.weights[t][i] = w + eps;
+        double plus = loss();
+        p.weights[t][i] = w - eps;
+        double minus = loss();
+        p.weights[t][i] = w;
+        EXPECT_NEAR(grads[t][i], (plus - minus) / (2 * eps), 1e-3);
+      }
+    }
+  }
+}
@@ -0,0 +1,223 @@
+#include "flexflow/gradient_overwrite.h"
+#include "gtest/gtest.h"
+#include <limits>
+#include <map>
+
+using namespace FlexFlow;
+
+namespace {
+
+int const VOLUME = 8;
+
+// An operator of a toy network: tensors and weights are identified by
+// their gradients, and the backward pass of the operator adds a multiple of
+// the sum of its output gradients to each gradient it writes
+struct ToyOp {
+  std::vector<int> inputs, outputs, weights;
+  bool can_overwrite; // like Linear and Conv2D, unlike Add or Concat
+};
+
+struct ToyNetwork {
+  std::vector<ToyOp> ops;
+  int loss_grad;
+
+  int add(std::vector<int> const &inputs,
+          std::vector<int> const &outputs,
+          int num_weights,
+          bool can_overwrite) {
+    ToyOp op;
+    op.inputs = inputs;
+    op.outputs = outputs;
+    for (int i = 0; i < num_weights; i++) {
+      op.weights.push_back(1000 + 10 * (int)ops.size() + i);
+    }
+    op.can_overwrite = can_overwrite;
+    ops.push_back(op);
+    return outputs.empty() ? -1 : outputs[0];
+  }
+  // A Linear or Conv2D with a bias
+  int dense(int input, int output) {
+    return add({input}, {output}, 2, true);
+  }
+  int elementwise(std::vector<int> const &inputs, int output) {
+    return add(inputs, {output}, 0, false);
+  }
+
+  std::vector<GradientAccess> accesses() const {
+    std::vector<GradientAccess> result;
+    for (ToyOp const &op : ops) {
+      GradientAccess access;
+      access.reads = op.outputs;
+      access.writes = op.inputs;
+      access.writes.insert(
+          access.writes.end(), op.weights.begin(), op.weights.end());
+      access.can_overwrite.resize(access.writes.size(), op.can_overwrite);
+      result.push_back(access);
+    }
+    return result;
+  }
+
+  // Run the backward pass. Without a plan, every gradient is zeroed first
+  // and every write accumulates; with one, the gradients it does not zero
+  // start out as NaN.
+  std::map<int, std::vector<float>>
+      backward(GradientOverwritePlan const *plan) const {
+    std::map<int, std::vector<float>> grads;
+    std::vector<GradientAccess> all = accesses();
+    for (GradientAccess const &access : all) {
+      for (int g : access.reads) {
+        grads[g];
+      }
+      for (int g : access.writes) {
+        grads[g];
+      }
+    }
+    for (auto &g : grads) {
+      bool zeroed = plan == nullptr ||
+                    plan->overwritten.find(g.first) == plan->overwritten.end();
+      g.second.assign(VOLUME,
+                      zeroed ? 0.0f : std::numeric_limits<float>::quiet_NaN());
+    }
+    for (int i = 0; i < VOLUME; i++) {
+      grads[loss_grad][i] = 0.5f * i - 1.0f;
+    }
+    for (int l = (int)ops.size() - 1; l >= 0; l--) {
+      GradientAccess const &access = all[l];
+      std::vector<float> sum(VOLUME, 0.0f);
+      for (int g : access.reads) {
+        for (int i = 0; i < VOLUME; i++) {
+          sum[i] += grads[g][i];
+        }
+      }
+      for (size_t k = 0; k < access.writes.size(); k++) {
+        std::vector<float> &grad = grads[access.writes[k]];
+        bool overwrite = plan != nullptr && plan->overwrite[l][k];
+        for (int i = 0; i < VOLUME; i++) {
+          float value = sum[i] * (0.25f * (l + 1) + 0.125f * k) + l;
+          grad[i] = overwrite ? value : grad[i] + value;
+        }
+      }
+    }
+    return grads;
+  }
+
+  GradientOverwritePlan check_same_gradients() const {
+    GradientOverwritePlan plan =
+        plan_gradient_overwrites(accesses(), {loss_grad});
+    std::map<int, std::vector<float>> expected = backward(nullptr);
+    std::map<int, std::vector<float>> actual = backward(&plan);
+    EXPECT_EQ(expected.size(), actual.size());
+    for (auto const &g : expected) {
+      for (int i = 0; i < VOLUME; i++) {
+        EXPECT_EQ(g.second[i], actual[g.first][i])
+            << "gradient " << g.first << " element " << i;
+      }
+    }
+    return plan;
+  }
+};
+
+bool overwritten(GradientOverwritePlan const &plan, int grad) {
+  return plan.overwritten.find(grad) != plan.overwritten.end();
+}
+
+} // namespace
+
+TEST(gradient_overwrite, resnet) {
+  ToyNetwork net;
+  int x = net.dense(0, 1);
+  int h = net.elementwise({x}, 2);
+  for (int block = 0; block < 3; block++) {
+    int base = 10 * (block + 1);
+    int a = net.dense(h, base);
+    a = net.elementwise({a}, base + 1);
+    a = net.dense(a, base + 2);
+    // The first block has a projection shortcut
+    int shortcut = block == 0 ? net.dense(h, base + 3) : h;
+    int sum = net.elementwise({a, shortcut}, base + 4);
+    h = net.elementwise({sum}, base + 5);
+  }
+  net.loss_grad = net.dense(h, 99);
+  GradientOverwritePlan plan = net.check_same_gradients();
+
+  EXPECT_TRUE(overwritten(plan, 99));
+  // The output of the stem is read by the projection shortcut, then by the
+  // first convolution of the block
+  EXPECT_TRUE(overwritten(plan, 2));
+  // The output of the first block is written by the addition of the second
+  // block first
+  EXPECT_FALSE(overwritten(plan, 15));
+  EXPECT_TRUE(overwritten(plan, 11));
+  EXPECT_TRUE(overwritten(plan, 35));
+  // The sums are written by element-wise operators
+  EXPECT_FALSE(overwritten(plan, 14));
+  // All weights
+  for (ToyOp const &op : net.ops) {
+    for (int w : op.weights) {
+      EXPECT_TRUE(overwritten(plan, w));
+    }
+  }
+}
+
+TEST(gradient_overwrite, inception) {
+  ToyNetwork net;
+  int x = net.dense(0, 1);
+  int a = net.dense(x, 2);
+  int b = net.dense(net.dense(x, 3), 4);
+  int c = net.dense(net.elementwise({x}, 5), 6);
+  int d = net.dense(x, 7);
+  int concat = net.elementwise({a, b, c, d}, 8);
+  net.loss_grad = net.dense(concat, 9);
+  GradientOverwritePlan plan = net.check_same_gradients();
+
+  // Only the last branch overwrites the gradient of the shared input
+  EXPECT_TRUE(overwritten(plan, x));
+  EXPECT_TRUE(plan.overwrite[6][0]);
+  EXPECT_FALSE(plan.overwrite[4][0]);
+  EXPECT_FALSE(plan.overwrite[2][0]);
+  EXPECT_FALSE(plan.overwrite[1][0]);
+  // The branches are written by the concatenation
+  EXPECT_FALSE(overwritten(plan, a));
+  EXPECT_FALSE(overwritten(plan, b));
+  EXPECT_TRUE(overwritten(plan, 3));
+}
+
+TEST(gradient_overwrite, mixture_of_experts) {
+  ToyNetwork net;
+  int x = net.dense(0, 1);
+  int gate = net.dense(x, 2);
+  int probs = net.elementwise({gate}, 3);
+  // Top-k: the gradient of the indices is read but never written
+  net.add({probs}, {4, 5}, 0, false);
+  std::vector<int> experts = {4};
+  for (int e = 0; e < 4; e++) {
+    experts.push_back(net.dense(x, 10 + e));
+  }
+  int out = net.elementwise(experts, 20);
+  net.loss_grad = net.dense(out, 21);
+  GradientOverwritePlan plan = net.check_same_gradients();
+
+  EXPECT_FALSE(overwritten(plan, 5));
+  EXPECT_FALSE(overwritten(plan, 4));
+  // The last expert overwrites the gradient of the shared input, and the
+  // gate is written by the softmax
+  EXPECT_TRUE(overwritten(plan, x));
+  EXPECT_TRUE(plan.overwrite[7][0]);
+  EXPECT_FALSE(overwritten(plan, gate));
+}
+
+TEST(gradient_overwrite, repeated_and_in_place_writes) {
+  ToyNetwork net;
+  int x = net.dense(0, 1);
+  // x * x writes the gradient of x twice
+  int square = net.add({x, x}, {2}, 0, true);
+  // An in-place operator reads and writes the same gradient
+  int y = net.add({square}, {square}, 0, true);
+  net.loss_grad = net.dense(y, 3);
+  GradientOverwritePlan plan = net.check_same_gradients();
+
+  EXPECT_FALSE(overwritten(plan, x));
+  EXPECT_FALSE(plan.overwrite[1][0]);
+  EXPECT_FALSE(plan.overwrite[1][1]);
+  EXPECT_FALSE(plan.overwrite[2][0]);
+}
@@ -0,0 +1,149 @@
+#include "flexflow/graph_ir.h"
+#include "gtest/gtest.h"
+#include <chrono>
+
+using namespace FlexFlow::GraphIR;
+
+namespace {
+
+Param int_param(int64_t i) {
+  Param p;
+  p.kind = Param::INT64;
+  p.i = i;
+  return p;
+}
+
+Param float_param(double f) {
+  Param p;
+  p.kind = Param::FLOAT;
+  p.f = f;
+  return p;
+}
+
+Param string_param(std::string const &s) {
+  Param p;
+  p.kind = Param::STRING;
+  p.s = s;
+  return p;
+}
+
+// input -> (linear -> relu -> dropout)* -> output
+Graph make_mlp(int num_layers) {
+  Graph graph;
+  graph.nodes.push_back({INPUT, "input", {}, {1}, {}});
+  for (int i = 0; i < num_layers; i++) {
+    int prev = graph.nodes.size() - 1;
+    int cur = graph.nodes.size();
+    graph.nodes.push_back({LINEAR,
+                           "fc" + std::to_string(i),
+                           {prev},
+                           {cur + 1},
+                           {int_param(1024), int_param(10), int_param(1)}});
+    graph.nodes.push_back(
+        {RELU, "relu" + std::to_string(i), {cur}, {cur + 2}, {}});
+    graph.nodes.push_back({DROPOUT,
+                           "dropout" + std::to_string(i),
+                           {cur + 1},
+                           {cur + 3},
+                           {float_param(0.1)}});
+  }
+  int prev = graph.nodes.size() - 1;
+  graph.nodes.push_back({OUTPUT, "output", {prev}, {}, {}});
+  return graph;
+}
+
+} // namespace
+
+TEST(graph_ir, round_trip) {
+  Graph graph = make_mlp(2);
+  graph.nodes[1].params.push_back(int_param(int64_t(1) << 40));
+  graph.nodes[1].params.push_back(int_param(-7));
+  graph.nodes[2].params.push_back(string_param("True"));
+  std::vector<char> buffer = graph.serialize();
+
+  Graph decoded;
+  ASSERT_TRUE(Graph::deserialize(buffer.data(), buffer.size(), decoded));
+  ASSERT_EQ(decoded.nodes.size(), graph.nodes.size());
+  for (size_t i = 0; i < graph.nodes.size(); i++) {
+    Node const &a = graph.nodes[i], &b = decoded.nodes[i];
+    EXPECT_EQ(a.op_type, b.op_type);
+    EXPECT_EQ(a.name, b.name);
+    EXPECT_EQ(a.inputs, b.inputs);
+    EXPECT_EQ(a.outputs, b.outputs);
+    ASSERT_EQ(a.params.size(), b.params.size());
+    for (size_t j = 0; j < a.params.size(); j++) {
+      if (a.params[j].kind == Param::STRING) {
+        EXPECT_EQ(a.params[j].s, b.params[j].s);
+      } else {
+        EXPECT_EQ(a.params[j].as_float(), b.params[j].as_float());
+      }
+    }
+  }
+  EXPECT_EQ(decoded.nodes[1].params[3].as_int(), int64_t(1) << 40);
+  EXPECT_EQ(decoded.nodes[1].params[4].as_int(), -7);
+  EXPECT_TRUE(decoded.nodes[2].params[0].as_bool());
+  EXPECT_DOUBLE_EQ(decoded.nodes[3].params[0].as_float(), 0.1);
+  // Encoding is deterministic
+  EXPECT_EQ(decoded.serialize(), buffer);
+}
+
+TEST(graph_ir, rejects_malformed_buffers) {
+  std::vector<char> buffer = make_mlp(1).serialize();
+  Graph graph;
+  // Truncated
+  for (size_t size = 0; size < buffer.size(); size++) {
+    EXPECT_FALSE(Graph::deserialize(buffer.data(), size, graph));
+  }
+  // Trailing bytes
+  std::vector<char> longer = buffer;
+  longer.push_back(0);
+  EXPECT_FALSE(Graph::deserialize(longer.data(), longer.size(), graph));
+  // Bad magic and version
+  std::vector<char> bad = buffer;
+  bad[0] = 'X';
+  EXPECT_FALSE(Graph::deserialize(bad.data(), bad.size(), graph));
+  bad = buffer;
+  bad[4] = VERSION + 1;
+  EXPECT_FALSE(Graph::deserialize(bad.data(), bad.size(), graph));
+  // Out-of-range node index
+  Graph dangling = make_mlp(1);
+  dangling.nodes[1].inputs[0] = dangling.nodes.size();
+  bad = dangling.serialize();
+  EXPECT_FALSE(Graph::deserialize(bad.data(), bad.size(), graph));
+  // Too few attributes or inputs for the op type
+  Graph short_params = make_mlp(1);
+  short_params.nodes[1].params.pop_back();
+  bad = short_params.serialize();
+  EXPECT_FALSE(Graph::deserialize(bad.data(), bad.size(), graph));
+  Graph short_inputs = make_mlp(1);
+  short_inputs.nodes[2].inputs.clear();
+  bad = short_inputs.serialize();
+  EXPECT_FALSE(Graph::deserialize(bad.data(), bad.size(), graph));
+  Graph binary_op = make_mlp(1);
+  binary_op.nodes[2].op_type = ADD;
+  bad = binary_op.serialize();
+  EXPECT_FALSE(Graph::deserialize(bad.data(), bad.size(), graph));
+  binary_op.nodes[2].inputs.push_back(0);
+  bad = binary_op.serialize();
+  EXPECT_TRUE(Graph::deserialize(bad.data(), bad.size(), graph));
+  EXPECT_TRUE(Graph::deserialize(buffer.data(), buffer.size(), graph));
+}
+
+TEST(graph_ir, large_graph_decode) {
+  // Decoding needs neither the runtime nor a GPU
+  for (int num_layers : {333, 3333}) {
+    Graph graph = make_mlp(num_layers);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<char> buffer = graph.serialize();
+    Graph decoded;
+    ASSERT_TRUE(Graph::deserialize(buffer.data(), buffer.size(), decoded));
+    double ms = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+    EXPECT_EQ(decoded.nodes.size(), graph.nodes.size());
+    printf("[graph_ir] %zu nodes, %zu bytes, encode+decode %.2f ms\n",
+           graph.nodes.size(),
+           buffer.size(),
+           ms);
+  }
+}
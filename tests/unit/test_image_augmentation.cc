@@ -0,0 +1,144 @@
+#include "flexflow/image_augmentation.h"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <cstring>
+#include <numeric>
+
+using namespace FlexFlow;
+
+namespace {
+
+ImageAugmentation deterministic(int height, int width) {
+  ImageAugmentation aug;
+  aug.height = height;
+  aug.width = width;
+  aug.random_crop = false;
+  aug.random_flip = false;
+  aug.mean = {0.0f, 0.0f, 0.0f};
+  aug.stddev = {1.0f, 1.0f, 1.0f};
+  return aug;
+}
+
+} // namespace
+
+TEST(image_augmentation, decode_pnm) {
+  char const ppm[] = "P6\n# comment\n2 1\n255\n\x01\x02\x03\x04\x05\x06";
+  Image image;
+  ASSERT_TRUE(decode_pnm((uint8_t const *)ppm, sizeof(ppm) - 1, image));
+  EXPECT_EQ(image.width, 2);
+  EXPECT_EQ(image.height, 1);
+  EXPECT_EQ(image.channels, 3);
+  EXPECT_EQ(image.pixels, std::vector<uint8_t>({1, 2, 3, 4, 5, 6}));
+
+  char const pgm[] = "P5 1 2 15 \x0f\x05";
+  ASSERT_TRUE(decode_pnm((uint8_t const *)pgm, sizeof(pgm) - 1, image));
+  EXPECT_EQ(image.channels, 1);
+  EXPECT_EQ(image.pixels, std::vector<uint8_t>({255, 85}));
+
+  // Truncated data and unsupported formats
+  EXPECT_FALSE(decode_pnm((uint8_t const *)ppm, sizeof(ppm) - 2, image));
+  char const ascii[] = "P3\n1 1\n255\n1 2 3\n";
+  EXPECT_FALSE(decode_pnm((uint8_t const *)ascii, sizeof(ascii) - 1, image));
+}
+
+TEST(image_augmentation, resize_flip_and_normalize) {
+  Image image;
+  image.height = 2;
+  image.width = 2;
+  image.channels = 3;
+  image.pixels = {0, 0, 0, 255, 255, 255, 0, 0, 0, 255, 255, 255};
+  // Identity resize: planar output, values in [0, 1]
+  std::vector<float> out(3 * 2 * 2);
+  augment_image(image, deterministic(2, 2), 0, out.data());
+  for (int c = 0; c < 3; c++) {
+    EXPECT_FLOAT_EQ(out[c * 4 + 0], 0.0f);
+    EXPECT_FLOAT_EQ(out[c * 4 + 1], 1.0f);
+    EXPECT_FLOAT_EQ(out[c * 4 + 2], 0.0f);
+    EXPECT_FLOAT_EQ(out[c * 4 + 3], 1.0f);
+  }
+  // Upsampling interpolates between the columns
+  std::vector<float> wide(3 * 1 * 4);
+  augment_image(image, deterministic(1, 4), 0, wide.data());
+  EXPECT_FLOAT_EQ(wide[0], 0.0f);
+  EXPECT_FLOAT_EQ(wide[1], 0.25f);
+  EXPECT_FLOAT_EQ(wide[2], 0.75f);
+  EXPECT_FLOAT_EQ(wide[3], 1.0f);
+
+  // A flip with probability 1/2 and normalization
+  ImageAugmentation aug = deterministic(2, 2);
+  aug.random_flip = true;
+  aug.mean = {0.5f, 0.5f, 0.5f};
+  aug.stddev = {0.5f, 0.5f, 0.5f};
+  int flipped = 0;
+  for (uint64_t seed = 0; seed < 100; seed++) {
+    augment_image(image, aug, seed, out.data());
+    EXPECT_FLOAT_EQ(out[0], -out[1]);
+    EXPECT_FLOAT_EQ(std::abs(out[0]), 1.0f);
+    flipped += out[0] > 0.0f;
+  }
+  EXPECT_GT(flipped, 25);
+  EXPECT_LT(flipped, 75);
+}
+
+TEST(image_augmentation, random_crop_stays_in_range) {
+  SyntheticImageSource source(1, 37, 53, 3, 10);
+  Image image;
+  int label;
+  source.read(0, image, label);
+  ImageAugmentation aug;
+  aug.height = aug.width = 16;
+  aug.mean = {0.0f, 0.0f, 0.0f};
+  aug.stddev = {1.0f, 1.0f, 1.0f};
+  std::vector<float> a(3 * 16 * 16), b(a.size());
+  for (uint64_t seed = 0; seed < 50; seed++) {
+    augment_image(image, aug, seed, a.data());
+    for (float v : a) {
+      ASSERT_GE(v, 0.0f);
+      ASSERT_LE(v, 1.0f);
+    }
+    augment_image(image, aug, seed, b.data());
+    ASSERT_EQ(a, b);
+  }
+}
+
+TEST(image_augmentation, pipeline_independent_of_workers) {
+  size_t const num_samples = 64;
+  ImageAugmentation aug;
+  aug.height = aug.width = 56;
+  std::vector<size_t> indices(num_samples);
+  std::iota(indices.rbegin(), indices.rend(), 0);
+  size_t const sample_size = 3 * 56 * 56;
+
+  std::vector<float> images[2];
+  std::vector<int32_t> labels[2];
+  double rates[2];
+  int const workers[2] = {1, 4};
+  for (int k = 0; k < 2; k++) {
+    ImageBatchPipeline pipeline(
+        std::unique_ptr<ImageSource>(
+            new SyntheticImageSource(num_samples, 64, 64, 3, 10)),
+        aug,
+        workers[k]);
+    EXPECT_EQ(pipeline.get_num_workers(), workers[k]);
+    images[k].resize(num_samples * sample_size);
+    labels[k].resize(num_samples);
+    auto start = std::chrono::steady_clock::now();
+    for (int batch = 0; batch < 4; batch++) {
+      pipeline.load_batch(indices, 1234, images[k].data(), labels[k].data());
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    rates[k] = 4 * num_samples / elapsed.count();
+  }
+  EXPECT_EQ(images[0], images[1]);
+  EXPECT_EQ(labels[0], labels[1]);
+  // Samples land at their position in the batch
+  SyntheticImageSource source(num_samples, 64, 64, 3, 10);
+  Image image;
+  int label;
+  source.read(indices[3], image, label);
+  EXPECT_EQ(labels[0][3], label);
+  printf("[image_augmentation] %.0f images/s with 1 worker, %.0f with 4\n",
+         rates[0],
+         rates[1]);
+}
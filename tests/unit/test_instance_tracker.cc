@@ -0,0 +1,150 @@
+#include "flexflow/instance_tracker.h"
+#include "gtest/gtest.h"
+#include <set>
+
+using namespace FlexFlow;
+
+namespace {
+
+// Mimics the mapper driving a runtime that collects the collectable
+// instances of a memory when an allocation does not fit
+struct FakeMemory {
+  FakeMemory(size_t _capacity, double gc_threshold)
+      : capacity(_capacity), tracker(gc_threshold) {
+    tracker.set_capacity(0, capacity);
+  }
+
+  void collect(void) {
+    for (int inst : tracker.get_victims(0)) {
+      tracker.remove_instance(inst);
+      live.erase(inst);
+    }
+  }
+
+  bool make_instance(int inst, size_t size) {
+    tracker.select_victims(0, size, false);
+    if (tracker.get_stats(0).allocated + size > capacity) {
+      collect();
+    }
+    if (tracker.get_stats(0).allocated + size > capacity) {
+      tracker.select_victims(0, size, true);
+      collect();
+    }
+    if (tracker.get_stats(0).allocated + size > capacity) {
+      return false;
+    }
+    tracker.add_instance(0, inst, size);
+    tracker.use_instance(inst);
+    live.insert(inst);
+    return true;
+  }
+
+  size_t capacity;
+  std::set<int> live;
+  InstanceTracker<int, int> tracker;
+};
+
+} // namespace
+
+TEST(instance_tracker, usage_stats) {
+  InstanceTracker<int, int> tracker;
+  tracker.set_capacity(0, 1000);
+  tracker.add_instance(0, 1, 300);
+  tracker.add_instance(0, 2, 200);
+  EXPECT_TRUE(tracker.use_instance(1));
+  EXPECT_TRUE(tracker.use_instance(1));
+  EXPECT_FALSE(tracker.use_instance(3));
+  tracker.remove_instance(2);
+
+  MemoryUsageStats const &s = tracker.get_stats(0);
+  EXPECT_EQ(s.capacity, 1000);
+  EXPECT_EQ(s.allocated, 300);
+  EXPECT_EQ(s.peak, 500);
+  EXPECT_EQ(s.num_live, 1);
+  EXPECT_EQ(s.num_created, 2);
+  EXPECT_EQ(s.num_reused, 1);
+  EXPECT_EQ(s.num_collected, 1);
+}
+
+TEST(instance_tracker, under_pressure) {
+  InstanceTracker<int, int> tracker(0.5);
+  tracker.add_instance(0, 1, 400);
+  // Memories of unknown capacity are never under pressure
+  EXPECT_FALSE(tracker.under_pressure(0, 1 << 30));
+  tracker.set_capacity(0, 1000);
+  EXPECT_FALSE(tracker.under_pressure(0));
+  EXPECT_FALSE(tracker.under_pressure(0, 100));
+  EXPECT_TRUE(tracker.under_pressure(0, 101));
+}
+
+TEST(instance_tracker, select_victims_lru) {
+  InstanceTracker<int, int> tracker(0.5);
+  tracker.set_capacity(0, 1000);
+  tracker.set_capacity(1, 1000);
+  for (int i = 0; i < 4; i++) {
+    tracker.add_instance(0, i, 200);
+  }
+  tracker.add_instance(1, 10, 900);
+  tracker.use_instance(2);
+  tracker.use_instance(0);
+  tracker.use_instance(3);
+  tracker.use_instance(1);
+  tracker.use_instance(10);
+  tracker.begin_mapping();
+
+  // Reclaim 300 bytes to stay below 500 after allocating 0 more
+  std::vector<int> victims = tracker.select_victims(0, 0, false);
+  ASSERT_EQ(victims.size(), 2);
+  EXPECT_EQ(victims[0], 2);
+  EXPECT_EQ(victims[1], 0);
+  EXPECT_TRUE(tracker.is_victim(2));
+  EXPECT_FALSE(tracker.is_victim(10));
+  // Victims already selected count as reclaimable
+  EXPECT_TRUE(tracker.select_victims(0, 0, false).empty());
+
+  // Using a victim again saves it
+  tracker.begin_mapping();
+  tracker.use_instance(2);
+  EXPECT_FALSE(tracker.is_victim(2));
+  EXPECT_EQ(tracker.get_victims(0), std::vector<int>({0}));
+
+  // Instances used by the current mapping are never selected
+  victims = tracker.select_victims(0, 0, true);
+  EXPECT_EQ(victims, std::vector<int>({3, 1}));
+  EXPECT_FALSE(tracker.is_victim(2));
+
+  // Evicted instances are victims regardless of their last use
+  EXPECT_TRUE(tracker.evict_instance(2));
+  EXPECT_TRUE(tracker.is_victim(2));
+  EXPECT_FALSE(tracker.evict_instance(42));
+}
+
+TEST(instance_tracker, repeated_recompile_bounded) {
+  size_t const capacity = 10000, instance_size = 300;
+  int const instances_per_model = 8, iterations = 5;
+  FakeMemory memory(capacity, 0.8);
+
+  for (int model = 0; model < 50; model++) {
+    // Every recompile maps new regions; instances of the previous models
+    // are never used again
+    for (int iter = 0; iter < iterations; iter++) {
+      memory.tracker.begin_mapping();
+      for (int i = 0; i < instances_per_model; i++) {
+        int inst = model * instances_per_model + i;
+        if (memory.live.count(inst) > 0) {
+          memory.tracker.use_instance(inst);
+        } else {
+          ASSERT_TRUE(memory.make_instance(inst, instance_size));
+        }
+      }
+    }
+  }
+
+  MemoryUsageStats const &s = memory.tracker.get_stats(0);
+  EXPECT_EQ(s.num_created, 50 * instances_per_model);
+  EXPECT_EQ(s.num_reused, 50 * instances_per_model * (iterations - 1));
+  EXPECT_EQ(s.num_created, s.num_live + s.num_collected);
+  EXPECT_LE(s.peak, capacity);
+  EXPECT_LE(s.allocated, capacity);
+  EXPECT_GT(s.num_collected, 0);
+}
@@ -0,0 +1,153 @@
+#include "flexflow/layerwise_optimizer.h"
+#include "gtest/gtest.h"
+#include <random>
+#include <vector>
+
+using namespace FlexFlow;
+
+namespace {
+
+std::vector<float> random_vector(size_t size, float scale, unsigned seed) {
+  std::mt19937 gen(seed);
+  std::normal_distribution<float> dist(0.0f, scale);
+  std::vector<float> x(size);
+  for (float &v : x) {
+    v = dist(gen);
+  }
+  return x;
+}
+
+double norm(std::vector<double> const &x) {
+  double sum = 0.0;
+  for (double v : x) {
+    sum += v * v;
+  }
+  return std::sqrt(sum);
+}
+
+// LAMB as written in the paper (You et al., 2020), in double precision
+struct ReferenceLAMB {
+  double lr, beta1, beta2, weight_decay, epsilon;
+  std::vector<double> w, m, v;
+  int t = 0;
+
+  void step(std::vector<float> const &g) {
+    t++;
+    std::vector<double> r(w.size());
+    for (size_t i = 0; i < w.size(); i++) {
+      m[i] = beta1 * m[i] + (1 - beta1) * g[i];
+      v[i] = beta2 * v[i] + (1 - beta2) * g[i] * g[i];
+      double m_hat = m[i] / (1 - std::pow(beta1, t));
+      double v_hat = v[i] / (1 - std::pow(beta2, t));
+      r[i] = m_hat / (std::sqrt(v_hat) + epsilon) + weight_decay * w[i];
+    }
+    double w_norm = norm(w), r_norm = norm(r);
+    double ratio = (w_norm > 0 && r_norm > 0) ? w_norm / r_norm : 1.0;
+    for (size_t i = 0; i < w.size(); i++) {
+      w[i] -= lr * ratio * r[i];
+    }
+  }
+};
+
+// LARS as written in the paper (You et al., 2017), in double precision
+struct ReferenceLARS {
+  double lr, momentum, weight_decay, trust_coefficient, epsilon;
+  std::vector<double> w, v;
+
+  void step(std::vector<float> const &g) {
+    std::vector<double> gd(g.begin(), g.end());
+    double w_norm = norm(w), g_norm = norm(gd);
+    double local_lr = 1.0;
+    if (w_norm > 0 && g_norm > 0) {
+      local_lr = trust_coefficient * w_norm /
+                 (g_norm + weight_decay * w_norm + epsilon);
+    }
+    for (size_t i = 0; i < w.size(); i++) {
+      v[i] = momentum * v[i] + lr * local_lr * (gd[i] + weight_decay * w[i]);
+      w[i] -= v[i];
+    }
+  }
+};
+
+} // namespace
+
+TEST(layerwise_optimizer, trust_ratio_falls_back_to_one) {
+  EXPECT_EQ(trust_ratio(0.0f, 2.0f), 1.0f);
+  EXPECT_EQ(trust_ratio(2.0f, 0.0f), 1.0f);
+  EXPECT_EQ(trust_ratio(3.0f, 2.0f), 1.5f);
+  LARSStep step{0.1f, 0.9f, 1e-4f, 1e-3f, 0.0f};
+  EXPECT_EQ(lars_ratio(step, 0.0f, 1.0f), 1.0f);
+}
+
+TEST(layerwise_optimizer, lamb_matches_reference) {
+  size_t const size = 1000;
+  int const num_steps = 20;
+  LAMBStep step;
+  step.lr = 0.01f;
+  step.beta1 = 0.9f;
+  step.beta2 = 0.999f;
+  step.weight_decay = 0.01f;
+  step.epsilon = 1e-6f;
+  std::vector<float> w = random_vector(size, 0.5f, 0);
+  std::vector<float> m(size, 0.0f), v(size, 0.0f);
+  ReferenceLAMB ref{step.lr, step.beta1, step.beta2, step.weight_decay,
+                    step.epsilon};
+  ref.w.assign(w.begin(), w.end());
+  ref.m.assign(size, 0.0);
+  ref.v.assign(size, 0.0);
+  double beta1_t = 1.0, beta2_t = 1.0;
+  for (int t = 0; t < num_steps; t++) {
+    std::vector<float> g = random_vector(size, 0.1f, t + 1);
+    beta1_t *= step.beta1;
+    beta2_t *= step.beta2;
+    step.bias_correction1 = 1 - beta1_t;
+    step.bias_correction2 = 1 - beta2_t;
+    Kernels::LAMB::update_cpu(step, size, g.data(), w.data(), m.data(), v.data());
+    ref.step(g);
+  }
+  for (size_t i = 0; i < size; i++) {
+    EXPECT_NEAR(w[i], ref.w[i], 1e-5);
+    EXPECT_NEAR(m[i], ref.m[i], 1e-6);
+  }
+}
+
+TEST(layerwise_optimizer, lamb_step_is_relative_to_the_weight_norm) {
+  // Without decay and at the first step, every element of the direction is
+  // +-1, so the step has the norm lr * ||w|| whatever the gradient scale
+  size_t const size = 256;
+  LAMBStep step{0.01f, 0.9f, 0.999f, 0.1f, 0.001f, 0.0f, 0.0f};
+  for (float scale : {1e-4f, 1.0f, 1e4f}) {
+    std::vector<float> w = random_vector(size, 2.0f, 1);
+    std::vector<float> w0 = w, m(size, 0.0f), v(size, 0.0f);
+    std::vector<float> g = random_vector(size, scale, 2);
+    Kernels::LAMB::update_cpu(
+        step, size, g.data(), w.data(), m.data(), v.data());
+    double delta = 0.0, w_norm = 0.0;
+    for (size_t i = 0; i < size; i++) {
+      delta += (double)(w[i] - w0[i]) * (w[i] - w0[i]);
+      w_norm += (double)w0[i] * w0[i];
+    }
+    EXPECT_NEAR(std::sqrt(delta), step.lr * std::sqrt(w_norm), 1e-4);
+  }
+}
+
+TEST(layerwise_optimizer, lars_matches_reference) {
+  size_t const size = 1000;
+  int const num_steps = 20;
+  LARSStep step{0.5f, 0.9f, 5e-4f, 1e-3f, 1e-9f};
+  std::vector<float> w = random_vector(size, 0.5f, 3);
+  std::vector<float> v(size, 0.0f);
+  ReferenceLARS ref{step.lr, step.momentum, step.weight_decay,
+                    step.trust_coefficient, step.epsilon};
+  ref.w.assign(w.begin(), w.end());
+  ref.v.assign(size, 0.0);
+  for (int t = 0; t < num_steps; t++) {
+    std::vector<float> g = random_vector(size, 0.1f, t + 100);
+    Kernels::LARS::update_cpu(step, size, g.data(), w.data(), v.data());
+    ref.step(g);
+  }
+  for (size_t i = 0; i < size; i++) {
+    EXPECT_NEAR(w[i], ref.w[i], 1e-5);
+    EXPECT_NEAR(v[i], ref.v[i], 1e-6);
+  }
+}
@@ -0,0 +1,149 @@
+#include "flexflow/mcmc_search.h"
+#include "gtest/gtest.h"
+
+using namespace FlexFlow;
+
+namespace {
+
+// Operators with a cost table over 8 configurations; a few of them dominate
+// the runtime, as the convolutions and dense layers of a CNN do
+struct ToyModel {
+  std::vector<float> scale;
+  std::vector<std::vector<float>> table;
+
+  ToyModel(int num_ops, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> uniform(1.0f, 2.0f);
+    for (int i = 0; i < num_ops; i++) {
+      scale.push_back(i % 10 == 0 ? 100.0f : 1.0f);
+      table.push_back(std::vector<float>(8));
+      for (float &t : table.back()) {
+        t = uniform(rng);
+      }
+    }
+  }
+
+  float optimum() const {
+    float total = 0.0f;
+    for (size_t i = 0; i < scale.size(); i++) {
+      total += scale[i] *
+               *std::min_element(table[i].begin(), table[i].end());
+    }
+    return total;
+  }
+
+  McmcProblem<int> problem(std::mt19937 &rng) const {
+    McmcProblem<int> p;
+    p.simulate = [this](std::vector<int> const &configs,
+                        std::vector<float> &costs) {
+      float total = 0.0f;
+      for (size_t i = 0; i < configs.size(); i++) {
+        costs[i] = scale[i] * table[i][configs[i]];
+        total += costs[i];
+      }
+      return total;
+    };
+    p.random_config = [&rng](int) {
+      return std::uniform_int_distribution<int>(0, 7)(rng);
+    };
+    p.mutable_ops = std::vector<bool>(scale.size(), true);
+    return p;
+  }
+};
+
+} // namespace
+
+TEST(mcmc_search, finds_the_optimum_and_keeps_fixed_ops) {
+  ToyModel model(6, 1);
+  std::mt19937 rng(0);
+  McmcProblem<int> problem = model.problem(rng);
+  problem.mutable_ops[5] = false;
+  std::vector<int> best(6, 0);
+  McmcSearchOptions options;
+  options.budget = 10000;
+  McmcSearchStats stats = mcmc_search(problem, best, options, rng);
+  EXPECT_EQ(best[5], 0);
+  float expected = model.optimum() - model.scale[5] * (*std::min_element(
+                                                          model.table[5].begin(),
+                                                          model.table[5].end()) -
+                                                      model.table[5][0]);
+  EXPECT_FLOAT_EQ(stats.best_runtime, expected);
+  EXPECT_GT(stats.accepted, 0u);
+  EXPECT_LE(stats.best_iteration, options.budget);
+}
+
+TEST(mcmc_search, cost_guided_reaches_target_sooner) {
+  // Budget needed to come within 1% of the optimum, over several models
+  size_t const budget = 20000;
+  double iterations[2] = {0, 0};
+  int reached[2] = {0, 0};
+  for (unsigned seed = 0; seed < 10; seed++) {
+    ToyModel model(50, seed);
+    for (int guided = 0; guided < 2; guided++) {
+      std::mt19937 rng(seed);
+      McmcSearchOptions options;
+      options.budget = budget;
+      options.alpha = 0.5f;
+      options.cost_guided = guided;
+      options.target_runtime = model.optimum() * 1.01f;
+      std::vector<int> best(50, 0);
+      McmcSearchStats stats =
+          mcmc_search(model.problem(rng), best, options, rng);
+      if (stats.target_iteration <= budget) {
+        reached[guided]++;
+        iterations[guided] += stats.target_iteration;
+      } else {
+        iterations[guided] += budget;
+      }
+    }
+  }
+  printf("[mcmc_search] mean budget to 1%% of optimum: uniform %.0f (%d/10), "
+         "cost-guided %.0f (%d/10)\n",
+         iterations[0] / 10,
+         reached[0],
+         iterations[1] / 10,
+         reached[1]);
+  EXPECT_EQ(reached[1], 10);
+  EXPECT_LT(iterations[1], iterations[0]);
+}
+
+TEST(mcmc_search, temperature_follows_acceptance_target) {
+  ToyModel model(20, 3);
+  std::mt19937 rng(0);
+  McmcSearchOptions options;
+  options.budget = 5000;
+  // Far too hot at first: nearly every uphill move would be accepted
+  options.alpha = 1e-4f;
+  std::vector<int> best(20, 0);
+  McmcSearchStats stats = mcmc_search(model.problem(rng), best, options, rng);
+  EXPECT_LT(stats.final_temperature, 1.0f / options.alpha / 100);
+  EXPECT_LT(stats.uphill_accepted, stats.accepted);
+}
+
+TEST(mcmc_search, rewrite_proposals) {
+  ToyModel model(6, 2);
+  std::mt19937 rng(0);
+  McmcProblem<int> problem = model.problem(rng);
+  problem.mutable_ops[5] = false;
+  // Propagate the configuration of one operator to its successor
+  size_t rewrites = 0;
+  problem.rewrite = [&](std::vector<int> const &current,
+                        std::vector<int> &next) {
+    rewrites++;
+    int op = std::uniform_int_distribution<int>(0, 3)(rng);
+    next[op] = next[op + 1] = problem.random_config(op);
+  };
+  std::vector<int> best(6, 0);
+  McmcSearchOptions options;
+  options.budget = 10000;
+  options.rewrite_chance = 0.25f;
+  McmcSearchStats stats = mcmc_search(problem, best, options, rng);
+  EXPECT_GT(rewrites, options.budget / 5);
+  EXPECT_LT(rewrites, options.budget / 3);
+  EXPECT_EQ(best[5], 0);
+  float expected = model.optimum() - model.scale[5] * (*std::min_element(
+                                                          model.table[5].begin(),
+                                                          model.table[5].end()) -
+                                                      model.table[5][0]);
+  EXPECT_FLOAT_EQ(stats.best_runtime, expected);
+}
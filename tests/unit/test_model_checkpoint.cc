@@ -0,0 +1,196 @@
+#include "flexflow/model_checkpoint.h"
+#include "gtest/gtest.h"
+#include <cstring>
+#include <random>
+#include <sstream>
+
+using namespace FlexFlow;
+
+namespace {
+
+// The region of a parameter compiled for a number of data parallel workers:
+// one replica of the tensor per worker, one after the other
+struct ToyParameter {
+  std::string name;
+  DataType data_type;
+  std::vector<int> dims;
+  size_t element_bytes;
+  int num_replicas;
+  std::vector<char> region;
+
+  ToyParameter(std::string const &_name,
+               DataType _data_type,
+               std::vector<int> const &_dims,
+               size_t _element_bytes,
+               int _num_replicas)
+      : name(_name), data_type(_data_type), dims(_dims),
+        element_bytes(_element_bytes), num_replicas(_num_replicas) {
+    region.resize(replica_bytes() * num_replicas);
+  }
+  size_t replica_bytes() const {
+    size_t volume = element_bytes;
+    for (int d : dims) {
+      volume *= d;
+    }
+    return volume;
+  }
+  // A training step, applied to every replica alike
+  void step(std::mt19937 &rng) {
+    std::vector<char> replica(replica_bytes());
+    for (char &c : replica) {
+      c = (char)rng();
+    }
+    for (int i = 0; i < num_replicas; i++) {
+      memcpy(&region[i * replica.size()], replica.data(), replica.size());
+    }
+  }
+  void save(ModelCheckpoint &ckpt) const {
+    ckpt.save_tensor(
+        name, data_type, dims, region.data(), region.size(), num_replicas);
+  }
+  bool load(ModelCheckpoint const &ckpt, std::string &error) {
+    return ckpt.load_tensor(name,
+                            data_type,
+                            dims,
+                            region.data(),
+                            region.size(),
+                            num_replicas,
+                            error);
+  }
+};
+
+// The parameters and Adam moments of a small MLP
+std::vector<ToyParameter> make_model(int num_workers) {
+  std::vector<ToyParameter> params;
+  for (int l = 0; l < 2; l++) {
+    std::string layer = "layer" + std::to_string(l) + ".Linear";
+    std::vector<std::vector<int>> shapes = {{16, 8}, {16}};
+    for (size_t i = 0; i < shapes.size(); i++) {
+      std::string weight = layer + ".weight" + std::to_string(i);
+      params.push_back(
+          ToyParameter(weight, DT_FLOAT, shapes[i], 4, num_workers));
+      params.push_back(ToyParameter(
+          weight + "/adam.v", DT_FLOAT, shapes[i], 4, num_workers));
+      params.push_back(ToyParameter(
+          weight + "/adam.m", DT_FLOAT, shapes[i], 4, num_workers));
+    }
+  }
+  // A half precision embedding
+  params.push_back(ToyParameter("layer2.Embedding.weight0",
+                                DT_HALF,
+                                {10, 4},
+                                2,
+                                num_workers));
+  return params;
+}
+
+// Save a model to a byte stream, as if it were written to a file before a
+// restart
+std::string save_model(std::vector<ToyParameter> const &params,
+                       double beta1_t) {
+  ModelCheckpoint ckpt;
+  for (ToyParameter const &p : params) {
+    p.save(ckpt);
+  }
+  ckpt.scalars["adam.beta1_t"] = beta1_t;
+  std::ostringstream os;
+  ckpt.write(os);
+  return os.str();
+}
+
+// Load a byte stream into a model compiled for other resources
+void load_model(std::string const &bytes,
+                std::vector<ToyParameter> &params,
+                double &beta1_t) {
+  ModelCheckpoint ckpt;
+  std::string error;
+  std::istringstream is(bytes);
+  ASSERT_TRUE(ModelCheckpoint::read(is, ckpt, error)) << error;
+  for (ToyParameter &p : params) {
+    ASSERT_TRUE(p.load(ckpt, error)) << error;
+  }
+  beta1_t = ckpt.scalars.at("adam.beta1_t");
+}
+
+// Every replica of every parameter matches the reference bit for bit
+void expect_bitwise_equal(std::vector<ToyParameter> const &expected,
+                          std::vector<ToyParameter> const &actual) {
+  ASSERT_EQ(expected.size(), actual.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    size_t bytes = expected[i].replica_bytes();
+    ASSERT_EQ(bytes, actual[i].replica_bytes());
+    for (int r = 0; r < actual[i].num_replicas; r++) {
+      EXPECT_EQ(0,
+                memcmp(expected[i].region.data(),
+                       actual[i].region.data() + r * bytes,
+                       bytes))
+          << actual[i].name << " replica " << r;
+    }
+  }
+}
+
+} // namespace
+
+TEST(model_checkpoint, reshard_2_4_3_workers) {
+  std::mt19937 rng(7);
+  // Train on 2 workers and save
+  std::vector<ToyParameter> two = make_model(2);
+  for (ToyParameter &p : two) {
+    p.step(rng);
+  }
+  double beta1_t = 0.9 * 0.9 * 0.9;
+  std::string bytes = save_model(two, beta1_t);
+
+  // Restart on 4 workers, train and save again
+  std::vector<ToyParameter> four = make_model(4);
+  double loaded_beta1_t = 0.0;
+  load_model(bytes, four, loaded_beta1_t);
+  EXPECT_EQ(beta1_t, loaded_beta1_t);
+  expect_bitwise_equal(two, four);
+  for (ToyParameter &p : four) {
+    p.step(rng);
+  }
+  bytes = save_model(four, loaded_beta1_t * 0.9);
+
+  // Restart on 3 workers
+  std::vector<ToyParameter> three = make_model(3);
+  load_model(bytes, three, loaded_beta1_t);
+  EXPECT_EQ(beta1_t * 0.9, loaded_beta1_t);
+  expect_bitwise_equal(four, three);
+}
+
+TEST(model_checkpoint, rejects_mismatches) {
+  ModelCheckpoint ckpt;
+  float data[6] = {1, 2, 3, 4, 5, 6};
+  ckpt.save_tensor("w", DT_FLOAT, {3, 2}, data, sizeof(data), 1);
+  float region[12];
+  std::string error;
+  EXPECT_FALSE(ckpt.load_tensor(
+      "x", DT_FLOAT, {3, 2}, region, sizeof(region), 2, error));
+  EXPECT_FALSE(ckpt.load_tensor(
+      "w", DT_FLOAT, {2, 3}, region, sizeof(region), 2, error));
+  EXPECT_FALSE(ckpt.load_tensor(
+      "w", DT_INT32, {3, 2}, region, sizeof(region), 2, error));
+  EXPECT_FALSE(ckpt.load_tensor(
+      "w", DT_FLOAT, {3, 2}, region, sizeof(region), 3, error));
+  EXPECT_TRUE(ckpt.load_tensor(
+      "w", DT_FLOAT, {3, 2}, region, sizeof(region), 2, error));
+  EXPECT_EQ(0, memcmp(region + 6, data, sizeof(data)));
+
+  std::ostringstream os;
+  ckpt.write(os);
+  std::string bytes = os.str();
+  ModelCheckpoint read;
+  std::istringstream truncated(bytes.substr(0, bytes.size() - 3));
+  EXPECT_FALSE(ModelCheckpoint::read(truncated, read, error));
+  std::string bad_magic = bytes;
+  bad_magic[0] = 'X';
+  std::istringstream not_checkpoint(bad_magic);
+  EXPECT_FALSE(ModelCheckpoint::read(not_checkpoint, read, error));
+  std::string newer = bytes;
+  newer[4] = ModelCheckpoint::VERSION + 1;
+  std::istringstream newer_version(newer);
+  EXPECT_FALSE(ModelCheckpoint::read(newer_version, read, error));
+  std::istringstream valid(bytes);
+  EXPECT_TRUE(ModelCheckpoint::read(valid, read, error)) << error;
+}
@@ -0,0 +1,150 @@
+#include "flexflow/optimizer_state.h"
+#include "gtest/gtest.h"
+#include <random>
+#include <vector>
+
+using namespace FlexFlow;
+using namespace FlexFlow::Kernels::Adam;
+
+namespace {
+
+// Noisy least squares regression y = X w* + e trained with full-batch Adam
+struct Regression {
+  int num_samples = 1024, num_features = 600;
+  std::vector<float> x, y;
+
+  Regression() {
+    std::mt19937 gen(0);
+    std::normal_distribution<float> dist(0.0f, 1.0f);
+    std::vector<float> w_star(num_features);
+    for (float &w : w_star) {
+      w = dist(gen);
+    }
+    x.resize((size_t)num_samples * num_features);
+    for (float &v : x) {
+      v = dist(gen) / std::sqrt((float)num_features);
+    }
+    y.assign(num_samples, 0.0f);
+    for (int n = 0; n < num_samples; n++) {
+      for (int f = 0; f < num_features; f++) {
+        y[n] += x[(size_t)n * num_features + f] * w_star[f];
+      }
+      y[n] += 0.1f * dist(gen);
+    }
+  }
+
+  float loss_and_grad(std::vector<float> const &w,
+                      std::vector<float> &grad) const {
+    grad.assign(num_features, 0.0f);
+    float loss = 0.0f;
+    for (int n = 0; n < num_samples; n++) {
+      float const *row = x.data() + (size_t)n * num_features;
+      float err = -y[n];
+      for (int f = 0; f < num_features; f++) {
+        err += row[f] * w[f];
+      }
+      loss += err * err / num_samples;
+      for (int f = 0; f < num_features; f++) {
+        grad[f] += 2.0f * err * row[f] / num_samples;
+      }
+    }
+    return loss;
+  }
+
+  float train(OptimizerStateType type, int num_steps) const {
+    std::vector<float> w(num_features, 0.0f), grad;
+    std::vector<float> m(num_features, 0.0f), v(num_features, 0.0f);
+    std::vector<uint16_t> m16(num_features, 0), v16(num_features, 0);
+    std::vector<int8_t> m8(num_features, 0);
+    std::vector<uint8_t> v8(num_features, 0);
+    size_t num_blocks = (num_features + OPTIMIZER_STATE_BLOCK_SIZE - 1) /
+                        OPTIMIZER_STATE_BLOCK_SIZE;
+    std::vector<float> m_scales(num_blocks, 0.0f), v_scales(num_blocks, 0.0f);
+    double alpha = 0.05, beta1 = 0.9, beta2 = 0.999;
+    double beta1_t = 1.0, beta2_t = 1.0;
+    float loss = 0.0f;
+    for (int t = 0; t < num_steps; t++) {
+      loss = loss_and_grad(w, grad);
+      beta1_t *= beta1;
+      beta2_t *= beta2;
+      AdamStep step;
+      step.alpha_t = alpha * std::sqrt(1 - beta2_t) / (1 - beta1_t);
+      step.beta1 = beta1;
+      step.beta2 = beta2;
+      step.weight_decay = 0.0f;
+      step.epsilon = 1e-8f;
+      switch (type) {
+        case OPTIMIZER_STATE_FP32:
+          update_cpu(step, w.size(), grad.data(), w.data(), m.data(), v.data());
+          break;
+        case OPTIMIZER_STATE_BF16:
+          update_bf16_cpu(
+              step, w.size(), grad.data(), w.data(), m16.data(), v16.data());
+          break;
+        case OPTIMIZER_STATE_INT8:
+          update_int8_cpu(step,
+                          w.size(),
+                          grad.data(),
+                          w.data(),
+                          m8.data(),
+                          v8.data(),
+                          m_scales.data(),
+                          v_scales.data());
+          break;
+      }
+    }
+    return loss;
+  }
+};
+
+} // namespace
+
+TEST(optimizer_state, bf16_round_trip) {
+  EXPECT_EQ(bf16_to_float(float_to_bf16(1.0f)), 1.0f);
+  EXPECT_EQ(bf16_to_float(float_to_bf16(-3.5f)), -3.5f);
+  EXPECT_EQ(bf16_to_float(float_to_bf16(0.0f)), 0.0f);
+  // 1 + 2^-8 is halfway between two bf16 values and rounds to even
+  EXPECT_EQ(bf16_to_float(float_to_bf16(1.0f + 1.0f / 256)), 1.0f);
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> dist(-1e3f, 1e3f);
+  for (int i = 0; i < 1000; i++) {
+    float x = dist(gen);
+    EXPECT_NEAR(bf16_to_float(float_to_bf16(x)), x, std::fabs(x) / 256);
+  }
+}
+
+TEST(optimizer_state, quantization_error_is_bounded_by_the_block_scale) {
+  float const absmax = 2.0f;
+  for (float x = -absmax; x <= absmax; x += 0.01f) {
+    float y = dequantize_first_moment(quantize_first_moment(x, absmax), absmax);
+    EXPECT_NEAR(y, x, absmax / 127 / 2 + 1e-6f);
+  }
+  // Small second moments keep their magnitude better than a linear code
+  float const max = 1.0f;
+  float small = 1e-3f;
+  float y = dequantize_second_moment(quantize_second_moment(small, max), max);
+  EXPECT_NEAR(y, small, 0.1f * small);
+  EXPECT_EQ(dequantize_second_moment(quantize_second_moment(max, max), max),
+            max);
+}
+
+TEST(optimizer_state, state_bytes) {
+  EXPECT_EQ(optimizer_state_bytes(OPTIMIZER_STATE_FP32), 4.0f);
+  EXPECT_EQ(optimizer_state_bytes(OPTIMIZER_STATE_BF16), 2.0f);
+  EXPECT_NEAR(optimizer_state_bytes(OPTIMIZER_STATE_INT8), 1.0f, 0.02f);
+}
+
+TEST(optimizer_state, low_precision_adam_converges_like_fp32) {
+  Regression problem;
+  std::vector<float> w(problem.num_features, 0.0f), grad;
+  float initial = problem.loss_and_grad(w, grad);
+  float fp32 = problem.train(OPTIMIZER_STATE_FP32, 300);
+  float bf16 = problem.train(OPTIMIZER_STATE_BF16, 300);
+  float int8 = problem.train(OPTIMIZER_STATE_INT8, 300);
+  EXPECT_LT(fp32, 1e-2f * initial);
+  EXPECT_LT(bf16, 1e-2f * initial);
+  EXPECT_LT(int8, 1e-2f * initial);
+  // The loss is down to the noise, where the runs should agree closely
+  EXPECT_LT(bf16, 1.05f * fp32);
+  EXPECT_LT(int8, 1.05f * fp32);
+}
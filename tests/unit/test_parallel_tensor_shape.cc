@@ -0,0 +1,53 @@
+#include "flexflow/parallel_tensor.h"
+#include "gtest/gtest.h"
+
+using namespace FlexFlow;
+
+// A 2-D weight of shape 64x16 replicated over num_replicas workers and
+// partitioned by partition_degree along its outer data dimension
+static ParallelTensorShape make_weight_shape(int num_replicas,
+                                             int partition_degree) {
+  ParallelDim dims[MAX_TENSOR_DIM];
+  dims[0].size = 16;
+  dims[0].degree = 1;
+  dims[1].size = 64;
+  dims[1].degree = partition_degree;
+  dims[2].size = num_replicas;
+  dims[2].degree = num_replicas;
+  dims[2].is_replica_dim = true;
+  return ParallelTensorShape(3, dims, DT_FLOAT);
+}
+
+TEST(parallel_tensor_shape_is_reshardable_to, elastic_resize) {
+  // 2 -> 4 -> 3 workers, with both data and parameter parallelism
+  ParallelTensorShape two = make_weight_shape(2, 1);
+  ParallelTensorShape four = make_weight_shape(2, 2);
+  ParallelTensorShape three = make_weight_shape(3, 1);
+
+  EXPECT_TRUE(two.is_reshardable_to(four));
+  EXPECT_TRUE(four.is_reshardable_to(three));
+  EXPECT_TRUE(three.is_reshardable_to(two));
+  EXPECT_TRUE(two.is_reshardable_to(two));
+}
+
+TEST(parallel_tensor_shape_is_reshardable_to, different_tensors) {
+  ParallelTensorShape shape = make_weight_shape(2, 1);
+
+  ParallelTensorShape other_size = shape;
+  other_size.dims[1].size = 32;
+  EXPECT_FALSE(shape.is_reshardable_to(other_size));
+
+  ParallelTensorShape other_type = shape;
+  other_type.data_type = DT_DOUBLE;
+  EXPECT_FALSE(shape.is_reshardable_to(other_type));
+}
+
+TEST(parallel_tensor_shape_is_reshardable_to, inner_replica_dim) {
+  ParallelTensorShape shape = make_weight_shape(2, 1);
+
+  // Replicas that are not stored contiguously cannot be resharded
+  ParallelTensorShape inner = shape;
+  std::swap(inner.dims[1], inner.dims[2]);
+  EXPECT_FALSE(shape.is_reshardable_to(inner));
+  EXPECT_FALSE(inner.is_reshardable_to(shape));
+}
@@ -0,0 +1,200 @@
+#include "flexflow/region_cache.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <set>
+
+using namespace FlexFlow;
+
+namespace {
+
+// Stand-in for the runtime: hands out fresh handles and counts live ones
+struct FakeRuntime {
+  int next = 0;
+  std::set<int> live;
+
+  int create() {
+    live.insert(next);
+    return next++;
+  }
+
+  void destroy(std::vector<int> const &handles) {
+    for (int h : handles) {
+      ASSERT_EQ(live.erase(h), 1u);
+    }
+  }
+};
+
+int get_or_create(RegionCache<int> &cache,
+                  FakeRuntime &runtime,
+                  RegionCache<int>::Key const &key) {
+  int handle;
+  if (!cache.find(key, handle)) {
+    handle = runtime.create();
+    cache.insert(key, handle);
+  }
+  return handle;
+}
+
+} // namespace
+
+TEST(region_cache, shared_resources) {
+  RegionCache<int> cache;
+  FakeRuntime runtime;
+  cache.begin_epoch();
+  int a = get_or_create(cache, runtime, {2, 0, 63});
+  EXPECT_EQ(get_or_create(cache, runtime, {2, 0, 63}), a);
+  int b = get_or_create(cache, runtime, {2, 0, 31});
+  EXPECT_NE(a, b);
+  runtime.destroy(cache.end_epoch());
+  EXPECT_EQ(runtime.live.size(), 2u);
+
+  // Resources not looked up again are destroyed after one idle epoch
+  for (int i = 0; i < 2; i++) {
+    cache.begin_epoch();
+    EXPECT_EQ(get_or_create(cache, runtime, {2, 0, 31}), b);
+    runtime.destroy(cache.end_epoch());
+    EXPECT_EQ(runtime.live.size(), 2u - i);
+  }
+  EXPECT_EQ(runtime.live, std::set<int>({b}));
+  EXPECT_EQ(cache.get_stats().num_created, 2u);
+  EXPECT_EQ(cache.get_stats().num_reused, 3u);
+  EXPECT_EQ(cache.get_stats().num_destroyed, 1u);
+  EXPECT_EQ(cache.get_stats().num_live, 1u);
+}
+
+TEST(region_cache, exclusive_resources) {
+  RegionCache<int> cache(true /*exclusive*/);
+  FakeRuntime runtime;
+  cache.begin_epoch();
+  int a = get_or_create(cache, runtime, {7, 1});
+  int b = get_or_create(cache, runtime, {7, 1});
+  EXPECT_NE(a, b);
+  runtime.destroy(cache.end_epoch());
+
+  cache.begin_epoch();
+  std::set<int> reused = {get_or_create(cache, runtime, {7, 1}),
+                          get_or_create(cache, runtime, {7, 1})};
+  EXPECT_EQ(reused, std::set<int>({a, b}));
+  // A third tensor of the same shape needs a new resource
+  int c = get_or_create(cache, runtime, {7, 1});
+  EXPECT_EQ(runtime.live.size(), 3u);
+  runtime.destroy(cache.end_epoch());
+  EXPECT_EQ(runtime.live, std::set<int>({a, b, c}));
+
+  RegionCache<int> eager(true /*exclusive*/, 0 /*max_idle_epochs*/);
+  eager.begin_epoch();
+  get_or_create(eager, runtime, {7, 1});
+  eager.end_epoch();
+  eager.begin_epoch();
+  EXPECT_EQ(eager.end_epoch().size(), 1u);
+  EXPECT_EQ(eager.size(), 0u);
+}
+
+TEST(region_cache, touch_keeps_referenced_resources) {
+  RegionCache<int> cache(true /*exclusive*/);
+  FakeRuntime runtime;
+  cache.begin_epoch();
+  int a = get_or_create(cache, runtime, {1});
+  runtime.destroy(cache.end_epoch());
+
+  cache.begin_epoch();
+  // Still referenced by a live tensor: neither handed out nor destroyed
+  EXPECT_TRUE(cache.touch(a));
+  EXPECT_NE(get_or_create(cache, runtime, {1}), a);
+  EXPECT_FALSE(cache.touch(1000));
+  runtime.destroy(cache.end_epoch());
+  EXPECT_EQ(runtime.live.size(), 2u);
+  EXPECT_TRUE(runtime.live.count(a));
+}
+
+TEST(region_cache, retained_resources_are_not_aliased) {
+  RegionCache<int> cache(true /*exclusive*/);
+  FakeRuntime runtime;
+  // The first compile maps two tensors of the same shape and keeps a
+  // reference to both; a data loader also refers to the first one
+  cache.begin_epoch();
+  int a = get_or_create(cache, runtime, {5});
+  int b = get_or_create(cache, runtime, {5});
+  runtime.destroy(cache.end_epoch());
+  std::vector<int> compile_refs = {a, b};
+  for (int h : compile_refs) {
+    EXPECT_TRUE(cache.retain(h));
+  }
+  EXPECT_TRUE(cache.retain(a));
+
+  // The next compile drops the tensors of the first one, but the region of
+  // the data loader is neither handed out nor destroyed
+  for (int compile = 0; compile < 3; compile++) {
+    cache.begin_epoch();
+    for (int h : compile_refs) {
+      EXPECT_TRUE(cache.release(h));
+    }
+    compile_refs = {get_or_create(cache, runtime, {5}),
+                    get_or_create(cache, runtime, {5})};
+    EXPECT_EQ(std::count(compile_refs.begin(), compile_refs.end(), a), 0);
+    runtime.destroy(cache.end_epoch());
+    for (int h : compile_refs) {
+      EXPECT_TRUE(cache.retain(h));
+    }
+    EXPECT_TRUE(runtime.live.count(a));
+  }
+  EXPECT_EQ(runtime.live.size(), 3u);
+
+  // Once released, the region is reused, or destroyed after being idle
+  EXPECT_TRUE(cache.release(a));
+  cache.begin_epoch();
+  for (int h : compile_refs) {
+    EXPECT_TRUE(cache.release(h));
+  }
+  std::set<int> reused;
+  for (int i = 0; i < 3; i++) {
+    reused.insert(get_or_create(cache, runtime, {5}));
+  }
+  EXPECT_TRUE(reused.count(a));
+  EXPECT_EQ(runtime.live.size(), 3u);
+  runtime.destroy(cache.end_epoch());
+  for (int i = 0; i < 2; i++) {
+    cache.begin_epoch();
+    runtime.destroy(cache.end_epoch());
+  }
+  EXPECT_EQ(runtime.live.size(), 0u);
+  EXPECT_FALSE(cache.retain(a));
+  EXPECT_FALSE(cache.release(a));
+}
+
+TEST(region_cache, bounded_growth_over_recompiles) {
+  // Alternate between two strategies that partition 64 tensors of a few
+  // shapes differently: nothing is created after the first two compiles and
+  // the live resources stay bounded by the union of both strategies
+  RegionCache<int> index_spaces, partitions, regions(true /*exclusive*/);
+  FakeRuntime runtime;
+  size_t max_live = 0;
+  for (int compile = 0; compile < 1000; compile++) {
+    int degree = compile % 2 == 0 ? 2 : 4;
+    index_spaces.begin_epoch();
+    partitions.begin_epoch();
+    regions.begin_epoch();
+    for (int t = 0; t < 64; t++) {
+      long long size = 128 << (t % 4);
+      int is = get_or_create(index_spaces, runtime, {1, 0, size - 1});
+      get_or_create(partitions, runtime, {is, degree, size / degree - 1});
+      get_or_create(regions, runtime, {is, 0});
+    }
+    runtime.destroy(regions.end_epoch());
+    runtime.destroy(partitions.end_epoch());
+    runtime.destroy(index_spaces.end_epoch());
+    max_live = std::max(max_live, runtime.live.size());
+    if (compile >= 2) {
+      EXPECT_EQ(regions.get_stats().num_created, 64u);
+      EXPECT_EQ(partitions.get_stats().num_created, 8u);
+    }
+  }
+  EXPECT_EQ(index_spaces.size(), 4u);
+  EXPECT_EQ(regions.size(), 64u);
+  EXPECT_EQ(max_live, 4u + 8u + 64u);
+  EXPECT_EQ(runtime.live.size(), index_spaces.size() + partitions.size() +
+                                     regions.size());
+  printf("[region_cache] 1000 compiles: %d resources created, %zu live\n",
+         runtime.next,
+         runtime.live.size());
+}
@@ -0,0 +1,69 @@
+#include "flexflow/serving_search.h"
+#include "gtest/gtest.h"
+#include <cstdio>
+
+using namespace FlexFlow;
+
+TEST(serving_search, pareto_front) {
+  // Latency grows sublinearly with the batch size until the device is
+  // saturated, then linearly; batch size 12 is dominated by 16
+  std::vector<ServingSearchPoint> points = {
+      {1, 2.0f}, {16, 8.0f}, {4, 3.0f}, {12, 8.0f}, {32, 16.0f}, {64, 40.0f}};
+  std::vector<ServingSearchPoint> front = serving_pareto_front(points);
+  std::vector<int> batch_sizes;
+  for (ServingSearchPoint const &p : front) {
+    batch_sizes.push_back(p.batch_size);
+  }
+  EXPECT_EQ(batch_sizes, std::vector<int>({1, 4, 16}));
+  EXPECT_FLOAT_EQ(front[0].throughput, 500.0f);
+  EXPECT_FLOAT_EQ(front[2].throughput, 2000.0f);
+}
+
+TEST(serving_search, select_under_slo) {
+  std::vector<ServingSearchPoint> points = {
+      {1, 2.0f}, {4, 3.0f}, {16, 8.0f}, {32, 16.0f}};
+  EXPECT_EQ(points[select_serving_point(points, 10.0f)].batch_size, 16);
+  EXPECT_EQ(points[select_serving_point(points, 16.0f)].batch_size, 16);
+  EXPECT_EQ(points[select_serving_point(points, 3.0f)].batch_size, 4);
+  // Nothing meets the SLO: fall back to the lowest latency
+  EXPECT_EQ(points[select_serving_point(points, 1.0f)].batch_size, 1);
+}
+
+TEST(serving_search, default_batch_sizes) {
+  EXPECT_EQ(default_serving_batch_sizes(1), std::vector<int>({1}));
+  EXPECT_EQ(default_serving_batch_sizes(64),
+            std::vector<int>({1, 2, 4, 8, 16, 32, 64}));
+  EXPECT_EQ(default_serving_batch_sizes(48),
+            std::vector<int>({1, 2, 4, 8, 16, 32, 48}));
+}
+
+TEST(serving_search, exported_strategy_round_trip) {
+  std::string filename = testing::TempDir() + "serving_strategy.bin";
+  ExportedStrategy strategy;
+  strategy.batch_size = 16;
+  strategy.comp_mode = 1;
+  strategy.latency_slo = 10.0f;
+  strategy.latency = 8.0f;
+  strategy.graph_optimal_view = {'p', 'c', 'g', '\0', 1, 2, 3};
+  ASSERT_TRUE(strategy.save(filename));
+
+  ExportedStrategy loaded;
+  ASSERT_TRUE(ExportedStrategy::load(filename, loaded));
+  EXPECT_EQ(loaded.batch_size, 16);
+  EXPECT_EQ(loaded.comp_mode, 1);
+  EXPECT_FLOAT_EQ(loaded.latency_slo, 10.0f);
+  EXPECT_FLOAT_EQ(loaded.latency, 8.0f);
+  EXPECT_EQ(loaded.graph_optimal_view, strategy.graph_optimal_view);
+
+  // Trailing garbage and other files are rejected
+  FILE *file = fopen(filename.c_str(), "ab");
+  fputc(0, file);
+  fclose(file);
+  EXPECT_FALSE(ExportedStrategy::load(filename, loaded));
+  file = fopen(filename.c_str(), "wb");
+  fputs("not a strategy", file);
+  fclose(file);
+  EXPECT_FALSE(ExportedStrategy::load(filename, loaded));
+  remove(filename.c_str());
+  EXPECT_FALSE(ExportedStrategy::load(filename, loaded));
+}
@@ -0,0 +1,146 @@
+#include "flexflow/ops/kernels/pad_kernels.h"
+#include "flexflow/ops/kernels/slice_kernels.h"
+#include "gtest/gtest.h"
+#include <random>
+#include <vector>
+
+using namespace FlexFlow;
+
+namespace {
+
+std::vector<float> random_tensor(size_t volume, unsigned seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+  std::vector<float> t(volume);
+  for (float &v : t) {
+    v = value(gen);
+  }
+  return t;
+}
+
+size_t volume_of(std::vector<int> const &dims) {
+  size_t v = 1;
+  for (int n : dims) {
+    v *= n;
+  }
+  return v;
+}
+
+// Dense offset of the coordinates, innermost dimension first
+size_t dense_offset(std::vector<int> const &dims,
+                    std::vector<int> const &coords) {
+  size_t offset = 0, stride = 1;
+  for (size_t d = 0; d < dims.size(); d++) {
+    offset += coords[d] * stride;
+    stride *= dims[d];
+  }
+  return offset;
+}
+
+// Coordinates of a dense offset
+std::vector<int> coords_of(std::vector<int> const &dims, size_t offset) {
+  std::vector<int> coords(dims.size());
+  for (size_t d = 0; d < dims.size(); d++) {
+    coords[d] = offset % dims[d];
+    offset /= dims[d];
+  }
+  return coords;
+}
+
+struct Window {
+  std::vector<int> enclosing, offsets, dims;
+  TensorWindow window;
+  size_t origin;
+
+  Window(std::vector<int> const &_enclosing,
+         std::vector<int> const &_offsets,
+         std::vector<int> const &_dims)
+      : enclosing(_enclosing), offsets(_offsets), dims(_dims) {
+    origin = window.set_dense(
+        dims.size(), enclosing.data(), offsets.data(), dims.data());
+  }
+
+  // Offset in the enclosing tensor of the element at a window offset
+  size_t enclosing_offset(size_t idx) const {
+    std::vector<int> coords = coords_of(dims, idx);
+    for (size_t d = 0; d < dims.size(); d++) {
+      coords[d] += offsets[d];
+    }
+    return dense_offset(enclosing, coords);
+  }
+};
+
+} // namespace
+
+TEST(slice_pad, windows_of_whole_inner_dimensions_are_contiguous) {
+  // Slicing the outermost dimension only
+  Window outer({6, 5, 8}, {0, 0, 2}, {6, 5, 3});
+  EXPECT_EQ(outer.origin, 2u * 30);
+  EXPECT_EQ(outer.window.volume(), 90u);
+  EXPECT_TRUE(outer.window.is_contiguous());
+  // The stride of a dimension of size 1 does not break the run
+  Window unit({6, 5, 8}, {0, 0, 2}, {6, 5, 1});
+  EXPECT_TRUE(unit.window.is_contiguous());
+  Window column({6, 5, 8}, {0, 1, 2}, {6, 1, 3});
+  EXPECT_EQ(column.window.run_length(), 6u);
+  EXPECT_FALSE(column.window.is_contiguous());
+  Window inner({6, 5, 8}, {1, 0, 0}, {4, 5, 8});
+  EXPECT_EQ(inner.window.run_length(), 4u);
+  EXPECT_EQ(inner.window.offset(4), 6u);
+}
+
+TEST(slice_pad, slice_copies_the_window) {
+  std::vector<Window> windows = {Window({7, 5, 4}, {2, 1, 1}, {3, 4, 2}),
+                                 Window({7, 5, 4}, {0, 0, 1}, {7, 5, 2}),
+                                 Window({7, 5, 4}, {0, 2, 0}, {7, 1, 4})};
+  for (Window const &w : windows) {
+    std::vector<float> input = random_tensor(volume_of(w.enclosing), 0);
+    std::vector<float> output(w.window.volume());
+    Kernels::Slice::forward_cpu(
+        w.window, input.data() + w.origin, output.data());
+    for (size_t i = 0; i < output.size(); i++) {
+      EXPECT_EQ(output[i], input[w.enclosing_offset(i)]);
+    }
+    // The backward pass accumulates into the window only
+    std::vector<float> output_grad = random_tensor(output.size(), 1);
+    std::vector<float> input_grad(input.size(), 1.0f);
+    Kernels::Slice::backward_cpu(
+        w.window, output_grad.data(), input_grad.data() + w.origin);
+    std::vector<float> expected(input.size(), 1.0f);
+    for (size_t i = 0; i < output_grad.size(); i++) {
+      expected[w.enclosing_offset(i)] += output_grad[i];
+    }
+    for (size_t i = 0; i < input_grad.size(); i++) {
+      EXPECT_FLOAT_EQ(input_grad[i], expected[i]);
+    }
+  }
+}
+
+TEST(slice_pad, pad_surrounds_the_input) {
+  // Pads of (1, 2) on the innermost dimension and (3, 0) on the next one
+  Window w({9, 7, 2}, {1, 3, 0}, {6, 4, 2});
+  std::vector<float> input = random_tensor(w.window.volume(), 2);
+  std::vector<float> output(volume_of(w.enclosing));
+  Kernels::Pad::forward_cpu(
+      w.window, w.origin, -2.0f, input.data(), output.data(), output.size());
+  std::vector<float> expected(output.size(), -2.0f);
+  for (size_t i = 0; i < input.size(); i++) {
+    expected[w.enclosing_offset(i)] = input[i];
+  }
+  for (size_t i = 0; i < output.size(); i++) {
+    EXPECT_EQ(output[i], expected[i]);
+  }
+  // The backward pass is the slice of the output gradient
+  std::vector<float> output_grad = random_tensor(output.size(), 3);
+  std::vector<float> input_grad(input.size(), 0.5f);
+  Kernels::Pad::backward_cpu(
+      w.window, w.origin, output_grad.data(), input_grad.data());
+  for (size_t i = 0; i < input_grad.size(); i++) {
+    EXPECT_FLOAT_EQ(input_grad[i], 0.5f + output_grad[w.enclosing_offset(i)]);
+  }
+  // Slicing the padded window gives the input back
+  std::vector<float> sliced(input.size());
+  Kernels::Slice::forward_cpu(
+      w.window, output.data() + w.origin, sliced.data());
+  EXPECT_EQ(sliced, input);
+}
@@ -0,0 +1,68 @@
+#include "flexflow/simulator.h"
+#include "gtest/gtest.h"
+
+using namespace FlexFlow;
+
+TEST(step_time_variance, disabled_by_default) {
+  StepTimeVarianceModel model;
+
+  EXPECT_FALSE(model.enabled());
+  EXPECT_EQ(model.straggler_time(1.0f, 8), 0.0f);
+}
+
+TEST(step_time_variance, straggler_time) {
+  StepTimeVarianceModel model;
+  model.quantile = 0.95f;
+
+  // A single device pays the p95 of its own run time
+  EXPECT_NEAR(model.straggler_time(1.0f, 1), 1.645f, 1e-3f);
+  EXPECT_NEAR(model.straggler_time(2.0f, 1), 3.290f, 2e-3f);
+  // Waiting for the slowest of more devices costs more
+  EXPECT_GT(model.straggler_time(1.0f, 8), model.straggler_time(1.0f, 2));
+  EXPECT_GT(model.straggler_time(1.0f, 64), model.straggler_time(1.0f, 8));
+  EXPECT_EQ(model.straggler_time(0.0f, 64), 0.0f);
+
+  // The median of a single device is its mean
+  model.quantile = 0.5f;
+  EXPECT_NEAR(model.straggler_time(1.0f, 1), 0.0f, 1e-3f);
+}
+
+TEST(step_time_variance, stddev) {
+  StepTimeVarianceModel model;
+  EXPECT_EQ(model.stddev(10.0f, 0.0f), 0.0f);
+  EXPECT_NEAR(model.stddev(10.0f, 3.0f), 3.0f, 1e-6f);
+
+  model.jitter = 0.4f;
+  EXPECT_NEAR(model.stddev(10.0f, 0.0f), 4.0f, 1e-6f);
+  EXPECT_NEAR(model.stddev(10.0f, 3.0f), 5.0f, 1e-6f);
+}
+
+TEST(step_time_variance, sample_quantile) {
+  StepTimeVarianceModel model;
+  std::vector<float> samples{5.0f, 1.0f, 4.0f, 2.0f, 3.0f};
+
+  model.quantile = 0.5f;
+  EXPECT_EQ(model.sample_quantile(samples), 3.0f);
+  model.quantile = 0.99f;
+  EXPECT_EQ(model.sample_quantile(samples), 5.0f);
+  model.quantile = 0.01f;
+  EXPECT_EQ(model.sample_quantile(samples), 1.0f);
+}
+
+TEST(step_time_variance, jitter_injection) {
+  StepTimeVarianceModel model;
+  model.quantile = 0.95f;
+  model.jitter = 0.1f;
+  std::mt19937 rng(0);
+
+  float run_time = 1.0f;
+  std::vector<float> samples;
+  for (int i = 0; i < 20000; i++) {
+    samples.push_back(model.sample_run_time(
+        run_time, model.stddev(run_time, 0.0f), rng));
+  }
+  EXPECT_NEAR(model.sample_quantile(samples), 1.1645f, 0.01f);
+
+  // A deterministic task is never perturbed
+  EXPECT_EQ(model.sample_run_time(run_time, 0.0f, rng), run_time);
+}
@@ -0,0 +1,96 @@
+#include "flexflow/machine_model.h"
+#include "gtest/gtest.h"
+#include <sstream>
+
+using namespace FlexFlow;
+
+namespace {
+
+// A forward task on GPU 0 sends 20 MiB to a forward task on GPU 1
+TaskGraphTrace two_gpu_trace() {
+  TaskGraphTrace trace;
+  trace.num_gpus = 2;
+  trace.segment_size = 16 << 20;
+  trace.max_num_segments = 1;
+  trace.tasks.push_back(
+      TaskGraphTrace::Task{TaskGraphTrace::TASK_FORWARD, 0, 1.0f, "dense 1"});
+  trace.tasks.push_back(
+      TaskGraphTrace::Task{TaskGraphTrace::TASK_FORWARD, 1, 1.0f, "dense 2"});
+  trace.tasks.push_back(
+      TaskGraphTrace::Task{TaskGraphTrace::TASK_LAUNCH, 0, 0.5f, ""});
+  trace.edges.push_back(TaskGraphTrace::Edge{2, 0, 0});
+  trace.edges.push_back(TaskGraphTrace::Edge{0, 1, 20 << 20});
+  return trace;
+}
+
+} // namespace
+
+TEST(task_graph_trace, round_trip) {
+  TaskGraphTrace trace = two_gpu_trace();
+  std::stringstream ss;
+  trace.write(ss);
+
+  TaskGraphTrace loaded;
+  std::string error;
+  ASSERT_TRUE(TaskGraphTrace::read(ss, loaded, error)) << error;
+  EXPECT_EQ(loaded.num_gpus, 2);
+  EXPECT_EQ(loaded.segment_size, 16 << 20);
+  EXPECT_EQ(loaded.max_num_segments, 1);
+  ASSERT_EQ(loaded.tasks.size(), 3u);
+  EXPECT_EQ(loaded.tasks[0].type, TaskGraphTrace::TASK_FORWARD);
+  EXPECT_EQ(loaded.tasks[1].device_id, 1);
+  EXPECT_EQ(loaded.tasks[0].name, "dense 1");
+  EXPECT_EQ(loaded.tasks[2].type, TaskGraphTrace::TASK_LAUNCH);
+  EXPECT_EQ(loaded.tasks[2].name, "");
+  EXPECT_FLOAT_EQ(loaded.tasks[2].run_time, 0.5f);
+  ASSERT_EQ(loaded.edges.size(), 2u);
+  EXPECT_EQ(loaded.edges[1].src, 0);
+  EXPECT_EQ(loaded.edges[1].dst, 1);
+  EXPECT_EQ(loaded.edges[1].xfer_size, (size_t)20 << 20);
+  EXPECT_EQ(loaded.max_gpu_id(), 1);
+}
+
+TEST(task_graph_trace, rejects_invalid_traces) {
+  TaskGraphTrace trace;
+  std::string error;
+  std::stringstream not_a_trace("digraph taskgraph {\n}\n");
+  EXPECT_FALSE(TaskGraphTrace::read(not_a_trace, trace, error));
+
+  std::stringstream newer("flexflow-taskgraph-trace 999\n");
+  EXPECT_FALSE(TaskGraphTrace::read(newer, trace, error));
+
+  std::stringstream ss;
+  two_gpu_trace().write(ss);
+  std::string text = ss.str();
+  std::stringstream bad_edge(text.substr(0, text.rfind("0 1")) + "0 7 16\n");
+  EXPECT_FALSE(TaskGraphTrace::read(bad_edge, trace, error));
+  EXPECT_NE(error.find("edge"), std::string::npos);
+}
+
+TEST(task_graph_trace, replay_on_machine_models) {
+  TaskGraphTrace trace = two_gpu_trace();
+  TaskGraphReplayOptions options;
+  size_t const capacity = (size_t)16 << 30;
+
+  // 20 MiB over an NVLink of 20 MiB/ms
+  SimpleMachineModel one_node(1, 2, capacity);
+  TaskGraphReplayReport report =
+      replay_task_graph_trace(trace, &one_node, options);
+  EXPECT_NEAR(report.makespan, 3.5f, 1e-3f);
+  ASSERT_EQ(report.compute_devices.size(), 3u);
+  EXPECT_NEAR(report.compute_devices[0].busy_time, 1.0f, 1e-5f);
+  ASSERT_EQ(report.links.size(), 1u);
+  EXPECT_NEAR(report.links[0].busy_time, 1.0f, 1e-3f);
+  EXPECT_EQ(report.links[0].bytes, (size_t)20 << 20);
+
+  // Across nodes: PCIe at 16 MiB/ms, then a NIC at 6 MiB/ms, then PCIe
+  SimpleMachineModel two_nodes(2, 1, capacity);
+  report = replay_task_graph_trace(trace, &two_nodes, options);
+  EXPECT_NEAR(report.makespan, 2.5f + 1.25f + 20.0f / 6 + 1.25f, 1e-3f);
+  EXPECT_EQ(report.links.size(), 3u);
+
+  // Faster GPUs only shorten the compute tasks
+  options.compute_scale = 0.5f;
+  report = replay_task_graph_trace(trace, &one_node, options);
+  EXPECT_NEAR(report.makespan, 2.5f, 1e-3f);
+}
@@ -0,0 +1,210 @@
+#include "flexflow/ops/kernels/tiled_attention_kernels.h"
+#include "gtest/gtest.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace FlexFlow;
+using namespace FlexFlow::Kernels::TiledAttention;
+
+namespace {
+
+TiledAttentionShape make_shape(int qo, int kv, int tile_size) {
+  TiledAttentionShape shape;
+  shape.num_samples = 2;
+  shape.num_heads = 3;
+  shape.qo_seq_length = qo;
+  shape.kv_seq_length = kv;
+  shape.q_size = shape.k_size = shape.v_size = 5;
+  shape.q_proj_size = shape.k_proj_size = 4;
+  shape.v_proj_size = 3;
+  shape.o_proj_size = 6;
+  shape.scale = 0.5f;
+  shape.tile_size = tile_size;
+  return shape;
+}
+
+std::vector<float> random_vector(size_t size, std::mt19937 &gen) {
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  std::vector<float> v(size);
+  for (float &x : v) {
+    x = dist(gen);
+  }
+  return v;
+}
+
+// Materializes the score matrix of each head, in double precision
+std::vector<double> reference_forward(TiledAttentionShape const &s,
+                                      std::vector<float> const &query,
+                                      std::vector<float> const &key,
+                                      std::vector<float> const &value,
+                                      std::vector<float> const &weight) {
+  std::vector<double> output(
+      (size_t)s.num_samples * s.qo_seq_length * s.o_proj_size, 0.0);
+  for (int n = 0; n < s.num_samples; n++) {
+    for (int h = 0; h < s.num_heads; h++) {
+      float const *w = weight.data() + h * s.weights_per_head();
+      auto proj = [&](float const *in, size_t off, int rows, int in_size,
+                      int out_size) {
+        std::vector<double> out((size_t)rows * out_size, 0.0);
+        for (int i = 0; i < rows; i++) {
+          for (int a = 0; a < out_size; a++) {
+            for (int c = 0; c < in_size; c++) {
+              out[i * out_size + a] +=
+                  (double)w[off + a * in_size + c] * in[i * in_size + c];
+            }
+          }
+        }
+        return out;
+      };
+      auto q = proj(query.data() + n * s.qo_seq_length * s.q_size,
+                    s.wq_offset(), s.qo_seq_length, s.q_size, s.q_proj_size);
+      auto k = proj(key.data() + n * s.kv_seq_length * s.k_size,
+                    s.wk_offset(), s.kv_seq_length, s.k_size, s.k_proj_size);
+      auto v = proj(value.data() + n * s.kv_seq_length * s.v_size,
+                    s.wv_offset(), s.kv_seq_length, s.v_size, s.v_proj_size);
+      for (int i = 0; i < s.qo_seq_length; i++) {
+        std::vector<double> p(s.kv_seq_length);
+        double max = -INFINITY, sum = 0.0;
+        for (int j = 0; j < s.kv_seq_length; j++) {
+          p[j] = 0.0;
+          for (int a = 0; a < s.q_proj_size; a++) {
+            p[j] += q[i * s.q_proj_size + a] * k[j * s.k_proj_size + a];
+          }
+          p[j] *= s.scale;
+          max = std::max(max, p[j]);
+        }
+        for (int j = 0; j < s.kv_seq_length; j++) {
+          p[j] = std::exp(p[j] - max);
+          sum += p[j];
+        }
+        for (int b = 0; b < s.v_proj_size; b++) {
+          double o = 0.0;
+          for (int j = 0; j < s.kv_seq_length; j++) {
+            o += p[j] / sum * v[j * s.v_proj_size + b];
+          }
+          for (int c = 0; c < s.o_proj_size; c++) {
+            output[(n * s.qo_seq_length + i) * s.o_proj_size + c] +=
+                (double)w[s.wo_offset() + c * s.v_proj_size + b] * o;
+          }
+        }
+      }
+    }
+  }
+  return output;
+}
+
+// Loss sum(output * coeff), whose output gradient is coeff
+double loss(TiledAttentionShape const &s,
+            std::vector<float> const &query,
+            std::vector<float> const &key,
+            std::vector<float> const &value,
+            std::vector<float> const &weight,
+            std::vector<float> const &coeff) {
+  auto output = reference_forward(s, query, key, value, weight);
+  double l = 0.0;
+  for (size_t i = 0; i < output.size(); i++) {
+    l += output[i] * coeff[i];
+  }
+  return l;
+}
+
+} // namespace
+
+TEST(tiled_attention, forward_matches_reference) {
+  std::mt19937 gen(0);
+  // Tiles dividing the sequences, not dividing them, and covering them
+  int const configs[][3] = {{8, 8, 4}, {7, 11, 3}, {5, 9, 64}, {6, 1, 2}};
+  for (auto const &c : configs) {
+    TiledAttentionShape s = make_shape(c[0], c[1], c[2]);
+    auto query = random_vector(s.num_samples * s.qo_seq_length * s.q_size, gen);
+    auto key = random_vector(s.num_samples * s.kv_seq_length * s.k_size, gen);
+    auto value = random_vector(s.num_samples * s.kv_seq_length * s.v_size, gen);
+    auto weight = random_vector(s.num_heads * s.weights_per_head(), gen);
+    std::vector<float> output(s.num_samples * s.qo_seq_length * s.o_proj_size,
+                              -7.0f);
+    std::vector<float> lse(s.num_samples * s.num_heads * s.qo_seq_length);
+    forward_cpu(s, query.data(), key.data(), value.data(), weight.data(),
+                output.data(), lse.data());
+    auto expected = reference_forward(s, query, key, value, weight);
+    for (size_t i = 0; i < output.size(); i++) {
+      EXPECT_NEAR(output[i], expected[i], 1e-4) << "tile " << c[2];
+    }
+  }
+}
+
+TEST(tiled_attention, backward_matches_finite_differences) {
+  std::mt19937 gen(1);
+  TiledAttentionShape s = make_shape(7, 5, 3);
+  auto query = random_vector(s.num_samples * s.qo_seq_length * s.q_size, gen);
+  auto key = random_vector(s.num_samples * s.kv_seq_length * s.k_size, gen);
+  auto value = random_vector(s.num_samples * s.kv_seq_length * s.v_size, gen);
+  auto weight = random_vector(s.num_heads * s.weights_per_head(), gen);
+  auto coeff =
+      random_vector(s.num_samples * s.qo_seq_length * s.o_proj_size, gen);
+  std::vector<float> output(coeff.size());
+  std::vector<float> lse(s.num_samples * s.num_heads * s.qo_seq_length);
+  forward_cpu(s, query.data(), key.data(), value.data(), weight.data(),
+              output.data(), lse.data());
+
+  // Gradients accumulate into what is already there
+  std::vector<float> query_grad(query.size(), 1.0f),
+      key_grad(key.size(), 1.0f), value_grad(value.size(), 1.0f),
+      weight_grad(weight.size(), 1.0f);
+  backward_cpu(s, query.data(), key.data(), value.data(), weight.data(),
+               coeff.data(), lse.data(), query_grad.data(), key_grad.data(),
+               value_grad.data(), weight_grad.data());
+
+  double const eps = 1e-3;
+  auto check = [&](std::vector<float> &x, std::vector<float> const &grad) {
+    for (size_t i = 0; i < x.size(); i++) {
+      float saved = x[i];
+      x[i] = saved + eps;
+      double plus = loss(s, query, key, value, weight, coeff);
+      x[i] = saved - eps;
+      double minus = loss(s, query, key, value, weight, coeff);
+      x[i] = saved;
+      EXPECT_NEAR(grad[i] - 1.0f, (plus - minus) / (2 * eps), 2e-3);
+    }
+  };
+  check(query, query_grad);
+  check(key, key_grad);
+  check(value, value_grad);
+  check(weight, weight_grad);
+}
+
+TEST(tiled_attention, self_attention_gradients_alias) {
+  std::mt19937 gen(2);
+  TiledAttentionShape s = make_shape(6, 6, 4);
+  auto input = random_vector(s.num_samples * s.qo_seq_length * s.q_size, gen);
+  auto weight = random_vector(s.num_heads * s.weights_per_head(), gen);
+  auto coeff =
+      random_vector(s.num_samples * s.qo_seq_length * s.o_proj_size, gen);
+  std::vector<float> output(coeff.size());
+  std::vector<float> lse(s.num_samples * s.num_heads * s.qo_seq_length);
+  forward_cpu(s, input.data(), input.data(), input.data(), weight.data(),
+              output.data(), lse.data());
+
+  std::vector<float> shared_grad(input.size(), 0.0f),
+      weight_grad(weight.size(), 0.0f);
+  backward_cpu(s, input.data(), input.data(), input.data(), weight.data(),
+               coeff.data(), lse.data(), shared_grad.data(),
+               shared_grad.data(), shared_grad.data(), weight_grad.data());
+
+  std::vector<float> query_grad(input.size(), 0.0f),
+      key_grad(input.size(), 0.0f), value_grad(input.size(), 0.0f),
+      separate_weight_grad(weight.size(), 0.0f);
+  backward_cpu(s, input.data(), input.data(), input.data(), weight.data(),
+               coeff.data(), lse.data(), query_grad.data(), key_grad.data(),
+               value_grad.data(), separate_weight_grad.data());
+  for (size_t i = 0; i < input.size(); i++) {
+    EXPECT_NEAR(shared_grad[i], query_grad[i] + key_grad[i] + value_grad[i],
+                1e-5);
+  }
+}
+
+TEST(tiled_attention, saved_state_smaller_than_scores) {
+  TiledAttentionShape s = make_shape(4096, 4096, 64);
+  s.q_proj_size = s.k_proj_size = s.v_proj_size = 64;
+  EXPECT_LT(s.saved_state_size() * 10, s.score_matrix_size());
+}
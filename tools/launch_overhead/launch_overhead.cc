@@ -0,0 +1,138 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Calibrate the simulator's task launch overhead model on the local machine.
+//
+// The tool issues back-to-back index launches of an empty CPU leaf task with
+// an increasing number of points and fits the per-launch time as
+//   t(points) = per_task_overhead + per_point_overhead * points / num_util
+// where num_util is the number of utility processors (-ll:util). The fitted
+// values are printed as the FlexFlow flags that enable the model:
+//   ./launch_overhead -ll:cpu 4 -ll:util 2 [--max-points 64] [--launches 200]
+
+#include "legion.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace Legion;
+
+enum TaskIDs {
+  TOP_LEVEL_TASK_ID,
+  EMPTY_TASK_ID,
+};
+
+void empty_task(Task const *task,
+                std::vector<PhysicalRegion> const &regions,
+                Context ctx,
+                Runtime *runtime) {}
+
+// Average wall time (in ms) of one index launch of `num_points` points
+double time_index_launch(int num_points,
+                         int num_launches,
+                         Context ctx,
+                         Runtime *runtime) {
+  Rect<1> bounds(Point<1>(0), Point<1>(num_points - 1));
+  IndexSpaceT<1> launch_is = runtime->create_index_space(ctx, bounds);
+  ArgumentMap argmap;
+  IndexLauncher launcher(
+      EMPTY_TASK_ID, launch_is, TaskArgument(NULL, 0), argmap);
+  // Warm up the mapper and the runtime's internal caches
+  runtime->execute_index_space(ctx, launcher);
+  runtime->issue_execution_fence(ctx).get_void_result();
+  double start = Realm::Clock::current_time_in_microseconds();
+  for (int i = 0; i < num_launches; i++) {
+    runtime->execute_index_space(ctx, launcher);
+  }
+  runtime->issue_execution_fence(ctx).get_void_result();
+  double end = Realm::Clock::current_time_in_microseconds();
+  runtime->destroy_index_space(ctx, launch_is);
+  return (end - start) / 1e3 / num_launches;
+}
+
+void top_level_task(Task const *task,
+                    std::vector<PhysicalRegion> const &regions,
+                    Context ctx,
+                    Runtime *runtime) {
+  int max_points = 64;
+  int num_launches = 200;
+  int num_util = 1;
+  InputArgs const &args = Runtime::get_input_args();
+  for (int i = 1; i < args.argc; i++) {
+    if (!strcmp(args.argv[i], "--max-points")) {
+      max_points = atoi(args.argv[++i]);
+      continue;
+    }
+    if (!strcmp(args.argv[i], "--launches")) {
+      num_launches = atoi(args.argv[++i]);
+      continue;
+    }
+    if (!strcmp(args.argv[i], "-ll:util")) {
+      num_util = atoi(args.argv[++i]);
+      continue;
+    }
+  }
+  assert(max_points > 0 && num_launches > 0 && num_util > 0);
+
+  // Least-squares fit of t = a + b * points
+  std::vector<std::pair<double, double>> samples;
+  printf("points\tms/launch\n");
+  for (int points = 1; points <= max_points; points *= 2) {
+    double t = time_index_launch(points, num_launches, ctx, runtime);
+    printf("%d\t%.6lf\n", points, t);
+    samples.push_back(std::make_pair((double)points, t));
+  }
+  double n = samples.size(), sx = 0, sy = 0, sxx = 0, sxy = 0;
+  for (auto const &s : samples) {
+    sx += s.first;
+    sy += s.second;
+    sxx += s.first * s.first;
+    sxy += s.first * s.second;
+  }
+  double slope = 0.0;
+  if (n > 1 && n * sxx - sx * sx > 0) {
+    slope = (n * sxy - sx * sy) / (n * sxx - sx * sx);
+  }
+  double intercept = (sy - slope * sx) / n;
+  // The per-point cost in the simulator is charged per utility processor
+  double per_point = std::max(slope, 0.0) * num_util;
+  double per_task = std::max(intercept, 0.0);
+  printf("\nFitted launch overhead (%d utility processors):\n", num_util);
+  printf("  --simulator-task-launch-overhead %.6lf "
+         "--simulator-point-launch-overhead %.6lf -ll:util %d\n",
+         per_task,
+         per_point,
+         num_util);
+}
+
+int main(int argc, char **argv) {
+  Runtime::set_top_level_task_id(TOP_LEVEL_TASK_ID);
+  {
+    TaskVariantRegistrar registrar(TOP_LEVEL_TASK_ID, "top_level");
+    registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
+    Runtime::preregister_task_variant<top_level_task>(registrar, "top_level");
+  }
+  {
+    TaskVariantRegistrar registrar(EMPTY_TASK_ID, "empty_task");
+    registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<empty_task>(registrar, "empty_task");
+  }
+  return Runtime::start(argc, argv);
+}
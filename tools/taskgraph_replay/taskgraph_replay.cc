@@ -0,0 +1,175 @@
+/* Copyright 2023 CMU, Facebook, LANL, MIT, NVIDIA, and Stanford (alphabetical)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Replay a task graph trace on a machine model, without the model or GPUs.
+//
+// A trace is written by a FlexFlow run with --taskgraph-trace <file>. The
+// tool rebuilds the communication of the trace on the given machine and
+// prints the makespan and the utilization of every compute device and link:
+//   ./taskgraph_replay <trace> [--nodes 2 --gpus-per-node 4]
+//   ./taskgraph_replay <trace> --machine-model-file machine_config_example
+//   ./taskgraph_replay <trace> --nodes 4 --gpus-per-node 2
+//       --topology bigswitch|fc|flat:<degree> [--link-bandwidth 12.5]
+//       [--network-latency 0.005] [--pcie]
+// --compute-scale scales the run time of the GPU tasks, e.g. 0.5 for GPUs
+// twice as fast; --segment-size and --max-num-segments override the
+// segmentation of the transfers recorded in the trace.
+
+#include "flexflow/machine_model.h"
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using namespace FlexFlow;
+
+namespace {
+
+size_t const GPU_FB_MEM_CAPACITY = (size_t)16 << 30;
+
+void usage(char const *program) {
+  fprintf(stderr,
+          "Usage: %s <trace> [--nodes N] [--gpus-per-node G] "
+          "[--machine-model-file F] [--topology bigswitch|fc|flat:<degree>] "
+          "[--link-bandwidth GB/s] [--network-latency ms] [--pcie] "
+          "[--compute-scale S] [--segment-size B] [--max-num-segments N]\n",
+          program);
+  exit(1);
+}
+
+MachineModel *create_networked_machine(std::string const &topology,
+                                       int num_nodes,
+                                       int gpus_per_node,
+                                       float link_bandwidth,
+                                       float network_latency,
+                                       bool pcie) {
+  int num_switches = 0;
+  ConnectionMatrix conn;
+  if (topology == "bigswitch") {
+    num_switches = 1;
+    conn = BigSwitchNetworkTopologyGenerator(num_nodes).generate_topology();
+  } else if (topology == "fc") {
+    conn = FCTopologyGenerator(num_nodes).generate_topology();
+  } else if (topology.compare(0, 5, "flat:") == 0) {
+    int degree = atoi(topology.c_str() + 5);
+    conn = FlatDegConstraintNetworkTopologyGenerator(num_nodes, degree)
+               .generate_topology();
+  } else {
+    fprintf(stderr, "Unknown topology %s\n", topology.c_str());
+    exit(1);
+  }
+  NetworkedMachineModel *machine =
+      new NetworkedMachineModel(num_nodes,
+                                gpus_per_node,
+                                num_switches,
+                                network_latency,
+                                conn,
+                                GPU_FB_MEM_CAPACITY,
+                                link_bandwidth * 1024 * 1024 /* B/ms */);
+  // Expand transfers onto the physical links of the route
+  machine->set_pipeline(false);
+  machine->set_pcie(pcie);
+  return machine;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 2 || argv[1][0] == '-') {
+    usage(argv[0]);
+  }
+  std::string trace_file = argv[1];
+  int num_nodes = 1, gpus_per_node = 0;
+  std::string machine_model_file, topology;
+  float link_bandwidth = 12.5f, network_latency = 0.005f;
+  bool pcie = false;
+  TaskGraphReplayOptions options;
+  for (int i = 2; i < argc; i++) {
+    if (i + 1 < argc && !strcmp(argv[i], "--nodes")) {
+      num_nodes = atoi(argv[++i]);
+    } else if (i + 1 < argc && !strcmp(argv[i], "--gpus-per-node")) {
+      gpus_per_node = atoi(argv[++i]);
+    } else if (i + 1 < argc && !strcmp(argv[i], "--machine-model-file")) {
+      machine_model_file = argv[++i];
+    } else if (i + 1 < argc && !strcmp(argv[i], "--topology")) {
+      topology = argv[++i];
+    } else if (i + 1 < argc && !strcmp(argv[i], "--link-bandwidth")) {
+      link_bandwidth = atof(argv[++i]);
+    } else if (i + 1 < argc && !strcmp(argv[i], "--network-latency")) {
+      network_latency = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--pcie")) {
+      pcie = true;
+    } else if (i + 1 < argc && !strcmp(argv[i], "--compute-scale")) {
+      options.compute_scale = atof(argv[++i]);
+    } else if (i + 1 < argc && !strcmp(argv[i], "--segment-size")) {
+      options.segment_size = atoi(argv[++i]);
+    } else if (i + 1 < argc && !strcmp(argv[i], "--max-num-segments")) {
+      options.max_num_segments = atoi(argv[++i]);
+    } else {
+      usage(argv[0]);
+    }
+  }
+
+  std::ifstream file(trace_file);
+  if (!file) {
+    fprintf(stderr, "Cannot open %s\n", trace_file.c_str());
+    return 1;
+  }
+  TaskGraphTrace trace;
+  std::string error;
+  if (!TaskGraphTrace::read(file, trace, error)) {
+    fprintf(stderr, "%s: %s\n", trace_file.c_str(), error.c_str());
+    return 1;
+  }
+  if (gpus_per_node == 0) {
+    // Default to the GPUs of the recording machine on the given nodes
+    assert(num_nodes > 0);
+    gpus_per_node = (trace.num_gpus + num_nodes - 1) / num_nodes;
+  }
+
+  MachineModel *machine;
+  if (!machine_model_file.empty()) {
+    machine = new EnhancedMachineModel(machine_model_file, GPU_FB_MEM_CAPACITY);
+  } else if (!topology.empty()) {
+    machine = create_networked_machine(topology,
+                                       num_nodes,
+                                       gpus_per_node,
+                                       link_bandwidth,
+                                       network_latency,
+                                       pcie);
+  } else {
+    machine =
+        new SimpleMachineModel(num_nodes, gpus_per_node, GPU_FB_MEM_CAPACITY);
+  }
+  if (trace.max_gpu_id() >= machine->get_num_gpus()) {
+    fprintf(stderr,
+            "The trace uses %d GPUs but the machine only has %d\n",
+            trace.max_gpu_id() + 1,
+            machine->get_num_gpus());
+    return 1;
+  }
+  printf("%zu tasks, %zu edges recorded on %d GPUs, replayed on %d GPUs\n",
+         trace.tasks.size(),
+         trace.edges.size(),
+         trace.num_gpus,
+         machine->get_num_gpus());
+  TaskGraphReplayReport report =
+      replay_task_graph_trace(trace, machine, options);
+  report.print(std::cout);
+  delete machine;
+  return 0;
+}
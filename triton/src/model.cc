@@ -20,6 +20,8 @@
 #include "operator.h"
 #include "tensor.h"
 
+#include <chrono>
+
 using namespace Legion;
 
 namespace triton { namespace backend { namespace legion {
@@ -80,6 +82,7 @@ LegionModelState::LoadModel()
   // TODO: load files based on the default / cc file name that may be set
   // in model config
   auto model_path = JoinPath({RepositoryPath(), std::to_string(Version())});
+  const auto start = std::chrono::steady_clock::now();
   assert(strategy_ == nullptr);
   strategy_ = PartitionStrategy::LoadStrategy(
       JoinPath({model_path, "model.strategy"}), this);
@@ -101,9 +104,24 @@ LegionModelState::LoadModel()
   // Perform the layer fusion optimization based on the partitioning strategy
   FuseLayers();
 
+  // Share identical weights with the other models and versions loaded
+  ShareWeights();
+
   // Load each of the layers across the target processors
   LoadLayers();
 
+  const WeightStoreStats stats = runtime_->GetWeightStats();
+  LOG_MESSAGE(
+      TRITONSERVER_LOG_INFO,
+      (std::string("Loaded model '") + name + "' version " +
+       std::to_string(version) + " in " +
+       std::to_string(std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - start)
+                          .count()) +
+       " ms; weight store holds " + std::to_string(stats.live_bytes) +
+       " bytes in " + std::to_string(stats.num_live) + " allocations, " +
+       std::to_string(stats.shared_bytes) + " bytes shared")
+          .c_str());
   return nullptr;
 }
 
@@ -508,6 +526,23 @@ LegionModelState::SetOutputInfos()
   return nullptr;  // success
 }
 
+void
+LegionModelState::ShareWeights(void) const
+{
+  for (auto layer : layers_) {
+    for (Weights* wts : layer->GetWeights()) {
+      for (unsigned idx = 0; idx < MAX_LOCAL_PROCS; idx++) {
+        if (wts->local_allocation[idx] == nullptr)
+          continue;
+        const size_t size = sizeof_datatype(wts->type) *
+                            wts->local_bounds[idx].get_volume();
+        wts->local_allocation[idx] = runtime_->ShareWeights(
+            wts->local_memory[idx], wts->local_allocation[idx], size);
+      }
+    }
+  }
+}
+
 void
 LegionModelState::LoadLayers(void) const
 {
@@ -79,6 +79,7 @@ class LegionModelState : public BackendModel {
   TRITONSERVER_Error* ValidateModelConfig();
   TRITONSERVER_Error* SetOutputInfos();
 
+  void ShareWeights(void) const;
   void LoadLayers(void) const;
   void FuseLayers(void);
   void FreeLayers(void) const;
@@ -72,6 +72,9 @@ class Operator {
   // Called by model free (Realm)
   virtual void Free(Realm::Processor processor) = 0;
 
+ public:
+  const std::vector<Weights*>& GetWeights(void) const { return weights; }
+
  public:
   static void PreregisterTaskVariants(void);
 
@@ -285,15 +285,26 @@ Conv2D::Load(Processor proc)
     Weights* wts = weights[0];
     if ((wts->local_memory[local_index].kind() != Memory::GPU_FB_MEM) ||
         (wts->local_memory[local_index].kind() != Memory::Z_COPY_MEM)) {
-      void* device_ptr;
-      const size_t weights_size = sizeof_datatype(wts->type) *
-                                  wts->local_bounds[local_index].get_volume();
-      CHECK_CUDA(cudaMalloc(&device_ptr, weights_size));
-      CHECK_CUDA(cudaMemcpy(
-          device_ptr, wts->local_allocation[local_index], weights_size,
-          cudaMemcpyHostToDevice));
+      // Layers with the same filter weights on this GPU share one copy
+      void* host_ptr = wts->local_allocation[local_index];
+      void* device_ptr = model->runtime_->FindWeights(host_ptr, local_fb);
+      if (device_ptr == nullptr) {
+        const size_t weights_size =
+            sizeof_datatype(wts->type) *
+            wts->local_bounds[local_index].get_volume();
+        CHECK_CUDA(cudaMalloc(&device_ptr, weights_size));
+        CHECK_CUDA(cudaMemcpy(
+            device_ptr, host_ptr, weights_size, cudaMemcpyHostToDevice));
+        void* shared_ptr =
+            model->runtime_->RecordWeights(host_ptr, local_fb, device_ptr);
+        if (shared_ptr != device_ptr) {
+          CHECK_CUDA(cudaFree(device_ptr));
+          device_ptr = shared_ptr;
+        }
+      }
       // Free the old allocation since we no longer need it
-      std::free(wts->local_allocation[local_index]);
+      if (model->runtime_->ReleaseWeights(host_ptr))
+        std::free(host_ptr);
       wts->local_allocation[local_index] = device_ptr;
       wts->local_memory[local_index] = local_fb;
     }
@@ -463,9 +474,14 @@ Conv2D::Free(Processor proc)
     CHECK_CUDNN(cudnnDestroyFilterDescriptor(proc_args.filterDesc));
     CHECK_CUDNN(cudnnDestroyActivationDescriptor(proc_args.actiDesc));
     CHECK_CUDNN(cudnnDestroyConvolutionDescriptor(proc_args.convDesc));
-    CHECK_CUDA(cudaFree(weights[0]->local_allocation[local_index]));
+    if (model->runtime_->ReleaseWeights(
+            weights[0]->local_allocation[local_index]))
+      CHECK_CUDA(cudaFree(weights[0]->local_allocation[local_index]));
+    weights[0]->local_allocation[local_index] = nullptr;
     if (use_bias) {
-      std::free(weights[1]->local_allocation[local_index]);
+      if (model->runtime_->ReleaseWeights(
+              weights[1]->local_allocation[local_index]))
+        std::free(weights[1]->local_allocation[local_index]);
       weights[1]->local_allocation[local_index] = nullptr;
     }
     if (proc_args.workSpaceSize > 0) {
@@ -477,7 +493,8 @@ Conv2D::Free(Processor proc)
 #endif
   {
     for (Weights* wts : weights) {
-      std::free(wts->local_allocation[local_index]);
+      if (model->runtime_->ReleaseWeights(wts->local_allocation[local_index]))
+        std::free(wts->local_allocation[local_index]);
       wts->local_allocation[local_index] = nullptr;
     }
   }
@@ -357,6 +357,46 @@ LegionTritonRuntime::FreeLayer(Processor proc, Operator* op)
       INT_MAX /*high priority*/);
 }
 
+void*
+LegionTritonRuntime::ShareWeights(
+    Memory memory, void* allocation, size_t size)
+{
+  AutoLock<true> lock(weights_lock_);
+  void* shared = weights_.Intern(memory, allocation, size);
+  if (shared != allocation)
+    std::free(allocation);
+  return shared;
+}
+
+void*
+LegionTritonRuntime::FindWeights(const void* source, Memory memory)
+{
+  AutoLock<false> lock(weights_lock_);
+  return weights_.FindCopy(source, memory);
+}
+
+void*
+LegionTritonRuntime::RecordWeights(
+    const void* source, Memory memory, void* copy)
+{
+  AutoLock<false> lock(weights_lock_);
+  return weights_.RecordCopy(source, memory, copy);
+}
+
+bool
+LegionTritonRuntime::ReleaseWeights(const void* allocation)
+{
+  AutoLock<false> lock(weights_lock_);
+  return weights_.Release(allocation);
+}
+
+WeightStoreStats
+LegionTritonRuntime::GetWeightStats(void)
+{
+  AutoLock<true> lock(weights_lock_, false /*exclusive*/);
+  return weights_.Stats();
+}
+
 void
 LegionTritonRuntime::HandleContextCreation(
     const std::string& name, uint64_t version, unsigned index,
@@ -20,6 +20,7 @@
 #include "legion.h"
 #include "triton/backend/backend_common.h"
 #include "types.h"
+#include "weight_store.h"
 #ifdef LEGION_USE_CUDA
 #include "cudahelp.h"
 #endif
@@ -121,6 +122,16 @@ class LegionTritonRuntime {
   Realm::Event LoadLayer(Realm::Processor proc, Operator* op);
   Realm::Event FreeLayer(Realm::Processor proc, Operator* op);
 
+ public:
+  // Read-only weights shared by content across all the models and versions
+  // loaded in this process (see WeightStore). ShareWeights is called from
+  // external threads, the other methods from layer load and free tasks.
+  void* ShareWeights(Realm::Memory memory, void* allocation, size_t size);
+  void* FindWeights(const void* source, Realm::Memory memory);
+  void* RecordWeights(const void* source, Realm::Memory memory, void* copy);
+  bool ReleaseWeights(const void* allocation);
+  WeightStoreStats GetWeightStats(void);
+
  protected:
   void HandleContextCreation(
       const std::string& name, uint64_t version, unsigned index,
@@ -188,6 +199,8 @@ class LegionTritonRuntime {
  private:
   Realm::FastReservation lock_;
   std::vector<LegionModelState*> models_;
+  Realm::FastReservation weights_lock_;
+  WeightStore<Realm::Memory> weights_;
 
  private:
   std::list<PendingContext> pending_contexts_;
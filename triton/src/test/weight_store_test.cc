@@ -0,0 +1,98 @@
+/* Copyright 2022 NVIDIA CORPORATION
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gtest/gtest.h"
+
+#include <cstdlib>
+#include <vector>
+#include "weight_store.h"
+
+namespace {
+
+namespace tbl = triton::backend::legion;
+
+const int SYSMEM = 0;
+const int FRAMEBUFFER = 1;
+
+float*
+LoadWeights(size_t count, float value)
+{
+  float* weights = static_cast<float*>(std::malloc(count * sizeof(float)));
+  for (size_t idx = 0; idx < count; idx++) weights[idx] = value + idx;
+  return weights;
+}
+
+TEST(WeightStoreTest, IdenticalWeightsAreShared)
+{
+  tbl::WeightStore<int> store;
+  const size_t bytes = 1024 * sizeof(float);
+  // Three versions of a model, the last one retrained
+  float* v1 = LoadWeights(1024, 1.f);
+  float* v2 = LoadWeights(1024, 1.f);
+  float* v3 = LoadWeights(1024, 2.f);
+  EXPECT_EQ(store.Intern(SYSMEM, v1, bytes), v1);
+  EXPECT_EQ(store.Intern(SYSMEM, v2, bytes), v1);
+  std::free(v2);
+  EXPECT_EQ(store.Intern(SYSMEM, v3, bytes), v3);
+  EXPECT_EQ(store.Stats().num_live, 2u);
+  EXPECT_EQ(store.Stats().live_bytes, 2 * bytes);
+  EXPECT_EQ(store.Stats().shared_bytes, bytes);
+
+  // Same bytes in another memory are a different allocation
+  float* other = LoadWeights(1024, 1.f);
+  EXPECT_EQ(store.Intern(FRAMEBUFFER, other, bytes), other);
+  EXPECT_TRUE(store.Release(other));
+  std::free(other);
+
+  // Freed once the last model using them is removed
+  EXPECT_FALSE(store.Release(v1));
+  EXPECT_TRUE(store.Release(v1));
+  std::free(v1);
+  EXPECT_TRUE(store.Release(v3));
+  std::free(v3);
+  EXPECT_EQ(store.Stats().num_live, 0u);
+  EXPECT_EQ(store.Stats().live_bytes, 0u);
+}
+
+TEST(WeightStoreTest, CopiesAreSharedByContent)
+{
+  tbl::WeightStore<int> store;
+  const size_t bytes = 64 * sizeof(float);
+  float* host = LoadWeights(64, 3.f);
+  ASSERT_EQ(store.Intern(SYSMEM, host, bytes), host);
+  EXPECT_EQ(store.FindCopy(host, FRAMEBUFFER), nullptr);
+  float device[64];
+  EXPECT_EQ(store.RecordCopy(host, FRAMEBUFFER, device), device);
+  // The host buffer is dropped once copied
+  EXPECT_TRUE(store.Release(host));
+  std::free(host);
+
+  // A later version with the same weights finds the copy from the content
+  float* again = LoadWeights(64, 3.f);
+  ASSERT_EQ(store.Intern(SYSMEM, again, bytes), again);
+  EXPECT_EQ(store.FindCopy(again, FRAMEBUFFER), device);
+  EXPECT_TRUE(store.Release(again));
+  std::free(again);
+  EXPECT_FALSE(store.Release(device));
+  EXPECT_TRUE(store.Release(device));
+
+  // Unknown allocations are private to their user
+  float local[4];
+  EXPECT_EQ(store.FindCopy(local, FRAMEBUFFER), nullptr);
+  EXPECT_EQ(store.RecordCopy(local, FRAMEBUFFER, device), device);
+  EXPECT_TRUE(store.Release(local));
+}
+
+}  // namespace
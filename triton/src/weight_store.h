@@ -0,0 +1,189 @@
+/* Copyright 2022 NVIDIA CORPORATION
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __LEGION_TRITON_WEIGHT_STORE_H__
+#define __LEGION_TRITON_WEIGHT_STORE_H__
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <tuple>
+
+namespace triton { namespace backend { namespace legion {
+
+//
+// WeightDigest
+// The content address of a weight buffer: its size and two independent
+// 64-bit hashes of its bytes (FNV-1a and a position-dependent variant).
+//
+struct WeightDigest {
+ public:
+  static WeightDigest Compute(const void* data, size_t size)
+  {
+    WeightDigest digest;
+    digest.size = size;
+    digest.hash[0] = 14695981039346656037ULL;
+    digest.hash[1] = 9650029242287828579ULL;
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t idx = 0; idx < size; idx++) {
+      digest.hash[0] = (digest.hash[0] ^ bytes[idx]) * 1099511628211ULL;
+      digest.hash[1] = (digest.hash[1] ^ bytes[idx]) * 6700417ULL + idx;
+    }
+    return digest;
+  }
+  inline bool operator<(const WeightDigest& rhs) const
+  {
+    return std::tie(size, hash[0], hash[1]) <
+           std::tie(rhs.size, rhs.hash[0], rhs.hash[1]);
+  }
+
+ public:
+  size_t size;
+  uint64_t hash[2];
+};
+
+struct WeightStoreStats {
+ public:
+  size_t num_live = 0;     // allocations held by the store
+  size_t live_bytes = 0;   // bytes of those allocations
+  size_t num_shared = 0;   // requests served by an existing allocation
+  size_t shared_bytes = 0; // bytes not allocated thanks to sharing
+};
+
+//
+// WeightStore
+// Content-addressed, read-only storage of layer weights. Each memory holds
+// at most one allocation per weight content; allocations are reference
+// counted by the layers using them and must be freed by the caller when
+// Release returns true. Allocations the store does not know about are
+// private to their user. The store does not synchronize, its owner does.
+//
+template <typename Mem>
+class WeightStore {
+ public:
+  // Share a buffer loaded in host-addressable memory. Returns an allocation
+  // of the memory with the same bytes (in which case the caller frees its
+  // own buffer), or takes over the buffer. Either way the result holds one
+  // more reference.
+  void* Intern(const Mem& memory, void* allocation, size_t size)
+  {
+    const WeightDigest digest = WeightDigest::Compute(allocation, size);
+    auto finder = entries_.find(std::make_pair(memory, digest));
+    if ((finder != entries_.end()) &&
+        (std::memcmp(finder->second.allocation, allocation, size) == 0))
+      return Retain(finder);
+    return Insert(memory, digest, allocation);
+  }
+
+  // Find a copy of the content of a stored allocation in another memory,
+  // retained for the caller; nullptr if there is none yet
+  void* FindCopy(const void* source, const Mem& memory)
+  {
+    const WeightDigest* digest = Digest(source);
+    if (digest == nullptr)
+      return nullptr;
+    auto finder = entries_.find(std::make_pair(memory, *digest));
+    if (finder == entries_.end())
+      return nullptr;
+    return Retain(finder);
+  }
+
+  // Record a copy of a stored allocation made by the caller. Returns the
+  // copy that must be used: another copy may have been recorded concurrently,
+  // in which case the caller frees its own.
+  void* RecordCopy(const void* source, const Mem& memory, void* copy)
+  {
+    const WeightDigest* digest = Digest(source);
+    if (digest == nullptr)
+      return copy;
+    auto finder = entries_.find(std::make_pair(memory, *digest));
+    if (finder != entries_.end())
+      return Retain(finder);
+    return Insert(memory, *digest, copy);
+  }
+
+  // Drop a reference; returns true if the allocation is no longer used and
+  // must be freed by the caller
+  bool Release(const void* allocation)
+  {
+    auto finder = allocations_.find(allocation);
+    if (finder == allocations_.end())
+      return true;
+    auto entry = finder->second;
+    assert(entry->second.references > 0);
+    if (--entry->second.references > 0)
+      return false;
+    stats_.num_live--;
+    stats_.live_bytes -= entry->first.second.size;
+    allocations_.erase(finder);
+    entries_.erase(entry);
+    return true;
+  }
+
+  const WeightDigest* Digest(const void* allocation) const
+  {
+    auto finder = allocations_.find(allocation);
+    if (finder == allocations_.end())
+      return nullptr;
+    return &finder->second->first.second;
+  }
+
+  const WeightStoreStats& Stats(void) const { return stats_; }
+
+ private:
+  struct Entry {
+   public:
+    void* allocation;
+    size_t references;
+  };
+  typedef std::map<std::pair<Mem, WeightDigest>, Entry> EntryMap;
+
+  void* Retain(typename EntryMap::iterator entry)
+  {
+    entry->second.references++;
+    stats_.num_shared++;
+    stats_.shared_bytes += entry->first.second.size;
+    return entry->second.allocation;
+  }
+
+  void* Insert(const Mem& memory, const WeightDigest& digest, void* allocation)
+  {
+    Entry entry;
+    entry.allocation = allocation;
+    entry.references = 1;
+    auto result =
+        entries_.insert(std::make_pair(std::make_pair(memory, digest), entry));
+    // A hash collision with different bytes keeps the first allocation
+    // shareable and leaves this one private
+    if (!result.second)
+      return allocation;
+    assert(allocations_.find(allocation) == allocations_.end());
+    allocations_[allocation] = result.first;
+    stats_.num_live++;
+    stats_.live_bytes += digest.size;
+    return allocation;
+  }
+
+ private:
+  EntryMap entries_;
+  std::map<const void*, typename EntryMap::iterator> allocations_;
+  WeightStoreStats stats_;
+};
+
+}}}  // namespace triton::backend::legion
+
+#endif  // __LEGION_TRITON_WEIGHT_STORE_H__